@@ -6,14 +6,24 @@
 
 #include <AK/Assertions.h>
 #include <AK/Base64.h>
+#include <AK/BitCast.h>
 #include <AK/CharacterTypes.h>
+#include <AK/Endian.h>
 #include <AK/Error.h>
-#include <AK/StringBuilder.h>
+#include <AK/SIMD.h>
 #include <AK/Types.h>
-#include <AK/Vector.h>
+
+// See AK/SIMDExtras.h for why the vector functions here are fine despite this warning.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi"
 
 namespace AK {
 
+using SIMD::i8x16;
+using SIMD::u32x4;
+using SIMD::u64x2;
+using SIMD::u8x16;
+
 size_t calculate_base64_decoded_length(StringView input)
 {
     return input.length() * 3 / 4;
@@ -24,100 +34,356 @@ size_t calculate_base64_encoded_length(ReadonlyBytes input)
     return ((4 * input.size() / 3) + 3) & ~3;
 }
 
-ErrorOr<ByteBuffer> decode_base64(StringView input)
+// The vectorized paths below work on 12 bytes of data and 16 characters of base64 at a time. There is no byte shuffle
+// in baseline SSE2, so the 3-byte groups are moved in and out of the 32-bit lanes with scalar loads and stores, and the
+// vectors are only used to spread the bits over the lanes and to map between 6-bit values and the alphabet.
+
+ALWAYS_INLINE static u8x16 mask(i8x16 comparison)
 {
-    auto alphabet_lookup_table = base64_lookup_table();
-
-    auto get = [&](size_t& offset, bool* is_padding, bool& parsed_something) -> ErrorOr<u8> {
-        while (offset < input.length() && is_ascii_space(input[offset]))
-            ++offset;
-        if (offset >= input.length())
-            return 0;
-        auto ch = static_cast<unsigned char>(input[offset++]);
-        parsed_something = true;
-        if (ch == '=') {
-            if (!is_padding)
-                return Error::from_string_literal("Invalid '=' character outside of padding in base64 data");
-            *is_padding = true;
-            return 0;
-        }
-        i16 result = alphabet_lookup_table[ch];
-        if (result < 0)
-            return Error::from_string_literal("Invalid character in base64 data");
-        VERIFY(result < 256);
-        return { result };
+    return bit_cast<u8x16>(comparison);
+}
+
+ALWAYS_INLINE static bool all_lanes_set(i8x16 comparison)
+{
+    auto halves = bit_cast<u64x2>(comparison);
+    return (halves[0] & halves[1]) == NumericLimits<u64>::max();
+}
+
+ALWAYS_INLINE static u32 load_big_endian_u32(u8 const* bytes)
+{
+    u32 value;
+    __builtin_memcpy(&value, bytes, sizeof(value));
+    return convert_between_host_and_big_endian(value);
+}
+
+// Maps each 6-bit value to its character by adding the distance from the first value of its range in the alphabet
+// to the character that starts that range, one range at a time.
+ALWAYS_INLINE static u8x16 to_base64_characters(u8x16 values)
+{
+    u8x16 offsets = u8x16 {} + 'A';
+    offsets += mask(values >= 26) & static_cast<u8>(('a' - 26) - 'A');
+    offsets += mask(values >= 52) & static_cast<u8>(('0' - 52) - ('a' - 26));
+    offsets += mask(values >= 62) & static_cast<u8>(('+' - 62) - ('0' - 52));
+    offsets += mask(values == 63) & static_cast<u8>(('/' - 63) - ('+' - 62));
+    return values + offsets;
+}
+
+// Maps each character to its 6-bit value, and returns false if any of them is not in the alphabet.
+ALWAYS_INLINE static bool from_base64_characters(u8x16 characters, u8x16& values)
+{
+    // The subtraction wraps around for characters before the start of each range.
+    auto is_upper = (characters - 'A') < 26;
+    auto is_lower = (characters - 'a') < 26;
+    auto is_digit = (characters - '0') < 10;
+    auto is_plus = characters == '+';
+    auto is_slash = characters == '/';
+
+    if (!all_lanes_set(is_upper | is_lower | is_digit | is_plus | is_slash))
+        return false;
+
+    u8x16 offsets = mask(is_upper) & static_cast<u8>(-'A');
+    offsets += mask(is_lower) & static_cast<u8>(26 - 'a');
+    offsets += mask(is_digit) & static_cast<u8>(52 - '0');
+    offsets += mask(is_plus) & static_cast<u8>(62 - '+');
+    offsets += mask(is_slash) & static_cast<u8>(63 - '/');
+    values = characters + offsets;
+    return true;
+}
+
+// Encodes 12 bytes into 16 characters, reading (but not using) the byte after them.
+ALWAYS_INLINE static void encode_block(u8 const* input, char* output)
+{
+    u32x4 groups {
+        load_big_endian_u32(input),
+        load_big_endian_u32(input + 3),
+        load_big_endian_u32(input + 6),
+        load_big_endian_u32(input + 9),
     };
 
-    Vector<u8> output;
-    output.ensure_capacity(calculate_base64_decoded_length(input));
+    // Spread the top 24 bits of each lane over its four bytes, first character in the lowest byte.
+    auto values = ((groups >> 26) & 0x3f)
+        | (((groups >> 20) & 0x3f) << 8)
+        | (((groups >> 14) & 0x3f) << 16)
+        | (((groups >> 8) & 0x3f) << 24);
+
+    auto characters = to_base64_characters(bit_cast<u8x16>(values));
+    __builtin_memcpy(output, &characters, sizeof(characters));
+}
+
+// Decodes 16 characters into 12 bytes, or returns false without writing anything if any of them is not in the alphabet.
+ALWAYS_INLINE static bool decode_block(u8 const* input, u8* output)
+{
+    u8x16 characters;
+    __builtin_memcpy(&characters, input, sizeof(characters));
+
+    u8x16 values;
+    if (!from_base64_characters(characters, values))
+        return false;
 
+    auto lanes = bit_cast<u32x4>(values);
+    auto groups = ((lanes & 0x3f) << 26)
+        | (((lanes >> 8) & 0x3f) << 20)
+        | (((lanes >> 16) & 0x3f) << 14)
+        | (((lanes >> 24) & 0x3f) << 8);
+
+    for (size_t i = 0; i < 4; ++i) {
+        u32 group = convert_between_host_and_big_endian(groups[i]);
+        __builtin_memcpy(output + i * 3, &group, 3);
+    }
+    return true;
+}
+
+// Encodes the input into output, which must have room for calculate_base64_encoded_length(input) characters.
+static void encode_base64_into(ReadonlyBytes input, char* output)
+{
     size_t offset = 0;
-    while (offset < input.length()) {
-        bool in2_is_padding = false;
-        bool in3_is_padding = false;
+    while (input.size() - offset >= 16) {
+        encode_block(input.data() + offset, output);
+        offset += 12;
+        output += 16;
+    }
+
+    for (; offset < input.size(); offset += 3) {
+        auto remaining = input.size() - offset;
+        u32 group = input[offset] << 16;
+        if (remaining > 1)
+            group |= input[offset + 1] << 8;
+        if (remaining > 2)
+            group |= input[offset + 2];
+
+        *output++ = base64_alphabet[(group >> 18) & 0x3f];
+        *output++ = base64_alphabet[(group >> 12) & 0x3f];
+        *output++ = remaining > 1 ? base64_alphabet[(group >> 6) & 0x3f] : '=';
+        *output++ = remaining > 2 ? base64_alphabet[group & 0x3f] : '=';
+    }
+}
+
+// Writes out the bytes of the group in the state, which is either complete or at the end of unpadded input.
+static void flush_group(Base64Decoder::State& state, u8*& output)
+{
+    auto data_length = state.length - state.padding_length;
+    auto bits = state.bits << (6 * (4 - state.length));
+
+    *output++ = bits >> 16;
+    if (data_length > 2)
+        *output++ = bits >> 8;
+    if (data_length > 3)
+        *output++ = bits;
 
-        bool parsed_something = false;
+    state.bits = 0;
+    state.length = 0;
+}
+
+static ErrorOr<void> decode_character(Base64Decoder::State& state, u8 ch, u8*& output)
+{
+    static constexpr auto alphabet_lookup_table = base64_lookup_table();
+
+    if (is_ascii_space(ch))
+        return {};
+    if (state.finished)
+        return Error::from_string_literal("Invalid character after padding in base64 data");
+
+    u8 value = 0;
+    if (ch == '=') {
+        if (state.length < 2)
+            return Error::from_string_literal("Invalid '=' character outside of padding in base64 data");
+        ++state.padding_length;
+    } else {
+        auto entry = alphabet_lookup_table[ch];
+        if (entry < 0)
+            return Error::from_string_literal("Invalid character in base64 data");
+        if (state.padding_length > 0)
+            return Error::from_string_literal("Invalid character after padding in base64 data");
+        value = static_cast<u8>(entry);
+    }
 
-        const u8 in0 = TRY(get(offset, nullptr, parsed_something));
-        const u8 in1 = TRY(get(offset, nullptr, parsed_something));
-        const u8 in2 = TRY(get(offset, &in2_is_padding, parsed_something));
-        const u8 in3 = TRY(get(offset, &in3_is_padding, parsed_something));
+    state.bits = (state.bits << 6) | value;
+    if (++state.length == 4) {
+        state.finished = state.padding_length > 0;
+        flush_group(state, output);
+    }
+    return {};
+}
 
-        if (!parsed_something)
-            break;
+// Decodes as much of the input as possible into output, which must have room for three more bytes than
+// calculate_base64_decoded_length(input). Characters of an incomplete group are kept in the state.
+static ErrorOr<size_t> decode_base64_into(Base64Decoder::State& state, StringView input, u8* output)
+{
+    auto const* characters = reinterpret_cast<u8 const*>(input.characters_without_null_termination());
+    auto* output_start = output;
+    size_t offset = 0;
 
-        const u8 out0 = (in0 << 2) | ((in1 >> 4) & 3);
-        const u8 out1 = ((in1 & 0xf) << 4) | ((in2 >> 2) & 0xf);
-        const u8 out2 = ((in2 & 0x3) << 6) | in3;
+    while (offset < input.length()) {
+        if (state.length == 0 && !state.finished) {
+            while (input.length() - offset >= 16 && decode_block(characters + offset, output)) {
+                offset += 16;
+                output += 12;
+            }
+        }
 
-        output.append(out0);
-        if (!in2_is_padding)
-            output.append(out1);
-        if (!in3_is_padding)
-            output.append(out2);
+        // Whitespace, padding or an invalid character is somewhere in the next block, so go through it (and
+        // whatever is needed to get back to the start of a group) one character at a time.
+        auto scalar_end = min(offset + 16, input.length());
+        while (offset < input.length() && (offset < scalar_end || state.length != 0))
+            TRY(decode_character(state, characters[offset++], output));
     }
 
-    return ByteBuffer::copy(output);
+    return output - output_start;
+}
+
+static ErrorOr<void> finish_decoding(Base64Decoder::State& state, u8*& output)
+{
+    if (state.length == 0)
+        return {};
+    if (state.length == 1 || state.padding_length > 0)
+        return Error::from_string_literal("Incomplete group at the end of base64 data");
+
+    // Like forgiving-base64, accept a final group that is missing its padding.
+    flush_group(state, output);
+    return {};
+}
+
+ErrorOr<ByteBuffer> decode_base64(StringView input)
+{
+    auto output = TRY(ByteBuffer::create_uninitialized(calculate_base64_decoded_length(input) + 3));
+
+    Base64Decoder::State state;
+    auto length = TRY(decode_base64_into(state, input, output.data()));
+    auto* end = output.data() + length;
+    TRY(finish_decoding(state, end));
+
+    output.resize(end - output.data());
+    return output;
 }
 
 ErrorOr<String> encode_base64(ReadonlyBytes input)
 {
-    StringBuilder output(calculate_base64_encoded_length(input));
+    auto output = TRY(ByteBuffer::create_uninitialized(calculate_base64_encoded_length(input)));
+    encode_base64_into(input, reinterpret_cast<char*>(output.data()));
+    return String::from_utf8_without_validation(output.bytes());
+}
+
+// Input is processed in chunks of this many bytes, so that the output for each fits comfortably on the stack.
+static constexpr size_t streaming_chunk_size = 3 * KiB;
+
+Base64Encoder::Base64Encoder(MaybeOwned<Stream> stream)
+    : m_output_stream(move(stream))
+{
+}
+
+ErrorOr<Bytes> Base64Encoder::read_some(Bytes)
+{
+    return Error::from_errno(EBADF);
+}
 
-    auto get = [&](const size_t offset, bool* need_padding = nullptr) -> u8 {
-        if (offset >= input.size()) {
-            if (need_padding)
-                *need_padding = true;
-            return 0;
+ErrorOr<size_t> Base64Encoder::write_some(ReadonlyBytes bytes)
+{
+    VERIFY(!m_finished);
+
+    // Complete the group left over from the previous write first.
+    if (m_pending_length > 0 || bytes.size() < 3) {
+        auto needed = 3 - m_pending_length;
+        auto consumed = min(needed, bytes.size());
+        u8 group[3];
+        __builtin_memcpy(group, m_pending_bytes.data(), m_pending_length);
+        __builtin_memcpy(group + m_pending_length, bytes.data(), consumed);
+
+        if (consumed < needed) {
+            m_pending_length += consumed;
+            __builtin_memcpy(m_pending_bytes.data(), group, m_pending_length);
+            return consumed;
         }
-        return input[offset];
-    };
 
-    for (size_t i = 0; i < input.size(); i += 3) {
-        bool is_8bit = false;
-        bool is_16bit = false;
+        char encoded[4];
+        encode_base64_into({ group, 3 }, encoded);
+        TRY(m_output_stream->write_until_depleted({ encoded, sizeof(encoded) }));
+        m_pending_length = 0;
+        return consumed;
+    }
+
+    auto input = bytes.trim(min(bytes.size() / 3 * 3, streaming_chunk_size));
+    char encoded[streaming_chunk_size / 3 * 4];
+    encode_base64_into(input, encoded);
+    TRY(m_output_stream->write_until_depleted({ encoded, input.size() / 3 * 4 }));
+    return input.size();
+}
 
-        const u8 in0 = get(i);
-        const u8 in1 = get(i + 1, &is_16bit);
-        const u8 in2 = get(i + 2, &is_8bit);
+bool Base64Encoder::is_eof() const
+{
+    return false;
+}
+
+bool Base64Encoder::is_open() const
+{
+    return m_output_stream->is_open();
+}
 
-        const u8 index0 = (in0 >> 2) & 0x3f;
-        const u8 index1 = ((in0 << 4) | (in1 >> 4)) & 0x3f;
-        const u8 index2 = ((in1 << 2) | (in2 >> 6)) & 0x3f;
-        const u8 index3 = in2 & 0x3f;
+void Base64Encoder::close()
+{
+}
 
-        char const out0 = base64_alphabet[index0];
-        char const out1 = base64_alphabet[index1];
-        char const out2 = is_16bit ? '=' : base64_alphabet[index2];
-        char const out3 = is_8bit ? '=' : base64_alphabet[index3];
+ErrorOr<void> Base64Encoder::finish()
+{
+    VERIFY(!m_finished);
 
-        TRY(output.try_append(out0));
-        TRY(output.try_append(out1));
-        TRY(output.try_append(out2));
-        TRY(output.try_append(out3));
+    if (m_pending_length > 0) {
+        char encoded[4];
+        encode_base64_into({ m_pending_bytes.data(), m_pending_length }, encoded);
+        TRY(m_output_stream->write_until_depleted({ encoded, sizeof(encoded) }));
     }
 
-    return output.to_string();
+    m_pending_length = 0;
+    m_finished = true;
+    return {};
+}
+
+Base64Decoder::Base64Decoder(MaybeOwned<Stream> stream)
+    : m_output_stream(move(stream))
+{
+}
+
+ErrorOr<Bytes> Base64Decoder::read_some(Bytes)
+{
+    return Error::from_errno(EBADF);
+}
+
+ErrorOr<size_t> Base64Decoder::write_some(ReadonlyBytes bytes)
+{
+    VERIFY(!m_finished);
+
+    u8 decoded[streaming_chunk_size / 4 * 3 + 3];
+    auto input = bytes.trim(streaming_chunk_size);
+    auto length = TRY(decode_base64_into(m_state, StringView { input }, decoded));
+    TRY(m_output_stream->write_until_depleted({ decoded, length }));
+    return input.size();
 }
 
+bool Base64Decoder::is_eof() const
+{
+    return false;
+}
+
+bool Base64Decoder::is_open() const
+{
+    return m_output_stream->is_open();
+}
+
+void Base64Decoder::close()
+{
 }
+
+ErrorOr<void> Base64Decoder::finish()
+{
+    VERIFY(!m_finished);
+    m_finished = true;
+
+    u8 decoded[3];
+    auto* end = decoded;
+    TRY(finish_decoding(m_state, end));
+    TRY(m_output_stream->write_until_depleted({ decoded, static_cast<size_t>(end - decoded) }));
+    return {};
+}
+
+}
+
+#pragma GCC diagnostic pop
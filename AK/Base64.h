@@ -9,6 +9,8 @@
 #include <AK/Array.h>
 #include <AK/ByteBuffer.h>
 #include <AK/Error.h>
+#include <AK/MaybeOwned.h>
+#include <AK/Stream.h>
 #include <AK/String.h>
 #include <AK/StringView.h>
 
@@ -42,9 +44,59 @@ consteval auto base64_lookup_table()
 [[nodiscard]] ErrorOr<ByteBuffer> decode_base64(StringView);
 
 [[nodiscard]] ErrorOr<String> encode_base64(ReadonlyBytes);
+
+// Encodes everything written to it as base64 into the output stream, so the input doesn't have to be in memory all at once.
+// finish() must be called after the last write to flush the final, padded group.
+class Base64Encoder final : public Stream {
+public:
+    explicit Base64Encoder(MaybeOwned<Stream>);
+
+    virtual ErrorOr<Bytes> read_some(Bytes) override;
+    virtual ErrorOr<size_t> write_some(ReadonlyBytes) override;
+    virtual bool is_eof() const override;
+    virtual bool is_open() const override;
+    virtual void close() override;
+    ErrorOr<void> finish();
+
+private:
+    MaybeOwned<Stream> m_output_stream;
+    Array<u8, 2> m_pending_bytes {};
+    size_t m_pending_length { 0 };
+    bool m_finished { false };
+};
+
+// Decodes base64 text written to it into the output stream, accepting the same input as decode_base64() regardless of
+// how it is split between writes. finish() must be called after the last write to check and flush the final group.
+class Base64Decoder final : public Stream {
+public:
+    explicit Base64Decoder(MaybeOwned<Stream>);
+
+    virtual ErrorOr<Bytes> read_some(Bytes) override;
+    virtual ErrorOr<size_t> write_some(ReadonlyBytes) override;
+    virtual bool is_eof() const override;
+    virtual bool is_open() const override;
+    virtual void close() override;
+    ErrorOr<void> finish();
+
+    // The state of a partially decoded group of four characters.
+    struct State {
+        u32 bits { 0 };
+        u8 length { 0 };
+        u8 padding_length { 0 };
+        bool finished { false };
+    };
+
+private:
+    MaybeOwned<Stream> m_output_stream;
+    State m_state;
+    bool m_finished { false };
+};
+
 }
 
 #if USING_AK_GLOBALLY
+using AK::Base64Decoder;
+using AK::Base64Encoder;
 using AK::decode_base64;
 using AK::encode_base64;
 #endif
@@ -210,6 +210,7 @@ public:
         size_t* bitmap = reinterpret_cast<size_t*>(m_data);
 
         // Calculating the start offset.
+        size_t const first_bit = from;
         size_t start_bucket_index = from / bit_size;
         size_t start_bucket_bit = from % bit_size;
 
@@ -227,11 +228,11 @@ public:
                 continue;
             }
             if (bitmap[bucket_index] == 0x0) {
-                // Skip over completely empty bucket of size bit_size.
+                // Skip over completely empty bucket of size bit_size, leaving out the bits before `from`.
                 if (free_chunks == 0) {
-                    *start_of_free_chunks = bucket_index * bit_size;
+                    *start_of_free_chunks = bucket_index * bit_size + start_bucket_bit;
                 }
-                free_chunks += bit_size;
+                free_chunks += bit_size - start_bucket_bit;
                 if (free_chunks >= max_length) {
                     return max_length;
                 }
@@ -277,9 +278,9 @@ public:
         }
 
         if (free_chunks < min_length) {
-            size_t first_trailing_bit = (m_size / bit_size) * bit_size;
-            size_t trailing_bits = size() % bit_size;
-            for (size_t i = 0; i < trailing_bits; ++i) {
+            // Don't look at the trailing bits before `from` either.
+            size_t first_trailing_bit = max((m_size / bit_size) * bit_size, first_bit);
+            for (size_t i = 0; first_trailing_bit + i < size(); ++i) {
                 if (!get(first_trailing_bit + i)) {
                     if (free_chunks == 0)
                         *start_of_free_chunks = first_trailing_bit + i;
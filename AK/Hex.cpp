@@ -6,20 +6,95 @@
  */
 
 #include <AK/Hex.h>
-#include <AK/StringBuilder.h>
 #include <AK/Types.h>
-#include <AK/Vector.h>
+
+#ifndef KERNEL
+#    include <AK/BitCast.h>
+#    include <AK/SIMD.h>
+
+// See AK/SIMDExtras.h for why the vector functions here are fine despite this warning.
+#    pragma GCC diagnostic push
+#    pragma GCC diagnostic ignored "-Wpsabi"
+#endif
 
 namespace AK {
 
+#ifndef KERNEL
+using SIMD::u16x8;
+using SIMD::u64x2;
+using SIMD::u8x16;
+using SIMD::u8x8;
+
+// Decodes 16 hex digits into 8 bytes, or returns false without writing anything if any of them is not a hex digit.
+ALWAYS_INLINE static bool decode_hex_block(char const* input, u8* output)
+{
+    u8x16 digits;
+    __builtin_memcpy(&digits, input, sizeof(digits));
+
+    // The subtraction wraps around for characters before the start of each range, and setting bit 5 folds uppercase letters into lowercase.
+    auto decimal_values = digits - '0';
+    auto letter_values = (digits | 0x20) - 'a';
+    auto is_decimal = decimal_values < 10;
+    auto is_letter = letter_values < 6;
+
+    auto is_hex_digit = bit_cast<u64x2>(is_decimal | is_letter);
+    if ((is_hex_digit[0] & is_hex_digit[1]) != NumericLimits<u64>::max())
+        return false;
+
+    auto values = (decimal_values & bit_cast<u8x16>(is_decimal)) | ((letter_values + 10) & bit_cast<u8x16>(is_letter));
+
+    // Each pair of digits is one 16-bit lane, with the high nibble in its low byte.
+    auto pairs = bit_cast<u16x8>(values);
+    auto bytes = __builtin_convertvector((pairs << 4) | (pairs >> 8), u8x8);
+    __builtin_memcpy(output, &bytes, sizeof(bytes));
+    return true;
+}
+
+// Encodes 8 bytes into 16 lowercase hex digits.
+ALWAYS_INLINE static void encode_hex_block(u8 const* input, char* output)
+{
+    u8x8 bytes;
+    __builtin_memcpy(&bytes, input, sizeof(bytes));
+
+    // Widen each byte to a 16-bit lane, with the high nibble going into the low byte so it comes first in memory.
+    auto pairs = __builtin_convertvector(bytes, u16x8);
+    auto nibbles = bit_cast<u8x16>((pairs >> 4) | ((pairs & 0xf) << 8));
+
+    auto digits = nibbles + '0' + (bit_cast<u8x16>(nibbles > 9) & static_cast<u8>('a' - '0' - 10));
+    __builtin_memcpy(output, &digits, sizeof(digits));
+}
+#endif
+
+static void encode_hex_into(ReadonlyBytes input, char* output)
+{
+    static constexpr auto digits = "0123456789abcdef"sv;
+
+    size_t offset = 0;
+#ifndef KERNEL
+    for (; input.size() - offset >= 8; offset += 8)
+        encode_hex_block(input.data() + offset, output + offset * 2);
+#endif
+
+    for (; offset < input.size(); ++offset) {
+        output[offset * 2] = digits[input[offset] >> 4];
+        output[offset * 2 + 1] = digits[input[offset] & 0xf];
+    }
+}
+
 ErrorOr<ByteBuffer> decode_hex(StringView input)
 {
     if ((input.length() % 2) != 0)
         return Error::from_string_view_or_print_error_and_return_errno("Hex string was not an even length"sv, EINVAL);
 
-    auto output = TRY(ByteBuffer::create_zeroed(input.length() / 2));
+    auto output = TRY(ByteBuffer::create_uninitialized(input.length() / 2));
 
-    for (size_t i = 0; i < input.length() / 2; ++i) {
+    size_t i = 0;
+#ifndef KERNEL
+    while (input.length() / 2 - i >= 8 && decode_hex_block(input.characters_without_null_termination() + i * 2, output.data() + i))
+        i += 8;
+#endif
+
+    for (; i < input.length() / 2; ++i) {
         auto const c1 = decode_hex_digit(input[i * 2]);
         if (c1 >= 16)
             return Error::from_string_view_or_print_error_and_return_errno("Hex string contains invalid digit"sv, EINVAL);
@@ -37,23 +112,26 @@ ErrorOr<ByteBuffer> decode_hex(StringView input)
 #ifdef KERNEL
 ErrorOr<NonnullOwnPtr<Kernel::KString>> encode_hex(const ReadonlyBytes input)
 {
-    StringBuilder output(input.size() * 2);
-
-    for (auto ch : input)
-        TRY(output.try_appendff("{:02x}", ch));
-
-    return Kernel::KString::try_create(output.string_view());
+    char* buffer;
+    auto string = TRY(Kernel::KString::try_create_uninitialized(input.size() * 2, buffer));
+    encode_hex_into(input, buffer);
+    return string;
 }
 #else
 DeprecatedString encode_hex(const ReadonlyBytes input)
 {
-    StringBuilder output(input.size() * 2);
+    if (input.is_empty())
+        return DeprecatedString::empty();
 
-    for (auto ch : input)
-        output.appendff("{:02x}", ch);
-
-    return output.to_deprecated_string();
+    char* buffer;
+    auto impl = StringImpl::create_uninitialized(input.size() * 2, buffer);
+    encode_hex_into(input, buffer);
+    return *impl;
 }
 #endif
 
 }
+
+#ifndef KERNEL
+#    pragma GCC diagnostic pop
+#endif
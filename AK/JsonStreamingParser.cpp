@@ -0,0 +1,390 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/BitCast.h>
+#include <AK/BuiltinWrappers.h>
+#include <AK/CharacterTypes.h>
+#include <AK/JsonParser.h>
+#include <AK/JsonStreamingParser.h>
+#include <AK/SIMD.h>
+#include <AK/StringUtils.h>
+
+// See AK/SIMDExtras.h for why the vector functions here are fine despite this warning.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi"
+
+namespace AK {
+
+using SIMD::i8x16;
+using SIMD::u8x16;
+
+static constexpr size_t block_size = 64;
+
+// Returns a mask with bit i set if lane i of the comparison result is set.
+ALWAYS_INLINE static u64 to_bitmask(i8x16 comparison)
+{
+#if defined(__SSE2__)
+    return static_cast<u16>(__builtin_ia32_pmovmskb128(bit_cast<SIMD::c8x16>(comparison)));
+#else
+    u64 bits = 0;
+    for (size_t i = 0; i < sizeof(comparison); ++i)
+        bits |= static_cast<u64>(comparison[i] != 0) << i;
+    return bits;
+#endif
+}
+
+struct BlockMasks {
+    u64 backslash { 0 };
+    u64 quote { 0 };
+    u64 whitespace { 0 };
+    u64 operators { 0 };
+};
+
+ALWAYS_INLINE static BlockMasks classify_block(u8 const* block)
+{
+    BlockMasks masks;
+
+    for (size_t i = 0; i < block_size; i += sizeof(u8x16)) {
+        u8x16 chunk;
+        __builtin_memcpy(&chunk, block + i, sizeof(chunk));
+
+        // '[' and ']' only differ from '{' and '}' in bit 5.
+        auto folded = chunk | 0x20;
+        auto whitespace = (chunk == ' ') | (chunk == '\t') | (chunk == '\n') | (chunk == '\r');
+        auto operators = (folded == '{') | (folded == '}') | (chunk == ':') | (chunk == ',');
+
+        masks.backslash |= to_bitmask(chunk == '\\') << i;
+        masks.quote |= to_bitmask(chunk == '"') << i;
+        masks.whitespace |= to_bitmask(whitespace) << i;
+        masks.operators |= to_bitmask(operators) << i;
+    }
+
+    return masks;
+}
+
+// Sets every bit to the XOR of itself and all the bits below it.
+ALWAYS_INLINE static u64 prefix_xor(u64 bits)
+{
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+}
+
+// This follows the first stage of simdjson, as described in "Parsing Gigabytes of JSON per Second" (Langdale and Lemire, 2019).
+// Every block is reduced to bitmasks, and the state that carries over between blocks is kept to a handful of bits.
+ErrorOr<void> JsonStreamingParser::build_structural_index()
+{
+    if (m_input.length() > NumericLimits<u32>::max())
+        return Error::from_string_literal("JsonStreamingParser: Input is too large");
+
+    m_structural_indices.clear_with_capacity();
+
+    auto const* input = reinterpret_cast<u8 const*>(m_input.characters_without_null_termination());
+    auto length = m_input.length();
+
+    u64 previous_escaped = 0;
+    u64 previous_in_string = 0;
+    u64 previous_scalar = 0;
+
+    for (size_t offset = 0; offset < length; offset += block_size) {
+        u8 const* block = input + offset;
+
+        // Pad the last block with whitespace, which is never structural.
+        u8 padded_block[block_size];
+        if (length - offset < block_size) {
+            __builtin_memset(padded_block, ' ', block_size);
+            __builtin_memcpy(padded_block, block, length - offset);
+            block = padded_block;
+        }
+
+        auto masks = classify_block(block);
+
+        // A character is escaped if it follows an odd-length run of backslashes. Runs are found by adding their
+        // start to them, which carries through the run; the parity of the start position then tells us which
+        // of the characters in the run (and the one after it) are escaped.
+        constexpr u64 even_bits = 0x5555555555555555ull;
+        u64 backslash = masks.backslash & ~previous_escaped;
+        u64 follows_escape = (backslash << 1) | previous_escaped;
+        u64 odd_sequence_starts = backslash & ~even_bits & ~follows_escape;
+        u64 sequences_starting_on_even_bits;
+        previous_escaped = __builtin_add_overflow(odd_sequence_starts, backslash, &sequences_starting_on_even_bits);
+        u64 escaped = (even_bits ^ (sequences_starting_on_even_bits << 1)) & follows_escape;
+
+        // The running XOR of the unescaped quotes is set from each opening quote up to, but not including, its closing quote.
+        u64 quote = masks.quote & ~escaped;
+        u64 in_string = prefix_xor(quote) ^ previous_in_string;
+        previous_in_string = static_cast<u64>(static_cast<i64>(in_string) >> 63);
+        u64 string_tail = in_string ^ quote;
+
+        // Any other value starts at a non-whitespace character that follows an operator or whitespace.
+        u64 scalar = ~(masks.operators | masks.whitespace);
+        u64 non_quote_scalar = scalar & ~quote;
+        u64 follows_non_quote_scalar = (non_quote_scalar << 1) | previous_scalar;
+        previous_scalar = non_quote_scalar >> 63;
+        u64 scalar_start = scalar & ~follows_non_quote_scalar;
+
+        u64 structurals = (masks.operators | scalar_start) & ~string_tail;
+
+        TRY(m_structural_indices.try_grow_capacity(m_structural_indices.size() + popcount(structurals)));
+        while (structurals != 0) {
+            m_structural_indices.unchecked_append(static_cast<u32>(offset + count_trailing_zeroes(structurals)));
+            structurals &= structurals - 1;
+        }
+    }
+
+    if (previous_in_string != 0)
+        return Error::from_string_literal("JsonStreamingParser: EOF while parsing String");
+
+    return {};
+}
+
+ErrorOr<StringView> JsonStreamingParser::parse_string(size_t start, StringBuilder& unescaped_string)
+{
+    VERIFY(m_input[start] == '"');
+
+    // The structural index doesn't know where the string ends, so look for the closing quote. If there are no
+    // escapes on the way there, the string can be used as it is.
+    size_t position = start + 1;
+    for (; position < m_input.length(); ++position) {
+        char ch = m_input[position];
+        if (ch == '"')
+            return m_input.substring_view(start + 1, position - start - 1);
+        if (ch == '\\')
+            break;
+        if (is_ascii_c0_control(ch))
+            return Error::from_string_literal("JsonStreamingParser: ASCII control sequence encountered");
+    }
+
+    unescaped_string.clear();
+    unescaped_string.append(m_input.substring_view(start + 1, position - start - 1));
+
+    while (position < m_input.length()) {
+        char ch = m_input[position++];
+        if (ch == '"')
+            return unescaped_string.string_view();
+        if (is_ascii_c0_control(ch))
+            return Error::from_string_literal("JsonStreamingParser: ASCII control sequence encountered");
+        if (ch != '\\') {
+            unescaped_string.append(ch);
+            continue;
+        }
+
+        if (position == m_input.length())
+            break;
+
+        switch (m_input[position++]) {
+        case '"':
+            unescaped_string.append('"');
+            break;
+        case '\\':
+            unescaped_string.append('\\');
+            break;
+        case '/':
+            unescaped_string.append('/');
+            break;
+        case 'b':
+            unescaped_string.append('\b');
+            break;
+        case 'f':
+            unescaped_string.append('\f');
+            break;
+        case 'n':
+            unescaped_string.append('\n');
+            break;
+        case 'r':
+            unescaped_string.append('\r');
+            break;
+        case 't':
+            unescaped_string.append('\t');
+            break;
+        case 'u': {
+            if (m_input.length() - position < 4)
+                return Error::from_string_literal("JsonStreamingParser: EOF while parsing Unicode escape");
+            auto code_point = AK::StringUtils::convert_to_uint_from_hex(m_input.substring_view(position, 4));
+            if (!code_point.has_value())
+                return Error::from_string_literal("JsonStreamingParser: Error while parsing Unicode escape");
+            // NOTE: Like JsonParser, surrogate pairs are appended as two separate code points.
+            unescaped_string.append_code_point(code_point.value());
+            position += 4;
+            break;
+        }
+        default:
+            return Error::from_string_literal("JsonStreamingParser: Invalid escaped character");
+        }
+    }
+
+    return Error::from_string_literal("JsonStreamingParser: EOF while parsing String");
+}
+
+ErrorOr<JsonValue> JsonStreamingParser::parse_scalar(size_t start, size_t end)
+{
+    auto token = m_input.substring_view(start, end - start).trim_whitespace(TrimMode::Right);
+
+    // Fast path for the most common kind of number, everything else is handled by JsonParser.
+    if (token.length() <= 19 && is_ascii_digit(token[0]) && (token[0] != '0' || token.length() == 1)) {
+        u64 value = 0;
+        bool is_integer = true;
+        for (auto ch : token) {
+            if (!is_ascii_digit(ch)) {
+                is_integer = false;
+                break;
+            }
+            value = value * 10 + (ch - '0');
+        }
+
+        if (is_integer) {
+            if (value <= NumericLimits<u32>::max())
+                return JsonValue(static_cast<u32>(value));
+            return JsonValue(value);
+        }
+    }
+
+    if (token == "true"sv)
+        return JsonValue(true);
+    if (token == "false"sv)
+        return JsonValue(false);
+    if (token == "null"sv)
+        return JsonValue {};
+
+    if (token[0] != '-' && !is_ascii_digit(token[0]))
+        return Error::from_string_literal("JsonStreamingParser: Unexpected character");
+
+    return JsonParser { token }.parse();
+}
+
+ErrorOr<void> JsonStreamingParser::parse_document(Visitor& visitor)
+{
+    enum class State {
+        Value,
+        Key,
+        AfterValue,
+    };
+
+    auto const& indices = m_structural_indices;
+    auto character_at = [&](size_t index) { return m_input[indices[index]]; };
+
+    Vector<Container, 32> containers;
+    State state = State::Value;
+    size_t index = 0;
+
+    for (;;) {
+        switch (state) {
+        case State::Value: {
+            if (index == indices.size())
+                return Error::from_string_literal("JsonStreamingParser: Unexpected end of input");
+
+            auto start = indices[index++];
+            switch (m_input[start]) {
+            case '{':
+                TRY(visitor.on_object_start());
+                if (index < indices.size() && character_at(index) == '}') {
+                    ++index;
+                    TRY(visitor.on_object_end());
+                    state = State::AfterValue;
+                } else {
+                    TRY(containers.try_append(Container::Object));
+                    state = State::Key;
+                }
+                break;
+            case '[':
+                TRY(visitor.on_array_start());
+                if (index < indices.size() && character_at(index) == ']') {
+                    ++index;
+                    TRY(visitor.on_array_end());
+                    state = State::AfterValue;
+                } else {
+                    TRY(containers.try_append(Container::Array));
+                }
+                break;
+            case '"':
+                TRY(visitor.on_string(TRY(parse_string(start, m_unescaped_string))));
+                state = State::AfterValue;
+                break;
+            case '}':
+            case ']':
+            case ':':
+            case ',':
+                return Error::from_string_literal("JsonStreamingParser: Unexpected character");
+            default: {
+                auto end = index < indices.size() ? indices[index] : m_input.length();
+                auto value = TRY(parse_scalar(start, end));
+                if (value.is_number())
+                    TRY(visitor.on_number(value));
+                else if (value.is_bool())
+                    TRY(visitor.on_boolean(value.as_bool()));
+                else if (value.is_null())
+                    TRY(visitor.on_null());
+                else
+                    VERIFY_NOT_REACHED();
+                state = State::AfterValue;
+                break;
+            }
+            }
+            break;
+        }
+
+        case State::Key: {
+            if (index == indices.size() || character_at(index) != '"')
+                return Error::from_string_literal("JsonStreamingParser: Expected '\"'");
+            TRY(visitor.on_key(TRY(parse_string(indices[index++], m_unescaped_key))));
+
+            if (index == indices.size() || character_at(index) != ':')
+                return Error::from_string_literal("JsonStreamingParser: Expected ':'");
+            ++index;
+
+            state = State::Value;
+            break;
+        }
+
+        case State::AfterValue: {
+            if (containers.is_empty()) {
+                if (index != indices.size())
+                    return Error::from_string_literal("JsonStreamingParser: Didn't consume all input");
+                return {};
+            }
+
+            if (index == indices.size())
+                return Error::from_string_literal("JsonStreamingParser: Unexpected end of input");
+
+            auto ch = character_at(index++);
+            if (containers.last() == Container::Object) {
+                if (ch == ',') {
+                    state = State::Key;
+                } else if (ch == '}') {
+                    containers.take_last();
+                    TRY(visitor.on_object_end());
+                } else {
+                    return Error::from_string_literal("JsonStreamingParser: Expected ','");
+                }
+            } else {
+                if (ch == ',') {
+                    state = State::Value;
+                } else if (ch == ']') {
+                    containers.take_last();
+                    TRY(visitor.on_array_end());
+                } else {
+                    return Error::from_string_literal("JsonStreamingParser: Expected ','");
+                }
+            }
+            break;
+        }
+        }
+    }
+}
+
+ErrorOr<void> JsonStreamingParser::parse(Visitor& visitor)
+{
+    TRY(build_structural_index());
+    return parse_document(visitor);
+}
+
+}
+
+#pragma GCC diagnostic pop
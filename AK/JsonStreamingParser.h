@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Error.h>
+#include <AK/JsonValue.h>
+#include <AK/StringBuilder.h>
+#include <AK/StringView.h>
+#include <AK/Vector.h>
+
+namespace AK {
+
+// Parses a JSON document without building a JsonValue tree, by reporting its contents to a Visitor as they are found.
+//
+// Parsing happens in two stages: First, the whole input is scanned a block at a time to find the position of every
+// structural character ({}[]:,) and the start of every value, skipping over anything inside strings. Second, those
+// positions are walked to validate the grammar and report each value.
+class JsonStreamingParser {
+public:
+    class Visitor {
+    public:
+        virtual ~Visitor() = default;
+
+        virtual ErrorOr<void> on_object_start() { return {}; }
+        virtual ErrorOr<void> on_object_end() { return {}; }
+        virtual ErrorOr<void> on_array_start() { return {}; }
+        virtual ErrorOr<void> on_array_end() { return {}; }
+
+        // Strings without escape sequences are passed as views into the input, so they live as long as the input does.
+        // Strings that had to be unescaped are only valid until the next call to the same function.
+        virtual ErrorOr<void> on_key(StringView) { return {}; }
+        virtual ErrorOr<void> on_string(StringView) { return {}; }
+
+        // The number is one of the numeric JsonValue types, chosen the same way as JsonParser does.
+        virtual ErrorOr<void> on_number(JsonValue const&) { return {}; }
+        virtual ErrorOr<void> on_boolean(bool) { return {}; }
+        virtual ErrorOr<void> on_null() { return {}; }
+    };
+
+    explicit JsonStreamingParser(StringView input)
+        : m_input(input)
+    {
+    }
+
+    ErrorOr<void> parse(Visitor&);
+
+private:
+    enum class Container : u8 {
+        Object,
+        Array,
+    };
+
+    ErrorOr<void> build_structural_index();
+    ErrorOr<void> parse_document(Visitor&);
+
+    ErrorOr<StringView> parse_string(size_t start, StringBuilder& unescaped_string);
+    ErrorOr<JsonValue> parse_scalar(size_t start, size_t end);
+
+    StringView m_input;
+    Vector<u32> m_structural_indices;
+    StringBuilder m_unescaped_key;
+    StringBuilder m_unescaped_string;
+};
+
+}
+
+#if USING_AK_GLOBALLY
+using AK::JsonStreamingParser;
+#endif
@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include <AK/BitCast.h>
 #include <AK/Concepts.h>
 #include <AK/SIMD.h>
 
@@ -172,6 +173,9 @@ ALWAYS_INLINE static void store4_masked(VectorType v, UnderlyingType* a, Underly
 template<OneOf<i8x16, u8x16> T>
 ALWAYS_INLINE static T shuffle(T a, T control)
 {
+#if defined(__SSSE3__)
+    return bit_cast<T>(__builtin_ia32_pshufb128(bit_cast<c8x16>(a), bit_cast<c8x16>(control & 0xf)));
+#else
     // FIXME: This is probably not the fastest way to do this.
     return T {
         a[control[0] & 0xf],
@@ -191,6 +195,7 @@ ALWAYS_INLINE static T shuffle(T a, T control)
         a[control[14] & 0xf],
         a[control[15] & 0xf],
     };
+#endif
 }
 }
 
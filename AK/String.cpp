@@ -233,6 +233,13 @@ ErrorOr<String> String::from_utf8(StringView view)
     if (!Utf8View { view }.validate())
         return Error::from_string_literal("String::from_utf8: Input was not valid UTF-8");
 
+    return from_utf8_without_validation(view.bytes());
+}
+
+ErrorOr<String> String::from_utf8_without_validation(ReadonlyBytes bytes)
+{
+    StringView view { bytes };
+
     if (view.length() <= MAX_SHORT_STRING_BYTE_COUNT) {
         ShortString short_string;
         if (!view.is_empty())
@@ -70,6 +70,9 @@ public:
     requires(IsOneOf<RemoveCVReference<T>, DeprecatedString, DeprecatedFlyString>)
     static ErrorOr<String> from_utf8(T&&) = delete;
 
+    // Creates a new String from a sequence of UTF-8 encoded code points that the caller has already validated.
+    static ErrorOr<String> from_utf8_without_validation(ReadonlyBytes);
+
     // Creates a new String by reading byte_count bytes from a UTF-8 encoded Stream.
     static ErrorOr<String> from_stream(Stream&, size_t byte_count);
 
@@ -6,12 +6,18 @@
 
 #include <AK/CharacterTypes.h>
 #include <AK/Concepts.h>
+#include <AK/SIMD.h>
 #include <AK/StringBuilder.h>
 #include <AK/StringView.h>
+#include <AK/UnicodeUtils.h>
 #include <AK/Utf16View.h>
 #include <AK/Utf32View.h>
 #include <AK/Utf8View.h>
 
+// See AK/SIMDExtras.h for why the vector functions here are fine despite this warning.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi"
+
 namespace AK {
 
 static constexpr u16 high_surrogate_min = 0xd800;
@@ -33,13 +39,73 @@ static ErrorOr<Utf16Data> to_utf16_impl(UtfViewType const& view)
     return utf16_data;
 }
 
+// Copies runs of ASCII 16 bytes at a time, and decodes everything else one code point at a time.
+// The input must be valid UTF-8.
+static ErrorOr<Utf16Data> valid_utf8_to_utf16(Utf8View const& utf8_view)
+{
+    auto const* input = utf8_view.bytes();
+    auto const* end = input + utf8_view.byte_length();
+
+    // Every byte that isn't a continuation byte starts a code point, and four byte sequences become surrogate pairs.
+    size_t utf16_length = 0;
+    for (auto const* byte = input; byte < end; ++byte)
+        utf16_length += ((*byte & 0xc0) != 0x80) + (*byte >= 0xf0);
+
+    Utf16Data utf16_data;
+    TRY(utf16_data.try_resize(utf16_length));
+    auto* output = utf16_data.data();
+
+    while (input < end) {
+        if (*input < 0x80 && end - input >= 16) {
+            u64 words[2];
+            __builtin_memcpy(words, input, sizeof(words));
+
+            if (((words[0] | words[1]) & 0x8080808080808080ull) == 0) {
+                SIMD::u8x16 bytes;
+                __builtin_memcpy(&bytes, input, sizeof(bytes));
+                auto code_units = __builtin_convertvector(bytes, SIMD::u16x16);
+                __builtin_memcpy(output, &code_units, sizeof(code_units));
+
+                input += 16;
+                output += 16;
+                continue;
+            }
+        }
+
+        u32 byte = *input;
+        if (byte < 0x80) {
+            *output++ = static_cast<u16>(byte);
+            input += 1;
+        } else if (byte < 0xe0) {
+            *output++ = static_cast<u16>(((byte & 0x1f) << 6) | (input[1] & 0x3f));
+            input += 2;
+        } else if (byte < 0xf0) {
+            *output++ = static_cast<u16>(((byte & 0x0f) << 12) | ((input[1] & 0x3f) << 6) | (input[2] & 0x3f));
+            input += 3;
+        } else {
+            u32 code_point = ((byte & 0x07) << 18) | ((input[1] & 0x3f) << 12) | ((input[2] & 0x3f) << 6) | (input[3] & 0x3f);
+            code_point -= first_supplementary_plane_code_point;
+            *output++ = static_cast<u16>(high_surrogate_min | (code_point >> 10));
+            *output++ = static_cast<u16>(low_surrogate_min | (code_point & 0x3ff));
+            input += 4;
+        }
+    }
+
+    VERIFY(output == utf16_data.data() + utf16_length);
+    return utf16_data;
+}
+
 ErrorOr<Utf16Data> utf8_to_utf16(StringView utf8_view)
 {
-    return to_utf16_impl(Utf8View { utf8_view });
+    return utf8_to_utf16(Utf8View { utf8_view });
 }
 
 ErrorOr<Utf16Data> utf8_to_utf16(Utf8View const& utf8_view)
 {
+    if (utf8_view.validate())
+        return valid_utf8_to_utf16(utf8_view);
+
+    // Invalid input needs to be decoded one code point at a time, to produce the same replacement characters as the iterator.
     return to_utf16_impl(utf8_view);
 }
 
@@ -88,29 +154,54 @@ ErrorOr<DeprecatedString> Utf16View::to_deprecated_string(AllowInvalidCodeUnits
 
 ErrorOr<String> Utf16View::to_utf8(AllowInvalidCodeUnits allow_invalid_code_units) const
 {
-    StringBuilder builder;
-
-    if (allow_invalid_code_units == AllowInvalidCodeUnits::Yes) {
-        for (auto const* ptr = begin_ptr(); ptr < end_ptr(); ++ptr) {
-            if (is_high_surrogate(*ptr)) {
-                auto const* next = ptr + 1;
-
-                if ((next < end_ptr()) && is_low_surrogate(*next)) {
-                    auto code_point = decode_surrogate_pair(*ptr, *next);
-                    TRY(builder.try_append_code_point(code_point));
-                    ++ptr;
-                    continue;
-                }
-            }
+    // Unpaired surrogates are either encoded as they are, or replaced with U+FFFD. Both take three bytes.
+    size_t utf8_length = 0;
+    for (auto const* ptr = begin_ptr(); ptr < end_ptr(); ++ptr) {
+        if (*ptr < 0x80) {
+            utf8_length += 1;
+        } else if (*ptr < 0x800) {
+            utf8_length += 2;
+        } else if (is_high_surrogate(*ptr) && (ptr + 1 < end_ptr()) && is_low_surrogate(*(ptr + 1))) {
+            utf8_length += 4;
+            ++ptr;
+        } else {
+            utf8_length += 3;
+        }
+    }
 
-            TRY(builder.try_append_code_point(static_cast<u32>(*ptr)));
+    Vector<u8, 256> utf8_data;
+    TRY(utf8_data.try_resize(utf8_length));
+    auto* output = utf8_data.data();
+
+    for (auto const* ptr = begin_ptr(); ptr < end_ptr();) {
+        // Narrow runs of ASCII 8 code units at a time.
+        if (*ptr < 0x80 && end_ptr() - ptr >= 8) {
+            u64 words[2];
+            __builtin_memcpy(words, ptr, sizeof(words));
+
+            if (((words[0] | words[1]) & 0xff80ff80ff80ff80ull) == 0) {
+                SIMD::u16x8 code_units;
+                __builtin_memcpy(&code_units, ptr, sizeof(code_units));
+                auto bytes = __builtin_convertvector(code_units, SIMD::u8x8);
+                __builtin_memcpy(output, &bytes, sizeof(bytes));
+
+                ptr += 8;
+                output += 8;
+                continue;
+            }
         }
-    } else {
-        for (auto code_point : *this)
-            TRY(builder.try_append_code_point(code_point));
+
+        u32 code_point = *ptr++;
+        if (is_high_surrogate(code_point) && (ptr < end_ptr()) && is_low_surrogate(*ptr))
+            code_point = decode_surrogate_pair(code_point, *ptr++);
+        else if (allow_invalid_code_units == AllowInvalidCodeUnits::No && is_unicode_surrogate(code_point))
+            code_point = replacement_code_point;
+
+        (void)UnicodeUtils::code_point_to_utf8(code_point, [&](char byte) { *output++ = static_cast<u8>(byte); });
     }
 
-    return builder.to_string();
+    VERIFY(output == utf8_data.data() + utf8_length);
+    return String::from_utf8_without_validation(utf8_data);
 }
 
 size_t Utf16View::length_in_code_points() const
@@ -317,3 +408,5 @@ size_t Utf16CodePointIterator::length_in_code_units() const
 }
 
 }
+
+#pragma GCC diagnostic pop
@@ -8,10 +8,169 @@
 #include <AK/Assertions.h>
 #include <AK/Debug.h>
 #include <AK/Format.h>
+#include <AK/SIMDExtras.h>
 #include <AK/Utf8View.h>
 
+// See the comment in AK/SIMDExtras.h, these functions are all local to this translation unit.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi"
+
 namespace AK {
 
+using SIMD::u8x16;
+
+static constexpr size_t chunk_size = sizeof(u8x16);
+
+ALWAYS_INLINE static u8x16 load_chunk(u8 const* data)
+{
+    u8x16 chunk;
+    __builtin_memcpy(&chunk, data, sizeof(chunk));
+    return chunk;
+}
+
+ALWAYS_INLINE static bool is_ascii_chunk(u8 const* data)
+{
+    u64 words[2];
+    __builtin_memcpy(words, data, sizeof(words));
+    return ((words[0] | words[1]) & 0x8080808080808080ull) == 0;
+}
+
+ALWAYS_INLINE static bool has_nonzero_byte(u8x16 chunk)
+{
+    u64 words[2];
+    __builtin_memcpy(words, &chunk, sizeof(words));
+    return (words[0] | words[1]) != 0;
+}
+
+// Errors that can occur between a pair of adjacent bytes, as classified by the lookup tables below.
+static constexpr u8 too_short = 1 << 0;      // 11______ 0_______ or 11______ 11______
+static constexpr u8 too_long = 1 << 1;       // 0_______ 10______
+static constexpr u8 overlong_3 = 1 << 2;     // 11100000 100_____
+static constexpr u8 too_large = 1 << 3;      // 11110100 1001____, 11110100 101_____ or 11110101+ 10______
+static constexpr u8 overlong_2 = 1 << 5;     // 1100000_ 10______
+static constexpr u8 too_large_1000 = 1 << 6; // 11110101+ 1000____
+static constexpr u8 overlong_4 = 1 << 6;     // 11110000 1000____
+static constexpr u8 two_continuations = 1 << 7;
+static constexpr u8 carry = too_short | too_long | two_continuations;
+
+// NOTE: Unlike strict UTF-8, we accept encoded surrogates (ED A0..BF __), to match the scalar implementation.
+static constexpr u8x16 byte_1_high_table {
+    // 0_______: ASCII
+    too_long, too_long, too_long, too_long, too_long, too_long, too_long, too_long,
+    // 10______: Continuation
+    two_continuations, two_continuations, two_continuations, two_continuations,
+    // 1100____: Two byte lead
+    too_short | overlong_2,
+    // 1101____: Two byte lead
+    too_short,
+    // 1110____: Three byte lead
+    too_short | overlong_3,
+    // 1111____: Four byte lead
+    too_short | too_large | too_large_1000 | overlong_4
+};
+
+static constexpr u8x16 byte_1_low_table {
+    carry | overlong_2 | overlong_3 | overlong_4, // ____0000
+    carry | overlong_2,                           // ____0001
+    carry,                                        // ____0010
+    carry,                                        // ____0011
+    carry | too_large,                            // ____0100
+    carry | too_large | too_large_1000,           // ____0101
+    carry | too_large | too_large_1000,           // ____0110
+    carry | too_large | too_large_1000,           // ____0111
+    carry | too_large | too_large_1000,           // ____1000
+    carry | too_large | too_large_1000,           // ____1001
+    carry | too_large | too_large_1000,           // ____1010
+    carry | too_large | too_large_1000,           // ____1011
+    carry | too_large | too_large_1000,           // ____1100
+    carry | too_large | too_large_1000,           // ____1101
+    carry | too_large | too_large_1000,           // ____1110
+    carry | too_large | too_large_1000,           // ____1111
+};
+
+static constexpr u8x16 byte_2_high_table {
+    // 0_______: ASCII
+    too_short, too_short, too_short, too_short, too_short, too_short, too_short, too_short,
+    // 1000____
+    too_long | overlong_2 | two_continuations | overlong_3 | too_large_1000 | overlong_4,
+    // 1001____
+    too_long | overlong_2 | two_continuations | overlong_3 | too_large,
+    // 101_____
+    too_long | overlong_2 | two_continuations | too_large,
+    too_long | overlong_2 | two_continuations | too_large,
+    // 11______
+    too_short, too_short, too_short, too_short
+};
+
+// This is the "lookup" algorithm from "Validating UTF-8 In Less Than One Instruction Per Byte" (Keiser and Lemire, 2021).
+// Every pair of adjacent bytes is looked up by the high and low nibble of the first byte and the high nibble of the second,
+// and the pair is invalid if all three lookups share an error bit. Third and fourth bytes are checked separately, as a
+// pair of continuation bytes is only valid if it is preceded by a three or four byte lead.
+// Expects the three bytes in front of the chunk to be readable.
+ALWAYS_INLINE static u8x16 find_errors_in_chunk(u8 const* data)
+{
+    auto input = load_chunk(data);
+    auto previous_1 = load_chunk(data - 1);
+    auto previous_2 = load_chunk(data - 2);
+    auto previous_3 = load_chunk(data - 3);
+
+    auto byte_1_high = SIMD::shuffle(byte_1_high_table, previous_1 >> 4);
+    auto byte_1_low = SIMD::shuffle(byte_1_low_table, previous_1 & 0x0f);
+    auto byte_2_high = SIMD::shuffle(byte_2_high_table, input >> 4);
+    auto special_cases = byte_1_high & byte_1_low & byte_2_high;
+
+    auto must_be_continuation = bit_cast<u8x16>((previous_2 >= 0xe0) | (previous_3 >= 0xf0)) & 0x80;
+    return must_be_continuation ^ special_cases;
+}
+
+ALWAYS_INLINE static bool ends_with_incomplete_sequence(u8 const* end)
+{
+    return end[-1] >= 0xc0 || end[-2] >= 0xe0 || end[-3] >= 0xf0;
+}
+
+bool Utf8View::validate_vectorized(size_t& valid_bytes) const
+{
+    auto const* data = begin_ptr();
+    auto length = byte_length();
+    size_t offset = 0;
+
+    if (length >= chunk_size) {
+        // Pad the first chunk with ASCII bytes, so that it can be checked the same way as the rest.
+        u8 first_chunk[3 + chunk_size] {};
+        __builtin_memcpy(first_chunk + 3, data, chunk_size);
+
+        if (!has_nonzero_byte(find_errors_in_chunk(first_chunk + 3))) {
+            for (offset = chunk_size; offset + chunk_size <= length; offset += chunk_size) {
+                auto const* chunk = data + offset;
+
+                if (is_ascii_chunk(chunk)) {
+                    // An ASCII chunk can only be invalid if it cuts off a sequence from the previous chunk.
+                    if (ends_with_incomplete_sequence(chunk))
+                        break;
+                    continue;
+                }
+
+                if (has_nonzero_byte(find_errors_in_chunk(chunk)))
+                    break;
+            }
+        }
+    }
+
+    // Everything before offset is known to be valid, except possibly for a code point that straddles it.
+    // Rewind to the start of that code point, and let the scalar implementation handle the rest. This
+    // also gives us the exact position of an error, if there is one.
+    auto start = offset;
+    while (start > 0 && offset - start < 3 && (data[start - 1] & 0xc0) == 0x80)
+        --start;
+    if (start > 0 && data[start - 1] >= 0xc0)
+        --start;
+
+    size_t remaining_valid_bytes = 0;
+    auto is_valid = substring_view(start).validate_scalar(remaining_valid_bytes);
+    valid_bytes = start + remaining_valid_bytes;
+    return is_valid;
+}
+
 Utf8CodePointIterator Utf8View::iterator_at_byte_offset(size_t byte_offset) const
 {
     size_t current_offset = 0;
@@ -245,3 +404,5 @@ ErrorOr<void> Formatter<Utf8View>::format(FormatBuilder& builder, Utf8View const
 }
 
 }
+
+#pragma GCC diagnostic pop
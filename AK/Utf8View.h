@@ -128,6 +128,22 @@ public:
     }
 
     constexpr bool validate(size_t& valid_bytes) const
+    {
+#ifndef KERNEL
+        if (!is_constant_evaluated())
+            return validate_vectorized(valid_bytes);
+#endif
+        return validate_scalar(valid_bytes);
+    }
+
+private:
+    friend class Utf8CodePointIterator;
+
+#ifndef KERNEL
+    bool validate_vectorized(size_t& valid_bytes) const;
+#endif
+
+    constexpr bool validate_scalar(size_t& valid_bytes) const
     {
         valid_bytes = 0;
 
@@ -157,9 +173,6 @@ public:
         return true;
     }
 
-private:
-    friend class Utf8CodePointIterator;
-
     u8 const* begin_ptr() const { return reinterpret_cast<u8 const*>(m_string.characters_without_null_termination()); }
     u8 const* end_ptr() const { return begin_ptr() + m_string.length(); }
     size_t calculate_length() const;
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Types.h>
+
+// An I/O ring is a pair of queues in memory that is shared between a process and the kernel.
+// The process writes requests into the submission queue and hands them to the kernel with io_ring_enter().
+// The kernel writes the result of every request into the completion queue once it's done.
+//
+// Both queues are rings of a power-of-two size. The producer of a queue only ever advances its tail, and the consumer
+// only ever advances its head, so neither side has to take a lock.
+
+enum class IORingOpcode : u8 {
+    Nop,
+    Read,
+    Write,
+    Accept,
+    Connect,
+    Send,
+    Receive,
+    Fsync,
+    PollAdd,
+};
+
+// Use the offset of the file description, and advance it, like read() and write() do.
+constexpr u64 IO_RING_CURRENT_OFFSET = ~0ull;
+
+struct IORingSubmission {
+    IORingOpcode opcode { IORingOpcode::Nop };
+    u8 reserved0 { 0 };
+    u16 reserved1 { 0 };
+    i32 fd { -1 };
+    // Read and Write: the file offset, or IO_RING_CURRENT_OFFSET.
+    u64 offset { IO_RING_CURRENT_OFFSET };
+    // Read, Write, Send and Receive: the buffer. Connect: the sockaddr.
+    u64 address { 0 };
+    // The size of whatever address points to.
+    u32 length { 0 };
+    // Send and Receive: MSG_* flags. Accept: SOCK_NONBLOCK and SOCK_CLOEXEC. PollAdd: POLL* events.
+    u32 operation_flags { 0 };
+    // Passed back unchanged in the completion.
+    u64 user_data { 0 };
+};
+
+struct IORingCompletion {
+    u64 user_data { 0 };
+    // What the equivalent syscall would have returned, or a negated errno.
+    i32 result { 0 };
+    u32 reserved { 0 };
+};
+
+// This sits at the start of the shared memory.
+struct IORingHeader {
+    u32 submission_head;
+    u32 submission_tail;
+    u32 completion_head;
+    u32 completion_tail;
+    // Completions that were lost because userspace moved completion_head past completions it hadn't seen.
+    u32 dropped_completions;
+};
+
+struct IORingParameters {
+    u32 submission_entries;
+    u32 completion_entries;
+    // The offsets of the submission and completion arrays from the start of the shared memory.
+    u32 submissions_offset;
+    u32 completions_offset;
+    // How much memory to mmap() from the ring's file descriptor.
+    u32 size;
+};
@@ -18,6 +18,7 @@
 constexpr int syscall_vector = 0x82;
 
 extern "C" {
+struct epoll_event;
 struct pollfd;
 struct timeval;
 struct timespec;
@@ -70,6 +71,9 @@ enum class NeedsBigProcessLock {
     S(dump_backtrace, NeedsBigProcessLock::No)             \
     S(dup2, NeedsBigProcessLock::No)                       \
     S(emuctl, NeedsBigProcessLock::No)                     \
+    S(epoll_create1, NeedsBigProcessLock::No)              \
+    S(epoll_ctl, NeedsBigProcessLock::No)                  \
+    S(epoll_pwait, NeedsBigProcessLock::No)                \
     S(execve, NeedsBigProcessLock::Yes)                    \
     S(exit, NeedsBigProcessLock::Yes)                      \
     S(exit_thread, NeedsBigProcessLock::Yes)               \
@@ -85,7 +89,7 @@ enum class NeedsBigProcessLock {
     S(fsmount, NeedsBigProcessLock::No)                    \
     S(fsync, NeedsBigProcessLock::No)                      \
     S(ftruncate, NeedsBigProcessLock::No)                  \
-    S(futex, NeedsBigProcessLock::Yes)                     \
+    S(futex, NeedsBigProcessLock::No)                      \
     S(futimens, NeedsBigProcessLock::No)                   \
     S(get_dir_entries, NeedsBigProcessLock::No)            \
     S(get_root_session_id, NeedsBigProcessLock::No)        \
@@ -113,6 +117,8 @@ enum class NeedsBigProcessLock {
     S(getuid, NeedsBigProcessLock::No)                     \
     S(inode_watcher_add_watch, NeedsBigProcessLock::No)    \
     S(inode_watcher_remove_watch, NeedsBigProcessLock::No) \
+    S(io_ring_enter, NeedsBigProcessLock::No)              \
+    S(io_ring_setup, NeedsBigProcessLock::No)              \
     S(ioctl, NeedsBigProcessLock::Yes)                     \
     S(join_thread, NeedsBigProcessLock::Yes)               \
     S(jail_create, NeedsBigProcessLock::No)                \
@@ -138,6 +144,7 @@ enum class NeedsBigProcessLock {
     S(pipe, NeedsBigProcessLock::No)                       \
     S(pledge, NeedsBigProcessLock::No)                     \
     S(poll, NeedsBigProcessLock::No)                       \
+    S(posix_fadvise, NeedsBigProcessLock::No)              \
     S(posix_fallocate, NeedsBigProcessLock::No)            \
     S(prctl, NeedsBigProcessLock::No)                      \
     S(profiling_disable, NeedsBigProcessLock::Yes)         \
@@ -158,6 +165,7 @@ enum class NeedsBigProcessLock {
     S(scheduler_get_parameters, NeedsBigProcessLock::No)   \
     S(scheduler_set_parameters, NeedsBigProcessLock::No)   \
     S(sendfd, NeedsBigProcessLock::No)                     \
+    S(sendfile, NeedsBigProcessLock::Yes)                  \
     S(sendmsg, NeedsBigProcessLock::Yes)                   \
     S(set_mmap_name, NeedsBigProcessLock::No)              \
     S(setegid, NeedsBigProcessLock::No)                    \
@@ -184,6 +192,7 @@ enum class NeedsBigProcessLock {
     S(sigtimedwait, NeedsBigProcessLock::No)               \
     S(socket, NeedsBigProcessLock::No)                     \
     S(socketpair, NeedsBigProcessLock::No)                 \
+    S(splice, NeedsBigProcessLock::Yes)                    \
     S(stat, NeedsBigProcessLock::No)                       \
     S(statvfs, NeedsBigProcessLock::No)                    \
     S(symlink, NeedsBigProcessLock::No)                    \
@@ -265,6 +274,23 @@ struct SC_poll_params {
     u32 const* sigmask;
 };
 
+struct SC_splice_params {
+    int fd_in;
+    off_t* off_in;
+    int fd_out;
+    off_t* off_out;
+    size_t length;
+    unsigned flags;
+};
+
+struct SC_epoll_pwait_params {
+    int epfd;
+    struct epoll_event* events;
+    int maxevents;
+    const struct timespec* timeout;
+    u32 const* sigmask;
+};
+
 struct SC_clock_nanosleep_params {
     int clock_id;
     int flags;
@@ -64,6 +64,7 @@ public:
     static bool is_smp_enabled();
     static void smp_enable();
     static u32 smp_wake_n_idle_processors(u32 wake_count);
+    static bool smp_wake_idle_processor(u32 cpu);
 
     static void flush_tlb_local(VirtualAddress vaddr, size_t page_count);
     static void flush_tlb(Memory::PageDirectory const*, VirtualAddress, size_t);
@@ -46,6 +46,7 @@
 #include <Kernel/KSyms.h>
 #include <Kernel/Library/Panic.h>
 #include <Kernel/Memory/MemoryManager.h>
+#include <Kernel/Memory/PageMerger.h>
 #include <Kernel/Net/NetworkTask.h>
 #include <Kernel/Net/NetworkingManagement.h>
 #include <Kernel/Prekernel/Prekernel.h>
@@ -393,6 +394,7 @@ void init_stage2(void*)
 
     SyncTask::spawn();
     FinalizerTask::spawn();
+    Memory::PageMerger::spawn();
 
     auto boot_profiling = kernel_command_line().is_boot_profiling_enabled();
 
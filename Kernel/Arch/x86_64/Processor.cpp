@@ -949,6 +949,14 @@ void ProcessorBase<T>::exit_trap(TrapFrame& trap)
 template<typename T>
 void ProcessorBase<T>::flush_tlb_local(VirtualAddress vaddr, size_t page_count)
 {
+    // Past a point, it's cheaper to throw away all of userspace's TLB entries than to invalidate them one by one.
+    // Kernel pages are global and survive a CR3 reload, so they always have to be invalidated individually.
+    static constexpr size_t flush_entire_tlb_threshold = 64;
+    if (page_count > flush_entire_tlb_threshold && Memory::is_user_address(vaddr)) {
+        flush_entire_tlb_local();
+        return;
+    }
+
     auto ptr = vaddr.as_ptr();
     while (page_count > 0) {
         // clang-format off
@@ -1066,6 +1074,20 @@ u32 ProcessorBase<T>::smp_wake_n_idle_processors(u32 wake_count)
     return did_wake_count;
 }
 
+template<typename T>
+bool ProcessorBase<T>::smp_wake_idle_processor(u32 cpu)
+{
+    VERIFY_INTERRUPTS_DISABLED();
+    if (!s_smp_enabled || cpu == Processor::current_id())
+        return false;
+
+    // Flip it to busy first, so that only one of us sends the IPI.
+    if (!(Processor::s_idle_cpu_mask.fetch_and(~(1u << cpu), AK::MemoryOrder::memory_order_acq_rel) & (1u << cpu)))
+        return false;
+    APIC::the().send_ipi(cpu);
+    return true;
+}
+
 template<typename T>
 UNMAP_AFTER_INIT void ProcessorBase<T>::smp_enable()
 {
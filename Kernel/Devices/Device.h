@@ -51,6 +51,10 @@ public:
     virtual bool is_openable_by_jailed_processes() const { return false; }
     void process_next_queued_request(Badge<AsyncDeviceRequest>, AsyncDeviceRequest const&);
 
+    // Devices that can have several requests in flight (e.g. with a hardware queue per CPU) start every
+    // request right away, instead of waiting for the previous one to complete.
+    virtual bool can_process_requests_concurrently() const { return false; }
+
     template<typename AsyncRequestType, typename... Args>
     ErrorOr<NonnullLockRefPtr<AsyncRequestType>> try_make_request(Args&&... args)
     {
@@ -58,7 +62,7 @@ public:
         SpinlockLocker lock(m_requests_lock);
         bool was_empty = m_requests.is_empty();
         TRY(m_requests.try_append(request));
-        if (was_empty)
+        if (was_empty || can_process_requests_concurrently())
             request->do_start(move(lock));
         return request;
     }
@@ -35,8 +35,11 @@ UNMAP_AFTER_INIT NVMeController::NVMeController(const PCI::DeviceIdentifier& dev
 
 UNMAP_AFTER_INIT ErrorOr<void> NVMeController::initialize(bool is_queue_polled)
 {
-    // Nr of queues = one queue per core
-    auto nr_of_queues = Processor::count();
+    // Ideally every core gets an IO queue of its own, but we can't have more queues than MSI-X vectors
+    // (one of which goes to the admin queue), and the controller might limit them further below.
+    u16 nr_of_queues = Processor::count();
+    if (device_identifier().is_msix_capable() && device_identifier().get_msix_table_size() > 1)
+        nr_of_queues = min<u16>(nr_of_queues, device_identifier().get_msix_table_size() - 1);
     auto queue_type = is_queue_polled ? QueueType::Polled : QueueType::IRQ;
 
     PCI::enable_memory_space(device_identifier());
@@ -63,10 +66,12 @@ UNMAP_AFTER_INIT ErrorOr<void> NVMeController::initialize(bool is_queue_polled)
     dbgln_if(NVME_DEBUG, "NVMe: IO queue depth is: {}", IO_QUEUE_SIZE);
 
     TRY(identify_and_init_controller());
-    // Create an IO queue per core
-    for (u32 cpuid = 0; cpuid < nr_of_queues; ++cpuid) {
+    nr_of_queues = TRY(negotiate_io_queue_count(nr_of_queues));
+    dbgln_if(NVME_DEBUG, "NVMe: Using {} IO queues for {} cores", nr_of_queues, Processor::count());
+    // Create an IO queue per core, cores beyond the number of queues share them
+    for (u32 queue_index = 0; queue_index < nr_of_queues; ++queue_index) {
         // qid is zero is used for admin queue
-        TRY(create_io_queue(cpuid + 1, queue_type));
+        TRY(create_io_queue(queue_index + 1, queue_type));
     }
     TRY(identify_and_init_namespaces());
     return {};
@@ -276,6 +281,22 @@ ErrorOr<void> NVMeController::identify_and_init_controller()
     return {};
 }
 
+UNMAP_AFTER_INIT ErrorOr<u16> NVMeController::negotiate_io_queue_count(u16 wanted_queue_count)
+{
+    NVMeSubmission sub {};
+    u32 allocated_queues = 0;
+    sub.op = OP_ADMIN_SET_FEATURES;
+    sub.generic.cdw10 = FEATURE_NUMBER_OF_QUEUES;
+    sub.generic.cdw11 = NUMBER_OF_QUEUES(wanted_queue_count, wanted_queue_count);
+    if (auto status = m_admin_queue->submit_sync_sqe(sub, &allocated_queues); status) {
+        dmesgln_pci(*this, "Failed to set the number of queues");
+        return EFAULT;
+    }
+
+    // The controller may give us fewer queues than we asked for, but also more, which we then don't use.
+    return min(wanted_queue_count, min(NSQA(allocated_queues), NCQA(allocated_queues)));
+}
+
 UNMAP_AFTER_INIT Tuple<u64, u8> NVMeController::get_ns_features(IdentifyNamespace& identify_data_struct)
 {
     auto flbas = identify_data_struct.flbas & FLBA_SIZE_MASK;
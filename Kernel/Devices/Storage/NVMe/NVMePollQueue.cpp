@@ -11,57 +11,52 @@
 
 namespace Kernel {
 
-ErrorOr<NonnullLockRefPtr<NVMePollQueue>> NVMePollQueue::try_create(NonnullOwnPtr<Memory::Region> rw_dma_region, NonnullRefPtr<Memory::PhysicalPage> rw_dma_page, u16 qid, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, OwnPtr<Memory::Region> sq_dma_region, Doorbell db_regs)
+ErrorOr<NonnullLockRefPtr<NVMePollQueue>> NVMePollQueue::try_create(NonnullOwnPtr<Memory::Region> rw_dma_region, Vector<NonnullRefPtr<Memory::PhysicalPage>> rw_dma_pages, u16 qid, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, OwnPtr<Memory::Region> sq_dma_region, Doorbell db_regs)
 {
-    return TRY(adopt_nonnull_lock_ref_or_enomem(new (nothrow) NVMePollQueue(move(rw_dma_region), rw_dma_page, qid, q_depth, move(cq_dma_region), move(sq_dma_region), move(db_regs))));
+    return TRY(adopt_nonnull_lock_ref_or_enomem(new (nothrow) NVMePollQueue(move(rw_dma_region), move(rw_dma_pages), qid, q_depth, move(cq_dma_region), move(sq_dma_region), move(db_regs))));
 }
 
-UNMAP_AFTER_INIT NVMePollQueue::NVMePollQueue(NonnullOwnPtr<Memory::Region> rw_dma_region, NonnullRefPtr<Memory::PhysicalPage> rw_dma_page, u16 qid, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, OwnPtr<Memory::Region> sq_dma_region, Doorbell db_regs)
-    : NVMeQueue(move(rw_dma_region), rw_dma_page, qid, q_depth, move(cq_dma_region), move(sq_dma_region), move(db_regs))
+UNMAP_AFTER_INIT NVMePollQueue::NVMePollQueue(NonnullOwnPtr<Memory::Region> rw_dma_region, Vector<NonnullRefPtr<Memory::PhysicalPage>> rw_dma_pages, u16 qid, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, OwnPtr<Memory::Region> sq_dma_region, Doorbell db_regs)
+    : NVMeQueue(move(rw_dma_region), move(rw_dma_pages), qid, q_depth, move(cq_dma_region), move(sq_dma_region), move(db_regs))
 {
+    m_completion_counts.try_resize(q_depth).release_value_but_fixme_should_propagate_errors();
 }
 
-void NVMePollQueue::submit_sqe(NVMeSubmission& sub)
+bool NVMePollQueue::has_completed(Span<NVMeSubmission const> submissions, Span<u32 const> completion_counts_before) const
 {
-    NVMeQueue::submit_sqe(sub);
-    SpinlockLocker lock_cq(m_cq_lock);
-    while (!process_cq()) {
-        microseconds_delay(1);
+    for (size_t i = 0; i < submissions.size(); ++i) {
+        if (m_completion_counts[submissions[i].cmdid] == completion_counts_before[i])
+            return false;
     }
+    return true;
 }
 
-void NVMePollQueue::complete_current_request(u16 cmdid, u16 status)
+void NVMePollQueue::submit_sqes(Span<NVMeSubmission> submissions)
 {
-    SpinlockLocker lock(m_request_lock);
-    auto& request_pdu = m_requests.get(cmdid).release_value();
-    auto current_request = request_pdu.request;
-    AsyncDeviceRequest::RequestResult req_result = AsyncDeviceRequest::Success;
-
-    ScopeGuard guard = [req_result, status, &request_pdu] {
-        if (request_pdu.request)
-            request_pdu.request->complete(req_result);
-        if (request_pdu.end_io_handler)
-            request_pdu.end_io_handler(status);
-        request_pdu.clear();
-    };
-
-    // There can be submission without any request associated with it such as with
-    // admin queue commands during init. If there is no request, we are done
-    if (!current_request)
-        return;
-
-    if (status) {
-        req_result = AsyncBlockDeviceRequest::Failure;
-        return;
+    // Other processors may be polling this queue at the same time and reap the completions of our commands, so
+    // rather than waiting for any completion, we wait until every one of our own commands has completed.
+    Vector<u32, 16> completion_counts_before;
+    {
+        SpinlockLocker lock_cq(m_cq_lock);
+        for (auto& submission : submissions)
+            completion_counts_before.append(m_completion_counts[submission.cmdid]);
     }
 
-    if (current_request->request_type() == AsyncBlockDeviceRequest::RequestType::Read) {
-        if (auto result = current_request->write_to_buffer(current_request->buffer(), m_rw_dma_region->vaddr().as_ptr(), current_request->buffer_size()); result.is_error()) {
-            req_result = AsyncBlockDeviceRequest::MemoryFault;
-            return;
+    NVMeQueue::submit_sqes(submissions);
+    for (;;) {
+        {
+            SpinlockLocker lock_cq(m_cq_lock);
+            process_cq();
+            if (has_completed(submissions, completion_counts_before))
+                return;
         }
+        microseconds_delay(1);
     }
+}
 
-    return;
+void NVMePollQueue::complete_current_request(u16 cmdid, u16 status, u32 command_specific)
+{
+    ++m_completion_counts[cmdid];
+    complete_command(cmdid, status, command_specific);
 }
 }
@@ -15,22 +15,22 @@ namespace Kernel {
 ErrorOr<NonnullLockRefPtr<NVMeQueue>> NVMeQueue::try_create(NVMeController& device, u16 qid, u8 irq, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, OwnPtr<Memory::Region> sq_dma_region, Doorbell db_regs, QueueType queue_type)
 {
     // Note: Allocate DMA region for RW operation. For now the requests don't exceed more than 4096 bytes (Storage device takes care of it)
-    RefPtr<Memory::PhysicalPage> rw_dma_page;
-    auto rw_dma_region = TRY(MM.allocate_dma_buffer_page("NVMe Queue Read/Write DMA"sv, Memory::Region::Access::ReadWrite, rw_dma_page));
-
-    if (rw_dma_page.is_null())
-        return ENOMEM;
+    // Every command identifier of an IO queue gets a page of its own, so that we can use the whole queue depth.
+    // The admin queue only transfers data into buffers of its own.
+    auto rw_dma_page_count = qid == 0 ? 1 : q_depth;
+    Vector<NonnullRefPtr<Memory::PhysicalPage>> rw_dma_pages;
+    auto rw_dma_region = TRY(MM.allocate_dma_buffer_pages(rw_dma_page_count * PAGE_SIZE, "NVMe Queue Read/Write DMA"sv, Memory::Region::Access::ReadWrite, rw_dma_pages));
 
     if (queue_type == QueueType::Polled) {
-        auto queue = NVMePollQueue::try_create(move(rw_dma_region), rw_dma_page.release_nonnull(), qid, q_depth, move(cq_dma_region), move(sq_dma_region), move(db_regs));
+        auto queue = NVMePollQueue::try_create(move(rw_dma_region), move(rw_dma_pages), qid, q_depth, move(cq_dma_region), move(sq_dma_region), move(db_regs));
         return queue;
     }
 
-    auto queue = NVMeInterruptQueue::try_create(device, move(rw_dma_region), rw_dma_page.release_nonnull(), qid, irq, q_depth, move(cq_dma_region), move(sq_dma_region), move(db_regs));
+    auto queue = NVMeInterruptQueue::try_create(device, move(rw_dma_region), move(rw_dma_pages), qid, irq, q_depth, move(cq_dma_region), move(sq_dma_region), move(db_regs));
     return queue;
 }
 
-UNMAP_AFTER_INIT NVMeQueue::NVMeQueue(NonnullOwnPtr<Memory::Region> rw_dma_region, Memory::PhysicalPage const& rw_dma_page, u16 qid, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, OwnPtr<Memory::Region> sq_dma_region, Doorbell db_regs)
+UNMAP_AFTER_INIT NVMeQueue::NVMeQueue(NonnullOwnPtr<Memory::Region> rw_dma_region, Vector<NonnullRefPtr<Memory::PhysicalPage>> rw_dma_pages, u16 qid, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, OwnPtr<Memory::Region> sq_dma_region, Doorbell db_regs)
     : m_rw_dma_region(move(rw_dma_region))
     , m_qid(qid)
     , m_admin_queue(qid == 0)
@@ -38,7 +38,7 @@ UNMAP_AFTER_INIT NVMeQueue::NVMeQueue(NonnullOwnPtr<Memory::Region> rw_dma_regio
     , m_cq_dma_region(move(cq_dma_region))
     , m_sq_dma_region(move(sq_dma_region))
     , m_db_regs(move(db_regs))
-    , m_rw_dma_page(rw_dma_page)
+    , m_rw_dma_pages(move(rw_dma_pages))
 
 {
     m_requests.try_ensure_capacity(q_depth).release_value_but_fixme_should_propagate_errors();
@@ -69,16 +69,18 @@ u32 NVMeQueue::process_cq()
     while (cqe_available()) {
         u16 status;
         u16 cmdid;
+        u32 command_specific;
         ++nr_of_processed_cqes;
         status = CQ_STATUS_FIELD(m_cqe_array[m_cq_head].status);
         cmdid = m_cqe_array[m_cq_head].command_id;
+        command_specific = m_cqe_array[m_cq_head].cmd_spec;
         dbgln_if(NVME_DEBUG, "NVMe: Completion with status {:x} and command identifier {}. CQ_HEAD: {}", status, cmdid, m_cq_head);
 
         if (!m_requests.contains(cmdid)) {
             dmesgln("Bogus cmd id: {}", cmdid);
             VERIFY_NOT_REACHED();
         }
-        complete_current_request(cmdid, status);
+        complete_current_request(cmdid, status, command_specific);
         update_cqe_head();
     }
     if (nr_of_processed_cqes) {
@@ -87,36 +89,52 @@ u32 NVMeQueue::process_cq()
     return nr_of_processed_cqes;
 }
 
-void NVMeQueue::submit_sqe(NVMeSubmission& sub)
+void NVMeQueue::submit_sqes(Span<NVMeSubmission> submissions)
 {
     SpinlockLocker lock(m_sq_lock);
 
-    memcpy(&m_sqe_array[m_sq_tail], &sub, sizeof(NVMeSubmission));
-    {
-        u32 temp_sq_tail = m_sq_tail + 1;
-        if (temp_sq_tail == m_qdepth)
-            m_sq_tail = 0;
-        else
-            m_sq_tail = temp_sq_tail;
+    for (auto& sub : submissions) {
+        memcpy(&m_sqe_array[m_sq_tail], &sub, sizeof(NVMeSubmission));
+        {
+            u32 temp_sq_tail = m_sq_tail + 1;
+            if (temp_sq_tail == m_qdepth)
+                m_sq_tail = 0;
+            else
+                m_sq_tail = temp_sq_tail;
+        }
+
+        dbgln_if(NVME_DEBUG, "NVMe: Submission with command identifier {}. SQ_TAIL: {}", sub.cmdid, m_sq_tail);
     }
 
-    dbgln_if(NVME_DEBUG, "NVMe: Submission with command identifier {}. SQ_TAIL: {}", sub.cmdid, m_sq_tail);
+    // Ring the doorbell only once for the whole batch, every MMIO write is a trip to the device.
     update_sq_doorbell();
 }
 
-u16 NVMeQueue::submit_sync_sqe(NVMeSubmission& sub)
+// Must be called with m_request_lock held.
+u16 NVMeQueue::allocate_command_id()
+{
+    // Commands can complete in any order, so the next identifier might still be taken.
+    for (u32 i = 0; i < m_qdepth; ++i) {
+        u16 cid = m_next_command_id;
+        m_next_command_id = (m_next_command_id + 1) % m_qdepth;
+        auto io = m_requests.get(cid);
+        if (!io.has_value() || !io->used)
+            return cid;
+    }
+    VERIFY_NOT_REACHED();
+}
+
+u16 NVMeQueue::submit_sync_sqe(NVMeSubmission& sub, u32* command_specific)
 {
-    // For now let's use sq tail as a unique command id.
     u16 cmd_status;
-    u16 cid = get_request_cid();
-    sub.cmdid = cid;
 
     {
         SpinlockLocker req_lock(m_request_lock);
-
-        if (m_requests.contains(sub.cmdid) && m_requests.get(sub.cmdid).release_value().used)
-            VERIFY_NOT_REACHED();
-        m_requests.set(sub.cmdid, { nullptr, true, [this, &cmd_status](u16 status) mutable { cmd_status = status; m_sync_wait_queue.wake_all(); } });
+        // A submission queue is full with one entry left empty.
+        VERIFY(m_commands_in_flight < m_qdepth - 1);
+        sub.cmdid = allocate_command_id();
+        m_requests.set(sub.cmdid, { {}, true, [this, &cmd_status, command_specific](u16 status, u32 result) mutable { cmd_status = status; if (command_specific) *command_specific = result; m_sync_wait_queue.wake_all(); } });
+        ++m_commands_in_flight;
     }
     submit_sqe(sub);
 
@@ -126,54 +144,160 @@ u16 NVMeQueue::submit_sync_sqe(NVMeSubmission& sub)
     return cmd_status;
 }
 
-void NVMeQueue::read(AsyncBlockDeviceRequest& request, u16 nsid, u64 index, u32 count)
+// Must be called with m_request_lock held.
+bool NVMeQueue::try_merge_into_pending_command(AsyncBlockDeviceRequest& request, u16 nsid)
+{
+    if (m_pending_commands.is_empty())
+        return false;
+    auto& command = m_pending_commands.last();
+    if (command.nsid != nsid || command.io.requests.size() == max_requests_per_command)
+        return false;
+
+    auto& last_request = *command.io.requests.last();
+    if (last_request.request_type() != request.request_type() || last_request.block_index() + last_request.block_count() != request.block_index())
+        return false;
+
+    size_t command_block_count = request.block_count();
+    for (auto& merged_request : command.io.requests)
+        command_block_count += merged_request->block_count();
+    if (command_block_count * request.block_size() > PAGE_SIZE)
+        return false;
+
+    command.io.requests.unchecked_append(request);
+    return true;
+}
+
+void NVMeQueue::submit_request(AsyncBlockDeviceRequest& request, u16 nsid)
 {
-    NVMeSubmission sub {};
-    sub.op = OP_NVME_READ;
-    sub.rw.nsid = nsid;
-    sub.rw.slba = AK::convert_between_host_and_little_endian(index);
-    // No. of lbas is 0 based
-    sub.rw.length = AK::convert_between_host_and_little_endian((count - 1) & 0xFFFF);
-    sub.rw.data_ptr.prp1 = reinterpret_cast<u64>(AK::convert_between_host_and_little_endian(m_rw_dma_page->paddr().as_ptr()));
-    sub.cmdid = get_request_cid();
+    {
+        SpinlockLocker lock(m_request_lock);
+        if (!try_merge_into_pending_command(request, nsid)) {
+            NVMePendingCommand command { nsid, {} };
+            command.io.requests.unchecked_append(request);
+            if (m_pending_commands.try_append(move(command)).is_error()) {
+                lock.unlock();
+                request.complete(AsyncDeviceRequest::OutOfMemory);
+                return;
+            }
+        }
+    }
+    submit_pending_commands();
+}
 
+bool NVMeQueue::copy_write_data_to_dma_page(u16 cmdid)
+{
+    Vector<NonnullRefPtr<AsyncBlockDeviceRequest>, max_requests_per_command> requests;
     {
-        SpinlockLocker req_lock(m_request_lock);
-        if (m_requests.contains(sub.cmdid) && m_requests.get(sub.cmdid).release_value().used)
-            VERIFY_NOT_REACHED();
-        m_requests.set(sub.cmdid, { request, true, nullptr });
+        SpinlockLocker lock(m_request_lock);
+        requests = m_requests.get(cmdid)->requests;
     }
 
-    full_memory_barrier();
-    submit_sqe(sub);
+    auto* dma_page = dma_page_of_command(cmdid);
+    size_t offset = 0;
+    for (auto& request : requests) {
+        if (request->read_from_buffer(request->buffer(), dma_page + offset, request->buffer_size()).is_error())
+            return false;
+        offset += request->block_count() * request->block_size();
+    }
+    return true;
 }
 
-void NVMeQueue::write(AsyncBlockDeviceRequest& request, u16 nsid, u64 index, u32 count)
+void NVMeQueue::submit_pending_commands()
 {
-    NVMeSubmission sub {};
+    static constexpr size_t max_submissions_per_doorbell = 16;
+
+    for (;;) {
+        Vector<NVMeSubmission, max_submissions_per_doorbell> submissions;
+        {
+            SpinlockLocker lock(m_request_lock);
+            while (!m_pending_commands.is_empty() && m_commands_in_flight < m_qdepth - 1 && submissions.size() < max_submissions_per_doorbell) {
+                auto command = m_pending_commands.take_first();
+                auto& first_request = *command.io.requests.first();
+                u32 block_count = 0;
+                for (auto& request : command.io.requests)
+                    block_count += request->block_count();
+
+                NVMeSubmission sub {};
+                sub.op = first_request.request_type() == AsyncBlockDeviceRequest::Read ? OP_NVME_READ : OP_NVME_WRITE;
+                sub.rw.nsid = command.nsid;
+                sub.rw.slba = AK::convert_between_host_and_little_endian(first_request.block_index());
+                // No. of lbas is 0 based
+                sub.rw.length = AK::convert_between_host_and_little_endian((block_count - 1) & 0xFFFF);
+                sub.cmdid = allocate_command_id();
+                sub.rw.data_ptr.prp1 = reinterpret_cast<u64>(AK::convert_between_host_and_little_endian(m_rw_dma_pages[sub.cmdid]->paddr().as_ptr()));
+
+                command.io.used = true;
+                m_requests.set(sub.cmdid, move(command.io));
+                ++m_commands_in_flight;
+                submissions.unchecked_append(sub);
+            }
+        }
+        if (submissions.is_empty())
+            return;
+
+        // Copying the data to be written can fault in pages of the requesting process, so we do it without holding any locks.
+        size_t ready_count = 0;
+        for (auto& sub : submissions) {
+            if (sub.op == OP_NVME_WRITE && !copy_write_data_to_dma_page(sub.cmdid)) {
+                fail_command(sub.cmdid, 0, AsyncDeviceRequest::MemoryFault);
+                continue;
+            }
+            submissions[ready_count++] = sub;
+        }
+        submissions.shrink(ready_count);
 
-    sub.op = OP_NVME_WRITE;
-    sub.rw.nsid = nsid;
-    sub.rw.slba = AK::convert_between_host_and_little_endian(index);
-    // No. of lbas is 0 based
-    sub.rw.length = AK::convert_between_host_and_little_endian((count - 1) & 0xFFFF);
-    sub.rw.data_ptr.prp1 = reinterpret_cast<u64>(AK::convert_between_host_and_little_endian(m_rw_dma_page->paddr().as_ptr()));
-    sub.cmdid = get_request_cid();
+        if (!submissions.is_empty()) {
+            full_memory_barrier();
+            submit_sqes(submissions.span());
+        }
+    }
+}
 
+void NVMeQueue::finish_command(u16 cmdid, u16 status, u32 command_specific, Optional<AsyncDeviceRequest::RequestResult> forced_result)
+{
+    Vector<NonnullRefPtr<AsyncBlockDeviceRequest>, max_requests_per_command> requests;
+    Function<void(u16, u32)> end_io_handler;
     {
-        SpinlockLocker req_lock(m_request_lock);
-        if (m_requests.contains(sub.cmdid) && m_requests.get(sub.cmdid).release_value().used)
-            VERIFY_NOT_REACHED();
-        m_requests.set(sub.cmdid, { request, true, nullptr });
+        SpinlockLocker lock(m_request_lock);
+        auto& request_pdu = m_requests.get(cmdid).release_value();
+        requests = request_pdu.requests;
+        end_io_handler = move(request_pdu.end_io_handler);
     }
 
-    if (auto result = request.read_from_buffer(request.buffer(), m_rw_dma_region->vaddr().as_ptr(), request.buffer_size()); result.is_error()) {
-        complete_current_request(sub.cmdid, AsyncDeviceRequest::MemoryFault);
-        return;
+    auto result = forced_result.value_or(status ? AsyncDeviceRequest::Failure : AsyncDeviceRequest::Success);
+    Vector<AsyncDeviceRequest::RequestResult, max_requests_per_command> request_results;
+    size_t offset = 0;
+    for (auto& request : requests) {
+        auto request_result = result;
+        if (!forced_result.has_value() && result == AsyncDeviceRequest::Success && request->request_type() == AsyncBlockDeviceRequest::Read) {
+            if (request->write_to_buffer(request->buffer(), dma_page_of_command(cmdid) + offset, request->buffer_size()).is_error())
+                request_result = AsyncDeviceRequest::MemoryFault;
+        }
+        offset += request->block_count() * request->block_size();
+        request_results.unchecked_append(request_result);
     }
 
-    full_memory_barrier();
-    submit_sqe(sub);
+    // The data has been copied out, so the command identifier (and its page) can be reused now.
+    {
+        SpinlockLocker lock(m_request_lock);
+        m_requests.get(cmdid)->clear();
+        --m_commands_in_flight;
+    }
+
+    if (end_io_handler)
+        end_io_handler(status, command_specific);
+    for (size_t i = 0; i < requests.size(); ++i)
+        requests[i]->complete(request_results[i]);
+}
+
+void NVMeQueue::complete_command(u16 cmdid, u16 status, u32 command_specific)
+{
+    finish_command(cmdid, status, command_specific, {});
+}
+
+void NVMeQueue::fail_command(u16 cmdid, u16 status, AsyncDeviceRequest::RequestResult result)
+{
+    finish_command(cmdid, status, 0, result);
 }
 
 UNMAP_AFTER_INIT NVMeQueue::~NVMeQueue() = default;
@@ -11,6 +11,7 @@
 #include <AK/OwnPtr.h>
 #include <AK/Types.h>
 #include <Kernel/Bus/PCI/Device.h>
+#include <Kernel/Devices/BlockDevice.h>
 #include <Kernel/Devices/Storage/NVMe/NVMeDefinitions.h>
 #include <Kernel/Interrupts/IRQHandler.h>
 #include <Kernel/Library/LockRefPtr.h>
@@ -37,18 +38,25 @@ enum class QueueType {
     IRQ
 };
 
-class AsyncBlockDeviceRequest;
+// Adjacent block requests that have to wait for a free submission queue slot are merged into one command,
+// as long as their data still fits into the page of the command.
+static constexpr size_t max_requests_per_command = PAGE_SIZE / 512;
 
 struct NVMeIO {
     void clear()
     {
         used = false;
-        request = nullptr;
+        requests.clear();
         end_io_handler = nullptr;
     }
-    RefPtr<AsyncBlockDeviceRequest> request;
+    Vector<NonnullRefPtr<AsyncBlockDeviceRequest>, max_requests_per_command> requests;
     bool used = false;
-    Function<void(u16 status)> end_io_handler;
+    Function<void(u16 status, u32 command_specific)> end_io_handler;
+};
+
+struct NVMePendingCommand {
+    u16 nsid { 0 };
+    NVMeIO io;
 };
 
 class NVMeController;
@@ -56,14 +64,18 @@ class NVMeQueue : public AtomicRefCounted<NVMeQueue> {
 public:
     static ErrorOr<NonnullLockRefPtr<NVMeQueue>> try_create(NVMeController& device, u16 qid, u8 irq, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, OwnPtr<Memory::Region> sq_dma_region, Doorbell db_regs, QueueType queue_type);
     bool is_admin_queue() { return m_admin_queue; }
-    u16 submit_sync_sqe(NVMeSubmission&);
-    void read(AsyncBlockDeviceRequest& request, u16 nsid, u64 index, u32 count);
-    void write(AsyncBlockDeviceRequest& request, u16 nsid, u64 index, u32 count);
-    virtual void submit_sqe(NVMeSubmission&);
+    u16 submit_sync_sqe(NVMeSubmission&, u32* command_specific = nullptr);
+    void submit_request(AsyncBlockDeviceRequest& request, u16 nsid);
+    void submit_sqe(NVMeSubmission& submission) { submit_sqes({ &submission, 1 }); }
+    virtual void submit_sqes(Span<NVMeSubmission>);
     virtual ~NVMeQueue();
 
 protected:
     u32 process_cq();
+    void submit_pending_commands();
+    void complete_command(u16 cmdid, u16 status, u32 command_specific);
+    // Completes the command without copying out any data, for when we can't get to a process context.
+    void fail_command(u16 cmdid, u16 status, AsyncDeviceRequest::RequestResult);
 
     // Updates the shadow buffer and returns if mmio is needed
     bool update_shadow_buf(u16 new_value, u32* dbbuf, u32* ei)
@@ -85,25 +97,17 @@ protected:
             m_db_regs.mmio_reg->sq_tail = m_sq_tail;
     }
 
-    NVMeQueue(NonnullOwnPtr<Memory::Region> rw_dma_region, Memory::PhysicalPage const& rw_dma_page, u16 qid, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, OwnPtr<Memory::Region> sq_dma_region, Doorbell db_regs);
-
-    [[nodiscard]] u32 get_request_cid()
-    {
-        u32 expected_tag = m_tag.load(AK::memory_order_acquire);
-
-        for (;;) {
-            u32 cid = expected_tag + 1;
-            if (cid == m_qdepth)
-                cid = 0;
-            if (m_tag.compare_exchange_strong(expected_tag, cid, AK::memory_order_acquire))
-                return cid;
-        }
-    }
+    NVMeQueue(NonnullOwnPtr<Memory::Region> rw_dma_region, Vector<NonnullRefPtr<Memory::PhysicalPage>> rw_dma_pages, u16 qid, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, OwnPtr<Memory::Region> sq_dma_region, Doorbell db_regs);
 
 private:
     bool cqe_available();
     void update_cqe_head();
-    virtual void complete_current_request(u16 cmdid, u16 status) = 0;
+    virtual void complete_current_request(u16 cmdid, u16 status, u32 command_specific) = 0;
+    u16 allocate_command_id();
+    bool try_merge_into_pending_command(AsyncBlockDeviceRequest&, u16 nsid);
+    bool copy_write_data_to_dma_page(u16 cmdid);
+    void finish_command(u16 cmdid, u16 status, u32 command_specific, Optional<AsyncDeviceRequest::RequestResult> forced_result);
+    u8* dma_page_of_command(u16 cmdid) { return m_rw_dma_region->vaddr().offset(cmdid * PAGE_SIZE).as_ptr(); }
     void update_cq_doorbell()
     {
         full_memory_barrier();
@@ -125,7 +129,10 @@ private:
     u16 m_cq_head {};
     bool m_admin_queue { false };
     u32 m_qdepth {};
-    Atomic<u32> m_tag { 0 }; // used for the cid in a submission queue entry
+    // NOTE: These are protected by m_request_lock.
+    Vector<NVMePendingCommand> m_pending_commands;
+    u32 m_commands_in_flight { 0 };
+    u16 m_next_command_id { 0 };
     Spinlock<LockRank::Interrupts> m_sq_lock {};
     OwnPtr<Memory::Region> m_cq_dma_region;
     Span<NVMeSubmission> m_sqe_array;
@@ -133,6 +140,7 @@ private:
     Span<NVMeCompletion> m_cqe_array;
     WaitQueue m_sync_wait_queue;
     Doorbell m_db_regs;
-    NonnullRefPtr<Memory::PhysicalPage const> const m_rw_dma_page;
+    // One page per command identifier, so every command can have a transfer in flight.
+    Vector<NonnullRefPtr<Memory::PhysicalPage>> const m_rw_dma_pages;
 };
 }
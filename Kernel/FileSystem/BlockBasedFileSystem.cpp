@@ -5,7 +5,9 @@
  */
 
 #include <AK/IntrusiveList.h>
+#include <AK/QuickSort.h>
 #include <Kernel/Debug.h>
+#include <Kernel/Devices/BlockDevice.h>
 #include <Kernel/FileSystem/BlockBasedFileSystem.h>
 #include <Kernel/Tasks/Process.h>
 
@@ -16,40 +18,62 @@ struct CacheEntry {
     BlockBasedFileSystem::BlockIndex block_index { 0 };
     u8* data { nullptr };
     bool has_data { false };
+    bool is_dirty { false };
+};
+
+// The cache grows a chunk at a time as blocks are read, and gives chunks back when memory gets tight.
+static constexpr size_t cache_chunk_size = 64 * KiB;
+
+// The block caches of all file systems together may use up to this fraction of physical memory.
+static constexpr size_t cache_memory_budget_divisor = 8;
+static constexpr size_t minimum_cache_memory_budget = 4 * MiB;
+
+static Atomic<size_t> s_total_cache_size { 0 };
+
+static size_t cache_memory_budget()
+{
+    auto physical_memory_size = MM.get_system_memory_info().physical_pages * PAGE_SIZE;
+    return max(physical_memory_size / cache_memory_budget_divisor, minimum_cache_memory_budget);
+}
+
+struct CacheChunk {
+    NonnullOwnPtr<KBuffer> block_data;
+    FixedArray<CacheEntry> entries;
 };
 
 class DiskCache {
 public:
-    static constexpr size_t EntryCount = 10000;
-    explicit DiskCache(BlockBasedFileSystem& fs, NonnullOwnPtr<KBuffer> cached_block_data, NonnullOwnPtr<KBuffer> entries_buffer)
+    explicit DiskCache(BlockBasedFileSystem& fs, NonnullOwnPtr<KBuffer> write_back_buffer)
         : m_fs(fs)
-        , m_cached_block_data(move(cached_block_data))
-        , m_entries(move(entries_buffer))
+        , m_blocks_per_chunk(max(cache_chunk_size / fs.logical_block_size(), 1u))
+        , m_write_back_buffer(move(write_back_buffer))
     {
-        for (size_t i = 0; i < EntryCount; ++i) {
-            entries()[i].data = m_cached_block_data->data() + i * m_fs->logical_block_size();
-            m_clean_list.append(entries()[i]);
-        }
     }
 
-    ~DiskCache() = default;
-
-    bool is_dirty() const { return !m_dirty_list.is_empty(); }
-    bool entry_is_dirty(CacheEntry const& entry) const { return m_dirty_list.contains(entry); }
+    ~DiskCache()
+    {
+        s_total_cache_size.fetch_sub(m_chunks.size() * chunk_size(), AK::memory_order_relaxed);
+    }
 
-    void mark_all_clean()
+    ErrorOr<void> initialize()
     {
-        while (auto* entry = m_dirty_list.first())
-            m_clean_list.prepend(*entry);
+        // Always keep one chunk around, so there's something to work with even under memory pressure.
+        TRY(try_add_chunk());
+        return {};
     }
 
+    bool is_dirty() const { return !m_dirty_list.is_empty(); }
+    bool entry_is_dirty(CacheEntry const& entry) const { return entry.is_dirty; }
+
     void mark_dirty(CacheEntry& entry)
     {
+        entry.is_dirty = true;
         m_dirty_list.prepend(entry);
     }
 
     void mark_clean(CacheEntry& entry)
     {
+        entry.is_dirty = false;
         m_clean_list.prepend(entry);
     }
 
@@ -72,20 +96,21 @@ public:
         if (auto* entry = get(block_index))
             return entry;
 
-        if (m_clean_list.is_empty()) {
-            // Not a single clean entry! Flush writes and try again.
-            // NOTE: We want to make sure we only call FileBackedFileSystem flush here,
-            //       not some FileBackedFileSystem subclass flush!
-            m_fs->flush_writes_impl();
-            return ensure(block_index);
-        }
+        if (m_free_list.is_empty() && !try_grow()) {
+            if (m_clean_list.is_empty()) {
+                // Not a single clean entry! Write back the oldest batch of dirty blocks and try again.
+                write_back_oldest_dirty_entries(m_blocks_per_chunk);
+                VERIFY(!m_clean_list.is_empty());
+            }
 
-        VERIFY(m_clean_list.last());
-        auto& new_entry = *m_clean_list.last();
-        m_clean_list.prepend(new_entry);
+            auto& evicted_entry = *m_clean_list.last();
+            m_hash.remove(evicted_entry.block_index);
+            m_free_list.append(evicted_entry);
+        }
 
-        m_hash.remove(new_entry.block_index);
+        auto& new_entry = *m_free_list.first();
         TRY(m_hash.try_set(block_index, &new_entry));
+        m_clean_list.prepend(new_entry);
 
         new_entry.block_index = block_index;
         new_entry.has_data = false;
@@ -93,23 +118,176 @@ public:
         return &new_entry;
     }
 
-    CacheEntry const* entries() const { return (CacheEntry const*)m_entries->data(); }
-    CacheEntry* entries() { return (CacheEntry*)m_entries->data(); }
+    size_t write_back_all_dirty_entries()
+    {
+        return write_back_oldest_dirty_entries(NumericLimits<size_t>::max());
+    }
+
+    // Gives up to `chunk_count` chunks back to the system, writing back any dirty blocks they hold first.
+    size_t shrink(size_t chunk_count)
+    {
+        size_t released_chunk_count = 0;
+        while (released_chunk_count < chunk_count && m_chunks.size() > 1) {
+            auto& chunk = *m_chunks.last();
+            for (auto& entry : chunk.entries) {
+                CacheEntry* entry_pointer = &entry;
+                if (entry.is_dirty)
+                    write_back_entries(Span<CacheEntry*> { &entry_pointer, 1 });
+                if (auto it = m_hash.find(entry.block_index); it != m_hash.end() && it->value == &entry)
+                    m_hash.remove(it);
+                entry.list_node.remove();
+            }
+            (void)m_chunks.take_last();
+            s_total_cache_size.fetch_sub(chunk_size(), AK::memory_order_relaxed);
+            ++released_chunk_count;
+        }
+        return released_chunk_count;
+    }
+
+    size_t chunk_count() const { return m_chunks.size(); }
+
+    // Finds the first run of consecutive blocks in `block_indices` that aren't cached yet, and returns where it starts.
+    // The run is empty if all of the blocks are cached already.
+    size_t find_uncached_run(ReadonlySpan<BlockBasedFileSystem::BlockIndex> block_indices, size_t max_run_length, size_t& run_length) const
+    {
+        size_t first = 0;
+        while (first < block_indices.size() && m_hash.contains(block_indices[first]))
+            ++first;
+        run_length = 0;
+        if (first == block_indices.size())
+            return first;
+
+        run_length = 1;
+        while (first + run_length < block_indices.size() && run_length < max_run_length
+            && block_indices[first + run_length].value() == block_indices[first].value() + run_length
+            && !m_hash.contains(block_indices[first + run_length]))
+            ++run_length;
+        return first;
+    }
+
+    // Puts blocks that were read ahead from the disk into the cache, unless someone has cached them since.
+    ErrorOr<void> add_read_ahead_blocks(ReadonlySpan<BlockBasedFileSystem::BlockIndex> block_indices, u8 const* data) const
+    {
+        auto block_size = m_fs->logical_block_size();
+        for (size_t i = 0; i < block_indices.size(); ++i) {
+            if (m_hash.contains(block_indices[i]))
+                continue;
+            // Read-ahead is speculative, so it's not worth writing back dirty blocks to make room for it.
+            if (m_free_list.is_empty() && m_clean_list.is_empty() && !try_grow())
+                break;
+            auto* entry = TRY(ensure(block_indices[i]));
+            VERIFY(!entry->has_data);
+            memcpy(entry->data, data + i * block_size, block_size);
+            entry->has_data = true;
+        }
+        return {};
+    }
 
-    template<typename Callback>
-    void for_each_dirty_entry(Callback callback)
+    // Forgets the given blocks, unless they still have to be written back.
+    void drop_clean_blocks(ReadonlySpan<BlockBasedFileSystem::BlockIndex> block_indices) const
     {
-        for (auto& entry : m_dirty_list)
-            callback(entry);
+        for (auto block_index : block_indices) {
+            auto it = m_hash.find(block_index);
+            if (it == m_hash.end() || it->value->is_dirty)
+                continue;
+            auto& entry = *it->value;
+            m_hash.remove(it);
+            m_free_list.append(entry);
+        }
     }
 
 private:
+    size_t chunk_size() const { return m_blocks_per_chunk * m_fs->logical_block_size(); }
+
+    ErrorOr<void> try_add_chunk() const
+    {
+        auto block_data = TRY(KBuffer::try_create_with_size("BlockBasedFS: Cache blocks"sv, chunk_size()));
+        auto entries = TRY(FixedArray<CacheEntry>::create(m_blocks_per_chunk));
+        auto chunk = TRY(adopt_nonnull_own_or_enomem(new (nothrow) CacheChunk { move(block_data), move(entries) }));
+        TRY(m_chunks.try_append(move(chunk)));
+
+        auto& new_chunk = *m_chunks.last();
+        for (size_t i = 0; i < m_blocks_per_chunk; ++i) {
+            new_chunk.entries[i].data = new_chunk.block_data->data() + i * m_fs->logical_block_size();
+            m_free_list.append(new_chunk.entries[i]);
+        }
+        s_total_cache_size.fetch_add(chunk_size(), AK::memory_order_relaxed);
+        return {};
+    }
+
+    bool try_grow() const
+    {
+        if (s_total_cache_size.load(AK::memory_order_relaxed) + chunk_size() > cache_memory_budget())
+            return false;
+        if (MM.is_under_memory_pressure())
+            return false;
+        return !try_add_chunk().is_error();
+    }
+
+    size_t write_back_oldest_dirty_entries(size_t max_count) const
+    {
+        size_t count = 0;
+        while (count < max_count && !m_dirty_list.is_empty()) {
+            // If we can't allocate room for more entries, write back what we have and go for another round.
+            Vector<CacheEntry*, 64> entries;
+            for (auto it = m_dirty_list.rbegin(); it != m_dirty_list.rend() && count + entries.size() < max_count; ++it) {
+                if (entries.try_append(&*it).is_error())
+                    break;
+            }
+            write_back_entries(entries);
+            count += entries.size();
+        }
+        return count;
+    }
+
+    // Writes the given entries to disk in block order, merging runs of consecutive blocks into a single write.
+    void write_back_entries(Span<CacheEntry*> entries) const
+    {
+        auto block_size = m_fs->logical_block_size();
+        quick_sort(entries, [](auto* a, auto* b) { return a->block_index < b->block_index; });
+
+        auto max_run_length = m_write_back_buffer->size() / block_size;
+        for (size_t i = 0; i < entries.size();) {
+            size_t run_length = 1;
+            while (i + run_length < entries.size() && run_length < max_run_length
+                && entries[i + run_length]->block_index.value() == entries[i]->block_index.value() + run_length)
+                ++run_length;
+
+            u8* data = entries[i]->data;
+            if (run_length > 1) {
+                for (size_t j = 0; j < run_length; ++j)
+                    memcpy(m_write_back_buffer->data() + j * block_size, entries[i + j]->data, block_size);
+                data = m_write_back_buffer->data();
+            }
+
+            // NOTE: The device may write less than we asked for in one go, so keep going until the whole run is written.
+            auto base_offset = entries[i]->block_index.value() * block_size;
+            auto data_buffer = UserOrKernelBuffer::for_kernel_buffer(data);
+            size_t run_size = run_length * block_size;
+            for (size_t nwritten = 0; nwritten < run_size;) {
+                auto result = m_fs->file_description().write(base_offset + nwritten, data_buffer.offset(nwritten), run_size - nwritten);
+                if (result.is_error() || result.value() == 0)
+                    break;
+                nwritten += result.value();
+            }
+
+            for (size_t j = 0; j < run_length; ++j) {
+                auto& entry = *entries[i + j];
+                entry.is_dirty = false;
+                m_clean_list.prepend(entry);
+            }
+            i += run_length;
+        }
+    }
+
     mutable NonnullRefPtr<BlockBasedFileSystem> m_fs;
-    NonnullOwnPtr<KBuffer> m_cached_block_data;
+    size_t const m_blocks_per_chunk;
+    NonnullOwnPtr<KBuffer> m_write_back_buffer;
 
-    // NOTE: m_entries must be declared before m_dirty_list and m_clean_list because their entries are allocated from it.
-    // We need to ensure that the destructors of m_dirty_list and m_clean_list are called before m_entries is destroyed.
-    NonnullOwnPtr<KBuffer> m_entries;
+    // NOTE: m_chunks must be declared before the lists because their entries are allocated from it.
+    // We need to ensure that the destructors of the lists are called before m_chunks is destroyed.
+    mutable Vector<NonnullOwnPtr<CacheChunk>> m_chunks;
+    mutable IntrusiveList<&CacheEntry::list_node> m_free_list;
     mutable IntrusiveList<&CacheEntry::list_node> m_dirty_list;
     mutable IntrusiveList<&CacheEntry::list_node> m_clean_list;
     mutable HashMap<BlockBasedFileSystem::BlockIndex, CacheEntry*> m_hash;
@@ -136,13 +314,17 @@ ErrorOr<void> BlockBasedFileSystem::initialize_while_locked()
     VERIFY(m_lock.is_locked());
     VERIFY(!is_initialized_while_locked());
     VERIFY(logical_block_size() != 0);
-    auto cached_block_data = TRY(KBuffer::try_create_with_size("BlockBasedFS: Cache blocks"sv, DiskCache::EntryCount * logical_block_size()));
-    auto entries_data = TRY(KBuffer::try_create_with_size("BlockBasedFS: Cache entries"sv, DiskCache::EntryCount * sizeof(CacheEntry)));
-    auto disk_cache = TRY(adopt_nonnull_own_or_enomem(new (nothrow) DiskCache(*this, move(cached_block_data), move(entries_data))));
+    auto write_back_buffer = TRY(KBuffer::try_create_with_size("BlockBasedFS: Cache write-back buffer"sv, max(cache_chunk_size, logical_block_size())));
+    auto read_ahead_buffer = TRY(KBuffer::try_create_with_size("BlockBasedFS: Cache read-ahead buffer"sv, max(cache_chunk_size, logical_block_size())));
+    auto disk_cache = TRY(adopt_nonnull_own_or_enomem(new (nothrow) DiskCache(*this, move(write_back_buffer))));
+    TRY(disk_cache->initialize());
 
     m_cache.with_exclusive([&](auto& cache) {
         cache = move(disk_cache);
     });
+    m_read_ahead_buffer.with_exclusive([&](auto& buffer) {
+        buffer = move(read_ahead_buffer);
+    });
     return {};
 }
 
@@ -272,6 +454,87 @@ ErrorOr<void> BlockBasedFileSystem::read_blocks(BlockIndex index, unsigned count
     return {};
 }
 
+ErrorOr<void> BlockBasedFileSystem::read_from_device(u64 offset, size_t size, u8* data)
+{
+    if (file().is_block_device()) {
+        auto& device = static_cast<BlockDevice&>(file());
+        if (offset % device.block_size() == 0 && size % device.block_size() == 0) {
+            // NOTE: Storage drivers can't transfer more than a page per request, so split the read up into as few requests
+            //       as that allows, and queue all of them before waiting for any, so the device sees the whole read at once.
+            auto blocks_per_request = max(PAGE_SIZE / device.block_size(), 1ul);
+            Vector<NonnullLockRefPtr<AsyncBlockDeviceRequest>, 16> requests;
+            for (size_t block = 0; block < size / device.block_size(); block += blocks_per_request) {
+                auto block_count = min(blocks_per_request, size / device.block_size() - block);
+                auto buffer = UserOrKernelBuffer::for_kernel_buffer(data + block * device.block_size());
+                auto request = TRY(device.try_make_request<AsyncBlockDeviceRequest>(AsyncBlockDeviceRequest::Read, (offset >> device.block_size_log()) + block, block_count, buffer, block_count * device.block_size()));
+                TRY(requests.try_append(move(request)));
+            }
+
+            bool failed = false;
+            for (auto& request : requests) {
+                auto result = request->wait();
+                if (result.wait_result().was_interrupted() || result.request_result() != AsyncDeviceRequest::Success)
+                    failed = true;
+            }
+            if (failed)
+                return EIO;
+            return {};
+        }
+    }
+
+    // NOTE: The file may read less than we asked for in one go, so keep going until all of it is read.
+    for (size_t nread = 0; nread < size;) {
+        auto buffer = UserOrKernelBuffer::for_kernel_buffer(data + nread);
+        auto result = TRY(file_description().read(buffer, offset + nread, size - nread));
+        if (result == 0)
+            return EIO;
+        nread += result;
+    }
+    return {};
+}
+
+void BlockBasedFileSystem::read_ahead_blocks(ReadonlySpan<BlockIndex> block_indices)
+{
+    // NOTE: The cache is only locked to look for blocks that need reading and to add them once they've been read,
+    //       so anyone reading from the cache in the meantime doesn't have to wait for the disk.
+    auto result = m_read_ahead_buffer.with_exclusive([&](auto& buffer) -> ErrorOr<void> {
+        if (!buffer)
+            return {};
+        auto max_run_length = buffer->size() / logical_block_size();
+        while (!block_indices.is_empty()) {
+            size_t run_length = 0;
+            auto first = m_cache.with_shared([&](auto const& cache) -> size_t {
+                if (!cache)
+                    return block_indices.size();
+                return cache->find_uncached_run(block_indices, max_run_length, run_length);
+            });
+            if (run_length == 0)
+                return {};
+
+            auto run = block_indices.slice(first, run_length);
+            TRY(read_from_device(run.first().value() * logical_block_size(), run_length * logical_block_size(), buffer->data()));
+
+            TRY(m_cache.with_exclusive([&](auto& cache) -> ErrorOr<void> {
+                if (!cache)
+                    return {};
+                return cache->add_read_ahead_blocks(run, buffer->data());
+            }));
+            block_indices = block_indices.slice(first + run_length);
+        }
+        return {};
+    });
+    if (result.is_error())
+        dbgln_if(BBFS_DEBUG, "BlockBasedFileSystem::read_ahead_blocks: Read-ahead failed: {}", result.error());
+}
+
+void BlockBasedFileSystem::drop_cached_blocks(ReadonlySpan<BlockIndex> block_indices)
+{
+    m_cache.with_exclusive([&](auto& cache) {
+        if (cache)
+            cache->drop_clean_blocks(block_indices);
+    });
+}
+
 void BlockBasedFileSystem::flush_specific_block_if_needed(BlockIndex index)
 {
     m_cache.with_exclusive([&](auto& cache) {
@@ -290,17 +553,10 @@ void BlockBasedFileSystem::flush_specific_block_if_needed(BlockIndex index)
 
 void BlockBasedFileSystem::flush_writes_impl()
 {
-    size_t count = 0;
     m_cache.with_exclusive([&](auto& cache) {
         if (!cache->is_dirty())
             return;
-        cache->for_each_dirty_entry([&](CacheEntry& entry) {
-            auto base_offset = entry.block_index.value() * logical_block_size();
-            auto entry_data_buffer = UserOrKernelBuffer::for_kernel_buffer(entry.data);
-            [[maybe_unused]] auto rc = file_description().write(base_offset, entry_data_buffer, logical_block_size());
-            ++count;
-        });
-        cache->mark_all_clean();
+        auto count = cache->write_back_all_dirty_entries();
         dbgln("{}: Flushed {} blocks to disk", class_name(), count);
     });
 }
@@ -311,4 +567,16 @@ ErrorOr<void> BlockBasedFileSystem::flush_writes()
     return {};
 }
 
+void BlockBasedFileSystem::release_cached_memory()
+{
+    m_cache.with_exclusive([&](auto& cache) {
+        if (!cache)
+            return;
+        // Give back half of what we have each time we're asked, so a cache that is in active use shrinks gradually.
+        auto chunk_count = cache->chunk_count();
+        auto released_chunk_count = cache->shrink(chunk_count / 2);
+        dbgln_if(BBFS_DEBUG, "{}: Released {} of {} cache chunks under memory pressure", class_name(), released_chunk_count, chunk_count);
+    });
+}
+
 }
@@ -22,6 +22,8 @@ public:
     virtual ErrorOr<void> flush_writes() override;
     void flush_writes_impl();
 
+    virtual void release_cached_memory() override;
+
 protected:
     explicit BlockBasedFileSystem(OpenFileDescription&);
 
@@ -30,6 +32,12 @@ protected:
     ErrorOr<void> read_block(BlockIndex, UserOrKernelBuffer*, size_t count, u64 offset = 0, bool allow_cache = true) const;
     ErrorOr<void> read_blocks(BlockIndex, unsigned count, UserOrKernelBuffer&, bool allow_cache = true) const;
 
+    // Brings the given blocks into the cache, reading runs of consecutive blocks that aren't cached yet with a single request.
+    void read_ahead_blocks(ReadonlySpan<BlockIndex>);
+
+    // Drops the given blocks from the cache, except for those that haven't been written back yet.
+    void drop_cached_blocks(ReadonlySpan<BlockIndex>);
+
     ErrorOr<void> raw_read(BlockIndex, UserOrKernelBuffer&);
     ErrorOr<void> raw_write(BlockIndex, UserOrKernelBuffer const&);
 
@@ -45,8 +53,10 @@ protected:
 
 private:
     void flush_specific_block_if_needed(BlockIndex index);
+    ErrorOr<void> read_from_device(u64 offset, size_t size, u8* data);
 
     mutable MutexProtected<OwnPtr<DiskCache>> m_cache;
+    MutexProtected<OwnPtr<KBuffer>> m_read_ahead_buffer;
 };
 
 }
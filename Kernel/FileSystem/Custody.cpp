@@ -14,6 +14,8 @@
 
 namespace Kernel {
 
+DEFINE_SLAB_CACHE(Custody);
+
 static Singleton<SpinlockProtected<Custody::AllCustodiesList, LockRank::None>> s_all_instances;
 
 SpinlockProtected<Custody::AllCustodiesList, LockRank::None>& Custody::all_instances()
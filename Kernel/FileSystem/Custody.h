@@ -17,6 +17,8 @@
 namespace Kernel {
 
 class Custody final : public ListedRefCounted<Custody, LockType::Spinlock> {
+    MAKE_SLAB_CACHE_ALLOCATED(Custody);
+
 public:
     static ErrorOr<NonnullRefPtr<Custody>> try_create(Custody* parent, StringView name, Inode&, int mount_flags);
 
@@ -0,0 +1,224 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Singleton.h>
+#include <Kernel/FileSystem/DirectoryEntryCache.h>
+#include <Kernel/FileSystem/Inode.h>
+
+namespace Kernel {
+
+static constexpr size_t maximum_entry_count = 8192;
+
+static Singleton<DirectoryEntryCache> s_the;
+
+DirectoryEntryCache& DirectoryEntryCache::the()
+{
+    return *s_the;
+}
+
+ErrorOr<NonnullRefPtr<Inode>> DirectoryEntryCache::lookup(Inode& directory, StringView name)
+{
+    if (!directory.fs().supports_watchers())
+        return directory.lookup(name);
+
+    enum class CachedResult {
+        NotCached,
+        Found,
+        DoesNotExist,
+    };
+
+    u64 generation = 0;
+    RefPtr<Inode> cached_child;
+    auto result = m_state.with([&](auto& state) {
+        generation = state.generation;
+        auto* entry = find_entry(state, directory.identifier(), name);
+        if (!entry)
+            return CachedResult::NotCached;
+
+        state.lru_list.remove(*entry);
+        state.lru_list.append(*entry);
+        if (entry->is_negative)
+            return CachedResult::DoesNotExist;
+        // NOTE: We don't keep the inode alive, as that would keep unlinked files and unmounted file systems around.
+        //       If it went away in the meantime, the file system has to look it up again.
+        if (auto child = entry->child.strong_ref()) {
+            cached_child = *child;
+            return CachedResult::Found;
+        }
+        return CachedResult::NotCached;
+    });
+
+    switch (result) {
+    case CachedResult::Found:
+        m_hits++;
+        return cached_child.release_nonnull();
+    case CachedResult::DoesNotExist:
+        m_negative_hits++;
+        return ENOENT;
+    case CachedResult::NotCached:
+        break;
+    }
+
+    m_misses++;
+    auto child_or_error = directory.lookup(name);
+    if (!child_or_error.is_error())
+        insert(directory, name, child_or_error.value(), generation);
+    else if (child_or_error.error().code() == ENOENT)
+        insert(directory, name, nullptr, generation);
+    return child_or_error;
+}
+
+DirectoryEntryCache::NameList& DirectoryEntryCache::name_bucket(State& state, InodeIdentifier directory, StringView name)
+{
+    return state.entries_by_name[pair_int_hash(Traits<InodeIdentifier>::hash(directory), name.hash()) % bucket_count];
+}
+
+DirectoryEntryCache::DirectoryList& DirectoryEntryCache::directory_bucket(State& state, InodeIdentifier directory)
+{
+    return state.entries_by_directory[Traits<InodeIdentifier>::hash(directory) % bucket_count];
+}
+
+DirectoryEntryCache::Entry* DirectoryEntryCache::find_entry(State& state, InodeIdentifier directory, StringView name)
+{
+    for (auto& entry : name_bucket(state, directory, name)) {
+        if (entry.directory == directory && entry.name->view() == name)
+            return &entry;
+    }
+    return nullptr;
+}
+
+void DirectoryEntryCache::insert(Inode& directory, StringView name, RefPtr<Inode> child, u64 generation)
+{
+    // Failing to allocate here only means that the next lookup will have to ask the file system again.
+    auto name_or_error = KString::try_create(name);
+    if (name_or_error.is_error())
+        return;
+    LockWeakPtr<Inode> weak_child;
+    if (child) {
+        auto weak_child_or_error = child->try_make_weak_ptr<Inode>();
+        if (weak_child_or_error.is_error())
+            return;
+        weak_child = weak_child_or_error.release_value();
+    }
+    auto* new_entry = new (nothrow) Entry {
+        .directory = directory.identifier(),
+        .name = name_or_error.release_value(),
+        .child = move(weak_child),
+        .is_negative = !child,
+        .name_list_node = {},
+        .directory_list_node = {},
+        .lru_list_node = {},
+    };
+    if (!new_entry)
+        return;
+
+    LRUList removed_entries;
+    m_state.with([&](auto& state) {
+        if (state.generation != generation) {
+            removed_entries.append(*new_entry);
+            return;
+        }
+
+        if (auto* entry = find_entry(state, new_entry->directory, new_entry->name->view()))
+            remove_entry(state, *entry, removed_entries);
+
+        name_bucket(state, new_entry->directory, new_entry->name->view()).append(*new_entry);
+        directory_bucket(state, new_entry->directory).append(*new_entry);
+        state.lru_list.append(*new_entry);
+        state.entry_count++;
+        if (new_entry->is_negative)
+            state.negative_entry_count++;
+
+        while (state.entry_count > maximum_entry_count) {
+            remove_entry(state, *state.lru_list.first(), removed_entries);
+            m_evictions++;
+        }
+    });
+    free_entries(removed_entries);
+}
+
+void DirectoryEntryCache::remove_entry(State& state, Entry& entry, LRUList& removed_entries)
+{
+    entry.name_list_node.remove();
+    entry.directory_list_node.remove();
+    state.lru_list.remove(entry);
+    state.entry_count--;
+    if (entry.is_negative)
+        state.negative_entry_count--;
+    removed_entries.append(entry);
+}
+
+void DirectoryEntryCache::free_entries(LRUList& entries)
+{
+    while (auto* entry = entries.take_first())
+        delete entry;
+}
+
+void DirectoryEntryCache::invalidate(InodeIdentifier directory, StringView name)
+{
+    LRUList removed_entries;
+    m_state.with([&](auto& state) {
+        state.generation++;
+        if (auto* entry = find_entry(state, directory, name)) {
+            remove_entry(state, *entry, removed_entries);
+            m_invalidations++;
+        }
+    });
+    free_entries(removed_entries);
+}
+
+void DirectoryEntryCache::invalidate_directory(InodeIdentifier directory)
+{
+    LRUList removed_entries;
+    m_state.with([&](auto& state) {
+        state.generation++;
+        auto& bucket = directory_bucket(state, directory);
+        for (auto it = bucket.begin(); it != bucket.end();) {
+            auto& entry = *it;
+            ++it;
+            if (entry.directory != directory)
+                continue;
+            remove_entry(state, entry, removed_entries);
+            m_invalidations++;
+        }
+    });
+    free_entries(removed_entries);
+}
+
+void DirectoryEntryCache::invalidate_file_system(FileSystemID fsid)
+{
+    LRUList removed_entries;
+    m_state.with([&](auto& state) {
+        state.generation++;
+        for (auto it = state.lru_list.begin(); it != state.lru_list.end();) {
+            auto& entry = *it;
+            ++it;
+            if (entry.directory.fsid() != fsid)
+                continue;
+            remove_entry(state, entry, removed_entries);
+            m_invalidations++;
+        }
+    });
+    free_entries(removed_entries);
+}
+
+DirectoryEntryCache::Statistics DirectoryEntryCache::statistics() const
+{
+    Statistics statistics;
+    statistics.hits = m_hits.load();
+    statistics.negative_hits = m_negative_hits.load();
+    statistics.misses = m_misses.load();
+    statistics.evictions = m_evictions.load();
+    statistics.invalidations = m_invalidations.load();
+    statistics.capacity = maximum_entry_count;
+    m_state.with([&](auto& state) {
+        statistics.entries = state.entry_count;
+        statistics.negative_entries = state.negative_entry_count;
+    });
+    return statistics;
+}
+
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Array.h>
+#include <AK/Atomic.h>
+#include <AK/Error.h>
+#include <AK/IntrusiveList.h>
+#include <AK/Noncopyable.h>
+#include <AK/StringView.h>
+#include <Kernel/FileSystem/FileSystem.h>
+#include <Kernel/FileSystem/InodeIdentifier.h>
+#include <Kernel/Forward.h>
+#include <Kernel/Library/KString.h>
+#include <Kernel/Library/LockWeakPtr.h>
+#include <Kernel/Locking/SpinlockProtected.h>
+
+namespace Kernel {
+
+// Remembers what looking up a name in a directory turned up, including names that don't exist, so path resolution
+// doesn't have to ask the file system again for every component.
+// Only file systems that support watchers are cached, as the change events they send are what keeps us up to date.
+class DirectoryEntryCache {
+    AK_MAKE_NONCOPYABLE(DirectoryEntryCache);
+    AK_MAKE_NONMOVABLE(DirectoryEntryCache);
+
+public:
+    static DirectoryEntryCache& the();
+
+    DirectoryEntryCache() = default;
+
+    ErrorOr<NonnullRefPtr<Inode>> lookup(Inode& directory, StringView name);
+
+    void invalidate(InodeIdentifier directory, StringView name);
+    void invalidate_directory(InodeIdentifier directory);
+    void invalidate_file_system(FileSystemID);
+
+    struct Statistics {
+        u64 hits { 0 };
+        u64 negative_hits { 0 };
+        u64 misses { 0 };
+        u64 evictions { 0 };
+        u64 invalidations { 0 };
+        size_t entries { 0 };
+        size_t negative_entries { 0 };
+        size_t capacity { 0 };
+    };
+    Statistics statistics() const;
+
+private:
+    struct Entry {
+        InodeIdentifier directory;
+        NonnullOwnPtr<KString> name;
+        LockWeakPtr<Inode> child;
+        // The name doesn't exist in the directory.
+        bool is_negative { false };
+        IntrusiveListNode<Entry> name_list_node;
+        IntrusiveListNode<Entry> directory_list_node;
+        IntrusiveListNode<Entry> lru_list_node;
+    };
+    using NameList = IntrusiveList<&Entry::name_list_node>;
+    using DirectoryList = IntrusiveList<&Entry::directory_list_node>;
+    // NOTE: Entries that were removed while holding the lock are also gathered on one of these, to be freed after
+    //       dropping it.
+    using LRUList = IntrusiveList<&Entry::lru_list_node>;
+
+    // NOTE: The buckets don't grow, so that nothing has to be allocated or freed while holding the lock.
+    static constexpr size_t bucket_count = 1024;
+
+    struct State {
+        Array<NameList, bucket_count> entries_by_name;
+        Array<DirectoryList, bucket_count> entries_by_directory;
+        LRUList lru_list;
+        size_t entry_count { 0 };
+        size_t negative_entry_count { 0 };
+        // Bumped by every invalidation, so a lookup that raced with a change doesn't cache what it saw before it.
+        u64 generation { 0 };
+    };
+
+    void insert(Inode& directory, StringView name, RefPtr<Inode> child, u64 generation);
+    static NameList& name_bucket(State&, InodeIdentifier directory, StringView name);
+    static DirectoryList& directory_bucket(State&, InodeIdentifier directory);
+    static Entry* find_entry(State&, InodeIdentifier directory, StringView name);
+    static void remove_entry(State&, Entry&, LRUList& removed_entries);
+    static void free_entries(LRUList&);
+
+    SpinlockProtected<State, LockRank::None> m_state {};
+
+    Atomic<u64> m_hits { 0 };
+    Atomic<u64> m_negative_hits { 0 };
+    Atomic<u64> m_misses { 0 };
+    Atomic<u64> m_evictions { 0 };
+    Atomic<u64> m_invalidations { 0 };
+};
+
+}
@@ -0,0 +1,298 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Singleton.h>
+#include <Kernel/FileSystem/EventQueue.h>
+#include <Kernel/FileSystem/OpenFileDescription.h>
+
+namespace Kernel {
+
+using BlockFlags = Thread::FileBlocker::BlockFlags;
+
+// The registrations of every file description that has been added to an event queue, so they can be dropped
+// when the description goes away.
+// NOTE: This lock is taken before the lock of any event queue.
+using RegistrationsByDescription = HashMap<OpenFileDescription*, Vector<NonnullRefPtr<EventQueueRegistration>, 1>>;
+static Singleton<SpinlockProtected<RegistrationsByDescription, LockRank::None>> s_registrations_by_description;
+
+static void forget_registration_of_description(RegistrationsByDescription& table, OpenFileDescription* description, EventQueueRegistration const& registration)
+{
+    auto it = table.find(description);
+    if (it == table.end())
+        return;
+    it->value.remove_first_matching([&](auto& entry) { return entry.ptr() == &registration; });
+    if (it->value.is_empty())
+        table.remove(it);
+}
+
+EventQueueRegistration::EventQueueRegistration(EventQueue& event_queue, OpenFileDescription& description, int fd, epoll_event const& event)
+    : m_event_queue(event_queue)
+    , m_file(description.file())
+    , m_fd(fd)
+    , m_events(event.events)
+    , m_data(event.data)
+{
+}
+
+void EventQueueRegistration::file_state_may_have_changed()
+{
+    m_event_queue.did_change_state(*this);
+}
+
+BlockFlags EventQueueRegistration::block_flags() const
+{
+    // Errors and hangups are always reported, whether they were asked for or not.
+    auto flags = BlockFlags::WriteError | BlockFlags::WriteHangUp;
+    if (m_events & (EPOLLIN | EPOLLRDNORM))
+        flags |= BlockFlags::Read;
+    if (m_events & (EPOLLOUT | EPOLLWRNORM))
+        flags |= BlockFlags::Write;
+    if (m_events & EPOLLRDHUP)
+        flags |= BlockFlags::ReadHangUp;
+    return flags;
+}
+
+ErrorOr<NonnullRefPtr<EventQueue>> EventQueue::try_create()
+{
+    return adopt_nonnull_ref_or_enomem(new (nothrow) EventQueue);
+}
+
+EventQueue::~EventQueue()
+{
+    // NOTE: Once our registrations are out of the table, no description can call forget() on us anymore.
+    auto registrations = s_registrations_by_description->with([&](auto& table) {
+        return m_state.with([&](auto& state) {
+            for (auto& it : state.registrations) {
+                if (auto* description = it.value->m_description)
+                    forget_registration_of_description(table, description, *it.value);
+                it.value->m_description = nullptr;
+            }
+            state.ready_list.clear();
+            return move(state.registrations);
+        });
+    });
+
+    for (auto& it : registrations)
+        it.value->m_file->blocker_set().remove_observer(*it.value);
+}
+
+ErrorOr<void> EventQueue::add(int fd, OpenFileDescription& description, epoll_event const& event)
+{
+    if (description.file().is_event_queue()) {
+        // FIXME: Support nesting event queues.
+        return EINVAL;
+    }
+    // NOTE: Regular files and directories are always ready, so Linux refuses to watch them, and so do we.
+    if (description.file().is_inode())
+        return EPERM;
+
+    auto registration = TRY(adopt_nonnull_ref_or_enomem(new (nothrow) EventQueueRegistration(*this, description, fd, event)));
+
+    TRY(s_registrations_by_description->with([&](auto& table) -> ErrorOr<void> {
+        auto it = table.find(&description);
+        if (it == table.end()) {
+            TRY(table.try_set(&description, {}));
+            it = table.find(&description);
+        }
+        TRY(it->value.try_append(registration));
+        return {};
+    }));
+    description.did_register_with_event_queue({});
+
+    // The registration has to observe the file before anyone can find it in the queue, or a concurrent remove()
+    // could miss it and leave it linked after it's gone. Until it's published, it ignores state changes.
+    registration->m_file->blocker_set().add_observer(*registration);
+
+    RefPtr<EventQueueRegistration> stale_registration;
+    OpenFileDescription* stale_description = nullptr;
+    auto result = m_state.with([&](auto& state) -> ErrorOr<void> {
+        if (auto it = state.registrations.find(fd); it != state.registrations.end()) {
+            if (it->value->m_description == &description)
+                return EEXIST;
+            // The file descriptor was closed and reused without removing it from the queue first, but the old
+            // description is still open somewhere else. Linux would keep watching it, we replace it instead.
+            stale_registration = it->value;
+            stale_description = it->value->m_description;
+            stale_registration->m_description = nullptr;
+            if (stale_registration->m_ready_list_node.is_in_list())
+                state.ready_list.remove(*stale_registration);
+        }
+        TRY(state.registrations.try_set(fd, registration));
+        registration->m_description = &description;
+        // Check the initial state at the next wait.
+        state.ready_list.append(*registration);
+        return {};
+    });
+
+    if (result.is_error() || stale_registration) {
+        s_registrations_by_description->with([&](auto& table) {
+            if (result.is_error())
+                forget_registration_of_description(table, &description, *registration);
+            if (stale_registration)
+                forget_registration_of_description(table, stale_description, *stale_registration);
+        });
+        if (stale_registration)
+            stale_registration->m_file->blocker_set().remove_observer(*stale_registration);
+        if (result.is_error()) {
+            registration->m_file->blocker_set().remove_observer(*registration);
+            return result.release_error();
+        }
+    }
+
+    m_wait_queue.wake_all();
+    evaluate_block_conditions();
+    return {};
+}
+
+ErrorOr<void> EventQueue::modify(int fd, OpenFileDescription& description, epoll_event const& event)
+{
+    TRY(m_state.with([&](auto& state) -> ErrorOr<void> {
+        auto it = state.registrations.find(fd);
+        if (it == state.registrations.end() || it->value->m_description != &description)
+            return ENOENT;
+        auto& registration = *it->value;
+        registration.m_events = event.events;
+        registration.m_data = event.data;
+        registration.m_is_disabled = false;
+        if (!registration.m_ready_list_node.is_in_list())
+            state.ready_list.append(registration);
+        return {};
+    }));
+
+    m_wait_queue.wake_all();
+    evaluate_block_conditions();
+    return {};
+}
+
+ErrorOr<void> EventQueue::remove(int fd, OpenFileDescription& description)
+{
+    auto registration = TRY(m_state.with([&](auto& state) -> ErrorOr<NonnullRefPtr<EventQueueRegistration>> {
+        auto it = state.registrations.find(fd);
+        if (it == state.registrations.end() || it->value->m_description != &description)
+            return ENOENT;
+        auto registration = it->value;
+        state.registrations.remove(it);
+        registration->m_description = nullptr;
+        if (registration->m_ready_list_node.is_in_list())
+            state.ready_list.remove(*registration);
+        return registration;
+    }));
+
+    registration->m_file->blocker_set().remove_observer(*registration);
+    s_registrations_by_description->with([&](auto& table) {
+        forget_registration_of_description(table, &description, *registration);
+    });
+    return {};
+}
+
+void EventQueue::description_will_be_destroyed(Badge<OpenFileDescription>, OpenFileDescription& description)
+{
+    // NOTE: The event queues are kept alive by the table lock here, as their destructors have to take it before
+    //       they are gone.
+    s_registrations_by_description->with([&](auto& table) {
+        auto registrations = table.take(&description);
+        if (!registrations.has_value())
+            return;
+        for (auto& registration : *registrations) {
+            registration->m_file->blocker_set().remove_observer(*registration);
+            registration->m_event_queue.forget(*registration);
+        }
+    });
+}
+
+void EventQueue::forget(EventQueueRegistration& registration)
+{
+    m_state.with([&](auto& state) {
+        if (auto it = state.registrations.find(registration.m_fd); it != state.registrations.end() && it->value.ptr() == &registration)
+            state.registrations.remove(it);
+        registration.m_description = nullptr;
+        if (registration.m_ready_list_node.is_in_list())
+            state.ready_list.remove(registration);
+    });
+}
+
+void EventQueue::did_change_state(EventQueueRegistration& registration)
+{
+    bool was_queued = m_state.with([&](auto& state) {
+        if (!registration.m_description || registration.m_is_disabled || registration.m_ready_list_node.is_in_list())
+            return false;
+        state.ready_list.append(registration);
+        return true;
+    });
+    if (!was_queued)
+        return;
+
+    m_wait_queue.wake_all();
+    evaluate_block_conditions();
+}
+
+size_t EventQueue::collect_ready_events(Span<epoll_event> events)
+{
+    return m_state.with([&](auto& state) {
+        size_t count = 0;
+        EventQueueRegistration::ReadyList still_ready;
+        while (count < events.size() && !state.ready_list.is_empty()) {
+            auto registration = state.ready_list.take_first();
+            if (!registration->m_description || registration->m_is_disabled)
+                continue;
+
+            auto unblock_flags = registration->m_description->should_unblock(registration->block_flags());
+            if (unblock_flags == BlockFlags::None)
+                continue;
+
+            u32 ready_events = 0;
+            if (has_flag(unblock_flags, BlockFlags::Read))
+                ready_events |= EPOLLIN | EPOLLRDNORM;
+            if (has_flag(unblock_flags, BlockFlags::Write) && !has_flag(unblock_flags, BlockFlags::WriteHangUp))
+                ready_events |= EPOLLOUT | EPOLLWRNORM;
+            if (has_flag(unblock_flags, BlockFlags::ReadHangUp))
+                ready_events |= EPOLLRDHUP;
+            if (has_flag(unblock_flags, BlockFlags::WriteHangUp))
+                ready_events |= EPOLLHUP;
+            if (has_flag(unblock_flags, BlockFlags::WriteError))
+                ready_events |= EPOLLERR;
+            events[count++] = { ready_events & (registration->m_events | EPOLLHUP | EPOLLERR), registration->m_data };
+
+            if (registration->m_events & EPOLLONESHOT)
+                registration->m_is_disabled = true;
+            else if (!(registration->m_events & EPOLLET))
+                still_ready.append(*registration);
+        }
+
+        // A level-triggered registration stays on the ready list until a wait finds it not ready anymore.
+        while (!still_ready.is_empty())
+            state.ready_list.append(*still_ready.take_first());
+        return count;
+    });
+}
+
+ErrorOr<size_t> EventQueue::wait(Span<epoll_event> events, Thread::BlockTimeout const& timeout)
+{
+    for (;;) {
+        if (auto count = collect_ready_events(events); count > 0)
+            return count;
+
+        auto result = m_wait_queue.wait_on(timeout, "EventQueue"sv);
+        if (result == Thread::BlockResult::InterruptedByTimeout)
+            return collect_ready_events(events);
+        if (result.was_interrupted())
+            return EINTR;
+    }
+}
+
+bool EventQueue::can_read(OpenFileDescription const&, u64) const
+{
+    return m_state.with([](auto& state) { return !state.ready_list.is_empty(); });
+}
+
+ErrorOr<NonnullOwnPtr<KString>> EventQueue::pseudo_path(OpenFileDescription const&) const
+{
+    return m_state.with([](auto& state) -> ErrorOr<NonnullOwnPtr<KString>> {
+        return KString::formatted("EventQueue:({})", state.registrations.size());
+    });
+}
+
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/AtomicRefCounted.h>
+#include <AK/Badge.h>
+#include <AK/HashMap.h>
+#include <AK/IntrusiveList.h>
+#include <Kernel/API/POSIX/sys/epoll.h>
+#include <Kernel/FileSystem/File.h>
+#include <Kernel/Locking/SpinlockProtected.h>
+#include <Kernel/Tasks/WaitQueue.h>
+
+namespace Kernel {
+
+// The interest of an event queue in one file description.
+class EventQueueRegistration final
+    : public AtomicRefCounted<EventQueueRegistration>
+    , public FileStateObserver {
+public:
+    virtual ~EventQueueRegistration() override = default;
+
+    virtual void file_state_may_have_changed() override;
+
+private:
+    friend class EventQueue;
+
+    EventQueueRegistration(EventQueue& event_queue, OpenFileDescription& description, int fd, epoll_event const& event);
+
+    Thread::FileBlocker::BlockFlags block_flags() const;
+
+    EventQueue& m_event_queue;
+    NonnullRefPtr<File> m_file;
+
+    // NOTE: Everything below is protected by the event queue's lock.
+
+    // This is set once the registration is in the event queue, and cleared when the description goes away,
+    // which also removes the registration from the event queue.
+    OpenFileDescription* m_description { nullptr };
+    int const m_fd { -1 };
+    u32 m_events { 0 };
+    epoll_data_t m_data {};
+    // Set once an EPOLLONESHOT registration has reported an event, until it's modified again.
+    bool m_is_disabled { false };
+
+    IntrusiveListNode<EventQueueRegistration, RefPtr<EventQueueRegistration>> m_ready_list_node;
+
+public:
+    using ReadyList = IntrusiveList<&EventQueueRegistration::m_ready_list_node>;
+};
+
+// An event queue keeps a set of file descriptions and tells which of them are ready for I/O, like poll() does.
+// Unlike with poll(), the set is kept between waits, and a description goes on a ready list whenever its state
+// changes, so a wait costs time in proportion to the number of ready descriptions rather than all of them.
+// This is what implements the epoll API.
+class EventQueue final : public File {
+public:
+    static ErrorOr<NonnullRefPtr<EventQueue>> try_create();
+    virtual ~EventQueue() override;
+
+    ErrorOr<void> add(int fd, OpenFileDescription&, epoll_event const&);
+    ErrorOr<void> modify(int fd, OpenFileDescription&, epoll_event const&);
+    ErrorOr<void> remove(int fd, OpenFileDescription&);
+
+    // Fills in up to events.size() events, blocking until there is at least one or the timeout expires.
+    ErrorOr<size_t> wait(Span<epoll_event> events, Thread::BlockTimeout const&);
+
+    static void description_will_be_destroyed(Badge<OpenFileDescription>, OpenFileDescription&);
+
+    // ^File
+    virtual bool can_read(OpenFileDescription const&, u64) const override;
+    virtual ErrorOr<size_t> read(OpenFileDescription&, u64, UserOrKernelBuffer&, size_t) override { return EINVAL; }
+    virtual bool can_write(OpenFileDescription const&, u64) const override { return false; }
+    virtual ErrorOr<size_t> write(OpenFileDescription&, u64, UserOrKernelBuffer const&, size_t) override { return EINVAL; }
+    virtual ErrorOr<NonnullOwnPtr<KString>> pseudo_path(OpenFileDescription const&) const override;
+    virtual StringView class_name() const override { return "EventQueue"sv; }
+    virtual bool is_event_queue() const override { return true; }
+
+private:
+    friend class EventQueueRegistration;
+
+    EventQueue() = default;
+
+    void did_change_state(EventQueueRegistration&);
+    void forget(EventQueueRegistration&);
+    size_t collect_ready_events(Span<epoll_event>);
+
+    struct State {
+        HashMap<int, NonnullRefPtr<EventQueueRegistration>> registrations;
+        EventQueueRegistration::ReadyList ready_list;
+    };
+    SpinlockProtected<State, LockRank::None> m_state {};
+    WaitQueue m_wait_queue;
+};
+
+}
@@ -250,9 +250,82 @@ ErrorOr<void> Ext2FS::write_ext2_inode(InodeIndex inode, ext2_inode const& e2ino
     return write_block(block_index, buffer, inode_size(), offset);
 }
 
-auto Ext2FS::allocate_blocks(GroupIndex preferred_group_index, size_t count) -> ErrorOr<Vector<BlockIndex>>
+size_t Ext2FS::blocks_in_group() const
 {
-    dbgln_if(EXT2_DEBUG, "Ext2FS: allocate_blocks(preferred group: {}, count {})", preferred_group_index, count);
+    return min(blocks_per_group(), super_block().s_blocks_count);
+}
+
+size_t Ext2FS::bit_index_in_group(BlockIndex block_index) const
+{
+    return (block_index.value() - first_block_index().value()) % blocks_per_group();
+}
+
+auto Ext2FS::find_available_blocks_in_group(GroupIndex group_index, size_t first_bit_index, size_t minimum_length, size_t maximum_length) -> ErrorOr<Optional<BlockRun>>
+{
+    VERIFY(m_lock.is_locked());
+    VERIFY(minimum_length > 0 && minimum_length <= maximum_length);
+
+    auto const& bgd = group_descriptor(group_index);
+    if (bgd.bg_free_blocks_count < minimum_length || first_bit_index >= blocks_in_group())
+        return Optional<BlockRun> {};
+
+    auto* cached_bitmap = TRY(get_bitmap_block(bgd.bg_block_bitmap));
+    BitmapView block_bitmap { cached_bitmap->buffer->data(), blocks_in_group() };
+    Optional<BitmapView> reservations;
+    if (cached_bitmap->reservations)
+        reservations = BitmapView { cached_bitmap->reservations->data(), blocks_in_group() };
+
+    size_t from = first_bit_index;
+    while (from < blocks_in_group()) {
+        size_t start = from;
+        auto length = block_bitmap.find_next_range_of_unset_bits(start, minimum_length, maximum_length);
+        if (!length.has_value())
+            return Optional<BlockRun> {};
+
+        if (reservations.has_value()) {
+            // The run may overlap the preallocation window of some other inode, so cut it short where that begins.
+            size_t unreserved_start = start;
+            auto unreserved_length = reservations->find_next_range_of_unset_bits(unreserved_start, 1, length.value());
+            if (!unreserved_length.has_value() || unreserved_start >= start + length.value()) {
+                from = start + length.value();
+                continue;
+            }
+            if (unreserved_start != start) {
+                from = unreserved_start;
+                continue;
+            }
+            length = min(length.value(), unreserved_length.value());
+        }
+
+        if (length.value() >= minimum_length)
+            return BlockRun { group_index, start, length.value() };
+        from = start + length.value();
+    }
+    return Optional<BlockRun> {};
+}
+
+auto Ext2FS::find_available_blocks(BlockIndex goal, size_t minimum_length, size_t maximum_length) -> ErrorOr<Optional<BlockRun>>
+{
+    auto goal_group_index = group_index_from_block_index(goal);
+    auto goal_bit_index = bit_index_in_group(goal);
+
+    // Look after the goal in its own group first, then at all the other groups, and finally before the goal.
+    for (size_t i = 0; i <= m_block_group_count; ++i) {
+        GroupIndex group_index = (goal_group_index.value() - 1 + i) % m_block_group_count + 1;
+        size_t first_bit_index = 0;
+        if (i == 0)
+            first_bit_index = goal_bit_index;
+        else if (i == m_block_group_count && goal_bit_index == 0)
+            break;
+        if (auto run = TRY(find_available_blocks_in_group(group_index, first_bit_index, minimum_length, maximum_length)); run.has_value())
+            return run;
+    }
+    return Optional<BlockRun> {};
+}
+
+auto Ext2FS::allocate_blocks(GroupIndex preferred_group_index, size_t count, BlockIndex goal) -> ErrorOr<Vector<BlockIndex>>
+{
+    dbgln_if(EXT2_DEBUG, "Ext2FS: allocate_blocks(preferred group: {}, count {}, goal {})", preferred_group_index, count, goal);
     if (count == 0)
         return Vector<BlockIndex> {};
 
@@ -260,52 +333,152 @@ auto Ext2FS::allocate_blocks(GroupIndex preferred_group_index, size_t count) ->
     TRY(blocks.try_ensure_capacity(count));
 
     MutexLocker locker(m_lock);
-    auto group_index = preferred_group_index;
-
-    if (!group_descriptor(preferred_group_index).bg_free_blocks_count) {
-        group_index = 1;
+    if (goal == 0 || goal >= super_block().s_blocks_count) {
+        if (preferred_group_index == 0 || preferred_group_index > m_block_group_count)
+            preferred_group_index = 1;
+        goal = first_block_of_group(preferred_group_index);
     }
 
     while (blocks.size() < count) {
-        bool found_a_group = false;
-        if (group_descriptor(group_index).bg_free_blocks_count) {
-            found_a_group = true;
-        } else {
-            if (group_index == preferred_group_index)
-                group_index = 1;
-            for (; group_index <= m_block_group_count; group_index = GroupIndex { group_index.value() + 1 }) {
-                if (group_descriptor(group_index).bg_free_blocks_count) {
-                    found_a_group = true;
-                    break;
-                }
-            }
+        auto remaining_count = count - blocks.size();
+
+        // Look for a single run that fits everything that's left, and settle for shorter and shorter ones if there is none.
+        Optional<BlockRun> run;
+        for (size_t minimum_length = remaining_count;; minimum_length = max<size_t>(minimum_length / 2, 1)) {
+            run = TRY(find_available_blocks(goal, minimum_length, remaining_count));
+            if (run.has_value() || minimum_length == 1)
+                break;
+        }
+
+        if (!run.has_value()) {
+            // All the free blocks that are left are set aside for other inodes, so stop setting them aside.
+            if (discard_all_preallocation_windows())
+                continue;
+            dmesgln("Ext2FS: allocate_blocks found no available blocks, despite the superblock claiming there are {}", super_block().s_free_blocks_count);
+            TRY(free_blocks(blocks));
+            return ENOSPC;
         }
 
-        VERIFY(found_a_group);
-        auto const& bgd = group_descriptor(group_index);
+        dbgln_if(EXT2_DEBUG, "Ext2FS: allocating free region of size: {} [{}]", run->length, run->group_index);
+        TRY(set_blocks_allocation_state(run->group_index, run->first_bit_index, run->length, true));
+        auto first_block = first_block_of_group(run->group_index).value() + run->first_bit_index;
+        for (size_t i = 0; i < run->length; ++i)
+            blocks.unchecked_append(first_block + i);
+        goal = first_block + run->length;
+    }
+
+    VERIFY(blocks.size() == count);
+    return blocks;
+}
+
+auto Ext2FS::allocate_data_blocks(Ext2FSInode& inode, size_t count) -> ErrorOr<Vector<BlockIndex>>
+{
+    if (count == 0)
+        return Vector<BlockIndex> {};
 
-        auto* cached_bitmap = TRY(get_bitmap_block(bgd.bg_block_bitmap));
+    Vector<BlockIndex> blocks;
+    TRY(blocks.try_ensure_capacity(count));
 
-        int blocks_in_group = min(blocks_per_group(), super_block().s_blocks_count);
-        auto block_bitmap = cached_bitmap->bitmap(blocks_in_group);
+    MutexLocker locker(m_lock);
 
-        BlockIndex first_block_in_group = first_block_of_group(group_index);
-        size_t free_region_size = 0;
-        auto first_unset_bit_index = block_bitmap.find_longest_range_of_unset_bits(count - blocks.size(), free_region_size);
-        VERIFY(first_unset_bit_index.has_value());
-        dbgln_if(EXT2_DEBUG, "Ext2FS: allocating free region of size: {} [{}]", free_region_size, group_index);
-        for (size_t i = 0; i < free_region_size; ++i) {
-            BlockIndex block_index = (first_unset_bit_index.value() + i) + first_block_in_group.value();
-            TRY(set_block_allocation_state(block_index, true));
-            blocks.unchecked_append(block_index);
-            dbgln_if(EXT2_DEBUG, "  allocated > {}", block_index);
+    BlockIndex goal = 0;
+    for (size_t i = inode.m_block_list.size(); i > 0; --i) {
+        if (auto block_index = inode.m_block_list[i - 1]; block_index != 0) {
+            goal = block_index.value() + 1;
+            break;
+        }
+    }
+
+    // The window has to carry on right where the file ends, which it doesn't anymore if the file was truncated.
+    auto& window = inode.m_preallocation_window;
+    if (window.block_count != 0 && window.first_block != goal)
+        discard_preallocation_window(inode);
+
+    if (auto count_from_window = min(count, window.block_count); count_from_window != 0) {
+        auto group_index = group_index_from_block_index(window.first_block);
+        auto first_bit_index = bit_index_in_group(window.first_block);
+        TRY(set_blocks_reserved(group_index, first_bit_index, count_from_window, false));
+        TRY(set_blocks_allocation_state(group_index, first_bit_index, count_from_window, true));
+        for (size_t i = 0; i < count_from_window; ++i)
+            blocks.unchecked_append(window.first_block.value() + i);
+        window.first_block = window.first_block.value() + count_from_window;
+        window.block_count -= count_from_window;
+        // The file is being written sequentially, so give it a bigger window next time.
+        if (window.block_count == 0)
+            window.next_size = min(window.next_size * 2, Ext2FSInode::PreallocationWindow::maximum_size);
+    }
+
+    if (blocks.size() < count) {
+        if (!blocks.is_empty())
+            goal = blocks.last().value() + 1;
+        auto more_blocks = TRY(allocate_blocks(group_index_from_inode(inode.index()), count - blocks.size(), goal));
+        TRY(blocks.try_extend(move(more_blocks)));
+    }
+
+    // Set aside the blocks that follow, so the next writes can carry on contiguously even if other files grow in the meantime.
+    if (window.block_count == 0 && Kernel::is_regular_file(inode.m_raw_inode.i_mode)) {
+        BlockIndex next_block = blocks.last().value() + 1;
+        if (next_block < super_block().s_blocks_count) {
+            auto group_index = group_index_from_block_index(next_block);
+            auto run = TRY(find_available_blocks_in_group(group_index, bit_index_in_group(next_block), 1, window.next_size));
+            if (run.has_value() && run->first_bit_index == bit_index_in_group(next_block)) {
+                TRY(set_blocks_reserved(group_index, run->first_bit_index, run->length, true));
+                window.first_block = next_block;
+                window.block_count = run->length;
+            }
         }
     }
 
-    VERIFY(blocks.size() == count);
     return blocks;
 }
 
+ErrorOr<void> Ext2FS::free_blocks(Span<BlockIndex const> blocks)
+{
+    MutexLocker locker(m_lock);
+    for (size_t i = 0; i < blocks.size();) {
+        auto first_block = blocks[i];
+        if (first_block == 0) {
+            ++i;
+            continue;
+        }
+        VERIFY(first_block < super_block().s_blocks_count);
+
+        // Free runs of consecutive blocks in one go.
+        auto group_index = group_index_from_block_index(first_block);
+        size_t length = 1;
+        while (i + length < blocks.size() && blocks[i + length] == first_block.value() + length && group_index_from_block_index(blocks[i + length]) == group_index)
+            ++length;
+
+        TRY(set_blocks_allocation_state(group_index, bit_index_in_group(first_block), length, false));
+        i += length;
+    }
+    return {};
+}
+
+void Ext2FS::discard_preallocation_window(Ext2FSInode& inode)
+{
+    MutexLocker locker(m_lock);
+    auto& window = inode.m_preallocation_window;
+    if (window.block_count != 0) {
+        // NOTE: The bitmap is cached already, since we reserved blocks in it. So this can't fail.
+        MUST(set_blocks_reserved(group_index_from_block_index(window.first_block), bit_index_in_group(window.first_block), window.block_count, false));
+    }
+    window = {};
+}
+
+bool Ext2FS::discard_all_preallocation_windows()
+{
+    MutexLocker locker(m_lock);
+    bool discarded_any = false;
+    for (auto& it : m_inode_cache) {
+        if (!it.value || it.value->m_preallocation_window.block_count == 0)
+            continue;
+        discard_preallocation_window(*it.value);
+        discarded_any = true;
+    }
+    return discarded_any;
+}
+
 ErrorOr<InodeIndex> Ext2FS::allocate_inode(GroupIndex preferred_group)
 {
     dbgln_if(EXT2_DEBUG, "Ext2FS: allocate_inode(preferred_group: {})", preferred_group);
@@ -474,6 +647,49 @@ ErrorOr<void> Ext2FS::set_block_allocation_state(BlockIndex block_index, bool ne
     return update_bitmap_block(bgd.bg_block_bitmap, bit_index, new_state, m_super_block.s_free_blocks_count, bgd.bg_free_blocks_count);
 }
 
+ErrorOr<void> Ext2FS::set_blocks_allocation_state(GroupIndex group_index, size_t first_bit_index, size_t count, bool new_state)
+{
+    VERIFY(m_lock.is_locked());
+    auto& bgd = const_cast<ext2_group_desc&>(group_descriptor(group_index));
+    auto* cached_bitmap = TRY(get_bitmap_block(bgd.bg_block_bitmap));
+    auto block_bitmap = cached_bitmap->bitmap(blocks_per_group());
+
+    dbgln_if(EXT2_DEBUG, "Ext2FS: Blocks {}-{} of group {} state -> {} (in bitmap block {})", first_bit_index, first_bit_index + count - 1, group_index, new_state, bgd.bg_block_bitmap);
+    if (auto count_in_new_state = block_bitmap.count_in_range(first_bit_index, count, new_state); count_in_new_state != 0) {
+        dbgln("Ext2FS: {} of bits {}-{} in bitmap block {} already had state {}", count_in_new_state, first_bit_index, first_bit_index + count - 1, bgd.bg_block_bitmap, new_state);
+        return EIO;
+    }
+    block_bitmap.set_range(first_bit_index, count, new_state);
+    cached_bitmap->dirty = true;
+
+    // Update the counters once for the whole run, rather than once per block.
+    if (new_state) {
+        m_super_block.s_free_blocks_count -= count;
+        bgd.bg_free_blocks_count -= count;
+    } else {
+        m_super_block.s_free_blocks_count += count;
+        bgd.bg_free_blocks_count += count;
+    }
+
+    m_super_block_dirty = true;
+    m_block_group_descriptors_dirty = true;
+    return {};
+}
+
+ErrorOr<void> Ext2FS::set_blocks_reserved(GroupIndex group_index, size_t first_bit_index, size_t count, bool reserved)
+{
+    VERIFY(m_lock.is_locked());
+    auto* cached_bitmap = TRY(get_bitmap_block(group_descriptor(group_index).bg_block_bitmap));
+    if (!cached_bitmap->reservations) {
+        VERIFY(reserved);
+        auto buffer = TRY(KBuffer::try_create_with_size("Ext2FS: Block reservations"sv, logical_block_size(), Memory::Region::Access::ReadWrite));
+        memset(buffer->data(), 0, buffer->size());
+        cached_bitmap->reservations = move(buffer);
+    }
+    Bitmap { cached_bitmap->reservations->data(), blocks_per_group() }.set_range(first_bit_index, count, reserved);
+    return {};
+}
+
 ErrorOr<NonnullRefPtr<Inode>> Ext2FS::create_directory(Ext2FSInode& parent_inode, StringView name, mode_t mode, UserID uid, GroupID gid)
 {
     MutexLocker locker(m_lock);
@@ -609,14 +825,12 @@ ErrorOr<void> Ext2FS::free_inode(Ext2FSInode& inode)
     VERIFY(inode.m_raw_inode.i_links_count == 0);
     dbgln_if(EXT2_DEBUG, "Ext2FS[{}]::free_inode(): Inode {} has no more links, time to delete!", fsid(), inode.index());
 
+    discard_preallocation_window(inode);
+
     // Mark all blocks used by this inode as free.
     {
         auto blocks = TRY(inode.compute_block_list_with_meta_blocks());
-        for (auto block_index : blocks) {
-            VERIFY(block_index <= super_block().s_blocks_count);
-            if (block_index.value())
-                TRY(set_block_allocation_state(block_index, false));
-        }
+        TRY(free_blocks(blocks));
     }
 
     // If the inode being freed is a directory, update block group directory counter.
@@ -8,6 +8,7 @@
 
 #include <AK/Bitmap.h>
 #include <AK/HashMap.h>
+#include <AK/Optional.h>
 #include <Kernel/FileSystem/BlockBasedFileSystem.h>
 #include <Kernel/FileSystem/Ext2FS/Definitions.h>
 #include <Kernel/FileSystem/Inode.h>
@@ -82,7 +83,13 @@ private:
     BlockIndex first_block_index() const;
     BlockIndex first_block_of_block_group_descriptors() const;
     ErrorOr<InodeIndex> allocate_inode(GroupIndex preferred_group = 0);
-    ErrorOr<Vector<BlockIndex>> allocate_blocks(GroupIndex preferred_group_index, size_t count);
+    // Allocates blocks in as few contiguous runs as possible, starting the search at `goal` if given.
+    ErrorOr<Vector<BlockIndex>> allocate_blocks(GroupIndex preferred_group_index, size_t count, BlockIndex goal = 0);
+    // Allocates blocks to append to the inode, from its preallocation window if it has one.
+    ErrorOr<Vector<BlockIndex>> allocate_data_blocks(Ext2FSInode&, size_t count);
+    ErrorOr<void> free_blocks(Span<BlockIndex const>);
+    void discard_preallocation_window(Ext2FSInode&);
+    bool discard_all_preallocation_windows();
     GroupIndex group_index_from_inode(InodeIndex) const;
     GroupIndex group_index_from_block_index(BlockIndex) const;
     BlockIndex first_block_of_group(GroupIndex) const;
@@ -90,6 +97,18 @@ private:
     ErrorOr<bool> get_inode_allocation_state(InodeIndex) const;
     ErrorOr<void> set_inode_allocation_state(InodeIndex, bool);
     ErrorOr<void> set_block_allocation_state(BlockIndex, bool);
+    ErrorOr<void> set_blocks_allocation_state(GroupIndex, size_t first_bit_index, size_t count, bool);
+    ErrorOr<void> set_blocks_reserved(GroupIndex, size_t first_bit_index, size_t count, bool);
+    size_t bit_index_in_group(BlockIndex) const;
+    size_t blocks_in_group() const;
+
+    struct BlockRun {
+        GroupIndex group_index;
+        size_t first_bit_index { 0 };
+        size_t length { 0 };
+    };
+    ErrorOr<Optional<BlockRun>> find_available_blocks(BlockIndex goal, size_t minimum_length, size_t maximum_length);
+    ErrorOr<Optional<BlockRun>> find_available_blocks_in_group(GroupIndex, size_t first_bit_index, size_t minimum_length, size_t maximum_length);
 
     void uncache_inode(InodeIndex);
     ErrorOr<void> free_inode(Ext2FSInode&);
@@ -123,6 +142,8 @@ private:
         BlockIndex bitmap_block_index { 0 };
         bool dirty { false };
         NonnullOwnPtr<KBuffer> buffer;
+        // For block bitmaps: the free blocks that are set aside in a preallocation window. This only lives in memory.
+        OwnPtr<KBuffer> reservations;
         Bitmap bitmap(u32 blocks_per_group) { return Bitmap { buffer->data(), blocks_per_group }; }
     };
 
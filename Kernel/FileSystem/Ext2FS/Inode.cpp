@@ -455,6 +455,8 @@ Ext2FSInode::~Ext2FSInode()
         // Alas, we have nowhere to propagate any errors that occur here.
         (void)fs().free_inode(*this);
     }
+    if (m_preallocation_window.block_count != 0)
+        fs().discard_preallocation_window(*this);
 }
 
 u64 Ext2FSInode::size() const
@@ -588,7 +590,50 @@ ErrorOr<size_t> Ext2FSInode::read_bytes_locked(off_t offset, size_t count, UserO
     return nread;
 }
 
-ErrorOr<void> Ext2FSInode::resize(u64 new_size)
+Vector<BlockBasedFileSystem::BlockIndex, 64> Ext2FSInode::blocks_backing_range(u64 offset, size_t size)
+{
+    Vector<BlockBasedFileSystem::BlockIndex, 64> block_indices;
+    MutexLocker locker(m_inode_lock, Mutex::Mode::Shared);
+    if (!Kernel::is_regular_file(m_raw_inode.i_mode))
+        return block_indices;
+
+    auto file_size = this->size();
+    if (offset >= file_size || size == 0)
+        return block_indices;
+    size = min(static_cast<u64>(size), file_size - offset);
+
+    if (compute_block_list_with_exclusive_locking().is_error() || m_block_list.is_empty())
+        return block_indices;
+
+    auto block_size = fs().logical_block_size();
+    auto first_block_logical_index = offset / block_size;
+    auto last_block_logical_index = min((offset + size - 1) / block_size, static_cast<u64>(m_block_list.size() - 1));
+    for (auto logical_index = first_block_logical_index; logical_index <= last_block_logical_index; ++logical_index) {
+        auto block_index = m_block_list[logical_index];
+        // Holes read as zeroes, so there's nothing on the disk for them.
+        if (block_index.value() == 0)
+            continue;
+        if (block_indices.try_append(block_index).is_error())
+            break;
+    }
+    return block_indices;
+}
+
+void Ext2FSInode::read_ahead(u64 offset, size_t size)
+{
+    auto block_indices = blocks_backing_range(offset, size);
+    dbgln_if(EXT2_VERY_DEBUG, "Ext2FSInode[{}]::read_ahead(): Reading {} blocks ahead, {} bytes into inode", identifier(), block_indices.size(), offset);
+    fs().read_ahead_blocks(block_indices);
+}
+
+void Ext2FSInode::drop_cached_range(u64 offset, size_t size)
+{
+    auto block_indices = blocks_backing_range(offset, size);
+    dbgln_if(EXT2_VERY_DEBUG, "Ext2FSInode[{}]::drop_cached_range(): Dropping {} blocks, {} bytes into inode", identifier(), block_indices.size(), offset);
+    fs().drop_cached_blocks(block_indices);
+}
+
+ErrorOr<void> Ext2FSInode::resize(u64 new_size, Optional<u64> zero_fill_end)
 {
     auto old_size = size();
     if (old_size == new_size)
@@ -616,7 +661,7 @@ ErrorOr<void> Ext2FSInode::resize(u64 new_size)
         m_block_list = TRY(compute_block_list());
 
     if (blocks_needed_after > blocks_needed_before) {
-        auto blocks = TRY(fs().allocate_blocks(fs().group_index_from_inode(index()), blocks_needed_after - blocks_needed_before));
+        auto blocks = TRY(fs().allocate_data_blocks(*this, blocks_needed_after - blocks_needed_before));
         TRY(m_block_list.try_extend(move(blocks)));
     } else if (blocks_needed_after < blocks_needed_before) {
         if constexpr (EXT2_VERY_DEBUG) {
@@ -625,15 +670,12 @@ ErrorOr<void> Ext2FSInode::resize(u64 new_size)
                 dbgln("    # {}", block_index);
             }
         }
-        while (m_block_list.size() != blocks_needed_after) {
-            auto block_index = m_block_list.take_last();
-            if (block_index.value()) {
-                if (auto result = fs().set_block_allocation_state(block_index, false); result.is_error()) {
-                    dbgln("Ext2FSInode[{}]::resize(): Failed to free block {}: {}", identifier(), block_index, result.error());
-                    return result;
-                }
-            }
+        fs().discard_preallocation_window(*this);
+        if (auto result = fs().free_blocks(m_block_list.span().slice(blocks_needed_after)); result.is_error()) {
+            dbgln("Ext2FSInode[{}]::resize(): Failed to free blocks: {}", identifier(), result.error());
+            return result;
         }
+        m_block_list.shrink(blocks_needed_after);
     }
 
     TRY(flush_block_list());
@@ -644,20 +686,40 @@ ErrorOr<void> Ext2FSInode::resize(u64 new_size)
 
     set_metadata_dirty(true);
 
-    if (new_size > old_size) {
-        // If we're growing the inode, make sure we zero out all the new space.
-        // FIXME: There are definitely more efficient ways to achieve this.
-        auto bytes_to_clear = new_size - old_size;
-        auto clear_from = old_size;
-        u8 zero_buffer[PAGE_SIZE] {};
-        while (bytes_to_clear) {
-            auto nwritten = TRY(write_bytes(clear_from, min(static_cast<u64>(sizeof(zero_buffer)), bytes_to_clear), UserOrKernelBuffer::for_kernel_buffer(zero_buffer), nullptr));
-            VERIFY(nwritten != 0);
-            bytes_to_clear -= nwritten;
-            clear_from += nwritten;
-        }
+    // If we're growing the inode, make sure we zero out all the new space.
+    if (new_size > old_size)
+        TRY(zero_fill(old_size, min(zero_fill_end.value_or(new_size), new_size)));
+
+    return {};
+}
+
+ErrorOr<void> Ext2FSInode::zero_fill(u64 offset, u64 end)
+{
+    if (offset >= end)
+        return {};
+
+    u64 block_size = fs().logical_block_size();
+    u8 zero_buffer[PAGE_SIZE] {};
+
+    // The end of the last block that was in use may still have stale data in it.
+    if (auto offset_into_block = offset % block_size; offset_into_block != 0) {
+        auto count = min(block_size - offset_into_block, end - offset);
+        TRY(fs().write_block(m_block_list[offset / block_size], UserOrKernelBuffer::for_kernel_buffer(zero_buffer), count, offset_into_block));
+        offset += count;
     }
 
+    // The rest are whole blocks that were allocated just now, so clear them in runs of consecutive blocks.
+    auto blocks_per_buffer = max(sizeof(zero_buffer) / block_size, static_cast<u64>(1));
+    auto first_logical_index = offset / block_size;
+    auto end_logical_index = ceil_div(end, block_size);
+    for (auto logical_index = first_logical_index; logical_index < end_logical_index;) {
+        auto first_block = m_block_list[logical_index];
+        size_t count = 1;
+        while (count < blocks_per_buffer && logical_index + count < end_logical_index && m_block_list[logical_index + count] == first_block.value() + count)
+            ++count;
+        TRY(fs().write_blocks(first_block, count, UserOrKernelBuffer::for_kernel_buffer(zero_buffer)));
+        logical_index += count;
+    }
     return {};
 }
 
@@ -684,9 +746,11 @@ ErrorOr<size_t> Ext2FSInode::write_bytes_locked(off_t offset, size_t count, User
     bool allow_cache = !description || !description->is_direct();
 
     auto const block_size = fs().logical_block_size();
-    auto new_size = max(static_cast<u64>(offset) + count, size());
+    auto old_size = size();
+    auto new_size = max(static_cast<u64>(offset) + count, old_size);
 
-    TRY(resize(new_size));
+    // Only the gap between the old end of the file and the write needs to be zeroed, we're about to overwrite the rest.
+    TRY(resize(new_size, max(static_cast<u64>(offset), old_size)));
 
     if (m_block_list.is_empty())
         m_block_list = TRY(compute_block_list());
@@ -714,6 +778,9 @@ ErrorOr<size_t> Ext2FSInode::write_bytes_locked(off_t offset, size_t count, User
         dbgln_if(EXT2_DEBUG, "Ext2FSInode[{}]::write_bytes_locked(): Writing block {} (offset_into_block: {})", identifier(), m_block_list[bi.value()], offset_into_block);
         if (auto result = fs().write_block(m_block_list[bi.value()], data.offset(nwritten), num_bytes_to_copy, offset_into_block, allow_cache); result.is_error()) {
             dbgln("Ext2FSInode[{}]::write_bytes_locked(): Failed to write block {} (index {})", identifier(), m_block_list[bi.value()], bi);
+            // The blocks we grew into weren't zeroed, so don't leave any of them in the file that weren't written.
+            if (new_size > old_size)
+                (void)resize(max(static_cast<u64>(offset) + nwritten, old_size));
             return result.release_error();
         }
         remaining_count -= num_bytes_to_copy;
@@ -943,7 +1010,7 @@ ErrorOr<void> Ext2FSInode::replace_child(StringView name, Inode& child)
     //        can't "un-write" a directory entry list.
     TRY(write_directory(entries));
 
-    // TODO: Emit a did_replace_child event.
+    did_replace_child(child.identifier(), name);
 
     return {};
 }
@@ -1061,6 +1128,19 @@ ErrorOr<void> Ext2FSInode::chown(UserID uid, GroupID gid)
     return {};
 }
 
+ErrorOr<void> Ext2FSInode::attach(OpenFileDescription&)
+{
+    m_open_description_count++;
+    return {};
+}
+
+void Ext2FSInode::detach(OpenFileDescription&)
+{
+    // Once the last writer has closed the file, nobody is going to append to it, so give the blocks we set aside back.
+    if (--m_open_description_count == 0 && Kernel::is_regular_file(m_raw_inode.i_mode))
+        fs().discard_preallocation_window(*this);
+}
+
 ErrorOr<void> Ext2FSInode::truncate(u64 size)
 {
     MutexLocker locker(m_inode_lock);
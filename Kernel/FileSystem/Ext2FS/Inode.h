@@ -44,10 +44,19 @@ private:
     virtual ErrorOr<void> chown(UserID, GroupID) override;
     virtual ErrorOr<void> truncate(u64) override;
     virtual ErrorOr<int> get_block_address(int) override;
+    virtual bool can_read_ahead() const override { return true; }
+    virtual void read_ahead(u64 offset, size_t size) override;
+    virtual void drop_cached_range(u64 offset, size_t size) override;
+    virtual ErrorOr<void> attach(OpenFileDescription&) override;
+    virtual void detach(OpenFileDescription&) override;
+
+    Vector<BlockBasedFileSystem::BlockIndex, 64> blocks_backing_range(u64 offset, size_t size);
 
     ErrorOr<void> write_directory(Vector<Ext2FSDirectoryEntry>&);
     ErrorOr<void> populate_lookup_cache();
-    ErrorOr<void> resize(u64);
+    // When growing, the new space is zero-filled up to `zero_fill_end` (or the new size), the caller overwrites the rest.
+    ErrorOr<void> resize(u64 new_size, Optional<u64> zero_fill_end = {});
+    ErrorOr<void> zero_fill(u64 offset, u64 end);
     ErrorOr<void> write_indirect_block(BlockBasedFileSystem::BlockIndex, Span<BlockBasedFileSystem::BlockIndex>);
     ErrorOr<void> grow_doubly_indirect_block(BlockBasedFileSystem::BlockIndex, size_t, Span<BlockBasedFileSystem::BlockIndex>, Vector<BlockBasedFileSystem::BlockIndex>&, unsigned&);
     ErrorOr<void> shrink_doubly_indirect_block(BlockBasedFileSystem::BlockIndex, size_t, size_t, unsigned&);
@@ -69,6 +78,21 @@ private:
     HashMap<NonnullOwnPtr<KString>, InodeIndex> m_lookup_cache;
     ext2_inode m_raw_inode {};
 
+    // Free blocks right after the end of the file that are set aside for it, so it keeps growing contiguously.
+    // Only Ext2FS touches this, with its lock held.
+    struct PreallocationWindow {
+        static constexpr size_t minimum_size = 8;
+        static constexpr size_t maximum_size = 1024;
+
+        BlockBasedFileSystem::BlockIndex first_block { 0 };
+        size_t block_count { 0 };
+        // This doubles every time the file uses up its window.
+        size_t next_size { minimum_size };
+    };
+    PreallocationWindow m_preallocation_window;
+    // NOTE: A description isn't known to be for writing yet when it's attached, so we count all of them.
+    Atomic<u32> m_open_description_count { 0 };
+
     Mutex m_block_list_lock { "BlockList"sv };
 };
 
@@ -8,6 +8,7 @@
 
 #include <AK/AtomicRefCounted.h>
 #include <AK/Error.h>
+#include <AK/IntrusiveList.h>
 #include <AK/StringView.h>
 #include <AK/Types.h>
 #include <Kernel/Forward.h>
@@ -21,10 +22,43 @@ namespace Kernel {
 
 class File;
 
+// Something other than a blocked thread that wants to know when the state of a file may have changed,
+// such as an event queue waiting for it to become readable. Observers are told in the same places
+// that blocked threads are woken up.
+class FileStateObserver {
+public:
+    virtual ~FileStateObserver() = default;
+
+    // NOTE: This is called with the file's blocker set lock held, so it must not block.
+    virtual void file_state_may_have_changed() = 0;
+
+private:
+    friend class FileBlockerSet;
+    IntrusiveListNode<FileStateObserver> m_file_state_observer_list_node;
+};
+
 class FileBlockerSet final : public Thread::BlockerSet {
 public:
     FileBlockerSet() { }
 
+    virtual ~FileBlockerSet() override
+    {
+        VERIFY(m_observers.is_empty());
+    }
+
+    void add_observer(FileStateObserver& observer)
+    {
+        SpinlockLocker lock(m_lock);
+        m_observers.append(observer);
+    }
+
+    void remove_observer(FileStateObserver& observer)
+    {
+        SpinlockLocker lock(m_lock);
+        if (observer.m_file_state_observer_list_node.is_in_list())
+            m_observers.remove(observer);
+    }
+
     virtual bool should_add_blocker(Thread::Blocker& b, void* data) override
     {
         VERIFY(b.blocker_type() == Thread::Blocker::Type::File);
@@ -40,7 +74,12 @@ public:
             auto& blocker = static_cast<Thread::FileBlocker&>(b);
             return blocker.unblock_if_conditions_are_met(false, data);
         });
+        for (auto& observer : m_observers)
+            observer.file_state_may_have_changed();
     }
+
+private:
+    IntrusiveList<&FileStateObserver::m_file_state_observer_list_node> m_observers;
 };
 
 // File is the base class for anything that can be referenced by a OpenFileDescription.
@@ -115,6 +154,8 @@ public:
     virtual bool is_socket() const { return false; }
     virtual bool is_inode_watcher() const { return false; }
     virtual bool is_mount_file() const { return false; }
+    virtual bool is_event_queue() const { return false; }
+    virtual bool is_io_ring() const { return false; }
 
     virtual bool is_regular_file() const { return false; }
 
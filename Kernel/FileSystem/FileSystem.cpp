@@ -7,6 +7,7 @@
 #include <AK/HashMap.h>
 #include <AK/Singleton.h>
 #include <AK/StringView.h>
+#include <Kernel/FileSystem/DirectoryEntryCache.h>
 #include <Kernel/FileSystem/FileSystem.h>
 #include <Kernel/FileSystem/Inode.h>
 #include <Kernel/FileSystem/VirtualFileSystem.h>
@@ -25,6 +26,7 @@ FileSystem::FileSystem()
 
 FileSystem::~FileSystem()
 {
+    DirectoryEntryCache::the().invalidate_file_system(m_fsid);
 }
 
 ErrorOr<void> FileSystem::prepare_to_unmount(Inode& mount_guest_inode)
@@ -53,6 +53,9 @@ public:
 
     virtual ErrorOr<void> flush_writes() { return {}; }
 
+    // Called when the system is running low on memory, to give back memory used for caching.
+    virtual void release_cached_memory() { }
+
     u64 logical_block_size() const { return m_logical_block_size; }
     size_t fragment_size() const { return m_fragment_size; }
 
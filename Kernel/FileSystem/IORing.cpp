@@ -0,0 +1,590 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/NumericLimits.h>
+#include <Kernel/API/POSIX/poll.h>
+#include <Kernel/FileSystem/IORing.h>
+#include <Kernel/FileSystem/OpenFileDescription.h>
+#include <Kernel/Memory/AnonymousVMObject.h>
+#include <Kernel/Memory/MemoryManager.h>
+#include <Kernel/Memory/ScopedAddressSpaceSwitcher.h>
+#include <Kernel/Net/IPv4Socket.h>
+#include <Kernel/Net/LocalSocket.h>
+#include <Kernel/Tasks/Process.h>
+#include <Kernel/Tasks/WorkQueue.h>
+
+namespace Kernel {
+
+using BlockFlags = Thread::FileBlocker::BlockFlags;
+
+static constexpr u32 maximum_submission_entries = 4096;
+
+// Keep the two arrays on cache lines of their own, as they're written by different sides.
+static constexpr size_t submissions_offset = 64;
+
+static constexpr size_t completions_offset_for(u32 submission_entries)
+{
+    return align_up_to(submissions_offset + submission_entries * sizeof(IORingSubmission), 64);
+}
+
+IORingRequest::IORingRequest(IORing& ring, NonnullRefPtr<OpenFileDescription> description, IORingSubmission const& submission, u32 exec_generation, WorkQueue& work_queue)
+    : m_ring(ring)
+    , m_description(move(description))
+    , m_submission(submission)
+    , m_exec_generation(exec_generation)
+    , m_work_queue(work_queue)
+{
+}
+
+bool IORingRequest::waits_for_readiness() const
+{
+    switch (m_submission.opcode) {
+    case IORingOpcode::Read:
+    case IORingOpcode::Write:
+        // Inodes are always ready, but reading and writing them may have to wait for the disk.
+        return !m_description->file().is_inode();
+    case IORingOpcode::Accept:
+    case IORingOpcode::Connect:
+    case IORingOpcode::Send:
+    case IORingOpcode::Receive:
+    case IORingOpcode::PollAdd:
+        return true;
+    case IORingOpcode::Nop:
+    case IORingOpcode::Fsync:
+        return false;
+    }
+    VERIFY_NOT_REACHED();
+}
+
+BlockFlags IORingRequest::block_flags() const
+{
+    switch (m_submission.opcode) {
+    case IORingOpcode::Read:
+    case IORingOpcode::Accept:
+    case IORingOpcode::Receive:
+        return BlockFlags::Read;
+    case IORingOpcode::Write:
+    case IORingOpcode::Send:
+        return BlockFlags::Write;
+    case IORingOpcode::PollAdd: {
+        auto flags = BlockFlags::WriteError | BlockFlags::WriteHangUp;
+        if (m_submission.operation_flags & POLLIN)
+            flags |= BlockFlags::Read;
+        if (m_submission.operation_flags & POLLOUT)
+            flags |= BlockFlags::Write;
+        if (m_submission.operation_flags & POLLPRI)
+            flags |= BlockFlags::ReadPriority;
+        if (m_submission.operation_flags & POLLRDHUP)
+            flags |= BlockFlags::ReadHangUp;
+        return flags;
+    }
+    case IORingOpcode::Connect:
+        return BlockFlags::Connect;
+    case IORingOpcode::Nop:
+    case IORingOpcode::Fsync:
+        return BlockFlags::None;
+    }
+    VERIFY_NOT_REACHED();
+}
+
+bool IORingRequest::may_be_ready() const
+{
+    // Local sockets don't go through the setup states, they're connected once the other side has accepted.
+    if (m_submission.opcode == IORingOpcode::Connect && m_description->socket()->is_local())
+        return m_description->socket()->is_connected();
+    return m_description->should_unblock(block_flags()) != BlockFlags::None;
+}
+
+void IORingRequest::file_state_may_have_changed()
+{
+    // NOTE: We can't ask the file whether it's ready while its blocker set is locked, so the retry will find out.
+    queue_retry();
+}
+
+void IORingRequest::queue_retry()
+{
+    if (m_is_finished || m_retry_is_queued.exchange(true))
+        return;
+    auto result = m_work_queue.try_queue([request = NonnullRefPtr { *this }] {
+        if (auto ring = request->m_ring.strong_ref())
+            ring->retry(*request);
+    });
+    // We'll try again on the next state change.
+    if (result.is_error())
+        m_retry_is_queued = false;
+}
+
+ErrorOr<NonnullRefPtr<IORing>> IORing::try_create(Process& process, u32 entries)
+{
+    if (entries == 0 || entries > maximum_submission_entries)
+        return EINVAL;
+    u32 submission_entries = 1;
+    while (submission_entries < entries)
+        submission_entries <<= 1;
+    // Leave room for completions that userspace hasn't gotten around to yet.
+    u32 completion_entries = submission_entries * 2;
+
+    auto size = TRY(Memory::page_round_up(completions_offset_for(submission_entries) + completion_entries * sizeof(IORingCompletion)));
+    auto vmobject = TRY(Memory::AnonymousVMObject::try_create_with_size(size, AllocationStrategy::AllocateNow));
+    auto region = TRY(MM.allocate_kernel_region_with_vmobject(*vmobject, size, "I/O ring"sv, Memory::Region::Access::ReadWrite));
+    auto weak_process = TRY(process.try_make_weak_ptr<Process>());
+    return adopt_nonnull_ref_or_enomem(new (nothrow) IORing(move(weak_process), submission_entries, move(vmobject), move(region)));
+}
+
+IORing::IORing(LockWeakPtr<Process> process, u32 submission_entries, NonnullLockRefPtr<Memory::AnonymousVMObject> vmobject, NonnullOwnPtr<Memory::Region> region)
+    : m_process(move(process))
+    , m_submission_entries(submission_entries)
+    , m_completion_entries(submission_entries * 2)
+    , m_vmobject(move(vmobject))
+    , m_region(move(region))
+{
+}
+
+IORing::~IORing()
+{
+    // NOTE: Retries that are still queued can't get a reference to us anymore, so they won't touch these.
+    IORingRequest::PendingList requests;
+    m_state.with([&](auto& state) {
+        while (!state.pending_requests.is_empty())
+            requests.append(*state.pending_requests.take_first());
+    });
+    while (!requests.is_empty()) {
+        auto request = requests.take_first();
+        request->m_is_finished = true;
+        request->m_description->file().blocker_set().remove_observer(*request);
+    }
+}
+
+IORingParameters IORing::parameters() const
+{
+    return {
+        .submission_entries = m_submission_entries,
+        .completion_entries = m_completion_entries,
+        .submissions_offset = static_cast<u32>(submissions_offset),
+        .completions_offset = static_cast<u32>(completions_offset_for(m_submission_entries)),
+        .size = static_cast<u32>(m_region->size()),
+    };
+}
+
+IORingSubmission volatile* IORing::submissions() const
+{
+    return reinterpret_cast<IORingSubmission volatile*>(m_region->vaddr().offset(submissions_offset).as_ptr());
+}
+
+IORingCompletion volatile* IORing::completions() const
+{
+    return reinterpret_cast<IORingCompletion volatile*>(m_region->vaddr().offset(completions_offset_for(m_submission_entries)).as_ptr());
+}
+
+u32 IORing::unreaped_completion_count(State const& state) const
+{
+    // NOTE: Userspace owns the head, so it may be anything. We just make sure not to overwrite completions.
+    auto head = AK::atomic_load(&header().completion_head, AK::memory_order_acquire);
+    return min(state.completion_tail - head, m_completion_entries);
+}
+
+ErrorOr<size_t> IORing::enter(Process& process, u32 count, u32 minimum_completions)
+{
+    // A forked child may still have the file descriptor, but the requests are done in the address space of the parent.
+    if (!is_owned_by(process))
+        return EBADF;
+
+    size_t submitted_count = 0;
+    {
+        MutexLocker locker(m_submission_lock);
+        auto tail = AK::atomic_load(&header().submission_tail, AK::memory_order_acquire);
+        while (submitted_count < count && m_submission_head != tail) {
+            // Don't start more requests than the completion queue has room for.
+            bool has_room = m_state.with([&](auto& state) {
+                if (state.in_flight_count + unreaped_completion_count(state) >= m_completion_entries)
+                    return false;
+                state.in_flight_count++;
+                return true;
+            });
+            if (!has_room)
+                break;
+
+            // NOTE: Userspace may change the submission while we look at it, so we take a copy first.
+            IORingSubmission submission;
+            __builtin_memcpy(&submission, const_cast<IORingSubmission const*>(&submissions()[m_submission_head & (m_submission_entries - 1)]), sizeof(submission));
+            AK::atomic_store(&header().submission_head, ++m_submission_head, AK::memory_order_release);
+
+            submit(process, submission);
+            ++submitted_count;
+        }
+    }
+
+    auto wanted_completions = min(minimum_completions, m_completion_entries);
+    while (wanted_completions > 0 && m_state.with([&](auto& state) { return unreaped_completion_count(state); }) < wanted_completions) {
+        if (m_completion_wait_queue.wait_on({}, "IORing"sv).was_interrupted()) {
+            if (submitted_count == 0)
+                return EINTR;
+            break;
+        }
+    }
+    return submitted_count;
+}
+
+static ErrorOr<void> check_submission(Process& process, OpenFileDescription& description, IORingSubmission const& submission)
+{
+    switch (submission.opcode) {
+    case IORingOpcode::Read:
+    case IORingOpcode::Write:
+        if (!(submission.opcode == IORingOpcode::Read ? description.is_readable() : description.is_writable()))
+            return EBADF;
+        if (description.is_directory())
+            return EISDIR;
+        if (submission.offset != IO_RING_CURRENT_OFFSET) {
+            if (submission.offset > static_cast<u64>(NumericLimits<off_t>::max()))
+                return EINVAL;
+            if (!description.file().is_seekable())
+                return ESPIPE;
+        }
+        return {};
+    case IORingOpcode::Accept:
+        TRY(process.require_promise(Pledge::accept));
+        [[fallthrough]];
+    case IORingOpcode::Connect:
+    case IORingOpcode::Send:
+    case IORingOpcode::Receive:
+        if (!description.is_socket())
+            return ENOTSOCK;
+        // Nothing would ever come in for us to wait for.
+        if (submission.opcode == IORingOpcode::Accept && description.socket()->role(description) != Socket::Role::Listener)
+            return EINVAL;
+        if (submission.opcode == IORingOpcode::Connect) {
+            auto domain = description.socket()->domain();
+            if (domain == AF_INET)
+                TRY(process.require_promise(Pledge::inet));
+            else if (domain == AF_LOCAL)
+                TRY(process.require_promise(Pledge::unix));
+        }
+        return {};
+    case IORingOpcode::Nop:
+    case IORingOpcode::Fsync:
+    case IORingOpcode::PollAdd:
+        return {};
+    }
+    return EINVAL;
+}
+
+void IORing::submit(Process& process, IORingSubmission const& submission)
+{
+    // NOTE: While an exec is replacing the program, a request would end up being done for the next one.
+    //       Threads of the old program may still get here after that until they're gone, so we turn them away too.
+    auto exec_generation = process.exec_generation();
+    if ((exec_generation & 1) || Thread::current()->should_die()) {
+        post_completion(submission.user_data, -ECANCELED);
+        return;
+    }
+
+    if (submission.opcode == IORingOpcode::Nop) {
+        post_completion(submission.user_data, 0);
+        return;
+    }
+
+    auto request_or_error = [&]() -> ErrorOr<NonnullRefPtr<IORingRequest>> {
+        auto description = TRY(process.open_file_description(submission.fd));
+        TRY(check_submission(process, *description, submission));
+        auto& work_queue = *g_io_ring_work[m_next_work_queue.fetch_add(1, AK::memory_order_relaxed) % io_ring_work_queue_count];
+        return adopt_nonnull_ref_or_enomem(new (nothrow) IORingRequest(*this, move(description), submission, exec_generation, work_queue));
+    }();
+    if (request_or_error.is_error()) {
+        post_completion(submission.user_data, -request_or_error.error().code());
+        return;
+    }
+    auto request = request_or_error.release_value();
+
+    if (!request->waits_for_readiness()) {
+        start_on_work_queue(move(request));
+        return;
+    }
+
+    auto result = perform(process, *request);
+    if (result.is_error() && result.error().code() == EAGAIN) {
+        park(move(request));
+        return;
+    }
+    finish(*request, move(result));
+}
+
+void IORing::start_on_work_queue(NonnullRefPtr<IORingRequest> request)
+{
+    request->m_retry_is_queued = true;
+    auto result = request->m_work_queue.try_queue([request] {
+        if (auto ring = request->m_ring.strong_ref())
+            ring->retry(*request);
+    });
+    if (result.is_error())
+        finish(*request, result.release_error());
+}
+
+void IORing::park(NonnullRefPtr<IORingRequest> request)
+{
+    // NOTE: We have to watch the file before anyone can find the request in the pending list, so that whoever
+    //       finishes it from there also stops watching. A retry may finish it even before we get to the list.
+    request->m_description->file().blocker_set().add_observer(*request);
+    bool is_pending = m_state.with([&](auto& state) {
+        if (request->m_is_finished)
+            return false;
+        state.pending_requests.append(*request);
+        return true;
+    });
+    // The file may have become ready before we started watching it.
+    if (is_pending && request->may_be_ready())
+        request->queue_retry();
+}
+
+void IORing::retry(IORingRequest& request)
+{
+    request.m_retry_is_queued = false;
+    if (request.m_is_finished)
+        return;
+
+    auto process = m_process.strong_ref();
+    if (!process || process->is_dying() || !begin_performing(*process, request)) {
+        finish(request, Error::from_errno(ECANCELED));
+        return;
+    }
+
+    auto result = [&] {
+        // NOTE: The buffers are in the address space of the process that submitted the request.
+        ScopedAddressSpaceSwitcher switcher(*process);
+        return perform(*process, request);
+    }();
+    end_performing();
+    if (result.is_error() && result.error().code() == EAGAIN && request.waits_for_readiness())
+        return;
+    finish(request, move(result));
+}
+
+bool IORing::begin_performing(Process const& process, IORingRequest const& request)
+{
+    // NOTE: An exec moves on to the next generation before it waits for us, so either it sees us here, or we see it.
+    return m_state.with([&](auto& state) {
+        if (request.m_exec_generation != process.exec_generation())
+            return false;
+        state.performing_count++;
+        return true;
+    });
+}
+
+void IORing::end_performing()
+{
+    m_state.with([&](auto& state) {
+        VERIFY(state.performing_count > 0);
+        state.performing_count--;
+    });
+    m_performing_wait_queue.wake_all();
+}
+
+bool IORing::is_owned_by(Process const& process) const
+{
+    return m_process.strong_ref().ptr() == &process;
+}
+
+void IORing::cancel_requests_for_exec()
+{
+    IORingRequest::PendingList requests;
+    {
+        // NOTE: Other threads may be submitting right now. Once we have the lock, they've parked what they started.
+        MutexLocker locker(m_submission_lock);
+        m_state.with([&](auto& state) {
+            while (!state.pending_requests.is_empty())
+                requests.append(*state.pending_requests.take_first());
+        });
+    }
+    while (!requests.is_empty()) {
+        auto request = requests.take_first();
+        finish(*request, Error::from_errno(ECANCELED));
+    }
+
+    // Requests that are waiting in a work queue will find out about the exec on their own.
+    while (m_state.with([](auto& state) { return state.performing_count; }) > 0)
+        (void)m_performing_wait_queue.wait_on({}, "IORing"sv);
+}
+
+void IORing::finish(IORingRequest& request, ErrorOr<size_t> result)
+{
+    // NOTE: park() looks at this with the state locked, so the request either ends up being removed from the list below,
+    //       or never gets there.
+    if (request.m_is_finished.exchange(true))
+        return;
+    request.m_description->file().blocker_set().remove_observer(request);
+    m_state.with([&](auto& state) {
+        if (request.m_pending_list_node.is_in_list())
+            state.pending_requests.remove(request);
+    });
+
+    i32 completion_result = 0;
+    if (result.is_error())
+        completion_result = -result.error().code();
+    else
+        completion_result = static_cast<i32>(min(result.value(), static_cast<size_t>(NumericLimits<i32>::max())));
+    post_completion(request.m_submission.user_data, completion_result);
+}
+
+void IORing::post_completion(u64 user_data, i32 result)
+{
+    m_state.with([&](auto& state) {
+        VERIFY(state.in_flight_count > 0);
+        state.in_flight_count--;
+        // We never start more requests than there is room for, unless userspace moved the head too far.
+        if (unreaped_completion_count(state) >= m_completion_entries) {
+            AK::atomic_fetch_add(&header().dropped_completions, 1u, AK::memory_order_relaxed);
+            return;
+        }
+        auto& completion = completions()[state.completion_tail & (m_completion_entries - 1)];
+        completion.user_data = user_data;
+        completion.result = result;
+        completion.reserved = 0;
+        AK::atomic_store(&header().completion_tail, ++state.completion_tail, AK::memory_order_release);
+    });
+
+    m_completion_wait_queue.wake_all();
+    evaluate_block_conditions();
+}
+
+static u32 poll_events_from_block_flags(BlockFlags flags)
+{
+    u32 events = 0;
+    if (has_flag(flags, BlockFlags::Read))
+        events |= POLLIN;
+    if (has_flag(flags, BlockFlags::ReadPriority))
+        events |= POLLPRI;
+    if (has_flag(flags, BlockFlags::ReadHangUp))
+        events |= POLLRDHUP;
+    if (has_flag(flags, BlockFlags::WriteHangUp))
+        events |= POLLHUP;
+    else if (has_flag(flags, BlockFlags::Write))
+        events |= POLLOUT;
+    if (has_flag(flags, BlockFlags::WriteError))
+        events |= POLLERR;
+    return events;
+}
+
+ErrorOr<size_t> IORing::perform(Process& process, IORingRequest& request)
+{
+    auto& description = *request.m_description;
+    auto const& submission = request.m_submission;
+
+    auto user_buffer = [&] {
+        return UserOrKernelBuffer::for_user_buffer(reinterpret_cast<u8*>(submission.address), submission.length);
+    };
+
+    switch (submission.opcode) {
+    case IORingOpcode::Read: {
+        auto buffer = TRY(user_buffer());
+        if (auto* socket = description.socket()) {
+            if (socket->is_shut_down_for_reading())
+                return 0;
+            UnixDateTime timestamp {};
+            return socket->recvfrom(description, buffer, submission.length, 0, {}, {}, timestamp, false);
+        }
+        if (!description.can_read())
+            return EAGAIN;
+        if (submission.offset == IO_RING_CURRENT_OFFSET)
+            return description.read(buffer, submission.length);
+        return description.read(buffer, submission.offset, submission.length);
+    }
+    case IORingOpcode::Write: {
+        auto buffer = TRY(user_buffer());
+        if (!description.can_write())
+            return EAGAIN;
+        if (submission.offset == IO_RING_CURRENT_OFFSET)
+            return description.write(buffer, submission.length);
+        return description.write(submission.offset, buffer, submission.length);
+    }
+    case IORingOpcode::Send: {
+        auto buffer = TRY(user_buffer());
+        if (!description.can_write())
+            return EAGAIN;
+        return description.socket()->sendto(description, buffer, submission.length, submission.operation_flags, {}, 0);
+    }
+    case IORingOpcode::Receive: {
+        auto buffer = TRY(user_buffer());
+        UnixDateTime timestamp {};
+        return description.socket()->recvfrom(description, buffer, submission.length, submission.operation_flags, {}, {}, timestamp, false);
+    }
+    case IORingOpcode::Accept: {
+        return process.fds().with_exclusive([&](auto& fds) -> ErrorOr<size_t> {
+            auto fd_allocation = TRY(fds.allocate());
+            auto accepted_socket = description.socket()->accept();
+            if (!accepted_socket)
+                return EAGAIN;
+            auto accepted_socket_description = TRY(OpenFileDescription::try_create(*accepted_socket));
+            accepted_socket_description->set_readable(true);
+            accepted_socket_description->set_writable(true);
+            if (submission.operation_flags & SOCK_NONBLOCK)
+                accepted_socket_description->set_blocking(false);
+            fds[fd_allocation.fd].set(move(accepted_socket_description), (submission.operation_flags & SOCK_CLOEXEC) ? FD_CLOEXEC : 0);
+            return fd_allocation.fd;
+        });
+    }
+    case IORingOpcode::Connect: {
+        auto& socket = *description.socket();
+        Userspace<sockaddr const*> address(static_cast<FlatPtr>(submission.address));
+        // Don't tie up the work queue until the other side gets around to us, but wait for the socket to be connected instead.
+        if (socket.is_local()) {
+            auto& local_socket = static_cast<LocalSocket&>(socket);
+            if (!request.m_connect_started) {
+                request.m_connect_started = true;
+                auto result = local_socket.connect_without_blocking(process.credentials(), description, address, submission.length);
+                if (!result.is_error())
+                    return 0;
+                if (result.error().code() != EINPROGRESS)
+                    return result.release_error();
+            }
+            TRY(local_socket.finish_connect());
+            return 0;
+        }
+        auto& ipv4_socket = static_cast<IPv4Socket&>(socket);
+        if (!request.m_connect_started) {
+            request.m_connect_started = true;
+            auto result = ipv4_socket.connect_without_blocking(description, address, submission.length);
+            if (!result.is_error())
+                return 0;
+            if (result.error().code() != EINPROGRESS)
+                return result.release_error();
+        }
+        if (ipv4_socket.setup_state() != Socket::SetupState::Completed)
+            return EAGAIN;
+        TRY(ipv4_socket.connect_result());
+        return 0;
+    }
+    case IORingOpcode::Fsync:
+        TRY(description.sync());
+        return 0;
+    case IORingOpcode::PollAdd: {
+        auto unblocked_flags = description.should_unblock(request.block_flags());
+        if (unblocked_flags == BlockFlags::None)
+            return EAGAIN;
+        return poll_events_from_block_flags(unblocked_flags);
+    }
+    case IORingOpcode::Nop:
+        return 0;
+    }
+    VERIFY_NOT_REACHED();
+}
+
+bool IORing::can_read(OpenFileDescription const&, u64) const
+{
+    return m_state.with([&](auto& state) { return unreaped_completion_count(state) > 0; });
+}
+
+ErrorOr<NonnullLockRefPtr<Memory::VMObject>> IORing::vmobject_for_mmap(Process&, Memory::VirtualRange const& range, u64& offset, bool shared)
+{
+    if (offset != 0 || !shared || range.size() > m_region->size())
+        return EINVAL;
+    return m_vmobject;
+}
+
+ErrorOr<NonnullOwnPtr<KString>> IORing::pseudo_path(OpenFileDescription const&) const
+{
+    return KString::formatted("IORing:({})", m_submission_entries);
+}
+
+}
@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/AtomicRefCounted.h>
+#include <AK/IntrusiveList.h>
+#include <Kernel/API/IORing.h>
+#include <Kernel/FileSystem/File.h>
+#include <Kernel/Library/LockWeakPtr.h>
+#include <Kernel/Locking/Mutex.h>
+#include <Kernel/Locking/SpinlockProtected.h>
+#include <Kernel/Memory/Region.h>
+#include <Kernel/Tasks/WaitQueue.h>
+
+namespace Kernel {
+
+// A submission that couldn't be completed right away.
+class IORingRequest final
+    : public AtomicRefCounted<IORingRequest>
+    , public FileStateObserver {
+public:
+    virtual ~IORingRequest() override = default;
+
+    virtual void file_state_may_have_changed() override;
+
+private:
+    friend class IORing;
+
+    IORingRequest(IORing&, NonnullRefPtr<OpenFileDescription>, IORingSubmission const&, u32 exec_generation, WorkQueue&);
+
+    // Requests that wait for their file to become ready observe it, and are retried from the work queue.
+    bool waits_for_readiness() const;
+    Thread::FileBlocker::BlockFlags block_flags() const;
+    bool may_be_ready() const;
+
+    void queue_retry();
+
+    LockWeakPtr<IORing> m_ring;
+    NonnullRefPtr<OpenFileDescription> m_description;
+    IORingSubmission const m_submission;
+    // The buffers belong to the program that was running when the request was submitted.
+    u32 const m_exec_generation { 0 };
+    // All retries of a request go to the same work queue, so they never run at the same time.
+    WorkQueue& m_work_queue;
+    // Set once a connection has been started, so retries only look at how it went.
+    bool m_connect_started { false };
+
+    // Set while a retry sits in the work queue, so state changes in the meantime don't queue another one.
+    Atomic<bool> m_retry_is_queued { false };
+    // Set once the request has been completed or cancelled. A request that is finished is never put in the pending list.
+    Atomic<bool> m_is_finished { false };
+
+    IntrusiveListNode<IORingRequest, RefPtr<IORingRequest>> m_pending_list_node;
+
+public:
+    using PendingList = IntrusiveList<&IORingRequest::m_pending_list_node>;
+};
+
+// The kernel side of an I/O ring (see Kernel/API/IORing.h).
+// Submissions are picked up by io_ring_enter(). Requests on sockets and pipes that are ready are done right there,
+// the ones that aren't ready yet wait for their file's state to change and are retried from a work queue.
+// Requests that would block on something else, like the disk, are done from the work queue as well.
+class IORing final : public File {
+public:
+    static ErrorOr<NonnullRefPtr<IORing>> try_create(Process&, u32 entries);
+    virtual ~IORing() override;
+
+    IORingParameters parameters() const;
+
+    // Starts up to `count` submissions and waits until at least `minimum_completions` completions can be reaped.
+    ErrorOr<size_t> enter(Process&, u32 count, u32 minimum_completions);
+
+    bool is_owned_by(Process const&) const;
+    // Cancels the requests of the program that is being replaced, and waits for the ones that are being done right now.
+    void cancel_requests_for_exec();
+
+    // ^File
+    virtual bool can_read(OpenFileDescription const&, u64) const override;
+    virtual ErrorOr<size_t> read(OpenFileDescription&, u64, UserOrKernelBuffer&, size_t) override { return EINVAL; }
+    virtual bool can_write(OpenFileDescription const&, u64) const override { return false; }
+    virtual ErrorOr<size_t> write(OpenFileDescription&, u64, UserOrKernelBuffer const&, size_t) override { return EINVAL; }
+    virtual ErrorOr<NonnullLockRefPtr<Memory::VMObject>> vmobject_for_mmap(Process&, Memory::VirtualRange const&, u64& offset, bool shared) override;
+    virtual ErrorOr<NonnullOwnPtr<KString>> pseudo_path(OpenFileDescription const&) const override;
+    virtual StringView class_name() const override { return "IORing"sv; }
+    virtual bool is_io_ring() const override { return true; }
+
+private:
+    friend class IORingRequest;
+
+    IORing(LockWeakPtr<Process>, u32 submission_entries, NonnullLockRefPtr<Memory::AnonymousVMObject>, NonnullOwnPtr<Memory::Region>);
+
+    struct State {
+        IORingRequest::PendingList pending_requests;
+        // Requests that have been submitted, but haven't posted their completion yet.
+        u32 in_flight_count { 0 };
+        // Requests that are being done from a work queue right now.
+        u32 performing_count { 0 };
+        u32 completion_tail { 0 };
+    };
+
+    IORingHeader volatile& header() const { return *reinterpret_cast<IORingHeader volatile*>(m_region->vaddr().as_ptr()); }
+    IORingSubmission volatile* submissions() const;
+    IORingCompletion volatile* completions() const;
+    u32 unreaped_completion_count(State const&) const;
+
+    void submit(Process&, IORingSubmission const&);
+    void start_on_work_queue(NonnullRefPtr<IORingRequest>);
+    void park(NonnullRefPtr<IORingRequest>);
+    void retry(IORingRequest&);
+    bool begin_performing(Process const&, IORingRequest const&);
+    void end_performing();
+    void finish(IORingRequest&, ErrorOr<size_t>);
+    void post_completion(u64 user_data, i32 result);
+
+    static ErrorOr<size_t> perform(Process&, IORingRequest&);
+
+    LockWeakPtr<Process> m_process;
+    u32 const m_submission_entries { 0 };
+    u32 const m_completion_entries { 0 };
+    NonnullLockRefPtr<Memory::AnonymousVMObject> m_vmobject;
+    // The shared memory, as seen by the kernel.
+    NonnullOwnPtr<Memory::Region> m_region;
+
+    Mutex m_submission_lock { "IORing"sv };
+    u32 m_submission_head { 0 };
+
+    SpinlockProtected<State, LockRank::None> m_state {};
+    WaitQueue m_completion_wait_queue;
+    WaitQueue m_performing_wait_queue;
+
+    Atomic<u32> m_next_work_queue { 0 };
+};
+
+}
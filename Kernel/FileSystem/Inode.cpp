@@ -10,6 +10,7 @@
 #include <AK/StringView.h>
 #include <Kernel/API/InodeWatcherEvent.h>
 #include <Kernel/FileSystem/Custody.h>
+#include <Kernel/FileSystem/DirectoryEntryCache.h>
 #include <Kernel/FileSystem/Inode.h>
 #include <Kernel/FileSystem/InodeWatcher.h>
 #include <Kernel/FileSystem/OpenFileDescription.h>
@@ -18,6 +19,7 @@
 #include <Kernel/Memory/SharedInodeVMObject.h>
 #include <Kernel/Net/LocalSocket.h>
 #include <Kernel/Tasks/Process.h>
+#include <Kernel/Tasks/WorkQueue.h>
 
 namespace Kernel {
 
@@ -94,15 +96,87 @@ ErrorOr<size_t> Inode::write_bytes(off_t offset, size_t length, UserOrKernelBuff
 {
     MutexLocker locker(m_inode_lock);
     TRY(prepare_to_write_data());
-    return write_bytes_locked(offset, length, target_buffer, open_description);
+
+    auto nwritten = TRY(write_bytes_locked(offset, length, target_buffer, open_description));
+    auto shared_vmobject = m_shared_vmobject.strong_ref();
+    if (!shared_vmobject)
+        return nwritten;
+
+    // Keep the pages of a shared mapping of this file in sync with what was just written, as read() will prefer them.
+    // They are refreshed from the file system rather than from the buffer, so that the two can't end up with
+    // different data if another thread changed the buffer while we were writing it.
+    u8 page_buffer[PAGE_SIZE];
+    auto end = static_cast<size_t>(offset) + nwritten;
+    for (auto position = static_cast<size_t>(offset); position < end;) {
+        auto page_index = position / PAGE_SIZE;
+        auto offset_in_page = position % PAGE_SIZE;
+        auto count = min(PAGE_SIZE - offset_in_page, end - position);
+        if (shared_vmobject->is_page_resident(page_index)) {
+            auto buffer = UserOrKernelBuffer::for_kernel_buffer(page_buffer);
+            auto nread = TRY(read_bytes_locked(position, count, buffer, open_description));
+            shared_vmobject->write_to_resident_page(page_index, offset_in_page, ReadonlyBytes { page_buffer, nread });
+        }
+        position += count;
+    }
+    return nwritten;
+}
+
+ErrorOr<void> Inode::resize_contents(u64 size)
+{
+    // Hold the lock throughout, so that read() can't pick up what the mapping has past the new end in between.
+    MutexLocker locker(m_inode_lock);
+    TRY(truncate(size));
+    if (auto shared_vmobject = m_shared_vmobject.strong_ref())
+        shared_vmobject->discard_contents_past(size);
+    return {};
 }
 
 ErrorOr<size_t> Inode::read_bytes(off_t offset, size_t length, UserOrKernelBuffer& buffer, OpenFileDescription* open_description) const
 {
+    if (auto shared_vmobject = m_shared_vmobject.strong_ref(); shared_vmobject && !(open_description && open_description->is_direct()))
+        return read_bytes_through_shared_vmobject(*shared_vmobject, offset, length, buffer, open_description);
+
     MutexLocker locker(m_inode_lock, Mutex::Mode::Shared);
     return read_bytes_locked(offset, length, buffer, open_description);
 }
 
+ErrorOr<size_t> Inode::read_bytes_through_shared_vmobject(Memory::SharedInodeVMObject const& shared_vmobject, off_t offset, size_t length, UserOrKernelBuffer& buffer, OpenFileDescription* open_description) const
+{
+    // NOTE: Some file systems take the inode lock to get the metadata, so we need to get the size before locking.
+    auto file_size = static_cast<off_t>(size());
+    MutexLocker locker(m_inode_lock, Mutex::Mode::Shared);
+
+    // Copy whatever is already mapped into memory from there, and go to the file system for the rest.
+    // This way the file system doesn't end up caching a second copy of the mapped parts of the file.
+    u8 page_buffer[PAGE_SIZE];
+    size_t nread = 0;
+    while (nread < length && offset + static_cast<off_t>(nread) < file_size) {
+        auto position = offset + nread;
+        auto page_index = position / PAGE_SIZE;
+        auto offset_in_page = position % PAGE_SIZE;
+        auto count = min(min(PAGE_SIZE - offset_in_page, length - nread), static_cast<size_t>(file_size - position));
+
+        auto buffer_offset = buffer.offset(nread);
+        if (shared_vmobject.read_from_resident_page(page_index, offset_in_page, Bytes { page_buffer, count })) {
+            TRY(buffer_offset.write(page_buffer, count));
+            nread += count;
+            continue;
+        }
+
+        // Read everything up to the next resident page in one go.
+        auto last_page_index = page_index + 1;
+        while (last_page_index * PAGE_SIZE < offset + length && !shared_vmobject.is_page_resident(last_page_index))
+            ++last_page_index;
+        count = min(last_page_index * PAGE_SIZE, offset + length) - position;
+
+        auto nread_from_file_system = TRY(read_bytes_locked(position, count, buffer_offset, open_description));
+        nread += nread_from_file_system;
+        if (nread_from_file_system < count)
+            break;
+    }
+    return nread;
+}
+
 ErrorOr<size_t> Inode::read_until_filled_or_end(off_t offset, size_t length, UserOrKernelBuffer buffer, OpenFileDescription* open_description) const
 {
     auto remaining_length = length;
@@ -118,6 +192,17 @@ ErrorOr<size_t> Inode::read_until_filled_or_end(off_t offset, size_t length, Use
     return length - remaining_length;
 }
 
+void Inode::queue_read_ahead(u64 offset, size_t size)
+{
+    if (!can_read_ahead() || size == 0)
+        return;
+
+    // NOTE: Read-ahead is only a hint, so there's nothing to be done if we can't queue it.
+    (void)g_read_ahead_work->try_queue([inode = NonnullRefPtr<Inode>(*this), offset, size] {
+        inode->read_ahead(offset, size);
+    });
+}
+
 ErrorOr<void> Inode::update_timestamps([[maybe_unused]] Optional<UnixDateTime> atime, [[maybe_unused]] Optional<UnixDateTime> ctime, [[maybe_unused]] Optional<UnixDateTime> mtime)
 {
     return ENOTIMPL;
@@ -216,6 +301,8 @@ void Inode::set_metadata_dirty(bool metadata_dirty)
 
 void Inode::did_add_child(InodeIdentifier, StringView name)
 {
+    DirectoryEntryCache::the().invalidate(identifier(), name);
+
     m_watchers.for_each([&](auto& watcher) {
         watcher->notify_inode_event({}, identifier(), InodeWatcherEvent::Type::ChildCreated, name);
     });
@@ -223,6 +310,8 @@ void Inode::did_add_child(InodeIdentifier, StringView name)
 
 void Inode::did_remove_child(InodeIdentifier, StringView name)
 {
+    DirectoryEntryCache::the().invalidate(identifier(), name);
+
     if (name == "." || name == "..") {
         // These are just aliases and are not interesting to userspace.
         return;
@@ -245,8 +334,27 @@ void Inode::did_modify_contents()
     });
 }
 
+void Inode::did_replace_child(InodeIdentifier, StringView name)
+{
+    DirectoryEntryCache::the().invalidate(identifier(), name);
+
+    if (name == "." || name == "..") {
+        // These are just aliases and are not interesting to userspace.
+        return;
+    }
+
+    // To watchers, the old child went away and a new one took its name.
+    m_watchers.for_each([&](auto& watcher) {
+        watcher->notify_inode_event({}, identifier(), InodeWatcherEvent::Type::ChildDeleted, name);
+        watcher->notify_inode_event({}, identifier(), InodeWatcherEvent::Type::ChildCreated, name);
+    });
+}
+
 void Inode::did_delete_self()
 {
+    // Our index may be handed out again, so nothing that was cached about our children may survive us.
+    DirectoryEntryCache::the().invalidate_directory(identifier());
+
     m_watchers.for_each([&](auto& watcher) {
         watcher->notify_inode_event({}, identifier(), InodeWatcherEvent::Type::Deleted);
     });
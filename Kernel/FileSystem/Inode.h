@@ -57,6 +57,13 @@ public:
     ErrorOr<size_t> read_bytes(off_t, size_t, UserOrKernelBuffer& buffer, OpenFileDescription*) const;
     ErrorOr<size_t> read_until_filled_or_end(off_t, size_t, UserOrKernelBuffer buffer, OpenFileDescription*) const;
 
+    // Starts bringing [offset, offset + size) into the file system's cache in the background, so it's there by the
+    // time someone reads it. This is only a hint, and is silently dropped by file systems that can't make use of it.
+    void queue_read_ahead(u64 offset, size_t size);
+
+    // Lets the file system forget whatever it has cached of [offset, offset + size), except for data that still has to be written back.
+    virtual void drop_cached_range(u64, size_t) { }
+
     virtual ErrorOr<void> attach(OpenFileDescription&) { return {}; }
     virtual void detach(OpenFileDescription&) { }
     virtual void did_seek(OpenFileDescription&, off_t) { }
@@ -71,6 +78,8 @@ public:
     virtual ErrorOr<void> chmod(mode_t) = 0;
     virtual ErrorOr<void> chown(UserID, GroupID) = 0;
     virtual ErrorOr<void> truncate(u64) { return {}; }
+    // Like truncate(), but also keeps the pages of a shared mapping of this file in line with its new size.
+    ErrorOr<void> resize_contents(u64 size);
 
     ErrorOr<NonnullRefPtr<Custody>> resolve_as_link(Credentials const&, Custody& base, RefPtr<Custody>* out_parent, int options, int symlink_recursion_level) const;
 
@@ -116,6 +125,7 @@ protected:
 
     void did_add_child(InodeIdentifier child_id, StringView);
     void did_remove_child(InodeIdentifier child_id, StringView);
+    void did_replace_child(InodeIdentifier child_id, StringView);
     void did_modify_contents();
     void did_delete_self();
 
@@ -124,8 +134,12 @@ protected:
     virtual ErrorOr<size_t> write_bytes_locked(off_t, size_t, UserOrKernelBuffer const& data, OpenFileDescription*) = 0;
     virtual ErrorOr<size_t> read_bytes_locked(off_t, size_t, UserOrKernelBuffer& buffer, OpenFileDescription*) const = 0;
 
+    virtual bool can_read_ahead() const { return false; }
+    virtual void read_ahead(u64, size_t) { }
+
 private:
     ErrorOr<bool> try_apply_flock(Process const&, OpenFileDescription const&, flock const&);
+    ErrorOr<size_t> read_bytes_through_shared_vmobject(Memory::SharedInodeVMObject const&, off_t, size_t, UserOrKernelBuffer& buffer, OpenFileDescription*) const;
 
     FileSystem& m_file_system;
     InodeIndex m_index { 0 };
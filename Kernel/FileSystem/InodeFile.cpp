@@ -31,6 +31,8 @@ ErrorOr<size_t> InodeFile::read(OpenFileDescription& description, u64 offset, Us
 
     auto nread = TRY(m_inode->read_bytes(offset, count, buffer, &description));
     if (nread > 0) {
+        if (auto read_ahead = description.did_read_for_read_ahead(offset, nread); read_ahead.has_value() && !description.is_direct())
+            m_inode->queue_read_ahead(read_ahead->offset, read_ahead->size);
         Thread::current()->did_file_read(nread);
         evaluate_block_conditions();
     }
@@ -95,7 +97,7 @@ ErrorOr<NonnullOwnPtr<KString>> InodeFile::pseudo_path(OpenFileDescription const
 
 ErrorOr<void> InodeFile::truncate(u64 size)
 {
-    TRY(m_inode->truncate(size));
+    TRY(m_inode->resize_contents(size));
     TRY(m_inode->update_timestamps({}, {}, kgettimeofday()));
     return {};
 }
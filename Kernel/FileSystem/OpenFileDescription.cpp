@@ -11,6 +11,7 @@
 #include <Kernel/Devices/TTY/MasterPTY.h>
 #include <Kernel/Devices/TTY/TTY.h>
 #include <Kernel/FileSystem/Custody.h>
+#include <Kernel/FileSystem/EventQueue.h>
 #include <Kernel/FileSystem/FIFO.h>
 #include <Kernel/FileSystem/InodeFile.h>
 #include <Kernel/FileSystem/InodeWatcher.h>
@@ -53,6 +54,9 @@ OpenFileDescription::OpenFileDescription(File& file)
 
 OpenFileDescription::~OpenFileDescription()
 {
+    if (m_state.with([](auto& state) { return state.is_registered_with_event_queue; }))
+        EventQueue::description_will_be_destroyed({}, *this);
+
     m_file->detach(*this);
     // FIXME: Should this error path be observed somehow?
     (void)m_file->close();
@@ -451,6 +455,11 @@ FileBlockerSet& OpenFileDescription::blocker_set()
     return m_file->blocker_set();
 }
 
+void OpenFileDescription::did_register_with_event_queue(Badge<EventQueue>)
+{
+    m_state.with([](auto& state) { state.is_registered_with_event_queue = true; });
+}
+
 ErrorOr<void> OpenFileDescription::apply_flock(Process const& process, Userspace<flock const*> lock, ShouldBlock should_block)
 {
     if (!m_inode)
@@ -499,6 +508,21 @@ bool OpenFileDescription::is_direct() const
     return m_state.with([](auto& state) { return state.direct; });
 }
 
+AccessPattern OpenFileDescription::access_pattern() const
+{
+    return m_state.with([](auto& state) { return state.read_ahead.access_pattern(); });
+}
+
+void OpenFileDescription::set_access_pattern(AccessPattern access_pattern)
+{
+    m_state.with([&](auto& state) { state.read_ahead.set_access_pattern(access_pattern); });
+}
+
+Optional<ReadAheadRange> OpenFileDescription::did_read_for_read_ahead(u64 offset, size_t count)
+{
+    return m_state.with([&](auto& state) { return state.read_ahead.did_read(offset, count); });
+}
+
 bool OpenFileDescription::is_directory() const
 {
     return m_state.with([](auto& state) { return state.is_directory; });
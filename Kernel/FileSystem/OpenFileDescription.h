@@ -13,6 +13,7 @@
 #include <Kernel/FileSystem/FIFO.h>
 #include <Kernel/FileSystem/Inode.h>
 #include <Kernel/FileSystem/InodeMetadata.h>
+#include <Kernel/FileSystem/ReadAheadState.h>
 #include <Kernel/Forward.h>
 #include <Kernel/Library/KBuffer.h>
 #include <Kernel/Memory/VirtualAddress.h>
@@ -63,6 +64,13 @@ public:
 
     bool is_direct() const;
 
+    AccessPattern access_pattern() const;
+    void set_access_pattern(AccessPattern);
+
+    // Lets the description know that [offset, offset + count) was just read from it,
+    // and returns the range that should be read ahead of the reader, if any.
+    Optional<ReadAheadRange> did_read_for_read_ahead(u64 offset, size_t count);
+
     bool is_directory() const;
 
     File& file() { return *m_file; }
@@ -128,6 +136,8 @@ public:
 
     FileBlockerSet& blocker_set();
 
+    void did_register_with_event_queue(Badge<EventQueue>);
+
     ErrorOr<void> apply_flock(Process const&, Userspace<flock const*>, ShouldBlock);
     ErrorOr<void> get_flock(Userspace<flock*>) const;
 
@@ -156,7 +166,9 @@ private:
         bool is_directory : 1 { false };
         bool should_append : 1 { false };
         bool direct : 1 { false };
+        bool is_registered_with_event_queue : 1 { false };
         FIFO::Direction fifo_direction : 2 { FIFO::Direction::Neither };
+        ReadAheadState read_ahead;
     };
 
     SpinlockProtected<State, LockRank::None> m_state {};
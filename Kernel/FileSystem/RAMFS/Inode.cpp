@@ -84,7 +84,7 @@ ErrorOr<void> RAMFSInode::replace_child(StringView name, Inode& new_child)
 
     old_child->did_delete_self();
 
-    // TODO: Emit a did_replace_child event.
+    did_replace_child(new_child.identifier(), name);
 
     return {};
 }
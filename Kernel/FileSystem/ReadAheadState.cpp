@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/StdLibExtras.h>
+#include <Kernel/FileSystem/ReadAheadState.h>
+
+namespace Kernel {
+
+void ReadAheadState::set_access_pattern(AccessPattern access_pattern)
+{
+    m_access_pattern = access_pattern;
+    m_window_size = 0;
+    m_read_ahead_end = 0;
+}
+
+Optional<ReadAheadRange> ReadAheadState::did_read(u64 offset, size_t size)
+{
+    if (m_access_pattern == AccessPattern::Random)
+        return {};
+
+    bool is_sequential = offset == m_next_offset || m_access_pattern == AccessPattern::Sequential;
+    m_next_offset = offset + size;
+
+    if (!is_sequential) {
+        // The reader jumped somewhere else, so whatever we fetched ahead of it is probably not going to be used.
+        // Start over with a small window once it settles into reading sequentially again.
+        m_window_size = 0;
+        m_read_ahead_end = 0;
+        return {};
+    }
+
+    if (m_window_size == 0) {
+        m_window_size = m_access_pattern == AccessPattern::Sequential ? maximum_window_size : initial_window_size;
+        m_read_ahead_end = m_next_offset;
+    }
+
+    // Don't fetch more until the reader has made its way through half of what's already been fetched ahead of it.
+    if (m_read_ahead_end > m_next_offset && m_read_ahead_end - m_next_offset >= m_window_size / 2)
+        return {};
+
+    ReadAheadRange range { max(m_read_ahead_end, m_next_offset), m_window_size };
+    m_read_ahead_end = range.offset + range.size;
+    m_window_size = min(m_window_size * 2, maximum_window_size);
+    return range;
+}
+
+}
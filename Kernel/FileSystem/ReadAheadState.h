@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Optional.h>
+#include <AK/Types.h>
+
+namespace Kernel {
+
+// How a file (or a mapping of one) is expected to be accessed, as hinted by posix_fadvise() or madvise().
+enum class AccessPattern : u8 {
+    Normal,
+    Sequential,
+    Random,
+};
+
+struct ReadAheadRange {
+    u64 offset { 0 };
+    size_t size { 0 };
+};
+
+// Watches the reads made through a file description (or the faults taken in a mapping) for sequential access,
+// and decides how much of the file to fetch ahead of the reader. The window starts out small and doubles each
+// time the reader catches up with it, so short reads don't pull in data that's never going to be used.
+class ReadAheadState {
+public:
+    static constexpr size_t initial_window_size = 16 * KiB;
+    static constexpr size_t maximum_window_size = 256 * KiB;
+
+    AccessPattern access_pattern() const { return m_access_pattern; }
+    void set_access_pattern(AccessPattern);
+
+    // Returns the range that should be read ahead now that [offset, offset + size) has been read, if any.
+    Optional<ReadAheadRange> did_read(u64 offset, size_t size);
+
+private:
+    u64 m_next_offset { 0 };
+    u64 m_read_ahead_end { 0 };
+    size_t m_window_size { 0 };
+    AccessPattern m_access_pattern { AccessPattern::Normal };
+};
+
+}
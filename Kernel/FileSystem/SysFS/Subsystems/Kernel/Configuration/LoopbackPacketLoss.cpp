@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/StringView.h>
+#include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Configuration/LoopbackPacketLoss.h>
+#include <Kernel/Net/LoopbackAdapter.h>
+#include <Kernel/Sections.h>
+#include <Kernel/Tasks/Process.h>
+
+namespace Kernel {
+
+UNMAP_AFTER_INIT SysFSLoopbackPacketLoss::SysFSLoopbackPacketLoss(SysFSDirectory const& parent_directory)
+    : SysFSGlobalInformation(parent_directory)
+{
+}
+
+UNMAP_AFTER_INIT NonnullRefPtr<SysFSLoopbackPacketLoss> SysFSLoopbackPacketLoss::must_create(SysFSDirectory const& parent_directory)
+{
+    return adopt_ref_if_nonnull(new (nothrow) SysFSLoopbackPacketLoss(parent_directory)).release_nonnull();
+}
+
+ErrorOr<void> SysFSLoopbackPacketLoss::try_generate(KBufferBuilder& builder)
+{
+    return builder.appendff("{}\n", LoopbackAdapter::packet_loss_interval());
+}
+
+ErrorOr<size_t> SysFSLoopbackPacketLoss::write_bytes(off_t, size_t count, UserOrKernelBuffer const& buffer, OpenFileDescription*)
+{
+    MutexLocker locker(m_refresh_lock);
+    // NOTE: If we are in a jail, don't let the current process change the variable.
+    if (Process::current().is_currently_in_jail())
+        return Error::from_errno(EPERM);
+
+    char digits[16] {};
+    if (count == 0 || count > sizeof(digits))
+        return Error::from_errno(EINVAL);
+    TRY(buffer.read(digits, count));
+    auto interval = StringView { digits, count }.trim_whitespace().to_uint<u32>();
+    if (!interval.has_value())
+        return Error::from_errno(EINVAL);
+    LoopbackAdapter::set_packet_loss_interval(*interval);
+    return count;
+}
+
+ErrorOr<void> SysFSLoopbackPacketLoss::truncate(u64 size)
+{
+    if (size != 0)
+        return EPERM;
+    return {};
+}
+
+}
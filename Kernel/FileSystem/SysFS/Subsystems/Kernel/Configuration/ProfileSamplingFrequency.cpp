@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/StringView.h>
+#include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Configuration/ProfileSamplingFrequency.h>
+#include <Kernel/Sections.h>
+#include <Kernel/Tasks/Process.h>
+#include <Kernel/Tasks/SamplingProfiler.h>
+
+namespace Kernel {
+
+UNMAP_AFTER_INIT SysFSProfileSamplingFrequency::SysFSProfileSamplingFrequency(SysFSDirectory const& parent_directory)
+    : SysFSGlobalInformation(parent_directory)
+{
+}
+
+UNMAP_AFTER_INIT NonnullRefPtr<SysFSProfileSamplingFrequency> SysFSProfileSamplingFrequency::must_create(SysFSDirectory const& parent_directory)
+{
+    return adopt_ref_if_nonnull(new (nothrow) SysFSProfileSamplingFrequency(parent_directory)).release_nonnull();
+}
+
+ErrorOr<void> SysFSProfileSamplingFrequency::try_generate(KBufferBuilder& builder)
+{
+    return builder.appendff("{}\n", SamplingProfiler::frequency());
+}
+
+ErrorOr<size_t> SysFSProfileSamplingFrequency::write_bytes(off_t, size_t count, UserOrKernelBuffer const& buffer, OpenFileDescription*)
+{
+    MutexLocker locker(m_refresh_lock);
+    // NOTE: If we are in a jail, don't let the current process change the variable.
+    if (Process::current().is_currently_in_jail())
+        return Error::from_errno(EPERM);
+
+    char digits[16] {};
+    if (count == 0 || count > sizeof(digits))
+        return Error::from_errno(EINVAL);
+    TRY(buffer.read(digits, count));
+    auto frequency = StringView { digits, count }.trim_whitespace().to_uint<u32>();
+    if (!frequency.has_value())
+        return Error::from_errno(EINVAL);
+    TRY(SamplingProfiler::set_frequency(*frequency));
+    return count;
+}
+
+ErrorOr<void> SysFSProfileSamplingFrequency::truncate(u64 size)
+{
+    if (size != 0)
+        return EPERM;
+    return {};
+}
+
+}
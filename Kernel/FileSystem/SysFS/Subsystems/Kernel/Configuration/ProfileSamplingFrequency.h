@@ -0,0 +1,36 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/RefPtr.h>
+#include <AK/Types.h>
+#include <Kernel/FileSystem/SysFS/Subsystems/Kernel/GlobalInformation.h>
+#include <Kernel/Library/KBufferBuilder.h>
+#include <Kernel/Library/UserOrKernelBuffer.h>
+
+namespace Kernel {
+
+// How many times a second SamplingProfiler samples every processor, or 0 if it doesn't.
+class SysFSProfileSamplingFrequency final : public SysFSGlobalInformation {
+public:
+    virtual StringView name() const override { return "profile_sampling_frequency"sv; }
+
+    static NonnullRefPtr<SysFSProfileSamplingFrequency> must_create(SysFSDirectory const&);
+
+private:
+    explicit SysFSProfileSamplingFrequency(SysFSDirectory const&);
+
+    // ^SysFSGlobalInformation
+    virtual ErrorOr<void> try_generate(KBufferBuilder&) override;
+
+    // ^SysFSExposedComponent
+    virtual ErrorOr<size_t> write_bytes(off_t, size_t, UserOrKernelBuffer const&, OpenFileDescription*) override;
+    virtual mode_t permissions() const override { return S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH; }
+    virtual ErrorOr<void> truncate(u64) override;
+};
+
+}
@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/JsonObjectSerializer.h>
+#include <Kernel/FileSystem/DirectoryEntryCache.h>
+#include <Kernel/FileSystem/SysFS/Subsystems/Kernel/DirectoryEntryCache.h>
+#include <Kernel/Sections.h>
+
+namespace Kernel {
+
+UNMAP_AFTER_INIT SysFSDirectoryEntryCacheStatistics::SysFSDirectoryEntryCacheStatistics(SysFSDirectory const& parent_directory)
+    : SysFSGlobalInformation(parent_directory)
+{
+}
+
+UNMAP_AFTER_INIT NonnullRefPtr<SysFSDirectoryEntryCacheStatistics> SysFSDirectoryEntryCacheStatistics::must_create(SysFSDirectory const& parent_directory)
+{
+    return adopt_ref_if_nonnull(new (nothrow) SysFSDirectoryEntryCacheStatistics(parent_directory)).release_nonnull();
+}
+
+ErrorOr<void> SysFSDirectoryEntryCacheStatistics::try_generate(KBufferBuilder& builder)
+{
+    auto statistics = DirectoryEntryCache::the().statistics();
+    auto json = TRY(JsonObjectSerializer<>::try_create(builder));
+    TRY(json.add("hits"sv, statistics.hits));
+    TRY(json.add("negative_hits"sv, statistics.negative_hits));
+    TRY(json.add("misses"sv, statistics.misses));
+    TRY(json.add("evictions"sv, statistics.evictions));
+    TRY(json.add("invalidations"sv, statistics.invalidations));
+    TRY(json.add("entries"sv, statistics.entries));
+    TRY(json.add("negative_entries"sv, statistics.negative_entries));
+    TRY(json.add("capacity"sv, statistics.capacity));
+    TRY(json.finish());
+    return {};
+}
+
+}
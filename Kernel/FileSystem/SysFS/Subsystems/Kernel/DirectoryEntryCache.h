@@ -0,0 +1,30 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/RefPtr.h>
+#include <AK/Types.h>
+#include <Kernel/FileSystem/SysFS/Subsystems/Kernel/GlobalInformation.h>
+#include <Kernel/Library/KBufferBuilder.h>
+#include <Kernel/Library/UserOrKernelBuffer.h>
+
+namespace Kernel {
+
+class SysFSDirectoryEntryCacheStatistics final : public SysFSGlobalInformation {
+public:
+    virtual StringView name() const override { return "directory_entry_cache"sv; }
+
+    static NonnullRefPtr<SysFSDirectoryEntryCacheStatistics> must_create(SysFSDirectory const& parent_directory);
+
+private:
+    explicit SysFSDirectoryEntryCacheStatistics(SysFSDirectory const& parent_directory);
+    virtual ErrorOr<void> try_generate(KBufferBuilder& builder) override;
+
+    virtual bool is_readable_by_jailed_processes() const override { return true; }
+};
+
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/JsonObjectSerializer.h>
+#include <Kernel/FileSystem/SysFS/Subsystems/Kernel/LockStatistics.h>
+#include <Kernel/Locking/LockStatistics.h>
+#include <Kernel/Sections.h>
+#include <Kernel/Tasks/Process.h>
+
+#if LOCK_STATISTICS
+
+namespace Kernel {
+
+UNMAP_AFTER_INIT SysFSLockStatistics::SysFSLockStatistics(SysFSDirectory const& parent_directory)
+    : SysFSGlobalInformation(parent_directory)
+{
+}
+
+UNMAP_AFTER_INIT NonnullRefPtr<SysFSLockStatistics> SysFSLockStatistics::must_create(SysFSDirectory const& parent_directory)
+{
+    return adopt_ref_if_nonnull(new (nothrow) SysFSLockStatistics(parent_directory)).release_nonnull();
+}
+
+static StringView lock_type_to_string(LockStatistics::Type type)
+{
+    switch (type) {
+    case LockStatistics::Type::Spinlock:
+        return "Spinlock"sv;
+    case LockStatistics::Type::RecursiveSpinlock:
+        return "RecursiveSpinlock"sv;
+    case LockStatistics::Type::Mutex:
+        return "Mutex"sv;
+    }
+    VERIFY_NOT_REACHED();
+}
+
+ErrorOr<void> SysFSLockStatistics::try_generate(KBufferBuilder& builder)
+{
+    auto object = TRY(JsonObjectSerializer<>::try_create(builder));
+    TRY(object.add("untracked"sv, LockStatistics::untracked_acquisitions()));
+    auto array = TRY(object.add_array("locks"sv));
+    TRY(LockStatistics::try_for_each_lock([&](auto const& lock) -> ErrorOr<void> {
+        auto lock_object = TRY(array.add_object());
+        TRY(lock_object.add("address"sv, lock.address));
+        TRY(lock_object.add("type"sv, lock_type_to_string(lock.type)));
+        TRY(lock_object.add("rank"sv, to_underlying(lock.rank)));
+        TRY(lock_object.add("name"sv, lock.name));
+        TRY(lock_object.add("acquisitions"sv, lock.acquisitions));
+        TRY(lock_object.add("contended"sv, lock.contended_acquisitions));
+        TRY(lock_object.add("total_wait"sv, lock.total_wait));
+        TRY(lock_object.add("max_wait"sv, lock.max_wait));
+        auto histogram_array = TRY(lock_object.add_array("histogram"sv));
+        for (auto count : lock.wait_histogram)
+            TRY(histogram_array.add(count));
+        TRY(histogram_array.finish());
+        auto call_sites_array = TRY(lock_object.add_array("call_sites"sv));
+        for (auto const& call_site : lock.call_sites) {
+            if (call_site.address == 0)
+                continue;
+            auto call_site_object = TRY(call_sites_array.add_object());
+            TRY(call_site_object.add("address"sv, call_site.address));
+            TRY(call_site_object.add("contended"sv, call_site.contended_acquisitions));
+            TRY(call_site_object.finish());
+        }
+        TRY(call_sites_array.finish());
+        TRY(lock_object.finish());
+        return {};
+    }));
+    TRY(array.finish());
+    TRY(object.finish());
+    return {};
+}
+
+ErrorOr<size_t> SysFSLockStatistics::write_bytes(off_t, size_t count, UserOrKernelBuffer const&, OpenFileDescription*)
+{
+    MutexLocker locker(m_refresh_lock);
+    // NOTE: If we are in a jail, don't let the current process reset the statistics.
+    if (Process::current().is_currently_in_jail())
+        return Error::from_errno(EPERM);
+    LockStatistics::reset();
+    return count;
+}
+
+ErrorOr<void> SysFSLockStatistics::truncate(u64 size)
+{
+    if (size != 0)
+        return EPERM;
+    return {};
+}
+
+mode_t SysFSLockStatistics::permissions() const
+{
+    return S_IRUSR | S_IWUSR;
+}
+
+}
+
+#endif
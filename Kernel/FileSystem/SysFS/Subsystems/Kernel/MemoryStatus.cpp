@@ -5,8 +5,10 @@
  */
 
 #include <AK/JsonObjectSerializer.h>
+#include <AK/Vector.h>
 #include <Kernel/FileSystem/SysFS/Subsystems/Kernel/MemoryStatus.h>
 #include <Kernel/Memory/MemoryManager.h>
+#include <Kernel/Memory/PageMerger.h>
 #include <Kernel/Sections.h>
 
 namespace Kernel {
@@ -26,6 +28,12 @@ ErrorOr<void> SysFSMemoryStatus::try_generate(KBufferBuilder& builder)
     kmalloc_stats stats;
     get_kmalloc_stats(stats);
 
+    // NOTE: Typed slab caches are set up on first use, so there may be more of them by the time we fill them in.
+    Vector<kmalloc_cache_stats> cache_stats;
+    TRY(cache_stats.try_resize(get_kmalloc_cache_stats(nullptr, 0)));
+    auto cache_count = get_kmalloc_cache_stats(cache_stats.data(), cache_stats.size());
+    cache_stats.shrink(min(cache_count, cache_stats.size()));
+
     auto system_memory = MM.get_system_memory_info();
 
     auto json = TRY(JsonObjectSerializer<>::try_create(builder));
@@ -35,8 +43,27 @@ ErrorOr<void> SysFSMemoryStatus::try_generate(KBufferBuilder& builder)
     TRY(json.add("physical_available"sv, system_memory.physical_pages - system_memory.physical_pages_used));
     TRY(json.add("physical_committed"sv, system_memory.physical_pages_committed));
     TRY(json.add("physical_uncommitted"sv, system_memory.physical_pages_uncommitted));
+    TRY(json.add("large_pages_mapped"sv, system_memory.large_pages_mapped));
+    TRY(json.add("large_page_allocations"sv, system_memory.large_page_allocations));
+    TRY(json.add("large_page_allocation_failures"sv, system_memory.large_page_allocation_failures));
+    TRY(json.add("merged_pages"sv, Memory::PageMerger::merged_page_count()));
+    TRY(json.add("merged_zero_pages"sv, Memory::PageMerger::merged_zero_page_count()));
     TRY(json.add("kmalloc_call_count"sv, stats.kmalloc_call_count));
     TRY(json.add("kfree_call_count"sv, stats.kfree_call_count));
+    auto slab_caches = TRY(json.add_array("slab_caches"sv));
+    for (auto const& cache : cache_stats) {
+        auto cache_object = TRY(slab_caches.add_object());
+        TRY(cache_object.add("name"sv, cache.name));
+        TRY(cache_object.add("object_size"sv, cache.object_size));
+        TRY(cache_object.add("bytes_allocated"sv, cache.bytes_allocated));
+        TRY(cache_object.add("bytes_free"sv, cache.bytes_free));
+        TRY(cache_object.add("objects_in_magazines"sv, cache.objects_in_magazines));
+        TRY(cache_object.add("allocation_count"sv, cache.allocation_count));
+        TRY(cache_object.add("free_count"sv, cache.free_count));
+        TRY(cache_object.add("magazine_hit_count"sv, cache.magazine_hit_count));
+        TRY(cache_object.finish());
+    }
+    TRY(slab_caches.finish());
     TRY(json.finish());
     return {};
 }
@@ -44,6 +44,10 @@ ErrorOr<void> SysFSNetworkAdaptersStats::try_generate(KBufferBuilder& builder)
         TRY(obj.add("link_speed"sv, adapter.link_speed()));
         TRY(obj.add("link_full_duplex"sv, adapter.link_full_duplex()));
         TRY(obj.add("mtu"sv, adapter.mtu()));
+        TRY(obj.add("transmit_checksum_offload"sv, adapter.has_offload(NetworkAdapter::Offload::TransmitChecksum)));
+        TRY(obj.add("receive_checksum_offload"sv, adapter.has_offload(NetworkAdapter::Offload::ReceiveChecksum)));
+        TRY(obj.add("tcp_segmentation_offload"sv, adapter.has_offload(NetworkAdapter::Offload::TCPSegmentation)));
+        TRY(obj.add("queue_pairs"sv, adapter.queue_pair_count()));
         TRY(obj.finish());
         return {};
     }));
@@ -11,6 +11,7 @@
 #include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Network/Adapters.h>
 #include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Network/Directory.h>
 #include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Network/Local.h>
+#include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Network/ReceiveWorkers.h>
 #include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Network/Route.h>
 #include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Network/TCP.h>
 #include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Network/UDP.h>
@@ -26,6 +27,7 @@ UNMAP_AFTER_INIT NonnullRefPtr<SysFSGlobalNetworkStatsDirectory> SysFSGlobalNetw
         list.append(SysFSNetworkRouteStats::must_create(*global_network_stats_directory));
         list.append(SysFSNetworkTCPStats::must_create(*global_network_stats_directory));
         list.append(SysFSLocalNetStats::must_create(*global_network_stats_directory));
+        list.append(SysFSNetworkReceiveWorkersStats::must_create(*global_network_stats_directory));
         list.append(SysFSNetworkUDPStats::must_create(*global_network_stats_directory));
         return {};
     }));
@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/JsonObjectSerializer.h>
+#include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Network/ReceiveWorkers.h>
+#include <Kernel/Net/NetworkTask.h>
+#include <Kernel/Sections.h>
+
+namespace Kernel {
+
+UNMAP_AFTER_INIT SysFSNetworkReceiveWorkersStats::SysFSNetworkReceiveWorkersStats(SysFSDirectory const& parent_directory)
+    : SysFSGlobalInformation(parent_directory)
+{
+}
+
+UNMAP_AFTER_INIT NonnullRefPtr<SysFSNetworkReceiveWorkersStats> SysFSNetworkReceiveWorkersStats::must_create(SysFSDirectory const& parent_directory)
+{
+    return adopt_ref_if_nonnull(new (nothrow) SysFSNetworkReceiveWorkersStats(parent_directory)).release_nonnull();
+}
+
+ErrorOr<void> SysFSNetworkReceiveWorkersStats::try_generate(KBufferBuilder& builder)
+{
+    auto array = TRY(JsonArraySerializer<>::try_create(builder));
+    TRY(NetworkTask::try_for_each_receive_worker([&array](auto& worker) -> ErrorOr<void> {
+        auto obj = TRY(array.add_object());
+        TRY(obj.add("processor"sv, worker.processor));
+        TRY(obj.add("packets"sv, worker.packets));
+        TRY(obj.add("bytes"sv, worker.bytes));
+        TRY(obj.add("wakeups"sv, worker.wakeups));
+        TRY(obj.finish());
+        return {};
+    }));
+    TRY(array.finish());
+    return {};
+}
+
+}
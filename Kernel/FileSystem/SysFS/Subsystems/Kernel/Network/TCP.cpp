@@ -41,6 +41,23 @@ ErrorOr<void> SysFSNetworkTCPStats::try_generate(KBufferBuilder& builder)
         TRY(obj.add("bytes_in"sv, socket.bytes_in()));
         TRY(obj.add("packets_out"sv, socket.packets_out()));
         TRY(obj.add("bytes_out"sv, socket.bytes_out()));
+        TRY(obj.add("congestion_control"sv, TCPSocket::to_string(socket.congestion_control())));
+        TRY(obj.add("mss"sv, socket.send_mss()));
+        TRY(obj.add("congestion_window"sv, socket.congestion_window()));
+        TRY(obj.add("slow_start_threshold"sv, socket.slow_start_threshold()));
+        TRY(obj.add("send_window"sv, socket.send_window_size()));
+        TRY(obj.add("receive_window"sv, socket.receive_window_size()));
+        TRY(obj.add("send_window_scale"sv, socket.send_window_shift()));
+        TRY(obj.add("receive_window_scale"sv, socket.receive_window_shift()));
+        TRY(obj.add("sack_permitted"sv, socket.is_sack_permitted()));
+        if (auto round_trip_time = socket.smoothed_round_trip_time(); round_trip_time.has_value()) {
+            TRY(obj.add("round_trip_time_us"sv, round_trip_time->to_microseconds()));
+            TRY(obj.add("round_trip_time_variance_us"sv, socket.round_trip_time_variance().to_microseconds()));
+        }
+        TRY(obj.add("retransmission_timeout_ms"sv, socket.retransmission_timeout().to_milliseconds()));
+        TRY(obj.add("retransmitted_packets"sv, socket.retransmitted_packets()));
+        TRY(obj.add("fast_retransmits"sv, socket.fast_retransmits()));
+        TRY(obj.add("retransmission_timeouts"sv, socket.retransmission_timeouts()));
         auto current_process_credentials = Process::current().credentials();
         if (current_process_credentials->is_superuser() || current_process_credentials->uid() == socket.origin_uid()) {
             TRY(obj.add("origin_pid"sv, socket.origin_pid().value()));
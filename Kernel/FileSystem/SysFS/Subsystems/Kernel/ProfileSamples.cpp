@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/JsonObjectSerializer.h>
+#include <Kernel/FileSystem/SysFS/Subsystems/Kernel/ProfileSamples.h>
+#include <Kernel/Sections.h>
+#include <Kernel/Tasks/SamplingProfiler.h>
+
+namespace Kernel {
+
+UNMAP_AFTER_INIT SysFSProfileSamples::SysFSProfileSamples(SysFSDirectory const& parent_directory)
+    : SysFSGlobalInformation(parent_directory)
+{
+}
+
+UNMAP_AFTER_INIT NonnullRefPtr<SysFSProfileSamples> SysFSProfileSamples::must_create(SysFSDirectory const& parent_directory)
+{
+    return adopt_ref_if_nonnull(new (nothrow) SysFSProfileSamples(parent_directory)).release_nonnull();
+}
+
+ErrorOr<void> SysFSProfileSamples::try_generate(KBufferBuilder& builder)
+{
+    auto object = TRY(JsonObjectSerializer<>::try_create(builder));
+    TRY(object.add("frequency"sv, SamplingProfiler::frequency()));
+    TRY(object.add("dropped"sv, SamplingProfiler::dropped_sample_count()));
+    auto array = TRY(object.add_array("samples"sv));
+    TRY(SamplingProfiler::drain([&](auto const& sample) -> ErrorOr<void> {
+        auto sample_object = TRY(array.add_object());
+        TRY(sample_object.add("timestamp"sv, sample.timestamp_ns));
+        TRY(sample_object.add("pid"sv, sample.pid));
+        TRY(sample_object.add("tid"sv, sample.tid));
+        TRY(sample_object.add("cpu"sv, sample.processor));
+        TRY(sample_object.add("kernel_frames"sv, sample.kernel_frame_count));
+        auto stack_array = TRY(sample_object.add_array("stack"sv));
+        for (size_t i = 0; i < sample.frame_count; ++i)
+            TRY(stack_array.add(sample.frames[i]));
+        TRY(stack_array.finish());
+        TRY(sample_object.finish());
+        return {};
+    }));
+    TRY(array.finish());
+    TRY(object.finish());
+    return {};
+}
+
+mode_t SysFSProfileSamples::permissions() const
+{
+    return S_IRUSR;
+}
+
+}
@@ -21,6 +21,7 @@ class Custody;
 class Device;
 class DiskCache;
 class DoubleBuffer;
+class EventQueue;
 class File;
 class FATInode;
 class OpenFileDescription;
@@ -31,6 +32,8 @@ class IPv4Socket;
 class Inode;
 class InodeIdentifier;
 class InodeWatcher;
+class IORing;
+class IORingRequest;
 class MountFile;
 class Jail;
 class KBuffer;
@@ -10,6 +10,7 @@
 #include <Kernel/Debug.h>
 #include <Kernel/Heap/Heap.h>
 #include <Kernel/Heap/kmalloc.h>
+#include <Kernel/Interrupts/InterruptDisabler.h>
 #include <Kernel/KSyms.h>
 #include <Kernel/Library/Panic.h>
 #include <Kernel/Library/StdLib.h>
@@ -81,6 +82,13 @@ public:
         m_freelist = freelist_entry;
     }
 
+    static KmallocSlabBlock& from_slab(void* ptr)
+    {
+        return *(KmallocSlabBlock*)((FlatPtr)ptr & block_mask);
+    }
+
+    size_t slab_size() const { return m_slab_size; }
+
     bool is_full() const
     {
         return m_freelist == nullptr;
@@ -146,11 +154,11 @@ public:
         return ptr;
     }
 
+    // NOTE: The slab has already been scrubbed when it was put into a magazine.
     void deallocate(void* ptr)
     {
-        memset(ptr, KFREE_SCRUB_BYTE, m_slab_size);
-
-        auto* block = (KmallocSlabBlock*)((FlatPtr)ptr & KmallocSlabBlock::block_mask);
+        auto* block = &KmallocSlabBlock::from_slab(ptr);
+        VERIFY(block->slab_size() == m_slab_size);
         bool block_was_full = block->is_full();
         block->deallocate(ptr);
         if (block_was_full)
@@ -191,7 +199,7 @@ public:
             ++block;
             block_to_remove.list_node.remove();
             block_to_remove.~KmallocSlabBlock();
-            kfree_sized(&block_to_remove, KmallocSlabBlock::block_size);
+            kfree_aligned(&block_to_remove, KmallocSlabBlock::block_size, KmallocSlabBlock::block_size);
 
             did_purge = true;
         }
@@ -205,6 +213,144 @@ private:
     KmallocSlabBlock::List m_full_blocks;
 };
 
+// Each CPU keeps a magazine of free slabs for every slab cache, which lets most allocations and frees get by without
+// taking the kmalloc lock. Magazines are refilled from and drained to the slab heaps half a magazine at a time, so
+// that a CPU going back and forth around the boundary doesn't have to take the lock every time.
+struct KmallocMagazine {
+    static constexpr size_t capacity = 32;
+    static constexpr size_t batch_size = capacity / 2;
+
+    void* rounds[capacity];
+    size_t count { 0 };
+
+    // NOTE: These are only ever updated by the CPU that owns the magazine.
+    u64 allocation_count { 0 };
+    u64 free_count { 0 };
+    u64 hit_count { 0 };
+};
+
+class KmallocSlabCache {
+public:
+    KmallocSlabCache(char const* name, KmallocSlabheap& slabheap)
+        : m_name(name)
+        , m_slabheap(slabheap)
+    {
+    }
+
+    size_t slab_size() const { return m_slabheap.slab_size(); }
+
+    void* allocate(CallerWillInitializeMemory caller_will_initialize_memory)
+    {
+        void* ptr = nullptr;
+        {
+            InterruptDisabler disabler;
+            auto& magazine = m_magazines[Processor::current_id()];
+            if (magazine.count > 0)
+                ++magazine.hit_count;
+            else
+                refill(magazine);
+            if (magazine.count > 0) {
+                ptr = magazine.rounds[--magazine.count];
+                ++magazine.allocation_count;
+            }
+        }
+
+        if (ptr && caller_will_initialize_memory == CallerWillInitializeMemory::No)
+            memset(ptr, KMALLOC_SCRUB_BYTE, slab_size());
+        return ptr;
+    }
+
+    void deallocate(void* ptr)
+    {
+        memset(ptr, KFREE_SCRUB_BYTE, slab_size());
+
+        InterruptDisabler disabler;
+        auto& magazine = m_magazines[Processor::current_id()];
+        if (magazine.count == KmallocMagazine::capacity)
+            drain(magazine);
+        magazine.rounds[magazine.count++] = ptr;
+        ++magazine.free_count;
+    }
+
+    // NOTE: The counters of other CPUs can change while we add them up, so these are only ever a snapshot.
+    size_t objects_in_magazines() const
+    {
+        size_t total = 0;
+        for (auto const& magazine : m_magazines)
+            total += magazine.count;
+        return total;
+    }
+
+    u64 allocation_count() const
+    {
+        u64 total = 0;
+        for (auto const& magazine : m_magazines)
+            total += magazine.allocation_count;
+        return total;
+    }
+
+    u64 free_count() const
+    {
+        u64 total = 0;
+        for (auto const& magazine : m_magazines)
+            total += magazine.free_count;
+        return total;
+    }
+
+    // Must be called with s_lock held.
+    void fill_in_stats(kmalloc_cache_stats& stats) const
+    {
+        stats.name = m_name;
+        stats.object_size = slab_size();
+        stats.bytes_allocated = m_slabheap.allocated_bytes();
+        stats.bytes_free = m_slabheap.free_bytes();
+        stats.objects_in_magazines = objects_in_magazines();
+        stats.allocation_count = allocation_count();
+        stats.free_count = free_count();
+        stats.magazine_hit_count = 0;
+        for (auto const& magazine : m_magazines)
+            stats.magazine_hit_count += magazine.hit_count;
+    }
+
+private:
+    void refill(KmallocMagazine& magazine)
+    {
+        SpinlockLocker lock(s_lock);
+        while (magazine.count < KmallocMagazine::batch_size) {
+            auto* ptr = m_slabheap.allocate(CallerWillInitializeMemory::Yes);
+            if (!ptr)
+                break;
+            magazine.rounds[magazine.count++] = ptr;
+        }
+    }
+
+    void drain(KmallocMagazine& magazine)
+    {
+        SpinlockLocker lock(s_lock);
+        while (magazine.count > KmallocMagazine::capacity - KmallocMagazine::batch_size)
+            m_slabheap.deallocate(magazine.rounds[--magazine.count]);
+    }
+
+    char const* m_name { nullptr };
+    KmallocSlabheap& m_slabheap;
+    KmallocMagazine m_magazines[MAX_CPU_COUNT];
+};
+
+// The slab heap and cache behind a KmallocCache.
+struct KmallocTypedSlabCache {
+    KmallocTypedSlabCache(char const* name, size_t object_size)
+        : slabheap(round_up_to_power_of_two(max(object_size, sizeof(void*)), KMALLOC_DEFAULT_ALIGNMENT))
+        , cache(name, slabheap)
+    {
+    }
+
+    KmallocSlabheap slabheap;
+    KmallocSlabCache cache;
+
+    IntrusiveListNode<KmallocTypedSlabCache> list_node;
+    using List = IntrusiveList<&KmallocTypedSlabCache::list_node>;
+};
+
 struct KmallocGlobalData {
     static constexpr size_t minimum_subheap_size = 1 * MiB;
 
@@ -221,15 +367,22 @@ struct KmallocGlobalData {
         subheaps.append(*subheap);
     }
 
+    // NOTE: Small allocations with a large alignment end up in a bigger slab than their size suggests, or in a subheap
+    //       if no slab is aligned well enough. Frees therefore need the alignment the allocation was made with.
+    KmallocSlabCache* slab_cache_for(size_t size, size_t alignment)
+    {
+        for (auto& slab_cache : slab_caches) {
+            if (size <= slab_cache.slab_size() && alignment <= slab_cache.slab_size())
+                return &slab_cache;
+        }
+        return nullptr;
+    }
+
+    // NOTE: Allocations that fit into a slab go through the slab caches instead.
     void* allocate(size_t size, size_t alignment, CallerWillInitializeMemory caller_will_initialize_memory)
     {
         VERIFY(!expansion_in_progress);
 
-        for (auto& slabheap : slabheaps) {
-            if (size <= slabheap.slab_size() && alignment <= slabheap.slab_size())
-                return slabheap.allocate(caller_will_initialize_memory);
-        }
-
         for (auto& subheap : subheaps) {
             if (auto* ptr = subheap.allocator.allocate(size, alignment, caller_will_initialize_memory))
                 return ptr;
@@ -264,11 +417,6 @@ struct KmallocGlobalData {
         VERIFY(!expansion_in_progress);
         VERIFY(is_valid_kmalloc_address(VirtualAddress { ptr }));
 
-        for (auto& slabheap : slabheaps) {
-            if (size <= slabheap.slab_size())
-                return slabheap.deallocate(ptr);
-        }
-
         for (auto& subheap : subheaps) {
             if (subheap.allocator.contains(ptr)) {
                 subheap.allocator.deallocate(ptr);
@@ -279,6 +427,7 @@ struct KmallocGlobalData {
         PANIC("Bogus pointer passed to kfree_sized({:p}, {})", ptr, size);
     }
 
+    // NOTE: Slabs sitting in a magazine count as free.
     size_t allocated_bytes() const
     {
         size_t total = 0;
@@ -286,6 +435,8 @@ struct KmallocGlobalData {
             total += subheap.allocator.allocated_bytes();
         for (auto const& slabheap : slabheaps)
             total += slabheap.allocated_bytes();
+        for (auto const& slab_cache : slab_caches)
+            total -= slab_cache.objects_in_magazines() * slab_cache.slab_size();
         return total;
     }
 
@@ -296,6 +447,8 @@ struct KmallocGlobalData {
             total += subheap.allocator.free_bytes();
         for (auto const& slabheap : slabheaps)
             total += slabheap.free_bytes();
+        for (auto const& slab_cache : slab_caches)
+            total += slab_cache.objects_in_magazines() * slab_cache.slab_size();
         return total;
     }
 
@@ -395,6 +548,15 @@ struct KmallocGlobalData {
     KmallocSubheap::List subheaps;
 
     KmallocSlabheap slabheaps[6] = { 16, 32, 64, 128, 256, 512 };
+    KmallocSlabCache slab_caches[6] = {
+        { "kmalloc-16", slabheaps[0] },
+        { "kmalloc-32", slabheaps[1] },
+        { "kmalloc-64", slabheaps[2] },
+        { "kmalloc-128", slabheaps[3] },
+        { "kmalloc-256", slabheaps[4] },
+        { "kmalloc-512", slabheaps[5] },
+    };
+    KmallocTypedSlabCache::List typed_slab_caches;
 
     bool expansion_in_progress { false };
 };
@@ -404,7 +566,7 @@ alignas(KmallocGlobalData) static u8 g_kmalloc_global_heap[sizeof(KmallocGlobalD
 
 static size_t g_kmalloc_call_count;
 static size_t g_kfree_call_count;
-static size_t g_nested_kfree_calls;
+static size_t g_nested_kfree_calls[MAX_CPU_COUNT];
 bool g_dump_kmalloc_stacks;
 
 void kmalloc_enable_expand()
@@ -421,26 +583,16 @@ UNMAP_AFTER_INIT void kmalloc_init()
     s_lock.initialize();
 }
 
-static void* kmalloc_impl(size_t size, size_t alignment, CallerWillInitializeMemory caller_will_initialize_memory)
+static void verify_allocation_is_allowed()
 {
     // Catch bad callers allocating under spinlock.
     if constexpr (KMALLOC_VERIFY_NO_SPINLOCK_HELD) {
         Processor::verify_no_spinlocks_held();
     }
+}
 
-    // Alignment must be a power of two.
-    VERIFY(is_power_of_two(alignment));
-
-    SpinlockLocker lock(s_lock);
-    ++g_kmalloc_call_count;
-
-    if (g_dump_kmalloc_stacks && Kernel::g_kernel_symbols_available) {
-        dbgln("kmalloc({})", size);
-        Kernel::dump_backtrace();
-    }
-
-    void* ptr = g_kmalloc_global->allocate(size, alignment, caller_will_initialize_memory);
-
+static void record_kmalloc(size_t size, void* ptr)
+{
     Thread* current_thread = Thread::current();
     if (!current_thread)
         current_thread = Processor::idle_thread();
@@ -450,7 +602,50 @@ static void* kmalloc_impl(size_t size, size_t alignment, CallerWillInitializeMem
         VERIFY(current_thread->is_allocation_enabled());
         PerformanceManager::add_kmalloc_perf_event(*current_thread, size, (FlatPtr)ptr);
     }
+}
+
+static void record_kfree(void* ptr)
+{
+    InterruptDisabler disabler;
+    auto& nested_kfree_calls = g_nested_kfree_calls[Processor::current_id()];
+    ++nested_kfree_calls;
+
+    if (nested_kfree_calls == 1) {
+        Thread* current_thread = Thread::current();
+        if (!current_thread)
+            current_thread = Processor::idle_thread();
+        if (current_thread) {
+            VERIFY(current_thread->is_allocation_enabled());
+            PerformanceManager::add_kfree_perf_event(*current_thread, 0, (FlatPtr)ptr);
+        }
+    }
+
+    --nested_kfree_calls;
+}
 
+static void* kmalloc_impl(size_t size, size_t alignment, CallerWillInitializeMemory caller_will_initialize_memory)
+{
+    verify_allocation_is_allowed();
+
+    // Alignment must be a power of two.
+    VERIFY(is_power_of_two(alignment));
+
+    if (g_dump_kmalloc_stacks && Kernel::g_kernel_symbols_available) {
+        SpinlockLocker lock(s_lock);
+        dbgln("kmalloc({})", size);
+        Kernel::dump_backtrace();
+    }
+
+    void* ptr = nullptr;
+    if (auto* slab_cache = g_kmalloc_global->slab_cache_for(size, alignment)) {
+        ptr = slab_cache->allocate(caller_will_initialize_memory);
+    } else {
+        SpinlockLocker lock(s_lock);
+        ++g_kmalloc_call_count;
+        ptr = g_kmalloc_global->allocate(size, alignment, caller_will_initialize_memory);
+    }
+
+    record_kmalloc(size, ptr);
     return ptr;
 }
 
@@ -470,34 +665,75 @@ void* kcalloc(size_t count, size_t size)
     return ptr;
 }
 
-void kfree_sized(void* ptr, size_t size)
+static void kfree_impl(void* ptr, size_t size, size_t alignment)
 {
     if (!ptr)
         return;
 
     VERIFY(size > 0);
+    verify_allocation_is_allowed();
 
-    // Catch bad callers allocating under spinlock.
-    if constexpr (KMALLOC_VERIFY_NO_SPINLOCK_HELD) {
-        Processor::verify_no_spinlocks_held();
+    record_kfree(ptr);
+
+    if (auto* slab_cache = g_kmalloc_global->slab_cache_for(size, alignment)) {
+        slab_cache->deallocate(ptr);
+        return;
     }
 
     SpinlockLocker lock(s_lock);
     ++g_kfree_call_count;
-    ++g_nested_kfree_calls;
+    g_kmalloc_global->deallocate(ptr, size);
+}
 
-    if (g_nested_kfree_calls == 1) {
-        Thread* current_thread = Thread::current();
-        if (!current_thread)
-            current_thread = Processor::idle_thread();
-        if (current_thread) {
-            VERIFY(current_thread->is_allocation_enabled());
-            PerformanceManager::add_kfree_perf_event(*current_thread, 0, (FlatPtr)ptr);
-        }
+void kfree_sized(void* ptr, size_t size)
+{
+    kfree_impl(ptr, size, KMALLOC_DEFAULT_ALIGNMENT);
+}
+
+void kfree_aligned(void* ptr, size_t size, size_t alignment)
+{
+    kfree_impl(ptr, size, alignment);
+}
+
+KmallocSlabCache& KmallocCache::slab_cache()
+{
+    if (auto* slab_cache = m_slab_cache.load(AK::MemoryOrder::memory_order_acquire))
+        return *slab_cache;
+
+    // NOTE: The allocation may have to take the kmalloc lock itself, so we can't hold it yet.
+    //       Typed caches live as long as the kernel does, so we never free this unless another thread beat us to it.
+    auto* storage = kmalloc_impl(sizeof(KmallocTypedSlabCache), alignof(KmallocTypedSlabCache), CallerWillInitializeMemory::Yes);
+    VERIFY(storage);
+
+    SpinlockLocker lock(s_lock);
+    if (auto* slab_cache = m_slab_cache.load(AK::MemoryOrder::memory_order_relaxed)) {
+        lock.unlock();
+        kfree_impl(storage, sizeof(KmallocTypedSlabCache), alignof(KmallocTypedSlabCache));
+        return *slab_cache;
     }
 
-    g_kmalloc_global->deallocate(ptr, size);
-    --g_nested_kfree_calls;
+    auto* typed_slab_cache = new (storage) KmallocTypedSlabCache(m_name, m_object_size);
+    g_kmalloc_global->typed_slab_caches.append(*typed_slab_cache);
+    m_slab_cache.store(&typed_slab_cache->cache, AK::MemoryOrder::memory_order_release);
+    return typed_slab_cache->cache;
+}
+
+void* KmallocCache::allocate()
+{
+    verify_allocation_is_allowed();
+    auto* ptr = slab_cache().allocate(CallerWillInitializeMemory::No);
+    record_kmalloc(m_object_size, ptr);
+    return ptr;
+}
+
+void KmallocCache::deallocate(void* ptr)
+{
+    if (!ptr)
+        return;
+
+    verify_allocation_is_allowed();
+    record_kfree(ptr);
+    slab_cache().deallocate(ptr);
 }
 
 size_t kmalloc_good_size(size_t size)
@@ -563,9 +799,9 @@ void operator delete(void* ptr, size_t size) noexcept
     return kfree_sized(ptr, size);
 }
 
-void operator delete(void* ptr, size_t size, std::align_val_t) noexcept
+void operator delete(void* ptr, size_t size, std::align_val_t al) noexcept
 {
-    return kfree_sized(ptr, size);
+    return kfree_aligned(ptr, size, (size_t)al);
 }
 
 void operator delete[](void*) noexcept
@@ -586,4 +822,24 @@ void get_kmalloc_stats(kmalloc_stats& stats)
     stats.bytes_free = g_kmalloc_global->free_bytes();
     stats.kmalloc_call_count = g_kmalloc_call_count;
     stats.kfree_call_count = g_kfree_call_count;
+    for (auto const& slab_cache : g_kmalloc_global->slab_caches) {
+        stats.kmalloc_call_count += slab_cache.allocation_count();
+        stats.kfree_call_count += slab_cache.free_count();
+    }
+}
+
+size_t get_kmalloc_cache_stats(kmalloc_cache_stats* stats, size_t max_count)
+{
+    SpinlockLocker lock(s_lock);
+    size_t count = 0;
+    auto add = [&](KmallocSlabCache const& slab_cache) {
+        if (count < max_count)
+            slab_cache.fill_in_stats(stats[count]);
+        ++count;
+    };
+    for (auto const& slab_cache : g_kmalloc_global->slab_caches)
+        add(slab_cache);
+    for (auto const& typed_slab_cache : g_kmalloc_global->typed_slab_caches)
+        add(typed_slab_cache.cache);
+    return count;
 }
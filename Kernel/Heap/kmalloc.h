@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include <AK/Atomic.h>
 #include <AK/Types.h>
 #include <Kernel/API/POSIX/sys/limits.h> // For PAGE_SIZE. Everyone needs PAGE_SIZE
 
@@ -26,7 +27,7 @@ public:                                                                      \
     }                                                                        \
     void operator delete(void* ptr) noexcept                                 \
     {                                                                        \
-        kfree_sized(ptr, sizeof(type));                                      \
+        kfree_aligned(ptr, sizeof(type), alignment);                         \
     }                                                                        \
                                                                              \
 private:
@@ -46,6 +47,8 @@ enum class align_val_t : size_t {};
 void kmalloc_init();
 
 void kfree_sized(void*, size_t);
+// For memory from kmalloc_aligned(), which has to be freed with the same size and alignment.
+void kfree_aligned(void*, size_t size, size_t alignment);
 
 struct kmalloc_stats {
     size_t bytes_allocated;
@@ -55,6 +58,70 @@ struct kmalloc_stats {
 };
 void get_kmalloc_stats(kmalloc_stats&);
 
+struct kmalloc_cache_stats {
+    char const* name;
+    size_t object_size;
+    size_t bytes_allocated;
+    size_t bytes_free;
+    size_t objects_in_magazines;
+    u64 allocation_count;
+    u64 free_count;
+    u64 magazine_hit_count;
+};
+// Fills in up to `max_count` entries and returns the total number of slab caches.
+size_t get_kmalloc_cache_stats(kmalloc_cache_stats*, size_t max_count);
+
+class KmallocSlabCache;
+
+// A slab cache for kernel objects of a single type that are allocated and freed all the time. The objects get slab
+// blocks of their own, which packs them tighter than the power-of-two slab heaps behind kmalloc(), and keeps
+// separate statistics for them. Like those, each CPU has a magazine of free objects in front of the cache.
+// NOTE: The cache is set up on first use, so it can be used before the global constructors have run.
+class KmallocCache {
+public:
+    constexpr KmallocCache(char const* name, size_t object_size)
+        : m_name(name)
+        , m_object_size(object_size)
+    {
+    }
+
+    [[nodiscard]] void* allocate();
+    void deallocate(void*);
+
+private:
+    KmallocSlabCache& slab_cache();
+
+    char const* m_name { nullptr };
+    size_t m_object_size { 0 };
+    Atomic<KmallocSlabCache*> m_slab_cache { nullptr };
+};
+
+// Put this in the class definition, and DEFINE_SLAB_CACHE() in one translation unit.
+// NOTE: The cache only holds objects of exactly this type, so it can't be used for classes that are derived from.
+#define MAKE_SLAB_CACHE_ALLOCATED(type)                                           \
+public:                                                                           \
+    [[nodiscard]] void* operator new(size_t size)                                 \
+    {                                                                             \
+        VERIFY(size == sizeof(type));                                             \
+        void* ptr = s_slab_cache.allocate();                                      \
+        VERIFY(ptr);                                                              \
+        return ptr;                                                               \
+    }                                                                             \
+    [[nodiscard]] void* operator new(size_t size, std::nothrow_t const&) noexcept \
+    {                                                                             \
+        VERIFY(size == sizeof(type));                                             \
+        return s_slab_cache.allocate();                                           \
+    }                                                                             \
+    void operator delete(void* ptr) noexcept                                      \
+    {                                                                             \
+        s_slab_cache.deallocate(ptr);                                             \
+    }                                                                             \
+                                                                                  \
+private:                                                                          \
+    static KmallocCache s_slab_cache
+
+#define DEFINE_SLAB_CACHE(type) constinit KmallocCache type::s_slab_cache { #type, sizeof(type) }
+
 extern bool g_dump_kmalloc_stacks;
 
 inline void* operator new(size_t, void* p) { return p; }
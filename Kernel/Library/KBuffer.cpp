@@ -0,0 +1,13 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <Kernel/Library/KBuffer.h>
+
+namespace Kernel {
+
+DEFINE_SLAB_CACHE(KBuffer);
+
+}
@@ -23,6 +23,8 @@
 namespace Kernel {
 
 class [[nodiscard]] KBuffer {
+    MAKE_SLAB_CACHE_ALLOCATED(KBuffer);
+
 public:
     static ErrorOr<NonnullOwnPtr<KBuffer>> try_create_with_size(StringView name, size_t size, Memory::Region::Access access = Memory::Region::Access::ReadWrite, AllocationStrategy strategy = AllocationStrategy::Reserve)
     {
@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Atomic.h>
+#include <AK/BuiltinWrappers.h>
+#include <AK/HashFunctions.h>
+#include <AK/QuickSort.h>
+#include <Kernel/Locking/LockStatistics.h>
+
+#if LOCK_STATISTICS
+
+namespace Kernel {
+
+// Everything in here is updated from within the locks themselves, so none of it can take a lock or allocate.
+// Entries are claimed by a lock the first time it's taken, and are given back when the lock is destroyed, so that
+// whatever gets allocated at the same address later on starts out with a clean slate.
+struct LockEntry {
+    Atomic<FlatPtr> address { 0 };
+    Atomic<u8> type { 0 };
+    Atomic<int> rank { 0 };
+    Atomic<char const*> name_characters { nullptr };
+    Atomic<size_t> name_length { 0 };
+
+    Atomic<u64> acquisitions { 0 };
+    Atomic<u64> contended_acquisitions { 0 };
+    Atomic<u64> total_wait { 0 };
+    Atomic<u64> max_wait { 0 };
+    Atomic<u64> wait_histogram[LockStatistics::wait_histogram_bucket_count] {};
+    Atomic<FlatPtr> call_site_addresses[LockStatistics::max_call_sites] {};
+    Atomic<u64> call_site_counts[LockStatistics::max_call_sites] {};
+};
+
+static LockEntry s_entries[LockStatistics::max_tracked_locks];
+static Atomic<u64> s_untracked_acquisitions { 0 };
+
+static constexpr size_t max_probe_count = 32;
+// Marks an entry whose lock has been destroyed. Unlike an empty entry, it doesn't end the search for a lock, as the
+// lock may have been placed further along when this entry was still taken. No lock lives at this address.
+static constexpr FlatPtr released_entry_address = 1;
+
+static void clear_counts(LockEntry& entry)
+{
+    entry.acquisitions.store(0, AK::MemoryOrder::memory_order_relaxed);
+    entry.contended_acquisitions.store(0, AK::MemoryOrder::memory_order_relaxed);
+    entry.total_wait.store(0, AK::MemoryOrder::memory_order_relaxed);
+    entry.max_wait.store(0, AK::MemoryOrder::memory_order_relaxed);
+    for (auto& bucket : entry.wait_histogram)
+        bucket.store(0, AK::MemoryOrder::memory_order_relaxed);
+    for (size_t i = 0; i < LockStatistics::max_call_sites; ++i) {
+        entry.call_site_addresses[i].store(0, AK::MemoryOrder::memory_order_relaxed);
+        entry.call_site_counts[i].store(0, AK::MemoryOrder::memory_order_relaxed);
+    }
+}
+
+static LockEntry* find_entry(FlatPtr address)
+{
+    auto index = ptr_hash(address) % LockStatistics::max_tracked_locks;
+    for (size_t probe = 0; probe < max_probe_count; ++probe) {
+        auto& entry = s_entries[(index + probe) % LockStatistics::max_tracked_locks];
+        auto entry_address = entry.address.load(AK::MemoryOrder::memory_order_acquire);
+        if (entry_address == address)
+            return &entry;
+        if (entry_address == 0)
+            return nullptr;
+    }
+    return nullptr;
+}
+
+static LockEntry* entry_for_lock(void const* lock, LockStatistics::Type type, LockRank rank, StringView name)
+{
+    auto address = bit_cast<FlatPtr>(lock);
+    if (auto* entry = find_entry(address))
+        return entry;
+
+    // The lock isn't in the table yet, so claim the first free entry along the way for it.
+    auto index = ptr_hash(address) % LockStatistics::max_tracked_locks;
+    for (size_t probe = 0; probe < max_probe_count; ++probe) {
+        auto& entry = s_entries[(index + probe) % LockStatistics::max_tracked_locks];
+        auto expected = entry.address.load(AK::MemoryOrder::memory_order_acquire);
+        if (expected == address)
+            return &entry;
+        if (expected != 0 && expected != released_entry_address)
+            continue;
+        if (entry.address.compare_exchange_strong(expected, address, AK::MemoryOrder::memory_order_acq_rel)) {
+            entry.type.store(to_underlying(type), AK::MemoryOrder::memory_order_relaxed);
+            entry.rank.store(to_underlying(rank), AK::MemoryOrder::memory_order_relaxed);
+            entry.name_characters.store(name.characters_without_null_termination(), AK::MemoryOrder::memory_order_relaxed);
+            entry.name_length.store(name.length(), AK::MemoryOrder::memory_order_release);
+            return &entry;
+        }
+        if (expected == address)
+            return &entry;
+    }
+    s_untracked_acquisitions.fetch_add(1, AK::MemoryOrder::memory_order_relaxed);
+    return nullptr;
+}
+
+void LockStatistics::release_lock(void const* lock)
+{
+    auto* entry = find_entry(bit_cast<FlatPtr>(lock));
+    if (!entry)
+        return;
+    // Nobody can be taking a lock that is being destroyed, so nothing else records into its entry anymore.
+    clear_counts(*entry);
+    entry->name_length.store(0, AK::MemoryOrder::memory_order_relaxed);
+    entry->address.store(released_entry_address, AK::MemoryOrder::memory_order_release);
+}
+
+void LockStatistics::record_acquisition(void const* lock, Type type, LockRank rank, StringView name)
+{
+    if (auto* entry = entry_for_lock(lock, type, rank, name))
+        entry->acquisitions.fetch_add(1, AK::MemoryOrder::memory_order_relaxed);
+}
+
+static void record_call_site(LockEntry& entry, FlatPtr call_site)
+{
+    for (size_t i = 0; i < LockStatistics::max_call_sites; ++i) {
+        auto address = entry.call_site_addresses[i].load(AK::MemoryOrder::memory_order_relaxed);
+        if (address == 0) {
+            FlatPtr expected = 0;
+            if (!entry.call_site_addresses[i].compare_exchange_strong(expected, call_site, AK::MemoryOrder::memory_order_relaxed) && expected != call_site)
+                continue;
+            address = call_site;
+        }
+        if (address == call_site) {
+            entry.call_site_counts[i].fetch_add(1, AK::MemoryOrder::memory_order_relaxed);
+            return;
+        }
+    }
+    // All slots are taken by other call sites. The first call sites to wait tend to be the ones that do so most.
+}
+
+NEVER_INLINE void LockStatistics::record_contended_acquisition(void const* lock, Type type, LockRank rank, u64 waited, FlatPtr call_site, StringView name)
+{
+    if (call_site == 0)
+        call_site = bit_cast<FlatPtr>(__builtin_return_address(0));
+
+    auto* entry = entry_for_lock(lock, type, rank, name);
+    if (!entry)
+        return;
+    entry->contended_acquisitions.fetch_add(1, AK::MemoryOrder::memory_order_relaxed);
+    entry->total_wait.fetch_add(waited, AK::MemoryOrder::memory_order_relaxed);
+
+    auto max_wait = entry->max_wait.load(AK::MemoryOrder::memory_order_relaxed);
+    while (waited > max_wait && !entry->max_wait.compare_exchange_strong(max_wait, waited, AK::MemoryOrder::memory_order_relaxed))
+        ;
+
+    size_t bucket = waited == 0 ? 0 : sizeof(u64) * 8 - count_leading_zeroes(waited);
+    entry->wait_histogram[min(bucket, wait_histogram_bucket_count - 1)].fetch_add(1, AK::MemoryOrder::memory_order_relaxed);
+
+    record_call_site(*entry, call_site);
+}
+
+ErrorOr<void> LockStatistics::try_for_each_lock(Function<ErrorOr<void>(Lock const&)> callback)
+{
+    for (auto& entry : s_entries) {
+        auto address = entry.address.load(AK::MemoryOrder::memory_order_acquire);
+        if (address == 0 || address == released_entry_address)
+            continue;
+
+        Lock lock;
+        lock.address = address;
+        lock.acquisitions = entry.acquisitions.load(AK::MemoryOrder::memory_order_relaxed);
+        if (lock.acquisitions == 0)
+            continue;
+        lock.type = static_cast<Type>(entry.type.load(AK::MemoryOrder::memory_order_relaxed));
+        lock.rank = static_cast<LockRank>(entry.rank.load(AK::MemoryOrder::memory_order_relaxed));
+        if (auto name_length = entry.name_length.load(AK::MemoryOrder::memory_order_acquire); name_length > 0)
+            lock.name = StringView { entry.name_characters.load(AK::MemoryOrder::memory_order_relaxed), name_length };
+        lock.contended_acquisitions = entry.contended_acquisitions.load(AK::MemoryOrder::memory_order_relaxed);
+        lock.total_wait = entry.total_wait.load(AK::MemoryOrder::memory_order_relaxed);
+        lock.max_wait = entry.max_wait.load(AK::MemoryOrder::memory_order_relaxed);
+        for (size_t i = 0; i < wait_histogram_bucket_count; ++i)
+            lock.wait_histogram[i] = entry.wait_histogram[i].load(AK::MemoryOrder::memory_order_relaxed);
+        for (size_t i = 0; i < max_call_sites; ++i) {
+            lock.call_sites[i].address = entry.call_site_addresses[i].load(AK::MemoryOrder::memory_order_relaxed);
+            lock.call_sites[i].contended_acquisitions = entry.call_site_counts[i].load(AK::MemoryOrder::memory_order_relaxed);
+        }
+        quick_sort(lock.call_sites, [](auto const& a, auto const& b) { return a.contended_acquisitions > b.contended_acquisitions; });
+
+        TRY(callback(lock));
+    }
+    return {};
+}
+
+u64 LockStatistics::untracked_acquisitions()
+{
+    return s_untracked_acquisitions.load(AK::MemoryOrder::memory_order_relaxed);
+}
+
+void LockStatistics::reset()
+{
+    // The entries stay claimed by their locks, as those may be recording into them right now.
+    for (auto& entry : s_entries)
+        clear_counts(entry);
+    s_untracked_acquisitions.store(0, AK::MemoryOrder::memory_order_relaxed);
+}
+
+}
+
+#endif
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Array.h>
+#include <AK/Error.h>
+#include <AK/Function.h>
+#include <AK/StringView.h>
+#include <AK/Types.h>
+#include <Kernel/Debug.h>
+#include <Kernel/Locking/LockRank.h>
+
+// Counts how often every lock is taken, and how long it has to be waited for when it's already held, to find the
+// locks that are contended under load. The counts are at /sys/kernel/lock_stats, which the lockstat utility prints.
+//
+// This is only built with LOCK_STATISTICS. Otherwise, the locks don't call into it, and it doesn't exist.
+
+namespace Kernel {
+
+#if LOCK_STATISTICS
+class LockStatistics {
+public:
+    enum class Type : u8 {
+        Spinlock,
+        RecursiveSpinlock,
+        Mutex,
+    };
+
+    // Locks beyond this many aren't tracked, but are counted.
+    static constexpr size_t max_tracked_locks = 1024;
+    static constexpr size_t max_call_sites = 4;
+    // Bucket N counts the waits of less than 2^N: spins for spinlocks, and microseconds for mutexes.
+    static constexpr size_t wait_histogram_bucket_count = 16;
+
+    // Recording never takes a lock, so it can be done from within any of them.
+    static void record_acquisition(void const* lock, Type, LockRank, StringView name = {});
+    // Without a call site, it's the code that calls this, which is where the lock is taken if lock() was inlined.
+    static void record_contended_acquisition(void const* lock, Type, LockRank, u64 waited, FlatPtr call_site = 0, StringView name = {});
+    // Called by the locks' destructors, so that a lock that later ends up at the same address doesn't inherit the counts.
+    static void release_lock(void const* lock);
+
+    struct CallSite {
+        FlatPtr address { 0 };
+        u64 contended_acquisitions { 0 };
+    };
+
+    struct Lock {
+        FlatPtr address { 0 };
+        Type type { Type::Spinlock };
+        LockRank rank { LockRank::None };
+        StringView name;
+        u64 acquisitions { 0 };
+        u64 contended_acquisitions { 0 };
+        u64 total_wait { 0 };
+        u64 max_wait { 0 };
+        Array<u64, wait_histogram_bucket_count> wait_histogram {};
+        // The call sites that were the first to wait for the lock, with the most waits first.
+        Array<CallSite, max_call_sites> call_sites {};
+    };
+
+    static ErrorOr<void> try_for_each_lock(Function<ErrorOr<void>(Lock const&)>);
+    static u64 untracked_acquisitions();
+    static void reset();
+};
+#endif
+
+}
@@ -8,9 +8,11 @@
 #include <Kernel/Debug.h>
 #include <Kernel/KSyms.h>
 #include <Kernel/Locking/LockLocation.h>
+#include <Kernel/Locking/LockStatistics.h>
 #include <Kernel/Locking/Mutex.h>
 #include <Kernel/Locking/Spinlock.h>
 #include <Kernel/Tasks/Thread.h>
+#include <Kernel/Time/TimeManagement.h>
 
 extern bool g_in_early_boot;
 
@@ -30,6 +32,9 @@ void Mutex::lock(Mode mode, [[maybe_unused]] LockLocation const& location)
     auto* current_thread = Thread::current();
 
     SpinlockLocker lock(m_lock);
+#if LOCK_STATISTICS
+    LockStatistics::record_acquisition(this, LockStatistics::Type::Mutex, LockRank::None, m_name);
+#endif
     bool did_block = false;
     Mode current_mode = m_mode;
     switch (current_mode) {
@@ -60,7 +65,11 @@ void Mutex::lock(Mode mode, [[maybe_unused]] LockLocation const& location)
     case Mode::Exclusive: {
         VERIFY(m_holder);
         if (m_holder != bit_cast<uintptr_t>(current_thread)) {
+#if LOCK_STATISTICS
+            block(*current_thread, mode, lock, 1, bit_cast<FlatPtr>(__builtin_return_address(0)));
+#else
             block(*current_thread, mode, lock, 1);
+#endif
             did_block = true;
             // If we blocked then m_mode should have been updated to what we requested
             VERIFY(m_mode == mode);
@@ -106,7 +115,11 @@ void Mutex::lock(Mode mode, [[maybe_unused]] LockLocation const& location)
             // and is asking to upgrade the lock to be exclusive without first releasing the shared lock. We have no
             // allocation-free way to detect such a scenario, so if you suspect that this is the cause of your deadlock,
             // try turning on LOCK_SHARED_UPGRADE_DEBUG.
+#if LOCK_STATISTICS
+            block(*current_thread, mode, lock, 1, bit_cast<FlatPtr>(__builtin_return_address(0)));
+#else
             block(*current_thread, mode, lock, 1);
+#endif
             did_block = true;
             VERIFY(m_mode == mode);
         }
@@ -207,7 +220,11 @@ void Mutex::unlock()
     }
 }
 
+#if LOCK_STATISTICS
+void Mutex::block(Thread& current_thread, Mode mode, SpinlockLocker<Spinlock<LockRank::None>>& lock, u32 requested_locks, FlatPtr call_site)
+#else
 void Mutex::block(Thread& current_thread, Mode mode, SpinlockLocker<Spinlock<LockRank::None>>& lock, u32 requested_locks)
+#endif
 {
     if constexpr (LOCK_IN_CRITICAL_DEBUG) {
         // There are no interrupts enabled in early boot.
@@ -227,7 +244,14 @@ void Mutex::block(Thread& current_thread, Mode mode, SpinlockLocker<Spinlock<Loc
     });
 
     dbgln_if(LOCK_TRACE_DEBUG, "Mutex::lock @ {} ({}) waiting...", this, m_name);
+#if LOCK_STATISTICS
+    auto wait_start = TimeManagement::the().monotonic_time(TimePrecision::Precise);
+#endif
     current_thread.block(*this, lock, requested_locks);
+#if LOCK_STATISTICS
+    auto waited = (TimeManagement::the().monotonic_time(TimePrecision::Precise) - wait_start).to_microseconds();
+    LockStatistics::record_contended_acquisition(this, LockStatistics::Type::Mutex, LockRank::None, waited, call_site, m_name);
+#endif
     dbgln_if(LOCK_TRACE_DEBUG, "Mutex::lock @ {} ({}) waited", this, m_name);
 
     m_blocked_thread_lists.with([&](auto& lists) {
@@ -337,7 +361,11 @@ void Mutex::restore_exclusive_lock(u32 lock_count, [[maybe_unused]] LockLocation
     SpinlockLocker lock(m_lock);
     [[maybe_unused]] auto previous_mode = m_mode;
     if (m_mode == Mode::Exclusive && m_holder != bit_cast<uintptr_t>(current_thread)) {
+#if LOCK_STATISTICS
+        block(*current_thread, Mode::Exclusive, lock, lock_count, bit_cast<FlatPtr>(__builtin_return_address(0)));
+#else
         block(*current_thread, Mode::Exclusive, lock, lock_count);
+#endif
         did_block = true;
         // If we blocked then m_mode should have been updated to what we requested
         VERIFY(m_mode == Mode::Exclusive);
@@ -14,6 +14,7 @@
 #include <Kernel/Forward.h>
 #include <Kernel/Locking/LockLocation.h>
 #include <Kernel/Locking/LockMode.h>
+#include <Kernel/Locking/LockStatistics.h>
 #include <Kernel/Tasks/WaitQueue.h>
 
 namespace Kernel {
@@ -38,7 +39,14 @@ public:
         , m_behavior(behavior)
     {
     }
+#if LOCK_STATISTICS
+    ~Mutex()
+    {
+        LockStatistics::release_lock(this);
+    }
+#else
     ~Mutex() = default;
+#endif
 
     void lock(Mode mode = Mode::Exclusive, LockLocation const& location = LockLocation::current());
     void restore_exclusive_lock(u32, LockLocation const& location = LockLocation::current());
@@ -83,7 +91,11 @@ private:
     using BigLockBlockedThreadList = IntrusiveList<&Thread::m_big_lock_blocked_threads_list_node>;
 
     // FIXME: Allow any lock rank.
+#if LOCK_STATISTICS
+    void block(Thread&, Mode, SpinlockLocker<Spinlock<LockRank::None>>&, u32, FlatPtr call_site);
+#else
     void block(Thread&, Mode, SpinlockLocker<Spinlock<LockRank::None>>&, u32);
+#endif
     void unblock_waiters(Mode);
 
     StringView m_name;
@@ -10,6 +10,7 @@
 #include <AK/Types.h>
 #include <Kernel/Arch/Processor.h>
 #include <Kernel/Locking/LockRank.h>
+#include <Kernel/Locking/LockStatistics.h>
 
 namespace Kernel {
 
@@ -20,15 +21,33 @@ class Spinlock {
 
 public:
     Spinlock() = default;
+#if LOCK_STATISTICS
+    ~Spinlock()
+    {
+        LockStatistics::release_lock(this);
+    }
+#endif
 
     InterruptsState lock()
     {
         InterruptsState previous_interrupts_state = Processor::interrupts_state();
         Processor::enter_critical();
         Processor::disable_interrupts();
-        while (m_lock.exchange(1, AK::memory_order_acquire) != 0)
+#if LOCK_STATISTICS
+        u64 spins = 0;
+#endif
+        while (m_lock.exchange(1, AK::memory_order_acquire) != 0) {
             Processor::wait_check();
+#if LOCK_STATISTICS
+            ++spins;
+#endif
+        }
         track_lock_acquire(m_rank);
+#if LOCK_STATISTICS
+        LockStatistics::record_acquisition(this, LockStatistics::Type::Spinlock, m_rank);
+        if (spins > 0)
+            LockStatistics::record_contended_acquisition(this, LockStatistics::Type::Spinlock, m_rank, spins, bit_cast<FlatPtr>(__builtin_return_address(0)));
+#endif
         return previous_interrupts_state;
     }
 
@@ -64,6 +83,12 @@ class RecursiveSpinlock {
 
 public:
     RecursiveSpinlock() = default;
+#if LOCK_STATISTICS
+    ~RecursiveSpinlock()
+    {
+        LockStatistics::release_lock(this);
+    }
+#endif
 
     InterruptsState lock()
     {
@@ -73,14 +98,26 @@ public:
         auto& proc = Processor::current();
         FlatPtr cpu = FlatPtr(&proc);
         FlatPtr expected = 0;
+#if LOCK_STATISTICS
+        u64 spins = 0;
+#endif
         while (!m_lock.compare_exchange_strong(expected, cpu, AK::memory_order_acq_rel)) {
             if (expected == cpu)
                 break;
             Processor::wait_check();
             expected = 0;
+#if LOCK_STATISTICS
+            ++spins;
+#endif
         }
-        if (m_recursions == 0)
+        if (m_recursions == 0) {
             track_lock_acquire(m_rank);
+#if LOCK_STATISTICS
+            LockStatistics::record_acquisition(this, LockStatistics::Type::RecursiveSpinlock, m_rank);
+            if (spins > 0)
+                LockStatistics::record_contended_acquisition(this, LockStatistics::Type::RecursiveSpinlock, m_rank, spins, bit_cast<FlatPtr>(__builtin_return_address(0)));
+#endif
+        }
         m_recursions++;
         return previous_interrupts_state;
     }
@@ -37,8 +37,11 @@ ErrorOr<NonnullLockRefPtr<VMObject>> AnonymousVMObject::try_clone()
             ++new_cow_pages_needed;
     }
 
-    if (new_cow_pages_needed == 0)
-        return TRY(try_create_with_size(size(), AllocationStrategy::None));
+    if (new_cow_pages_needed == 0) {
+        auto clone = TRY(try_create_with_size(size(), AllocationStrategy::None));
+        clone->m_mergeable = m_mergeable;
+        return clone;
+    }
 
     dbgln_if(COMMIT_DEBUG, "Cloning {:p}, need {} committed cow pages", this, new_cow_pages_needed);
 
@@ -96,6 +99,28 @@ ErrorOr<NonnullLockRefPtr<AnonymousVMObject>> AnonymousVMObject::try_create_phys
     return adopt_nonnull_lock_ref_or_enomem(new (nothrow) AnonymousVMObject(move(new_physical_pages)));
 }
 
+ErrorOr<NonnullLockRefPtr<AnonymousVMObject>> AnonymousVMObject::try_create_with_large_pages(size_t size)
+{
+    size_t page_count = ceil_div(size, static_cast<size_t>(PAGE_SIZE));
+    auto committed_pages = TRY(MM.commit_physical_pages(page_count));
+    auto new_physical_pages = TRY(VMObject::try_create_physical_pages(size));
+
+    // Once physical memory is too fragmented for another large page, the rest gets individual pages.
+    size_t page_index = 0;
+    for (; page_index + pages_per_large_page <= page_count; page_index += pages_per_large_page) {
+        auto large_page_or_error = committed_pages.try_take_large_page();
+        if (large_page_or_error.is_error())
+            break;
+        auto large_page = large_page_or_error.release_value();
+        for (size_t i = 0; i < pages_per_large_page; ++i)
+            new_physical_pages[page_index + i] = move(large_page[i]);
+    }
+    for (; page_index < page_count; ++page_index)
+        new_physical_pages[page_index] = committed_pages.take_one();
+
+    return adopt_nonnull_lock_ref_or_enomem(new (nothrow) AnonymousVMObject(move(new_physical_pages)));
+}
+
 ErrorOr<NonnullLockRefPtr<AnonymousVMObject>> AnonymousVMObject::try_create_purgeable_with_size(size_t size, AllocationStrategy strategy)
 {
     Optional<CommittedPhysicalPageSet> committed_pages;
@@ -172,6 +197,7 @@ AnonymousVMObject::AnonymousVMObject(LockWeakPtr<AnonymousVMObject> other, Nonnu
     , m_cow_parent(move(other))
     , m_shared_committed_cow_pages(move(shared_committed_cow_pages))
     , m_purgeable(m_cow_parent.strong_ref()->m_purgeable)
+    , m_mergeable(m_cow_parent.strong_ref()->m_mergeable)
 {
 }
 
@@ -270,11 +296,64 @@ ErrorOr<void> AnonymousVMObject::set_volatile(bool is_volatile, bool& was_purged
     return {};
 }
 
+void AnonymousVMObject::set_mergeable(bool mergeable)
+{
+    SpinlockLocker locker(m_lock);
+    m_mergeable = mergeable;
+    // Pages that were merged already stay shared until they're written to.
+    if (!mergeable)
+        m_merge_checksums = {};
+}
+
 NonnullRefPtr<PhysicalPage> AnonymousVMObject::allocate_committed_page(Badge<Region>)
 {
     return m_unused_committed_pages->take_one();
 }
 
+// Replaces the lazily committed pages of a large page with a large block of physical memory, unless any of them
+// has been faulted in already.
+// Must be called with m_lock held.
+bool AnonymousVMObject::can_replace_with_large_page(size_t first_page_index) const
+{
+    VERIFY(first_page_index + pages_per_large_page <= page_count());
+    if (is_purgeable() || !m_unused_committed_pages.has_value() || m_unused_committed_pages->page_count() < pages_per_large_page)
+        return false;
+    for (size_t i = 0; i < pages_per_large_page; ++i) {
+        auto const& page = m_physical_pages[first_page_index + i];
+        if (!page || !page->is_lazy_committed_page())
+            return false;
+    }
+    return true;
+}
+
+bool AnonymousVMObject::try_allocate_committed_large_page(Badge<Region>, size_t first_page_index)
+{
+    {
+        SpinlockLocker lock(m_lock);
+        if (!can_replace_with_large_page(first_page_index))
+            return false;
+    }
+
+    // NOTE: Zeroing a large page takes a while, so we allocate it with a commitment of its own instead of holding our
+    //       lock, and then give back the commitment of the lazily committed pages it replaces.
+    auto commitment_or_error = MM.commit_physical_pages(pages_per_large_page);
+    if (commitment_or_error.is_error())
+        return false;
+    auto large_page_or_error = commitment_or_error.value().try_take_large_page();
+    if (large_page_or_error.is_error())
+        return false;
+    auto large_page = large_page_or_error.release_value();
+
+    SpinlockLocker lock(m_lock);
+    // Someone else may have faulted in some of the pages in the meantime.
+    if (!can_replace_with_large_page(first_page_index))
+        return false;
+    m_unused_committed_pages->uncommit(pages_per_large_page);
+    for (size_t i = 0; i < pages_per_large_page; ++i)
+        m_physical_pages[first_page_index + i] = move(large_page[i]);
+    return true;
+}
+
 ErrorOr<void> AnonymousVMObject::ensure_cow_map()
 {
     if (m_cow_map.is_null())
@@ -332,11 +411,18 @@ PageFaultResponse AnonymousVMObject::handle_cow_fault(size_t page_index, Virtual
     if (m_shared_committed_cow_pages && m_shared_committed_cow_pages->is_empty())
         m_shared_committed_cow_pages = nullptr;
 
+    bool was_merged = !m_merged_page_map.is_null() && m_merged_page_map.get(page_index);
+    if (was_merged)
+        m_merged_page_map.set(page_index, false);
+
     if (page_slot->ref_count() == 1) {
         dbgln_if(PAGE_FAULT_DEBUG, "    >> It's a COW page but nobody is sharing it anymore. Remap r/w");
         MUST(set_should_cow(page_index, false)); // If we received a COW fault, we already have a cow map allocated, so this is infallible
 
-        if (m_shared_committed_cow_pages) {
+        // The page that was committed for copying a merged page won't be needed anymore.
+        if (was_merged) {
+            m_merged_committed_pages->uncommit_one();
+        } else if (m_shared_committed_cow_pages) {
             m_shared_committed_cow_pages->uncommit_one();
             if (m_shared_committed_cow_pages->is_empty())
                 m_shared_committed_cow_pages = nullptr;
@@ -345,7 +431,10 @@ PageFaultResponse AnonymousVMObject::handle_cow_fault(size_t page_index, Virtual
     }
 
     RefPtr<PhysicalPage> page;
-    if (m_shared_committed_cow_pages) {
+    if (was_merged) {
+        dbgln_if(PAGE_FAULT_DEBUG, "    >> It's a merged page and it's time to COW!");
+        page = m_merged_committed_pages->take_one();
+    } else if (m_shared_committed_cow_pages) {
         dbgln_if(PAGE_FAULT_DEBUG, "    >> It's a committed COW page and it's time to COW!");
         page = m_shared_committed_cow_pages->take_one();
     } else {
@@ -15,6 +15,8 @@
 namespace Kernel::Memory {
 
 class AnonymousVMObject final : public VMObject {
+    friend class PageMerger;
+
 public:
     virtual ~AnonymousVMObject() override;
 
@@ -23,9 +25,11 @@ public:
     static ErrorOr<NonnullLockRefPtr<AnonymousVMObject>> try_create_with_physical_pages(Span<NonnullRefPtr<PhysicalPage>>);
     static ErrorOr<NonnullLockRefPtr<AnonymousVMObject>> try_create_purgeable_with_size(size_t, AllocationStrategy);
     static ErrorOr<NonnullLockRefPtr<AnonymousVMObject>> try_create_physically_contiguous_with_size(size_t);
+    static ErrorOr<NonnullLockRefPtr<AnonymousVMObject>> try_create_with_large_pages(size_t);
     virtual ErrorOr<NonnullLockRefPtr<VMObject>> try_clone() override;
 
     [[nodiscard]] NonnullRefPtr<PhysicalPage> allocate_committed_page(Badge<Region>);
+    [[nodiscard]] bool try_allocate_committed_large_page(Badge<Region>, size_t first_page_index);
     PageFaultResponse handle_cow_fault(size_t, VirtualAddress);
     size_t cow_pages() const;
     bool should_cow(size_t page_index, bool) const;
@@ -38,6 +42,10 @@ public:
 
     size_t purge();
 
+    // Whether PageMerger may let pages of this object share a physical page with others that have the same contents.
+    bool is_mergeable() const { return m_mergeable; }
+    void set_mergeable(bool);
+
 private:
     class SharedCommittedCowPages;
 
@@ -58,6 +66,7 @@ private:
 
     ErrorOr<void> ensure_cow_map();
     ErrorOr<void> ensure_or_reset_cow_map();
+    bool can_replace_with_large_page(size_t first_page_index) const;
 
     Optional<CommittedPhysicalPageSet> m_unused_committed_pages;
     Bitmap m_cow_map;
@@ -88,6 +97,14 @@ private:
     bool m_purgeable { false };
     bool m_volatile { false };
     bool m_was_purged { false };
+
+    bool m_mergeable { false };
+    // One committed page for every slot that PageMerger pointed at a page shared with others, so that writing to it
+    // later can't run out of memory. Those slots are marked in m_merged_page_map until they're written to.
+    Optional<CommittedPhysicalPageSet> m_merged_committed_pages;
+    Bitmap m_merged_page_map;
+    // The checksum of every page when PageMerger last looked at it, to tell which pages keep changing.
+    FixedArray<u32> m_merge_checksums;
 };
 
 }
@@ -6,6 +6,7 @@
 
 #include <Kernel/FileSystem/Inode.h>
 #include <Kernel/Memory/InodeVMObject.h>
+#include <Kernel/Memory/MemoryManager.h>
 
 namespace Kernel::Memory {
 
@@ -96,4 +97,59 @@ u32 InodeVMObject::writable_mappings() const
     return count;
 }
 
+bool InodeVMObject::is_page_resident(size_t page_index) const
+{
+    SpinlockLocker locker(m_lock);
+    return page_index < page_count() && m_physical_pages[page_index];
+}
+
+bool InodeVMObject::read_from_resident_page(size_t page_index, size_t offset_in_page, Bytes destination) const
+{
+    VERIFY(offset_in_page + destination.size() <= PAGE_SIZE);
+    SpinlockLocker locker(m_lock);
+    if (page_index >= page_count() || !m_physical_pages[page_index])
+        return false;
+    auto* page = MM.quickmap_page(*m_physical_pages[page_index]);
+    memcpy(destination.data(), page + offset_in_page, destination.size());
+    MM.unquickmap_page();
+    return true;
+}
+
+void InodeVMObject::discard_contents_past(u64 size)
+{
+    SpinlockLocker locker(m_lock);
+    auto page_index = size / PAGE_SIZE;
+    auto offset_in_page = size % PAGE_SIZE;
+    if (offset_in_page != 0 && page_index < page_count() && m_physical_pages[page_index]) {
+        auto* page = MM.quickmap_page(*m_physical_pages[page_index]);
+        memset(page + offset_in_page, 0, PAGE_SIZE - offset_in_page);
+        MM.unquickmap_page();
+    }
+
+    bool did_discard = false;
+    for (size_t i = ceil_div(size, static_cast<u64>(PAGE_SIZE)); i < page_count(); ++i) {
+        if (!m_physical_pages[i])
+            continue;
+        m_physical_pages[i] = nullptr;
+        m_dirty_pages.set(i, false);
+        did_discard = true;
+    }
+    if (did_discard) {
+        for_each_region([](auto& region) {
+            region.remap();
+        });
+    }
+}
+
+void InodeVMObject::write_to_resident_page(size_t page_index, size_t offset_in_page, ReadonlyBytes source)
+{
+    VERIFY(offset_in_page + source.size() <= PAGE_SIZE);
+    SpinlockLocker locker(m_lock);
+    if (page_index >= page_count() || !m_physical_pages[page_index])
+        return;
+    auto* page = MM.quickmap_page(*m_physical_pages[page_index]);
+    memcpy(page + offset_in_page, source.data(), source.size());
+    MM.unquickmap_page();
+}
+
 }
@@ -27,6 +27,14 @@ public:
 
     u32 writable_mappings() const;
 
+    // These let read() and write() use the pages that are already in memory, so a file that is both mapped and
+    // read or written doesn't need a second copy of its contents in the file system's cache.
+    bool read_from_resident_page(size_t page_index, size_t offset_in_page, Bytes destination) const;
+    void write_to_resident_page(size_t page_index, size_t offset_in_page, ReadonlyBytes source);
+    bool is_page_resident(size_t page_index) const;
+    // Forgets everything past `size` after the file was truncated, so that growing it again reads zeroes.
+    void discard_contents_past(u64 size);
+
 protected:
     explicit InodeVMObject(Inode&, FixedArray<RefPtr<PhysicalPage>>&&, Bitmap dirty_pages);
     explicit InodeVMObject(InodeVMObject const&, FixedArray<RefPtr<PhysicalPage>>&&, Bitmap dirty_pages);
@@ -604,6 +604,11 @@ PageTableEntry* MemoryManager::pte(PageDirectory& page_directory, VirtualAddress
     PageDirectoryEntry const& pde = pd[page_directory_index];
     if (!pde.is_present())
         return nullptr;
+#if ARCH(X86_64)
+    // NOTE: Large pages are mapped without a page table.
+    if (pde.is_huge())
+        return nullptr;
+#endif
 
     return &quickmap_pt(PhysicalAddress((FlatPtr)pde.page_table_base()))[page_table_index];
 }
@@ -618,7 +623,11 @@ PageTableEntry* MemoryManager::ensure_pte(PageDirectory& page_directory, Virtual
 
     auto* pd = quickmap_pd(page_directory, page_directory_table_index);
     auto& pde = pd[page_directory_index];
-    if (pde.is_present())
+    bool is_large_page = false;
+#if ARCH(X86_64)
+    is_large_page = pde.is_present() && pde.is_huge();
+#endif
+    if (pde.is_present() && !is_large_page)
         return &quickmap_pt(PhysicalAddress(pde.page_table_base()))[page_table_index];
 
     bool did_purge = false;
@@ -635,8 +644,26 @@ PageTableEntry* MemoryManager::ensure_pte(PageDirectory& page_directory, Virtual
         pd = quickmap_pd(page_directory, page_directory_table_index);
         VERIFY(&pde == &pd[page_directory_index]); // Sanity check
 
-        VERIFY(!pde.is_present()); // Should have not changed
+        VERIFY(pde.is_present() == is_large_page); // Should have not changed
     }
+#if ARCH(X86_64)
+    if (is_large_page) {
+        // Break the large page up into individual pages, so that one of them can be changed.
+        auto* page_table_entries = quickmap_pt(page_table->paddr());
+        for (size_t i = 0; i < pages_per_large_page; ++i) {
+            auto& pte = page_table_entries[i];
+            pte.set_physical_page_base(pde.page_table_base() + i * PAGE_SIZE);
+            pte.set_present(true);
+            pte.set_writable(pde.is_writable());
+            pte.set_user_allowed(pde.is_user_allowed());
+            pte.set_cache_disabled(pde.is_cache_disabled());
+            pte.set_execute_disabled(pde.is_execute_disabled());
+            pte.set_global(pde.is_global());
+        }
+        pde.clear();
+        --m_large_pages_mapped;
+    }
+#endif
     pde.set_page_table_base(page_table->paddr().get());
     pde.set_user_allowed(true);
     pde.set_present(true);
@@ -646,9 +673,43 @@ PageTableEntry* MemoryManager::ensure_pte(PageDirectory& page_directory, Virtual
     // NOTE: This leaked ref is matched by the unref in MemoryManager::release_pte()
     (void)page_table.leak_ref();
 
+    // The pages of a large page that we just broke up may still be in the TLB as part of it.
+    if (is_large_page)
+        flush_tlb(&page_directory, VirtualAddress { vaddr.get() & ~(large_page_size - 1) }, pages_per_large_page);
+
     return &quickmap_pt(PhysicalAddress(pde.page_table_base()))[page_table_index];
 }
 
+#if ARCH(X86_64)
+// Returns the page directory entry that maps the large page at `vaddr`, for the caller to fill in.
+// NOTE: The caller has to map the whole large page, so that no other region can have anything in the page table
+//       that's already there.
+PageDirectoryEntry* MemoryManager::ensure_large_page_pde(PageDirectory& page_directory, VirtualAddress vaddr)
+{
+    VERIFY_INTERRUPTS_DISABLED();
+    VERIFY(page_directory.get_lock().is_locked_by_current_processor());
+    VERIFY(vaddr.get() % large_page_size == 0);
+    u32 page_directory_table_index = (vaddr.get() >> 30) & 0x1ff;
+    u32 page_directory_index = (vaddr.get() >> 21) & 0x1ff;
+
+    auto* pd = quickmap_pd(page_directory, page_directory_table_index);
+    auto& pde = pd[page_directory_index];
+    if (pde.is_present() && pde.is_huge())
+        return &pde;
+
+    if (pde.is_present()) {
+        // Other processors may still walk the old page table through their TLBs and paging structure caches, so it
+        // can only be freed once they've all been flushed.
+        auto& page_table = get_physical_page_entry(PhysicalAddress { pde.page_table_base() }).allocated.physical_page;
+        pde.clear();
+        flush_tlb(&page_directory, vaddr, pages_per_large_page);
+        page_table.unref();
+    }
+    ++m_large_pages_mapped;
+    return &pde;
+}
+#endif
+
 void MemoryManager::release_pte(PageDirectory& page_directory, VirtualAddress vaddr, IsLastPTERelease is_last_pte_release)
 {
     VERIFY_INTERRUPTS_DISABLED();
@@ -659,6 +720,14 @@ void MemoryManager::release_pte(PageDirectory& page_directory, VirtualAddress va
 
     auto* pd = quickmap_pd(page_directory, page_directory_table_index);
     PageDirectoryEntry& pde = pd[page_directory_index];
+#if ARCH(X86_64)
+    if (pde.is_present() && pde.is_huge()) {
+        // Large pages are only mapped within a single region, and that one is going away as a whole.
+        pde.clear();
+        --m_large_pages_mapped;
+        return;
+    }
+#endif
     if (pde.is_present()) {
         auto* page_table = quickmap_pt(PhysicalAddress((FlatPtr)pde.page_table_base()));
         auto& pte = page_table[page_table_index];
@@ -873,7 +942,10 @@ ErrorOr<NonnullOwnPtr<Region>> MemoryManager::allocate_kernel_region(PhysicalAdd
     if (!name.is_null())
         name_kstring = TRY(KString::try_create(name));
     auto region = TRY(Region::create_unplaced(move(vmobject), 0, move(name_kstring), access, cacheable));
-    TRY(m_global_data.with([&](auto& global_data) { return global_data.region_tree.place_anywhere(*region, RandomizeVirtualAddress::No, size, PAGE_SIZE); }));
+    // The VMObject of a physical range is anonymous, so map() uses large pages for it wherever both the virtual and
+    // the physical address are on a large page boundary. Only the virtual one is up to us.
+    size_t alignment = (size >= large_page_size && paddr.get() % large_page_size == 0) ? large_page_size : PAGE_SIZE;
+    TRY(m_global_data.with([&](auto& global_data) { return global_data.region_tree.place_anywhere(*region, RandomizeVirtualAddress::No, size, alignment); }));
     TRY(region->map(kernel_page_directory()));
     return region;
 }
@@ -1090,6 +1162,34 @@ ErrorOr<Vector<NonnullRefPtr<PhysicalPage>>> MemoryManager::allocate_contiguous_
     return physical_pages;
 }
 
+ErrorOr<Vector<NonnullRefPtr<PhysicalPage>>> MemoryManager::allocate_committed_large_physical_page(Badge<CommittedPhysicalPageSet>)
+{
+    auto physical_pages = TRY(m_global_data.with([&](auto& global_data) -> ErrorOr<Vector<NonnullRefPtr<PhysicalPage>>> {
+        auto& system_memory_info = global_data.system_memory_info;
+        for (auto& physical_region : global_data.physical_regions) {
+            auto physical_pages = physical_region->take_contiguous_free_pages(pages_per_large_page, large_page_size);
+            if (!physical_pages.is_empty()) {
+                VERIFY(system_memory_info.physical_pages_committed >= pages_per_large_page);
+                system_memory_info.physical_pages_committed -= pages_per_large_page;
+                system_memory_info.physical_pages_used += pages_per_large_page;
+                ++system_memory_info.large_page_allocations;
+                return physical_pages;
+            }
+        }
+        ++system_memory_info.large_page_allocation_failures;
+        return ENOMEM;
+    }));
+
+    // NOTE: We zero the pages one at a time, so that we don't need a kernel region for this.
+    for (auto& page : physical_pages) {
+        InterruptDisabler disabler;
+        auto* ptr = quickmap_page(*page);
+        memset(ptr, 0, PAGE_SIZE);
+        unquickmap_page();
+    }
+    return physical_pages;
+}
+
 void MemoryManager::enter_process_address_space(Process& process)
 {
     process.address_space().with([](auto& space) {
@@ -1193,6 +1293,36 @@ bool MemoryManager::validate_user_stack(AddressSpace& space, VirtualAddress vadd
     return region && region->is_user() && region->is_stack();
 }
 
+bool MemoryManager::is_user_page_present_in_current_page_tables(VirtualAddress vaddr)
+{
+    VERIFY_INTERRUPTS_DISABLED();
+    if (!is_user_address(vaddr))
+        return false;
+#if ARCH(X86_64)
+    // NOTE: Nobody can be in the middle of using this processor's quickmap slot, since that needs interrupts to be disabled.
+    auto pml4t_index = (vaddr.get() >> 39) & 0x1ff;
+    auto page_directory_table_index = (vaddr.get() >> 30) & 0x1ff;
+    auto page_directory_index = (vaddr.get() >> 21) & 0x1ff;
+    auto page_table_index = (vaddr.get() >> 12) & 0x1ff;
+
+    auto pml4te = quickmap_pt(PhysicalAddress(PhysicalAddress::physical_page_base(read_cr3())))[pml4t_index];
+    if (!pml4te.is_present())
+        return false;
+    auto pdpte = quickmap_pt(PhysicalAddress(pml4te.physical_page_base()))[page_directory_table_index];
+    if (!pdpte.is_present())
+        return false;
+    auto pde = bit_cast<PageDirectoryEntry>(quickmap_pt(PhysicalAddress(pdpte.physical_page_base()))[page_directory_index]);
+    if (!pde.is_present())
+        return false;
+    if (pde.is_huge())
+        return true;
+    return quickmap_pt(PhysicalAddress(pde.page_table_base()))[page_table_index].is_present();
+#else
+    // FIXME: Walk the page tables on other architectures as well. Until then, callers have to cope with faults.
+    return true;
+#endif
+}
+
 void MemoryManager::unregister_kernel_region(Region& region)
 {
     VERIFY(region.is_kernel());
@@ -1246,6 +1376,14 @@ NonnullRefPtr<PhysicalPage> CommittedPhysicalPageSet::take_one()
     return MM.allocate_committed_physical_page({}, MemoryManager::ShouldZeroFill::Yes);
 }
 
+ErrorOr<Vector<NonnullRefPtr<PhysicalPage>>> CommittedPhysicalPageSet::try_take_large_page()
+{
+    VERIFY(m_page_count >= pages_per_large_page);
+    auto physical_pages = TRY(MM.allocate_committed_large_physical_page({}));
+    m_page_count -= pages_per_large_page;
+    return physical_pages;
+}
+
 void CommittedPhysicalPageSet::uncommit_one()
 {
     VERIFY(m_page_count > 0);
@@ -1253,6 +1391,13 @@ void CommittedPhysicalPageSet::uncommit_one()
     MM.uncommit_physical_pages({}, 1);
 }
 
+void CommittedPhysicalPageSet::uncommit(size_t page_count)
+{
+    VERIFY(m_page_count >= page_count);
+    m_page_count -= page_count;
+    MM.uncommit_physical_pages({}, page_count);
+}
+
 void MemoryManager::copy_physical_page(PhysicalPage& physical_page, u8 page_buffer[PAGE_SIZE])
 {
     auto* quickmapped_page = quickmap_page(physical_page);
@@ -1282,7 +1427,18 @@ MemoryManager::SystemMemoryInfo MemoryManager::get_system_memory_info()
     return m_global_data.with([&](auto& global_data) {
         auto physical_pages_unused = global_data.system_memory_info.physical_pages_committed + global_data.system_memory_info.physical_pages_uncommitted;
         VERIFY(global_data.system_memory_info.physical_pages == (global_data.system_memory_info.physical_pages_used + physical_pages_unused));
-        return global_data.system_memory_info;
+        auto system_memory_info = global_data.system_memory_info;
+        system_memory_info.large_pages_mapped = m_large_pages_mapped.load();
+        return system_memory_info;
+    });
+}
+
+bool MemoryManager::is_under_memory_pressure()
+{
+    // Consider memory to be tight once less than 1/16th of physical memory is still available for new allocations.
+    return m_global_data.with([&](auto& global_data) {
+        auto const& info = global_data.system_memory_info;
+        return info.physical_pages_uncommitted < info.physical_pages / 16;
     });
 }
 }
@@ -27,6 +27,10 @@ namespace Kernel::Memory {
 class PageDirectoryEntry;
 class PageTableEntry;
 
+// Large pages are mapped directly by a page directory entry, without a page table.
+static constexpr size_t large_page_size = 2 * MiB;
+static constexpr size_t pages_per_large_page = large_page_size / PAGE_SIZE;
+
 ErrorOr<FlatPtr> page_round_up(FlatPtr x);
 
 constexpr FlatPtr page_round_down(FlatPtr x)
@@ -114,7 +118,12 @@ public:
     size_t page_count() const { return m_page_count; }
 
     [[nodiscard]] NonnullRefPtr<PhysicalPage> take_one();
+    // Takes the pages of a large page at once. This fails if physical memory is too fragmented.
+    ErrorOr<Vector<NonnullRefPtr<PhysicalPage>>> try_take_large_page();
     void uncommit_one();
+    void uncommit(size_t page_count);
+    // Adds the pages of `other` to this set, leaving `other` empty.
+    void take_over(CommittedPhysicalPageSet&& other) { m_page_count += exchange(other.m_page_count, 0); }
 
     void operator=(CommittedPhysicalPageSet&&) = delete;
 
@@ -125,6 +134,8 @@ private:
 class MemoryManager {
     friend class PageDirectory;
     friend class AnonymousVMObject;
+    friend class InodeVMObject;
+    friend class PageMerger;
     friend class Region;
     friend class RegionTree;
     friend class VMObject;
@@ -154,6 +165,8 @@ public:
     static void enter_address_space(AddressSpace&);
 
     bool validate_user_stack(AddressSpace&, VirtualAddress) const;
+    // Walks the page tables this processor is using without taking any locks, for code that must not page fault or block.
+    bool is_user_page_present_in_current_page_tables(VirtualAddress);
 
     enum class ShouldZeroFill {
         No,
@@ -166,6 +179,7 @@ public:
     NonnullRefPtr<PhysicalPage> allocate_committed_physical_page(Badge<CommittedPhysicalPageSet>, ShouldZeroFill = ShouldZeroFill::Yes);
     ErrorOr<NonnullRefPtr<PhysicalPage>> allocate_physical_page(ShouldZeroFill = ShouldZeroFill::Yes, bool* did_purge = nullptr);
     ErrorOr<Vector<NonnullRefPtr<PhysicalPage>>> allocate_contiguous_physical_pages(size_t size);
+    ErrorOr<Vector<NonnullRefPtr<PhysicalPage>>> allocate_committed_large_physical_page(Badge<CommittedPhysicalPageSet>);
     void deallocate_physical_page(PhysicalAddress);
 
     ErrorOr<NonnullOwnPtr<Region>> allocate_contiguous_kernel_region(size_t, StringView name, Region::Access access, Region::Cacheable = Region::Cacheable::Yes);
@@ -184,10 +198,16 @@ public:
         PhysicalSize physical_pages_used { 0 };
         PhysicalSize physical_pages_committed { 0 };
         PhysicalSize physical_pages_uncommitted { 0 };
+        size_t large_pages_mapped { 0 };
+        u64 large_page_allocations { 0 };
+        u64 large_page_allocation_failures { 0 };
     };
 
     SystemMemoryInfo get_system_memory_info();
 
+    // Whether free memory is running low enough that caches should start giving memory back.
+    bool is_under_memory_pressure();
+
     template<IteratorFunction<VMObject&> Callback>
     static void for_each_vmobject(Callback callback)
     {
@@ -264,6 +284,9 @@ private:
 
     PageTableEntry* pte(PageDirectory&, VirtualAddress);
     PageTableEntry* ensure_pte(PageDirectory&, VirtualAddress);
+#if ARCH(X86_64)
+    PageDirectoryEntry* ensure_large_page_pde(PageDirectory&, VirtualAddress);
+#endif
     enum class IsLastPTERelease {
         Yes,
         No
@@ -282,6 +305,8 @@ private:
     PhysicalPageEntry* m_physical_page_entries { nullptr };
     size_t m_physical_page_entries_count { 0 };
 
+    Atomic<size_t> m_large_pages_mapped { 0 };
+
     struct GlobalData {
         GlobalData();
 
@@ -0,0 +1,306 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Atomic.h>
+#include <AK/HashFunctions.h>
+#include <Kernel/Memory/AnonymousVMObject.h>
+#include <Kernel/Memory/MemoryManager.h>
+#include <Kernel/Memory/PageMerger.h>
+#include <Kernel/Memory/Region.h>
+#include <Kernel/Sections.h>
+#include <Kernel/Tasks/Process.h>
+
+namespace Kernel::Memory {
+
+static Atomic<size_t> s_merged_page_count { 0 };
+static Atomic<u64> s_merged_zero_page_count { 0 };
+
+// Only the page merging task touches this.
+static u8 s_page_copy[PAGE_SIZE];
+
+size_t PageMerger::merged_page_count()
+{
+    return s_merged_page_count.load(AK::MemoryOrder::memory_order_relaxed);
+}
+
+u64 PageMerger::merged_zero_page_count()
+{
+    return s_merged_zero_page_count.load(AK::MemoryOrder::memory_order_relaxed);
+}
+
+void PageMerger::copy_page(PhysicalPage& page, u8* destination)
+{
+    auto* data = MM.quickmap_page(page);
+    memcpy(destination, data, PAGE_SIZE);
+    MM.unquickmap_page();
+}
+
+bool PageMerger::page_has_contents(PhysicalPage& page, u8 const* contents)
+{
+    auto* data = MM.quickmap_page(page);
+    bool is_equal = memcmp(data, contents, PAGE_SIZE) == 0;
+    MM.unquickmap_page();
+    return is_equal;
+}
+
+static u32 checksum_page(u8 const* contents)
+{
+    auto const* words = reinterpret_cast<u64 const*>(contents);
+    u32 checksum = 0;
+    for (size_t i = 0; i < PAGE_SIZE / sizeof(u64); ++i)
+        checksum = pair_int_hash(checksum, u64_hash(words[i]));
+    return checksum;
+}
+
+static bool is_zeroed(u8 const* contents)
+{
+    auto const* words = reinterpret_cast<u64 const*>(contents);
+    for (size_t i = 0; i < PAGE_SIZE / sizeof(u64); ++i) {
+        if (words[i] != 0)
+            return false;
+    }
+    return true;
+}
+
+// Pages that are already shared (with a forked child, or from an earlier merge) are left alone. Besides the slot in
+// the VMObject, the caller holds the only other reference.
+static bool can_be_merged(PhysicalPage const& page)
+{
+    return !page.is_shared_zero_page() && !page.is_lazy_committed_page() && page.ref_count() <= 2;
+}
+
+UNMAP_AFTER_INIT void PageMerger::spawn()
+{
+    MUST(Process::create_kernel_process("Page Merging Task"sv, [] {
+        StablePages stable_pages;
+        while (!Process::current().is_dying()) {
+            (void)Thread::current()->sleep(Duration::from_seconds(5));
+            scan(stable_pages);
+        }
+        Process::current().sys$exit(0);
+        VERIFY_NOT_REACHED();
+    }));
+}
+
+void PageMerger::scan(StablePages& stable_pages)
+{
+    Vector<NonnullLockRefPtr<AnonymousVMObject>> vmobjects;
+    MemoryManager::for_each_vmobject([&](VMObject& vmobject) {
+        if (!vmobject.is_anonymous() || !static_cast<AnonymousVMObject&>(vmobject).is_mergeable())
+            return IterationDecision::Continue;
+        if (vmobjects.try_append(static_cast<AnonymousVMObject&>(vmobject)).is_error())
+            return IterationDecision::Break;
+        return IterationDecision::Continue;
+    });
+
+    // `vmobjects` keeps the objects that these pages belong to alive until the end of the pass.
+    UnstablePages unstable_pages;
+    for (auto& vmobject : vmobjects)
+        scan_vmobject(*vmobject, stable_pages, unstable_pages);
+
+    // Merged pages that are only used once more can go back to being private to whoever uses them.
+    size_t merged_page_count = 0;
+    stable_pages.remove_all_matching([&](auto&, auto& page) {
+        if (page->ref_count() <= 2)
+            return true;
+        merged_page_count += page->ref_count() - 2;
+        return false;
+    });
+    s_merged_page_count.store(merged_page_count, AK::MemoryOrder::memory_order_relaxed);
+}
+
+void PageMerger::scan_vmobject(AnonymousVMObject& vmobject, StablePages& stable_pages, UnstablePages& unstable_pages)
+{
+    bool needs_checksums = false;
+    bool needs_merged_page_map = false;
+    {
+        SpinlockLocker locker(vmobject.m_lock);
+        // Pages can only be swapped out from under private mappings, as shared ones never copy on write.
+        // Objects that share committed pages with a forked child will have most of their pages copied anyway.
+        if (!vmobject.is_mergeable() || vmobject.is_purgeable() || vmobject.m_shared_committed_cow_pages)
+            return;
+        bool is_mapped_shared = false;
+        vmobject.for_each_region([&](Region& region) {
+            if (region.is_shared())
+                is_mapped_shared = true;
+        });
+        if (is_mapped_shared)
+            return;
+        needs_checksums = vmobject.m_merge_checksums.is_empty();
+        needs_merged_page_map = vmobject.m_merged_page_map.is_null();
+    }
+    if (needs_merged_page_map) {
+        auto merged_page_map_or_error = Bitmap::create(vmobject.page_count(), false);
+        if (merged_page_map_or_error.is_error())
+            return;
+        SpinlockLocker locker(vmobject.m_lock);
+        if (vmobject.m_merged_page_map.is_null())
+            vmobject.m_merged_page_map = merged_page_map_or_error.release_value();
+    }
+    if (needs_checksums) {
+        auto checksums_or_error = FixedArray<u32>::create(vmobject.page_count());
+        if (checksums_or_error.is_error())
+            return;
+        SpinlockLocker locker(vmobject.m_lock);
+        if (!vmobject.is_mergeable())
+            return;
+        if (vmobject.m_merge_checksums.is_empty())
+            vmobject.m_merge_checksums = checksums_or_error.release_value();
+    }
+
+    for (size_t page_index = 0; page_index < vmobject.page_count(); ++page_index) {
+        RefPtr<PhysicalPage> page;
+        {
+            SpinlockLocker locker(vmobject.m_lock);
+            if (!vmobject.is_mergeable())
+                return;
+            page = vmobject.m_physical_pages[page_index];
+        }
+        if (!page || !can_be_merged(*page))
+            continue;
+
+        copy_page(*page, s_page_copy);
+        auto checksum = checksum_page(s_page_copy);
+        {
+            SpinlockLocker locker(vmobject.m_lock);
+            if (vmobject.m_merge_checksums.is_empty())
+                return;
+            auto previous_checksum = exchange(vmobject.m_merge_checksums[page_index], checksum);
+            if (previous_checksum != checksum)
+                continue;
+        }
+
+        if (is_zeroed(s_page_copy)) {
+            if (merge_page(vmobject, page_index, *page, MM.shared_zero_page()))
+                s_merged_zero_page_count.fetch_add(1, AK::MemoryOrder::memory_order_relaxed);
+            continue;
+        }
+
+        if (auto it = stable_pages.find(checksum); it != stable_pages.end()) {
+            (void)merge_page(vmobject, page_index, *page, *it->value);
+            continue;
+        }
+
+        auto it = unstable_pages.find(checksum);
+        if (it == unstable_pages.end()) {
+            (void)unstable_pages.try_set(checksum, { &vmobject, page_index });
+            continue;
+        }
+        auto other = it->value;
+        unstable_pages.remove(it);
+
+        // Stop the other page from changing first, so that it can become the page that both share.
+        RefPtr<PhysicalPage> other_page;
+        bool other_was_cow = false;
+        {
+            SpinlockLocker locker(other.vmobject->m_lock);
+            other_page = other.vmobject->m_physical_pages[other.page_index];
+            if (!other_page || !can_be_merged(*other_page) || !write_protect(*other.vmobject, other.page_index, *other_page, other_was_cow))
+                continue;
+        }
+        if (merge_page(vmobject, page_index, *page, *other_page)) {
+            (void)stable_pages.try_set(checksum, other_page.release_nonnull());
+            continue;
+        }
+        SpinlockLocker locker(other.vmobject->m_lock);
+        if (other.vmobject->m_physical_pages[other.page_index] == other_page)
+            undo_write_protect(*other.vmobject, other.page_index, other_was_cow);
+    }
+}
+
+// Replaces the page at `page_index` with `replacement` if they have the same contents. The replacement must not be
+// writable anywhere. A page is committed for the slot, so that the copy it gets on the next write can't fail.
+bool PageMerger::merge_page(AnonymousVMObject& vmobject, size_t page_index, PhysicalPage& page, PhysicalPage& replacement)
+{
+    auto committed_page_or_error = MM.commit_physical_pages(1);
+    if (committed_page_or_error.is_error())
+        return false;
+    auto committed_page = committed_page_or_error.release_value();
+
+    SpinlockLocker locker(vmobject.m_lock);
+    bool was_cow = false;
+    if (!can_be_merged(page) || !write_protect(vmobject, page_index, page, was_cow))
+        return false;
+
+    // Now that the page can't change anymore, make sure that it's really the same.
+    copy_page(page, s_page_copy);
+    if (!page_has_contents(replacement, s_page_copy)) {
+        undo_write_protect(vmobject, page_index, was_cow);
+        return false;
+    }
+
+    // A slot that was merged before (and has since become the only user of its page) already has a page committed.
+    bool was_merged = vmobject.m_merged_page_map.get(page_index);
+    if (replacement.is_shared_zero_page()) {
+        // Zeroed pages go back to being lazily committed, just like they were before they were first written to.
+        MUST(vmobject.set_should_cow(page_index, false));
+        vmobject.m_physical_pages[page_index] = MM.lazy_committed_page();
+        if (vmobject.m_unused_committed_pages.has_value())
+            vmobject.m_unused_committed_pages->take_over(move(committed_page));
+        else
+            vmobject.m_unused_committed_pages = move(committed_page);
+        if (was_merged) {
+            vmobject.m_merged_page_map.set(page_index, false);
+            vmobject.m_merged_committed_pages->uncommit_one();
+        }
+    } else {
+        vmobject.m_physical_pages[page_index] = replacement;
+        if (!was_merged) {
+            vmobject.m_merged_page_map.set(page_index, true);
+            if (vmobject.m_merged_committed_pages.has_value())
+                vmobject.m_merged_committed_pages->take_over(move(committed_page));
+            else
+                vmobject.m_merged_committed_pages = move(committed_page);
+        }
+    }
+    // All page tables needed for this were set up to write protect the page, so this can't fail.
+    auto did_remap = remap_page(vmobject, page_index);
+    VERIFY(did_remap);
+    return true;
+}
+
+// Makes the page read-only everywhere by marking it as copy-on-write, so that its contents can't change anymore.
+bool PageMerger::write_protect(AnonymousVMObject& vmobject, size_t page_index, PhysicalPage const& page, bool& was_cow)
+{
+    VERIFY(vmobject.m_lock.is_locked_by_current_processor());
+    if (vmobject.m_physical_pages[page_index] != &page)
+        return false;
+    was_cow = !vmobject.m_cow_map.is_null() && vmobject.m_cow_map.get(page_index);
+    if (vmobject.set_should_cow(page_index, true).is_error())
+        return false;
+    if (!remap_page(vmobject, page_index)) {
+        undo_write_protect(vmobject, page_index, was_cow);
+        return false;
+    }
+    return true;
+}
+
+void PageMerger::undo_write_protect(AnonymousVMObject& vmobject, size_t page_index, bool was_cow)
+{
+    VERIFY(vmobject.m_lock.is_locked_by_current_processor());
+    // If the page has become shared since (e.g. by a fork), it has to stay copy-on-write.
+    if (was_cow || vmobject.m_physical_pages[page_index]->ref_count() > 2)
+        return;
+    MUST(vmobject.set_should_cow(page_index, false));
+    (void)remap_page(vmobject, page_index);
+}
+
+// NOTE: merge_page() and write_protect() call this with the VMObject lock held, so the page directory locks are taken
+//       inside of it. Region::handle_inode_fault() and AnonymousVMObject::purge() nest them the same way.
+bool PageMerger::remap_page(AnonymousVMObject& vmobject, size_t page_index)
+{
+    bool did_remap = true;
+    vmobject.for_each_region([&](Region& region) {
+        auto page_index_in_region = page_index;
+        if (!region.is_mapped() || !region.translate_vmobject_page(page_index_in_region))
+            return;
+        if (!region.remap_vmobject_page(page_index, *vmobject.m_physical_pages[page_index]))
+            did_remap = false;
+    });
+    return did_remap;
+}
+
+}
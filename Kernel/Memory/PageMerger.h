@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/HashMap.h>
+#include <AK/NonnullRefPtr.h>
+#include <AK/Types.h>
+#include <Kernel/Forward.h>
+
+namespace Kernel::Memory {
+
+// Looks for identical pages in the anonymous memory that processes marked with madvise(MADV_MERGEABLE), and lets
+// them share a single copy-on-write page. Pages that went back to all zeroes are given up for the shared zero page.
+//
+// Only pages that were the same for two passes in a row are considered, as the others are likely to be written to
+// again soon. Before pages are compared, they are made read-only everywhere, so that they can't change until they
+// have been replaced. Writing to a merged page copies it again, just like after a fork.
+class PageMerger {
+public:
+    static void spawn();
+
+    // How many pages are saved right now by sharing pages that had the same contents.
+    static size_t merged_page_count();
+    // How many pages have been given up for the shared zero page since boot.
+    static u64 merged_zero_page_count();
+
+private:
+    // The pages that have been merged, keyed by checksum. None of them is writable anywhere while it's in here.
+    using StablePages = HashMap<u32, NonnullRefPtr<PhysicalPage>>;
+
+    struct UnstablePage {
+        AnonymousVMObject* vmobject { nullptr };
+        size_t page_index { 0 };
+    };
+    // The pages that haven't changed since the last pass, but that nothing could be merged with yet, keyed by
+    // checksum. These are gathered again on every pass.
+    using UnstablePages = HashMap<u32, UnstablePage>;
+
+    static void scan(StablePages&);
+    static void scan_vmobject(AnonymousVMObject&, StablePages&, UnstablePages&);
+    static bool merge_page(AnonymousVMObject&, size_t page_index, PhysicalPage&, PhysicalPage& replacement);
+    static bool write_protect(AnonymousVMObject&, size_t page_index, PhysicalPage const&, bool& was_cow);
+    static void undo_write_protect(AnonymousVMObject&, size_t page_index, bool was_cow);
+    static bool remap_page(AnonymousVMObject&, size_t page_index);
+
+    static void copy_page(PhysicalPage&, u8* destination);
+    static bool page_has_contents(PhysicalPage&, u8 const* contents);
+};
+
+}
@@ -39,7 +39,7 @@ void PhysicalRegion::initialize_zones()
     size_t remaining_pages = m_pages;
     auto base_address = m_lower;
 
-    auto make_zones = [&](size_t zone_size) -> size_t {
+    auto make_zones = [&](size_t zone_size) {
         size_t pages_per_zone = zone_size / PAGE_SIZE;
         size_t zone_count = 0;
         auto first_address = base_address;
@@ -52,13 +52,24 @@ void PhysicalRegion::initialize_zones()
         }
         if (zone_count)
             dmesgln(" * {}x PhysicalZone ({} MiB) @ {:016x}-{:016x}", zone_count, pages_per_zone / 256, first_address.get(), base_address.get() - pages_per_zone * PAGE_SIZE - 1);
-        return zone_count;
     };
 
-    // First make 16 MiB zones (with 4096 pages each)
-    m_large_zones = make_zones(large_zone_size);
+    // Cover everything up to the first large page boundary with smaller zones, so that the large zones start on one.
+    // Their blocks are aligned to their base address, which makes the 2 MiB blocks they hand out usable as large pages.
+    while (remaining_pages > 0 && base_address.get() % large_page_size != 0) {
+        size_t pages_to_boundary = (large_page_size - base_address.get() % large_page_size) / PAGE_SIZE;
+        size_t pages_per_zone = min(pages_to_boundary, remaining_pages);
+        pages_per_zone = static_cast<size_t>(1) << (8 * sizeof(size_t) - 1 - count_leading_zeroes(pages_per_zone));
+        m_zones.append(adopt_nonnull_own_or_enomem(new (nothrow) PhysicalZone(base_address, pages_per_zone)).release_value_but_fixme_should_propagate_errors());
+        m_usable_zones.append(*m_zones.last());
+        base_address = base_address.offset(pages_per_zone * PAGE_SIZE);
+        remaining_pages -= pages_per_zone;
+    }
+
+    // Then make 16 MiB zones (with 4096 pages each)
+    make_zones(large_zone_size);
 
-    // Then divide any remaining space into 1 MiB zones (with 256 pages each)
+    // Finally divide any remaining space into 1 MiB zones (with 256 pages each)
     make_zones(small_zone_size);
 }
 
@@ -74,13 +85,19 @@ OwnPtr<PhysicalRegion> PhysicalRegion::try_take_pages_from_beginning(size_t page
     return try_create(taken_lower, taken_upper);
 }
 
-Vector<NonnullRefPtr<PhysicalPage>> PhysicalRegion::take_contiguous_free_pages(size_t count)
+Vector<NonnullRefPtr<PhysicalPage>> PhysicalRegion::take_contiguous_free_pages(size_t count, size_t alignment)
 {
     auto rounded_page_count = next_power_of_two(count);
     auto order = count_trailing_zeroes(rounded_page_count);
 
+    // NOTE: Blocks are aligned to their size relative to the base of their zone.
+    VERIFY(is_power_of_two(alignment));
+    VERIFY(rounded_page_count * PAGE_SIZE >= alignment);
+
     Optional<PhysicalAddress> page_base;
     for (auto& zone : m_usable_zones) {
+        if (zone.base().get() % alignment != 0)
+            continue;
         page_base = zone.allocate_block(order);
         if (page_base.has_value()) {
             if (zone.is_empty()) {
@@ -119,22 +136,29 @@ RefPtr<PhysicalPage> PhysicalRegion::take_free_page()
     return PhysicalPage::create(page.value());
 }
 
+PhysicalZone& PhysicalRegion::zone_containing(PhysicalAddress paddr)
+{
+    size_t low = 0;
+    size_t high = m_zones.size();
+    while (low + 1 < high) {
+        auto middle = low + (high - low) / 2;
+        if (paddr < m_zones[middle]->base())
+            high = middle;
+        else
+            low = middle;
+    }
+
+    auto& zone = *m_zones[low];
+    VERIFY(zone.contains(paddr));
+    return zone;
+}
+
 void PhysicalRegion::return_page(PhysicalAddress paddr)
 {
-    auto large_zone_base = lower().get();
-    auto small_zone_base = lower().get() + (m_large_zones * large_zone_size);
-
-    size_t zone_index;
-    if (paddr.get() < small_zone_base)
-        zone_index = (paddr.get() - large_zone_base) / large_zone_size;
-    else
-        zone_index = m_large_zones + (paddr.get() - small_zone_base) / small_zone_size;
-
-    auto& zone = m_zones[zone_index];
-    VERIFY(zone->contains(paddr));
-    zone->deallocate_block(paddr, 0);
-    if (m_full_zones.contains(*zone))
-        m_usable_zones.append(*zone);
+    auto& zone = zone_containing(paddr);
+    zone.deallocate_block(paddr, 0);
+    if (m_full_zones.contains(zone))
+        m_usable_zones.append(zone);
 }
 
 }
@@ -35,7 +35,7 @@ public:
     OwnPtr<PhysicalRegion> try_take_pages_from_beginning(size_t);
 
     RefPtr<PhysicalPage> take_free_page();
-    Vector<NonnullRefPtr<PhysicalPage>> take_contiguous_free_pages(size_t count);
+    Vector<NonnullRefPtr<PhysicalPage>> take_contiguous_free_pages(size_t count, size_t alignment = PAGE_SIZE);
     void return_page(PhysicalAddress);
 
 private:
@@ -44,9 +44,10 @@ private:
     static constexpr size_t large_zone_size = 16 * MiB;
     static constexpr size_t small_zone_size = 1 * MiB;
 
-    Vector<NonnullOwnPtr<PhysicalZone>> m_zones;
+    PhysicalZone& zone_containing(PhysicalAddress);
 
-    size_t m_large_zones { 0 };
+    // NOTE: These are sorted by their base address.
+    Vector<NonnullOwnPtr<PhysicalZone>> m_zones;
 
     PhysicalZone::List m_usable_zones;
     PhysicalZone::List m_full_zones;
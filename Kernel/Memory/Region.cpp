@@ -21,6 +21,9 @@
 
 namespace Kernel::Memory {
 
+// How many pages around a faulting page of a file mapping are mapped along with it when they're already in memory.
+static constexpr size_t fault_around_page_count = 16;
+
 Region::Region()
     : m_range(VirtualRange({}, 0))
 {
@@ -126,8 +129,9 @@ ErrorOr<NonnullOwnPtr<Region>> Region::try_clone()
     auto vmobject_clone = TRY(vmobject().try_clone());
 
     // Set up a COW region. The parent (this) region becomes COW as well!
+    // NOTE: The caller has to flush the TLB for this region, so it can do that for all regions it clones at once.
     if (is_writable())
-        remap();
+        TRY(map(*m_page_directory, ShouldFlushTLB::No));
 
     OwnPtr<KString> clone_region_name;
     if (m_name)
@@ -246,6 +250,77 @@ bool Region::map_individual_page_impl(size_t page_index, RefPtr<PhysicalPage> pa
     return true;
 }
 
+#if ARCH(X86_64)
+// Maps the large page starting at `page_index` if it lies within this region and is backed by a large block of
+// physical memory that would be mapped the same way all over. Otherwise, its pages have to be mapped one by one.
+bool Region::map_large_page_impl(size_t page_index)
+{
+    VERIFY(m_page_directory->get_lock().is_locked_by_current_processor());
+
+    auto page_vaddr = vaddr_from_page_index(page_index);
+    if (page_vaddr.get() % large_page_size != 0 || page_index + pages_per_large_page > page_count())
+        return false;
+    // NOTE: Kernel mappings of physical ranges are backed by anonymous VMObjects too, so they qualify.
+    if (!vmobject().is_anonymous() || is_write_combine() || (!is_readable() && !is_writable()))
+        return false;
+
+    bool user_allowed = page_vaddr.get() >= USER_RANGE_BASE && is_user_address(page_vaddr);
+    if (is_mmap() && !user_allowed) {
+        PANIC("About to map mmap'ed page at a kernel address");
+    }
+
+    SpinlockLocker vmobject_locker(vmobject().m_lock);
+    auto const& first_page = physical_page_slot(page_index);
+    if (!first_page || first_page->paddr().get() % large_page_size != 0)
+        return false;
+    for (size_t i = 0; i < pages_per_large_page; ++i) {
+        auto const& page = physical_page_slot(page_index + i);
+        if (!page || page->paddr() != first_page->paddr().offset(i * PAGE_SIZE) || should_cow(page_index + i))
+            return false;
+    }
+
+    auto* pde = MM.ensure_large_page_pde(*m_page_directory, page_vaddr);
+    pde->clear();
+    pde->set_page_table_base(first_page->paddr().get());
+    pde->set_huge(true);
+    pde->set_present(true);
+    pde->set_cache_disabled(!m_cacheable);
+    pde->set_writable(is_writable());
+    if (Processor::current().has_nx())
+        pde->set_execute_disabled(!is_executable());
+    pde->set_user_allowed(user_allowed);
+    return true;
+}
+
+// Backs the whole large page around a page that is about to be written to for the first time with a large block of
+// physical memory, if the large page lies within this region and hasn't been written to anywhere yet.
+bool Region::try_fault_in_large_page(size_t page_index_in_region)
+{
+    VERIFY(vmobject().is_anonymous());
+    if (is_shared() || is_stack())
+        return false;
+
+    auto large_page_vaddr = VirtualAddress { vaddr_from_page_index(page_index_in_region).get() & ~(large_page_size - 1) };
+    if (large_page_vaddr < vaddr() || large_page_vaddr.offset(large_page_size) > range().end())
+        return false;
+    auto first_page_index = (large_page_vaddr - vaddr()).get() / PAGE_SIZE;
+
+    auto& anonymous_vmobject = static_cast<AnonymousVMObject&>(vmobject());
+    if (!anonymous_vmobject.try_allocate_committed_large_page({}, translate_to_vmobject_page(first_page_index)))
+        return false;
+
+    SpinlockLocker page_lock(m_page_directory->get_lock());
+    if (!map_large_page_impl(first_page_index)) {
+        for (size_t i = 0; i < pages_per_large_page; ++i) {
+            if (!map_individual_page_impl(first_page_index + i))
+                return false;
+        }
+    }
+    MemoryManager::flush_tlb(m_page_directory, large_page_vaddr, pages_per_large_page);
+    return true;
+}
+#endif
+
 bool Region::map_individual_page_impl(size_t page_index)
 {
     RefPtr<PhysicalPage> page;
@@ -310,6 +385,12 @@ ErrorOr<void> Region::map(PageDirectory& page_directory, ShouldFlushTLB should_f
     set_page_directory(page_directory);
     size_t page_index = 0;
     while (page_index < page_count()) {
+#if ARCH(X86_64)
+        if (map_large_page_impl(page_index)) {
+            page_index += pages_per_large_page;
+            continue;
+        }
+#endif
         if (!map_individual_page_impl(page_index))
             break;
         ++page_index;
@@ -383,6 +464,22 @@ PageFaultResponse Region::handle_fault(PageFault const& fault)
                 return PageFaultResponse::OutOfMemory;
             return PageFaultResponse::Continue;
         }
+        if (page_slot) {
+            // The page is there, it just hasn't been mapped in this address space yet. fork() leaves that to the
+            // first access, so the child doesn't pay for the parts of the address space it never touches.
+            NonnullRefPtr<PhysicalPage> page = *page_slot;
+            if (fault.is_write() && should_cow(page_index_in_region)) {
+                vmobject_locker.unlock();
+                dbgln_if(PAGE_FAULT_DEBUG, "NP(cow) fault in Region({})[{}] at {}", this, page_index_in_region, fault.vaddr());
+                if (page->is_shared_zero_page())
+                    return handle_zero_fault(page_index_in_region, *page);
+                return handle_cow_fault(page_index_in_region);
+            }
+            dbgln_if(PAGE_FAULT_DEBUG, "NP(unmapped) fault in Region({})[{}] at {}", this, page_index_in_region, fault.vaddr());
+            if (!remap_vmobject_page(translate_to_vmobject_page(page_index_in_region), move(page)))
+                return PageFaultResponse::OutOfMemory;
+            return PageFaultResponse::Continue;
+        }
         dbgln("BUG! Unexpected NP fault at {}", fault.vaddr());
         dbgln("     - Physical page slot pointer: {:p}", page_slot.ptr());
         if (page_slot) {
@@ -416,6 +513,11 @@ PageFaultResponse Region::handle_zero_fault(size_t page_index_in_region, Physica
     if (current_thread != nullptr)
         current_thread->did_zero_fault();
 
+#if ARCH(X86_64)
+    if (page_in_slot_at_time_of_fault.is_lazy_committed_page() && try_fault_in_large_page(page_index_in_region))
+        return PageFaultResponse::Continue;
+#endif
+
     RefPtr<PhysicalPage> new_physical_page;
 
     if (page_in_slot_at_time_of_fault.is_lazy_committed_page()) {
@@ -487,6 +589,8 @@ PageFaultResponse Region::handle_inode_fault(size_t page_index_in_region)
             dbgln_if(PAGE_FAULT_DEBUG, "handle_inode_fault: Page faulted in by someone else before reading, remapping.");
             if (!remap_vmobject_page(page_index_in_vmobject, *vmobject_physical_page_slot))
                 return PageFaultResponse::OutOfMemory;
+            locker.unlock();
+            did_handle_inode_fault(page_index_in_region);
             return PageFaultResponse::Continue;
         }
     }
@@ -552,9 +656,65 @@ PageFaultResponse Region::handle_inode_fault(size_t page_index_in_region)
     if (!remap_vmobject_page(page_index_in_vmobject, *vmobject_physical_page_slot))
         return PageFaultResponse::OutOfMemory;
 
+    did_handle_inode_fault(page_index_in_region);
     return PageFaultResponse::Continue;
 }
 
+void Region::did_handle_inode_fault(size_t page_index_in_region)
+{
+    auto& inode_vmobject = static_cast<InodeVMObject&>(vmobject());
+    auto page_index_in_vmobject = translate_to_vmobject_page(page_index_in_region);
+
+    Optional<ReadAheadRange> read_ahead;
+    AccessPattern access_pattern;
+    {
+        SpinlockLocker locker(inode_vmobject.m_lock);
+        read_ahead = m_read_ahead.did_read(page_index_in_vmobject * PAGE_SIZE, PAGE_SIZE);
+        access_pattern = m_read_ahead.access_pattern();
+    }
+    if (read_ahead.has_value())
+        inode_vmobject.inode().queue_read_ahead(read_ahead->offset, read_ahead->size);
+
+    if (access_pattern == AccessPattern::Random)
+        return;
+
+    // Fault-around: Map any neighbors of the faulting page that are already in memory, so touching them doesn't
+    // cost another page fault each. We don't read anything in for this; that's left to read-ahead.
+    size_t first_page_index = page_index_in_region - page_index_in_region % fault_around_page_count;
+    size_t end_page_index = min(first_page_index + fault_around_page_count, page_count());
+
+    SpinlockLocker page_lock(m_page_directory->get_lock());
+    size_t mapped_page_count = 0;
+    for (size_t page_index = first_page_index; page_index < end_page_index; ++page_index) {
+        if (page_index == page_index_in_region)
+            continue;
+        RefPtr<PhysicalPage> page;
+        {
+            SpinlockLocker vmobject_locker(inode_vmobject.m_lock);
+            page = physical_page_slot(page_index);
+        }
+        if (!page)
+            continue;
+        if (!map_individual_page_impl(page_index, page))
+            break;
+        ++mapped_page_count;
+    }
+    if (mapped_page_count > 0)
+        MemoryManager::flush_tlb(m_page_directory, vaddr_from_page_index(first_page_index), end_page_index - first_page_index);
+}
+
+AccessPattern Region::access_pattern() const
+{
+    SpinlockLocker locker(vmobject().m_lock);
+    return m_read_ahead.access_pattern();
+}
+
+void Region::set_access_pattern(AccessPattern access_pattern)
+{
+    SpinlockLocker locker(vmobject().m_lock);
+    m_read_ahead.set_access_pattern(access_pattern);
+}
+
 RefPtr<PhysicalPage> Region::physical_page(size_t index) const
 {
     SpinlockLocker vmobject_locker(vmobject().m_lock);
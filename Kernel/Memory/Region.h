@@ -10,6 +10,7 @@
 #include <AK/EnumBits.h>
 #include <AK/IntrusiveList.h>
 #include <AK/IntrusiveRedBlackTree.h>
+#include <Kernel/FileSystem/ReadAheadState.h>
 #include <Kernel/Forward.h>
 #include <Kernel/Library/KString.h>
 #include <Kernel/Library/LockWeakable.h>
@@ -34,6 +35,7 @@ class Region final
     : public LockWeakable<Region> {
     friend class AddressSpace;
     friend class MemoryManager;
+    friend class PageMerger;
     friend class RegionTree;
 
 public:
@@ -207,6 +209,9 @@ public:
     [[nodiscard]] bool mmapped_from_readable() const { return m_mmapped_from_readable; }
     [[nodiscard]] bool mmapped_from_writable() const { return m_mmapped_from_writable; }
 
+    [[nodiscard]] AccessPattern access_pattern() const;
+    void set_access_pattern(AccessPattern);
+
     void start_handling_page_fault(Badge<MemoryManager>) { m_in_progress_page_faults++; }
     void finish_handling_page_fault(Badge<MemoryManager>) { m_in_progress_page_faults--; }
 
@@ -227,10 +232,15 @@ private:
 
     [[nodiscard]] PageFaultResponse handle_cow_fault(size_t page_index);
     [[nodiscard]] PageFaultResponse handle_inode_fault(size_t page_index);
+    void did_handle_inode_fault(size_t page_index_in_region);
     [[nodiscard]] PageFaultResponse handle_zero_fault(size_t page_index, PhysicalPage& page_in_slot_at_time_of_fault);
 
     [[nodiscard]] bool map_individual_page_impl(size_t page_index);
     [[nodiscard]] bool map_individual_page_impl(size_t page_index, RefPtr<PhysicalPage>);
+#if ARCH(X86_64)
+    [[nodiscard]] bool map_large_page_impl(size_t page_index);
+    [[nodiscard]] bool try_fault_in_large_page(size_t page_index_in_region);
+#endif
 
     LockRefPtr<PageDirectory> m_page_directory;
     VirtualRange m_range;
@@ -249,6 +259,9 @@ private:
     bool m_mmapped_from_readable : 1 { false };
     bool m_mmapped_from_writable : 1 { false };
 
+    // NOTE: This is protected by the VMObject's lock.
+    ReadAheadState m_read_ahead;
+
     IntrusiveRedBlackTreeNode<FlatPtr, Region, RawPtr<Region>> m_tree_node;
     IntrusiveListNode<Region> m_vmobject_list_node;
 
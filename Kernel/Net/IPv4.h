@@ -121,4 +121,39 @@ inline NetworkOrdered<u16> internet_checksum(void const* ptr, size_t count)
     return ~checksum & 0xffff;
 }
 
+// Adds up bytes as 16-bit words in network order, the way TCP and UDP checksums do, without folding or complementing.
+inline u32 add_to_internet_checksum(u32 checksum, void const* ptr, size_t count)
+{
+    auto* bytes = static_cast<u8 const*>(ptr);
+    for (; count > 1; count -= 2, bytes += 2) {
+        checksum += (bytes[0] << 8) | bytes[1];
+        if (checksum & 0x80000000)
+            checksum = (checksum & 0xffff) + (checksum >> 16);
+    }
+    if (count)
+        checksum += bytes[0] << 8;
+    while (checksum >> 16)
+        checksum = (checksum & 0xffff) + (checksum >> 16);
+    return checksum;
+}
+
+// The sum over the pseudo-header of a TCP or UDP packet, which is where adapters that offload the checksum start from.
+inline u16 pseudo_header_checksum(IPv4Address const& source, IPv4Address const& destination, IPv4Protocol protocol, u16 length)
+{
+    u32 checksum = (source[0] << 8 | source[1]) + (source[2] << 8 | source[3]);
+    checksum += (destination[0] << 8 | destination[1]) + (destination[2] << 8 | destination[3]);
+    checksum += to_underlying(protocol) + length;
+    while (checksum >> 16)
+        checksum = (checksum & 0xffff) + (checksum >> 16);
+    return checksum;
+}
+
+// Whether the checksum of the TCP or UDP packet in `packet` is right. It covers the pseudo-header and the whole
+// payload of the IPv4 packet, so that has to have been checked to fit into the frame.
+inline bool transport_checksum_is_valid(IPv4Packet const& packet)
+{
+    u32 checksum = pseudo_header_checksum(packet.source(), packet.destination(), static_cast<IPv4Protocol>(packet.protocol()), packet.payload_size());
+    return add_to_internet_checksum(checksum, packet.payload(), packet.payload_size()) == 0xffff;
+}
+
 }
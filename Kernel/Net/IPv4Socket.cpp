@@ -38,7 +38,7 @@ MutexProtected<IPv4Socket::List>& IPv4Socket::all_sockets()
 
 ErrorOr<NonnullOwnPtr<DoubleBuffer>> IPv4Socket::try_create_receive_buffer()
 {
-    return DoubleBuffer::try_create("IPv4Socket: Receive buffer"sv, 256 * KiB);
+    return DoubleBuffer::try_create("IPv4Socket: Receive buffer"sv, receive_buffer_size);
 }
 
 ErrorOr<NonnullRefPtr<Socket>> IPv4Socket::create(int type, int protocol)
@@ -152,6 +152,16 @@ ErrorOr<void> IPv4Socket::listen(size_t backlog)
 }
 
 ErrorOr<void> IPv4Socket::connect(Credentials const&, OpenFileDescription& description, Userspace<sockaddr const*> address, socklen_t address_size)
+{
+    return connect_impl(description, address, address_size, description.is_blocking());
+}
+
+ErrorOr<void> IPv4Socket::connect_without_blocking(OpenFileDescription& description, Userspace<sockaddr const*> address, socklen_t address_size)
+{
+    return connect_impl(description, address, address_size, false);
+}
+
+ErrorOr<void> IPv4Socket::connect_impl(OpenFileDescription& description, Userspace<sockaddr const*> address, socklen_t address_size, bool blocking)
 {
     if (address_size != sizeof(sockaddr_in))
         return set_so_error(EINVAL);
@@ -171,7 +181,7 @@ ErrorOr<void> IPv4Socket::connect(Credentials const&, OpenFileDescription& descr
         m_peer_address = IPv4Address { 127, 0, 0, 1 };
     m_peer_port = ntohs(safe_address.sin_port);
 
-    return protocol_connect(description);
+    return protocol_connect(description, blocking);
 }
 
 bool IPv4Socket::can_read(OpenFileDescription const&, u64) const
@@ -279,8 +289,10 @@ ErrorOr<size_t> IPv4Socket::receive_byte_buffered(OpenFileDescription& descripti
     else
         nreceived_or_error = m_receive_buffer->read(buffer, buffer_length);
 
-    if (!nreceived_or_error.is_error() && nreceived_or_error.value() > 0 && !(flags & MSG_PEEK))
+    if (!nreceived_or_error.is_error() && nreceived_or_error.value() > 0 && !(flags & MSG_PEEK)) {
         Thread::current()->did_ipv4_socket_read(nreceived_or_error.value());
+        protocol_did_consume_received_data();
+    }
 
     set_can_read(!m_receive_buffer->is_empty());
     return nreceived_or_error;
@@ -898,4 +910,11 @@ void IPv4Socket::drop_receive_buffer()
     m_receive_buffer = nullptr;
 }
 
+size_t IPv4Socket::receive_buffer_space() const
+{
+    if (!m_receive_buffer)
+        return 0;
+    return m_receive_buffer->space_for_writing();
+}
+
 }
@@ -29,6 +29,9 @@ public:
     virtual ErrorOr<void> close() override;
     virtual ErrorOr<void> bind(Credentials const&, Userspace<sockaddr const*>, socklen_t) override;
     virtual ErrorOr<void> connect(Credentials const&, OpenFileDescription&, Userspace<sockaddr const*>, socklen_t) override;
+    // Like connect() on a non-blocking description. Once setup_state() is Completed, connect_result() tells how it went.
+    ErrorOr<void> connect_without_blocking(OpenFileDescription&, Userspace<sockaddr const*>, socklen_t);
+    virtual ErrorOr<void> connect_result() { return {}; }
     virtual ErrorOr<void> listen(size_t) override;
     virtual void get_local_address(sockaddr*, socklen_t*) override;
     virtual void get_peer_address(sockaddr*, socklen_t*) override;
@@ -78,21 +81,26 @@ protected:
     virtual ErrorOr<void> protocol_listen() { return {}; }
     virtual ErrorOr<size_t> protocol_receive(ReadonlyBytes /* raw_ipv4_packet */, UserOrKernelBuffer&, size_t, int) { return ENOTIMPL; }
     virtual ErrorOr<size_t> protocol_send(UserOrKernelBuffer const&, size_t) { return ENOTIMPL; }
-    virtual ErrorOr<void> protocol_connect(OpenFileDescription&) { return {}; }
+    virtual ErrorOr<void> protocol_connect(OpenFileDescription&, bool /* blocking */) { return {}; }
     virtual ErrorOr<size_t> protocol_size(ReadonlyBytes /* raw_ipv4_packet */) { return ENOTIMPL; }
     virtual bool protocol_is_disconnected() const { return false; }
+    // Called after data has been read out of the receive buffer, making room for more.
+    virtual void protocol_did_consume_received_data() { }
 
     virtual void shut_down_for_reading() override;
 
     void set_local_address(IPv4Address address) { m_local_address = address; }
     void set_peer_address(IPv4Address address) { m_peer_address = address; }
 
+    static constexpr size_t receive_buffer_size = 256 * KiB;
     static ErrorOr<NonnullOwnPtr<DoubleBuffer>> try_create_receive_buffer();
     void drop_receive_buffer();
+    size_t receive_buffer_space() const;
 
 private:
     virtual bool is_ipv4() const override { return true; }
 
+    ErrorOr<void> connect_impl(OpenFileDescription&, Userspace<sockaddr const*>, socklen_t, bool blocking);
     ErrorOr<size_t> receive_byte_buffered(OpenFileDescription&, UserOrKernelBuffer& buffer, size_t buffer_length, int flags, Userspace<sockaddr*>, Userspace<socklen_t*>, bool blocking);
     ErrorOr<size_t> receive_packet_buffered(OpenFileDescription&, UserOrKernelBuffer& buffer, size_t buffer_length, int flags, Userspace<sockaddr*>, Userspace<socklen_t*>, UnixDateTime&, bool blocking);
 
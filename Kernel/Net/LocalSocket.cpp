@@ -161,6 +161,25 @@ ErrorOr<void> LocalSocket::bind(Credentials const& credentials, Userspace<sockad
 }
 
 ErrorOr<void> LocalSocket::connect(Credentials const& credentials, OpenFileDescription& description, Userspace<sockaddr const*> user_address, socklen_t address_size)
+{
+    return connect_impl(credentials, description, user_address, address_size, true);
+}
+
+ErrorOr<void> LocalSocket::connect_without_blocking(Credentials const& credentials, OpenFileDescription& description, Userspace<sockaddr const*> user_address, socklen_t address_size)
+{
+    return connect_impl(credentials, description, user_address, address_size, false);
+}
+
+ErrorOr<void> LocalSocket::finish_connect()
+{
+    VERIFY(m_connect_side_role == Role::Connecting);
+    if (!is_connected())
+        return EAGAIN;
+    set_connect_side_role(Role::Connected);
+    return {};
+}
+
+ErrorOr<void> LocalSocket::connect_impl(Credentials const& credentials, OpenFileDescription& description, Userspace<sockaddr const*> user_address, socklen_t address_size, bool blocking)
 {
     VERIFY(!m_bound);
 
@@ -205,6 +224,9 @@ ErrorOr<void> LocalSocket::connect(Credentials const& credentials, OpenFileDescr
         return {};
     }
 
+    if (!blocking)
+        return set_so_error(EINPROGRESS);
+
     auto unblock_flags = Thread::OpenFileDescriptionBlocker::BlockFlags::None;
     if (Thread::current()->block<Thread::ConnectBlocker>({}, description, unblock_flags).was_interrupted()) {
         set_connect_side_role(Role::None);
@@ -39,6 +39,10 @@ public:
     // ^Socket
     virtual ErrorOr<void> bind(Credentials const&, Userspace<sockaddr const*>, socklen_t) override;
     virtual ErrorOr<void> connect(Credentials const&, OpenFileDescription&, Userspace<sockaddr const*>, socklen_t) override;
+    // Like connect(), but returns EINPROGRESS instead of waiting for the other side to accept.
+    // finish_connect() returns EAGAIN until it has, and completes the connection after that.
+    ErrorOr<void> connect_without_blocking(Credentials const&, OpenFileDescription&, Userspace<sockaddr const*>, socklen_t);
+    ErrorOr<void> finish_connect();
     virtual ErrorOr<void> listen(size_t) override;
     virtual void get_local_address(sockaddr*, socklen_t*) override;
     virtual void get_peer_address(sockaddr*, socklen_t*) override;
@@ -58,6 +62,7 @@ private:
     virtual StringView class_name() const override { return "LocalSocket"sv; }
     virtual bool is_local() const override { return true; }
     bool has_attached_peer(OpenFileDescription const&) const;
+    ErrorOr<void> connect_impl(Credentials const&, OpenFileDescription&, Userspace<sockaddr const*>, socklen_t, bool blocking);
     DoubleBuffer* receive_buffer_for(OpenFileDescription&);
     DoubleBuffer* send_buffer_for(OpenFileDescription&);
     Vector<NonnullRefPtr<OpenFileDescription>>& sendfd_queue_for(OpenFileDescription const&);
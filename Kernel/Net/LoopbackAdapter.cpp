@@ -5,11 +5,15 @@
  */
 
 #include <AK/Singleton.h>
+#include <Kernel/Net/IPv4.h>
 #include <Kernel/Net/LoopbackAdapter.h>
+#include <Kernel/Net/TCP.h>
+#include <Kernel/Security/Random.h>
 
 namespace Kernel {
 
 static bool s_loopback_initialized = false;
+static Atomic<u32> s_packet_loss_interval { 0 };
 
 ErrorOr<NonnullRefPtr<LoopbackAdapter>> LoopbackAdapter::try_create()
 {
@@ -22,15 +26,69 @@ LoopbackAdapter::LoopbackAdapter(StringView interface_name)
     VERIFY(!s_loopback_initialized);
     s_loopback_initialized = true;
     set_mtu(65536);
+    // Nothing can corrupt packets on the way to ourselves, so there's no point in checksumming them.
+    // Segmentation is done in software, but it lets connections with a small MSS (see TCP_MAXSEG) try out that path.
+    set_offloads(Offload::TransmitChecksum | Offload::ReceiveChecksum | Offload::TCPSegmentation);
     set_mac_address({ 19, 85, 2, 9, 0x55, 0xaa });
 }
 
 LoopbackAdapter::~LoopbackAdapter() = default;
 
+u32 LoopbackAdapter::packet_loss_interval()
+{
+    return s_packet_loss_interval.load(AK::memory_order_relaxed);
+}
+
+void LoopbackAdapter::set_packet_loss_interval(u32 interval)
+{
+    s_packet_loss_interval.store(interval, AK::memory_order_relaxed);
+}
+
 void LoopbackAdapter::send_raw(ReadonlyBytes payload)
 {
+    if (auto interval = packet_loss_interval(); interval != 0 && get_fast_random<u32>() % interval == 0) {
+        dbgln_if(LOOPBACK_DEBUG, "LoopbackAdapter: Dropping {} byte(s) on purpose.", payload.size());
+        return;
+    }
     dbgln_if(LOOPBACK_DEBUG, "LoopbackAdapter: Sending {} byte(s) to myself.", payload.size());
-    did_receive(payload);
+    did_receive(payload, true);
+}
+
+void LoopbackAdapter::send_raw_with_offload(ReadonlyBytes payload, TransmitOffload const& offload)
+{
+    if (offload.segment_size == 0) {
+        send_raw(payload);
+        return;
+    }
+
+    // Cut the frame into segments the way a network card would, each with a copy of the headers.
+    auto const& tcp_packet = *reinterpret_cast<TCPPacket const*>(payload.offset(offload.checksum_start));
+    auto headers_size = offload.checksum_start + tcp_packet.header_size();
+    auto payload_size = payload.size() - headers_size;
+    for (size_t offset = 0; offset < payload_size; offset += offload.segment_size) {
+        auto length = min(static_cast<size_t>(offload.segment_size), payload_size - offset);
+        auto segment = acquire_packet_buffer(headers_size + length);
+        if (!segment) {
+            dbgln("LoopbackAdapter: Dropping segment because acquire_packet_buffer() failed");
+            continue;
+        }
+        auto* segment_data = segment->buffer->data();
+        memcpy(segment_data, payload.data(), headers_size);
+        memcpy(segment_data + headers_size, payload.offset(headers_size + offset), length);
+
+        auto& ipv4_packet = *reinterpret_cast<IPv4Packet*>(segment_data + layer3_payload_offset());
+        ipv4_packet.set_length(headers_size - layer3_payload_offset() + length);
+        ipv4_packet.set_checksum(0);
+        ipv4_packet.set_checksum(ipv4_packet.compute_checksum());
+
+        auto& segment_tcp_packet = *reinterpret_cast<TCPPacket*>(segment_data + offload.checksum_start);
+        segment_tcp_packet.set_sequence_number(tcp_packet.sequence_number() + offset);
+        if (offset + length != payload_size)
+            segment_tcp_packet.set_flags(tcp_packet.flags() & ~(TCPFlags::FIN | TCPFlags::PSH));
+
+        send_raw(segment->bytes());
+        release_packet_buffer(*segment);
+    }
 }
 
 }
@@ -5,7 +5,6 @@
  */
 
 #include <Kernel/Heap/kmalloc.h>
-#include <Kernel/Interrupts/InterruptDisabler.h>
 #include <Kernel/Library/StdLib.h>
 #include <Kernel/Net/EtherType.h>
 #include <Kernel/Net/NetworkAdapter.h>
@@ -14,6 +13,8 @@
 
 namespace Kernel {
 
+DEFINE_SLAB_CACHE(PacketWithTimestamp);
+
 NetworkAdapter::NetworkAdapter(StringView interface_name)
 {
     m_name.store_characters(interface_name);
@@ -21,11 +22,29 @@ NetworkAdapter::NetworkAdapter(StringView interface_name)
 
 NetworkAdapter::~NetworkAdapter() = default;
 
-void NetworkAdapter::send_packet(ReadonlyBytes packet)
+void NetworkAdapter::set_offloads(Offload offloads)
+{
+    VERIFY(!has_flag(offloads, Offload::TCPSegmentation) || has_flag(offloads, Offload::TransmitChecksum));
+    m_offloads = offloads;
+}
+
+bool NetworkAdapter::can_offload(TransmitOffload const& offload) const
+{
+    if (offload.needs_checksum() && !has_offload(Offload::TransmitChecksum))
+        return false;
+    if (offload.segment_size != 0 && !has_offload(Offload::TCPSegmentation))
+        return false;
+    return true;
+}
+
+void NetworkAdapter::send_packet(ReadonlyBytes packet, TransmitOffload const& offload)
 {
     m_packets_out++;
     m_bytes_out += packet.size();
-    send_raw(packet);
+    if (offload.is_empty())
+        return send_raw(packet);
+    VERIFY(can_offload(offload));
+    send_raw_with_offload(packet, offload);
 }
 
 void NetworkAdapter::send(MACAddress const& destination, ARPPacket const& packet)
@@ -47,7 +66,8 @@ void NetworkAdapter::send(MACAddress const& destination, ARPPacket const& packet
 void NetworkAdapter::fill_in_ipv4_header(PacketWithTimestamp& packet, IPv4Address const& source_ipv4, MACAddress const& destination_mac, IPv4Address const& destination_ipv4, IPv4Protocol protocol, size_t payload_size, u8 type_of_service, u8 ttl)
 {
     size_t ipv4_packet_size = sizeof(IPv4Packet) + payload_size;
-    VERIFY(ipv4_packet_size <= mtu());
+    // Segmentation offload cuts larger packets down to the MTU on the way out.
+    VERIFY(ipv4_packet_size <= (has_offload(Offload::TCPSegmentation) ? NumericLimits<u16>::max() : mtu()));
 
     size_t ethernet_frame_size = ipv4_payload_offset() + payload_size;
     VERIFY(packet.buffer->size() == ethernet_frame_size);
@@ -69,13 +89,20 @@ void NetworkAdapter::fill_in_ipv4_header(PacketWithTimestamp& packet, IPv4Addres
     ipv4.set_checksum(ipv4.compute_checksum());
 }
 
-void NetworkAdapter::did_receive(ReadonlyBytes payload)
+void NetworkAdapter::did_receive(ReadonlyBytes payload, bool checksum_is_verified)
 {
-    InterruptDisabler disabler;
-    m_packets_in++;
-    m_bytes_in += payload.size();
+    queue_received_packet(payload, checksum_is_verified);
+    did_queue_received_packets();
+}
 
-    if (m_packet_queue_size == max_packet_buffers) {
+void NetworkAdapter::queue_received_packet(ReadonlyBytes payload, bool checksum_is_verified)
+{
+    auto queue_is_full = m_receive_queues.with([&](auto& queues) {
+        m_packets_in++;
+        m_bytes_in += payload.size();
+        return queues.size >= max_packet_buffers;
+    });
+    if (queue_is_full) {
         // FIXME: Keep track of the number of dropped packets
         return;
     }
@@ -87,22 +114,45 @@ void NetworkAdapter::did_receive(ReadonlyBytes payload)
     }
 
     memcpy(packet->buffer->data(), payload.data(), payload.size());
+    packet->checksum_is_verified = checksum_is_verified;
 
-    m_packet_queue.append(*packet);
-    m_packet_queue_size++;
+    auto receive_worker = NetworkTask::receive_worker_for_frame(payload);
+    m_receive_queues.with([&](auto& queues) {
+        queues.packets[receive_worker].append(*packet);
+        queues.size++;
+        queues.pending_workers |= 1u << receive_worker;
+    });
+}
+
+void NetworkAdapter::did_queue_received_packets()
+{
+    auto pending_workers = m_receive_queues.with([](auto& queues) { return exchange(queues.pending_workers, 0); });
+    if (!on_receive)
+        return;
+    for (size_t receive_worker = 0; pending_workers != 0; ++receive_worker, pending_workers >>= 1) {
+        if (pending_workers & 1)
+            on_receive(receive_worker);
+    }
+}
 
-    if (on_receive)
-        on_receive();
+bool NetworkAdapter::has_queued_packets(size_t receive_worker) const
+{
+    return m_receive_queues.with([&](auto const& queues) { return !queues.packets[receive_worker].is_empty(); });
 }
 
-size_t NetworkAdapter::dequeue_packet(u8* buffer, size_t buffer_size, UnixDateTime& packet_timestamp)
+size_t NetworkAdapter::dequeue_packet(size_t receive_worker, u8* buffer, size_t buffer_size, UnixDateTime& packet_timestamp, bool& checksum_is_verified)
 {
-    InterruptDisabler disabler;
-    if (m_packet_queue.is_empty())
+    auto packet_with_timestamp = m_receive_queues.with([&](auto& queues) -> RefPtr<PacketWithTimestamp> {
+        auto& packets = queues.packets[receive_worker];
+        if (packets.is_empty())
+            return nullptr;
+        queues.size--;
+        return packets.take_first();
+    });
+    if (!packet_with_timestamp)
         return 0;
-    auto packet_with_timestamp = m_packet_queue.take_first();
-    m_packet_queue_size--;
     packet_timestamp = packet_with_timestamp->timestamp;
+    checksum_is_verified = packet_with_timestamp->checksum_is_verified;
     auto& packet_buffer = packet_with_timestamp->buffer;
     size_t packet_size = packet_buffer->size();
     VERIFY(packet_size <= buffer_size);
@@ -128,6 +178,8 @@ RefPtr<PacketWithTimestamp> NetworkAdapter::acquire_packet_buffer(size_t size)
 
     if (packet) {
         packet->timestamp = kgettimeofday();
+        packet->transmit_offload = {};
+        packet->checksum_is_verified = false;
         packet->buffer->set_size(size);
         return packet;
     }
@@ -6,8 +6,10 @@
 
 #pragma once
 
+#include <AK/Array.h>
 #include <AK/AtomicRefCounted.h>
 #include <AK/ByteBuffer.h>
+#include <AK/EnumBits.h>
 #include <AK/Function.h>
 #include <AK/IntrusiveList.h>
 #include <AK/MACAddress.h>
@@ -21,6 +23,7 @@
 #include <Kernel/Net/EthernetFrameHeader.h>
 #include <Kernel/Net/ICMP.h>
 #include <Kernel/Net/IPv4.h>
+#include <Kernel/Net/NetworkTask.h>
 
 namespace Kernel {
 
@@ -28,6 +31,20 @@ class NetworkAdapter;
 
 using NetworkByteBuffer = AK::Detail::ByteBuffer<1500>;
 
+// Work on an outgoing frame that the network stack leaves to an adapter which advertises the matching offloads.
+struct TransmitOffload {
+    // The checksum over the bytes from `checksum_start` to the end of the frame goes into the 16 bits at
+    // `checksum_start + checksum_offset`, which hold the (uncomplemented) checksum of the pseudo-header until then.
+    u16 checksum_start { 0 };
+    u16 checksum_offset { 0 };
+    // The TCP payload is cut into segments of this many bytes, which each get a copy of the headers. 0 means the frame
+    // is sent as it is.
+    u16 segment_size { 0 };
+
+    bool needs_checksum() const { return checksum_start != 0; }
+    bool is_empty() const { return !needs_checksum() && segment_size == 0; }
+};
+
 struct PacketWithTimestamp final : public AtomicRefCounted<PacketWithTimestamp> {
     PacketWithTimestamp(NonnullOwnPtr<KBuffer> buffer, UnixDateTime timestamp)
         : buffer(move(buffer))
@@ -39,7 +56,12 @@ struct PacketWithTimestamp final : public AtomicRefCounted<PacketWithTimestamp>
 
     NonnullOwnPtr<KBuffer> buffer;
     UnixDateTime timestamp;
+    TransmitOffload transmit_offload;
+    // Set on received packets whose TCP or UDP checksum the adapter has already verified.
+    bool checksum_is_verified { false };
     IntrusiveListNode<PacketWithTimestamp, RefPtr<PacketWithTimestamp>> packet_node;
+
+    MAKE_SLAB_CACHE_ALLOCATED(PacketWithTimestamp);
 };
 
 class NetworkingManagement;
@@ -52,6 +74,18 @@ public:
         Ethernet
     };
 
+    enum class Offload : u8 {
+        None = 0,
+        // The adapter computes the TCP checksum of outgoing frames, see TransmitOffload.
+        TransmitChecksum = 1 << 0,
+        // The adapter verifies the TCP and UDP checksums of incoming frames.
+        ReceiveChecksum = 1 << 1,
+        // The adapter takes TCP segments of up to 64 KiB and cuts them into segments that fit the MTU.
+        // This requires TransmitChecksum, as every one of those segments needs its own checksum.
+        TCPSegmentation = 1 << 2,
+    };
+    AK_ENUM_BITWISE_FRIEND_OPERATORS(Offload);
+
     static constexpr i32 LINKSPEED_INVALID = -1;
 
     virtual ~NetworkAdapter();
@@ -72,6 +106,8 @@ public:
         return LINKSPEED_INVALID;
     }
     virtual bool link_full_duplex() { return false; }
+    // How many pairs of receive and transmit queues the adapter spreads its traffic over.
+    virtual u16 queue_pair_count() const { return 1; }
 
     void set_ipv4_address(IPv4Address const&);
     void set_ipv4_netmask(IPv4Address const&);
@@ -79,13 +115,17 @@ public:
     void send(MACAddress const&, ARPPacket const&);
     void fill_in_ipv4_header(PacketWithTimestamp&, IPv4Address const&, MACAddress const&, IPv4Address const&, IPv4Protocol, size_t, u8 type_of_service, u8 ttl);
 
-    size_t dequeue_packet(u8* buffer, size_t buffer_size, UnixDateTime& packet_timestamp);
-
-    bool has_queued_packets() const { return !m_packet_queue.is_empty(); }
+    // Received packets are queued for the receive worker that handles their flow, see NetworkTask.
+    size_t dequeue_packet(size_t receive_worker, u8* buffer, size_t buffer_size, UnixDateTime& packet_timestamp, bool& checksum_is_verified);
+    bool has_queued_packets(size_t receive_worker) const;
 
     u32 mtu() const { return m_mtu; }
     void set_mtu(u32 mtu) { m_mtu = mtu; }
 
+    Offload offloads() const { return m_offloads; }
+    bool has_offload(Offload offload) const { return has_flag(m_offloads, offload); }
+    bool can_offload(TransmitOffload const&) const;
+
     u32 packets_in() const { return m_packets_in; }
     u32 bytes_in() const { return m_bytes_in; }
     u32 packets_out() const { return m_packets_out; }
@@ -97,15 +137,22 @@ public:
     constexpr size_t layer3_payload_offset() const { return sizeof(EthernetFrameHeader); }
     constexpr size_t ipv4_payload_offset() const { return layer3_payload_offset() + sizeof(IPv4Packet); }
 
-    Function<void()> on_receive;
+    // Called for every receive worker that one or more packets were queued for, at most once per interrupt.
+    Function<void(size_t receive_worker)> on_receive;
 
-    void send_packet(ReadonlyBytes);
+    // The offloads have to be ones that can_offload() agrees to.
+    void send_packet(ReadonlyBytes, TransmitOffload const& = {});
 
 protected:
     NetworkAdapter(StringView);
     void set_mac_address(MACAddress const& mac_address) { m_mac_address = mac_address; }
-    void did_receive(ReadonlyBytes);
+    void set_offloads(Offload);
+    void did_receive(ReadonlyBytes, bool checksum_is_verified = false);
+    // Adapters that get many packets per interrupt queue them all, then notify on_receive once.
+    void queue_received_packet(ReadonlyBytes, bool checksum_is_verified = false);
+    void did_queue_received_packets();
     virtual void send_raw(ReadonlyBytes) = 0;
+    virtual void send_raw_with_offload(ReadonlyBytes, TransmitOffload const&) { VERIFY_NOT_REACHED(); }
 
 private:
     MACAddress m_mac_address;
@@ -117,8 +164,13 @@ private:
 
     using PacketList = IntrusiveList<&PacketWithTimestamp::packet_node>;
 
-    PacketList m_packet_queue;
-    size_t m_packet_queue_size { 0 };
+    struct ReceiveQueues {
+        Array<PacketList, NetworkTask::maximum_receive_workers> packets;
+        size_t size { 0 };
+        // The workers that got packets since on_receive was last called for them.
+        u32 pending_workers { 0 };
+    };
+    SpinlockProtected<ReceiveQueues, LockRank::None> m_receive_queues {};
     SpinlockProtected<PacketList, LockRank::None> m_unused_packets {};
     FixedStringBuffer<IFNAMSIZ> m_name;
     u32 m_packets_in { 0 };
@@ -126,6 +178,7 @@ private:
     u32 m_packets_out { 0 };
     u32 m_bytes_out { 0 };
     u32 m_mtu { 1500 };
+    Offload m_offloads { Offload::None };
 };
 
 }
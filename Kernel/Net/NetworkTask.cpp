@@ -26,37 +26,36 @@
 namespace Kernel {
 
 static void handle_arp(EthernetFrameHeader const&, size_t frame_size);
-static void handle_ipv4(EthernetFrameHeader const&, size_t frame_size, UnixDateTime const& packet_timestamp);
+static void handle_ipv4(EthernetFrameHeader const&, size_t frame_size, UnixDateTime const& packet_timestamp, bool checksum_is_verified);
 static void handle_icmp(EthernetFrameHeader const&, IPv4Packet const&, UnixDateTime const& packet_timestamp);
-static void handle_udp(IPv4Packet const&, UnixDateTime const& packet_timestamp);
-static void handle_tcp(IPv4Packet const&, UnixDateTime const& packet_timestamp);
+static void handle_udp(IPv4Packet const&, UnixDateTime const& packet_timestamp, bool checksum_is_verified);
+static void handle_tcp(IPv4Packet const&, UnixDateTime const& packet_timestamp, bool checksum_is_verified);
 static void send_delayed_tcp_ack(TCPSocket& socket);
 static void send_tcp_rst(IPv4Packet const& ipv4_packet, TCPPacket const& tcp_packet, RefPtr<NetworkAdapter> adapter);
 static void flush_delayed_tcp_acks();
 static void retransmit_tcp_packets();
 
-static Thread* network_task = nullptr;
-static HashTable<NonnullRefPtr<TCPSocket>>* delayed_ack_sockets;
+struct ReceiveWorker {
+    Thread* thread { nullptr };
+    u32 processor { 0 };
+    WaitQueue packet_wait_queue;
+    // Only the worker itself touches this, as it only holds sockets of the flows the worker handles.
+    HashTable<NonnullRefPtr<TCPSocket>> delayed_ack_sockets;
+    Atomic<u64> packets { 0 };
+    Atomic<u64> bytes { 0 };
+    Atomic<u64> wakeups { 0 };
+};
+
+static Array<ReceiveWorker, NetworkTask::maximum_receive_workers>* s_receive_workers;
+static size_t s_receive_worker_count = 1;
 
 [[noreturn]] static void NetworkTask_main(void*);
 
 void NetworkTask::spawn()
 {
-    auto [_, first_thread] = MUST(Process::create_kernel_process("Network Task"sv, NetworkTask_main, nullptr));
-    network_task = first_thread;
-}
+    s_receive_workers = new Array<ReceiveWorker, maximum_receive_workers>;
+    s_receive_worker_count = min<size_t>(Processor::count(), maximum_receive_workers);
 
-bool NetworkTask::is_current()
-{
-    return Thread::current() == network_task;
-}
-
-void NetworkTask_main(void*)
-{
-    delayed_ack_sockets = new HashTable<NonnullRefPtr<TCPSocket>>;
-
-    WaitQueue packet_wait_queue;
-    int pending_packets = 0;
     NetworkingManagement::the().for_each([&](auto& adapter) {
         dmesgln("NetworkTask: {} network adapter found: hw={}", adapter.class_name(), adapter.mac_address().to_string());
 
@@ -65,21 +64,85 @@ void NetworkTask_main(void*)
             adapter.set_ipv4_netmask({ 255, 0, 0, 0 });
         }
 
-        adapter.on_receive = [&]() {
-            pending_packets++;
-            packet_wait_queue.wake_all();
+        adapter.on_receive = [](size_t receive_worker) {
+            (*s_receive_workers)[receive_worker].packet_wait_queue.wake_all();
         };
     });
 
-    auto dequeue_packet = [&pending_packets](u8* buffer, size_t buffer_size, UnixDateTime& packet_timestamp) -> size_t {
-        if (pending_packets == 0)
-            return 0;
+    // Every worker stays on its own CPU, and the first one also takes care of retransmissions.
+    for (size_t i = 0; i < s_receive_worker_count; ++i)
+        (*s_receive_workers)[i].processor = i;
+    auto [process, _] = MUST(Process::create_kernel_process("Network Task"sv, NetworkTask_main, &(*s_receive_workers)[0], 1u << 0));
+    for (size_t i = 1; i < s_receive_worker_count; ++i) {
+        auto name = MUST(KString::formatted("Network Task #{}", i));
+        (void)MUST(process->create_kernel_thread(NetworkTask_main, &(*s_receive_workers)[i], THREAD_PRIORITY_NORMAL, name->view(), 1u << i, false));
+    }
+}
+
+bool NetworkTask::is_current()
+{
+    if (!s_receive_workers)
+        return false;
+    for (size_t i = 0; i < s_receive_worker_count; ++i) {
+        if ((*s_receive_workers)[i].thread == Thread::current())
+            return true;
+    }
+    return false;
+}
+
+static ReceiveWorker& current_receive_worker()
+{
+    for (size_t i = 0; i < s_receive_worker_count; ++i) {
+        if ((*s_receive_workers)[i].thread == Thread::current())
+            return (*s_receive_workers)[i];
+    }
+    VERIFY_NOT_REACHED();
+}
+
+size_t NetworkTask::receive_worker_for_frame(ReadonlyBytes frame)
+{
+    if (s_receive_worker_count == 1 || frame.size() < sizeof(EthernetFrameHeader) + sizeof(IPv4Packet))
+        return 0;
+    auto& eth = *reinterpret_cast<EthernetFrameHeader const*>(frame.data());
+    if (eth.ether_type() != EtherType::IPv4)
+        return 0;
+
+    // A flow is identified by its addresses, protocol and ports, and both TCP and UDP headers start with the ports.
+    auto& ipv4_packet = *static_cast<IPv4Packet const*>(eth.payload());
+    u32 hash = pair_int_hash(ipv4_packet.source().to_u32(), ipv4_packet.destination().to_u32());
+    hash = pair_int_hash(hash, ipv4_packet.protocol());
+    auto protocol = static_cast<IPv4Protocol>(ipv4_packet.protocol());
+    if ((protocol == IPv4Protocol::TCP || protocol == IPv4Protocol::UDP) && frame.size() >= sizeof(EthernetFrameHeader) + sizeof(IPv4Packet) + sizeof(u32)) {
+        u32 ports;
+        memcpy(&ports, ipv4_packet.payload(), sizeof(ports));
+        hash = pair_int_hash(hash, ports);
+    }
+    return hash % s_receive_worker_count;
+}
+
+ErrorOr<void> NetworkTask::try_for_each_receive_worker(Function<ErrorOr<void>(ReceiveWorkerStatistics const&)> callback)
+{
+    if (!s_receive_workers)
+        return {};
+    for (size_t i = 0; i < s_receive_worker_count; ++i) {
+        auto& worker = (*s_receive_workers)[i];
+        TRY(callback({ worker.processor, worker.packets.load(AK::MemoryOrder::memory_order_relaxed), worker.bytes.load(AK::MemoryOrder::memory_order_relaxed), worker.wakeups.load(AK::MemoryOrder::memory_order_relaxed) }));
+    }
+    return {};
+}
+
+void NetworkTask_main(void* worker_pointer)
+{
+    auto& worker = *static_cast<ReceiveWorker*>(worker_pointer);
+    worker.thread = Thread::current();
+    size_t worker_index = &worker - s_receive_workers->data();
+
+    auto dequeue_packet = [worker_index](Bytes buffer, UnixDateTime& packet_timestamp, bool& checksum_is_verified) -> size_t {
         size_t packet_size = 0;
         NetworkingManagement::the().for_each([&](auto& adapter) {
-            if (packet_size || !adapter.has_queued_packets())
+            if (packet_size || !adapter.has_queued_packets(worker_index))
                 return;
-            packet_size = adapter.dequeue_packet(buffer, buffer_size, packet_timestamp);
-            pending_packets--;
+            packet_size = adapter.dequeue_packet(worker_index, buffer.data(), buffer.size(), packet_timestamp, checksum_is_verified);
             dbgln_if(NETWORK_TASK_DEBUG, "NetworkTask: Dequeued packet from {} ({} bytes)", adapter.name(), packet_size);
         });
         return packet_size;
@@ -92,17 +155,22 @@ void NetworkTask_main(void*)
     auto buffer_region = region_or_error.release_value();
     auto buffer = (u8*)buffer_region->vaddr().get();
     UnixDateTime packet_timestamp;
+    bool checksum_is_verified = false;
 
     while (!Process::current().is_dying()) {
         flush_delayed_tcp_acks();
-        retransmit_tcp_packets();
-        size_t packet_size = dequeue_packet(buffer, buffer_size, packet_timestamp);
+        if (worker_index == 0)
+            retransmit_tcp_packets();
+        size_t packet_size = dequeue_packet({ buffer, buffer_size }, packet_timestamp, checksum_is_verified);
         if (!packet_size) {
             auto timeout_time = Duration::from_milliseconds(500);
             auto timeout = Thread::BlockTimeout { false, &timeout_time };
-            [[maybe_unused]] auto result = packet_wait_queue.wait_on(timeout, "NetworkTask"sv);
+            [[maybe_unused]] auto result = worker.packet_wait_queue.wait_on(timeout, "NetworkTask"sv);
+            worker.wakeups.fetch_add(1, AK::MemoryOrder::memory_order_relaxed);
             continue;
         }
+        worker.packets.fetch_add(1, AK::MemoryOrder::memory_order_relaxed);
+        worker.bytes.fetch_add(packet_size, AK::MemoryOrder::memory_order_relaxed);
         if (packet_size < sizeof(EthernetFrameHeader)) {
             dbgln("NetworkTask: Packet is too small to be an Ethernet packet! ({})", packet_size);
             continue;
@@ -115,7 +183,7 @@ void NetworkTask_main(void*)
             handle_arp(eth, packet_size);
             break;
         case EtherType::IPv4:
-            handle_ipv4(eth, packet_size, packet_timestamp);
+            handle_ipv4(eth, packet_size, packet_timestamp, checksum_is_verified);
             break;
         case EtherType::IPv6:
             // ignore
@@ -124,7 +192,9 @@ void NetworkTask_main(void*)
             dbgln_if(ETHERNET_DEBUG, "NetworkTask: Unknown ethernet type {:#04x}", eth.ether_type());
         }
     }
-    Process::current().sys$exit(0);
+    if (worker_index == 0)
+        Process::current().sys$exit(0);
+    Thread::current()->exit();
     VERIFY_NOT_REACHED();
 }
 
@@ -176,7 +246,7 @@ void handle_arp(EthernetFrameHeader const& eth, size_t frame_size)
     }
 }
 
-void handle_ipv4(EthernetFrameHeader const& eth, size_t frame_size, UnixDateTime const& packet_timestamp)
+void handle_ipv4(EthernetFrameHeader const& eth, size_t frame_size, UnixDateTime const& packet_timestamp, bool checksum_is_verified)
 {
     constexpr size_t minimum_ipv4_frame_size = sizeof(EthernetFrameHeader) + sizeof(IPv4Packet);
     if (frame_size < minimum_ipv4_frame_size) {
@@ -212,9 +282,9 @@ void handle_ipv4(EthernetFrameHeader const& eth, size_t frame_size, UnixDateTime
     case IPv4Protocol::ICMP:
         return handle_icmp(eth, packet, packet_timestamp);
     case IPv4Protocol::UDP:
-        return handle_udp(packet, packet_timestamp);
+        return handle_udp(packet, packet_timestamp, checksum_is_verified);
     case IPv4Protocol::TCP:
-        return handle_tcp(packet, packet_timestamp);
+        return handle_tcp(packet, packet_timestamp, checksum_is_verified);
     default:
         dbgln_if(IPV4_DEBUG, "handle_ipv4: Unhandled protocol {:#02x}", packet.protocol());
         break;
@@ -272,7 +342,7 @@ void handle_icmp(EthernetFrameHeader const& eth, IPv4Packet const& ipv4_packet,
     }
 }
 
-void handle_udp(IPv4Packet const& ipv4_packet, UnixDateTime const& packet_timestamp)
+void handle_udp(IPv4Packet const& ipv4_packet, UnixDateTime const& packet_timestamp, bool checksum_is_verified)
 {
     if (ipv4_packet.payload_size() < sizeof(UDPPacket)) {
         dbgln("handle_udp: Packet too small ({}, need {})", ipv4_packet.payload_size(), sizeof(UDPPacket));
@@ -280,6 +350,11 @@ void handle_udp(IPv4Packet const& ipv4_packet, UnixDateTime const& packet_timest
     }
 
     auto& udp_packet = *static_cast<UDPPacket const*>(ipv4_packet.payload());
+    // RFC 768: A checksum of zero means the sender didn't compute one.
+    if (!checksum_is_verified && udp_packet.checksum() != 0 && !transport_checksum_is_valid(ipv4_packet)) {
+        dbgln_if(UDP_DEBUG, "handle_udp: Dropping packet with bad checksum");
+        return;
+    }
     dbgln_if(UDP_DEBUG, "handle_udp: source={}:{}, destination={}:{}, length={}",
         ipv4_packet.source(), udp_packet.source_port(),
         ipv4_packet.destination(), udp_packet.destination_port(),
@@ -308,13 +383,14 @@ void send_delayed_tcp_ack(TCPSocket& socket)
         return;
     }
 
-    delayed_ack_sockets->set(move(socket));
+    current_receive_worker().delayed_ack_sockets.set(move(socket));
 }
 
 void flush_delayed_tcp_acks()
 {
+    auto& delayed_ack_sockets = current_receive_worker().delayed_ack_sockets;
     Vector<NonnullRefPtr<TCPSocket>, 32> remaining_sockets;
-    for (auto& socket : *delayed_ack_sockets) {
+    for (auto& socket : delayed_ack_sockets) {
         MutexLocker locker(socket->mutex());
         if (socket->should_delay_next_ack()) {
             MUST(remaining_sockets.try_append(*socket));
@@ -323,12 +399,12 @@ void flush_delayed_tcp_acks()
         [[maybe_unused]] auto result = socket->send_ack();
     }
 
-    if (remaining_sockets.size() != delayed_ack_sockets->size()) {
-        delayed_ack_sockets->clear();
+    if (remaining_sockets.size() != delayed_ack_sockets.size()) {
+        delayed_ack_sockets.clear();
         if (remaining_sockets.size() > 0)
             dbgln("flush_delayed_tcp_acks: {} sockets remaining", remaining_sockets.size());
         for (auto&& socket : remaining_sockets)
-            delayed_ack_sockets->set(move(socket));
+            delayed_ack_sockets.set(move(socket));
     }
 }
 
@@ -366,7 +442,7 @@ void send_tcp_rst(IPv4Packet const& ipv4_packet, TCPPacket const& tcp_packet, Re
     routing_decision.adapter->release_packet_buffer(*packet);
 }
 
-void handle_tcp(IPv4Packet const& ipv4_packet, UnixDateTime const& packet_timestamp)
+void handle_tcp(IPv4Packet const& ipv4_packet, UnixDateTime const& packet_timestamp, bool checksum_is_verified)
 {
     if (ipv4_packet.payload_size() < sizeof(TCPPacket)) {
         dbgln("handle_tcp: IPv4 payload is too small to be a TCP packet ({}, need {})", ipv4_packet.payload_size(), sizeof(TCPPacket));
@@ -379,6 +455,7 @@ void handle_tcp(IPv4Packet const& ipv4_packet, UnixDateTime const& packet_timest
     size_t maximum_tcp_header_size = 15 * sizeof(u32);
     if (tcp_packet.header_size() < minimum_tcp_header_size || tcp_packet.header_size() > maximum_tcp_header_size) {
         dbgln("handle_tcp: TCP packet header has invalid size {}", tcp_packet.header_size());
+        return;
     }
 
     if (ipv4_packet.payload_size() < tcp_packet.header_size()) {
@@ -388,6 +465,11 @@ void handle_tcp(IPv4Packet const& ipv4_packet, UnixDateTime const& packet_timest
 
     size_t payload_size = ipv4_packet.payload_size() - tcp_packet.header_size();
 
+    if (!checksum_is_verified && !transport_checksum_is_valid(ipv4_packet)) {
+        dbgln_if(TCP_DEBUG, "handle_tcp: Dropping packet with bad checksum");
+        return;
+    }
+
     dbgln_if(TCP_DEBUG, "handle_tcp: source={}:{}, destination={}:{}, seq_no={}, ack_no={}, flags={:#04x} ({}{}{}{}), window_size={}, payload_size={}",
         ipv4_packet.source().to_string(),
         tcp_packet.source_port(),
@@ -455,8 +537,9 @@ void handle_tcp(IPv4Packet const& ipv4_packet, UnixDateTime const& packet_timest
             auto client = client_or_error.release_value();
             MutexLocker locker(client->mutex());
             dbgln_if(TCP_DEBUG, "handle_tcp: created new client socket with tuple {}", client->tuple().to_string());
-            client->set_sequence_number(1000);
+            client->set_initial_sequence_number(1000);
             client->set_ack_number(tcp_packet.sequence_number() + payload_size + 1);
+            client->process_syn_options(tcp_packet);
             [[maybe_unused]] auto rc2 = client->send_tcp_packet(TCPFlags::SYN | TCPFlags::ACK);
             client->set_state(TCPSocket::State::SynReceived);
             return;
@@ -470,11 +553,13 @@ void handle_tcp(IPv4Packet const& ipv4_packet, UnixDateTime const& packet_timest
         switch (tcp_packet.flags()) {
         case TCPFlags::SYN:
             socket->set_ack_number(tcp_packet.sequence_number() + payload_size + 1);
+            socket->process_syn_options(tcp_packet);
             (void)socket->send_tcp_packet(TCPFlags::SYN | TCPFlags::ACK);
             socket->set_state(TCPSocket::State::SynReceived);
             return;
         case TCPFlags::ACK | TCPFlags::SYN:
             socket->set_ack_number(tcp_packet.sequence_number() + payload_size + 1);
+            socket->process_syn_options(tcp_packet);
             (void)socket->send_ack(true);
             socket->set_state(TCPSocket::State::Established);
             socket->set_setup_state(Socket::SetupState::Completed);
@@ -618,17 +703,17 @@ void handle_tcp(IPv4Packet const& ipv4_packet, UnixDateTime const& packet_timest
         }
 
         if (tcp_packet.sequence_number() != socket->ack_number()) {
-            dbgln_if(TCP_DEBUG, "Discarding out of order packet: seq {} vs. ack {}", tcp_packet.sequence_number(), socket->ack_number());
-            if (socket->duplicate_acks() < TCPSocket::maximum_duplicate_acks) {
-                dbgln_if(TCP_DEBUG, "Sending ACK with same ack number to trigger fast retransmission");
-                socket->set_duplicate_acks(socket->duplicate_acks() + 1);
-                [[maybe_unused]] auto result = socket->send_ack(true);
-            }
+            if (payload_size == 0 && !tcp_packet.has_fin())
+                return;
+            dbgln_if(TCP_DEBUG, "Queueing out of order packet: seq {} vs. ack {}", tcp_packet.sequence_number(), socket->ack_number());
+            if (!tcp_packet.has_fin())
+                socket->queue_out_of_order_segment(ipv4_packet, tcp_packet, payload_size);
+            // RFC 5681, 4.2: "A TCP receiver SHOULD send an immediate duplicate ACK when an out-of-order segment arrives."
+            // This is what triggers fast retransmission on the other end.
+            [[maybe_unused]] auto result = socket->send_ack(true);
             return;
         }
 
-        socket->set_duplicate_acks(0);
-
         if (tcp_packet.has_fin()) {
             if (payload_size != 0)
                 socket->did_receive(ipv4_packet.source(), tcp_packet.source_port(), { &ipv4_packet, sizeof(IPv4Packet) + ipv4_packet.payload_size() }, packet_timestamp);
@@ -645,7 +730,12 @@ void handle_tcp(IPv4Packet const& ipv4_packet, UnixDateTime const& packet_timest
                 socket->set_ack_number(tcp_packet.sequence_number() + payload_size);
                 dbgln_if(TCP_DEBUG, "Got packet with ack_no={}, seq_no={}, payload_size={}, acking it with new ack_no={}, seq_no={}",
                     tcp_packet.ack_number(), tcp_packet.sequence_number(), payload_size, socket->ack_number(), socket->sequence_number());
-                send_delayed_tcp_ack(*socket);
+                // RFC 5681, 4.2: "A TCP receiver SHOULD send an immediate ACK when the incoming segment fills in all or
+                //                 part of a gap in the sequence space."
+                if (socket->deliver_queued_segments(packet_timestamp))
+                    (void)socket->send_ack();
+                else
+                    send_delayed_tcp_ack(*socket);
             }
         }
     }
@@ -6,10 +6,29 @@
 
 #pragma once
 
+#include <AK/Error.h>
+#include <AK/Function.h>
+#include <AK/Span.h>
+#include <AK/Types.h>
+
 namespace Kernel {
 class NetworkTask {
 public:
+    // Received packets are handled by a worker thread per CPU. All packets of a flow go to the same worker,
+    // so they are handled in the order they came in.
+    static constexpr size_t maximum_receive_workers = 16;
+
     static void spawn();
     static bool is_current();
+
+    static size_t receive_worker_for_frame(ReadonlyBytes);
+
+    struct ReceiveWorkerStatistics {
+        u32 processor;
+        u64 packets;
+        u64 bytes;
+        u64 wakeups;
+    };
+    static ErrorOr<void> try_for_each_receive_worker(Function<ErrorOr<void>(ReceiveWorkerStatistics const&)>);
 };
 }
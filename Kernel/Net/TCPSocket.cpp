@@ -76,6 +76,9 @@ void TCPSocket::set_state(State new_state)
         drop_receive_buffer();
     }
 
+    if (new_state != State::Established)
+        drop_queued_segments();
+
     if (new_state == State::Closed) {
         closing_sockets().with_exclusive([&](auto& table) {
             table.remove(tuple());
@@ -167,7 +170,7 @@ void TCPSocket::release_for_accept(NonnullRefPtr<TCPSocket> socket)
 TCPSocket::TCPSocket(int protocol, NonnullOwnPtr<DoubleBuffer> receive_buffer, NonnullOwnPtr<KBuffer> scratch_buffer)
     : IPv4Socket(SOCK_STREAM, protocol, move(receive_buffer), move(scratch_buffer))
     , m_last_ack_sent_time(TimeManagement::the().monotonic_time())
-    , m_last_retransmit_time(TimeManagement::the().monotonic_time())
+    , m_retransmit_timer_start(TimeManagement::the().monotonic_time())
 {
 }
 
@@ -209,7 +212,11 @@ ErrorOr<size_t> TCPSocket::protocol_send(UserOrKernelBuffer const& data, size_t
     RoutingDecision routing_decision = route_to(peer_address(), local_address(), adapter);
     if (routing_decision.is_zero())
         return set_so_error(EHOSTUNREACH);
-    size_t mss = routing_decision.adapter->mtu() - sizeof(IPv4Packet) - sizeof(TCPPacket);
+    size_t mss = send_mss(*routing_decision.adapter);
+    // With segmentation offload, we hand the adapter as many full segments as fit into one IPv4 packet.
+    size_t segment_size = mss;
+    if (routing_decision.adapter->has_offload(NetworkAdapter::Offload::TCPSegmentation))
+        segment_size = max(mss, (NumericLimits<u16>::max() - sizeof(IPv4Packet) - sizeof(TCPPacket)) / mss * mss);
 
     if (!m_no_delay) {
         // RFC 896 (Nagle’s algorithm): https://www.ietf.org/rfc/rfc0896
@@ -223,11 +230,87 @@ ErrorOr<size_t> TCPSocket::protocol_send(UserOrKernelBuffer const& data, size_t
             return set_so_error(EAGAIN);
     }
 
-    data_length = min(data_length, mss);
+    // RFC 9293, 3.8.6.2.1: Don't send a small segment into a window that is about to open further. With nothing
+    // outstanding, no acknowledgement is coming that could open it, so we send whatever fits.
+    auto usable_window = m_unacked_packets.with_shared([&](auto const& packets) { return usable_send_window(packets); });
+    bool has_outstanding_data = m_sequence_number != m_send_unacknowledged;
+    if (usable_window == 0 || (has_outstanding_data && usable_window < min(data_length, mss)))
+        return set_so_error(EAGAIN);
+
+    data_length = min(min(data_length, segment_size), usable_window);
     TRY(send_tcp_packet(TCPFlags::PSH | TCPFlags::ACK, &data, data_length, &routing_decision));
     return data_length;
 }
 
+size_t TCPSocket::send_mss(NetworkAdapter const& adapter) const
+{
+    return min<size_t>(adapter.mtu() - sizeof(IPv4Packet) - sizeof(TCPPacket), m_send_mss);
+}
+
+size_t TCPSocket::usable_send_window(UnackedPackets const& unacked_packets) const
+{
+    // RFC 5681, 2: We may not have more in flight than the congestion window, nor more outstanding than the peer's window.
+    auto outstanding = static_cast<size_t>(m_sequence_number - m_send_unacknowledged);
+    if (outstanding == 0) {
+        // RFC 9293, 3.8.6.1: If the peer has closed its window, probe it with a single byte to find out when it opens again.
+        if (m_send_window_size == 0)
+            return 1;
+        return min(m_congestion_window, m_send_window_size);
+    }
+    size_t congestion_room = m_congestion_window > unacked_packets.in_flight ? m_congestion_window - unacked_packets.in_flight : 0;
+    size_t peer_room = m_send_window_size > outstanding ? m_send_window_size - outstanding : 0;
+    return min(congestion_room, peer_room);
+}
+
+void TCPSocket::set_initial_sequence_number(u32 sequence_number)
+{
+    m_sequence_number = sequence_number;
+    m_send_unacknowledged = sequence_number;
+    m_recovery_point = sequence_number;
+}
+
+u32 TCPSocket::advertised_window() const
+{
+    // Segments waiting for a gap to be filled will take up room in the receive buffer as well.
+    auto space = receive_buffer_space();
+    if (space <= m_out_of_order_bytes)
+        return 0;
+    return space - m_out_of_order_bytes;
+}
+
+void TCPSocket::collect_sack_blocks(Vector<TCPSACKBlock, maximum_sack_blocks>& blocks) const
+{
+    struct Range {
+        u32 left_edge { 0 };
+        u32 right_edge { 0 };
+    };
+    Vector<Range, 16> ranges;
+    for (auto& segment : m_out_of_order_segments) {
+        if (!ranges.is_empty() && ranges.last().right_edge == segment.sequence_number) {
+            ranges.last().right_edge += segment.size;
+            continue;
+        }
+        if (ranges.try_append({ segment.sequence_number, segment.sequence_number + segment.size }).is_error())
+            break;
+    }
+
+    // RFC 2018, 4: "The first SACK block [...] MUST specify the contiguous block of data containing the segment
+    //               which triggered this ACK"
+    Optional<size_t> most_recent_index;
+    for (size_t i = 0; i < ranges.size(); ++i) {
+        if (tcp_sequence_before_or_equal(ranges[i].left_edge, m_last_out_of_order_sequence_number) && tcp_sequence_before(m_last_out_of_order_sequence_number, ranges[i].right_edge)) {
+            most_recent_index = i;
+            break;
+        }
+    }
+    if (most_recent_index.has_value())
+        blocks.unchecked_append({ ranges[*most_recent_index].left_edge, ranges[*most_recent_index].right_edge });
+    for (size_t i = 0; i < ranges.size() && blocks.size() < maximum_sack_blocks; ++i) {
+        if (i != most_recent_index)
+            blocks.unchecked_append({ ranges[i].left_edge, ranges[i].right_edge });
+    }
+}
+
 ErrorOr<void> TCPSocket::send_ack(bool allow_duplicate)
 {
     if (!allow_duplicate && m_last_ack_number_sent == m_ack_number)
@@ -235,6 +318,9 @@ ErrorOr<void> TCPSocket::send_ack(bool allow_duplicate)
     return send_tcp_packet(TCPFlags::ACK);
 }
 
+// Where the checksum is in the TCP header, for adapters that fill it in.
+static constexpr u16 tcp_checksum_offset = 16;
+
 ErrorOr<void> TCPSocket::send_tcp_packet(u16 flags, UserOrKernelBuffer const* payload, size_t payload_size, RoutingDecision* user_routing_decision)
 {
     auto adapter = bound_interface().with([](auto& bound_device) -> RefPtr<NetworkAdapter> { return bound_device; });
@@ -244,8 +330,27 @@ ErrorOr<void> TCPSocket::send_tcp_packet(u16 flags, UserOrKernelBuffer const* pa
 
     auto ipv4_payload_offset = routing_decision.adapter->ipv4_payload_offset();
 
-    bool const has_mss_option = flags == TCPFlags::SYN;
-    const size_t options_size = has_mss_option ? sizeof(TCPOptionMSS) : 0;
+    bool const is_syn = flags & TCPFlags::SYN;
+    // We offer window scaling and SACK in our own SYN, and only agree to them in a SYN-ACK if the peer offered them.
+    bool const is_active_open = is_syn && !(flags & TCPFlags::ACK);
+    bool const has_window_scale_option = is_syn && (is_active_open || m_window_scaling_enabled);
+    bool const has_sack_permitted_option = is_syn && (is_active_open || m_sack_permitted);
+
+    Vector<TCPSACKBlock, maximum_sack_blocks> sack_blocks;
+    if (!is_syn && (flags & TCPFlags::ACK) && payload_size == 0 && m_sack_permitted)
+        collect_sack_blocks(sack_blocks);
+
+    size_t options_size = 0;
+    if (is_syn)
+        options_size += sizeof(TCPOptionMSS);
+    if (has_window_scale_option)
+        options_size += 1 + sizeof(TCPOptionWindowScale);
+    if (has_sack_permitted_option)
+        options_size += 2 + sizeof(TCPOptionSACKPermitted);
+    if (!sack_blocks.is_empty())
+        options_size += 4 + sack_blocks.size() * sizeof(TCPSACKBlock);
+    VERIFY(options_size % sizeof(u32) == 0);
+
     const size_t tcp_header_size = sizeof(TCPPacket) + options_size;
     const size_t buffer_size = ipv4_payload_offset + tcp_header_size + payload_size;
     auto packet = routing_decision.adapter->acquire_packet_buffer(buffer_size);
@@ -259,11 +364,16 @@ ErrorOr<void> TCPSocket::send_tcp_packet(u16 flags, UserOrKernelBuffer const* pa
     VERIFY(local_port());
     tcp_packet.set_source_port(local_port());
     tcp_packet.set_destination_port(peer_port());
-    tcp_packet.set_window_size(NumericLimits<u16>::max());
     tcp_packet.set_sequence_number(m_sequence_number);
     tcp_packet.set_data_offset(tcp_header_size / sizeof(u32));
     tcp_packet.set_flags(flags);
 
+    // RFC 7323, 2.2: "The window field in a segment where the SYN bit is set (i.e., a <SYN> or <SYN,ACK>) MUST NOT be scaled."
+    u8 window_shift = is_syn ? 0 : m_receive_window_shift;
+    u32 window = min(advertised_window() >> window_shift, NumericLimits<u16>::max());
+    tcp_packet.set_window_size(window);
+    m_last_advertised_window = window << window_shift;
+
     if (payload) {
         if (auto result = payload->read(tcp_packet.payload(), payload_size); result.is_error()) {
             routing_decision.adapter->release_packet_buffer(*packet);
@@ -277,32 +387,80 @@ ErrorOr<void> TCPSocket::send_tcp_packet(u16 flags, UserOrKernelBuffer const* pa
         tcp_packet.set_ack_number(m_ack_number);
     }
 
+    auto sequence_number = m_sequence_number;
     if (flags & TCPFlags::SYN) {
         ++m_sequence_number;
     } else {
         m_sequence_number += payload_size;
     }
 
-    if (has_mss_option) {
+    VERIFY(packet->buffer->size() >= ipv4_payload_offset + tcp_header_size);
+    auto* options = packet->buffer->data() + ipv4_payload_offset + sizeof(TCPPacket);
+    auto append_option = [&](auto const& option) {
+        memcpy(options, &option, sizeof(option));
+        options += sizeof(option);
+    };
+    auto append_padding = [&](size_t count) {
+        memset(options, to_underlying(TCPOptionKind::NoOperation), count);
+        options += count;
+    };
+    if (is_syn) {
         u16 mss = routing_decision.adapter->mtu() - sizeof(IPv4Packet) - sizeof(TCPPacket);
-        TCPOptionMSS mss_option { mss };
-        VERIFY(packet->buffer->size() >= ipv4_payload_offset + sizeof(TCPPacket) + sizeof(mss_option));
-        memcpy(packet->buffer->data() + ipv4_payload_offset + sizeof(TCPPacket), &mss_option, sizeof(mss_option));
+        if (m_maximum_segment_size != 0)
+            mss = min(mss, m_maximum_segment_size);
+        append_option(TCPOptionMSS { mss });
+    }
+    if (has_window_scale_option) {
+        append_padding(1);
+        append_option(TCPOptionWindowScale { preferred_receive_window_shift });
+    }
+    if (has_sack_permitted_option) {
+        append_padding(2);
+        append_option(TCPOptionSACKPermitted {});
+    }
+    if (!sack_blocks.is_empty()) {
+        append_padding(2);
+        append_option(to_underlying(TCPOptionKind::SACK));
+        append_option(static_cast<u8>(2 + sack_blocks.size() * sizeof(TCPSACKBlock)));
+        for (auto& block : sack_blocks)
+            append_option(block);
     }
 
-    tcp_packet.set_checksum(compute_tcp_checksum(local_address(), peer_address(), tcp_packet, payload_size));
+    auto& transmit_offload = packet->transmit_offload;
+    if (routing_decision.adapter->has_offload(NetworkAdapter::Offload::TransmitChecksum)) {
+        transmit_offload.checksum_start = ipv4_payload_offset;
+        transmit_offload.checksum_offset = tcp_checksum_offset;
+        tcp_packet.set_checksum(pseudo_header_checksum(local_address(), peer_address(), IPv4Protocol::TCP, tcp_header_size + payload_size));
+    } else {
+        tcp_packet.set_checksum(compute_tcp_checksum(local_address(), peer_address(), tcp_packet, payload_size));
+    }
+    if (auto mss = send_mss(*routing_decision.adapter); payload_size > mss) {
+        VERIFY(routing_decision.adapter->has_offload(NetworkAdapter::Offload::TCPSegmentation));
+        transmit_offload.segment_size = mss;
+    }
 
     bool expect_ack { tcp_packet.has_syn() || payload_size > 0 };
     if (expect_ack) {
         bool append_failed { false };
         m_unacked_packets.with_exclusive([&](auto& unacked_packets) {
-            auto result = unacked_packets.packets.try_append({ m_sequence_number, packet, ipv4_payload_offset, *routing_decision.adapter });
+            OutgoingPacket outgoing_packet {
+                .sequence_number = sequence_number,
+                .ack_number = m_sequence_number,
+                .buffer = packet,
+                .ipv4_payload_offset = ipv4_payload_offset,
+                .adapter = *routing_decision.adapter,
+                .sent_time = TimeManagement::the().monotonic_time(),
+            };
+            if (unacked_packets.packets.is_empty())
+                m_retransmit_timer_start = outgoing_packet.sent_time;
+            auto result = unacked_packets.packets.try_append(move(outgoing_packet));
             if (result.is_error()) {
                 dbgln("TCPSocket: Dropped outbound packet because try_append() failed");
                 append_failed = true;
                 return;
             }
             unacked_packets.size += payload_size;
+            unacked_packets.in_flight += unacked_packets.packets.last().sequence_length();
             enqueue_for_retransmit();
         });
         if (append_failed)
@@ -311,56 +469,365 @@ ErrorOr<void> TCPSocket::send_tcp_packet(u16 flags, UserOrKernelBuffer const* pa
 
     m_packets_out++;
     m_bytes_out += buffer_size;
-    routing_decision.adapter->send_packet(packet->bytes());
+    routing_decision.adapter->send_packet(packet->bytes(), transmit_offload);
     if (!expect_ack)
         routing_decision.adapter->release_packet_buffer(*packet);
 
     return {};
 }
 
+template<typename Callback>
+void TCPSocket::update_outgoing_packet(UnackedPackets& unacked_packets, OutgoingPacket& packet, Callback callback)
+{
+    auto was_in_flight = packet.is_in_flight();
+    auto needed_retransmit = packet.needs_retransmit();
+    callback(packet);
+    if (was_in_flight != packet.is_in_flight()) {
+        if (was_in_flight)
+            unacked_packets.in_flight -= packet.sequence_length();
+        else
+            unacked_packets.in_flight += packet.sequence_length();
+    }
+    if (needed_retransmit != packet.needs_retransmit()) {
+        if (needed_retransmit)
+            --unacked_packets.pending_retransmits;
+        else
+            ++unacked_packets.pending_retransmits;
+    }
+}
+
 void TCPSocket::receive_tcp_packet(TCPPacket const& packet, u16 size)
 {
     if (packet.has_ack()) {
-        u32 ack_number = packet.ack_number();
+        dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: receive_tcp_packet: {}", packet.ack_number());
+
+        m_unacked_packets.with_exclusive([&](auto& unacked_packets) {
+            process_ack(unacked_packets, packet, size - packet.header_size());
+        });
+        evaluate_block_conditions();
+    }
+
+    m_packets_in++;
+    m_bytes_in += packet.header_size() + size;
+}
+
+void TCPSocket::process_ack(UnackedPackets& unacked_packets, TCPPacket const& packet, size_t payload_size)
+{
+    u32 ack_number = packet.ack_number();
 
-        dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: receive_tcp_packet: {}", ack_number);
+    // Ignore acknowledgements for data we haven't even sent yet.
+    if (tcp_sequence_before(m_sequence_number, ack_number))
+        return;
+
+    // RFC 7323, 2.2: The window in a SYN is never scaled.
+    u32 window = packet.window_size();
+    if (!packet.has_syn())
+        window <<= m_send_window_shift;
+    // RFC 9293, 3.10.7.4: Only take the window from a segment that is newer than the one we last took it from (SND.WL1
+    // and SND.WL2), so that a reordered old segment can't shrink or reopen it.
+    u32 sequence_number = packet.sequence_number();
+    bool window_changed = false;
+    if (!tcp_sequence_before(ack_number, m_send_unacknowledged)
+        && (tcp_sequence_before(m_send_window_update_sequence_number, sequence_number)
+            || (m_send_window_update_sequence_number == sequence_number && tcp_sequence_before_or_equal(m_send_window_update_ack_number, ack_number)))) {
+        window_changed = window != m_send_window_size;
+        m_send_window_size = window;
+        m_send_window_update_sequence_number = sequence_number;
+        m_send_window_update_ack_number = ack_number;
+    }
+
+    bool has_new_sack_information = m_sack_permitted && process_sack_blocks(unacked_packets, packet);
 
+    if (tcp_sequence_before(m_send_unacknowledged, ack_number)) {
+        auto acknowledged_bytes = ack_number - m_send_unacknowledged;
+        m_send_unacknowledged = ack_number;
+        m_duplicate_acks = 0;
+
+        auto now = TimeManagement::the().monotonic_time();
+        Optional<Duration> round_trip_time_sample;
         int removed = 0;
-        m_unacked_packets.with_exclusive([&](auto& unacked_packets) {
-            while (!unacked_packets.packets.is_empty()) {
-                auto& packet = unacked_packets.packets.first();
-
-                dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: iterate: {}", packet.ack_number);
-
-                if (packet.ack_number <= ack_number) {
-                    auto old_adapter = packet.adapter.strong_ref();
-                    if (old_adapter)
-                        old_adapter->release_packet_buffer(*packet.buffer);
-                    TCPPacket& tcp_packet = *(TCPPacket*)(packet.buffer->buffer->data() + packet.ipv4_payload_offset);
-                    if (m_send_window_size != tcp_packet.window_size()) {
-                        m_send_window_size = tcp_packet.window_size();
-                    }
-                    auto payload_size = packet.buffer->buffer->data() + packet.buffer->buffer->size() - (u8*)tcp_packet.payload();
-                    unacked_packets.size -= payload_size;
-                    evaluate_block_conditions();
-                    unacked_packets.packets.take_first();
-                    removed++;
-                } else {
-                    break;
-                }
+        while (!unacked_packets.packets.is_empty()) {
+            auto& outgoing_packet = unacked_packets.packets.first();
+
+            dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: iterate: {}", outgoing_packet.ack_number);
+
+            if (!tcp_sequence_before_or_equal(outgoing_packet.ack_number, ack_number))
+                break;
+
+            // RFC 6298, 3: Karn's algorithm, we can't tell which transmission of a retransmitted packet was acknowledged.
+            if (outgoing_packet.tx_counter == 0)
+                round_trip_time_sample = now - outgoing_packet.sent_time;
+
+            auto old_adapter = outgoing_packet.adapter.strong_ref();
+            if (old_adapter)
+                old_adapter->release_packet_buffer(*outgoing_packet.buffer);
+            TCPPacket& tcp_packet = *(TCPPacket*)(outgoing_packet.buffer->buffer->data() + outgoing_packet.ipv4_payload_offset);
+            auto packet_payload_size = outgoing_packet.buffer->buffer->data() + outgoing_packet.buffer->buffer->size() - (u8*)tcp_packet.payload();
+            unacked_packets.size -= packet_payload_size;
+            if (outgoing_packet.is_in_flight())
+                unacked_packets.in_flight -= outgoing_packet.sequence_length();
+            if (outgoing_packet.needs_retransmit())
+                --unacked_packets.pending_retransmits;
+            unacked_packets.packets.take_first();
+            removed++;
+        }
+
+        dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: receive_tcp_packet acknowledged {} packets", removed);
+
+        if (round_trip_time_sample.has_value())
+            update_round_trip_time(*round_trip_time_sample);
+
+        m_retransmit_attempts = 0;
+        m_window_probe_retransmits = 0;
+        if (unacked_packets.packets.is_empty()) {
+            dequeue_for_retransmit();
+        } else {
+            // RFC 6298, 5.3: Restart the timer whenever new data is acknowledged.
+            m_retransmit_timer_start = now;
+        }
+
+        if (!m_in_fast_recovery) {
+            increase_congestion_window(acknowledged_bytes);
+        } else if (!tcp_sequence_before(ack_number, m_recovery_point)) {
+            // RFC 6582, 3.2, step 3: A full acknowledgement ends fast recovery.
+            m_in_fast_recovery = false;
+            m_congestion_window = min(m_slow_start_threshold, max<u32>(unacked_packets.in_flight, m_send_mss) + m_send_mss);
+        } else if (!unacked_packets.packets.is_empty()) {
+            // RFC 6582, 3.2, step 3: A partial acknowledgement means the next packet was lost as well.
+            if (!m_sack_permitted) {
+                m_congestion_window = m_congestion_window > acknowledged_bytes ? m_congestion_window - acknowledged_bytes : 0;
+                if (acknowledged_bytes >= m_send_mss)
+                    m_congestion_window += m_send_mss;
+                m_congestion_window = max(m_congestion_window, m_send_mss);
             }
+            auto& first_packet = unacked_packets.packets.first();
+            if (!first_packet.is_sacked)
+                retransmit_packet(unacked_packets, first_packet);
+        }
+    } else if (ack_number == m_send_unacknowledged && !unacked_packets.packets.is_empty() && payload_size == 0
+        && !packet.has_syn() && !packet.has_fin() && m_send_window_size != 0 && (!window_changed || has_new_sack_information)) {
+        // RFC 5681, 2: A duplicate acknowledgement, the peer got something after a packet that went missing.
+        ++m_duplicate_acks;
+        if (m_in_fast_recovery) {
+            // RFC 6582, 3.2, step 4: Every duplicate acknowledgement means a packet has left the network.
+            if (!m_sack_permitted)
+                m_congestion_window += m_send_mss;
+        } else if (m_duplicate_acks == duplicate_ack_threshold && !tcp_sequence_before(ack_number, m_recovery_point)) {
+            enter_fast_recovery(unacked_packets);
+        }
+    }
 
-            if (unacked_packets.packets.is_empty()) {
-                m_retransmit_attempts = 0;
-                dequeue_for_retransmit();
+    if (m_in_fast_recovery && m_sack_permitted)
+        mark_lost_packets(unacked_packets);
+    retransmit_lost_packets(unacked_packets);
+}
+
+bool TCPSocket::process_sack_blocks(UnackedPackets& unacked_packets, TCPPacket const& packet)
+{
+    bool has_new_sack_information = false;
+    packet.for_each_option([&](TCPOptionKind kind, ReadonlyBytes data) {
+        if (kind != TCPOptionKind::SACK || data.size() % sizeof(TCPSACKBlock) != 0)
+            return;
+        for (size_t offset = 0; offset < data.size(); offset += sizeof(TCPSACKBlock)) {
+            TCPSACKBlock block;
+            memcpy(&block, data.offset(offset), sizeof(block));
+            u32 left_edge = block.left_edge;
+            u32 right_edge = block.right_edge;
+            // Ignore blocks for data that isn't outstanding.
+            if (!tcp_sequence_before(m_send_unacknowledged, right_edge) || tcp_sequence_before(m_sequence_number, right_edge))
+                continue;
+            for (auto& outgoing_packet : unacked_packets.packets) {
+                if (outgoing_packet.is_sacked || tcp_sequence_before(outgoing_packet.sequence_number, left_edge))
+                    continue;
+                if (!tcp_sequence_before_or_equal(outgoing_packet.ack_number, right_edge))
+                    break;
+                update_outgoing_packet(unacked_packets, outgoing_packet, [](auto& packet) { packet.is_sacked = true; });
+                has_new_sack_information = true;
             }
+        }
+    });
+    return has_new_sack_information;
+}
 
-            dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: receive_tcp_packet acknowledged {} packets", removed);
-        });
+void TCPSocket::mark_lost_packets(UnackedPackets& unacked_packets)
+{
+    // RFC 6675, 4: A packet is considered lost once enough data after it has been SACKed.
+    size_t sacked_bytes_after = 0;
+    for (auto& packet : unacked_packets.packets) {
+        if (packet.is_sacked)
+            sacked_bytes_after += packet.sequence_length();
     }
+    for (auto& packet : unacked_packets.packets) {
+        if (sacked_bytes_after <= (duplicate_ack_threshold - 1) * m_send_mss)
+            break;
+        if (packet.is_sacked)
+            sacked_bytes_after -= packet.sequence_length();
+        else if (!packet.is_lost)
+            update_outgoing_packet(unacked_packets, packet, [](auto& packet) { packet.is_lost = true; });
+    }
+}
 
-    m_packets_in++;
-    m_bytes_in += packet.header_size() + size;
+void TCPSocket::enter_fast_recovery(UnackedPackets& unacked_packets)
+{
+    dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket({}) entering fast recovery, cwnd={}", this, m_congestion_window);
+
+    // RFC 6582, 3.2, step 2
+    reduce_slow_start_threshold();
+    m_in_fast_recovery = true;
+    m_recovery_point = m_sequence_number;
+    // Without SACK, we have to account for the packets that made it to the peer by inflating the window.
+    // With SACK, they already don't count as being in flight anymore (RFC 6675, 5).
+    m_congestion_window = m_slow_start_threshold + (m_sack_permitted ? 0 : duplicate_ack_threshold * m_send_mss);
+
+    ++m_fast_retransmits;
+    retransmit_packet(unacked_packets, unacked_packets.packets.first());
+}
+
+void TCPSocket::reduce_slow_start_threshold()
+{
+    if (m_congestion_control == CongestionControl::Cubic) {
+        // RFC 8312, 4.6: Fast convergence, give up some of the window if we lost packets before reaching the last maximum.
+        if (m_congestion_window < m_cubic.max_window)
+            m_cubic.max_window = static_cast<u64>(m_congestion_window) * (10 + cubic_beta_tenths) / 20;
+        else
+            m_cubic.max_window = m_congestion_window;
+        m_cubic.epoch_start.clear();
+        m_slow_start_threshold = max(static_cast<u32>(static_cast<u64>(m_congestion_window) * cubic_beta_tenths / 10), 2 * m_send_mss);
+        return;
+    }
+
+    // RFC 5681, 3.1, equation (4)
+    u32 flight_size = m_sequence_number - m_send_unacknowledged;
+    m_slow_start_threshold = max(flight_size / 2, 2 * m_send_mss);
+}
+
+void TCPSocket::increase_congestion_window(u32 acknowledged_bytes)
+{
+    if (m_congestion_window >= maximum_congestion_window)
+        return;
+
+    if (m_congestion_window < m_slow_start_threshold) {
+        // RFC 5681, 3.1: Slow start, with the byte counting of RFC 3465 limited to one MSS per acknowledgement.
+        m_congestion_window += min(acknowledged_bytes, m_send_mss);
+        return;
+    }
+
+    if (m_congestion_control == CongestionControl::Cubic) {
+        increase_cubic_congestion_window(acknowledged_bytes);
+        return;
+    }
+
+    // RFC 5681, 3.1, equation (3): Congestion avoidance grows the window by about one MSS per round trip.
+    m_congestion_window += max(1u, m_send_mss * m_send_mss / m_congestion_window);
+}
+
+// Finds the largest x with x * x * x <= value.
+static u64 integer_cube_root(u64 value)
+{
+    u64 low = 0;
+    u64 high = min<u64>(value, 2'097'151); // The cube of this is the largest one that fits in 64 bits.
+    while (low < high) {
+        u64 middle = (low + high + 1) / 2;
+        if (middle * middle * middle <= value)
+            low = middle;
+        else
+            high = middle - 1;
+    }
+    return low;
+}
+
+void TCPSocket::increase_cubic_congestion_window(u32 acknowledged_bytes)
+{
+    // RFC 8312, 4.1: W_cubic(t) = C * (t - K)^3 + W_max, with C = 0.4 segments per second cubed.
+    // We keep windows in bytes and time in milliseconds, so none of this needs floating point.
+    auto now = TimeManagement::the().monotonic_time();
+    if (!m_cubic.epoch_start.has_value()) {
+        m_cubic.epoch_start = now;
+        if (m_congestion_window < m_cubic.max_window) {
+            // K = cbrt((W_max - cwnd) / C) seconds.
+            u64 segments_to_origin = (m_cubic.max_window - m_congestion_window) / m_send_mss;
+            m_cubic.time_to_origin_ms = integer_cube_root(segments_to_origin * 2'500'000'000);
+            m_cubic.origin_window = m_cubic.max_window;
+        } else {
+            m_cubic.time_to_origin_ms = 0;
+            m_cubic.origin_window = m_congestion_window;
+        }
+        m_cubic.estimated_reno_window = m_congestion_window;
+    }
+
+    // Aim for where the curve will be one round trip from now.
+    i64 elapsed_ms = (now - *m_cubic.epoch_start).to_milliseconds() + m_smoothed_round_trip_time.value_or({}).to_milliseconds();
+    i64 offset_ms = clamp<i64>(elapsed_ms - m_cubic.time_to_origin_ms, -2'000'000, 2'000'000);
+    i64 target = static_cast<i64>(m_cubic.origin_window) + (offset_ms * offset_ms * offset_ms / 1'000'000) * 4 * m_send_mss / 10'000;
+    // RFC 8312, 4.3: Don't grow by more than half the window in one round trip.
+    target = clamp<i64>(target, m_congestion_window, m_congestion_window + m_congestion_window / 2);
+
+    if (target > m_congestion_window)
+        m_congestion_window += max<u64>(1, (static_cast<u64>(target) - m_congestion_window) * acknowledged_bytes / m_congestion_window);
+
+    // RFC 8312, 4.2: In the TCP-friendly region, grow at least as fast as standard TCP would, which with
+    // CUBIC's beta is by 3 * (1 - beta) / (1 + beta) = 9/17 segments per round trip.
+    m_cubic.estimated_reno_window += max<u64>(1, static_cast<u64>(9) * m_send_mss * acknowledged_bytes / (17 * static_cast<u64>(m_congestion_window)));
+    m_congestion_window = max(m_congestion_window, m_cubic.estimated_reno_window);
+}
+
+void TCPSocket::update_round_trip_time(Duration sample)
+{
+    // RFC 6298, 2
+    if (!m_smoothed_round_trip_time.has_value()) {
+        m_smoothed_round_trip_time = sample;
+        m_round_trip_time_variance = Duration::from_microseconds(sample.to_microseconds() / 2);
+    } else {
+        auto smoothed_us = m_smoothed_round_trip_time->to_microseconds();
+        auto sample_us = sample.to_microseconds();
+        auto deviation_us = smoothed_us > sample_us ? smoothed_us - sample_us : sample_us - smoothed_us;
+        m_round_trip_time_variance = Duration::from_microseconds((3 * m_round_trip_time_variance.to_microseconds() + deviation_us) / 4);
+        m_smoothed_round_trip_time = Duration::from_microseconds((7 * smoothed_us + sample_us) / 8);
+    }
+
+    auto timeout = *m_smoothed_round_trip_time + Duration::from_microseconds(4 * m_round_trip_time_variance.to_microseconds());
+    m_retransmission_timeout = clamp(timeout, minimum_retransmission_timeout, maximum_retransmission_timeout);
+}
+
+void TCPSocket::process_syn_options(TCPPacket const& packet)
+{
+    Optional<u16> mss;
+    Optional<u8> window_shift;
+    bool sack_permitted = false;
+    packet.for_each_option([&](TCPOptionKind kind, ReadonlyBytes data) {
+        switch (kind) {
+        case TCPOptionKind::MSS:
+            if (data.size() == 2)
+                mss = (data[0] << 8) | data[1];
+            break;
+        case TCPOptionKind::WindowScale:
+            // RFC 7323, 2.3: Shifts larger than 14 are treated as 14.
+            if (data.size() == 1)
+                window_shift = min(data[0], 14);
+            break;
+        case TCPOptionKind::SACKPermitted:
+            if (data.is_empty())
+                sack_permitted = true;
+            break;
+        default:
+            break;
+        }
+    });
+
+    m_send_mss = max(mss.value_or(default_send_mss), minimum_send_mss);
+    if (m_maximum_segment_size != 0)
+        m_send_mss = min(m_send_mss, static_cast<u32>(m_maximum_segment_size));
+    // RFC 7323, 2.2: Window scaling is only enabled if both sides send the option, which we always do.
+    m_window_scaling_enabled = window_shift.has_value();
+    m_send_window_shift = window_shift.value_or(0);
+    m_receive_window_shift = m_window_scaling_enabled ? preferred_receive_window_shift : 0;
+    m_sack_permitted = sack_permitted;
+    m_send_window_size = packet.window_size();
+    m_send_window_update_sequence_number = packet.sequence_number();
+    m_send_window_update_ack_number = m_send_unacknowledged;
+
+    // RFC 6928: Increasing TCP's Initial Window
+    m_congestion_window = min(10 * m_send_mss, max(2 * m_send_mss, 14600u));
 }
 
 bool TCPSocket::should_delay_next_ack() const
@@ -445,6 +912,29 @@ ErrorOr<void> TCPSocket::setsockopt(int level, int option, Userspace<void const*
             return EINVAL;
         m_no_delay = value;
         return {};
+    case TCP_MAXSEG: {
+        if (user_value_size < sizeof(int))
+            return EINVAL;
+        int value;
+        TRY(copy_from_user(&value, static_ptr_cast<int const*>(user_value)));
+        if (value != 0 && (value < static_cast<int>(minimum_send_mss) || value > NumericLimits<u16>::max()))
+            return EINVAL;
+        m_maximum_segment_size = value;
+        return {};
+    }
+    case TCP_CONGESTION: {
+        char name[TCP_CA_NAME_MAX] {};
+        TRY(copy_from_user(name, static_ptr_cast<char const*>(user_value), min<size_t>(user_value_size, sizeof(name) - 1)));
+        auto name_view = StringView { name, strlen(name) };
+        if (name_view == to_string(CongestionControl::NewReno))
+            m_congestion_control = CongestionControl::NewReno;
+        else if (name_view == to_string(CongestionControl::Cubic))
+            m_congestion_control = CongestionControl::Cubic;
+        else
+            return ENOENT;
+        m_cubic = {};
+        return {};
+    }
     default:
         dbgln("setsockopt({}) at IPPROTO_TCP not implemented.", option);
         return ENOPROTOOPT;
@@ -470,6 +960,23 @@ ErrorOr<void> TCPSocket::getsockopt(OpenFileDescription& description, int level,
         size = sizeof(nodelay);
         return copy_to_user(value_size, &size);
     }
+    case TCP_MAXSEG: {
+        // Before the connection is set up, this is only what we were asked for.
+        int maximum_segment_size = m_state == State::Established ? m_send_mss : m_maximum_segment_size;
+        if (size < sizeof(maximum_segment_size))
+            return EINVAL;
+        TRY(copy_to_user(static_ptr_cast<int*>(value), &maximum_segment_size));
+        size = sizeof(maximum_segment_size);
+        return copy_to_user(value_size, &size);
+    }
+    case TCP_CONGESTION: {
+        auto name = to_string(m_congestion_control);
+        size = min<socklen_t>(size, name.length() + 1);
+        char buffer[TCP_CA_NAME_MAX] {};
+        name.bytes().copy_to({ buffer, sizeof(buffer) - 1 });
+        TRY(copy_to_user(static_ptr_cast<char*>(value), buffer, size));
+        return copy_to_user(value_size, &size);
+    }
     default:
         dbgln("getsockopt({}) at IPPROTO_TCP not implemented.", option);
         return ENOPROTOOPT;
@@ -538,7 +1045,7 @@ ErrorOr<void> TCPSocket::protocol_listen()
     return {};
 }
 
-ErrorOr<void> TCPSocket::protocol_connect(OpenFileDescription& description)
+ErrorOr<void> TCPSocket::protocol_connect(OpenFileDescription& description, bool blocking)
 {
     MutexLocker locker(mutex());
 
@@ -550,7 +1057,7 @@ ErrorOr<void> TCPSocket::protocol_connect(OpenFileDescription& description)
 
     TRY(ensure_bound());
 
-    m_sequence_number = get_good_random<u32>();
+    set_initial_sequence_number(get_good_random<u32>());
     m_ack_number = 0;
 
     set_setup_state(SetupState::InProgress);
@@ -561,26 +1068,31 @@ ErrorOr<void> TCPSocket::protocol_connect(OpenFileDescription& description)
 
     evaluate_block_conditions();
 
-    if (description.is_blocking()) {
+    if (blocking) {
         locker.unlock();
         auto unblock_flags = Thread::FileBlocker::BlockFlags::None;
         if (Thread::current()->block<Thread::ConnectBlocker>({}, description, unblock_flags).was_interrupted())
             return set_so_error(EINTR);
-        locker.lock();
-        VERIFY(setup_state() == SetupState::Completed);
-        if (has_error()) { // TODO: check unblock_flags
-            set_role(Role::None);
-            if (error() == TCPSocket::Error::RetransmitTimeout)
-                return set_so_error(ETIMEDOUT);
-            else
-                return set_so_error(ECONNREFUSED);
-        }
-        return {};
+        return connect_result();
     }
 
     return set_so_error(EINPROGRESS);
 }
 
+ErrorOr<void> TCPSocket::connect_result()
+{
+    MutexLocker locker(mutex());
+    VERIFY(setup_state() == SetupState::Completed);
+    if (has_error()) { // TODO: check unblock_flags
+        set_role(Role::None);
+        if (error() == TCPSocket::Error::RetransmitTimeout)
+            return set_so_error(ETIMEDOUT);
+        else
+            return set_so_error(ECONNREFUSED);
+    }
+    return {};
+}
+
 bool TCPSocket::protocol_is_disconnected() const
 {
     switch (m_state) {
@@ -625,6 +1137,87 @@ ErrorOr<void> TCPSocket::close()
     return result;
 }
 
+void TCPSocket::queue_out_of_order_segment(IPv4Packet const& ipv4_packet, TCPPacket const& tcp_packet, size_t payload_size)
+{
+    u32 sequence_number = tcp_packet.sequence_number();
+    if (payload_size == 0 || !tcp_sequence_before(m_ack_number, sequence_number))
+        return;
+
+    // Only keep what fits into the window we advertised, so there will be room for it in the receive buffer.
+    if (sequence_number + payload_size - m_ack_number > receive_buffer_space())
+        return;
+    if (m_out_of_order_segments.size() >= maximum_out_of_order_segments)
+        return;
+
+    size_t index = 0;
+    while (index < m_out_of_order_segments.size() && !tcp_sequence_before(sequence_number, m_out_of_order_segments[index].sequence_number))
+        ++index;
+    // Don't bother with segments that overlap ones we already have, the gaps will be filled by retransmissions.
+    if (index > 0) {
+        auto& previous = m_out_of_order_segments[index - 1];
+        if (tcp_sequence_before(sequence_number, previous.sequence_number + previous.size))
+            return;
+    }
+    if (index < m_out_of_order_segments.size() && tcp_sequence_before(m_out_of_order_segments[index].sequence_number, sequence_number + payload_size))
+        return;
+
+    auto packet_or_error = KBuffer::try_create_with_bytes("TCPSocket: Out-of-order segment"sv, { &ipv4_packet, sizeof(IPv4Packet) + ipv4_packet.payload_size() });
+    if (packet_or_error.is_error())
+        return;
+    if (m_out_of_order_segments.try_insert(index, { sequence_number, static_cast<u32>(payload_size), packet_or_error.release_value() }).is_error())
+        return;
+    m_out_of_order_bytes += payload_size;
+    m_last_out_of_order_sequence_number = sequence_number;
+}
+
+bool TCPSocket::deliver_queued_segments(UnixDateTime const& packet_timestamp)
+{
+    bool did_deliver = false;
+    while (!m_out_of_order_segments.is_empty() && !tcp_sequence_before(m_ack_number, m_out_of_order_segments.first().sequence_number)) {
+        auto segment = m_out_of_order_segments.take_first();
+        m_out_of_order_bytes -= segment.size;
+        u32 end = segment.sequence_number + segment.size;
+        // All of this came in with a retransmission in the meantime.
+        if (tcp_sequence_before_or_equal(end, m_ack_number))
+            continue;
+        auto bytes = segment.packet->bytes();
+        if (segment.sequence_number != m_ack_number) {
+            // Only the start of this came in with a retransmission in the meantime, so hand over the rest.
+            u32 overlap = m_ack_number - segment.sequence_number;
+            auto& tcp_packet = *reinterpret_cast<TCPPacket*>(segment.packet->data() + sizeof(IPv4Packet));
+            auto* payload = static_cast<u8*>(tcp_packet.payload());
+            memmove(payload, payload + overlap, end - m_ack_number);
+            bytes = bytes.trim(bytes.size() - overlap);
+        }
+        if (!did_receive(peer_address(), peer_port(), bytes, packet_timestamp))
+            break;
+        m_ack_number = end;
+        did_deliver = true;
+    }
+    return did_deliver;
+}
+
+void TCPSocket::drop_queued_segments()
+{
+    m_out_of_order_segments.clear();
+    m_out_of_order_bytes = 0;
+}
+
+void TCPSocket::protocol_did_consume_received_data()
+{
+    if (m_state != State::Established)
+        return;
+
+    // RFC 9293, 3.8.6.2.2: Let the peer know about the room we made, but only once it's grown by a useful amount,
+    // so we don't flood it with window updates.
+    auto window = advertised_window();
+    if (window <= m_last_advertised_window || window - m_last_advertised_window < min(m_send_mss, receive_buffer_size / 2))
+        return;
+    if (m_last_advertised_window >= window / 2)
+        return;
+    [[maybe_unused]] auto result = send_ack(true);
+}
+
 static Singleton<MutexProtected<TCPSocket::RetransmitList>> s_sockets_for_retransmit;
 
 MutexProtected<TCPSocket::RetransmitList>& TCPSocket::sockets_for_retransmit()
@@ -650,68 +1243,167 @@ void TCPSocket::retransmit_packets()
 {
     auto now = TimeManagement::the().monotonic_time();
 
-    // RFC6298 says we should have at least one second between retransmits. According to
-    // RFC1122 we must do exponential backoff - even for SYN packets.
-    i64 retransmit_interval = 1;
-    for (decltype(m_retransmit_attempts) i = 0; i < m_retransmit_attempts; i++)
-        retransmit_interval *= 2;
+    // RFC 6298, 5.5: Back off the timer exponentially, which RFC 1122 requires even for SYN packets.
+    auto timeout = m_retransmission_timeout;
+    for (decltype(m_retransmit_attempts) i = 0; i < m_retransmit_attempts && timeout < maximum_retransmission_timeout; i++)
+        timeout = timeout + timeout;
+    timeout = min(timeout, maximum_retransmission_timeout);
 
-    if (m_last_retransmit_time > now - Duration::from_seconds(retransmit_interval))
+    if (now < m_retransmit_timer_start + timeout)
         return;
 
     dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket({}) handling retransmit", this);
 
-    m_last_retransmit_time = now;
+    m_retransmit_timer_start = now;
     ++m_retransmit_attempts;
 
-    if (m_retransmit_attempts > maximum_retransmits) {
+    // RFC 1122, 4.2.2.17: The peer may keep its window closed for as long as it likes, so probing it doesn't count
+    // towards giving up on the connection.
+    bool is_window_probe = m_send_window_size == 0;
+    if (is_window_probe)
+        ++m_window_probe_retransmits;
+
+    if (m_retransmit_attempts - m_window_probe_retransmits > maximum_retransmits) {
         set_state(TCPSocket::State::Closed);
         set_error(TCPSocket::Error::RetransmitTimeout);
         set_setup_state(Socket::SetupState::Completed);
         return;
     }
 
+    m_unacked_packets.with_exclusive([&](auto& unacked_packets) {
+        if (unacked_packets.packets.is_empty())
+            return;
+
+        // A probe going unanswered says nothing about the path, so it leaves the congestion state alone.
+        if (is_window_probe) {
+            retransmit_packet(unacked_packets, unacked_packets.packets.first());
+            return;
+        }
+
+        ++m_retransmission_timeouts;
+
+        // RFC 5681, 3.1: After a timeout, start over from slow start with a single packet. The threshold is only
+        // lowered for the first timeout, since the backed off retransmissions don't say anything new about the path.
+        if (m_retransmit_attempts == 1)
+            reduce_slow_start_threshold();
+        m_congestion_window = m_send_mss;
+        m_in_fast_recovery = false;
+        m_recovery_point = m_sequence_number;
+        m_duplicate_acks = 0;
+
+        // Everything outstanding is presumed lost, and RFC 2018, 8 says the peer may have dropped what it SACKed.
+        for (auto& packet : unacked_packets.packets) {
+            update_outgoing_packet(unacked_packets, packet, [](auto& packet) {
+                packet.is_sacked = false;
+                packet.is_lost = true;
+                packet.is_retransmitted = false;
+            });
+        }
+        retransmit_packet(unacked_packets, unacked_packets.packets.first());
+    });
+}
+
+void TCPSocket::retransmit_lost_packets(UnackedPackets& unacked_packets)
+{
+    for (auto& packet : unacked_packets.packets) {
+        if (unacked_packets.pending_retransmits == 0 || unacked_packets.in_flight >= m_congestion_window)
+            return;
+        if (packet.needs_retransmit())
+            retransmit_packet(unacked_packets, packet);
+    }
+}
+
+void TCPSocket::retransmit_packet(UnackedPackets& unacked_packets, OutgoingPacket& packet)
+{
+    update_outgoing_packet(unacked_packets, packet, [](auto& packet) {
+        packet.is_lost = true;
+        packet.is_retransmitted = true;
+    });
+    packet.tx_counter++;
+    packet.sent_time = TimeManagement::the().monotonic_time();
+
+    if constexpr (TCP_SOCKET_DEBUG) {
+        auto& tcp_packet = *(const TCPPacket*)(packet.buffer->buffer->data() + packet.ipv4_payload_offset);
+        dbgln("Sending TCP packet from {}:{} to {}:{} with ({}{}{}{}) seq_no={}, ack_no={}, tx_counter={}",
+            local_address(), local_port(),
+            peer_address(), peer_port(),
+            (tcp_packet.has_syn() ? "SYN " : ""),
+            (tcp_packet.has_ack() ? "ACK " : ""),
+            (tcp_packet.has_fin() ? "FIN " : ""),
+            (tcp_packet.has_rst() ? "RST " : ""),
+            tcp_packet.sequence_number(),
+            tcp_packet.ack_number(),
+            packet.tx_counter);
+    }
+
     auto adapter = bound_interface().with([](auto& bound_device) -> RefPtr<NetworkAdapter> { return bound_device; });
     auto routing_decision = route_to(peer_address(), local_address(), adapter);
     if (routing_decision.is_zero())
         return;
 
-    m_unacked_packets.with_exclusive([&](auto& unacked_packets) {
-        for (auto& packet : unacked_packets.packets) {
-            packet.tx_counter++;
-
-            if constexpr (TCP_SOCKET_DEBUG) {
-                auto& tcp_packet = *(const TCPPacket*)(packet.buffer->buffer->data() + packet.ipv4_payload_offset);
-                dbgln("Sending TCP packet from {}:{} to {}:{} with ({}{}{}{}) seq_no={}, ack_no={}, tx_counter={}",
-                    local_address(), local_port(),
-                    peer_address(), peer_port(),
-                    (tcp_packet.has_syn() ? "SYN " : ""),
-                    (tcp_packet.has_ack() ? "ACK " : ""),
-                    (tcp_packet.has_fin() ? "FIN " : ""),
-                    (tcp_packet.has_rst() ? "RST " : ""),
-                    tcp_packet.sequence_number(),
-                    tcp_packet.ack_number(),
-                    packet.tx_counter);
-            }
+    size_t ipv4_payload_offset = routing_decision.adapter->ipv4_payload_offset();
+    if (ipv4_payload_offset != packet.ipv4_payload_offset) {
+        // FIXME: Add support for this. This can happen if after a route change
+        // we ended up on another adapter which doesn't have the same layer 2 type
+        // like the previous adapter.
+        VERIFY_NOT_REACHED();
+    }
+    if (!routing_decision.adapter->can_offload(packet.buffer->transmit_offload)) {
+        retransmit_packet_in_software(*routing_decision.adapter, routing_decision.next_hop, packet);
+        return;
+    }
 
-            size_t ipv4_payload_offset = routing_decision.adapter->ipv4_payload_offset();
-            if (ipv4_payload_offset != packet.ipv4_payload_offset) {
-                // FIXME: Add support for this. This can happen if after a route change
-                // we ended up on another adapter which doesn't have the same layer 2 type
-                // like the previous adapter.
-                VERIFY_NOT_REACHED();
-            }
+    auto packet_buffer = packet.buffer->bytes();
 
-            auto packet_buffer = packet.buffer->bytes();
+    routing_decision.adapter->fill_in_ipv4_header(*packet.buffer,
+        local_address(), routing_decision.next_hop, peer_address(),
+        IPv4Protocol::TCP, packet_buffer.size() - ipv4_payload_offset, type_of_service(), ttl());
+    routing_decision.adapter->send_packet(packet_buffer, packet.buffer->transmit_offload);
+    m_packets_out++;
+    m_bytes_out += packet_buffer.size();
+    m_retransmitted_packets++;
+}
 
-            routing_decision.adapter->fill_in_ipv4_header(*packet.buffer,
-                local_address(), routing_decision.next_hop, peer_address(),
-                IPv4Protocol::TCP, packet_buffer.size() - ipv4_payload_offset, type_of_service(), ttl());
-            routing_decision.adapter->send_packet(packet_buffer);
-            m_packets_out++;
-            m_bytes_out += packet_buffer.size();
+// The adapter we're on now can't finish the packet the way it was built, so we cut it into segments and checksum them ourselves.
+void TCPSocket::retransmit_packet_in_software(NetworkAdapter& adapter, MACAddress const& next_hop, OutgoingPacket const& packet)
+{
+    auto ipv4_payload_offset = packet.ipv4_payload_offset;
+    auto const& tcp_packet = *reinterpret_cast<TCPPacket const*>(packet.buffer->buffer->data() + ipv4_payload_offset);
+    auto header_size = tcp_packet.header_size();
+    auto payload_size = packet.buffer->buffer->size() - ipv4_payload_offset - header_size;
+    auto segment_size = packet.buffer->transmit_offload.segment_size;
+    if (segment_size == 0)
+        segment_size = payload_size;
+
+    size_t offset = 0;
+    do {
+        auto length = min(static_cast<size_t>(segment_size), payload_size - offset);
+        auto segment = adapter.acquire_packet_buffer(ipv4_payload_offset + header_size + length);
+        if (!segment) {
+            dbgln("TCPSocket: Dropped retransmitted segment because acquire_packet_buffer() failed");
+            return;
         }
-    });
+        auto* segment_data = segment->buffer->data();
+        memcpy(segment_data + ipv4_payload_offset, &tcp_packet, header_size);
+        memcpy(segment_data + ipv4_payload_offset + header_size, static_cast<u8 const*>(tcp_packet.payload()) + offset, length);
+
+        auto& segment_tcp_packet = *reinterpret_cast<TCPPacket*>(segment_data + ipv4_payload_offset);
+        segment_tcp_packet.set_sequence_number(tcp_packet.sequence_number() + offset);
+        // Like with segmentation offload, only the last segment keeps FIN and PSH.
+        if (offset + length != payload_size)
+            segment_tcp_packet.set_flags(tcp_packet.flags() & ~(TCPFlags::FIN | TCPFlags::PSH));
+        segment_tcp_packet.set_checksum(0);
+        segment_tcp_packet.set_checksum(compute_tcp_checksum(local_address(), peer_address(), segment_tcp_packet, length));
+
+        adapter.fill_in_ipv4_header(*segment, local_address(), next_hop, peer_address(),
+            IPv4Protocol::TCP, header_size + length, type_of_service(), ttl());
+        adapter.send_packet(segment->bytes());
+        m_packets_out++;
+        m_bytes_out += segment->buffer->size();
+        adapter.release_packet_buffer(*segment);
+        offset += length;
+    } while (offset < payload_size);
+    m_retransmitted_packets++;
 }
 
 bool TCPSocket::can_write(OpenFileDescription const& file_description, u64 size) const
@@ -722,11 +1414,10 @@ bool TCPSocket::can_write(OpenFileDescription const& file_description, u64 size)
     if (m_state == State::SynSent || m_state == State::SynReceived)
         return false;
 
-    if (!file_description.is_blocking())
-        return true;
-
     return m_unacked_packets.with_shared([&](auto& unacked_packets) {
-        return unacked_packets.size + size <= m_send_window_size;
+        // With nothing outstanding we also send smaller segments, e.g. to probe a closed window.
+        auto window = usable_send_window(unacked_packets);
+        return window >= m_send_mss || (window > 0 && m_sequence_number == m_send_unacknowledged);
     });
 }
 }
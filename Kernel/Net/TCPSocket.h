@@ -14,6 +14,7 @@
 #include <Kernel/Library/LockWeakPtr.h>
 #include <Kernel/Locking/MutexProtected.h>
 #include <Kernel/Net/IPv4Socket.h>
+#include <Kernel/Net/TCP.h>
 
 namespace Kernel {
 
@@ -101,6 +102,23 @@ public:
         RetransmitTimeout,
     };
 
+    enum class CongestionControl {
+        NewReno,
+        Cubic,
+    };
+
+    static StringView to_string(CongestionControl congestion_control)
+    {
+        switch (congestion_control) {
+        case CongestionControl::NewReno:
+            return "reno"sv;
+        case CongestionControl::Cubic:
+            return "cubic"sv;
+        default:
+            return "None"sv;
+        }
+    }
+
     static StringView to_string(Error error)
     {
         switch (error) {
@@ -127,7 +145,7 @@ public:
     void set_error(Error error) { m_error = error; }
 
     void set_ack_number(u32 n) { m_ack_number = n; }
-    void set_sequence_number(u32 n) { m_sequence_number = n; }
+    void set_initial_sequence_number(u32);
     u32 ack_number() const { return m_ack_number; }
     u32 sequence_number() const { return m_sequence_number; }
     u32 packets_in() const { return m_packets_in; }
@@ -135,15 +153,35 @@ public:
     u32 packets_out() const { return m_packets_out; }
     u32 bytes_out() const { return m_bytes_out; }
 
-    // FIXME: Make this configurable?
-    static constexpr u32 maximum_duplicate_acks = 5;
-    void set_duplicate_acks(u32 acks) { m_duplicate_acks = acks; }
-    u32 duplicate_acks() const { return m_duplicate_acks; }
+    CongestionControl congestion_control() const { return m_congestion_control; }
+    u32 send_mss() const { return m_send_mss; }
+    u32 congestion_window() const { return m_congestion_window; }
+    u32 slow_start_threshold() const { return m_slow_start_threshold; }
+    u32 send_window_size() const { return m_send_window_size; }
+    u32 receive_window_size() const { return m_last_advertised_window; }
+    u8 send_window_shift() const { return m_send_window_shift; }
+    u8 receive_window_shift() const { return m_receive_window_shift; }
+    bool is_sack_permitted() const { return m_sack_permitted; }
+    Optional<Duration> smoothed_round_trip_time() const { return m_smoothed_round_trip_time; }
+    Duration round_trip_time_variance() const { return m_round_trip_time_variance; }
+    Duration retransmission_timeout() const { return m_retransmission_timeout; }
+    u32 retransmitted_packets() const { return m_retransmitted_packets; }
+    u32 fast_retransmits() const { return m_fast_retransmits; }
+    u32 retransmission_timeouts() const { return m_retransmission_timeouts; }
 
     ErrorOr<void> send_ack(bool allow_duplicate = false);
     ErrorOr<void> send_tcp_packet(u16 flags, UserOrKernelBuffer const* = nullptr, size_t = 0, RoutingDecision* = nullptr);
     void receive_tcp_packet(TCPPacket const&, u16 size);
 
+    // Takes the MSS, window scale and SACK-permitted options from a SYN the peer sent us.
+    void process_syn_options(TCPPacket const&);
+
+    // Keeps a segment that arrived ahead of a missing one, and hands queued segments to the receive buffer
+    // once the gap before them has been filled.
+    void queue_out_of_order_segment(IPv4Packet const&, TCPPacket const&, size_t payload_size);
+    bool deliver_queued_segments(UnixDateTime const& packet_timestamp);
+    void drop_queued_segments();
+
     bool should_delay_next_ack() const;
 
     static MutexProtected<HashMap<IPv4SocketTuple, TCPSocket*>>& sockets_by_tuple();
@@ -160,6 +198,7 @@ public:
     void retransmit_packets();
 
     virtual ErrorOr<void> close() override;
+    virtual ErrorOr<void> connect_result() override;
 
     virtual bool can_write(OpenFileDescription const&, u64) const override;
 
@@ -179,15 +218,19 @@ private:
 
     virtual ErrorOr<size_t> protocol_receive(ReadonlyBytes raw_ipv4_packet, UserOrKernelBuffer& buffer, size_t buffer_size, int flags) override;
     virtual ErrorOr<size_t> protocol_send(UserOrKernelBuffer const&, size_t) override;
-    virtual ErrorOr<void> protocol_connect(OpenFileDescription&) override;
+    virtual ErrorOr<void> protocol_connect(OpenFileDescription&, bool blocking) override;
     virtual ErrorOr<size_t> protocol_size(ReadonlyBytes raw_ipv4_packet) override;
     virtual bool protocol_is_disconnected() const override;
     virtual ErrorOr<void> protocol_bind() override;
     virtual ErrorOr<void> protocol_listen() override;
 
+    virtual void protocol_did_consume_received_data() override;
+
     void enqueue_for_retransmit();
     void dequeue_for_retransmit();
 
+    u32 advertised_window() const;
+
     LockWeakPtr<TCPSocket> m_originator;
     HashMap<IPv4SocketTuple, NonnullRefPtr<TCPSocket>> m_pending_release_for_accept;
     Direction m_direction { Direction::Unspecified };
@@ -202,20 +245,56 @@ private:
     u32 m_bytes_out { 0 };
 
     struct OutgoingPacket {
+        u32 sequence_number { 0 };
         u32 ack_number { 0 };
         RefPtr<PacketWithTimestamp> buffer;
         size_t ipv4_payload_offset;
         LockWeakPtr<NetworkAdapter> adapter;
         int tx_counter { 0 };
+        MonotonicTime sent_time;
+        // The peer has told us it got this packet, but it can't acknowledge it until the gap before it is filled.
+        bool is_sacked { false };
+        bool is_lost { false };
+        // Set when a packet that was deemed lost has been sent again.
+        bool is_retransmitted { false };
+
+        u32 sequence_length() const { return ack_number - sequence_number; }
+        // RFC 6675, 4: Everything that counts towards "pipe", the data that is probably still in the network.
+        bool is_in_flight() const { return !is_sacked && (!is_lost || is_retransmitted); }
+        bool needs_retransmit() const { return !is_sacked && is_lost && !is_retransmitted; }
     };
 
     struct UnackedPackets {
         SinglyLinkedList<OutgoingPacket> packets;
         size_t size { 0 };
+        size_t in_flight { 0 };
+        size_t pending_retransmits { 0 };
     };
 
+    // Applies a change to the flags of a packet, and keeps the number of bytes in flight up to date.
+    template<typename Callback>
+    static void update_outgoing_packet(UnackedPackets&, OutgoingPacket&, Callback);
+
+    void process_ack(UnackedPackets&, TCPPacket const&, size_t payload_size);
+    bool process_sack_blocks(UnackedPackets&, TCPPacket const&);
+    void mark_lost_packets(UnackedPackets&);
+    void update_round_trip_time(Duration sample);
+    void enter_fast_recovery(UnackedPackets&);
+    void reduce_slow_start_threshold();
+    void increase_congestion_window(u32 acknowledged_bytes);
+    void increase_cubic_congestion_window(u32 acknowledged_bytes);
+    void retransmit_packet(UnackedPackets&, OutgoingPacket&);
+    void retransmit_packet_in_software(NetworkAdapter&, MACAddress const& next_hop, OutgoingPacket const&);
+    void retransmit_lost_packets(UnackedPackets&);
+    size_t usable_send_window(UnackedPackets const&) const;
+
+    static constexpr size_t maximum_sack_blocks = 4;
+    void collect_sack_blocks(Vector<TCPSACKBlock, maximum_sack_blocks>&) const;
+
     MutexProtected<UnackedPackets> m_unacked_packets;
 
+    // The oldest sequence number that the peer hasn't acknowledged yet (SND.UNA).
+    u32 m_send_unacknowledged { 0 };
     u32 m_duplicate_acks { 0 };
 
     u32 m_last_ack_number_sent { 0 };
@@ -223,14 +302,77 @@ private:
 
     // FIXME: Make this configurable (sysctl)
     static constexpr u32 maximum_retransmits = 5;
-    MonotonicTime m_last_retransmit_time;
+    MonotonicTime m_retransmit_timer_start;
     u32 m_retransmit_attempts { 0 };
+    u32 m_window_probe_retransmits { 0 };
+
+    // RFC 6298: Computing TCP's Retransmission Timer
+    static constexpr Duration minimum_retransmission_timeout = Duration::from_seconds(1);
+    static constexpr Duration maximum_retransmission_timeout = Duration::from_seconds(60);
+    Optional<Duration> m_smoothed_round_trip_time;
+    Duration m_round_trip_time_variance;
+    Duration m_retransmission_timeout { Duration::from_seconds(1) };
+
+    // RFC 9293, 3.7.1: The default send MSS is 536 bytes if the peer doesn't tell us otherwise.
+    static constexpr u32 default_send_mss = 536;
+    static constexpr u32 minimum_send_mss = 64;
+    u32 m_send_mss { default_send_mss };
+    size_t send_mss(NetworkAdapter const&) const;
+
+    // RFC 5681: TCP Congestion Control, with the fast recovery of RFC 6582 (NewReno).
+    static constexpr u32 duplicate_ack_threshold = 3;
+    static constexpr u32 maximum_congestion_window = 1 * GiB;
+    CongestionControl m_congestion_control { CongestionControl::Cubic };
+    u32 m_congestion_window { 10 * default_send_mss };
+    u32 m_slow_start_threshold { NumericLimits<u32>::max() };
+    bool m_in_fast_recovery { false };
+    u32 m_recovery_point { 0 };
+
+    // RFC 8312: CUBIC for Fast Long-Distance Networks
+    static constexpr u32 cubic_beta_tenths = 7;
+    struct CubicState {
+        u32 max_window { 0 };
+        Optional<MonotonicTime> epoch_start;
+        u32 origin_window { 0 };
+        i64 time_to_origin_ms { 0 };
+        u32 estimated_reno_window { 0 };
+    };
+    CubicState m_cubic;
+
+    // The peer's window, scaled by the shift it asked for (RFC 7323).
+    u32 m_send_window_size { NumericLimits<u16>::max() };
+    u8 m_send_window_shift { 0 };
+    // The sequence and acknowledgement numbers of the segment we last took the peer's window from (SND.WL1 and SND.WL2).
+    u32 m_send_window_update_sequence_number { 0 };
+    u32 m_send_window_update_ack_number { 0 };
+    // The shift we ask the peer to apply to our windows, so they can cover the whole receive buffer.
+    static constexpr u8 preferred_receive_window_shift = 3;
+    static_assert((static_cast<size_t>(NumericLimits<u16>::max()) << preferred_receive_window_shift) >= receive_buffer_size);
+    u8 m_receive_window_shift { 0 };
+    bool m_window_scaling_enabled { false };
+    u32 m_last_advertised_window { 0 };
+
+    // RFC 2018: TCP Selective Acknowledgment Options
+    bool m_sack_permitted { false };
+
+    struct OutOfOrderSegment {
+        u32 sequence_number { 0 };
+        u32 size { 0 };
+        NonnullOwnPtr<KBuffer> packet;
+    };
+    // Sorted by sequence number and never overlapping.
+    static constexpr size_t maximum_out_of_order_segments = 256;
+    Vector<OutOfOrderSegment> m_out_of_order_segments;
+    size_t m_out_of_order_bytes { 0 };
+    u32 m_last_out_of_order_sequence_number { 0 };
 
-    // Default to maximum window size. receive_tcp_packet() will update from the
-    // peer's advertised window size.
-    u32 m_send_window_size { 64 * KiB };
+    u32 m_retransmitted_packets { 0 };
+    u32 m_fast_retransmits { 0 };
+    u32 m_retransmission_timeouts { 0 };
 
     bool m_no_delay { false };
+    // Set with TCP_MAXSEG, 0 if we go by what the peer and the adapter can take.
+    u16 m_maximum_segment_size { 0 };
 
     IntrusiveListNode<TCPSocket> m_retransmit_list_node;
 
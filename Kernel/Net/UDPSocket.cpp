@@ -82,6 +82,9 @@ ErrorOr<size_t> UDPSocket::protocol_receive(ReadonlyBytes raw_ipv4_packet, UserO
     return read_size;
 }
 
+// Where the checksum is in the UDP header, for adapters that fill it in.
+static constexpr u16 udp_checksum_offset = 6;
+
 ErrorOr<size_t> UDPSocket::protocol_send(UserOrKernelBuffer const& data, size_t data_length)
 {
     auto adapter = bound_interface().with([](auto& bound_device) -> RefPtr<NetworkAdapter> { return bound_device; });
@@ -102,11 +105,17 @@ ErrorOr<size_t> UDPSocket::protocol_send(UserOrKernelBuffer const& data, size_t
     SOCKET_TRY(data.read(udp_packet.payload(), data_length));
     routing_decision.adapter->fill_in_ipv4_header(*packet, local_address(), routing_decision.next_hop,
         peer_address(), IPv4Protocol::UDP, udp_buffer_size, type_of_service(), ttl());
-    routing_decision.adapter->send_packet(packet->bytes());
+    // The checksum is optional, so we only have one when it's free.
+    if (routing_decision.adapter->has_offload(NetworkAdapter::Offload::TransmitChecksum)) {
+        packet->transmit_offload.checksum_start = ipv4_payload_offset;
+        packet->transmit_offload.checksum_offset = udp_checksum_offset;
+        udp_packet.set_checksum(pseudo_header_checksum(local_address(), peer_address(), IPv4Protocol::UDP, udp_buffer_size));
+    }
+    routing_decision.adapter->send_packet(packet->bytes(), packet->transmit_offload);
     return data_length;
 }
 
-ErrorOr<void> UDPSocket::protocol_connect(OpenFileDescription&)
+ErrorOr<void> UDPSocket::protocol_connect(OpenFileDescription&, bool)
 {
     TRY(ensure_bound());
     set_role(Role::Connected);
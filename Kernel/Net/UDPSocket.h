@@ -29,7 +29,7 @@ private:
     virtual ErrorOr<size_t> protocol_receive(ReadonlyBytes raw_ipv4_packet, UserOrKernelBuffer& buffer, size_t buffer_size, int flags) override;
     virtual ErrorOr<size_t> protocol_send(UserOrKernelBuffer const&, size_t) override;
     virtual ErrorOr<size_t> protocol_size(ReadonlyBytes raw_ipv4_packet) override;
-    virtual ErrorOr<void> protocol_connect(OpenFileDescription&) override;
+    virtual ErrorOr<void> protocol_connect(OpenFileDescription&, bool blocking) override;
     virtual ErrorOr<void> protocol_bind() override;
 };
 
@@ -7,6 +7,7 @@
 #include <Kernel/Bus/PCI/IDs.h>
 #include <Kernel/Bus/VirtIO/Transport/PCIe/TransportLink.h>
 #include <Kernel/Net/NetworkingManagement.h>
+#include <Kernel/Net/TCP.h>
 #include <Kernel/Net/VirtIO/VirtIONetworkAdapter.h>
 
 namespace Kernel {
@@ -48,8 +49,8 @@ static constexpr u16 VIRTIO_NET_S_LINK_UP = 1;
 static constexpr u16 VIRTIO_NET_S_ANNOUNCE = 2;
 
 static constexpr u8 VIRTIO_NET_HDR_F_NEEDS_CSUM = 1;
-static constexpr u8 VIRTIO_NET_HDR_F_DATA_VALID = 1;
-static constexpr u8 VIRTIO_NET_HDR_F_RSC_INFO = 1;
+static constexpr u8 VIRTIO_NET_HDR_F_DATA_VALID = 2;
+static constexpr u8 VIRTIO_NET_HDR_F_RSC_INFO = 4;
 static constexpr u8 VIRTIO_NET_HDR_GSO_NONE = 0;
 static constexpr u8 VIRTIO_NET_HDR_GSO_TCPV4 = 1;
 static constexpr u8 VIRTIO_NET_HDR_GSO_UDP = 3;
@@ -80,16 +81,31 @@ struct [[gnu::packed]] VirtIONetHdr {
     u8 frame[0];
 };
 
+static constexpr u8 VIRTIO_NET_OK = 0;
+static constexpr u8 VIRTIO_NET_ERR = 1;
+
+static constexpr u8 VIRTIO_NET_CTRL_MQ = 4;
+static constexpr u8 VIRTIO_NET_CTRL_MQ_VQ_PAIRS_SET = 0;
+
+struct [[gnu::packed]] VirtIONetCtrlHdr {
+    u8 class_;
+    u8 command;
+};
+
+struct [[gnu::packed]] VirtIONetCtrlMQ {
+    VirtIONetCtrlHdr header;
+    LittleEndian<u16> virtqueue_pairs;
+};
+
 }
 
 using namespace VirtIO;
 
-static constexpr u16 RECEIVEQ = 0;
-static constexpr u16 TRANSMITQ = 1;
-
-static constexpr size_t MAX_RX_FRAME_SIZE = 1514; // Non-jumbo Ethernet frame limit.
-static constexpr size_t RX_BUFFER_SIZE = sizeof(VirtIONetHdr) * MAX_RX_FRAME_SIZE;
+static constexpr u16 MAX_QUEUE_PAIRS = 8;
 static constexpr u16 MAX_INFLIGHT_PACKETS = 128;
+// Segmentation offload lets us send IPv4 packets of up to 64 KiB.
+static constexpr size_t MAX_TSO_FRAME_SIZE = sizeof(EthernetFrameHeader) + NumericLimits<u16>::max();
+static constexpr size_t MAX_INFLIGHT_TSO_FRAMES = 16;
 
 UNMAP_AFTER_INIT ErrorOr<bool> VirtIONetworkAdapter::probe(PCI::DeviceIdentifier const& pci_device_identifier)
 {
@@ -115,9 +131,6 @@ UNMAP_AFTER_INIT VirtIONetworkAdapter::VirtIONetworkAdapter(StringView interface
 
 UNMAP_AFTER_INIT ErrorOr<void> VirtIONetworkAdapter::initialize(Badge<NetworkingManagement>)
 {
-    m_rx_buffers = TRY(Memory::RingBuffer::try_create("VirtIONetworkAdapter Rx buffer"sv, RX_BUFFER_SIZE * MAX_INFLIGHT_PACKETS));
-    m_tx_buffers = TRY(Memory::RingBuffer::try_create("VirtIONetworkAdapter Tx buffer"sv, RX_BUFFER_SIZE * MAX_INFLIGHT_PACKETS));
-
     return initialize_virtio_resources();
 }
 
@@ -137,27 +150,108 @@ UNMAP_AFTER_INIT ErrorOr<void> VirtIONetworkAdapter::initialize_virtio_resources
             negotiated |= VIRTIO_NET_F_SPEED_DUPLEX;
         if (is_feature_set(supported_features, VIRTIO_NET_F_MTU))
             negotiated |= VIRTIO_NET_F_MTU;
+        if (is_feature_set(supported_features, VIRTIO_NET_F_CSUM)) {
+            negotiated |= VIRTIO_NET_F_CSUM;
+            // The device can only segment packets whose checksums it also fills in.
+            if (is_feature_set(supported_features, VIRTIO_NET_F_HOST_TSO4))
+                negotiated |= VIRTIO_NET_F_HOST_TSO4;
+        }
+        if (is_feature_set(supported_features, VIRTIO_NET_F_GUEST_CSUM))
+            negotiated |= VIRTIO_NET_F_GUEST_CSUM;
+        // The number of queue pairs in use can only be changed through the control queue.
+        if (is_feature_set(supported_features, VIRTIO_NET_F_MQ) && is_feature_set(supported_features, VIRTIO_NET_F_CTRL_VQ))
+            negotiated |= VIRTIO_NET_F_MQ | VIRTIO_NET_F_CTRL_VQ;
         return negotiated;
     }));
 
     TRY(handle_device_config_change());
-    TRY(setup_queues(2)); // receive & transmit
+
+    auto offloads = Offload::None;
+    if (is_feature_accepted(VIRTIO_NET_F_CSUM))
+        offloads |= Offload::TransmitChecksum;
+    if (is_feature_accepted(VIRTIO_NET_F_HOST_TSO4))
+        offloads |= Offload::TCPSegmentation;
+    if (is_feature_accepted(VIRTIO_NET_F_GUEST_CSUM))
+        offloads |= Offload::ReceiveChecksum;
+    set_offloads(offloads);
+
+    u16 queue_pair_count = 1;
+    if (is_feature_accepted(VIRTIO_NET_F_MQ)) {
+        m_maximum_queue_pair_count = max<u16>(1, transport_entity().config_read16(*m_device_config, offsetof(VirtIONetConfig, max_virtqueue_pairs)));
+        queue_pair_count = min(m_maximum_queue_pair_count, min<u16>(Processor::count(), MAX_QUEUE_PAIRS));
+        m_control_buffer = TRY(MM.allocate_contiguous_kernel_region(PAGE_SIZE, "VirtIONetworkAdapter Control"sv, Memory::Region::Access::ReadWrite));
+        // All queues have to be set up for the control queue to be at the end, even the pairs we won't use.
+        TRY(setup_queues(2 * m_maximum_queue_pair_count + 1));
+        get_queue(control_queue_index()).disable_interrupts();
+    } else {
+        TRY(setup_queues(2)); // receive & transmit
+    }
+
+    m_rx_buffer_size = sizeof(VirtIONetHdr) + sizeof(EthernetFrameHeader) + mtu();
+    size_t tx_ring_size = m_rx_buffer_size * MAX_INFLIGHT_PACKETS;
+    if (has_offload(Offload::TCPSegmentation))
+        tx_ring_size = max(tx_ring_size, (sizeof(VirtIONetHdr) + MAX_TSO_FRAME_SIZE) * MAX_INFLIGHT_TSO_FRAMES);
+    TRY(m_queue_pairs.try_resize(queue_pair_count));
+    for (auto& pair : m_queue_pairs) {
+        pair.rx_buffers = TRY(Memory::RingBuffer::try_create("VirtIONetworkAdapter Rx buffer"sv, m_rx_buffer_size * MAX_INFLIGHT_PACKETS));
+        pair.tx_buffers = TRY(Memory::RingBuffer::try_create("VirtIONetworkAdapter Tx buffer"sv, tx_ring_size));
+    }
 
     finish_init();
 
-    {
-        // Supply receive buffers.
-        auto& rx_queue = get_queue(RECEIVEQ);
-        SpinlockLocker queue_lock(rx_queue.lock());
-        VirtIO::QueueChain chain(rx_queue);
-        while (m_rx_buffers->available_bytes() > RX_BUFFER_SIZE) {
-            // We know that the RingBuffer will not wraparound in this loop. But it's still awkward.
-            auto buffer_start = MUST(m_rx_buffers->reserve_space(RX_BUFFER_SIZE));
-            VERIFY(chain.add_buffer_to_chain(buffer_start, RX_BUFFER_SIZE, VirtIO::BufferType::DeviceWritable));
-            supply_chain_and_notify(RECEIVEQ, chain);
-        }
+    for (u16 pair = 0; pair < queue_pair_count; ++pair)
+        TRY(supply_receive_buffers(pair));
+
+    if (queue_pair_count > 1) {
+        if (auto result = set_active_queue_pair_count(queue_pair_count); result.is_error())
+            dmesgln("VirtIONetworkAdapter: Could not use {} queue pairs, using only one: {}", queue_pair_count, result.error());
     }
+    dbgln_if(VIRTIO_DEBUG, "VirtIONetworkAdapter: Using {} queue pairs", m_active_queue_pair_count);
+
+    return {};
+}
 
+UNMAP_AFTER_INIT ErrorOr<void> VirtIONetworkAdapter::supply_receive_buffers(u16 pair)
+{
+    auto& rx_buffers = *m_queue_pairs[pair].rx_buffers;
+    auto& rx_queue = get_queue(receive_queue_index(pair));
+    SpinlockLocker queue_lock(rx_queue.lock());
+    VirtIO::QueueChain chain(rx_queue);
+    while (rx_buffers.available_bytes() > m_rx_buffer_size) {
+        // We know that the RingBuffer will not wraparound in this loop. But it's still awkward.
+        auto buffer_start = TRY(rx_buffers.reserve_space(m_rx_buffer_size));
+        VERIFY(chain.add_buffer_to_chain(buffer_start, m_rx_buffer_size, VirtIO::BufferType::DeviceWritable));
+        supply_chain_and_notify(receive_queue_index(pair), chain);
+    }
+    return {};
+}
+
+UNMAP_AFTER_INIT ErrorOr<void> VirtIONetworkAdapter::set_active_queue_pair_count(u16 count)
+{
+    auto* command = reinterpret_cast<VirtIONetCtrlMQ*>(m_control_buffer->vaddr().as_ptr());
+    *command = { { VIRTIO_NET_CTRL_MQ, VIRTIO_NET_CTRL_MQ_VQ_PAIRS_SET }, count };
+    // The device writes its reply after the command, and it only goes into a buffer of its own.
+    auto* reply = m_control_buffer->vaddr().offset(sizeof(VirtIONetCtrlMQ)).as_ptr();
+    *reply = VIRTIO_NET_ERR;
+    auto command_address = m_control_buffer->physical_page(0)->paddr();
+
+    auto& queue = get_queue(control_queue_index());
+    SpinlockLocker queue_lock(queue.lock());
+    VirtIO::QueueChain chain(queue);
+    VERIFY(chain.add_buffer_to_chain(command_address, sizeof(VirtIONetCtrlMQ), VirtIO::BufferType::DeviceReadable));
+    VERIFY(chain.add_buffer_to_chain(command_address.offset(sizeof(VirtIONetCtrlMQ)), sizeof(*reply), VirtIO::BufferType::DeviceWritable));
+    supply_chain_and_notify(control_queue_index(), chain);
+
+    // Control commands are rare enough that we just wait for them to be done, with the queue's interrupts off.
+    while (!queue.new_data_available())
+        Processor::wait_check();
+    size_t used;
+    auto popped_chain = queue.pop_used_buffer_chain(used);
+    popped_chain.release_buffer_slots_to_queue();
+
+    if (*reply != VIRTIO_NET_OK)
+        return Error::from_errno(EIO);
+    m_active_queue_pair_count = count;
     return {};
 }
 
@@ -180,7 +274,9 @@ ErrorOr<void> VirtIONetworkAdapter::handle_device_config_change()
         }
         if (is_feature_accepted(VIRTIO_NET_F_MTU)) {
             u16 mtu = transport_entity().config_read16(*m_device_config, offsetof(VirtIONetConfig, mtu));
-            set_mtu(mtu);
+            // Our receive buffers are sized for the MTU we started out with.
+            if (m_rx_buffer_size == 0)
+                set_mtu(mtu);
         }
         if (is_feature_accepted(VIRTIO_NET_F_SPEED_DUPLEX)) {
             u32 speed = transport_entity().config_read32(*m_device_config, offsetof(VirtIONetConfig, speed));
@@ -196,41 +292,74 @@ void VirtIONetworkAdapter::handle_queue_update(u16 queue_index)
 {
     dbgln_if(VIRTIO_DEBUG, "VirtIONetworkAdapter: handle_queue_update {}", queue_index);
 
-    if (queue_index == RECEIVEQ) {
-        // FIXME: Disable interrupts while receiving as recommended by the spec.
-        auto& queue = get_queue(RECEIVEQ);
-        SpinlockLocker queue_lock(queue.lock());
-        size_t used;
-        VirtIO::QueueChain popped_chain = queue.pop_used_buffer_chain(used);
-
-        while (!popped_chain.is_empty()) {
-            VERIFY(popped_chain.length() == 1);
-            popped_chain.for_each([&](PhysicalAddress addr, size_t length) {
-                size_t offset = addr.as_ptr() - m_rx_buffers->start_of_region().as_ptr();
-                auto* message = reinterpret_cast<VirtIONetHdr*>(m_rx_buffers->vaddr().offset(offset).as_ptr());
-                did_receive({ message->frame, length - sizeof(VirtIONetHdr) });
-            });
-
-            supply_chain_and_notify(RECEIVEQ, popped_chain);
-            popped_chain = queue.pop_used_buffer_chain(used);
-        }
-    } else if (queue_index == TRANSMITQ) {
-        auto& queue = get_queue(TRANSMITQ);
-        SpinlockLocker queue_lock(queue.lock());
-        SpinlockLocker ringbuffer_lock(m_tx_buffers->lock());
-
-        size_t used;
-        VirtIO::QueueChain popped_chain = queue.pop_used_buffer_chain(used);
-        do {
-            popped_chain.for_each([this](PhysicalAddress address, size_t length) {
-                m_tx_buffers->reclaim_space(address, length);
-            });
-            popped_chain.release_buffer_slots_to_queue();
-            popped_chain = queue.pop_used_buffer_chain(used);
-        } while (!popped_chain.is_empty());
-    } else {
+    // We wait for control commands ourselves.
+    if (is_feature_accepted(VIRTIO_NET_F_CTRL_VQ) && queue_index == control_queue_index())
+        return;
+
+    u16 pair = queue_index / 2;
+    if (pair >= m_queue_pairs.size()) {
         dmesgln("VirtIONetworkAdapter: unexpected update for queue {}", queue_index);
+        return;
+    }
+    if (queue_index == receive_queue_index(pair))
+        receive_packets(pair);
+    else
+        reclaim_transmit_buffers(pair);
+}
+
+void VirtIONetworkAdapter::receive_packets(u16 pair)
+{
+    auto& queue = get_queue(receive_queue_index(pair));
+    auto& rx_buffers = *m_queue_pairs[pair].rx_buffers;
+
+    // As recommended by the spec, the device doesn't interrupt us again while we're taking packets off the queue.
+    // Everything we find is handed to the network stack as one batch.
+    queue.disable_interrupts();
+    for (;;) {
+        {
+            SpinlockLocker queue_lock(queue.lock());
+            size_t used;
+            VirtIO::QueueChain popped_chain = queue.pop_used_buffer_chain(used);
+
+            while (!popped_chain.is_empty()) {
+                VERIFY(popped_chain.length() == 1);
+                popped_chain.for_each([&](PhysicalAddress addr, size_t) {
+                    size_t offset = addr.as_ptr() - rx_buffers.start_of_region().as_ptr();
+                    auto* message = reinterpret_cast<VirtIONetHdr*>(rx_buffers.vaddr().offset(offset).as_ptr());
+                    // Packets with a partial checksum come from the same host, and were never on a wire to get corrupted on.
+                    bool checksum_is_verified = message->flags & (VIRTIO_NET_HDR_F_DATA_VALID | VIRTIO_NET_HDR_F_NEEDS_CSUM);
+                    queue_received_packet({ message->frame, used - sizeof(VirtIONetHdr) }, checksum_is_verified);
+                });
+
+                supply_chain_and_notify(receive_queue_index(pair), popped_chain);
+                popped_chain = queue.pop_used_buffer_chain(used);
+            }
+        }
+        queue.enable_interrupts();
+        // Packets that came in before interrupts were enabled again wouldn't get an interrupt of their own.
+        if (!queue.new_data_available())
+            break;
+        queue.disable_interrupts();
     }
+    did_queue_received_packets();
+}
+
+void VirtIONetworkAdapter::reclaim_transmit_buffers(u16 pair)
+{
+    auto& queue = get_queue(transmit_queue_index(pair));
+    auto& tx_buffers = *m_queue_pairs[pair].tx_buffers;
+    SpinlockLocker queue_lock(queue.lock());
+    SpinlockLocker ringbuffer_lock(tx_buffers.lock());
+
+    size_t used;
+    VirtIO::QueueChain popped_chain = queue.pop_used_buffer_chain(used);
+    do {
+        popped_chain.for_each([&](PhysicalAddress address, size_t length) {
+            tx_buffers.reclaim_space(address, length);
+        });
+        popped_chain.release_buffer_slots_to_queue();
+        popped_chain = queue.pop_used_buffer_chain(used);
+    } while (!popped_chain.is_empty());
 }
 
 static bool copy_data_to_chain(VirtIO::QueueChain& chain, Memory::RingBuffer& ring, u8 const* data, size_t length)
@@ -253,26 +382,46 @@ static bool copy_data_to_chain(VirtIO::QueueChain& chain, Memory::RingBuffer& ri
 }
 
 void VirtIONetworkAdapter::send_raw(ReadonlyBytes payload)
+{
+    send_raw_with_offload(payload, {});
+}
+
+void VirtIONetworkAdapter::send_raw_with_offload(ReadonlyBytes payload, TransmitOffload const& offload)
 {
     dbgln_if(VIRTIO_DEBUG, "VirtIONetworkAdapter: send_raw length={}", payload.size());
 
-    auto& queue = get_queue(TRANSMITQ);
+    VirtIONetHdr hdr {};
+    if (offload.needs_checksum()) {
+        hdr.flags = VIRTIO_NET_HDR_F_NEEDS_CSUM;
+        hdr.csum_start = offload.checksum_start;
+        hdr.csum_offset = offload.checksum_offset;
+    }
+    if (offload.segment_size != 0) {
+        auto& tcp_packet = *reinterpret_cast<TCPPacket const*>(payload.offset(offload.checksum_start));
+        hdr.gso_type = VIRTIO_NET_HDR_GSO_TCPV4;
+        hdr.gso_size = offload.segment_size;
+        hdr.hdr_len = offload.checksum_start + tcp_packet.header_size();
+    }
+
+    // Every CPU sends on a pair of its own, as long as there are enough of them.
+    u16 pair = Processor::current_id() % m_active_queue_pair_count;
+    auto& tx_buffers = *m_queue_pairs[pair].tx_buffers;
+    auto& queue = get_queue(transmit_queue_index(pair));
     SpinlockLocker queue_lock(queue.lock());
     VirtIO::QueueChain chain(queue);
 
-    SpinlockLocker ringbuffer_lock(m_tx_buffers->lock());
-    if (m_tx_buffers->available_bytes() < sizeof(VirtIONetHdr) + payload.size()) {
+    SpinlockLocker ringbuffer_lock(tx_buffers.lock());
+    if (tx_buffers.available_bytes() < sizeof(VirtIONetHdr) + payload.size()) {
         // We can drop packets that don't fit to apply back pressure on eager senders.
         dmesgln("VirtIONetworkAdapter: not enough space in the buffer. Dropping packet");
         return;
     }
 
     // FIXME: Handle errors from pushing to the chain and rewind the RingBuffer.
-    VirtIONetHdr hdr {};
-    VERIFY(copy_data_to_chain(chain, *m_tx_buffers, reinterpret_cast<u8*>(&hdr), sizeof(hdr)));
-    VERIFY(copy_data_to_chain(chain, *m_tx_buffers, payload.data(), payload.size()));
+    VERIFY(copy_data_to_chain(chain, tx_buffers, reinterpret_cast<u8*>(&hdr), sizeof(hdr)));
+    VERIFY(copy_data_to_chain(chain, tx_buffers, payload.data(), payload.size()));
 
-    supply_chain_and_notify(TRANSMITQ, chain);
+    supply_chain_and_notify(transmit_queue_index(pair), chain);
 }
 
 }
@@ -32,6 +32,7 @@ public:
     virtual bool link_up() override { return m_link_up; }
     virtual bool link_full_duplex() override { return m_link_duplex; }
     virtual i32 link_speed() override { return m_link_speed; }
+    virtual u16 queue_pair_count() const override { return m_active_queue_pair_count; }
 
 private:
     explicit VirtIONetworkAdapter(StringView interface_name, NonnullOwnPtr<VirtIO::TransportEntity>);
@@ -42,6 +43,17 @@ private:
 
     // NetworkAdapter
     virtual void send_raw(ReadonlyBytes) override;
+    virtual void send_raw_with_offload(ReadonlyBytes, TransmitOffload const&) override;
+
+    // Each pair has a receive and a transmit queue, at the indices 2 * pair and 2 * pair + 1.
+    static constexpr u16 receive_queue_index(u16 pair) { return 2 * pair; }
+    static constexpr u16 transmit_queue_index(u16 pair) { return 2 * pair + 1; }
+    u16 control_queue_index() const { return 2 * m_maximum_queue_pair_count; }
+
+    ErrorOr<void> supply_receive_buffers(u16 pair);
+    ErrorOr<void> set_active_queue_pair_count(u16);
+    void receive_packets(u16 pair);
+    void reclaim_transmit_buffers(u16 pair);
 
 private:
     VirtIO::Configuration const* m_device_config { nullptr };
@@ -52,8 +64,18 @@ private:
     i32 m_link_speed { LINKSPEED_INVALID };
     bool m_link_duplex { false };
 
-    OwnPtr<Memory::RingBuffer> m_rx_buffers;
-    OwnPtr<Memory::RingBuffer> m_tx_buffers;
+    struct QueuePair {
+        OwnPtr<Memory::RingBuffer> rx_buffers;
+        OwnPtr<Memory::RingBuffer> tx_buffers;
+    };
+    Vector<QueuePair> m_queue_pairs;
+    // The device only uses the first pair until we tell it to use more.
+    u16 m_active_queue_pair_count { 1 };
+    u16 m_maximum_queue_pair_count { 1 };
+    size_t m_rx_buffer_size { 0 };
+
+    // Holds control commands and their replies.
+    OwnPtr<Memory::Region> m_control_buffer;
 };
 
 }
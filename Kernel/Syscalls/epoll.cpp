@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/ScopeGuard.h>
+#include <Kernel/FileSystem/EventQueue.h>
+#include <Kernel/FileSystem/OpenFileDescription.h>
+#include <Kernel/Tasks/Process.h>
+
+namespace Kernel {
+
+// A single epoll_pwait() never returns more events than this, which bounds the kernel buffer it needs.
+static constexpr int maximum_events_per_wait = 1024;
+
+ErrorOr<FlatPtr> Process::sys$epoll_create1(int flags)
+{
+    VERIFY_NO_PROCESS_BIG_LOCK(this);
+    TRY(require_promise(Pledge::stdio));
+
+    if (flags & ~EPOLL_CLOEXEC)
+        return EINVAL;
+
+    auto event_queue = TRY(EventQueue::try_create());
+    auto description = TRY(OpenFileDescription::try_create(move(event_queue)));
+    description->set_readable(true);
+
+    return m_fds.with_exclusive([&](auto& fds) -> ErrorOr<FlatPtr> {
+        auto fd_allocation = TRY(fds.allocate());
+        fds[fd_allocation.fd].set(move(description));
+
+        if (flags & EPOLL_CLOEXEC)
+            fds[fd_allocation.fd].set_flags(fds[fd_allocation.fd].flags() | FD_CLOEXEC);
+
+        return fd_allocation.fd;
+    });
+}
+
+ErrorOr<FlatPtr> Process::sys$epoll_ctl(int epfd, int op, int fd, Userspace<epoll_event*> user_event)
+{
+    VERIFY_NO_PROCESS_BIG_LOCK(this);
+    TRY(require_promise(Pledge::stdio));
+
+    auto event_queue_description = TRY(open_file_description(epfd));
+    if (!event_queue_description->file().is_event_queue())
+        return EINVAL;
+    auto& event_queue = static_cast<EventQueue&>(event_queue_description->file());
+
+    auto description = TRY(open_file_description(fd));
+    if (description == event_queue_description)
+        return EINVAL;
+
+    switch (op) {
+    case EPOLL_CTL_ADD:
+        TRY(event_queue.add(fd, *description, TRY(copy_typed_from_user(user_event))));
+        return 0;
+    case EPOLL_CTL_MOD:
+        TRY(event_queue.modify(fd, *description, TRY(copy_typed_from_user(user_event))));
+        return 0;
+    case EPOLL_CTL_DEL:
+        TRY(event_queue.remove(fd, *description));
+        return 0;
+    default:
+        return EINVAL;
+    }
+}
+
+ErrorOr<FlatPtr> Process::sys$epoll_pwait(Userspace<Syscall::SC_epoll_pwait_params const*> user_params)
+{
+    VERIFY_NO_PROCESS_BIG_LOCK(this);
+    TRY(require_promise(Pledge::stdio));
+
+    auto params = TRY(copy_typed_from_user(user_params));
+    if (params.maxevents <= 0)
+        return EINVAL;
+
+    auto event_queue_description = TRY(open_file_description(params.epfd));
+    if (!event_queue_description->file().is_event_queue())
+        return EINVAL;
+    auto& event_queue = static_cast<EventQueue&>(event_queue_description->file());
+
+    Thread::BlockTimeout timeout;
+    if (params.timeout) {
+        auto timeout_time = TRY(copy_time_from_user(params.timeout));
+        timeout = Thread::BlockTimeout(false, &timeout_time);
+    }
+
+    sigset_t sigmask = {};
+    if (params.sigmask)
+        TRY(copy_from_user(&sigmask, params.sigmask));
+
+    Vector<epoll_event> events;
+    TRY(events.try_resize(min(params.maxevents, maximum_events_per_wait)));
+
+    auto* current_thread = Thread::current();
+
+    u32 previous_signal_mask = 0;
+    if (params.sigmask)
+        previous_signal_mask = current_thread->update_signal_mask(sigmask);
+    ScopeGuard rollback_signal_mask([&]() {
+        if (params.sigmask)
+            current_thread->update_signal_mask(previous_signal_mask);
+    });
+
+    auto count = TRY(event_queue.wait(events.span(), timeout));
+    if (count > 0)
+        TRY(copy_n_to_user(params.events, events.data(), count));
+    return count;
+}
+
+}
@@ -485,6 +485,12 @@ ErrorOr<void> Process::do_exec(NonnullRefPtr<OpenFileDescription> main_program_d
     auto last_part = path->view().find_last_split_view('/');
 
     auto allocated_space = TRY(Memory::AddressSpace::try_create(*this, nullptr));
+
+    // NOTE: I/O ring requests write to the current address space, so they have to be gone before we swap it out.
+    //       No new ones are taken until the other threads have been told to die. The cancelled ones stay cancelled
+    //       if the exec fails after this.
+    cancel_io_ring_requests_for_exec();
+
     OwnPtr<Memory::AddressSpace> old_space;
     auto old_master_tls_region = m_master_tls_region;
     auto old_master_tls_size = m_master_tls_size;
@@ -506,6 +512,7 @@ ErrorOr<void> Process::do_exec(NonnullRefPtr<OpenFileDescription> main_program_d
         m_master_tls_size = old_master_tls_size;
         m_master_tls_alignment = old_master_tls_alignment;
         Memory::MemoryManager::enter_process_address_space(*this);
+        resume_io_ring_requests_after_exec();
     });
 
     auto load_result = TRY(load(new_space, main_program_description, interpreter_description, main_program_header, minimum_stack_size));
@@ -574,6 +581,7 @@ ErrorOr<void> Process::do_exec(NonnullRefPtr<OpenFileDescription> main_program_d
     TemporaryChange profiling_disabler(m_profiling, false);
 
     kill_threads_except_self();
+    resume_io_ring_requests_after_exec();
 
     with_mutable_protected_data([&](auto& protected_data) {
         protected_data.credentials = move(new_credentials);
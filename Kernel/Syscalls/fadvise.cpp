@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <Kernel/FileSystem/Inode.h>
+#include <Kernel/FileSystem/InodeFile.h>
+#include <Kernel/FileSystem/OpenFileDescription.h>
+#include <Kernel/Tasks/Process.h>
+
+namespace Kernel {
+
+// POSIX_FADV_WILLNEED reads the hinted range into the cache in the background, but never more than this at once.
+static constexpr size_t maximum_will_need_size = 8 * MiB;
+
+// https://pubs.opengroup.org/onlinepubs/9699919799/functions/posix_fadvise.html
+ErrorOr<FlatPtr> Process::sys$posix_fadvise(int fd, off_t offset, off_t length, int advice)
+{
+    VERIFY_NO_PROCESS_BIG_LOCK(this);
+    TRY(require_promise(Pledge::stdio));
+
+    // [EINVAL] The value of advice is invalid, or the value of len is less than zero.
+    if (length < 0 || offset < 0)
+        return EINVAL;
+
+    auto description = TRY(open_file_description(fd));
+
+    // [ESPIPE] The fd argument is associated with a pipe or FIFO.
+    if (description->is_fifo())
+        return ESPIPE;
+
+    switch (advice) {
+    case POSIX_FADV_NORMAL:
+        description->set_access_pattern(AccessPattern::Normal);
+        return 0;
+    case POSIX_FADV_SEQUENTIAL:
+        description->set_access_pattern(AccessPattern::Sequential);
+        return 0;
+    case POSIX_FADV_RANDOM:
+        description->set_access_pattern(AccessPattern::Random);
+        return 0;
+    case POSIX_FADV_WILLNEED: {
+        if (!description->file().is_inode() || description->is_direct())
+            return 0;
+        auto& inode = static_cast<InodeFile&>(description->file()).inode();
+        // NOTE: A length of zero means "until the end of the file".
+        auto size = length == 0 ? maximum_will_need_size : min(static_cast<size_t>(length), maximum_will_need_size);
+        inode.queue_read_ahead(offset, size);
+        return 0;
+    }
+    case POSIX_FADV_DONTNEED: {
+        if (!description->file().is_inode())
+            return 0;
+        auto& inode = static_cast<InodeFile&>(description->file()).inode();
+        // NOTE: A length of zero means "until the end of the file".
+        auto size = length == 0 ? NumericLimits<size_t>::max() : static_cast<size_t>(length);
+        inode.drop_cached_range(offset, size);
+        return 0;
+    }
+    case POSIX_FADV_NOREUSE:
+        // There is no single-use caching mode to switch to, so there's nothing to do here.
+        return 0;
+    default:
+        return EINVAL;
+    }
+}
+
+}
@@ -53,7 +53,7 @@ ErrorOr<FlatPtr> Process::sys$posix_fallocate(int fd, off_t offset, off_t length
     // Note: truncate essentially calls resize in the inodes implementation
     //       while resize is not a standard member of an inode, so we just call
     //       truncate instead
-    TRY(file.inode().truncate(checked_size.value()));
+    TRY(file.inode().resize_contents(checked_size.value()));
 
     // FIXME: EINTR: A signal was caught during execution.
     return 0;
@@ -5,6 +5,7 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/ScopeGuard.h>
 #include <Kernel/Debug.h>
 #include <Kernel/Devices/TTY/TTY.h>
 #include <Kernel/FileSystem/Custody.h>
@@ -161,10 +162,22 @@ ErrorOr<FlatPtr> Process::sys$fork(RegisterState& regs)
     TRY(address_space().with([&](auto& parent_space) {
         return child->address_space().with([&](auto& child_space) -> ErrorOr<void> {
             child_space->set_enforces_syscall_regions(parent_space->enforces_syscall_regions());
+
             for (auto& region : parent_space->region_tree().regions()) {
                 dbgln_if(FORK_DEBUG, "fork: cloning Region '{}' @ {}", region.name(), region.vaddr());
                 auto region_clone = TRY(region.try_clone());
-                TRY(region_clone->map(child_space->page_directory(), Memory::ShouldFlushTLB::No));
+                // Cloning a writable region makes the parent's mappings of it read-only. Flush them right away, so our
+                // other threads can't keep writing through stale TLB entries into pages the child now shares with us.
+                if (!region.is_shared() && region.is_writable())
+                    Processor::flush_tlb(&parent_space->page_directory(), region.vaddr(), region.page_count());
+
+                // The child's page tables are filled in on demand, by page faults. Those can only do that for memory
+                // that lives in a VMObject; anything else has to be mapped right away.
+                if (region_clone->vmobject().is_anonymous() || region_clone->vmobject().is_inode())
+                    region_clone->set_page_directory(child_space->page_directory());
+                else
+                    TRY(region_clone->map(child_space->page_directory(), Memory::ShouldFlushTLB::No));
+
                 TRY(child_space->region_tree().place_specifically(*region_clone, region.range()));
                 auto* child_region = region_clone.leak_ptr();
 
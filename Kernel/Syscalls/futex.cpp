@@ -5,6 +5,7 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/Array.h>
 #include <AK/Singleton.h>
 #include <Kernel/Debug.h>
 #include <Kernel/Memory/InodeVMObject.h>
@@ -13,23 +14,34 @@
 
 namespace Kernel {
 
-static Singleton<SpinlockProtected<HashMap<GlobalFutexKey, NonnullLockRefPtr<FutexQueue>>, LockRank::None>> s_global_futex_queues;
+// Futex queues are spread over a fixed number of buckets by the hash of their key, each with its own lock,
+// so that threads using unrelated futexes don't all serialize on a single global lock.
+static constexpr size_t futex_bucket_count = 256;
+using FutexBucket = SpinlockProtected<HashMap<GlobalFutexKey, NonnullLockRefPtr<FutexQueue>>, LockRank::None>;
+static Singleton<Array<FutexBucket, futex_bucket_count>> s_futex_buckets;
+
+static FutexBucket& futex_bucket_for(GlobalFutexKey const& futex_key)
+{
+    return (*s_futex_buckets)[Traits<GlobalFutexKey>::hash(futex_key) % futex_bucket_count];
+}
 
 void Process::clear_futex_queues_on_exec()
 {
-    s_global_futex_queues->with([this](auto& queues) {
-        auto const* address_space = this->address_space().with([](auto& space) { return space.ptr(); });
-        queues.remove_all_matching([address_space](auto& futex_key, auto& futex_queue) {
-            if ((futex_key.raw.offset & futex_key_private_flag) == 0)
-                return false;
-            if (futex_key.private_.address_space != address_space)
-                return false;
-            bool did_wake_all;
-            futex_queue->wake_all(did_wake_all);
-            VERIFY(did_wake_all); // No one should be left behind...
-            return true;
+    auto const* address_space = this->address_space().with([](auto& space) { return space.ptr(); });
+    for (auto& bucket : *s_futex_buckets) {
+        bucket.with([address_space](auto& queues) {
+            queues.remove_all_matching([address_space](auto& futex_key, auto& futex_queue) {
+                if ((futex_key.raw.offset & futex_key_private_flag) == 0)
+                    return false;
+                if (futex_key.private_.address_space != address_space)
+                    return false;
+                bool did_wake_all;
+                futex_queue->wake_all(did_wake_all);
+                VERIFY(did_wake_all); // No one should be left behind...
+                return true;
+            });
         });
-    });
+    }
 }
 
 ErrorOr<GlobalFutexKey> Process::get_futex_key(FlatPtr user_address, bool shared)
@@ -90,7 +102,7 @@ ErrorOr<GlobalFutexKey> Process::get_futex_key(FlatPtr user_address, bool shared
 
 ErrorOr<FlatPtr> Process::sys$futex(Userspace<Syscall::SC_futex_params const*> user_params)
 {
-    VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this);
+    VERIFY_NO_PROCESS_BIG_LOCK(this);
     auto params = TRY(copy_typed_from_user(user_params));
 
     Thread::BlockTimeout timeout;
@@ -126,7 +138,7 @@ ErrorOr<FlatPtr> Process::sys$futex(Userspace<Syscall::SC_futex_params const*> u
 
     auto find_futex_queue = [&](GlobalFutexKey futex_key, bool create_if_not_found, bool* did_create = nullptr) -> ErrorOr<LockRefPtr<FutexQueue>> {
         VERIFY(!create_if_not_found || did_create != nullptr);
-        return s_global_futex_queues->with([&](auto& queues) -> ErrorOr<LockRefPtr<FutexQueue>> {
+        return futex_bucket_for(futex_key).with([&](auto& queues) -> ErrorOr<LockRefPtr<FutexQueue>> {
             auto it = queues.find(futex_key);
             if (it != queues.end())
                 return it->value;
@@ -141,7 +153,7 @@ ErrorOr<FlatPtr> Process::sys$futex(Userspace<Syscall::SC_futex_params const*> u
     };
 
     auto remove_futex_queue = [&](GlobalFutexKey futex_key) {
-        return s_global_futex_queues->with([&](auto& queues) {
+        return futex_bucket_for(futex_key).with([&](auto& queues) {
             auto it = queues.find(futex_key);
             if (it == queues.end())
                 return;
@@ -170,30 +182,42 @@ ErrorOr<FlatPtr> Process::sys$futex(Userspace<Syscall::SC_futex_params const*> u
     auto user_address2 = FlatPtr(params.userspace_address2);
 
     auto do_wait = [&](u32 bitset) -> ErrorOr<FlatPtr> {
-        bool did_create;
         LockRefPtr<FutexQueue> futex_queue;
+        u32 imminent_wake_generation = 0;
         auto futex_key = TRY(get_futex_key(user_address, shared));
-        do {
-            auto user_value = user_atomic_load_relaxed(params.userspace_address);
-            if (!user_value.has_value())
-                return EFAULT;
-            if (user_value.value() != params.val) {
-                dbgln_if(FUTEX_DEBUG, "futex wait: EAGAIN. user value: {:p} @ {:p} != val: {}", user_value.value(), params.userspace_address, params.val);
-                return EAGAIN;
-            }
-            atomic_thread_fence(AK::MemoryOrder::memory_order_acquire);
-
-            did_create = false;
+        for (;;) {
+            bool did_create = false;
             futex_queue = TRY(find_futex_queue(futex_key, true, &did_create));
             VERIFY(futex_queue);
-            // We need to try again if we didn't create this queue and the existing queue
-            // was removed before we were able to queue an imminent wait.
-        } while (!did_create && !futex_queue->queue_imminent_wait());
+            // A queue we create already counts us as an imminent waiter.
+            if (did_create)
+                break;
+            // We need to try again if the existing queue was removed before we were able to queue an imminent wait.
+            if (auto generation = futex_queue->queue_imminent_wait(); generation.has_value()) {
+                imminent_wake_generation = generation.value();
+                break;
+            }
+        }
+
+        // The value has to be checked only once we are counted as an imminent waiter: a wake that comes after
+        // the queue's lock was dropped will stop us from blocking, and the change that a wake before it published
+        // is visible to us now.
+        auto user_value = user_atomic_load_relaxed(params.userspace_address);
+        if (!user_value.has_value() || user_value.value() != params.val) {
+            futex_queue->cancel_imminent_wait();
+            if (futex_queue->is_empty_and_no_imminent_waits())
+                remove_futex_queue(futex_key);
+            if (!user_value.has_value())
+                return EFAULT;
+            dbgln_if(FUTEX_DEBUG, "futex wait: EAGAIN. user value: {:p} @ {:p} != val: {}", user_value.value(), params.userspace_address, params.val);
+            return EAGAIN;
+        }
+        atomic_thread_fence(AK::MemoryOrder::memory_order_acquire);
 
         // We must not hold the lock before blocking. But we have a reference
         // to the FutexQueue so that we can keep it alive.
 
-        Thread::BlockResult block_result = futex_queue->wait_on(timeout, bitset);
+        Thread::BlockResult block_result = futex_queue->wait_on(timeout, bitset, imminent_wake_generation);
 
         if (futex_queue->is_empty_and_no_imminent_waits()) {
             // If there are no more waiters, we want to get rid of the futex!
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <Kernel/FileSystem/IORing.h>
+#include <Kernel/FileSystem/OpenFileDescription.h>
+#include <Kernel/Tasks/Process.h>
+
+namespace Kernel {
+
+ErrorOr<FlatPtr> Process::sys$io_ring_setup(u32 entries, Userspace<IORingParameters*> user_parameters)
+{
+    VERIFY_NO_PROCESS_BIG_LOCK(this);
+    TRY(require_promise(Pledge::stdio));
+
+    auto ring = TRY(IORing::try_create(*this, entries));
+    auto parameters = ring->parameters();
+    auto description = TRY(OpenFileDescription::try_create(move(ring)));
+    description->set_readable(true);
+    description->set_writable(true);
+
+    return m_fds.with_exclusive([&](auto& fds) -> ErrorOr<FlatPtr> {
+        auto fd_allocation = TRY(fds.allocate());
+        TRY(copy_to_user(user_parameters, &parameters));
+        // NOTE: Requests refer to memory of this process, which is gone after an exec.
+        fds[fd_allocation.fd].set(move(description), FD_CLOEXEC);
+        return fd_allocation.fd;
+    });
+}
+
+void Process::cancel_io_ring_requests_for_exec()
+{
+    m_exec_generation++;
+
+    // NOTE: Waiting for the requests that are being done may take a while, so we don't do it with the table locked.
+    //       If we can't keep track of a ring here, its requests still find out about the exec before they start.
+    Vector<NonnullRefPtr<IORing>, 4> rings;
+    m_fds.with_exclusive([&](auto& fds) {
+        for (size_t fd = 0; fd < fds.max_open(); ++fd) {
+            auto* file_description_metadata = fds.get_if_valid(fd);
+            if (!file_description_metadata || !file_description_metadata->description()->file().is_io_ring())
+                continue;
+            auto& ring = static_cast<IORing&>(file_description_metadata->description()->file());
+            if (ring.is_owned_by(*this))
+                (void)rings.try_append(ring);
+        }
+    });
+    for (auto& ring : rings)
+        ring->cancel_requests_for_exec();
+}
+
+void Process::resume_io_ring_requests_after_exec()
+{
+    m_exec_generation++;
+}
+
+ErrorOr<FlatPtr> Process::sys$io_ring_enter(int fd, u32 to_submit, u32 minimum_completions)
+{
+    VERIFY_NO_PROCESS_BIG_LOCK(this);
+    TRY(require_promise(Pledge::stdio));
+
+    auto description = TRY(open_file_description(fd));
+    if (!description->file().is_io_ring())
+        return EINVAL;
+    auto& ring = static_cast<IORing&>(description->file());
+    return ring.enter(*this, to_submit, minimum_completions);
+}
+
+}
@@ -172,6 +172,7 @@ ErrorOr<FlatPtr> Process::sys$mmap(Userspace<Syscall::SC_mmap_params const*> use
     bool map_noreserve = flags & MAP_NORESERVE;
     bool map_randomized = flags & MAP_RANDOMIZED;
     bool map_fixed_noreplace = flags & MAP_FIXED_NOREPLACE;
+    bool map_hugetlb = flags & MAP_HUGETLB;
 
     if (map_shared && map_private)
         return EINVAL;
@@ -187,6 +188,13 @@ ErrorOr<FlatPtr> Process::sys$mmap(Userspace<Syscall::SC_mmap_params const*> use
     if (map_stack && (!map_private || !map_anonymous))
         return EINVAL;
 
+    if (map_hugetlb && (!map_anonymous || map_stack || (flags & MAP_PURGEABLE)))
+        return EINVAL;
+
+    // Large anonymous mappings start on a large page boundary, so that they can be mapped with large pages.
+    if (map_anonymous && !map_stack && rounded_size >= Memory::large_page_size)
+        alignment = max(alignment, Memory::large_page_size);
+
     Memory::VirtualRange requested_range { VirtualAddress { addr }, rounded_size };
     if (addr && !(map_fixed || map_fixed_noreplace)) {
         // If there's an address but MAP_FIXED wasn't specified, the address is just a hint.
@@ -204,6 +212,8 @@ ErrorOr<FlatPtr> Process::sys$mmap(Userspace<Syscall::SC_mmap_params const*> use
 
         if (flags & MAP_PURGEABLE) {
             vmobject = TRY(Memory::AnonymousVMObject::try_create_purgeable_with_size(rounded_size, strategy));
+        } else if (map_hugetlb) {
+            vmobject = TRY(Memory::AnonymousVMObject::try_create_with_large_pages(rounded_size));
         } else {
             vmobject = TRY(Memory::AnonymousVMObject::try_create_with_size(rounded_size, strategy));
         }
@@ -435,7 +445,35 @@ ErrorOr<FlatPtr> Process::sys$madvise(Userspace<void*> address, size_t size, int
             TRY(vmobject.set_volatile(advice == MADV_SET_VOLATILE, was_purged));
             return was_purged ? 1 : 0;
         }
-        return EINVAL;
+        if (advice == MADV_MERGEABLE || advice == MADV_UNMERGEABLE) {
+            if (!region->vmobject().is_anonymous() || region->is_shared())
+                return EINVAL;
+            auto& vmobject = static_cast<Memory::AnonymousVMObject&>(region->vmobject());
+            if (vmobject.is_purgeable())
+                return EINVAL;
+            vmobject.set_mergeable(advice == MADV_MERGEABLE);
+            return 0;
+        }
+        switch (advice) {
+        case MADV_NORMAL:
+            region->set_access_pattern(AccessPattern::Normal);
+            return 0;
+        case MADV_SEQUENTIAL:
+            region->set_access_pattern(AccessPattern::Sequential);
+            return 0;
+        case MADV_RANDOM:
+            region->set_access_pattern(AccessPattern::Random);
+            return 0;
+        case MADV_WILLNEED:
+            if (region->vmobject().is_inode()) {
+                auto& inode = static_cast<Memory::InodeVMObject&>(region->vmobject()).inode();
+                auto offset_in_file = region->offset_in_vmobject() + (range_to_madvise.base().get() - region->vaddr().get());
+                inode.queue_read_ahead(offset_in_file, range_to_madvise.size());
+            }
+            return 0;
+        default:
+            return EINVAL;
+        }
     });
 }
 
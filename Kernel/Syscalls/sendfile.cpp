@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <Kernel/FileSystem/OpenFileDescription.h>
+#include <Kernel/Library/KBuffer.h>
+#include <Kernel/Tasks/Process.h>
+
+namespace Kernel {
+
+using BlockFlags = Thread::FileBlocker::BlockFlags;
+
+// Data is moved through a kernel buffer of (at most) this size, which saves copying it out to userspace and back.
+static constexpr size_t transfer_buffer_size = 64 * KiB;
+
+// Like Linux, we move at most this much per call and let the caller come back for the rest. This keeps a single call
+// from holding on to the process for too long, and the result always fits in the return value.
+static constexpr size_t maximum_transfer_size_per_call = 1 * MiB;
+
+static ErrorOr<void> wait_until_readable(OpenFileDescription& description)
+{
+    if (description.can_read())
+        return {};
+    auto unblock_flags = BlockFlags::None;
+    if (Thread::current()->block<Thread::ReadBlocker>({}, description, unblock_flags).was_interrupted())
+        return EINTR;
+    if (!has_flag(unblock_flags, BlockFlags::Read))
+        return EAGAIN;
+    return {};
+}
+
+ErrorOr<FlatPtr> Process::transfer(OpenFileDescription& source, Optional<off_t>& source_offset, OpenFileDescription& destination, Optional<off_t>& destination_offset, size_t count, ShouldBlock should_block)
+{
+    if (count == 0)
+        return 0;
+    count = min(count, maximum_transfer_size_per_call);
+
+    bool may_block = should_block == ShouldBlock::Yes;
+    if (!may_block && !destination.can_write())
+        return EAGAIN;
+
+    auto buffer = TRY(KBuffer::try_create_with_size("Transfer buffer"sv, min(count, transfer_buffer_size), Memory::Region::Access::ReadWrite, AllocationStrategy::AllocateNow));
+    auto kernel_buffer = UserOrKernelBuffer::for_kernel_buffer(buffer->data());
+
+    // Data that we can't read again must not be lost if the destination only takes part of it.
+    bool source_is_seekable = source.file().is_seekable();
+
+    size_t total_transferred = 0;
+    while (total_transferred < count) {
+        // Like read(), we only wait for data to become available before transferring anything at all.
+        if (total_transferred == 0 && may_block && source.is_blocking()) {
+            TRY(wait_until_readable(source));
+        } else if (!source.can_read()) {
+            if (total_transferred > 0)
+                break;
+            return EAGAIN;
+        }
+
+        auto chunk_size = min(count - total_transferred, buffer->size());
+        auto nread_or_error = source_offset.has_value()
+            ? source.read(kernel_buffer, source_offset.value(), chunk_size)
+            : source.read(kernel_buffer, chunk_size);
+        if (nread_or_error.is_error()) {
+            if (total_transferred > 0)
+                break;
+            return nread_or_error.release_error();
+        }
+        auto nread = nread_or_error.release_value();
+        if (nread == 0)
+            break;
+
+        size_t nwritten = 0;
+        while (nwritten < nread) {
+            Optional<off_t> write_offset;
+            if (destination_offset.has_value())
+                write_offset = destination_offset.value() + nwritten;
+            auto result = do_write(destination, kernel_buffer.offset(nwritten), nread - nwritten, write_offset);
+            if (!result.is_error()) {
+                nwritten += result.value();
+                if (nwritten == nread || source_is_seekable)
+                    break;
+            } else if (result.error().code() != EAGAIN || source_is_seekable) {
+                if (nwritten == 0 && total_transferred == 0) {
+                    if (!source_offset.has_value() && source_is_seekable)
+                        TRY(source.seek(-static_cast<off_t>(nread), SEEK_CUR));
+                    return result.release_error();
+                }
+                break;
+            }
+
+            // A non-blocking destination took only part of what we consumed from a pipe or socket, and there is
+            // no way to put the rest back, so we have to wait until it has room.
+            auto unblock_flags = BlockFlags::None;
+            if (Thread::current()->block<Thread::WriteBlocker>({}, destination, unblock_flags).was_interrupted())
+                break;
+        }
+
+        if (source_offset.has_value())
+            source_offset.value() += nwritten;
+        else if (nwritten < nread && source_is_seekable)
+            TRY(source.seek(-static_cast<off_t>(nread - nwritten), SEEK_CUR));
+        if (destination_offset.has_value())
+            destination_offset.value() += nwritten;
+        total_transferred += nwritten;
+
+        if (nwritten < nread)
+            break;
+    }
+    return total_transferred;
+}
+
+static ErrorOr<NonnullRefPtr<OpenFileDescription>> open_transfer_source(Process& process, int fd)
+{
+    auto description = TRY(process.open_file_description(fd));
+    if (!description->is_readable())
+        return EBADF;
+    if (description->is_directory())
+        return EISDIR;
+    return description;
+}
+
+static ErrorOr<NonnullRefPtr<OpenFileDescription>> open_transfer_destination(Process& process, int fd)
+{
+    auto description = TRY(process.open_file_description(fd));
+    if (!description->is_writable())
+        return EBADF;
+    return description;
+}
+
+ErrorOr<FlatPtr> Process::sys$sendfile(int out_fd, int in_fd, Userspace<off_t*> user_offset, size_t count)
+{
+    VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this);
+    TRY(require_promise(Pledge::stdio));
+
+    auto source = TRY(open_transfer_source(*this, in_fd));
+    auto destination = TRY(open_transfer_destination(*this, out_fd));
+
+    Optional<off_t> offset;
+    if (user_offset) {
+        offset = TRY(copy_typed_from_user(user_offset));
+        if (offset.value() < 0)
+            return EINVAL;
+        if (!source->file().is_seekable())
+            return ESPIPE;
+    }
+
+    Optional<off_t> no_offset;
+    auto ntransferred = TRY(transfer(*source, offset, *destination, no_offset, count, ShouldBlock::Yes));
+    if (user_offset)
+        TRY(copy_to_user(user_offset, &offset.value()));
+    return ntransferred;
+}
+
+ErrorOr<FlatPtr> Process::sys$splice(Userspace<Syscall::SC_splice_params const*> user_params)
+{
+    VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this);
+    TRY(require_promise(Pledge::stdio));
+    auto params = TRY(copy_typed_from_user(user_params));
+    if (params.flags & ~(SPLICE_F_MOVE | SPLICE_F_NONBLOCK | SPLICE_F_MORE | SPLICE_F_GIFT))
+        return EINVAL;
+
+    auto source = TRY(open_transfer_source(*this, params.fd_in));
+    auto destination = TRY(open_transfer_destination(*this, params.fd_out));
+
+    // NOTE: Like on Linux, one end has to be a pipe.
+    if (!source->is_fifo() && !destination->is_fifo())
+        return EINVAL;
+    if (source == destination)
+        return EINVAL;
+
+    auto copy_offset_from_user = [&](off_t* user_offset, OpenFileDescription& description) -> ErrorOr<Optional<off_t>> {
+        if (!user_offset)
+            return Optional<off_t> {};
+        if (description.is_fifo() || !description.file().is_seekable())
+            return ESPIPE;
+        off_t offset;
+        TRY(copy_from_user(&offset, user_offset));
+        if (offset < 0)
+            return EINVAL;
+        return Optional<off_t> { offset };
+    };
+    auto source_offset = TRY(copy_offset_from_user(params.off_in, *source));
+    auto destination_offset = TRY(copy_offset_from_user(params.off_out, *destination));
+
+    auto should_block = (params.flags & SPLICE_F_NONBLOCK) ? ShouldBlock::No : ShouldBlock::Yes;
+    auto ntransferred = TRY(transfer(*source, source_offset, *destination, destination_offset, params.length, should_block));
+    if (params.off_in)
+        TRY(copy_to_user(params.off_in, &source_offset.value()));
+    if (params.off_out)
+        TRY(copy_to_user(params.off_out, &destination_offset.value()));
+    return ntransferred;
+}
+
+}
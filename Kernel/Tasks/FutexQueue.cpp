@@ -25,6 +25,10 @@ bool FutexQueue::should_add_blocker(Thread::Blocker& b, void*)
         dbgln_if(FUTEXQUEUE_DEBUG, "FutexQueue @ {}: should not block thread {}: was removed", this, b.thread());
         return false;
     }
+    if (static_cast<Thread::FutexBlocker&>(b).imminent_wake_generation() != m_imminent_wake_generation) {
+        dbgln_if(FUTEXQUEUE_DEBUG, "FutexQueue @ {}: should not block thread {}: was woken before blocking", this, b.thread());
+        return false;
+    }
     dbgln_if(FUTEXQUEUE_DEBUG, "FutexQueue @ {}: should block thread {}", this, b.thread());
 
     return true;
@@ -51,6 +55,9 @@ ErrorOr<u32> FutexQueue::wake_n_requeue(u32 wake_count, Function<ErrorOr<FutexQu
         }
         return false;
     });
+    // Threads that are about to wait would miss both the wake and the requeue, so they are woken in any case.
+    if (did_wake < wake_count || requeue_count > 0)
+        did_wake += wake_imminent_waits_locked();
     is_empty = is_empty_and_no_imminent_waits_locked();
     if (requeue_count > 0) {
         auto blockers_to_requeue = do_take_blockers(requeue_count);
@@ -109,6 +116,8 @@ u32 FutexQueue::wake_n(u32 wake_count, Optional<u32> const& bitset, bool& is_emp
         }
         return false;
     });
+    if (did_wake < wake_count)
+        did_wake += min(wake_count - did_wake, wake_imminent_waits_locked());
     is_empty = is_empty_and_no_imminent_waits_locked();
     return did_wake;
 }
@@ -128,6 +137,7 @@ u32 FutexQueue::wake_all(bool& is_empty)
         }
         return false;
     });
+    did_wake += wake_imminent_waits_locked();
     is_empty = is_empty_and_no_imminent_waits_locked();
     return did_wake;
 }
@@ -137,13 +147,32 @@ bool FutexQueue::is_empty_and_no_imminent_waits_locked()
     return m_imminent_waits == 0 && is_empty_locked();
 }
 
-bool FutexQueue::queue_imminent_wait()
+// Threads that have checked the futex value but haven't blocked yet can't be unblocked, so they are told not to
+// block at all instead. They may not all wait for this wake (e.g. because of their bitset), but they have to cope
+// with spurious wakeups anyway.
+u32 FutexQueue::wake_imminent_waits_locked()
+{
+    VERIFY(m_lock.is_locked());
+    if (m_imminent_waits == 0)
+        return 0;
+    m_imminent_wake_generation++;
+    return m_imminent_waits;
+}
+
+Optional<u32> FutexQueue::queue_imminent_wait()
 {
     SpinlockLocker lock(m_lock);
     if (m_was_removed)
-        return false;
+        return {};
     m_imminent_waits++;
-    return true;
+    return m_imminent_wake_generation;
+}
+
+void FutexQueue::cancel_imminent_wait()
+{
+    SpinlockLocker lock(m_lock);
+    VERIFY(m_imminent_waits > 0);
+    m_imminent_waits--;
 }
 
 bool FutexQueue::try_remove()
@@ -29,7 +29,9 @@ public:
         return Thread::current()->block<Thread::FutexBlocker>(timeout, *this, forward<Args>(args)...);
     }
 
-    bool queue_imminent_wait();
+    // Returns the wake generation that the wait has to be started with, or nothing if the queue was removed.
+    Optional<u32> queue_imminent_wait();
+    void cancel_imminent_wait();
     bool try_remove();
 
     bool is_empty_and_no_imminent_waits()
@@ -43,7 +45,11 @@ protected:
     virtual bool should_add_blocker(Thread::Blocker& b, void*) override;
 
 private:
+    u32 wake_imminent_waits_locked();
+
     size_t m_imminent_waits { 1 }; // We only create this object if we're going to be waiting, so start out with 1
+    // Bumped by every wake that finds threads that are about to wait but aren't blocked yet, so that they don't block.
+    u32 m_imminent_wake_generation { 0 };
     bool m_was_removed { false };
 };
 
@@ -15,6 +15,7 @@
 #include <AK/RefPtr.h>
 #include <AK/Userspace.h>
 #include <AK/Variant.h>
+#include <Kernel/API/IORing.h>
 #include <Kernel/API/POSIX/select.h>
 #include <Kernel/API/POSIX/sys/resource.h>
 #include <Kernel/API/Syscall.h>
@@ -229,6 +230,10 @@ public:
     bool is_dead() const { return m_state.load(AK::MemoryOrder::memory_order_acquire) == State::Dead; }
 
     bool is_stopped() const { return m_is_stopped; }
+
+    // Counts the programs this process has run, so work on behalf of an earlier one can tell it's too late.
+    // It's odd while an exec is replacing the program.
+    u32 exec_generation() const { return m_exec_generation.load(AK::MemoryOrder::memory_order_acquire); }
     bool set_stopped(bool stopped) { return m_is_stopped.exchange(stopped); }
 
     bool is_kernel_process() const { return m_is_kernel_process; }
@@ -310,6 +315,11 @@ public:
     void tracer_trap(Thread&, RegisterState const&);
 
     ErrorOr<FlatPtr> sys$emuctl();
+    ErrorOr<FlatPtr> sys$epoll_create1(int flags);
+    ErrorOr<FlatPtr> sys$epoll_ctl(int epfd, int op, int fd, Userspace<epoll_event*>);
+    ErrorOr<FlatPtr> sys$epoll_pwait(Userspace<Syscall::SC_epoll_pwait_params const*>);
+    ErrorOr<FlatPtr> sys$io_ring_setup(u32 entries, Userspace<IORingParameters*>);
+    ErrorOr<FlatPtr> sys$io_ring_enter(int fd, u32 to_submit, u32 minimum_completions);
     ErrorOr<FlatPtr> sys$yield();
     ErrorOr<FlatPtr> sys$sync();
     ErrorOr<FlatPtr> sys$beep(int tone);
@@ -347,6 +357,7 @@ public:
     ErrorOr<FlatPtr> sys$lseek(int fd, Userspace<off_t*>, int whence);
     ErrorOr<FlatPtr> sys$ftruncate(int fd, off_t);
     ErrorOr<FlatPtr> sys$futimens(Userspace<Syscall::SC_futimens_params const*>);
+    ErrorOr<FlatPtr> sys$posix_fadvise(int fd, off_t, off_t, int advice);
     ErrorOr<FlatPtr> sys$posix_fallocate(int fd, off_t, off_t);
     ErrorOr<FlatPtr> sys$kill(pid_t pid_or_pgid, int sig);
     [[noreturn]] void sys$exit(int status);
@@ -453,6 +464,8 @@ public:
     ErrorOr<FlatPtr> sys$get_stack_bounds(Userspace<FlatPtr*> stack_base, Userspace<size_t*> stack_size);
     ErrorOr<FlatPtr> sys$ptrace(Userspace<Syscall::SC_ptrace_params const*>);
     ErrorOr<FlatPtr> sys$sendfd(int sockfd, int fd);
+    ErrorOr<FlatPtr> sys$sendfile(int out_fd, int in_fd, Userspace<off_t*> offset, size_t count);
+    ErrorOr<FlatPtr> sys$splice(Userspace<Syscall::SC_splice_params const*>);
     ErrorOr<FlatPtr> sys$recvfd(int sockfd, int options);
     ErrorOr<FlatPtr> sys$sysconf(int name);
     ErrorOr<FlatPtr> sys$disown(ProcessID);
@@ -666,6 +679,7 @@ private:
 
     ErrorOr<void> do_exec(NonnullRefPtr<OpenFileDescription> main_program_description, Vector<NonnullOwnPtr<KString>> arguments, Vector<NonnullOwnPtr<KString>> environment, RefPtr<OpenFileDescription> interpreter_description, Thread*& new_main_thread, InterruptsState& previous_interrupts_state, const ElfW(Ehdr) & main_program_header, Optional<size_t> minimum_stack_size = {});
     ErrorOr<FlatPtr> do_write(OpenFileDescription&, UserOrKernelBuffer const&, size_t, Optional<off_t> = {});
+    ErrorOr<FlatPtr> transfer(OpenFileDescription& source, Optional<off_t>& source_offset, OpenFileDescription& destination, Optional<off_t>& destination_offset, size_t count, ShouldBlock);
 
     ErrorOr<FlatPtr> do_statvfs(FileSystem const& path, Custody const*, statvfs* buf);
 
@@ -685,6 +699,8 @@ private:
 
     void clear_signal_handlers_for_exec();
     void clear_futex_queues_on_exec();
+    void cancel_io_ring_requests_for_exec();
+    void resume_io_ring_requests_after_exec();
 
     ErrorOr<GlobalFutexKey> get_futex_key(FlatPtr user_address, bool shared);
 
@@ -914,6 +930,7 @@ private:
     bool m_profiling { false };
     Atomic<bool, AK::MemoryOrder::memory_order_relaxed> m_is_stopped { false };
     bool m_should_generate_coredump { false };
+    Atomic<u32> m_exec_generation { 0 };
 
     SpinlockProtected<RefPtr<Custody>, LockRank::None> m_executable;
 
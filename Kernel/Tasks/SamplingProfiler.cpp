@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Array.h>
+#include <AK/Atomic.h>
+#include <AK/Singleton.h>
+#include <Kernel/Arch/Processor.h>
+#include <Kernel/Arch/SafeMem.h>
+#include <Kernel/Arch/SmapDisabler.h>
+#include <Kernel/Locking/Mutex.h>
+#include <Kernel/Memory/MemoryManager.h>
+#include <Kernel/Tasks/SamplingProfiler.h>
+#include <Kernel/Tasks/Thread.h>
+
+namespace Kernel {
+
+// A ring buffer that only its processor writes to, from the timer interrupt, and that only drain() reads from.
+struct ProcessorSamples {
+    Atomic<u32> head { 0 };
+    Atomic<u32> tail { 0 };
+    Atomic<u64> dropped { 0 };
+    u32 ticks_until_next_sample { 0 };
+    SamplingProfiler::Sample samples[SamplingProfiler::samples_per_processor];
+};
+
+static Atomic<u32> s_ticks_per_sample { 0 };
+static Array<Atomic<ProcessorSamples*>, MAX_CPU_COUNT> s_processor_samples;
+
+// Serializes starting and stopping with draining.
+static Singleton<Mutex> s_lock;
+
+ErrorOr<void> SamplingProfiler::set_frequency(u32 frequency)
+{
+    MutexLocker locker(*s_lock);
+    if (frequency == 0) {
+        s_ticks_per_sample.store(0, AK::MemoryOrder::memory_order_relaxed);
+        return {};
+    }
+
+    // The buffers stay around once sampling has been started, so that the timer interrupt never has to worry
+    // about them going away.
+    for (u32 processor = 0; processor < max(Processor::count(), 1u); ++processor) {
+        if (s_processor_samples[processor].load(AK::MemoryOrder::memory_order_relaxed))
+            continue;
+        auto* samples = new (nothrow) ProcessorSamples;
+        if (!samples)
+            return ENOMEM;
+        s_processor_samples[processor].store(samples, AK::MemoryOrder::memory_order_release);
+    }
+
+    auto ticks_per_sample = max_frequency / min(frequency, max_frequency);
+    s_ticks_per_sample.store(ticks_per_sample, AK::MemoryOrder::memory_order_release);
+    return {};
+}
+
+u32 SamplingProfiler::frequency()
+{
+    auto ticks_per_sample = s_ticks_per_sample.load(AK::MemoryOrder::memory_order_relaxed);
+    if (ticks_per_sample == 0)
+        return 0;
+    return max_frequency / ticks_per_sample;
+}
+
+// Walks the frame pointers from the kernel stack into the user stack, much like PerformanceEventBuffer does.
+static void capture_stack(SamplingProfiler::Sample& sample, RegisterState const& regs)
+{
+    sample.frames[0] = regs.ip();
+    sample.frame_count = 1;
+    sample.kernel_frame_count = Memory::is_user_address(VirtualAddress { regs.ip() }) ? 0 : 1;
+
+    SmapDisabler disabler;
+    bool is_walking_userspace_stack = sample.kernel_frame_count == 0;
+    FlatPtr stack_ptr = regs.bp();
+    while (stack_ptr && sample.frame_count < SamplingProfiler::max_frame_count) {
+        // NOTE: The stack should always have kernel frames first, followed by userspace frames.
+        //       If a userspace frame points back into kernel memory, something is afoot.
+        if (Memory::is_user_address(VirtualAddress { stack_ptr })) {
+            is_walking_userspace_stack = true;
+            // We're in the timer interrupt, which can't fault in stack pages that aren't mapped yet.
+            if (!MM.is_user_page_present_in_current_page_tables(VirtualAddress { stack_ptr })
+                || !MM.is_user_page_present_in_current_page_tables(VirtualAddress { stack_ptr + sizeof(FlatPtr) }))
+                break;
+        } else if (is_walking_userspace_stack) {
+            break;
+        }
+
+        void* fault_at;
+        FlatPtr next_stack_ptr;
+        FlatPtr return_address;
+        if (!safe_memcpy(&next_stack_ptr, reinterpret_cast<void*>(stack_ptr), sizeof(FlatPtr), fault_at))
+            break;
+        if (!safe_memcpy(&return_address, reinterpret_cast<void*>(stack_ptr + sizeof(FlatPtr)), sizeof(FlatPtr), fault_at))
+            break;
+        if (return_address == 0)
+            break;
+        bool is_user_frame = Memory::is_user_address(VirtualAddress { return_address });
+        if (!is_user_frame && is_walking_userspace_stack)
+            break;
+        is_walking_userspace_stack = is_user_frame;
+        sample.frames[sample.frame_count++] = return_address;
+        if (!is_user_frame)
+            ++sample.kernel_frame_count;
+        stack_ptr = next_stack_ptr;
+    }
+}
+
+void SamplingProfiler::timer_tick(Thread& thread, RegisterState const& regs)
+{
+    auto ticks_per_sample = s_ticks_per_sample.load(AK::MemoryOrder::memory_order_acquire);
+    if (ticks_per_sample == 0)
+        return;
+
+    auto* samples = s_processor_samples[Processor::current_id()].load(AK::MemoryOrder::memory_order_acquire);
+    if (!samples)
+        return;
+    if (samples->ticks_until_next_sample > 0) {
+        --samples->ticks_until_next_sample;
+        return;
+    }
+    samples->ticks_until_next_sample = ticks_per_sample - 1;
+
+    auto head = samples->head.load(AK::MemoryOrder::memory_order_relaxed);
+    if (head - samples->tail.load(AK::MemoryOrder::memory_order_acquire) >= samples_per_processor) {
+        samples->dropped.fetch_add(1, AK::MemoryOrder::memory_order_relaxed);
+        return;
+    }
+
+    auto& sample = samples->samples[head % samples_per_processor];
+    sample.timestamp_ns = TimeManagement::the().monotonic_time(TimePrecision::Coarse).nanoseconds();
+    sample.pid = thread.pid().value();
+    sample.tid = thread.tid().value();
+    sample.processor = Processor::current_id();
+    capture_stack(sample, regs);
+    samples->head.store(head + 1, AK::MemoryOrder::memory_order_release);
+}
+
+ErrorOr<void> SamplingProfiler::drain(Function<ErrorOr<void>(Sample const&)> callback)
+{
+    MutexLocker locker(*s_lock);
+    for (auto& processor_samples : s_processor_samples) {
+        auto* samples = processor_samples.load(AK::MemoryOrder::memory_order_acquire);
+        if (!samples)
+            continue;
+        auto head = samples->head.load(AK::MemoryOrder::memory_order_acquire);
+        for (auto tail = samples->tail.load(AK::MemoryOrder::memory_order_relaxed); tail != head; ++tail) {
+            // Copy the sample out first, as its slot can be reused as soon as the tail moves past it.
+            auto sample = samples->samples[tail % samples_per_processor];
+            samples->tail.store(tail + 1, AK::MemoryOrder::memory_order_release);
+            TRY(callback(sample));
+        }
+    }
+    return {};
+}
+
+u64 SamplingProfiler::dropped_sample_count()
+{
+    u64 count = 0;
+    for (auto& processor_samples : s_processor_samples) {
+        if (auto* samples = processor_samples.load(AK::MemoryOrder::memory_order_acquire))
+            count += samples->dropped.load(AK::MemoryOrder::memory_order_relaxed);
+    }
+    return count;
+}
+
+}
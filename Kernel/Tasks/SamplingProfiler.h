@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Error.h>
+#include <AK/Function.h>
+#include <AK/Types.h>
+#include <Kernel/Forward.h>
+#include <Kernel/Time/TimeManagement.h>
+
+namespace Kernel {
+
+// Samples what every processor is running from the scheduler's timer interrupt. Unlike the profiling that
+// PerformanceEventBuffer does, this doesn't record anything else, so it's cheap enough to leave on under load.
+//
+// Each processor writes its samples into a ring buffer of its own, without taking any locks. The rings are
+// drained by reading /sys/kernel/profile_samples. If nobody reads them quickly enough, new samples are dropped.
+class SamplingProfiler {
+public:
+    static constexpr size_t max_frame_count = 32;
+    static constexpr size_t samples_per_processor = 512;
+
+    // Samples are taken on timer ticks, so this is as often as they can be taken.
+    static constexpr u32 max_frequency = OPTIMAL_TICKS_PER_SECOND_RATE;
+
+    struct Sample {
+        u64 timestamp_ns { 0 };
+        pid_t pid { 0 };
+        pid_t tid { 0 };
+        u32 processor { 0 };
+        // The kernel frames come first, followed by the frames in userspace.
+        u16 kernel_frame_count { 0 };
+        u16 frame_count { 0 };
+        FlatPtr frames[max_frame_count];
+    };
+
+    // A frequency of 0 stops sampling. Others are rounded to a whole number of timer ticks.
+    static ErrorOr<void> set_frequency(u32);
+    static u32 frequency();
+
+    static void timer_tick(Thread&, RegisterState const&);
+
+    // Takes all samples out of the buffers, oldest first for each processor.
+    static ErrorOr<void> drain(Function<ErrorOr<void>(Sample const&)>);
+    static u64 dropped_sample_count();
+};
+
+}
@@ -6,7 +6,6 @@
 
 #include <AK/BuiltinWrappers.h>
 #include <AK/ScopeGuard.h>
-#include <AK/Singleton.h>
 #include <AK/Time.h>
 #include <Kernel/Arch/TrapFrame.h>
 #include <Kernel/Debug.h>
@@ -15,6 +14,7 @@
 #include <Kernel/Sections.h>
 #include <Kernel/Tasks/PerformanceManager.h>
 #include <Kernel/Tasks/Process.h>
+#include <Kernel/Tasks/SamplingProfiler.h>
 #include <Kernel/Tasks/Scheduler.h>
 #include <Kernel/Time/TimeManagement.h>
 #include <Kernel/kstdio.h>
@@ -44,9 +44,85 @@ struct ThreadReadyQueues {
     u32 mask {};
     static constexpr size_t count = sizeof(mask) * 8;
     Array<ThreadReadyQueue, count> queues;
+
+    // Only modified with the lock of the owning processor held, but read without it when looking for work to steal.
+    Atomic<u32> thread_count { 0 };
+
+    Thread* find_runnable_thread(u32 affinity_mask)
+    {
+        auto priority_mask = mask;
+        while (priority_mask != 0) {
+            auto priority = bit_scan_forward(priority_mask);
+            VERIFY(priority > 0);
+            auto& ready_queue = queues[--priority];
+            for (auto& thread : ready_queue.thread_list) {
+                VERIFY(thread.m_runnable_priority == (int)priority);
+                if (thread.is_active())
+                    continue;
+                if (!(thread.affinity() & affinity_mask))
+                    continue;
+                return &thread;
+            }
+            priority_mask &= ~(1u << priority);
+        }
+        return nullptr;
+    }
+
+    void enqueue(Thread& thread, u32 priority)
+    {
+        VERIFY(thread.m_runnable_priority < 0);
+        thread.m_runnable_priority = (int)priority;
+        VERIFY(!thread.m_ready_queue_node.is_in_list());
+        auto& ready_queue = queues[priority];
+        bool was_empty = ready_queue.thread_list.is_empty();
+        ready_queue.thread_list.append(thread);
+        if (was_empty)
+            mask |= (1u << priority);
+        thread_count.store(thread_count.load(AK::memory_order_relaxed) + 1, AK::memory_order_relaxed);
+    }
+
+    void dequeue(Thread& thread)
+    {
+        auto priority = thread.m_runnable_priority;
+        VERIFY(mask & (1u << priority));
+        auto& ready_queue = queues[priority];
+        thread.m_runnable_priority = -1;
+        ready_queue.thread_list.remove(thread);
+        if (ready_queue.thread_list.is_empty())
+            mask &= ~(1u << priority);
+        thread_count.store(thread_count.load(AK::memory_order_relaxed) - 1, AK::memory_order_relaxed);
+    }
+};
+
+// Every processor has its own ready queues, so that processors don't all contend on one lock (and one
+// cache line) whenever they pick a thread or check whether they should preempt the current one.
+struct alignas(64) ProcessorReadyQueues {
+    Spinlock<LockRank::None> lock {};
+    ThreadReadyQueues ready_queues;
+
+    // Only touched by the owning processor, from its timer interrupt.
+    u32 ticks_until_load_balance { 0 };
+
+    Atomic<u64> context_switches { 0 };
+    Atomic<u64> threads_stolen { 0 };
+    Atomic<u64> migrations { 0 };
+    Atomic<u64> lock_contentions { 0 };
+
+    template<typename Callback>
+    decltype(auto) with(Callback callback)
+    {
+        // This is only an estimate, but it's good enough to tell whether processors are fighting over a queue.
+        if (lock.is_locked())
+            lock_contentions.fetch_add(1, AK::memory_order_relaxed);
+        SpinlockLocker locker(lock);
+        return callback(ready_queues);
+    }
 };
 
-static Singleton<SpinlockProtected<ThreadReadyQueues, LockRank::None>> g_ready_queues;
+// Thread affinities are a u32 bitmask, so there can't be more processors than that.
+static constexpr size_t max_processor_count = sizeof(u32) * 8;
+static Array<ProcessorReadyQueues, max_processor_count> s_processor_ready_queues;
+static Atomic<u32> s_online_processors_mask { 0 };
 
 static SpinlockProtected<TotalTimeScheduled, LockRank::None> g_total_time_scheduled {};
 
@@ -55,7 +131,7 @@ static void dump_thread_list(bool = false);
 static inline u32 thread_priority_to_priority_index(u32 thread_priority)
 {
     // Converts the priority in the range of THREAD_PRIORITY_MIN...THREAD_PRIORITY_MAX
-    // to a index into g_ready_queues where 0 is the highest priority bucket
+    // to a index into ThreadReadyQueues::queues where 0 is the highest priority bucket
     VERIFY(thread_priority >= THREAD_PRIORITY_MIN && thread_priority <= THREAD_PRIORITY_MAX);
     constexpr u32 thread_priority_count = THREAD_PRIORITY_MAX - THREAD_PRIORITY_MIN + 1;
     static_assert(thread_priority_count > 0);
@@ -64,73 +140,147 @@ static inline u32 thread_priority_to_priority_index(u32 thread_priority)
     return priority_bucket;
 }
 
-Thread& Scheduler::pull_next_runnable_thread()
+static Thread* pull_runnable_thread_from(u32 processor, u32 affinity_mask)
 {
-    auto affinity_mask = 1u << Processor::current_id();
+    return s_processor_ready_queues[processor].with([&](auto& ready_queues) -> Thread* {
+        auto* thread = ready_queues.find_runnable_thread(affinity_mask);
+        if (!thread)
+            return nullptr;
+        ready_queues.dequeue(*thread);
+        // Mark it as active because we are using this thread. This is similar
+        // to comparing it with Processor::current_thread, but when there are
+        // multiple processors there's no easy way to check whether the thread
+        // is actually still needed. This prevents accidental finalization when
+        // a thread is no longer in Running state, but running on another core.
+
+        // We need to mark it active here so that this thread won't be
+        // scheduled on another core if it were to be queued before actually
+        // switching to it.
+        // FIXME: Figure out a better way maybe?
+        thread->set_active(true);
+        return thread;
+    });
+}
 
-    return g_ready_queues->with([&](auto& ready_queues) -> Thread& {
-        auto priority_mask = ready_queues.mask;
-        while (priority_mask != 0) {
-            auto priority = bit_scan_forward(priority_mask);
-            VERIFY(priority > 0);
-            auto& ready_queue = ready_queues.queues[--priority];
-            for (auto& thread : ready_queue.thread_list) {
-                VERIFY(thread.m_runnable_priority == (int)priority);
-                if (thread.is_active())
-                    continue;
-                if (!(thread.affinity() & affinity_mask))
-                    continue;
-                thread.m_runnable_priority = -1;
-                ready_queue.thread_list.remove(thread);
-                if (ready_queue.thread_list.is_empty())
-                    ready_queues.mask &= ~(1u << priority);
-                // Mark it as active because we are using this thread. This is similar
-                // to comparing it with Processor::current_thread, but when there are
-                // multiple processors there's no easy way to check whether the thread
-                // is actually still needed. This prevents accidental finalization when
-                // a thread is no longer in Running state, but running on another core.
-
-                // We need to mark it active here so that this thread won't be
-                // scheduled on another core if it were to be queued before actually
-                // switching to it.
-                // FIXME: Figure out a better way maybe?
-                thread.set_active(true);
-                return thread;
-            }
-            priority_mask &= ~(1u << priority);
+// Picks whichever of the candidate processors has the most threads waiting, as that's where they'd wait the longest.
+static u32 busiest_processor_among(u32 candidates, u32& busiest_thread_count)
+{
+    u32 busiest_processor = 0;
+    busiest_thread_count = 0;
+    while (candidates != 0) {
+        auto candidate = bit_scan_forward(candidates) - 1;
+        candidates &= ~(1u << candidate);
+        auto thread_count = s_processor_ready_queues[candidate].ready_queues.thread_count.load(AK::memory_order_relaxed);
+        if (thread_count > busiest_thread_count) {
+            busiest_processor = candidate;
+            busiest_thread_count = thread_count;
         }
+    }
+    return busiest_processor;
+}
+
+static Thread* steal_runnable_thread(u32 processor)
+{
+    auto affinity_mask = 1u << processor;
+    auto candidates = s_online_processors_mask.load(AK::memory_order_relaxed) & ~affinity_mask;
+
+    while (candidates != 0) {
+        u32 busiest_thread_count = 0;
+        auto busiest_processor = busiest_processor_among(candidates, busiest_thread_count);
+        if (busiest_thread_count == 0)
+            return nullptr;
+
+        if (auto* thread = pull_runnable_thread_from(busiest_processor, affinity_mask)) {
+            s_processor_ready_queues[processor].threads_stolen.fetch_add(1, AK::memory_order_relaxed);
+            return thread;
+        }
+
+        // Everything queued there is either running or not allowed to run here.
+        candidates &= ~(1u << busiest_processor);
+    }
+    return nullptr;
+}
+
+// Processors only steal work once they run out of their own, so without this, threads could keep piling up
+// behind each other on one busy processor while another busy processor has much less to do.
+static constexpr u32 load_balance_interval_in_ticks = 25;
+
+void Scheduler::balance_load(u32 processor)
+{
+    VERIFY(g_scheduler_lock.is_locked_by_current_processor());
+
+    auto& own_ready_queues = s_processor_ready_queues[processor];
+    auto own_thread_count = own_ready_queues.ready_queues.thread_count.load(AK::memory_order_relaxed);
+    u32 busiest_thread_count = 0;
+    auto busiest_processor = busiest_processor_among(s_online_processors_mask.load(AK::memory_order_relaxed) & ~(1u << processor), busiest_thread_count);
+
+    // Moving a thread over only helps if the busiest processor would still have at least as many waiting afterwards.
+    if (busiest_thread_count < own_thread_count + 2)
+        return;
+
+    // The scheduler lock keeps anyone else from looking for the thread while it is in neither queue.
+    u32 priority = 0;
+    auto* thread = s_processor_ready_queues[busiest_processor].with([&](auto& ready_queues) -> Thread* {
+        auto* thread = ready_queues.find_runnable_thread(1u << processor);
+        if (!thread)
+            return nullptr;
+        priority = thread->m_runnable_priority;
+        ready_queues.dequeue(*thread);
+        return thread;
+    });
+    if (!thread)
+        return;
 
-        auto* idle_thread = Processor::idle_thread();
-        idle_thread->set_active(true);
-        return *idle_thread;
+    own_ready_queues.with([&](auto& ready_queues) {
+        ready_queues.enqueue(*thread, priority);
+        thread->m_runnable_processor = processor;
     });
+    own_ready_queues.threads_stolen.fetch_add(1, AK::memory_order_relaxed);
 }
 
-Thread* Scheduler::peek_next_runnable_thread()
+static u32 processor_to_enqueue_on(Thread const& thread)
 {
-    auto affinity_mask = 1u << Processor::current_id();
+    auto allowed_processors = thread.affinity() & s_online_processors_mask.load(AK::memory_order_relaxed);
+    if (allowed_processors == 0) {
+        // The thread is pinned to processors that haven't come up yet. It will run once they do.
+        return bit_scan_forward(thread.affinity()) - 1;
+    }
 
-    return g_ready_queues->with([&](auto& ready_queues) -> Thread* {
-        auto priority_mask = ready_queues.mask;
-        while (priority_mask != 0) {
-            auto priority = bit_scan_forward(priority_mask);
-            VERIFY(priority > 0);
-            auto& ready_queue = ready_queues.queues[--priority];
-            for (auto& thread : ready_queue.thread_list) {
-                VERIFY(thread.m_runnable_priority == (int)priority);
-                if (thread.is_active())
-                    continue;
-                if (!(thread.affinity() & affinity_mask))
-                    continue;
-                return &thread;
-            }
-            priority_mask &= ~(1u << priority);
-        }
+    // Prefer the processor the thread last ran on, as its caches are most likely to still hold the thread's data.
+    // Threads that never ran yet go to the processor that made them runnable, which has most recently touched them.
+    if (thread.is_initialized() && (allowed_processors & (1u << thread.cpu())))
+        return thread.cpu();
+    auto current_processor = Processor::current_id();
+    if (allowed_processors & (1u << current_processor))
+        return current_processor;
+    return bit_scan_forward(allowed_processors) - 1;
+}
 
-        // Unlike in pull_next_runnable_thread() we don't want to fall back to
-        // the idle thread. We just want to see if we have any other thread ready
-        // to be scheduled.
-        return nullptr;
+Thread& Scheduler::pull_next_runnable_thread()
+{
+    auto current_processor = Processor::current_id();
+
+    if (auto* thread = pull_runnable_thread_from(current_processor, 1u << current_processor))
+        return *thread;
+
+    // Our own queues ran dry, so balance the load by taking over some work from a busier processor.
+    if (auto* thread = steal_runnable_thread(current_processor))
+        return *thread;
+
+    auto* idle_thread = Processor::idle_thread();
+    idle_thread->set_active(true);
+    return *idle_thread;
+}
+
+Thread* Scheduler::peek_next_runnable_thread()
+{
+    auto current_processor = Processor::current_id();
+
+    // Unlike in pull_next_runnable_thread() we don't want to fall back to
+    // the idle thread or steal from other processors. We just want to see if
+    // we have any other thread ready to be scheduled.
+    return s_processor_ready_queues[current_processor].with([&](auto& ready_queues) {
+        return ready_queues.find_runnable_thread(1u << current_processor);
     });
 }
 
@@ -139,9 +289,9 @@ bool Scheduler::dequeue_runnable_thread(Thread& thread, bool check_affinity)
     if (thread.is_idle_thread())
         return true;
 
-    return g_ready_queues->with([&](auto& ready_queues) {
-        auto priority = thread.m_runnable_priority;
-        if (priority < 0) {
+    // NOTE: m_runnable_processor is only changed while enqueueing, which requires the scheduler lock.
+    return s_processor_ready_queues[thread.m_runnable_processor].with([&](auto& ready_queues) {
+        if (thread.m_runnable_priority < 0) {
             VERIFY(!thread.m_ready_queue_node.is_in_list());
             return false;
         }
@@ -149,12 +299,7 @@ bool Scheduler::dequeue_runnable_thread(Thread& thread, bool check_affinity)
         if (check_affinity && !(thread.affinity() & (1 << Processor::current_id())))
             return false;
 
-        VERIFY(ready_queues.mask & (1u << priority));
-        auto& ready_queue = ready_queues.queues[priority];
-        thread.m_runnable_priority = -1;
-        ready_queue.thread_list.remove(thread);
-        if (ready_queue.thread_list.is_empty())
-            ready_queues.mask &= ~(1u << priority);
+        ready_queues.dequeue(thread);
         return true;
     });
 }
@@ -165,17 +310,22 @@ void Scheduler::enqueue_runnable_thread(Thread& thread)
     if (thread.is_idle_thread())
         return;
     auto priority = thread_priority_to_priority_index(thread.priority());
+    auto processor = processor_to_enqueue_on(thread);
 
-    g_ready_queues->with([&](auto& ready_queues) {
-        VERIFY(thread.m_runnable_priority < 0);
-        thread.m_runnable_priority = (int)priority;
-        VERIFY(!thread.m_ready_queue_node.is_in_list());
-        auto& ready_queue = ready_queues.queues[priority];
-        bool was_empty = ready_queue.thread_list.is_empty();
-        ready_queue.thread_list.append(thread);
-        if (was_empty)
-            ready_queues.mask |= (1u << priority);
+    auto& processor_ready_queues = s_processor_ready_queues[processor];
+    if (thread.is_initialized() && processor != thread.cpu())
+        processor_ready_queues.migrations.fetch_add(1, AK::memory_order_relaxed);
+
+    processor_ready_queues.with([&](auto& ready_queues) {
+        ready_queues.enqueue(thread, priority);
+        thread.m_runnable_processor = processor;
     });
+
+    // Make sure someone picks the thread up soon: the processor it was queued on if that's sitting idle,
+    // or otherwise any idle processor, which will steal it.
+    if (Processor::smp_wake_idle_processor(processor))
+        return;
+    Processor::smp_wake_n_idle_processors(1);
 }
 
 UNMAP_AFTER_INIT void Scheduler::start()
@@ -281,6 +431,8 @@ void Scheduler::context_switch(Thread* thread)
 #endif
 
     auto& proc = Processor::current();
+    s_processor_ready_queues[proc.id()].context_switches.fetch_add(1, AK::memory_order_relaxed);
+
     if (!thread->is_initialized()) {
         proc.init_context(*thread, false);
         thread->set_initialized(true);
@@ -385,6 +537,10 @@ UNMAP_AFTER_INIT void Scheduler::set_idle_thread(Thread* idle_thread)
     idle_thread->set_idle_thread();
     Processor::current().set_idle_thread(*idle_thread);
     Processor::set_current_thread(*idle_thread);
+
+    auto processor = Processor::current_id();
+    VERIFY(processor < max_processor_count);
+    s_online_processors_mask.fetch_or(1u << processor, AK::memory_order_relaxed);
 }
 
 UNMAP_AFTER_INIT Thread* Scheduler::create_ap_idle_thread(u32 cpu)
@@ -421,6 +577,8 @@ void Scheduler::timer_tick(RegisterState const& regs)
     VERIFY(current_thread->current_trap());
     VERIFY(current_thread->current_trap()->regs == &regs);
 
+    SamplingProfiler::timer_tick(*current_thread, regs);
+
     if (current_thread->process().is_kernel_process()) {
         // Because the previous mode when entering/exiting kernel threads never changes
         // we never update the time scheduled. So we need to update it manually on the
@@ -436,6 +594,13 @@ void Scheduler::timer_tick(RegisterState const& regs)
         return;
     }
 
+    auto& processor_ready_queues = s_processor_ready_queues[Processor::current_id()];
+    if (processor_ready_queues.ticks_until_load_balance-- == 0) {
+        processor_ready_queues.ticks_until_load_balance = load_balance_interval_in_ticks - 1;
+        SpinlockLocker scheduler_lock(g_scheduler_lock);
+        balance_load(Processor::current_id());
+    }
+
     if (current_thread->tick())
         return;
 
@@ -503,6 +668,27 @@ TotalTimeScheduled Scheduler::get_total_time_scheduled()
     return g_total_time_scheduled.with([&](auto& total_time_scheduled) { return total_time_scheduled; });
 }
 
+ErrorOr<void> Scheduler::try_for_each_processor_statistics(Function<ErrorOr<void>(ProcessorSchedulerStatistics const&)> callback)
+{
+    auto online_processors = s_online_processors_mask.load(AK::memory_order_relaxed);
+    while (online_processors != 0) {
+        u32 processor = bit_scan_forward(online_processors) - 1;
+        online_processors &= ~(1u << processor);
+
+        auto& processor_ready_queues = s_processor_ready_queues[processor];
+        ProcessorSchedulerStatistics statistics {
+            .processor = processor,
+            .ready_threads = processor_ready_queues.ready_queues.thread_count.load(AK::memory_order_relaxed),
+            .context_switches = processor_ready_queues.context_switches.load(AK::memory_order_relaxed),
+            .threads_stolen = processor_ready_queues.threads_stolen.load(AK::memory_order_relaxed),
+            .migrations = processor_ready_queues.migrations.load(AK::memory_order_relaxed),
+            .ready_queue_lock_contentions = processor_ready_queues.lock_contentions.load(AK::memory_order_relaxed),
+        };
+        TRY(callback(statistics));
+    }
+    return {};
+}
+
 void dump_thread_list(bool with_stack_traces)
 {
     dbgln("Scheduler thread list for processor {}:", Processor::current_id());
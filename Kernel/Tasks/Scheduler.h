@@ -7,6 +7,7 @@
 #pragma once
 
 #include <AK/Assertions.h>
+#include <AK/Error.h>
 #include <AK/Function.h>
 #include <AK/IntrusiveList.h>
 #include <AK/Types.h>
@@ -29,6 +30,15 @@ struct TotalTimeScheduled {
     u64 total_kernel { 0 };
 };
 
+struct ProcessorSchedulerStatistics {
+    u32 processor { 0 };
+    u32 ready_threads { 0 };
+    u64 context_switches { 0 };
+    u64 threads_stolen { 0 };
+    u64 migrations { 0 };
+    u64 ready_queue_lock_contentions { 0 };
+};
+
 class Scheduler {
 public:
     static void initialize();
@@ -51,9 +61,11 @@ public:
     static Thread* peek_next_runnable_thread();
     static bool dequeue_runnable_thread(Thread&, bool = false);
     static void enqueue_runnable_thread(Thread&);
+    static void balance_load(u32 processor);
     static void dump_scheduler_state(bool = false);
     static bool is_initialized();
     static TotalTimeScheduled get_total_time_scheduled();
+    static ErrorOr<void> try_for_each_processor_statistics(Function<ErrorOr<void>(ProcessorSchedulerStatistics const&)>);
     static void add_time_scheduled(u64, bool);
 };
 
@@ -5,6 +5,7 @@
  */
 
 #include <Kernel/FileSystem/VirtualFileSystem.h>
+#include <Kernel/Memory/MemoryManager.h>
 #include <Kernel/Sections.h>
 #include <Kernel/Tasks/Process.h>
 #include <Kernel/Tasks/SyncTask.h>
@@ -18,6 +19,8 @@ UNMAP_AFTER_INIT void SyncTask::spawn()
         dbgln("VFS SyncTask is running");
         while (!Process::current().is_dying()) {
             VirtualFileSystem::sync();
+            if (MM.is_under_memory_pressure())
+                VirtualFileSystem::the().release_cached_memory_from_filesystems();
             (void)Thread::current()->sleep(Duration::from_seconds(1));
         }
         Process::current().sys$exit(0);
@@ -61,6 +61,7 @@ class Thread
     friend class Process;
     friend class Scheduler;
     friend struct ThreadReadyQueue;
+    friend struct ThreadReadyQueues;
 
 public:
     static Thread* current()
@@ -459,7 +460,7 @@ public:
 
     class FutexBlocker final : public Blocker {
     public:
-        explicit FutexBlocker(FutexQueue&, u32);
+        FutexBlocker(FutexQueue&, u32 bitset, u32 imminent_wake_generation);
         virtual ~FutexBlocker();
 
         virtual Type blocker_type() const override { return Type::Futex; }
@@ -468,6 +469,7 @@ public:
         virtual bool setup_blocker() override;
 
         u32 bitset() const { return m_bitset; }
+        u32 imminent_wake_generation() const { return m_imminent_wake_generation; }
 
         void begin_requeue()
         {
@@ -482,6 +484,7 @@ public:
     protected:
         FutexQueue& m_futex_queue;
         u32 m_bitset { 0 };
+        u32 m_imminent_wake_generation { 0 };
         InterruptsState m_previous_interrupts_state { InterruptsState::Disabled };
         bool m_did_unblock { false };
     };
@@ -1093,6 +1096,7 @@ private:
 
     IntrusiveListNode<Thread> m_process_thread_list_node;
     int m_runnable_priority { -1 };
+    u32 m_runnable_processor { 0 };
 
     friend class WaitQueue;
 
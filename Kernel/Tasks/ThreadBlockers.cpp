@@ -146,9 +146,10 @@ bool Thread::WaitQueueBlocker::unblock()
     return true;
 }
 
-Thread::FutexBlocker::FutexBlocker(FutexQueue& futex_queue, u32 bitset)
+Thread::FutexBlocker::FutexBlocker(FutexQueue& futex_queue, u32 bitset, u32 imminent_wake_generation)
     : m_futex_queue(futex_queue)
     , m_bitset(bitset)
+    , m_imminent_wake_generation(imminent_wake_generation)
 {
 }
 
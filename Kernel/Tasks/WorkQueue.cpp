@@ -15,11 +15,19 @@ namespace Kernel {
 
 WorkQueue* g_io_work;
 WorkQueue* g_ata_work;
+WorkQueue* g_read_ahead_work;
+Array<WorkQueue*, io_ring_work_queue_count> g_io_ring_work;
 
 UNMAP_AFTER_INIT void WorkQueue::initialize()
 {
     g_io_work = new WorkQueue("IO WorkQueue Task"sv);
     g_ata_work = new WorkQueue("ATA WorkQueue Task"sv);
+    // NOTE: Read-ahead waits for disk I/O to finish, which is completed from the I/O work queue,
+    //       so it needs a queue of its own.
+    g_read_ahead_work = new WorkQueue("Read-ahead WorkQueue Task"sv);
+    // NOTE: I/O ring requests may wait for the disk or for a connection to be made, so they don't hold up the others.
+    for (auto& work_queue : g_io_ring_work)
+        work_queue = new WorkQueue("I/O ring WorkQueue Task"sv);
 }
 
 UNMAP_AFTER_INIT WorkQueue::WorkQueue(StringView name)
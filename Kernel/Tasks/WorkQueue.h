@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <AK/Array.h>
 #include <AK/Error.h>
 #include <AK/IntrusiveList.h>
 #include <Kernel/Forward.h>
@@ -17,6 +18,10 @@ namespace Kernel {
 
 extern WorkQueue* g_io_work;
 extern WorkQueue* g_ata_work;
+extern WorkQueue* g_read_ahead_work;
+// I/O ring requests are spread over several queues, so one that waits for the disk doesn't hold up all the others.
+static constexpr size_t io_ring_work_queue_count = 4;
+extern Array<WorkQueue*, io_ring_work_queue_count> g_io_ring_work;
 
 class WorkQueue {
     AK_MAKE_NONCOPYABLE(WorkQueue);
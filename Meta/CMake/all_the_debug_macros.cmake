@@ -107,6 +107,7 @@ set(LOCK_IN_CRITICAL_DEBUG ON)
 set(LOCK_RANK_ENFORCEMENT ON)
 set(LOCK_RESTORE_DEBUG ON)
 set(LOCK_SHARED_UPGRADE_DEBUG ON)
+set(LOCK_STATISTICS ON)
 set(LOCK_TRACE_DEBUG ON)
 set(LOOKUPSERVER_DEBUG ON)
 set(LOOPBACK_DEBUG ON)
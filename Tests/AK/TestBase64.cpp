@@ -8,6 +8,8 @@
 
 #include <AK/Base64.h>
 #include <AK/DeprecatedString.h>
+#include <AK/MemoryStream.h>
+#include <AK/Random.h>
 #include <string.h>
 
 TEST_CASE(test_decode)
@@ -35,6 +37,104 @@ TEST_CASE(test_decode_invalid)
     EXPECT(decode_base64(("asdf\x80qwe"sv)).is_error());
     EXPECT(decode_base64(("asdf:qwe"sv)).is_error());
     EXPECT(decode_base64(("asdf=qwe"sv)).is_error());
+
+    // Padding can only end the last group.
+    EXPECT(decode_base64(("Z==="sv)).is_error());
+    EXPECT(decode_base64(("Zm=v"sv)).is_error());
+    EXPECT(decode_base64(("Zg=="
+                          "Zg=="sv))
+               .is_error());
+    EXPECT(decode_base64(("Zg="sv)).is_error());
+    EXPECT(decode_base64(("Z"sv)).is_error());
+    EXPECT(decode_base64(("Zm9vY"sv)).is_error());
+
+    // Invalid characters are also caught in the middle of long inputs.
+    EXPECT(decode_base64(("Zm9vYmFyZm9vYmFyZm9vYmFyZm9v!mFyZm9vYmFyZm9vYmFy"sv)).is_error());
+}
+
+TEST_CASE(test_decode_without_padding)
+{
+    auto decode_equal = [&](StringView input, StringView expected) {
+        auto decoded = TRY_OR_FAIL(decode_base64(input));
+        EXPECT_EQ(StringView(decoded.bytes()), expected);
+    };
+
+    decode_equal("Zg"sv, "f"sv);
+    decode_equal("Zm8"sv, "fo"sv);
+    decode_equal("Zm9vYg"sv, "foob"sv);
+    decode_equal("Zm9v YmE \n"sv, "fooba"sv);
+}
+
+TEST_CASE(test_long_round_trip)
+{
+    // Long enough to go through the vectorized paths, with every length of tail.
+    ByteBuffer data = MUST(ByteBuffer::create_uninitialized(300));
+    fill_with_random(data);
+
+    for (size_t length = 0; length <= data.size(); ++length) {
+        auto input = data.bytes().trim(length);
+        auto encoded = MUST(encode_base64(input));
+        EXPECT_EQ(encoded.bytes().size(), calculate_base64_encoded_length(input));
+
+        // Compare with a simple reference encoder.
+        for (size_t i = 0; i < length; i += 3) {
+            u32 group = (input[i] << 16) | (i + 1 < length ? input[i + 1] << 8 : 0) | (i + 2 < length ? input[i + 2] : 0);
+            auto characters = encoded.bytes().slice(i / 3 * 4, 4);
+            EXPECT_EQ(characters[0], AK::base64_alphabet[group >> 18]);
+            EXPECT_EQ(characters[1], AK::base64_alphabet[(group >> 12) & 0x3f]);
+            EXPECT_EQ(characters[2], i + 1 < length ? AK::base64_alphabet[(group >> 6) & 0x3f] : '=');
+            EXPECT_EQ(characters[3], i + 2 < length ? AK::base64_alphabet[group & 0x3f] : '=');
+        }
+
+        auto decoded = TRY_OR_FAIL(decode_base64(encoded));
+        EXPECT_EQ(decoded.bytes(), input);
+    }
+
+    // Line breaks every 76 characters, as in MIME.
+    auto encoded = MUST(encode_base64(data)).to_deprecated_string();
+    StringBuilder wrapped;
+    for (size_t i = 0; i < encoded.length(); i += 76) {
+        wrapped.append(encoded.substring_view(i, min<size_t>(76, encoded.length() - i)));
+        wrapped.append("\r\n"sv);
+    }
+    auto decoded = TRY_OR_FAIL(decode_base64(wrapped.string_view()));
+    EXPECT_EQ(decoded.bytes(), data.bytes());
+}
+
+TEST_CASE(test_streaming)
+{
+    ByteBuffer data = MUST(ByteBuffer::create_uninitialized(10000));
+    fill_with_random(data);
+    auto encoded = MUST(encode_base64(data));
+
+    // Split the input at arbitrary points, including into single bytes.
+    for (size_t chunk_size : { 1, 2, 3, 5, 16, 1000, 4096, 10000 }) {
+        AllocatingMemoryStream encoded_stream;
+        Base64Encoder encoder { MaybeOwned<Stream>(encoded_stream) };
+        for (size_t offset = 0; offset < data.size(); offset += chunk_size)
+            TRY_OR_FAIL(encoder.write_until_depleted(data.bytes().slice(offset, min(chunk_size, data.size() - offset))));
+        TRY_OR_FAIL(encoder.finish());
+
+        auto streamed_encoding = TRY_OR_FAIL(encoded_stream.read_until_eof());
+        EXPECT_EQ(StringView(streamed_encoding.bytes()), encoded.bytes_as_string_view());
+
+        AllocatingMemoryStream decoded_stream;
+        Base64Decoder decoder { MaybeOwned<Stream>(decoded_stream) };
+        auto input = encoded.bytes();
+        for (size_t offset = 0; offset < input.size(); offset += chunk_size)
+            TRY_OR_FAIL(decoder.write_until_depleted(input.slice(offset, min(chunk_size, input.size() - offset))));
+        TRY_OR_FAIL(decoder.finish());
+
+        auto streamed_decoding = TRY_OR_FAIL(decoded_stream.read_until_eof());
+        EXPECT_EQ(streamed_decoding.bytes(), data.bytes());
+    }
+
+    // Errors are reported regardless of where the input is split.
+    AllocatingMemoryStream output;
+    Base64Decoder decoder { MaybeOwned<Stream>(output) };
+    TRY_OR_FAIL(decoder.write_until_depleted("Zm9vYg"sv.bytes()));
+    TRY_OR_FAIL(decoder.write_until_depleted("="sv.bytes()));
+    EXPECT(decoder.finish().is_error());
 }
 
 TEST_CASE(test_encode)
@@ -53,3 +153,24 @@ TEST_CASE(test_encode)
     encode_equal("fooba"sv, "Zm9vYmE="sv);
     encode_equal("foobar"sv, "Zm9vYmFy"sv);
 }
+
+static ByteBuffer make_benchmark_data()
+{
+    auto data = MUST(ByteBuffer::create_uninitialized(1 * MiB));
+    fill_with_random(data);
+    return data;
+}
+
+BENCHMARK_CASE(encode_throughput)
+{
+    auto data = make_benchmark_data();
+    for (size_t i = 0; i < 100; ++i)
+        EXPECT(!MUST(encode_base64(data)).is_empty());
+}
+
+BENCHMARK_CASE(decode_throughput)
+{
+    auto encoded = MUST(encode_base64(make_benchmark_data()));
+    for (size_t i = 0; i < 100; ++i)
+        EXPECT_EQ(TRY_OR_FAIL(decode_base64(encoded)).size(), 1 * MiB);
+}
@@ -204,6 +204,43 @@ TEST_CASE(find_longest_range_of_unset_bits_edge)
     EXPECT_EQ(result.value(), 32u);
 }
 
+TEST_CASE(find_next_range_of_unset_bits_from_the_middle)
+{
+    // An empty word, starting halfway through it.
+    {
+        auto bitmap = MUST(Bitmap::create(128, false));
+        size_t start = 10;
+        auto length = bitmap.find_next_range_of_unset_bits(start, 1, 8);
+        EXPECT_EQ(start, 10u);
+        EXPECT_EQ(length, 8u);
+    }
+    {
+        auto bitmap = MUST(Bitmap::create(128, true));
+        bitmap.set_range(64, 64, false);
+        size_t start = 100;
+        auto length = bitmap.find_next_range_of_unset_bits(start, 1);
+        EXPECT_EQ(start, 100u);
+        EXPECT_EQ(length, 28u);
+    }
+    // The trailing bits of a bitmap whose size isn't a multiple of the word size.
+    for (size_t from = 64; from < 100; ++from) {
+        auto bitmap = MUST(Bitmap::create(100, false));
+        size_t start = from;
+        auto length = bitmap.find_next_range_of_unset_bits(start, 100 - from);
+        EXPECT_EQ(start, from);
+        EXPECT_EQ(length, 100 - from);
+    }
+    {
+        auto bitmap = MUST(Bitmap::create(100, true));
+        bitmap.set(70, false);
+        bitmap.set(90, false);
+        size_t start = 71;
+        auto length = bitmap.find_next_range_of_unset_bits(start, 1);
+        EXPECT_EQ(start, 90u);
+        EXPECT_EQ(length, 1u);
+    }
+}
+
 TEST_CASE(count_in_range)
 {
     auto bitmap = MUST(Bitmap::create(256, false));
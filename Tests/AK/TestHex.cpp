@@ -7,6 +7,7 @@
 #include <LibTest/TestCase.h>
 
 #include <AK/Hex.h>
+#include <AK/Random.h>
 
 TEST_CASE(should_decode_hex_digit)
 {
@@ -59,3 +60,49 @@ TEST_CASE(should_constexpr_decode_hex_digit)
     static_assert(14u == decode_hex_digit('E'));
     static_assert(15u == decode_hex_digit('F'));
 }
+
+TEST_CASE(should_encode_and_decode_hex)
+{
+    EXPECT_EQ(encode_hex(""sv.bytes()), ""sv);
+    EXPECT_EQ(encode_hex("\x01\x23\x45\x67\x89\xab\xcd\xef\xff"sv.bytes()), "0123456789abcdefff"sv);
+
+    auto decoded = TRY_OR_FAIL(decode_hex("0123456789abcdefABCDEF"sv));
+    EXPECT_EQ(decoded.bytes(), "\x01\x23\x45\x67\x89\xab\xcd\xef\xab\xcd\xef"sv.bytes());
+    EXPECT(decode_hex("0"sv).is_error());
+    EXPECT(decode_hex("0g"sv).is_error());
+
+    // Invalid digits are also caught in the middle of long inputs.
+    EXPECT(decode_hex("00112233445566778899aabbccddeeff00112233445566:7"sv).is_error());
+    EXPECT(decode_hex("00112233445566778899aabbccddeeff0011223344556`77"sv).is_error());
+    EXPECT(decode_hex("00112233445566778899aabbccddeeff0011223344556G77"sv).is_error());
+}
+
+TEST_CASE(should_round_trip_long_hex)
+{
+    auto data = MUST(ByteBuffer::create_uninitialized(100));
+    fill_with_random(data);
+
+    for (size_t length = 0; length <= data.size(); ++length) {
+        auto input = data.bytes().trim(length);
+        auto encoded = encode_hex(input);
+        EXPECT_EQ(encoded.length(), length * 2);
+        for (size_t i = 0; i < length; ++i)
+            EXPECT_EQ(encoded.substring_view(i * 2, 2), DeprecatedString::formatted("{:02x}", input[i]));
+
+        auto decoded = TRY_OR_FAIL(decode_hex(encoded));
+        EXPECT_EQ(decoded.bytes(), input);
+        auto decoded_uppercase = TRY_OR_FAIL(decode_hex(encoded.to_uppercase()));
+        EXPECT_EQ(decoded_uppercase.bytes(), input);
+    }
+}
+
+BENCHMARK_CASE(hex_throughput)
+{
+    auto data = MUST(ByteBuffer::create_uninitialized(1 * MiB));
+    fill_with_random(data);
+
+    for (size_t i = 0; i < 100; ++i) {
+        auto encoded = encode_hex(data);
+        EXPECT_EQ(TRY_OR_FAIL(decode_hex(encoded)).size(), 1 * MiB);
+    }
+}
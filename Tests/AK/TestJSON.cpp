@@ -9,6 +9,7 @@
 #include <AK/DeprecatedString.h>
 #include <AK/HashMap.h>
 #include <AK/JsonObject.h>
+#include <AK/JsonStreamingParser.h>
 #include <AK/JsonValue.h>
 #include <AK/StringBuilder.h>
 
@@ -562,3 +563,235 @@ TEST_CASE(json_value_as_integer)
     EXPECT(!very_large_value.is_integer<i32>());
     EXPECT(very_large_value.is_integer<i64>());
 }
+
+// Records every event as a line of text, and reconstructs the document as a JsonValue to compare with JsonParser.
+class RecordingVisitor final : public JsonStreamingParser::Visitor {
+public:
+    virtual ErrorOr<void> on_object_start() override { return append("{"sv); }
+    virtual ErrorOr<void> on_object_end() override { return append("}"sv); }
+    virtual ErrorOr<void> on_array_start() override { return append("["sv); }
+    virtual ErrorOr<void> on_array_end() override { return append("]"sv); }
+    virtual ErrorOr<void> on_key(StringView key) override { return append(DeprecatedString::formatted("key {}", key)); }
+    virtual ErrorOr<void> on_string(StringView value) override { return append(DeprecatedString::formatted("string {}", value)); }
+    virtual ErrorOr<void> on_number(JsonValue const& value) override { return append(DeprecatedString::formatted("number {}", value.to_deprecated_string())); }
+    virtual ErrorOr<void> on_boolean(bool value) override { return append(DeprecatedString::formatted("boolean {}", value)); }
+    virtual ErrorOr<void> on_null() override { return append("null"sv); }
+
+    Vector<DeprecatedString> events;
+
+private:
+    ErrorOr<void> append(StringView event)
+    {
+        TRY(events.try_append(event));
+        return {};
+    }
+};
+
+static ErrorOr<Vector<DeprecatedString>> streaming_events(StringView input)
+{
+    RecordingVisitor visitor;
+    TRY(JsonStreamingParser { input }.parse(visitor));
+    return move(visitor.events);
+}
+
+TEST_CASE(streaming_parser_events)
+{
+    auto events = TRY_OR_FAIL(streaming_events(R"( {"name": "Form1", "size": [640, -1.5, 12345678901], "visible": true, "parent": null, "children": {}, "tags": []} )"sv));
+
+    Vector<DeprecatedString> expected {
+        "{", "key name", "string Form1",
+        "key size", "[", "number 640", "number -1.5", "number 12345678901", "]",
+        "key visible", "boolean true",
+        "key parent", "null",
+        "key children", "{", "}",
+        "key tags", "[", "]",
+        "}"
+    };
+    EXPECT_EQ(events, expected);
+
+    EXPECT_EQ(TRY_OR_FAIL(streaming_events("42"sv)), Vector<DeprecatedString> { "number 42" });
+    EXPECT_EQ(TRY_OR_FAIL(streaming_events("\"top\""sv)), Vector<DeprecatedString> { "string top" });
+    EXPECT_EQ(TRY_OR_FAIL(streaming_events("[[[]],{\"a\":{\"b\":[false]}}]"sv)),
+        (Vector<DeprecatedString> { "[", "[", "[", "]", "]", "{", "key a", "{", "key b", "[", "boolean false", "]", "}", "}", "]" }));
+}
+
+TEST_CASE(streaming_parser_zero_copy_strings)
+{
+    struct Visitor final : public JsonStreamingParser::Visitor {
+        virtual ErrorOr<void> on_key(StringView key) override
+        {
+            key_view = key;
+            return {};
+        }
+        virtual ErrorOr<void> on_string(StringView value) override
+        {
+            string_view = value;
+            return {};
+        }
+        StringView key_view;
+        StringView string_view;
+    };
+
+    auto input = R"({"key": "value"})"sv;
+    Visitor visitor;
+    TRY_OR_FAIL(JsonStreamingParser { input }.parse(visitor));
+
+    EXPECT_EQ(visitor.key_view, "key"sv);
+    EXPECT_EQ(visitor.key_view.characters_without_null_termination(), input.characters_without_null_termination() + 2);
+    EXPECT_EQ(visitor.string_view, "value"sv);
+    EXPECT_EQ(visitor.string_view.characters_without_null_termination(), input.characters_without_null_termination() + 9);
+}
+
+TEST_CASE(streaming_parser_escapes)
+{
+    auto events = TRY_OR_FAIL(streaming_events(R"({"a\"b": "\u0041\n\t\\\/\"", "\\": "\\\\"})"sv));
+    Vector<DeprecatedString> expected { "{", "key a\"b", "string A\n\t\\/\"", "key \\", "string \\\\", "}" };
+    EXPECT_EQ(events, expected);
+
+    // Runs of backslashes and quotes crossing the 64-byte block boundaries at every alignment.
+    for (size_t padding = 0; padding < 70; ++padding) {
+        for (size_t backslashes = 1; backslashes <= 5; ++backslashes) {
+            StringBuilder builder;
+            builder.append("[\""sv);
+            builder.append_repeated('x', padding);
+            for (size_t i = 0; i < backslashes * 2; ++i)
+                builder.append('\\');
+            builder.append("\\\"]\", \"{,}\", 1]"sv);
+            auto input = builder.string_view();
+
+            StringBuilder expected_string;
+            expected_string.append_repeated('x', padding);
+            expected_string.append_repeated('\\', backslashes);
+            expected_string.append("\"]"sv);
+
+            auto events = TRY_OR_FAIL(streaming_events(input));
+            Vector<DeprecatedString> expected { "[", DeprecatedString::formatted("string {}", expected_string.string_view()), "string {,}", "number 1", "]" };
+            EXPECT_EQ(events, expected);
+        }
+    }
+}
+
+TEST_CASE(streaming_parser_matches_json_parser)
+{
+    StringBuilder builder;
+    builder.append('[');
+    for (size_t i = 0; i < 100; ++i) {
+        if (i > 0)
+            builder.append(',');
+        builder.appendff(R"({{"pid": {}, "name": "process\t{}", "nested": [{}, {}.5, true, null, "\u00e9"]}})", i, i, -static_cast<i64>(i), i);
+    }
+    builder.append(']');
+
+    auto input = builder.string_view();
+    auto events = TRY_OR_FAIL(streaming_events(input));
+
+    // Replay the tree built by JsonParser as events.
+    Vector<DeprecatedString> expected;
+    Function<void(JsonValue const&)> replay = [&](JsonValue const& value) {
+        if (value.is_array()) {
+            expected.append("["sv);
+            value.as_array().for_each([&](auto const& element) { replay(element); });
+            expected.append("]"sv);
+        } else if (value.is_object()) {
+            expected.append("{"sv);
+            value.as_object().for_each_member([&](auto const& key, auto const& member) {
+                expected.append(DeprecatedString::formatted("key {}", key));
+                replay(member);
+            });
+            expected.append("}"sv);
+        } else if (value.is_string()) {
+            expected.append(DeprecatedString::formatted("string {}", value.as_string()));
+        } else if (value.is_number()) {
+            expected.append(DeprecatedString::formatted("number {}", value.to_deprecated_string()));
+        } else if (value.is_bool()) {
+            expected.append(DeprecatedString::formatted("boolean {}", value.as_bool()));
+        } else {
+            expected.append("null"sv);
+        }
+    };
+    replay(TRY_OR_FAIL(JsonValue::from_string(input)));
+
+    EXPECT_EQ(events, expected);
+}
+
+TEST_CASE(streaming_parser_errors)
+{
+    auto fails = [](StringView input) {
+        return streaming_events(input).is_error();
+    };
+
+    EXPECT(fails(""sv));
+    EXPECT(fails("   "sv));
+    EXPECT(fails("[1, 2,]"sv));
+    EXPECT(fails("{\"a\": 1,}"sv));
+    EXPECT(fails("[1 2]"sv));
+    EXPECT(fails("{\"a\" 1}"sv));
+    EXPECT(fails("{1: 1}"sv));
+    EXPECT(fails("[1]]"sv));
+    EXPECT(fails("[[1]"sv));
+    EXPECT(fails("{\"a\": 1"sv));
+    EXPECT(fails("\"unterminated"sv));
+    EXPECT(fails("[\"escaped quote\\\"]"sv));
+    EXPECT(fails("[\"control\ncharacter\"]"sv));
+    EXPECT(fails("[\"bad escape \\q\"]"sv));
+    EXPECT(fails("[\"short \\u12\"]"sv));
+    EXPECT(fails("1 2"sv));
+    EXPECT(fails("true false"sv));
+    EXPECT(fails("[tru]"sv));
+    EXPECT(fails("[nulls]"sv));
+    EXPECT(fails("[12abc]"sv));
+    EXPECT(fails("[01]"sv));
+    EXPECT(fails("[+1]"sv));
+    EXPECT(fails("[1\"a\"]"sv));
+    EXPECT(fails("[\"a\"1]"sv));
+    EXPECT(fails(":"sv));
+
+    EXPECT(!fails(" [ 1 , 2 ] "sv));
+    EXPECT(!fails("\t{\r\n}\n"sv));
+}
+
+static DeprecatedString make_benchmark_document()
+{
+    // Roughly the shape of /sys/kernel/processes with a lot of processes, about 2.4 MB in total.
+    StringBuilder builder;
+    builder.append(R"({"total_time": 123456789, "total_time_kernel": 2345678, "processes": [)"sv);
+    for (size_t i = 0; i < 1200; ++i) {
+        if (i > 0)
+            builder.append(',');
+        builder.appendff(R"({{"pid": {}, "pgid": {}, "pgp": {}, "sid": {}, "uid": 100, "gid": 100, "ppid": 1, "nfds": 12, "kernel": false, )"
+                         R"("name": "Process {}", "executable": "/usr/local/bin/process\/{}", "tty": "/dev/pts/0", "pledge": "", "veil": "", )"
+                         R"("creation_time": 1695000000, "amount_virtual": 123456789, "amount_resident": 23456789, "amount_shared": 345678, )"
+                         R"("amount_dirty_private": 45678, "amount_clean_inode": 5678, "amount_purgeable_volatile": 0, "amount_purgeable_nonvolatile": 0, )"
+                         R"("threads": [)",
+            i, i, i, i, i, i);
+        for (size_t j = 0; j < 4; ++j) {
+            if (j > 0)
+                builder.append(',');
+            builder.appendff(R"({{"tid": {}, "times_scheduled": 4815, "name": "Thread {}", "state": "Running", "time_user": 123456, "time_kernel": 7890, )"
+                             R"("cpu": 0, "priority": 30, "syscall_count": 1234, "inode_faults": 0, "zero_faults": 12, "cow_faults": 3, )"
+                             R"("unix_socket_read_bytes": 0, "unix_socket_write_bytes": 0, "ipv4_socket_read_bytes": 0, "ipv4_socket_write_bytes": 0, )"
+                             R"("file_read_bytes": 4096, "file_write_bytes": 0}})",
+                i * 4 + j, j);
+        }
+        builder.append("]}"sv);
+    }
+    builder.append("]}"sv);
+    return builder.to_deprecated_string();
+}
+
+BENCHMARK_CASE(json_parser_processes)
+{
+    auto document = make_benchmark_document();
+    for (size_t i = 0; i < 10; ++i) {
+        auto value = TRY_OR_FAIL(JsonValue::from_string(document));
+        EXPECT(value.is_object());
+    }
+}
+
+BENCHMARK_CASE(json_streaming_parser_processes)
+{
+    auto document = make_benchmark_document();
+    JsonStreamingParser::Visitor visitor;
+    for (size_t i = 0; i < 10; ++i)
+        TRY_OR_FAIL(JsonStreamingParser { document }.parse(visitor));
+}
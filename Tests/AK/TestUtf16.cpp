@@ -8,6 +8,7 @@
 
 #include <AK/Array.h>
 #include <AK/String.h>
+#include <AK/StringBuilder.h>
 #include <AK/StringView.h>
 #include <AK/Types.h>
 #include <AK/Utf16View.h>
@@ -280,3 +281,90 @@ TEST_CASE(substring_view)
         EXPECT_EQ(MUST(view.to_utf8(Utf16View::AllowInvalidCodeUnits::No)), "\ufffd"sv);
     }
 }
+
+TEST_CASE(transcode_long_strings)
+{
+    // Long enough to go through the chunked ASCII paths, with code points of every length straddling the chunks.
+    auto utf8_string = "The quick brown fox, Привет мир! 😀 jumps over the lazy dog γειά σου κόσμος こんにちは世界 😀😀 and so on"_string;
+    StringBuilder builder;
+    for (size_t i = 0; i < 17; ++i) {
+        builder.append(utf8_string);
+        builder.append('x');
+    }
+    auto long_utf8_string = MUST(builder.to_string());
+
+    auto string = MUST(AK::utf8_to_utf16(long_utf8_string));
+    Utf16View view { string };
+
+    size_t valid_code_units = 0;
+    EXPECT(view.validate(valid_code_units));
+    EXPECT_EQ(valid_code_units, view.length_in_code_units());
+    EXPECT_EQ(view.length_in_code_points(), long_utf8_string.code_points().length());
+
+    size_t i = 0;
+    for (auto code_point : long_utf8_string.code_points())
+        EXPECT_EQ(code_point, view.code_point_at(view.code_unit_offset_of(i++)));
+
+    EXPECT_EQ(MUST(view.to_utf8(Utf16View::AllowInvalidCodeUnits::Yes)), long_utf8_string);
+    EXPECT_EQ(MUST(view.to_utf8(Utf16View::AllowInvalidCodeUnits::No)), long_utf8_string);
+}
+
+TEST_CASE(transcode_invalid_utf8)
+{
+    // Invalid bytes are replaced with U+FFFD, just like when iterating over the code points.
+    auto string = MUST(AK::utf8_to_utf16("abcdefghijklmnop\xc3qrstuvwxyz\xe2\x82"sv));
+    Utf16View view { string };
+    EXPECT_EQ(MUST(view.to_utf8()), "abcdefghijklmnop�qrstuvwxyz��"sv);
+}
+
+TEST_CASE(encode_long_utf8_with_unpaired_surrogates)
+{
+    Vector<u16> encoded;
+    for (u16 code_unit : "abcdefghijklmnop"sv)
+        encoded.append(code_unit);
+    encoded.append(0xd83d);
+    for (u16 code_unit : "abcdefghijklmnop"sv)
+        encoded.append(code_unit);
+    encoded.append(0xde00);
+
+    Utf16View view { encoded };
+    EXPECT_EQ(MUST(view.to_utf8(Utf16View::AllowInvalidCodeUnits::Yes)), "abcdefghijklmnop\xed\xa0\xbd"
+                                                                         "abcdefghijklmnop\xed\xb8\x80"sv);
+    EXPECT_EQ(MUST(view.to_utf8(Utf16View::AllowInvalidCodeUnits::No)), "abcdefghijklmnop�abcdefghijklmnop�"sv);
+}
+
+static String make_benchmark_text(StringView text)
+{
+    StringBuilder builder;
+    while (builder.length() < 1 * MiB)
+        builder.append(text);
+    return MUST(builder.to_string());
+}
+
+BENCHMARK_CASE(utf8_to_utf16_ascii)
+{
+    auto text = make_benchmark_text("The quick brown fox jumps over the lazy dog. "sv);
+    for (size_t i = 0; i < 100; ++i)
+        (void)MUST(AK::utf8_to_utf16(text));
+}
+
+BENCHMARK_CASE(utf8_to_utf16_mixed)
+{
+    auto text = make_benchmark_text("Привет, мир! 😀 γειά σου κόσμος こんにちは世界 "sv);
+    for (size_t i = 0; i < 100; ++i)
+        (void)MUST(AK::utf8_to_utf16(text));
+}
+
+BENCHMARK_CASE(utf16_to_utf8_ascii)
+{
+    auto text = MUST(AK::utf8_to_utf16(make_benchmark_text("The quick brown fox jumps over the lazy dog. "sv)));
+    for (size_t i = 0; i < 100; ++i)
+        (void)MUST(Utf16View { text }.to_utf8());
+}
+
+BENCHMARK_CASE(utf16_to_utf8_mixed)
+{
+    auto text = MUST(AK::utf8_to_utf16(make_benchmark_text("Привет, мир! 😀 γειά σου κόσμος こんにちは世界 "sv)));
+    for (size_t i = 0; i < 100; ++i)
+        (void)MUST(Utf16View { text }.to_utf8());
+}
@@ -6,6 +6,7 @@
 
 #include <LibTest/TestCase.h>
 
+#include <AK/Array.h>
 #include <AK/ByteBuffer.h>
 #include <AK/Utf8View.h>
 
@@ -295,3 +296,82 @@ TEST_CASE(trim)
         EXPECT_EQ(view.trim(whitespace, TrimMode::Right).as_string(), "\u180E");
     }
 }
+
+TEST_CASE(validate_across_chunk_boundaries)
+{
+    // Long inputs are validated in chunks, so move every kind of sequence across the chunk boundaries.
+    auto valid_sequences = Array {
+        "\xc3\xa9"sv,         // U+00E9
+        "\xe2\x82\xac"sv,     // U+20AC
+        "\xed\xa0\xbd"sv,     // U+D83D, a lone surrogate
+        "\xef\xbf\xbf"sv,     // U+FFFF
+        "\xf0\x9f\x98\x80"sv, // U+1F600
+        "\xf4\x8f\xbf\xbf"sv, // U+10FFFF
+    };
+    auto invalid_sequences = Array {
+        "\x80"sv,
+        "\xc3"sv,
+        "\xc0\xaf"sv,
+        "\xe0\x80\xaf"sv,
+        "\xe2\x82"sv,
+        "\xf0\x80\x80\xaf"sv,
+        "\xf0\x9f\x98"sv,
+        "\xf4\x90\x80\x80"sv,
+        "\xf8\x88\x80\x80\x80"sv,
+        "\xff"sv,
+    };
+
+    for (size_t prefix_length = 0; prefix_length < 40; ++prefix_length) {
+        for (size_t suffix_length : { 0, 1, 5, 20 }) {
+            for (auto sequence : valid_sequences) {
+                ByteBuffer buffer;
+                buffer.append(ByteBuffer::create_zeroed(prefix_length).release_value());
+                buffer.append(sequence.bytes());
+                buffer.append(ByteBuffer::create_zeroed(suffix_length).release_value());
+
+                size_t valid_bytes = 0;
+                EXPECT(Utf8View { StringView { buffer } }.validate(valid_bytes));
+                EXPECT_EQ(valid_bytes, buffer.size());
+            }
+
+            for (auto sequence : invalid_sequences) {
+                ByteBuffer buffer;
+                buffer.append(ByteBuffer::create_zeroed(prefix_length).release_value());
+                buffer.append(sequence.bytes());
+                buffer.append(ByteBuffer::create_zeroed(suffix_length).release_value());
+
+                size_t valid_bytes = 0;
+                EXPECT(!Utf8View { StringView { buffer } }.validate(valid_bytes));
+                EXPECT_EQ(valid_bytes, prefix_length);
+            }
+        }
+    }
+}
+
+TEST_CASE(validate_in_constant_expression)
+{
+    static_assert(Utf8View { "Привет, мир! 😀 γειά σου κόσμος こんにちは世界"sv }.validate());
+    static_assert(!Utf8View { "Привет, мир! 😀 γειά σου κόσμος \xe3\x81"sv }.validate());
+}
+
+static ByteBuffer make_benchmark_text(StringView text)
+{
+    ByteBuffer buffer;
+    while (buffer.size() < 1 * MiB)
+        buffer.append(text.bytes());
+    return buffer;
+}
+
+BENCHMARK_CASE(validate_ascii)
+{
+    auto buffer = make_benchmark_text("The quick brown fox jumps over the lazy dog. "sv);
+    for (size_t i = 0; i < 100; ++i)
+        EXPECT(Utf8View { StringView { buffer } }.validate());
+}
+
+BENCHMARK_CASE(validate_mixed)
+{
+    auto buffer = make_benchmark_text("Привет, мир! 😀 γειά σου κόσμος こんにちは世界 "sv);
+    for (size_t i = 0; i < 100; ++i)
+        EXPECT(Utf8View { StringView { buffer } }.validate());
+}
@@ -0,0 +1,18 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/JsonValue.h>
+#include <AK/StringView.h>
+#include <LibCore/File.h>
+
+// Reads one of the files in /sys that the kernel fills with JSON, like /sys/kernel/memstat.
+inline JsonValue read_sysfs_json(StringView path)
+{
+    auto file = MUST(Core::File::open(path, Core::File::OpenMode::Read));
+    return MUST(JsonValue::from_string(MUST(file->read_until_eof())));
+}
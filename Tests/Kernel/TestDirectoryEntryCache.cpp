@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include "SysFS.h"
+#include <AK/JsonObject.h>
+#include <AK/String.h>
+#include <LibCore/System.h>
+#include <LibTest/TestCase.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+static JsonObject read_cache_statistics()
+{
+    return read_sysfs_json("/sys/kernel/directory_entry_cache"sv).as_object();
+}
+
+static void expect_does_not_exist(StringView path)
+{
+    auto result = Core::System::stat(path);
+    EXPECT(result.is_error());
+    if (result.is_error())
+        EXPECT_EQ(result.error().code(), ENOENT);
+}
+
+static void create_file(StringView path)
+{
+    auto fd = MUST(Core::System::open(path, O_CREAT | O_EXCL | O_WRONLY, 0644));
+    MUST(Core::System::close(fd));
+}
+
+TEST_CASE(negative_entries_go_away_when_the_name_is_created)
+{
+    MUST(Core::System::mkdir("/tmp/dentry-cache-test"sv, 0755));
+
+    // Look the name up twice, so the second time is answered by the cache.
+    expect_does_not_exist("/tmp/dentry-cache-test/file"sv);
+    expect_does_not_exist("/tmp/dentry-cache-test/file"sv);
+
+    create_file("/tmp/dentry-cache-test/file"sv);
+    EXPECT(!Core::System::stat("/tmp/dentry-cache-test/file"sv).is_error());
+
+    MUST(Core::System::rename("/tmp/dentry-cache-test/file"sv, "/tmp/dentry-cache-test/renamed"sv));
+    expect_does_not_exist("/tmp/dentry-cache-test/file"sv);
+    EXPECT(!Core::System::stat("/tmp/dentry-cache-test/renamed"sv).is_error());
+
+    MUST(Core::System::unlink("/tmp/dentry-cache-test/renamed"sv));
+    expect_does_not_exist("/tmp/dentry-cache-test/renamed"sv);
+
+    MUST(Core::System::rmdir("/tmp/dentry-cache-test"sv));
+    expect_does_not_exist("/tmp/dentry-cache-test/renamed"sv);
+}
+
+TEST_CASE(renaming_over_a_name_is_seen)
+{
+    MUST(Core::System::mkdir("/tmp/dentry-cache-replace"sv, 0755));
+    create_file("/tmp/dentry-cache-replace/old"sv);
+    create_file("/tmp/dentry-cache-replace/new"sv);
+
+    auto old_inode = MUST(Core::System::stat("/tmp/dentry-cache-replace/old"sv)).st_ino;
+    auto new_inode = MUST(Core::System::stat("/tmp/dentry-cache-replace/new"sv)).st_ino;
+    EXPECT_NE(old_inode, new_inode);
+
+    MUST(Core::System::rename("/tmp/dentry-cache-replace/new"sv, "/tmp/dentry-cache-replace/old"sv));
+    EXPECT_EQ(MUST(Core::System::stat("/tmp/dentry-cache-replace/old"sv)).st_ino, new_inode);
+    expect_does_not_exist("/tmp/dentry-cache-replace/new"sv);
+
+    MUST(Core::System::unlink("/tmp/dentry-cache-replace/old"sv));
+    MUST(Core::System::rmdir("/tmp/dentry-cache-replace"sv));
+}
+
+TEST_CASE(repeated_lookups_are_cache_hits)
+{
+    MUST(Core::System::mkdir("/tmp/dentry-cache-hits"sv, 0755));
+    create_file("/tmp/dentry-cache-hits/file"sv);
+    (void)MUST(Core::System::stat("/tmp/dentry-cache-hits/file"sv));
+
+    auto hits_before = read_cache_statistics().get_u64("hits"sv).value_or(0);
+    for (size_t i = 0; i < 100; ++i)
+        (void)MUST(Core::System::stat("/tmp/dentry-cache-hits/file"sv));
+    auto statistics = read_cache_statistics();
+    EXPECT(statistics.get_u64("hits"sv).value_or(0) >= hits_before + 100);
+    EXPECT(statistics.get_u64("entries"sv).value_or(0) <= statistics.get_u64("capacity"sv).value_or(0));
+
+    MUST(Core::System::unlink("/tmp/dentry-cache-hits/file"sv));
+    MUST(Core::System::rmdir("/tmp/dentry-cache-hits"sv));
+}
+
+BENCHMARK_CASE(stat_many_files)
+{
+    static constexpr size_t file_count = 1000;
+
+    MUST(Core::System::mkdir("/tmp/dentry-cache-benchmark"sv, 0755));
+    Vector<String> paths;
+    for (size_t i = 0; i < file_count; ++i) {
+        auto path = MUST(String::formatted("/tmp/dentry-cache-benchmark/header-{}.h", i));
+        create_file(path);
+        paths.append(move(path));
+    }
+
+    // This is what a compiler does while looking for headers: most lookups are of names that don't exist.
+    for (size_t round = 0; round < 100; ++round) {
+        for (auto& path : paths) {
+            (void)MUST(Core::System::stat(path));
+            EXPECT(Core::System::stat("/tmp/dentry-cache-benchmark/missing.h"sv).is_error());
+        }
+    }
+
+    for (auto& path : paths)
+        MUST(Core::System::unlink(path));
+    MUST(Core::System::rmdir("/tmp/dentry-cache-benchmark"sv));
+}
@@ -4,8 +4,12 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/ScopeGuard.h>
+#include <AK/Vector.h>
 #include <LibTest/TestCase.h>
 #include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 TEST_CASE(test_uid_and_gid_high_bits_are_set)
@@ -29,3 +33,193 @@ TEST_CASE(test_uid_and_gid_high_bits_are_set)
     EXPECT_EQ(st.st_uid, 65536u);
     EXPECT_EQ(st.st_gid, 65536u);
 }
+
+static size_t count_extents(int fd)
+{
+    struct stat st;
+    VERIFY(fstat(fd, &st) == 0);
+    size_t extent_count = 0;
+    int previous_block = 0;
+    for (off_t logical_block = 0; logical_block * st.st_blksize < st.st_size; ++logical_block) {
+        int block = static_cast<int>(logical_block);
+        VERIFY(ioctl(fd, FIBMAP, &block) == 0);
+        if (block != previous_block + 1)
+            ++extent_count;
+        previous_block = block;
+    }
+    return extent_count;
+}
+
+static void write_pattern(int fd, size_t size, u8 seed)
+{
+    Vector<u8> buffer;
+    buffer.resize(64 * KiB);
+    for (size_t offset = 0; offset < size; offset += buffer.size()) {
+        for (size_t i = 0; i < buffer.size(); ++i)
+            buffer[i] = static_cast<u8>(seed + (offset + i) / 4096);
+        VERIFY(write(fd, buffer.data(), buffer.size()) == static_cast<ssize_t>(buffer.size()));
+    }
+}
+
+TEST_CASE(interleaved_appends_stay_contiguous)
+{
+    static constexpr auto FIRST_PATH = "/home/anon/.ext2_interleaved_1";
+    static constexpr auto SECOND_PATH = "/home/anon/.ext2_interleaved_2";
+
+    auto first_fd = open(FIRST_PATH, O_CREAT | O_TRUNC | O_RDWR, 0600);
+    auto second_fd = open(SECOND_PATH, O_CREAT | O_TRUNC | O_RDWR, 0600);
+    auto cleanup_guard = ScopeGuard([&] {
+        close(first_fd);
+        close(second_fd);
+        unlink(FIRST_PATH);
+        unlink(SECOND_PATH);
+    });
+    VERIFY(first_fd >= 0 && second_fd >= 0);
+
+    // Growing both files a little at a time used to interleave their blocks.
+    u8 buffer[4096] {};
+    for (size_t i = 0; i < 512; ++i) {
+        EXPECT_EQ(write(first_fd, buffer, sizeof(buffer)), static_cast<ssize_t>(sizeof(buffer)));
+        EXPECT_EQ(write(second_fd, buffer, sizeof(buffer)), static_cast<ssize_t>(sizeof(buffer)));
+    }
+
+    // Every time a file uses up its preallocation window it may have to start a new run elsewhere,
+    // but the windows grow quickly, so that shouldn't happen often.
+    EXPECT(count_extents(first_fd) <= 16);
+    EXPECT(count_extents(second_fd) <= 16);
+}
+
+TEST_CASE(new_space_reads_as_zeroes)
+{
+    static constexpr auto TEST_FILE_PATH = "/home/anon/.ext2_zero_fill";
+
+    auto fd = open(TEST_FILE_PATH, O_CREAT | O_TRUNC | O_RDWR, 0600);
+    auto cleanup_guard = ScopeGuard([&] {
+        close(fd);
+        unlink(TEST_FILE_PATH);
+    });
+    VERIFY(fd >= 0);
+
+    // Fill some blocks with junk and free them again, so there's something for the file to reuse.
+    write_pattern(fd, 1 * MiB, 0xaa);
+    EXPECT_EQ(ftruncate(fd, 100), 0);
+
+    // Grow the file by writing past its end, and by extending it.
+    EXPECT_EQ(pwrite(fd, "x", 1, 300 * KiB), 1);
+    EXPECT_EQ(posix_fallocate(fd, 0, 600 * KiB), 0);
+
+    Vector<u8> contents;
+    contents.resize(600 * KiB);
+    EXPECT_EQ(pread(fd, contents.data(), contents.size(), 0), static_cast<ssize_t>(contents.size()));
+    for (size_t i = 100; i < contents.size(); ++i) {
+        if (i == 300 * KiB) {
+            EXPECT_EQ(contents[i], 'x');
+            continue;
+        }
+        if (contents[i] != 0) {
+            FAIL(DeprecatedString::formatted("Byte {} is {:#x}, not zero", i, contents[i]));
+            break;
+        }
+    }
+}
+
+TEST_CASE(fallocate_allocates_contiguously)
+{
+    static constexpr auto TEST_FILE_PATH = "/home/anon/.ext2_fallocate";
+
+    auto fd = open(TEST_FILE_PATH, O_CREAT | O_TRUNC | O_RDWR, 0600);
+    auto cleanup_guard = ScopeGuard([&] {
+        close(fd);
+        unlink(TEST_FILE_PATH);
+    });
+    VERIFY(fd >= 0);
+
+    EXPECT_EQ(posix_fallocate(fd, 0, 16 * MiB), 0);
+    // The indirect blocks may end up between the data blocks, but nothing else should.
+    EXPECT(count_extents(fd) <= 8);
+}
+
+TEST_CASE(file_larger_than_initial_block_cache_reads_back)
+{
+    static constexpr auto TEST_FILE_PATH = "/home/anon/.ext2_block_cache";
+    // The block cache starts out small and has to grow, and then evict blocks, to hold all of this.
+    static constexpr size_t file_size = 48 * MiB;
+
+    auto fd = open(TEST_FILE_PATH, O_CREAT | O_TRUNC | O_RDWR, 0600);
+    auto cleanup_guard = ScopeGuard([&] {
+        close(fd);
+        unlink(TEST_FILE_PATH);
+    });
+    VERIFY(fd >= 0);
+
+    write_pattern(fd, file_size, 0x11);
+    EXPECT_EQ(fsync(fd), 0);
+
+    Vector<u8> buffer;
+    buffer.resize(64 * KiB);
+    for (size_t offset = 0; offset < file_size; offset += buffer.size()) {
+        EXPECT_EQ(pread(fd, buffer.data(), buffer.size(), offset), static_cast<ssize_t>(buffer.size()));
+        for (size_t i = 0; i < buffer.size(); i += 4096) {
+            auto expected = static_cast<u8>(0x11 + (offset + i) / 4096);
+            if (buffer[i] != expected || buffer[i + 4095] != expected) {
+                FAIL(DeprecatedString::formatted("Block at {} doesn't have the contents that were written", offset + i));
+                return;
+            }
+        }
+    }
+}
+
+static constexpr size_t large_file_size = 64 * MiB;
+
+BENCHMARK_CASE(create_large_file)
+{
+    static constexpr auto TEST_FILE_PATH = "/home/anon/.ext2_large_file";
+
+    auto fd = open(TEST_FILE_PATH, O_CREAT | O_TRUNC | O_RDWR, 0600);
+    auto cleanup_guard = ScopeGuard([&] {
+        close(fd);
+        unlink(TEST_FILE_PATH);
+    });
+    VERIFY(fd >= 0);
+
+    write_pattern(fd, large_file_size, 0);
+    EXPECT_EQ(fsync(fd), 0);
+}
+
+BENCHMARK_CASE(create_two_large_files_at_once)
+{
+    static constexpr auto FIRST_PATH = "/home/anon/.ext2_large_file_1";
+    static constexpr auto SECOND_PATH = "/home/anon/.ext2_large_file_2";
+
+    auto first_fd = open(FIRST_PATH, O_CREAT | O_TRUNC | O_RDWR, 0600);
+    auto second_fd = open(SECOND_PATH, O_CREAT | O_TRUNC | O_RDWR, 0600);
+    auto cleanup_guard = ScopeGuard([&] {
+        close(first_fd);
+        close(second_fd);
+        unlink(FIRST_PATH);
+        unlink(SECOND_PATH);
+    });
+    VERIFY(first_fd >= 0 && second_fd >= 0);
+
+    for (size_t offset = 0; offset < large_file_size / 2; offset += 1 * MiB) {
+        write_pattern(first_fd, 1 * MiB, 0);
+        write_pattern(second_fd, 1 * MiB, 1);
+    }
+    EXPECT_EQ(fsync(first_fd), 0);
+    EXPECT_EQ(fsync(second_fd), 0);
+}
+
+BENCHMARK_CASE(fallocate_large_file)
+{
+    static constexpr auto TEST_FILE_PATH = "/home/anon/.ext2_fallocate_large_file";
+
+    auto fd = open(TEST_FILE_PATH, O_CREAT | O_TRUNC | O_RDWR, 0600);
+    auto cleanup_guard = ScopeGuard([&] {
+        close(fd);
+        unlink(TEST_FILE_PATH);
+    });
+    VERIFY(fd >= 0);
+
+    EXPECT_EQ(posix_fallocate(fd, 0, large_file_size), 0);
+    EXPECT_EQ(fsync(fd), 0);
+}
@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <LibCore/System.h>
+#include <LibTest/TestCase.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static constexpr size_t region_size = 16 * MiB;
+
+static u8 expected_byte_at(size_t offset)
+{
+    return static_cast<u8>((offset * 7) ^ (offset >> 12));
+}
+
+static u8* map_filled_region(size_t size)
+{
+    auto* data = static_cast<u8*>(MUST(Core::System::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, 0, 0)));
+    for (size_t i = 0; i < size; ++i)
+        data[i] = expected_byte_at(i);
+    return data;
+}
+
+// Runs `child` in a forked process, and returns its exit status.
+template<typename Callback>
+static int run_in_child(Callback child)
+{
+    auto pid = MUST(Core::System::fork());
+    if (pid == 0)
+        _exit(child());
+    auto result = MUST(Core::System::waitpid(pid));
+    VERIFY(WIFEXITED(result.status));
+    return WEXITSTATUS(result.status);
+}
+
+TEST_CASE(child_sees_memory_of_parent)
+{
+    auto* data = map_filled_region(region_size);
+    auto status = run_in_child([&] {
+        // Only look at every page, so that most of the region's page tables are never filled in.
+        for (size_t i = 0; i < region_size; i += PAGE_SIZE) {
+            if (data[i] != expected_byte_at(i))
+                return 1;
+        }
+        return 0;
+    });
+    EXPECT_EQ(status, 0);
+    MUST(Core::System::munmap(data, region_size));
+}
+
+TEST_CASE(writes_in_child_are_private)
+{
+    auto* data = map_filled_region(region_size);
+    auto status = run_in_child([&] {
+        for (size_t i = 0; i < region_size; i += PAGE_SIZE)
+            data[i] = ~expected_byte_at(i);
+        for (size_t i = 0; i < region_size; i += PAGE_SIZE) {
+            if (data[i] != static_cast<u8>(~expected_byte_at(i)))
+                return 1;
+        }
+        return 0;
+    });
+    EXPECT_EQ(status, 0);
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < region_size; ++i) {
+        if (data[i] != expected_byte_at(i))
+            ++mismatches;
+    }
+    EXPECT_EQ(mismatches, 0u);
+    MUST(Core::System::munmap(data, region_size));
+}
+
+TEST_CASE(writes_in_parent_after_fork_are_private)
+{
+    auto* data = map_filled_region(region_size);
+    auto pipe_fds = MUST(Core::System::pipe2(0));
+
+    auto pid = MUST(Core::System::fork());
+    if (pid == 0) {
+        // Wait for the parent to be done writing before looking at anything.
+        u8 byte;
+        MUST(Core::System::read(pipe_fds[0], { &byte, 1 }));
+        for (size_t i = 0; i < region_size; i += PAGE_SIZE) {
+            if (data[i] != expected_byte_at(i))
+                _exit(1);
+        }
+        _exit(0);
+    }
+
+    for (size_t i = 0; i < region_size; i += PAGE_SIZE)
+        data[i] = ~expected_byte_at(i);
+    MUST(Core::System::write(pipe_fds[1], "x"sv.bytes()));
+
+    auto result = MUST(Core::System::waitpid(pid));
+    EXPECT(WIFEXITED(result.status));
+    EXPECT_EQ(WEXITSTATUS(result.status), 0);
+
+    MUST(Core::System::close(pipe_fds[0]));
+    MUST(Core::System::close(pipe_fds[1]));
+    MUST(Core::System::munmap(data, region_size));
+}
+
+TEST_CASE(untouched_memory_is_zeroed_in_child)
+{
+    auto* data = static_cast<u8*>(MUST(Core::System::mmap(nullptr, region_size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, 0, 0)));
+    auto status = run_in_child([&] {
+        for (size_t i = 0; i < region_size; i += PAGE_SIZE) {
+            if (data[i] != 0)
+                return 1;
+            data[i] = 1;
+        }
+        return 0;
+    });
+    EXPECT_EQ(status, 0);
+    EXPECT_EQ(data[0], 0);
+    MUST(Core::System::munmap(data, region_size));
+}
+
+TEST_CASE(shared_memory_stays_shared)
+{
+    auto* data = static_cast<u8*>(MUST(Core::System::mmap(nullptr, region_size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_SHARED, 0, 0)));
+    auto status = run_in_child([&] {
+        for (size_t i = 0; i < region_size; i += PAGE_SIZE)
+            data[i] = expected_byte_at(i);
+        return 0;
+    });
+    EXPECT_EQ(status, 0);
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < region_size; i += PAGE_SIZE) {
+        if (data[i] != expected_byte_at(i))
+            ++mismatches;
+    }
+    EXPECT_EQ(mismatches, 0u);
+    MUST(Core::System::munmap(data, region_size));
+}
+
+TEST_CASE(posix_spawn_with_redirected_output)
+{
+    auto pipe_fds = MUST(Core::System::pipe2(O_CLOEXEC));
+    posix_spawn_file_actions_t file_actions;
+    posix_spawn_file_actions_init(&file_actions);
+    posix_spawn_file_actions_adddup2(&file_actions, pipe_fds[1], STDOUT_FILENO);
+
+    pid_t pid;
+    char const* argv[] = { "/bin/echo", "hello", nullptr };
+    EXPECT_EQ(posix_spawn(&pid, argv[0], &file_actions, nullptr, const_cast<char**>(argv), environ), 0);
+    posix_spawn_file_actions_destroy(&file_actions);
+    MUST(Core::System::close(pipe_fds[1]));
+
+    u8 buffer[16] {};
+    size_t nread = 0;
+    while (nread < sizeof(buffer)) {
+        auto n = MUST(Core::System::read(pipe_fds[0], { buffer + nread, sizeof(buffer) - nread }));
+        if (n == 0)
+            break;
+        nread += n;
+    }
+    EXPECT_EQ(StringView(buffer, nread), "hello\n"sv);
+    MUST(Core::System::close(pipe_fds[0]));
+
+    auto result = MUST(Core::System::waitpid(pid));
+    EXPECT(WIFEXITED(result.status));
+    EXPECT_EQ(WEXITSTATUS(result.status), 0);
+}
+
+TEST_CASE(posix_spawnp_searches_path)
+{
+    pid_t pid;
+    char const* argv[] = { "false", nullptr };
+    EXPECT_EQ(posix_spawnp(&pid, argv[0], nullptr, nullptr, const_cast<char**>(argv), environ), 0);
+    auto result = MUST(Core::System::waitpid(pid));
+    EXPECT(WIFEXITED(result.status));
+    EXPECT_EQ(WEXITSTATUS(result.status), 1);
+}
+
+TEST_CASE(posix_spawn_of_missing_program_fails_in_the_child)
+{
+    // The exec happens in the forked child, so all we get to see is the child exiting with 127.
+    pid_t pid;
+    char const* argv[] = { "/bin/does-not-exist", nullptr };
+    EXPECT_EQ(posix_spawn(&pid, argv[0], nullptr, nullptr, const_cast<char**>(argv), environ), 0);
+    auto result = MUST(Core::System::waitpid(pid));
+    EXPECT(WIFEXITED(result.status));
+    EXPECT_EQ(WEXITSTATUS(result.status), 127);
+}
+
+static constexpr size_t spawn_count = 200;
+
+BENCHMARK_CASE(fork_with_large_address_space)
+{
+    auto* data = map_filled_region(4 * region_size);
+    for (size_t i = 0; i < spawn_count; ++i)
+        EXPECT_EQ(run_in_child([] { return 0; }), 0);
+    MUST(Core::System::munmap(data, 4 * region_size));
+}
+
+BENCHMARK_CASE(posix_spawn_latency)
+{
+    auto* data = map_filled_region(4 * region_size);
+    char const* argv[] = { "/bin/true", nullptr };
+    for (size_t i = 0; i < spawn_count; ++i) {
+        pid_t pid;
+        EXPECT_EQ(posix_spawn(&pid, argv[0], nullptr, nullptr, const_cast<char**>(argv), environ), 0);
+        auto result = MUST(Core::System::waitpid(pid));
+        EXPECT(WIFEXITED(result.status));
+    }
+    MUST(Core::System::munmap(data, 4 * region_size));
+}
@@ -0,0 +1,390 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Array.h>
+#include <LibCore/EventLoop.h>
+#include <LibCore/IORing.h>
+#include <LibCore/System.h>
+#include <LibTest/TestCase.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static int create_listener(sockaddr_in& address, int backlog = 1)
+{
+    auto listener = MUST(Core::System::socket(AF_INET, SOCK_STREAM, 0));
+    address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+    MUST(Core::System::bind(listener, reinterpret_cast<sockaddr const*>(&address), sizeof(address)));
+    MUST(Core::System::listen(listener, backlog));
+
+    socklen_t address_size = sizeof(address);
+    MUST(Core::System::getsockname(listener, reinterpret_cast<sockaddr*>(&address), &address_size));
+    return listener;
+}
+
+TEST_CASE(nop)
+{
+    Core::EventLoop loop;
+    auto ring = MUST(Core::IORing::create(8));
+
+    size_t completed = 0;
+    for (size_t i = 0; i < 4; ++i) {
+        MUST(ring->nop([&](auto result) {
+            EXPECT(!result.is_error());
+            ++completed;
+        }));
+    }
+    MUST(ring->wait_for_completions(4));
+    EXPECT_EQ(completed, 4u);
+    EXPECT_EQ(ring->pending_request_count(), 0u);
+}
+
+TEST_CASE(file_read_and_write)
+{
+    Core::EventLoop loop;
+    auto ring = MUST(Core::IORing::create(8));
+
+    auto fd = MUST(Core::System::open("/tmp/io-ring-test"sv, O_CREAT | O_TRUNC | O_RDWR, 0600));
+    MUST(Core::System::unlink("/tmp/io-ring-test"sv));
+
+    auto data = "Well hello friends!"sv;
+    MUST(ring->write(fd, data.bytes(), 4, [&](auto result) {
+        EXPECT_EQ(result.release_value(), data.length());
+    }));
+    MUST(ring->fsync(fd, [&](auto result) {
+        EXPECT(!result.is_error());
+    }));
+    MUST(ring->wait_for_completions(2));
+
+    // A write at an explicit offset doesn't move the offset of the file description.
+    EXPECT_EQ(MUST(Core::System::lseek(fd, 0, SEEK_CUR)), 0);
+
+    Array<u8, 32> buffer {};
+    MUST(ring->read(fd, buffer.span(), 4, [&](auto result) {
+        EXPECT_EQ(result.release_value(), data.length());
+    }));
+    MUST(ring->wait_for_completions());
+    EXPECT_EQ(StringView(buffer.span().trim(data.length())), data);
+
+    // Without an offset, the offset of the file description is used and advanced.
+    MUST(ring->read(fd, buffer.span(), {}, [&](auto result) {
+        EXPECT_EQ(result.release_value(), data.length() + 4);
+    }));
+    MUST(ring->wait_for_completions());
+    EXPECT_EQ(MUST(Core::System::lseek(fd, 0, SEEK_CUR)), static_cast<off_t>(data.length() + 4));
+
+    MUST(Core::System::close(fd));
+}
+
+TEST_CASE(read_from_pipe_waits_for_data)
+{
+    Core::EventLoop loop;
+    auto ring = MUST(Core::IORing::create(8));
+    auto pipe_fds = MUST(Core::System::pipe2(0));
+
+    Array<u8, 16> buffer {};
+    Optional<size_t> nread;
+    MUST(ring->read(pipe_fds[0], buffer.span(), {}, [&](auto result) {
+        nread = result.release_value();
+    }));
+    MUST(ring->submit());
+
+    // The read can't complete, as there's nothing in the pipe yet.
+    MUST(ring->nop([](auto) {}));
+    MUST(ring->wait_for_completions(1));
+    EXPECT(!nread.has_value());
+    EXPECT_EQ(ring->pending_request_count(), 1u);
+
+    MUST(Core::System::write(pipe_fds[1], "abc"sv.bytes()));
+    MUST(ring->wait_for_completions(1));
+    EXPECT_EQ(nread, 3u);
+    EXPECT_EQ(StringView(buffer.span().trim(3)), "abc"sv);
+
+    MUST(Core::System::close(pipe_fds[0]));
+    MUST(Core::System::close(pipe_fds[1]));
+}
+
+TEST_CASE(poll_add)
+{
+    Core::EventLoop loop;
+    auto ring = MUST(Core::IORing::create(8));
+    auto pipe_fds = MUST(Core::System::pipe2(0));
+
+    Optional<size_t> events;
+    MUST(ring->poll_add(pipe_fds[0], POLLIN, [&](auto result) {
+        events = result.release_value();
+    }));
+    MUST(ring->nop([](auto) {}));
+    MUST(ring->wait_for_completions(1));
+    EXPECT(!events.has_value());
+
+    MUST(Core::System::write(pipe_fds[1], "x"sv.bytes()));
+    MUST(ring->wait_for_completions(1));
+    EXPECT(events.has_value());
+    EXPECT(events.value() & POLLIN);
+
+    MUST(Core::System::close(pipe_fds[0]));
+    MUST(Core::System::close(pipe_fds[1]));
+}
+
+TEST_CASE(bad_file_descriptor)
+{
+    Core::EventLoop loop;
+    auto ring = MUST(Core::IORing::create(8));
+
+    Array<u8, 4> buffer {};
+    Optional<int> error;
+    MUST(ring->read(-1, buffer.span(), {}, [&](auto result) {
+        error = result.error().code();
+    }));
+    MUST(ring->wait_for_completions(1));
+    EXPECT_EQ(error, EBADF);
+}
+
+TEST_CASE(socket_operations)
+{
+    Core::EventLoop loop;
+    auto ring = MUST(Core::IORing::create(8));
+
+    sockaddr_in address {};
+    auto listener = create_listener(address);
+    auto client = MUST(Core::System::socket(AF_INET, SOCK_STREAM, 0));
+
+    Optional<int> server;
+    MUST(ring->accept(listener, SOCK_CLOEXEC, [&](auto result) {
+        server = static_cast<int>(result.release_value());
+    }));
+    MUST(ring->connect(client, reinterpret_cast<sockaddr const*>(&address), sizeof(address), [&](auto result) {
+        EXPECT(!result.is_error());
+    }));
+    MUST(ring->wait_for_completions(2));
+    VERIFY(server.has_value());
+    EXPECT(MUST(Core::System::fcntl(*server, F_GETFD)) & FD_CLOEXEC);
+
+    Array<u8, 16> buffer {};
+    Optional<size_t> nreceived;
+    MUST(ring->receive(*server, buffer.span(), 0, [&](auto result) {
+        nreceived = result.release_value();
+    }));
+    MUST(ring->send(client, "ping"sv.bytes(), 0, [&](auto result) {
+        EXPECT_EQ(result.release_value(), 4u);
+    }));
+    MUST(ring->wait_for_completions(2));
+    EXPECT_EQ(nreceived, 4u);
+    EXPECT_EQ(StringView(buffer.span().trim(4)), "ping"sv);
+
+    MUST(Core::System::close(*server));
+    MUST(Core::System::close(client));
+    MUST(Core::System::close(listener));
+}
+
+TEST_CASE(accept_on_socket_that_is_not_listening)
+{
+    Core::EventLoop loop;
+    auto ring = MUST(Core::IORing::create(8));
+    auto socket = MUST(Core::System::socket(AF_INET, SOCK_STREAM, 0));
+
+    Optional<int> error;
+    MUST(ring->accept(socket, 0, [&](auto result) {
+        error = result.error().code();
+    }));
+    MUST(ring->wait_for_completions(1));
+    EXPECT_EQ(error, EINVAL);
+
+    MUST(Core::System::close(socket));
+}
+
+TEST_CASE(connect_to_closed_port)
+{
+    Core::EventLoop loop;
+    auto ring = MUST(Core::IORing::create(8));
+
+    // Nobody listens on the port anymore once the listener is closed.
+    sockaddr_in address {};
+    MUST(Core::System::close(create_listener(address)));
+    auto client = MUST(Core::System::socket(AF_INET, SOCK_STREAM, 0));
+
+    Optional<int> error;
+    MUST(ring->connect(client, reinterpret_cast<sockaddr const*>(&address), sizeof(address), [&](auto result) {
+        error = result.error().code();
+    }));
+    MUST(ring->wait_for_completions(1));
+    EXPECT_EQ(error, ECONNREFUSED);
+
+    MUST(Core::System::close(client));
+}
+
+TEST_CASE(connect_to_local_socket_waits_for_accept)
+{
+    Core::EventLoop loop;
+    auto ring = MUST(Core::IORing::create(8));
+
+    sockaddr_un address {};
+    address.sun_family = AF_LOCAL;
+    strlcpy(address.sun_path, "/tmp/io-ring-local-socket", sizeof(address.sun_path));
+    (void)Core::System::unlink({ address.sun_path, strlen(address.sun_path) });
+    auto listener = MUST(Core::System::socket(AF_LOCAL, SOCK_STREAM, 0));
+    MUST(Core::System::bind(listener, reinterpret_cast<sockaddr const*>(&address), sizeof(address)));
+    MUST(Core::System::listen(listener, 1));
+    auto client = MUST(Core::System::socket(AF_LOCAL, SOCK_STREAM, 0));
+
+    // The connection isn't complete until it has been accepted, which we only ask for afterwards.
+    bool is_connected = false;
+    MUST(ring->connect(client, reinterpret_cast<sockaddr const*>(&address), sizeof(address), [&](auto result) {
+        EXPECT(!result.is_error());
+        is_connected = true;
+    }));
+    MUST(ring->wait_for_completions(0));
+    EXPECT(!is_connected);
+
+    Optional<int> server;
+    MUST(ring->accept(listener, 0, [&](auto result) {
+        server = static_cast<int>(result.release_value());
+    }));
+    MUST(ring->wait_for_completions(2));
+    EXPECT(is_connected);
+    VERIFY(server.has_value());
+
+    MUST(Core::System::write(client, "ping"sv.bytes()));
+    Array<u8, 16> buffer {};
+    EXPECT_EQ(MUST(Core::System::read(*server, buffer.span())), 4u);
+    EXPECT_EQ(StringView(buffer.span().trim(4)), "ping"sv);
+
+    MUST(Core::System::close(*server));
+    MUST(Core::System::close(client));
+    MUST(Core::System::close(listener));
+    MUST(Core::System::unlink({ address.sun_path, strlen(address.sun_path) }));
+}
+
+TEST_CASE(completions_are_dispatched_from_the_event_loop)
+{
+    Core::EventLoop loop;
+    auto ring = MUST(Core::IORing::create(8));
+    auto pipe_fds = MUST(Core::System::pipe2(0));
+
+    Array<u8, 16> buffer {};
+    MUST(ring->read(pipe_fds[0], buffer.span(), {}, [&](auto result) {
+        EXPECT_EQ(result.release_value(), 5u);
+        loop.quit(0);
+    }));
+    Core::deferred_invoke([&] {
+        MUST(Core::System::write(pipe_fds[1], "hello"sv.bytes()));
+    });
+    EXPECT_EQ(loop.exec(), 0);
+
+    MUST(Core::System::close(pipe_fds[0]));
+    MUST(Core::System::close(pipe_fds[1]));
+}
+
+static constexpr size_t echo_connection_count = 16;
+static constexpr size_t echo_round_count = 500;
+static constexpr size_t echo_message_size = 64;
+
+// Echoes everything back, with a process per connection.
+static pid_t start_echo_server(sockaddr_in& address)
+{
+    auto listener = create_listener(address, echo_connection_count);
+    auto pid = MUST(Core::System::fork());
+    if (pid != 0) {
+        MUST(Core::System::close(listener));
+        return pid;
+    }
+
+    for (size_t i = 0; i < echo_connection_count; ++i) {
+        auto connection = MUST(Core::System::accept(listener, nullptr, nullptr));
+        if (MUST(Core::System::fork()) != 0) {
+            MUST(Core::System::close(connection));
+            continue;
+        }
+        u8 buffer[echo_message_size];
+        for (;;) {
+            auto nread = MUST(Core::System::read(connection, { buffer, sizeof(buffer) }));
+            if (nread == 0)
+                _exit(0);
+            MUST(Core::System::write(connection, { buffer, nread }));
+        }
+    }
+    _exit(0);
+}
+
+static Array<int, echo_connection_count> connect_to_echo_server(sockaddr_in const& address)
+{
+    Array<int, echo_connection_count> connections {};
+    for (auto& connection : connections) {
+        connection = MUST(Core::System::socket(AF_INET, SOCK_STREAM, 0));
+        MUST(Core::System::connect(connection, reinterpret_cast<sockaddr const*>(&address), sizeof(address)));
+    }
+    return connections;
+}
+
+static void stop_echo_server(pid_t pid, Span<int const> connections)
+{
+    for (auto connection : connections)
+        MUST(Core::System::close(connection));
+    MUST(Core::System::waitpid(pid));
+}
+
+BENCHMARK_CASE(echo_with_blocking_syscalls)
+{
+    sockaddr_in address {};
+    auto server_pid = start_echo_server(address);
+    auto connections = connect_to_echo_server(address);
+
+    u8 message[echo_message_size] {};
+    u8 reply[echo_message_size];
+    for (size_t round = 0; round < echo_round_count; ++round) {
+        for (auto connection : connections)
+            MUST(Core::System::write(connection, { message, sizeof(message) }));
+        for (auto connection : connections) {
+            size_t nread = 0;
+            while (nread < sizeof(reply))
+                nread += MUST(Core::System::read(connection, { reply + nread, sizeof(reply) - nread }));
+        }
+    }
+
+    stop_echo_server(server_pid, connections);
+}
+
+BENCHMARK_CASE(echo_with_io_ring)
+{
+    Core::EventLoop loop;
+    auto ring = MUST(Core::IORing::create(2 * echo_connection_count));
+
+    sockaddr_in address {};
+    auto server_pid = start_echo_server(address);
+    auto connections = connect_to_echo_server(address);
+
+    u8 message[echo_message_size] {};
+    // Replies on loopback are never split, as every message fits in a single segment.
+    u8 replies[echo_connection_count][echo_message_size];
+    for (size_t round = 0; round < echo_round_count; ++round) {
+        size_t pending = 0;
+        for (size_t i = 0; i < echo_connection_count; ++i) {
+            MUST(ring->send(connections[i], { message, sizeof(message) }, 0, [&](auto result) {
+                EXPECT_EQ(result.release_value(), sizeof(message));
+                --pending;
+            }));
+            MUST(ring->receive(connections[i], { replies[i], sizeof(replies[i]) }, 0, [&](auto result) {
+                EXPECT_EQ(result.release_value(), sizeof(replies[i]));
+                --pending;
+            }));
+            pending += 2;
+        }
+        while (pending > 0)
+            MUST(ring->wait_for_completions(pending));
+    }
+
+    stop_echo_server(server_pid, connections);
+}
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include "SysFS.h"
+#include <AK/JsonArray.h>
+#include <AK/JsonObject.h>
+#include <LibCore/System.h>
+#include <LibTest/TestCase.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+struct CacheStatistics {
+    u64 allocation_count { 0 };
+    u64 free_count { 0 };
+    u64 magazine_hit_count { 0 };
+};
+
+static HashMap<DeprecatedString, CacheStatistics> read_cache_statistics()
+{
+    auto json = read_sysfs_json("/sys/kernel/memstat"sv);
+    auto slab_caches = json.as_object().get_array("slab_caches"sv);
+    VERIFY(slab_caches.has_value());
+
+    HashMap<DeprecatedString, CacheStatistics> statistics;
+    slab_caches->for_each([&](auto& value) {
+        auto& object = value.as_object();
+        CacheStatistics cache;
+        cache.allocation_count = object.get_u64("allocation_count"sv).value_or(0);
+        cache.free_count = object.get_u64("free_count"sv).value_or(0);
+        cache.magazine_hit_count = object.get_u64("magazine_hit_count"sv).value_or(0);
+        statistics.set(object.get_deprecated_string("name"sv).value(), cache);
+    });
+    return statistics;
+}
+
+// Each round allocates and frees path custodies, open file descriptions, pipes and sockets in the kernel.
+static void hammer_syscalls(size_t rounds)
+{
+    for (size_t i = 0; i < rounds; ++i) {
+        struct stat st;
+        VERIFY(stat("/usr/lib/libc.so", &st) == 0);
+
+        int fd = open("/etc/passwd", O_RDONLY);
+        VERIFY(fd >= 0);
+        close(fd);
+
+        int pipe_fds[2];
+        VERIFY(pipe(pipe_fds) == 0);
+        char byte = 'x';
+        VERIFY(write(pipe_fds[1], &byte, 1) == 1);
+        VERIFY(read(pipe_fds[0], &byte, 1) == 1);
+        close(pipe_fds[0]);
+        close(pipe_fds[1]);
+
+        int socket_fds[2];
+        VERIFY(socketpair(AF_LOCAL, SOCK_STREAM, 0, socket_fds) == 0);
+        close(socket_fds[0]);
+        close(socket_fds[1]);
+    }
+}
+
+// Runs the rounds in a few processes at once, so that the magazines of several CPUs get used.
+static void hammer_syscalls_in_parallel(size_t process_count, size_t rounds_per_process)
+{
+    Vector<pid_t> pids;
+    for (size_t i = 0; i < process_count; ++i) {
+        auto pid = MUST(Core::System::fork());
+        if (pid == 0) {
+            hammer_syscalls(rounds_per_process);
+            _exit(0);
+        }
+        pids.append(pid);
+    }
+
+    for (auto pid : pids) {
+        auto result = MUST(Core::System::waitpid(pid));
+        EXPECT(WIFEXITED(result.status) && WEXITSTATUS(result.status) == 0);
+    }
+}
+
+TEST_CASE(memstat_lists_slab_caches)
+{
+    // Looking up a path makes sure that the custody cache is set up.
+    hammer_syscalls(1);
+
+    auto statistics = read_cache_statistics();
+    for (auto name : { "kmalloc-16"sv, "kmalloc-32"sv, "kmalloc-64"sv, "kmalloc-128"sv, "kmalloc-256"sv, "kmalloc-512"sv, "Custody"sv })
+        EXPECT(statistics.contains(name));
+}
+
+TEST_CASE(syscalls_are_served_from_magazines)
+{
+    auto before = read_cache_statistics();
+    hammer_syscalls_in_parallel(4, 1000);
+    auto after = read_cache_statistics();
+
+    for (auto name : { "kmalloc-64"sv, "Custody"sv }) {
+        auto cache_before = before.get(name).value_or({});
+        auto cache_after = after.get(name);
+        EXPECT(cache_after.has_value());
+        if (!cache_after.has_value())
+            continue;
+        EXPECT(cache_after->allocation_count > cache_before.allocation_count);
+        EXPECT(cache_after->free_count > cache_before.free_count);
+
+        // Nearly everything we allocated was freed again right away, so the magazines should have had it.
+        auto allocations = cache_after->allocation_count - cache_before.allocation_count;
+        auto hits = cache_after->magazine_hit_count - cache_before.magazine_hit_count;
+        EXPECT(hits * 2 > allocations);
+    }
+}
+
+BENCHMARK_CASE(syscall_heavy_stress)
+{
+    hammer_syscalls_in_parallel(8, 100'000);
+}
@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include "SysFS.h"
+#include <AK/JsonObject.h>
+#include <LibCore/System.h>
+#include <LibTest/TestCase.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static constexpr size_t large_page_size = 2 * MiB;
+
+struct LargePageStatistics {
+    u64 mapped { 0 };
+    u64 allocations { 0 };
+};
+
+static LargePageStatistics read_large_page_statistics()
+{
+    auto json = read_sysfs_json("/sys/kernel/memstat"sv);
+    auto const& object = json.as_object();
+    return {
+        .mapped = object.get_u64("large_pages_mapped"sv).value_or(0),
+        .allocations = object.get_u64("large_page_allocations"sv).value_or(0),
+    };
+}
+
+static u8 expected_byte_at(size_t offset)
+{
+    return static_cast<u8>((offset * 13) ^ (offset >> 12));
+}
+
+static void fill(u8* data, size_t size)
+{
+    for (size_t i = 0; i < size; ++i)
+        data[i] = expected_byte_at(i);
+}
+
+static size_t count_mismatches(u8 const* data, size_t offset, size_t size)
+{
+    size_t mismatches = 0;
+    for (size_t i = offset; i < offset + size; ++i) {
+        if (data[i] != expected_byte_at(i))
+            ++mismatches;
+    }
+    return mismatches;
+}
+
+static u8* map_large_pages(size_t size)
+{
+    auto* data = static_cast<u8*>(MUST(Core::System::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE | MAP_HUGETLB, 0, 0)));
+    EXPECT_EQ(reinterpret_cast<FlatPtr>(data) % large_page_size, 0u);
+    return data;
+}
+
+TEST_CASE(hugetlb_mappings_use_large_pages)
+{
+    auto before = read_large_page_statistics();
+    auto* data = map_large_pages(4 * large_page_size);
+    auto after = read_large_page_statistics();
+
+    EXPECT(after.allocations >= before.allocations + 4);
+    EXPECT(after.mapped > before.mapped);
+
+    fill(data, 4 * large_page_size);
+    EXPECT_EQ(count_mismatches(data, 0, 4 * large_page_size), 0u);
+    MUST(Core::System::munmap(data, 4 * large_page_size));
+}
+
+TEST_CASE(partial_mprotect_splits_large_page)
+{
+    auto* data = map_large_pages(2 * large_page_size);
+    fill(data, 2 * large_page_size);
+
+    EXPECT_EQ(mprotect(data + large_page_size + 5 * PAGE_SIZE, PAGE_SIZE, PROT_READ), 0);
+    EXPECT_EQ(count_mismatches(data, 0, 2 * large_page_size), 0u);
+
+    // The pages around the protected one have to stay writable.
+    data[large_page_size + 4 * PAGE_SIZE] = expected_byte_at(large_page_size + 4 * PAGE_SIZE);
+    data[large_page_size + 6 * PAGE_SIZE] = expected_byte_at(large_page_size + 6 * PAGE_SIZE);
+
+    MUST(Core::System::munmap(data, 2 * large_page_size));
+}
+
+TEST_CASE(partial_munmap_splits_large_page)
+{
+    auto* data = map_large_pages(2 * large_page_size);
+    fill(data, 2 * large_page_size);
+
+    MUST(Core::System::munmap(data + 3 * PAGE_SIZE, PAGE_SIZE));
+    EXPECT_EQ(count_mismatches(data, 0, 3 * PAGE_SIZE), 0u);
+    EXPECT_EQ(count_mismatches(data, 4 * PAGE_SIZE, 2 * large_page_size - 4 * PAGE_SIZE), 0u);
+
+    MUST(Core::System::munmap(data, 3 * PAGE_SIZE));
+    MUST(Core::System::munmap(data + 4 * PAGE_SIZE, 2 * large_page_size - 4 * PAGE_SIZE));
+}
+
+TEST_CASE(fork_copies_large_pages_on_write)
+{
+    auto* data = map_large_pages(large_page_size);
+    fill(data, large_page_size);
+
+    auto pid = MUST(Core::System::fork());
+    if (pid == 0) {
+        data[PAGE_SIZE] = ~expected_byte_at(PAGE_SIZE);
+        _exit(count_mismatches(data, 0, large_page_size) == 1 ? 0 : 1);
+    }
+
+    auto result = MUST(Core::System::waitpid(pid));
+    EXPECT(WIFEXITED(result.status) && WEXITSTATUS(result.status) == 0);
+    EXPECT_EQ(count_mismatches(data, 0, large_page_size), 0u);
+
+    MUST(Core::System::munmap(data, large_page_size));
+}
+
+TEST_CASE(large_anonymous_mappings_get_large_pages_on_first_write)
+{
+    auto* data = static_cast<u8*>(MUST(Core::System::mmap(nullptr, 2 * large_page_size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, 0, 0)));
+    EXPECT_EQ(reinterpret_cast<FlatPtr>(data) % large_page_size, 0u);
+
+    auto before = read_large_page_statistics();
+    data[0] = 1;
+    data[large_page_size + 1] = 2;
+    auto after = read_large_page_statistics();
+
+    EXPECT(after.allocations >= before.allocations + 2);
+    EXPECT_EQ(data[0], 1);
+    EXPECT_EQ(data[1], 0);
+    EXPECT_EQ(data[large_page_size + 1], 2);
+
+    MUST(Core::System::munmap(data, 2 * large_page_size));
+}
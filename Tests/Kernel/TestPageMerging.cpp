@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include "SysFS.h"
+#include <AK/JsonObject.h>
+#include <LibCore/System.h>
+#include <LibTest/TestCase.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+static constexpr size_t page_count = 64;
+
+struct MergeStatistics {
+    u64 merged_pages { 0 };
+    u64 merged_zero_pages { 0 };
+};
+
+static MergeStatistics read_merge_statistics()
+{
+    auto json = read_sysfs_json("/sys/kernel/memstat"sv);
+    auto const& object = json.as_object();
+    return {
+        .merged_pages = object.get_u64("merged_pages"sv).value_or(0),
+        .merged_zero_pages = object.get_u64("merged_zero_pages"sv).value_or(0),
+    };
+}
+
+// Pages are only merged once they've stayed the same for two passes, which are a few seconds apart.
+template<typename Callback>
+static bool wait_until(Callback condition)
+{
+    for (int i = 0; i < 30; ++i) {
+        if (condition())
+            return true;
+        sleep(1);
+    }
+    return false;
+}
+
+static u8* map_mergeable_pages()
+{
+    auto* data = static_cast<u8*>(MUST(Core::System::mmap(nullptr, page_count * PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, 0, 0)));
+    EXPECT_EQ(madvise(data, page_count * PAGE_SIZE, MADV_MERGEABLE), 0);
+    return data;
+}
+
+TEST_CASE(shared_memory_cannot_be_merged)
+{
+    auto* data = MUST(Core::System::mmap(nullptr, PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_SHARED, 0, 0));
+    EXPECT_EQ(madvise(data, PAGE_SIZE, MADV_MERGEABLE), -1);
+    EXPECT_EQ(errno, EINVAL);
+    MUST(Core::System::munmap(data, PAGE_SIZE));
+}
+
+TEST_CASE(identical_pages_are_merged)
+{
+    auto before = read_merge_statistics();
+    auto* data = map_mergeable_pages();
+    for (size_t page = 0; page < page_count; ++page) {
+        for (size_t i = 0; i < PAGE_SIZE; ++i)
+            data[page * PAGE_SIZE + i] = static_cast<u8>(i * 7 + 1);
+    }
+
+    EXPECT(wait_until([&] { return read_merge_statistics().merged_pages > before.merged_pages; }));
+
+    // Writing to one of the merged pages must not change any of the others.
+    data[0] = 0xff;
+    EXPECT_EQ(data[0], 0xff);
+    for (size_t page = 1; page < page_count; ++page)
+        EXPECT_EQ(data[page * PAGE_SIZE], 1);
+
+    MUST(Core::System::munmap(data, page_count * PAGE_SIZE));
+}
+
+TEST_CASE(zeroed_pages_are_given_up)
+{
+    auto before = read_merge_statistics();
+    auto* data = map_mergeable_pages();
+    for (size_t page = 0; page < page_count; ++page)
+        data[page * PAGE_SIZE] = 1;
+    for (size_t page = 0; page < page_count; ++page)
+        data[page * PAGE_SIZE] = 0;
+
+    EXPECT(wait_until([&] { return read_merge_statistics().merged_zero_pages > before.merged_zero_pages; }));
+
+    for (size_t page = 0; page < page_count; ++page)
+        EXPECT_EQ(data[page * PAGE_SIZE], 0);
+    data[PAGE_SIZE] = 2;
+    EXPECT_EQ(data[PAGE_SIZE], 2);
+    EXPECT_EQ(data[2 * PAGE_SIZE], 0);
+
+    MUST(Core::System::munmap(data, page_count * PAGE_SIZE));
+}
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <LibCore/System.h>
+#include <LibTest/TestCase.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+static constexpr size_t test_file_size = 1 * MiB;
+
+static u8 expected_byte_at(size_t offset)
+{
+    return static_cast<u8>((offset * 7) ^ (offset >> 12));
+}
+
+static int create_test_file()
+{
+    char pattern[] = "/tmp/posix_fadvise.XXXXXX";
+    auto fd = MUST(Core::System::mkstemp(pattern));
+    MUST(Core::System::unlink({ pattern, strlen(pattern) }));
+
+    u8 buffer[PAGE_SIZE];
+    for (size_t offset = 0; offset < test_file_size; offset += sizeof(buffer)) {
+        for (size_t i = 0; i < sizeof(buffer); ++i)
+            buffer[i] = expected_byte_at(offset + i);
+        VERIFY(static_cast<size_t>(MUST(Core::System::write(fd, { buffer, sizeof(buffer) }))) == sizeof(buffer));
+    }
+    return fd;
+}
+
+static void expect_contents_read_back_correctly(int fd, size_t read_size)
+{
+    u8 buffer[3 * PAGE_SIZE];
+    VERIFY(read_size <= sizeof(buffer));
+
+    MUST(Core::System::lseek(fd, 0, SEEK_SET));
+    size_t offset = 0;
+    while (offset < test_file_size) {
+        auto nread = static_cast<size_t>(MUST(Core::System::read(fd, { buffer, read_size })));
+        EXPECT(nread > 0);
+        for (size_t i = 0; i < nread; ++i) {
+            if (buffer[i] != expected_byte_at(offset + i)) {
+                warnln("Mismatch at offset {} when reading {} bytes at a time", offset + i, read_size);
+                FAIL("Read back the wrong data");
+                return;
+            }
+        }
+        offset += nread;
+    }
+    EXPECT_EQ(offset, test_file_size);
+}
+
+TEST_CASE(posix_fadvise_basics)
+{
+    auto fd = create_test_file();
+
+    EXPECT_EQ(posix_fadvise(fd, 0, 0, POSIX_FADV_NORMAL), 0);
+    EXPECT_EQ(posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL), 0);
+    EXPECT_EQ(posix_fadvise(fd, 0, 0, POSIX_FADV_RANDOM), 0);
+    EXPECT_EQ(posix_fadvise(fd, 0, 4096, POSIX_FADV_WILLNEED), 0);
+    EXPECT_EQ(posix_fadvise(fd, 0, 4096, POSIX_FADV_DONTNEED), 0);
+    EXPECT_EQ(posix_fadvise(fd, 0, 4096, POSIX_FADV_NOREUSE), 0);
+
+    EXPECT_EQ(posix_fadvise(fd, 0, 0, 1234), EINVAL);
+    EXPECT_EQ(posix_fadvise(fd, 0, -1, POSIX_FADV_NORMAL), EINVAL);
+    EXPECT_EQ(posix_fadvise(-1, 0, 0, POSIX_FADV_NORMAL), EBADF);
+
+    MUST(Core::System::close(fd));
+}
+
+TEST_CASE(posix_fadvise_on_pipe)
+{
+    auto pipefds = MUST(Core::System::pipe2(0));
+    EXPECT_EQ(posix_fadvise(pipefds[0], 0, 0, POSIX_FADV_SEQUENTIAL), ESPIPE);
+    MUST(Core::System::close(pipefds[0]));
+    MUST(Core::System::close(pipefds[1]));
+}
+
+TEST_CASE(reads_are_unaffected_by_access_pattern)
+{
+    auto fd = create_test_file();
+
+    // Odd read sizes make the reads straddle blocks and read-ahead windows.
+    expect_contents_read_back_correctly(fd, 1000);
+
+    EXPECT_EQ(posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL), 0);
+    expect_contents_read_back_correctly(fd, 3 * PAGE_SIZE - 1);
+
+    EXPECT_EQ(posix_fadvise(fd, 0, 0, POSIX_FADV_RANDOM), 0);
+    expect_contents_read_back_correctly(fd, 513);
+
+    EXPECT_EQ(posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED), 0);
+    expect_contents_read_back_correctly(fd, PAGE_SIZE);
+
+    MUST(Core::System::close(fd));
+}
+
+TEST_CASE(dropping_cached_data_keeps_contents)
+{
+    auto fd = create_test_file();
+
+    // The freshly written blocks haven't been written back yet, so they have to survive this.
+    EXPECT_EQ(posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED), 0);
+    expect_contents_read_back_correctly(fd, PAGE_SIZE);
+
+    EXPECT_EQ(fsync(fd), 0);
+    EXPECT_EQ(posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED), 0);
+    expect_contents_read_back_correctly(fd, 1000);
+
+    EXPECT_EQ(posix_fadvise(fd, PAGE_SIZE, 3 * PAGE_SIZE, POSIX_FADV_DONTNEED), 0);
+    EXPECT_EQ(posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL), 0);
+    expect_contents_read_back_correctly(fd, 3 * PAGE_SIZE - 1);
+
+    MUST(Core::System::close(fd));
+}
+
+TEST_CASE(mapped_reads_are_unaffected_by_access_pattern)
+{
+    auto fd = create_test_file();
+
+    for (auto advice : { MADV_NORMAL, MADV_SEQUENTIAL, MADV_RANDOM, MADV_WILLNEED }) {
+        auto* mapping = static_cast<u8*>(MUST(Core::System::mmap(nullptr, test_file_size, PROT_READ, MAP_SHARED, fd, 0)));
+        EXPECT_EQ(madvise(mapping, test_file_size, advice), 0);
+
+        // Touch every other page first, so fault-around has resident neighbors to map in.
+        for (size_t offset = 0; offset < test_file_size; offset += 2 * PAGE_SIZE)
+            EXPECT_EQ(mapping[offset], expected_byte_at(offset));
+        for (size_t offset = 0; offset < test_file_size; ++offset) {
+            if (mapping[offset] != expected_byte_at(offset)) {
+                warnln("Mismatch at offset {} with advice {}", offset, advice);
+                FAIL("Read back the wrong data through the mapping");
+                break;
+            }
+        }
+
+        MUST(Core::System::munmap(mapping, test_file_size));
+    }
+
+    MUST(Core::System::close(fd));
+}
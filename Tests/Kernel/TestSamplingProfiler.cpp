@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/JsonArray.h>
+#include <AK/JsonObject.h>
+#include <AK/JsonValue.h>
+#include <LibCore/ElapsedTimer.h>
+#include <LibCore/File.h>
+#include <LibTest/TestCase.h>
+#include <unistd.h>
+
+static void set_sampling_frequency(u32 frequency)
+{
+    auto file = MUST(Core::File::open("/sys/kernel/conf/profile_sampling_frequency"sv, Core::File::OpenMode::Write));
+    MUST(file->write_until_depleted(DeprecatedString::number(frequency).bytes()));
+}
+
+static u32 sampling_frequency()
+{
+    auto file = MUST(Core::File::open("/sys/kernel/conf/profile_sampling_frequency"sv, Core::File::OpenMode::Read));
+    auto contents = MUST(file->read_until_eof());
+    return StringView { contents }.trim_whitespace().to_uint<u32>().value();
+}
+
+static JsonObject read_samples(Core::File& file)
+{
+    MUST(file.seek(0, SeekMode::SetPosition));
+    return MUST(JsonValue::from_string(MUST(file.read_until_eof()))).as_object();
+}
+
+TEST_CASE(frequency_is_rounded_to_timer_ticks)
+{
+    set_sampling_frequency(100);
+    EXPECT_EQ(sampling_frequency(), 125u);
+    set_sampling_frequency(100'000);
+    EXPECT_EQ(sampling_frequency(), 250u);
+    set_sampling_frequency(0);
+    EXPECT_EQ(sampling_frequency(), 0u);
+}
+
+TEST_CASE(samples_are_taken_and_drained)
+{
+    auto file = MUST(Core::File::open("/sys/kernel/profile_samples"sv, Core::File::OpenMode::Read));
+    (void)read_samples(*file);
+
+    set_sampling_frequency(250);
+    // Keep this processor busy, so some of the samples are of this process.
+    auto timer = Core::ElapsedTimer::start_new();
+    while (timer.elapsed_time().to_milliseconds() < 500)
+        ;
+    set_sampling_frequency(0);
+
+    auto samples = read_samples(*file);
+    auto const& sample_array = *samples.get_array("samples"sv);
+    EXPECT(!sample_array.is_empty());
+
+    size_t own_sample_count = 0;
+    for (auto const& value : sample_array.values()) {
+        auto const& sample = value.as_object();
+        auto stack_size = sample.get_array("stack"sv)->size();
+        EXPECT(stack_size > 0);
+        EXPECT(sample.get_u32("kernel_frames"sv).value() <= stack_size);
+        if (sample.get_i32("pid"sv) == getpid())
+            ++own_sample_count;
+    }
+    EXPECT(own_sample_count > 0);
+
+    // Samples are only handed out once.
+    EXPECT(read_samples(*file).get_array("samples"sv)->is_empty());
+}
@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/ScopeGuard.h>
+#include <LibCore/System.h>
+#include <LibTest/TestCase.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// Pipes and local sockets hold 64 KiB, so this is enough to fill up either of them.
+static constexpr size_t large_file_size = 1 * MiB;
+
+static u8 expected_byte_at(size_t offset)
+{
+    return static_cast<u8>((offset * 7) ^ (offset >> 12));
+}
+
+static int create_file(size_t size)
+{
+    char pattern[] = "/tmp/sendfile_splice.XXXXXX";
+    auto fd = MUST(Core::System::mkstemp(pattern));
+    MUST(Core::System::unlink({ pattern, sizeof(pattern) - 1 }));
+    u8 buffer[4 * KiB];
+    for (size_t offset = 0; offset < size; offset += sizeof(buffer)) {
+        auto count = min(sizeof(buffer), size - offset);
+        for (size_t i = 0; i < count; ++i)
+            buffer[i] = expected_byte_at(offset + i);
+        VERIFY(static_cast<size_t>(MUST(Core::System::write(fd, { buffer, count }))) == count);
+    }
+    MUST(Core::System::lseek(fd, 0, SEEK_SET));
+    return fd;
+}
+
+// Reads exactly `size` bytes, and checks that they are what the test file has at `file_offset`.
+static void expect_file_contents(int fd, size_t file_offset, size_t size)
+{
+    u8 buffer[4 * KiB];
+    size_t nread = 0;
+    while (nread < size) {
+        size_t count = MUST(Core::System::read(fd, { buffer, min(sizeof(buffer), size - nread) }));
+        EXPECT(count > 0);
+        if (count == 0)
+            return;
+        for (size_t i = 0; i < count; ++i) {
+            if (buffer[i] != expected_byte_at(file_offset + nread + i)) {
+                FAIL(DeprecatedString::formatted("Byte {} is {:#x}, not {:#x}", file_offset + nread + i, buffer[i], expected_byte_at(file_offset + nread + i)));
+                return;
+            }
+        }
+        nread += count;
+    }
+}
+
+static off_t current_offset(int fd)
+{
+    return MUST(Core::System::lseek(fd, 0, SEEK_CUR));
+}
+
+TEST_CASE(sendfile_from_file_to_socket)
+{
+    auto file_fd = create_file(8 * KiB);
+    int sockets[2];
+    MUST(Core::System::socketpair(AF_LOCAL, SOCK_STREAM, 0, sockets));
+    ScopeGuard cleanup_guard = [&] {
+        close(file_fd);
+        close(sockets[0]);
+        close(sockets[1]);
+    };
+
+    EXPECT_EQ(sendfile(sockets[0], file_fd, nullptr, 4 * KiB), static_cast<ssize_t>(4 * KiB));
+    EXPECT_EQ(current_offset(file_fd), static_cast<ssize_t>(4 * KiB));
+    expect_file_contents(sockets[1], 0, 4 * KiB);
+
+    // With an offset, the file position stays where it is.
+    off_t offset = 1 * KiB;
+    EXPECT_EQ(sendfile(sockets[0], file_fd, &offset, 2 * KiB), static_cast<ssize_t>(2 * KiB));
+    EXPECT_EQ(offset, static_cast<ssize_t>(3 * KiB));
+    EXPECT_EQ(current_offset(file_fd), static_cast<ssize_t>(4 * KiB));
+    expect_file_contents(sockets[1], 1 * KiB, 2 * KiB);
+
+    // Sending past the end of the file stops at the end.
+    EXPECT_EQ(sendfile(sockets[0], file_fd, nullptr, 64 * KiB), static_cast<ssize_t>(4 * KiB));
+    expect_file_contents(sockets[1], 4 * KiB, 4 * KiB);
+    EXPECT_EQ(sendfile(sockets[0], file_fd, nullptr, 64 * KiB), 0);
+}
+
+TEST_CASE(sendfile_to_full_socket_is_partial)
+{
+    auto file_fd = create_file(large_file_size);
+    int sockets[2];
+    MUST(Core::System::socketpair(AF_LOCAL, SOCK_STREAM, 0, sockets));
+    ScopeGuard cleanup_guard = [&] {
+        close(file_fd);
+        close(sockets[0]);
+        close(sockets[1]);
+    };
+    MUST(Core::System::fcntl(sockets[0], F_SETFL, O_NONBLOCK));
+
+    // The socket only takes part of the file. What it didn't take must still be in the file after the new offset.
+    off_t offset = 0;
+    auto nsent = sendfile(sockets[0], file_fd, &offset, large_file_size);
+    EXPECT(nsent > 0);
+    EXPECT(static_cast<size_t>(nsent) < large_file_size);
+    EXPECT_EQ(offset, nsent);
+    expect_file_contents(sockets[1], 0, nsent);
+
+    // Without an offset, the file position has to end up right after what the socket took.
+    nsent = sendfile(sockets[0], file_fd, nullptr, large_file_size);
+    EXPECT(nsent > 0);
+    EXPECT(static_cast<size_t>(nsent) < large_file_size);
+    EXPECT_EQ(current_offset(file_fd), nsent);
+    expect_file_contents(sockets[1], 0, nsent);
+}
+
+TEST_CASE(splice_from_pipe_to_file)
+{
+    auto source_fd = create_file(8 * KiB);
+    char pattern[] = "/tmp/splice_destination.XXXXXX";
+    auto file_fd = MUST(Core::System::mkstemp(pattern));
+    MUST(Core::System::unlink({ pattern, sizeof(pattern) - 1 }));
+    auto pipe_fds = MUST(Core::System::pipe2(0));
+    ScopeGuard cleanup_guard = [&] {
+        close(source_fd);
+        close(file_fd);
+        close(pipe_fds[0]);
+        close(pipe_fds[1]);
+    };
+
+    u8 buffer[8 * KiB];
+    EXPECT_EQ(MUST(Core::System::read(source_fd, { buffer, sizeof(buffer) })), static_cast<ssize_t>(sizeof(buffer)));
+    EXPECT_EQ(MUST(Core::System::write(pipe_fds[1], { buffer, sizeof(buffer) })), static_cast<ssize_t>(sizeof(buffer)));
+
+    // Without an offset, the data goes to the file position.
+    EXPECT_EQ(splice(pipe_fds[0], nullptr, file_fd, nullptr, 4 * KiB, 0), static_cast<ssize_t>(4 * KiB));
+    EXPECT_EQ(current_offset(file_fd), static_cast<ssize_t>(4 * KiB));
+
+    // With one, it goes there and the file position stays where it is.
+    off_t offset = 4 * KiB;
+    EXPECT_EQ(splice(pipe_fds[0], nullptr, file_fd, &offset, 4 * KiB, 0), static_cast<ssize_t>(4 * KiB));
+    EXPECT_EQ(offset, static_cast<ssize_t>(8 * KiB));
+    EXPECT_EQ(current_offset(file_fd), static_cast<ssize_t>(4 * KiB));
+
+    MUST(Core::System::lseek(file_fd, 0, SEEK_SET));
+    expect_file_contents(file_fd, 0, 8 * KiB);
+
+    // A file can't be spliced to a pipe offset.
+    offset = 0;
+    EXPECT_EQ(splice(file_fd, nullptr, pipe_fds[1], &offset, 1, 0), -1);
+    EXPECT_EQ(errno, ESPIPE);
+}
+
+TEST_CASE(splice_from_file_to_pipe)
+{
+    auto file_fd = create_file(8 * KiB);
+    auto pipe_fds = MUST(Core::System::pipe2(0));
+    ScopeGuard cleanup_guard = [&] {
+        close(file_fd);
+        close(pipe_fds[0]);
+        close(pipe_fds[1]);
+    };
+
+    EXPECT_EQ(splice(file_fd, nullptr, pipe_fds[1], nullptr, 4 * KiB, 0), static_cast<ssize_t>(4 * KiB));
+    EXPECT_EQ(current_offset(file_fd), static_cast<ssize_t>(4 * KiB));
+    expect_file_contents(pipe_fds[0], 0, 4 * KiB);
+
+    off_t offset = 2 * KiB;
+    EXPECT_EQ(splice(file_fd, &offset, pipe_fds[1], nullptr, 4 * KiB, 0), static_cast<ssize_t>(4 * KiB));
+    EXPECT_EQ(offset, static_cast<ssize_t>(6 * KiB));
+    EXPECT_EQ(current_offset(file_fd), static_cast<ssize_t>(4 * KiB));
+    expect_file_contents(pipe_fds[0], 2 * KiB, 4 * KiB);
+}
+
+TEST_CASE(splice_to_full_pipe_is_partial)
+{
+    auto file_fd = create_file(large_file_size);
+    auto pipe_fds = MUST(Core::System::pipe2(O_NONBLOCK));
+    ScopeGuard cleanup_guard = [&] {
+        close(file_fd);
+        close(pipe_fds[0]);
+        close(pipe_fds[1]);
+    };
+
+    off_t offset = 0;
+    auto nspliced = splice(file_fd, &offset, pipe_fds[1], nullptr, large_file_size, SPLICE_F_NONBLOCK);
+    EXPECT(nspliced > 0);
+    EXPECT(static_cast<size_t>(nspliced) < large_file_size);
+    EXPECT_EQ(offset, nspliced);
+    expect_file_contents(pipe_fds[0], 0, nspliced);
+
+    // Once the pipe is full, there is nothing to do without blocking.
+    auto nfilled = splice(file_fd, &offset, pipe_fds[1], nullptr, large_file_size, SPLICE_F_NONBLOCK);
+    EXPECT(nfilled > 0);
+    EXPECT_EQ(splice(file_fd, &offset, pipe_fds[1], nullptr, large_file_size, SPLICE_F_NONBLOCK), -1);
+    EXPECT_EQ(errno, EAGAIN);
+    EXPECT_EQ(offset, nspliced + nfilled);
+}
+
+TEST_CASE(splice_needs_a_pipe)
+{
+    auto file_fd = create_file(4 * KiB);
+    int sockets[2];
+    MUST(Core::System::socketpair(AF_LOCAL, SOCK_STREAM, 0, sockets));
+    ScopeGuard cleanup_guard = [&] {
+        close(file_fd);
+        close(sockets[0]);
+        close(sockets[1]);
+    };
+
+    EXPECT_EQ(splice(file_fd, nullptr, sockets[0], nullptr, 4 * KiB, 0), -1);
+    EXPECT_EQ(errno, EINVAL);
+    EXPECT_EQ(current_offset(file_fd), 0);
+}
@@ -4,6 +4,7 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/ScopeGuard.h>
 #include <LibTest/TestCase.h>
 #include <errno.h>
 #include <fcntl.h>
@@ -14,6 +15,101 @@
 #include <sys/mman.h>
 #include <unistd.h>
 
+static constexpr auto COHERENCE_TEST_FILE_PATH = "/tmp/shared_inode_vmobject_coherence_test";
+
+static int create_file_of_pages(size_t page_count)
+{
+    int fd = open(COHERENCE_TEST_FILE_PATH, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    VERIFY(fd >= 0);
+    u8 buf[0x1000];
+    memset(buf, 'a', sizeof(buf));
+    for (size_t i = 0; i < page_count; ++i)
+        VERIFY(write(fd, buf, sizeof(buf)) == sizeof(buf));
+    return fd;
+}
+
+TEST_CASE(read_sees_stores_to_shared_mapping)
+{
+    int fd = create_file_of_pages(2);
+    auto* mapping = static_cast<u8*>(mmap(nullptr, 0x2000, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0));
+    auto cleanup_guard = ScopeGuard([&] {
+        munmap(mapping, 0x2000);
+        close(fd);
+        unlink(COHERENCE_TEST_FILE_PATH);
+    });
+    VERIFY(mapping != MAP_FAILED);
+
+    mapping[0x10] = 'b';
+    mapping[0x1ff0] = 'c';
+    char c = 0;
+    EXPECT_EQ(pread(fd, &c, 1, 0x10), 1);
+    EXPECT_EQ(c, 'b');
+    EXPECT_EQ(pread(fd, &c, 1, 0x1ff0), 1);
+    EXPECT_EQ(c, 'c');
+}
+
+TEST_CASE(shared_mapping_sees_large_writes)
+{
+    static constexpr size_t page_count = 16;
+    int fd = create_file_of_pages(page_count);
+    auto* mapping = static_cast<u8*>(mmap(nullptr, page_count * 0x1000, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0));
+    auto cleanup_guard = ScopeGuard([&] {
+        munmap(mapping, page_count * 0x1000);
+        close(fd);
+        unlink(COHERENCE_TEST_FILE_PATH);
+    });
+    VERIFY(mapping != MAP_FAILED);
+
+    // Only some of the pages are in memory yet, the write has to reach both kinds.
+    for (size_t page = 0; page < page_count; page += 2)
+        EXPECT_EQ(mapping[page * 0x1000], 'a');
+
+    u8 buf[page_count * 0x1000 - 0x800];
+    for (size_t i = 0; i < sizeof(buf); ++i)
+        buf[i] = static_cast<u8>(i / 0x1000 + 1);
+    EXPECT_EQ(pwrite(fd, buf, sizeof(buf), 0x400), static_cast<ssize_t>(sizeof(buf)));
+
+    EXPECT_EQ(mapping[0x3ff], 'a');
+    for (size_t i = 0; i < sizeof(buf); ++i) {
+        if (mapping[0x400 + i] != buf[i]) {
+            FAIL(DeprecatedString::formatted("Byte {} of the mapping is {:#x}, not {:#x}", 0x400 + i, mapping[0x400 + i], buf[i]));
+            break;
+        }
+    }
+    EXPECT_EQ(mapping[page_count * 0x1000 - 0x400], 'a');
+}
+
+TEST_CASE(regrown_file_reads_zeroes_despite_shared_mapping)
+{
+    int fd = create_file_of_pages(2);
+    auto* mapping = static_cast<u8*>(mmap(nullptr, 0x2000, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0));
+    auto cleanup_guard = ScopeGuard([&] {
+        munmap(mapping, 0x2000);
+        close(fd);
+        unlink(COHERENCE_TEST_FILE_PATH);
+    });
+    VERIFY(mapping != MAP_FAILED);
+
+    // Bring both pages into memory, then cut the file off in the middle of the first one and grow it again.
+    EXPECT_EQ(mapping[0], 'a');
+    EXPECT_EQ(mapping[0x1000], 'a');
+    EXPECT_EQ(ftruncate(fd, 0x100), 0);
+    EXPECT_EQ(ftruncate(fd, 0x2000), 0);
+
+    u8 buf[0x2000];
+    EXPECT_EQ(pread(fd, buf, sizeof(buf), 0), static_cast<ssize_t>(sizeof(buf)));
+    EXPECT_EQ(buf[0xff], 'a');
+    for (size_t i = 0x100; i < sizeof(buf); ++i) {
+        if (buf[i] != 0) {
+            FAIL(DeprecatedString::formatted("Byte {} is {:#x}, not zero", i, buf[i]));
+            break;
+        }
+    }
+    EXPECT_EQ(mapping[0x100], 0);
+    EXPECT_EQ(mapping[0x1000], 0);
+}
+
+// This test ends the whole process from its signal handler, so it has to stay last.
 static u8* shared_ptr = nullptr;
 
 static void shared_non_empty_inode_vmobject_sync_signal_handler(int)
@@ -0,0 +1,407 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include "SysFS.h"
+#include <AK/JsonArray.h>
+#include <AK/JsonObject.h>
+#include <AK/ScopeGuard.h>
+#include <LibCore/File.h>
+#include <LibCore/System.h>
+#include <LibTest/TestCase.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static constexpr size_t transfer_size = 8 * MiB;
+
+static u8 expected_byte_at(size_t offset)
+{
+    return static_cast<u8>((offset * 7) ^ (offset >> 12));
+}
+
+static int create_listener(sockaddr_in& address, int backlog = 1)
+{
+    auto listener = MUST(Core::System::socket(AF_INET, SOCK_STREAM, 0));
+    address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+    MUST(Core::System::bind(listener, reinterpret_cast<sockaddr const*>(&address), sizeof(address)));
+    MUST(Core::System::listen(listener, backlog));
+
+    socklen_t address_size = sizeof(address);
+    MUST(Core::System::getsockname(listener, reinterpret_cast<sockaddr*>(&address), &address_size));
+    return listener;
+}
+
+static void set_congestion_control(int fd, StringView name)
+{
+    MUST(Core::System::setsockopt(fd, IPPROTO_TCP, TCP_CONGESTION, name.characters_without_null_termination(), name.length()));
+}
+
+static void write_test_data(int fd, size_t size)
+{
+    u8 buffer[16 * KiB];
+    size_t offset = 0;
+    while (offset < size) {
+        for (size_t i = 0; i < sizeof(buffer); ++i)
+            buffer[i] = expected_byte_at(offset + i);
+        ReadonlyBytes remaining { buffer, sizeof(buffer) };
+        while (!remaining.is_empty()) {
+            auto nwritten = MUST(Core::System::write(fd, remaining));
+            remaining = remaining.slice(nwritten);
+        }
+        offset += sizeof(buffer);
+    }
+}
+
+static void expect_test_data_until_eof(int fd, size_t size)
+{
+    u8 buffer[16 * KiB];
+    size_t offset = 0;
+    size_t mismatches = 0;
+    while (true) {
+        auto nread = MUST(Core::System::read(fd, { buffer, sizeof(buffer) }));
+        if (nread == 0)
+            break;
+        for (ssize_t i = 0; i < nread; ++i) {
+            if (buffer[i] != expected_byte_at(offset + i))
+                ++mismatches;
+        }
+        offset += nread;
+    }
+    EXPECT_EQ(offset, size);
+    EXPECT_EQ(mismatches, 0u);
+}
+
+[[noreturn]] static void send_test_data(sockaddr_in const& address, StringView congestion_control)
+{
+    auto fd = MUST(Core::System::socket(AF_INET, SOCK_STREAM, 0));
+    set_congestion_control(fd, congestion_control);
+    MUST(Core::System::connect(fd, reinterpret_cast<sockaddr const*>(&address), sizeof(address)));
+    write_test_data(fd, transfer_size);
+    MUST(Core::System::close(fd));
+    _exit(0);
+}
+
+static Optional<JsonObject> find_connection_statistics(u16 local_port)
+{
+    auto json = read_sysfs_json("/sys/kernel/net/tcp"sv);
+    Optional<JsonObject> statistics;
+    json.as_array().for_each([&](auto& value) {
+        auto& object = value.as_object();
+        if (object.get_u32("local_port"sv) == local_port && object.get_deprecated_string("state"sv) == "Established")
+            statistics = object;
+    });
+    return statistics;
+}
+
+static void transfer_over_loopback(StringView congestion_control)
+{
+    sockaddr_in address;
+    auto listener = create_listener(address);
+
+    auto pid = MUST(Core::System::fork());
+    if (pid == 0)
+        send_test_data(address, congestion_control);
+
+    auto connection = MUST(Core::System::accept(listener, nullptr, nullptr));
+
+    // Both ends are ours, so everything we offer should have been agreed to.
+    auto statistics = find_connection_statistics(ntohs(address.sin_port));
+    EXPECT(statistics.has_value());
+    if (statistics.has_value()) {
+        EXPECT_EQ(statistics->get_bool("sack_permitted"sv), true);
+        EXPECT(statistics->get_u32("send_window_scale"sv).value_or(0) > 0);
+        EXPECT(statistics->get_u32("receive_window_scale"sv).value_or(0) > 0);
+        EXPECT(statistics->get_u32("congestion_window"sv).value_or(0) > 0);
+    }
+
+    expect_test_data_until_eof(connection, transfer_size);
+
+    auto result = MUST(Core::System::waitpid(pid));
+    EXPECT(WIFEXITED(result.status) && WEXITSTATUS(result.status) == 0);
+
+    MUST(Core::System::close(connection));
+    MUST(Core::System::close(listener));
+}
+
+TEST_CASE(bulk_transfer_with_cubic)
+{
+    transfer_over_loopback("cubic"sv);
+}
+
+TEST_CASE(bulk_transfer_with_new_reno)
+{
+    transfer_over_loopback("reno"sv);
+}
+
+static void set_loopback_packet_loss(u32 interval)
+{
+    auto file = MUST(Core::File::open("/sys/kernel/conf/loopback_packet_loss"sv, Core::File::OpenMode::Write));
+    MUST(file->write_until_depleted(DeprecatedString::number(interval).bytes()));
+}
+
+static constexpr size_t lossy_transfer_size = 2 * MiB;
+static constexpr u32 lossy_packet_interval = 16;
+
+// Only the data gets through a lossy link, as we don't retransmit the packets that set up and tear down a connection.
+static void transfer_over_lossy_loopback(StringView congestion_control)
+{
+    sockaddr_in address;
+    auto listener = create_listener(address);
+
+    auto pid = MUST(Core::System::fork());
+    if (pid == 0) {
+        auto fd = MUST(Core::System::socket(AF_INET, SOCK_STREAM, 0));
+        set_congestion_control(fd, congestion_control);
+        MUST(Core::System::connect(fd, reinterpret_cast<sockaddr const*>(&address), sizeof(address)));
+        write_test_data(fd, lossy_transfer_size);
+        // Hold off closing until everything has arrived, so our FIN can't get lost.
+        u8 receipt;
+        MUST(Core::System::read(fd, { &receipt, 1 }));
+        MUST(Core::System::close(fd));
+        _exit(0);
+    }
+
+    auto connection = MUST(Core::System::accept(listener, nullptr, nullptr));
+    set_loopback_packet_loss(lossy_packet_interval);
+    ScopeGuard restore_packet_loss = [] { set_loopback_packet_loss(0); };
+
+    u8 buffer[16 * KiB];
+    size_t offset = 0;
+    size_t mismatches = 0;
+    while (offset < lossy_transfer_size) {
+        auto nread = MUST(Core::System::read(connection, { buffer, min(sizeof(buffer), lossy_transfer_size - offset) }));
+        if (nread == 0)
+            break;
+        for (ssize_t i = 0; i < nread; ++i) {
+            if (buffer[i] != expected_byte_at(offset + i))
+                ++mismatches;
+        }
+        offset += nread;
+    }
+    EXPECT_EQ(offset, lossy_transfer_size);
+    EXPECT_EQ(mismatches, 0u);
+
+    set_loopback_packet_loss(0);
+    u8 receipt = 1;
+    MUST(Core::System::write(connection, { &receipt, 1 }));
+    EXPECT_EQ(MUST(Core::System::read(connection, { buffer, sizeof(buffer) })), 0u);
+
+    auto result = MUST(Core::System::waitpid(pid));
+    EXPECT(WIFEXITED(result.status) && WEXITSTATUS(result.status) == 0);
+
+    MUST(Core::System::close(connection));
+    MUST(Core::System::close(listener));
+}
+
+TEST_CASE(lossy_transfer_with_cubic)
+{
+    transfer_over_lossy_loopback("cubic"sv);
+}
+
+TEST_CASE(lossy_transfer_with_new_reno)
+{
+    transfer_over_lossy_loopback("reno"sv);
+}
+
+TEST_CASE(congestion_control_can_be_selected)
+{
+    auto fd = MUST(Core::System::socket(AF_INET, SOCK_STREAM, 0));
+
+    char name[TCP_CA_NAME_MAX] {};
+    socklen_t name_size = sizeof(name);
+    MUST(Core::System::getsockopt(fd, IPPROTO_TCP, TCP_CONGESTION, name, &name_size));
+    EXPECT_EQ(StringView(name, strlen(name)), "cubic"sv);
+
+    set_congestion_control(fd, "reno"sv);
+    name_size = sizeof(name);
+    MUST(Core::System::getsockopt(fd, IPPROTO_TCP, TCP_CONGESTION, name, &name_size));
+    EXPECT_EQ(StringView(name, strlen(name)), "reno"sv);
+
+    auto result = Core::System::setsockopt(fd, IPPROTO_TCP, TCP_CONGESTION, "vegas", 5);
+    EXPECT(result.is_error());
+    EXPECT_EQ(result.error().code(), ENOENT);
+
+    MUST(Core::System::close(fd));
+}
+
+TEST_CASE(loopback_adapter_offloads_checksums)
+{
+    auto json = read_sysfs_json("/sys/kernel/net/adapters"sv);
+    bool found_loopback = false;
+    json.as_array().for_each([&](auto& value) {
+        auto& object = value.as_object();
+        if (object.get_deprecated_string("class_name"sv) != "LoopbackAdapter")
+            return;
+        found_loopback = true;
+        EXPECT_EQ(object.get_bool("transmit_checksum_offload"sv), true);
+        EXPECT_EQ(object.get_bool("receive_checksum_offload"sv), true);
+    });
+    EXPECT(found_loopback);
+}
+
+static JsonObject loopback_adapter_statistics()
+{
+    Optional<JsonObject> statistics;
+    read_sysfs_json("/sys/kernel/net/adapters"sv).as_array().for_each([&](auto& value) {
+        if (value.as_object().get_deprecated_string("class_name"sv) == "LoopbackAdapter")
+            statistics = value.as_object();
+    });
+    VERIFY(statistics.has_value());
+    return statistics.release_value();
+}
+
+static constexpr size_t segmented_transfer_size = 1 * MiB;
+static constexpr int small_segment_size = 1000;
+
+TEST_CASE(segmentation_offload_over_loopback)
+{
+    auto loopback = loopback_adapter_statistics();
+    EXPECT_EQ(loopback.get_bool("tcp_segmentation_offload"sv), true);
+    auto packets_in_before = loopback.get_u32("packets_in"sv).value();
+    auto packets_out_before = loopback.get_u32("packets_out"sv).value();
+
+    sockaddr_in address;
+    auto listener = create_listener(address);
+
+    auto pid = MUST(Core::System::fork());
+    if (pid == 0) {
+        auto fd = MUST(Core::System::socket(AF_INET, SOCK_STREAM, 0));
+        // With segments this small, we hand the adapter many of them at once, and it has to cut them apart.
+        MUST(Core::System::setsockopt(fd, IPPROTO_TCP, TCP_MAXSEG, &small_segment_size, sizeof(small_segment_size)));
+        MUST(Core::System::connect(fd, reinterpret_cast<sockaddr const*>(&address), sizeof(address)));
+        int maximum_segment_size = 0;
+        socklen_t size = sizeof(maximum_segment_size);
+        MUST(Core::System::getsockopt(fd, IPPROTO_TCP, TCP_MAXSEG, &maximum_segment_size, &size));
+        if (maximum_segment_size != small_segment_size)
+            _exit(1);
+        write_test_data(fd, segmented_transfer_size);
+        MUST(Core::System::close(fd));
+        _exit(0);
+    }
+
+    auto connection = MUST(Core::System::accept(listener, nullptr, nullptr));
+    expect_test_data_until_eof(connection, segmented_transfer_size);
+
+    auto result = MUST(Core::System::waitpid(pid));
+    EXPECT(WIFEXITED(result.status) && WEXITSTATUS(result.status) == 0);
+
+    MUST(Core::System::close(connection));
+    MUST(Core::System::close(listener));
+
+    // Every segment arrives as a packet of its own, but many of them were sent as one.
+    loopback = loopback_adapter_statistics();
+    auto packets_in = loopback.get_u32("packets_in"sv).value() - packets_in_before;
+    auto packets_out = loopback.get_u32("packets_out"sv).value() - packets_out_before;
+    EXPECT(packets_in >= segmented_transfer_size / small_segment_size);
+    EXPECT(packets_in > packets_out);
+}
+
+TEST_CASE(virtio_network_adapters_agree_with_the_device)
+{
+    auto processor_count = static_cast<u32>(sysconf(_SC_NPROCESSORS_ONLN));
+    read_sysfs_json("/sys/kernel/net/adapters"sv).as_array().for_each([&](auto& value) {
+        auto& object = value.as_object();
+        if (object.get_deprecated_string("class_name"sv) != "VirtIONetworkAdapter")
+            return;
+        // NOTE: QEMU only offers the offloads if its backend can take them, which the user network backend can't.
+        //       Segmentation can't be negotiated without checksum offload, though.
+        if (object.get_bool("tcp_segmentation_offload"sv) == true)
+            EXPECT_EQ(object.get_bool("transmit_checksum_offload"sv), true);
+        // One queue pair per processor, at most 8.
+        auto queue_pairs = object.get_u32("queue_pairs"sv).value_or(0);
+        EXPECT(queue_pairs >= 1);
+        EXPECT(queue_pairs <= min(processor_count, 8u));
+    });
+}
+
+TEST_CASE(udp_over_loopback_with_checksum_offload)
+{
+    auto receiver = MUST(Core::System::socket(AF_INET, SOCK_DGRAM, 0));
+    sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    MUST(Core::System::bind(receiver, reinterpret_cast<sockaddr const*>(&address), sizeof(address)));
+    socklen_t address_size = sizeof(address);
+    MUST(Core::System::getsockname(receiver, reinterpret_cast<sockaddr*>(&address), &address_size));
+
+    auto sender = MUST(Core::System::socket(AF_INET, SOCK_DGRAM, 0));
+    auto message = "Well hello friends!"sv;
+    MUST(Core::System::sendto(sender, message.characters_without_null_termination(), message.length(), 0, reinterpret_cast<sockaddr const*>(&address), sizeof(address)));
+
+    u8 buffer[64];
+    auto nreceived = MUST(Core::System::recvfrom(receiver, buffer, sizeof(buffer), 0, nullptr, nullptr));
+    EXPECT_EQ(StringView(buffer, static_cast<size_t>(nreceived)), message);
+
+    MUST(Core::System::close(sender));
+    MUST(Core::System::close(receiver));
+}
+
+BENCHMARK_CASE(bulk_transfer_throughput)
+{
+    transfer_over_loopback("cubic"sv);
+}
+
+TEST_CASE(receive_workers_are_listed)
+{
+    auto json = read_sysfs_json("/sys/kernel/net/receive_workers"sv);
+    EXPECT(json.as_array().size() >= 1);
+    u32 seen_processors = 0;
+    json.as_array().for_each([&](auto& value) {
+        auto processor = value.as_object().get_u32("processor"sv).value();
+        EXPECT(!(seen_processors & (1u << processor)));
+        seen_processors |= 1u << processor;
+    });
+}
+
+static constexpr size_t parallel_connection_count = 8;
+static constexpr size_t parallel_transfer_size = 2 * MiB;
+
+BENCHMARK_CASE(parallel_bulk_transfers)
+{
+    // Every connection is a flow of its own, so they are spread over the receive workers of all CPUs.
+    sockaddr_in address;
+    auto listener = create_listener(address, parallel_connection_count);
+
+    Vector<pid_t> pids;
+    for (size_t i = 0; i < parallel_connection_count; ++i) {
+        auto pid = MUST(Core::System::fork());
+        if (pid == 0) {
+            auto fd = MUST(Core::System::socket(AF_INET, SOCK_STREAM, 0));
+            MUST(Core::System::connect(fd, reinterpret_cast<sockaddr const*>(&address), sizeof(address)));
+            u8 buffer[16 * KiB] {};
+            for (size_t offset = 0; offset < parallel_transfer_size;)
+                offset += MUST(Core::System::write(fd, { buffer, min(sizeof(buffer), parallel_transfer_size - offset) }));
+            MUST(Core::System::close(fd));
+            _exit(0);
+        }
+        pids.append(pid);
+    }
+
+    for (size_t i = 0; i < parallel_connection_count; ++i) {
+        auto connection = MUST(Core::System::accept(listener, nullptr, nullptr));
+        auto pid = MUST(Core::System::fork());
+        if (pid == 0) {
+            u8 buffer[16 * KiB];
+            size_t total = 0;
+            while (auto nread = MUST(Core::System::read(connection, { buffer, sizeof(buffer) })))
+                total += nread;
+            _exit(total == parallel_transfer_size ? 0 : 1);
+        }
+        MUST(Core::System::close(connection));
+        pids.append(pid);
+    }
+
+    for (auto pid : pids) {
+        auto result = MUST(Core::System::waitpid(pid));
+        EXPECT(WIFEXITED(result.status) && WEXITSTATUS(result.status) == 0);
+    }
+    MUST(Core::System::close(listener));
+}
@@ -0,0 +1,233 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/JsonArray.h>
+#include <AK/JsonObject.h>
+#include <AK/JsonValue.h>
+#include <LibCore/ArgsParser.h>
+#include <LibCore/File.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+// Keeps every processor busy with a mix of threads that constantly block and wake each other up through pipes
+// and threads that just spin and yield, which exercises enqueueing, dequeueing and work stealing in the scheduler.
+// Meant to be run under QEMU with SMP enabled, e.g. `SERENITY_RUN=qn SERENITY_EXTRA_QEMU_ARGS="-smp 4"`.
+
+struct SchedulerCounters {
+    u64 context_switches { 0 };
+    u64 threads_stolen { 0 };
+    u64 migrations { 0 };
+    u64 ready_queue_lock_contentions { 0 };
+    size_t processors { 0 };
+};
+
+static ErrorOr<SchedulerCounters> read_scheduler_counters()
+{
+    auto file = TRY(Core::File::open("/sys/kernel/scheduler"sv, Core::File::OpenMode::Read));
+    auto buffer = TRY(file->read_until_eof());
+    auto json = TRY(JsonValue::from_string(buffer));
+
+    SchedulerCounters counters;
+    json.as_array().for_each([&](auto& value) {
+        auto& processor = value.as_object();
+        counters.context_switches += processor.get_u64("context_switches"sv).value_or(0);
+        counters.threads_stolen += processor.get_u64("threads_stolen"sv).value_or(0);
+        counters.migrations += processor.get_u64("migrations"sv).value_or(0);
+        counters.ready_queue_lock_contentions += processor.get_u64("ready_queue_lock_contentions"sv).value_or(0);
+        ++counters.processors;
+    });
+    return counters;
+}
+
+struct PingPongPair {
+    int ping[2];
+    int pong[2];
+    int round_trips;
+    bool failed;
+};
+
+static void* ping_thread(void* arg)
+{
+    auto& pair = *static_cast<PingPongPair*>(arg);
+    for (int i = 0; i < pair.round_trips; ++i) {
+        if (write(pair.ping[1], &i, sizeof(i)) != sizeof(i)) {
+            perror("write");
+            pair.failed = true;
+            return nullptr;
+        }
+        int reply = -1;
+        if (read(pair.pong[0], &reply, sizeof(reply)) != sizeof(reply) || reply != i + 1) {
+            fprintf(stderr, "Ping thread got a bad reply %d for round trip %d\n", reply, i);
+            pair.failed = true;
+            return nullptr;
+        }
+    }
+    return nullptr;
+}
+
+static void* pong_thread(void* arg)
+{
+    auto& pair = *static_cast<PingPongPair*>(arg);
+    for (int i = 0; i < pair.round_trips; ++i) {
+        int request = -1;
+        if (read(pair.ping[0], &request, sizeof(request)) != sizeof(request) || request != i) {
+            fprintf(stderr, "Pong thread got a bad request %d for round trip %d\n", request, i);
+            pair.failed = true;
+            return nullptr;
+        }
+        ++request;
+        if (write(pair.pong[1], &request, sizeof(request)) != sizeof(request)) {
+            perror("write");
+            pair.failed = true;
+            return nullptr;
+        }
+    }
+    return nullptr;
+}
+
+static Atomic<bool> s_stop_spinning { false };
+
+static void* spinning_thread(void* arg)
+{
+    auto& yields = *static_cast<u64*>(arg);
+    while (!s_stop_spinning.load(AK::memory_order_relaxed)) {
+        for (u32 i = 0; i < 10000; ++i)
+            AK::taint_for_optimizer(i);
+        sched_yield();
+        ++yields;
+    }
+    return nullptr;
+}
+
+static double seconds_since(timespec const& start)
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+int main(int argc, char** argv)
+{
+    Vector<StringView> arguments;
+    arguments.ensure_capacity(argc);
+    for (auto i = 0; i < argc; ++i)
+        arguments.append({ argv[i], strlen(argv[i]) });
+
+    int pair_count = 0;
+    int spinner_count = 0;
+    int round_trips = 20000;
+
+    Core::ArgsParser args_parser;
+    args_parser.add_option(pair_count, "Number of ping-pong thread pairs (default: two per processor)", "pairs", 'p', "number");
+    args_parser.add_option(spinner_count, "Number of spinning threads (default: one per processor)", "spinners", 's', "number");
+    args_parser.add_option(round_trips, "Number of round trips per pair", "round-trips", 'n', "number");
+    args_parser.parse(arguments);
+
+    auto counters_before_or_error = read_scheduler_counters();
+    if (counters_before_or_error.is_error()) {
+        warnln("Couldn't read /sys/kernel/scheduler: {}", counters_before_or_error.error());
+        return EXIT_FAILURE;
+    }
+    auto counters_before = counters_before_or_error.release_value();
+
+    if (pair_count <= 0)
+        pair_count = 2 * counters_before.processors;
+    if (spinner_count < 0)
+        spinner_count = 0;
+    else if (spinner_count == 0)
+        spinner_count = counters_before.processors;
+
+    printf("Running %d ping-pong pairs with %d round trips each and %d spinning threads on %zu processors\n",
+        pair_count, round_trips, spinner_count, counters_before.processors);
+
+    timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    Vector<pthread_t> spinners;
+    Vector<u64> spinner_yields;
+    spinner_yields.resize(spinner_count);
+    for (int i = 0; i < spinner_count; ++i) {
+        pthread_t thread;
+        if (pthread_create(&thread, nullptr, spinning_thread, &spinner_yields[i]) != 0) {
+            perror("pthread_create");
+            return EXIT_FAILURE;
+        }
+        spinners.append(thread);
+    }
+
+    Vector<PingPongPair> pairs;
+    pairs.resize(pair_count);
+    Vector<pthread_t> pair_threads;
+    for (auto& pair : pairs) {
+        pair.round_trips = round_trips;
+        pair.failed = false;
+        if (pipe(pair.ping) < 0 || pipe(pair.pong) < 0) {
+            perror("pipe");
+            return EXIT_FAILURE;
+        }
+        pthread_t ping;
+        pthread_t pong;
+        if (pthread_create(&ping, nullptr, ping_thread, &pair) != 0 || pthread_create(&pong, nullptr, pong_thread, &pair) != 0) {
+            perror("pthread_create");
+            return EXIT_FAILURE;
+        }
+        pair_threads.append(ping);
+        pair_threads.append(pong);
+    }
+
+    for (auto thread : pair_threads)
+        pthread_join(thread, nullptr);
+    auto elapsed = seconds_since(start);
+
+    s_stop_spinning.store(true, AK::memory_order_relaxed);
+    for (auto thread : spinners)
+        pthread_join(thread, nullptr);
+
+    bool failed = false;
+    for (auto& pair : pairs) {
+        failed |= pair.failed;
+        close(pair.ping[0]);
+        close(pair.ping[1]);
+        close(pair.pong[0]);
+        close(pair.pong[1]);
+    }
+
+    u64 total_yields = 0;
+    for (auto yields : spinner_yields)
+        total_yields += yields;
+
+    auto counters_after_or_error = read_scheduler_counters();
+    if (counters_after_or_error.is_error()) {
+        warnln("Couldn't read /sys/kernel/scheduler: {}", counters_after_or_error.error());
+        return EXIT_FAILURE;
+    }
+    auto counters_after = counters_after_or_error.release_value();
+
+    auto context_switches = counters_after.context_switches - counters_before.context_switches;
+    printf("Completed %" PRIu64 " round trips in %.3f s (%.0f round trips/s), spinners yielded %" PRIu64 " times\n",
+        static_cast<u64>(pair_count) * round_trips, elapsed, pair_count * round_trips / elapsed, total_yields);
+    printf("Context switches: %" PRIu64 " (%.0f/s), threads stolen: %" PRIu64 ", migrations: %" PRIu64 ", ready queue lock contentions: %" PRIu64 "\n",
+        context_switches, context_switches / elapsed,
+        counters_after.threads_stolen - counters_before.threads_stolen,
+        counters_after.migrations - counters_before.migrations,
+        counters_after.ready_queue_lock_contentions - counters_before.ready_queue_lock_contentions);
+
+    if (failed) {
+        fprintf(stderr, "FAIL: Some ping-pong pairs didn't see their messages in order\n");
+        return EXIT_FAILURE;
+    }
+    if (context_switches == 0) {
+        fprintf(stderr, "FAIL: The scheduler didn't count any context switches\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("PASS\n");
+    return EXIT_SUCCESS;
+}
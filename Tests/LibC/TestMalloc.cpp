@@ -8,7 +8,9 @@
 
 #include <errno.h>
 #include <mallocdefs.h>
+#include <pthread.h>
 #include <stdlib.h>
+#include <string.h>
 
 TEST_CASE(malloc_limits)
 {
@@ -38,3 +40,81 @@ TEST_CASE(malloc_limits)
         return Test::Crash::Failure::DidNotCrash;
     });
 }
+
+static constexpr size_t number_of_live_allocations = 64;
+
+// Keeps a window of live allocations of mixed small sizes, freeing the oldest one before every new allocation.
+static void allocate_and_free(size_t iterations)
+{
+    void* live[number_of_live_allocations] {};
+    for (size_t i = 0; i < iterations; ++i) {
+        auto& slot = live[i % number_of_live_allocations];
+        free(slot);
+        auto size = 16 + (i * 37) % 2000;
+        slot = malloc(size);
+        VERIFY(slot);
+        memset(slot, 0xab, size);
+    }
+    for (auto* ptr : live)
+        free(ptr);
+}
+
+static void allocate_and_free_on_threads(size_t thread_count, size_t iterations_per_thread)
+{
+    pthread_t threads[8];
+    VERIFY(thread_count <= sizeof(threads) / sizeof(threads[0]));
+
+    for (size_t i = 0; i < thread_count; ++i) {
+        auto rc = pthread_create(
+            &threads[i], nullptr, [](void* iterations) -> void* {
+                allocate_and_free(reinterpret_cast<size_t>(iterations));
+                return nullptr;
+            },
+            reinterpret_cast<void*>(iterations_per_thread));
+        EXPECT_EQ(rc, 0);
+    }
+
+    for (size_t i = 0; i < thread_count; ++i)
+        EXPECT_EQ(pthread_join(threads[i], nullptr), 0);
+}
+
+TEST_CASE(malloc_from_many_threads)
+{
+    allocate_and_free_on_threads(4, 10'000);
+}
+
+TEST_CASE(free_from_another_thread)
+{
+    static constexpr size_t count = 1000;
+    static void* pointers[count];
+
+    for (size_t i = 0; i < count; ++i) {
+        pointers[i] = malloc(32);
+        EXPECT(pointers[i] != nullptr);
+        memset(pointers[i], static_cast<int>(i), 32);
+    }
+
+    pthread_t thread;
+    auto rc = pthread_create(
+        &thread, nullptr, [](void*) -> void* {
+            for (auto* ptr : pointers)
+                free(ptr);
+            return nullptr;
+        },
+        nullptr);
+    EXPECT_EQ(rc, 0);
+    EXPECT_EQ(pthread_join(thread, nullptr), 0);
+
+    // The chunks the other thread kept around when it exited must be usable again.
+    allocate_and_free(10'000);
+}
+
+BENCHMARK_CASE(malloc_from_one_thread)
+{
+    allocate_and_free_on_threads(1, 1'000'000);
+}
+
+BENCHMARK_CASE(malloc_from_four_threads)
+{
+    allocate_and_free_on_threads(4, 1'000'000);
+}
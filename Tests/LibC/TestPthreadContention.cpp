@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Atomic.h>
+#include <AK/NumericLimits.h>
+#include <AK/Vector.h>
+#include <LibTest/TestCase.h>
+#include <pthread.h>
+#include <serenity.h>
+#include <unistd.h>
+
+// One thread per processor, so that the threads really contend with each other instead of taking turns.
+static size_t contending_thread_count()
+{
+    return max(sysconf(_SC_NPROCESSORS_ONLN), 2l);
+}
+
+// Runs `callback` with the index of each thread on `count` threads at once, and waits for all of them.
+template<typename Callback>
+static void run_on_threads(size_t count, Callback callback)
+{
+    struct Thread {
+        Callback* callback;
+        size_t index;
+        pthread_t thread;
+    };
+    Vector<Thread> threads;
+    threads.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        threads[i] = { &callback, i, 0 };
+        auto rc = pthread_create(
+            &threads[i].thread, nullptr, [](void* argument) -> void* {
+                auto& thread = *static_cast<Thread*>(argument);
+                (*thread.callback)(thread.index);
+                return nullptr;
+            },
+            &threads[i]);
+        VERIFY(rc == 0);
+    }
+    for (auto& thread : threads)
+        EXPECT_EQ(pthread_join(thread.thread, nullptr), 0);
+}
+
+static void increment_under_contention(size_t iterations_per_thread)
+{
+    pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+    size_t counter = 0;
+    auto thread_count = contending_thread_count();
+    run_on_threads(thread_count, [&](size_t) {
+        for (size_t i = 0; i < iterations_per_thread; ++i) {
+            pthread_mutex_lock(&mutex);
+            ++counter;
+            pthread_mutex_unlock(&mutex);
+        }
+    });
+    EXPECT_EQ(counter, thread_count * iterations_per_thread);
+}
+
+// Half of the threads hand items to the other half through a small queue, which makes them wait on each other a lot.
+static void hand_over_under_contention(size_t items_per_producer)
+{
+    static constexpr size_t queue_capacity = 16;
+    pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+    pthread_cond_t not_empty = PTHREAD_COND_INITIALIZER;
+    pthread_cond_t not_full = PTHREAD_COND_INITIALIZER;
+    size_t queued = 0;
+    size_t consumed = 0;
+
+    auto producer_count = contending_thread_count() / 2;
+    run_on_threads(producer_count * 2, [&](size_t index) {
+        bool is_producer = index % 2 == 0;
+        for (size_t i = 0; i < items_per_producer; ++i) {
+            pthread_mutex_lock(&mutex);
+            if (is_producer) {
+                while (queued == queue_capacity)
+                    pthread_cond_wait(&not_full, &mutex);
+                ++queued;
+                pthread_cond_signal(&not_empty);
+            } else {
+                while (queued == 0)
+                    pthread_cond_wait(&not_empty, &mutex);
+                --queued;
+                ++consumed;
+                pthread_cond_signal(&not_full);
+            }
+            pthread_mutex_unlock(&mutex);
+        }
+    });
+    EXPECT_EQ(queued, 0u);
+    EXPECT_EQ(consumed, producer_count * items_per_producer);
+}
+
+// The threads take turns in a fixed order, each waiting on the futex until it's its turn. A wake that comes in between
+// a thread checking the futex value and actually blocking must not get lost, or that thread never gets its turn.
+static void take_turns_on_futex(size_t turns_per_thread)
+{
+    u32 turn = 0;
+    auto thread_count = contending_thread_count();
+    run_on_threads(thread_count, [&](size_t index) {
+        for (size_t i = 0; i < turns_per_thread; ++i) {
+            u32 value = AK::atomic_load(&turn, AK::memory_order_acquire);
+            while (value % thread_count != index) {
+                futex_wait(&turn, value, nullptr, 0, false);
+                value = AK::atomic_load(&turn, AK::memory_order_acquire);
+            }
+            AK::atomic_store(&turn, value + 1, AK::memory_order_release);
+            futex_wake(&turn, NumericLimits<u32>::max(), false);
+        }
+    });
+    EXPECT_EQ(turn, thread_count * turns_per_thread);
+}
+
+TEST_CASE(contended_mutex_is_exclusive)
+{
+    increment_under_contention(10'000);
+}
+
+TEST_CASE(contended_condition_variable_hands_over_everything)
+{
+    hand_over_under_contention(10'000);
+}
+
+TEST_CASE(contended_futex_wakes_are_not_lost)
+{
+    take_turns_on_futex(2'000);
+}
+
+BENCHMARK_CASE(contended_mutex)
+{
+    increment_under_contention(1'000'000);
+}
+
+BENCHMARK_CASE(contended_condition_variable)
+{
+    hand_over_under_contention(200'000);
+}
@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Vector.h>
+#include <LibCore/EventLoop.h>
+#include <LibCore/Notifier.h>
+#include <LibCore/Timer.h>
+#include <LibTest/TestCase.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+struct Connection {
+    int fds[2] { -1, -1 };
+    RefPtr<Core::Notifier> notifier;
+    int round_trips { 0 };
+};
+
+static void close_connections(Vector<Connection>& connections)
+{
+    for (auto& connection : connections) {
+        connection.notifier = nullptr;
+        close(connection.fds[0]);
+        close(connection.fds[1]);
+    }
+    connections.clear();
+}
+
+// Opens up to `count` connections that are watched for reading, but stops early once we run out of file descriptors.
+static Vector<Connection> open_connections(size_t count, Function<void(Connection&)>& on_activation)
+{
+    // Leave some file descriptors for everything else.
+    static constexpr size_t spare_connections = 16;
+
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur != limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        (void)setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    Vector<Connection> connections;
+    connections.ensure_capacity(count + spare_connections);
+    while (connections.size() < count + spare_connections) {
+        Connection connection;
+        if (socketpair(AF_LOCAL, SOCK_STREAM, 0, connection.fds) < 0)
+            break;
+        connections.append(move(connection));
+    }
+    auto kept_count = min(count, connections.size() > spare_connections ? connections.size() - spare_connections : 0);
+    while (connections.size() > kept_count) {
+        auto connection = connections.take_last();
+        close(connection.fds[0]);
+        close(connection.fds[1]);
+    }
+
+    for (auto& connection : connections) {
+        connection.notifier = Core::Notifier::construct(connection.fds[0], Core::Notifier::Type::Read);
+        connection.notifier->on_activation = [&connection, &on_activation] { on_activation(connection); };
+    }
+    return connections;
+}
+
+static void send_byte(Connection& connection)
+{
+    char byte = 'x';
+    VERIFY(write(connection.fds[1], &byte, 1) == 1);
+}
+
+static void receive_byte(Connection& connection)
+{
+    char byte = 0;
+    VERIFY(read(connection.fds[0], &byte, 1) == 1);
+}
+
+// Keeps a few connections busy with round trips through the event loop while many more connections stay idle.
+static void run_idle_and_active_connections(size_t idle_count, size_t active_count, int round_trips_per_connection)
+{
+    Core::EventLoop event_loop;
+
+    size_t finished_count = 0;
+    Function<void(Connection&)> on_active_activation = [&](Connection& connection) {
+        receive_byte(connection);
+        if (++connection.round_trips < round_trips_per_connection) {
+            send_byte(connection);
+            return;
+        }
+        connection.notifier->set_enabled(false);
+        if (++finished_count == active_count)
+            event_loop.quit(0);
+    };
+    auto active_connections = open_connections(active_count, on_active_activation);
+    VERIFY(active_connections.size() == active_count);
+
+    auto idle_activations = 0;
+    Function<void(Connection&)> on_idle_activation = [&](Connection&) { ++idle_activations; };
+    auto idle_connections = open_connections(idle_count, on_idle_activation);
+
+    for (auto& connection : active_connections)
+        send_byte(connection);
+
+    auto catchall_timer = MUST(Core::Timer::create_single_shot(60'000, [&] {
+        FAIL("Timed out waiting for the active connections");
+        event_loop.quit(1);
+    }));
+    catchall_timer->start();
+
+    EXPECT_EQ(event_loop.exec(), 0);
+    EXPECT_EQ(idle_activations, 0);
+    for (auto& connection : active_connections)
+        EXPECT_EQ(connection.round_trips, round_trips_per_connection);
+
+    close_connections(active_connections);
+    close_connections(idle_connections);
+}
+
+TEST_CASE(notifiers_only_fire_for_ready_file_descriptors)
+{
+    run_idle_and_active_connections(100, 2, 100);
+}
+
+TEST_CASE(disabled_notifiers_do_not_fire)
+{
+    Core::EventLoop event_loop;
+
+    int fds[2];
+    EXPECT_EQ(socketpair(AF_LOCAL, SOCK_STREAM, 0, fds), 0);
+
+    auto read_activations = 0;
+    auto read_notifier = Core::Notifier::construct(fds[0], Core::Notifier::Type::Read);
+    read_notifier->on_activation = [&] {
+        ++read_activations;
+        event_loop.quit(0);
+    };
+
+    // Two notifiers on the same fd must not step on each other.
+    auto write_activations = 0;
+    auto write_notifier = Core::Notifier::construct(fds[0], Core::Notifier::Type::Write);
+    write_notifier->on_activation = [&] {
+        ++write_activations;
+        write_notifier->set_enabled(false);
+        char byte = 'x';
+        EXPECT_EQ(write(fds[1], &byte, 1), 1);
+    };
+
+    read_notifier->set_enabled(false);
+    auto timer = MUST(Core::Timer::create_single_shot(100, [&] {
+        EXPECT_EQ(read_activations, 0);
+        read_notifier->set_enabled(true);
+    }));
+    timer->start();
+
+    EXPECT_EQ(event_loop.exec(), 0);
+    EXPECT_EQ(read_activations, 1);
+    EXPECT_EQ(write_activations, 1);
+
+    read_notifier->set_enabled(false);
+    close(fds[0]);
+    close(fds[1]);
+}
+
+TEST_CASE(notifiers_can_change_type_while_enabled)
+{
+    Core::EventLoop event_loop;
+
+    int fds[2];
+    EXPECT_EQ(socketpair(AF_LOCAL, SOCK_STREAM, 0, fds), 0);
+
+    // Nothing is ever written to the socket, so only the switch to watching for writability lets this fire.
+    auto activations = 0;
+    auto notifier = Core::Notifier::construct(fds[0], Core::Notifier::Type::Read);
+    notifier->on_activation = [&] {
+        ++activations;
+        notifier->set_enabled(false);
+        event_loop.quit(0);
+    };
+    notifier->set_type(Core::Notifier::Type::Write);
+    notifier->set_enabled(true);
+
+    auto catchall_timer = MUST(Core::Timer::create_single_shot(5'000, [&] {
+        FAIL("Timed out waiting for the notifier");
+        event_loop.quit(1);
+    }));
+    catchall_timer->start();
+
+    EXPECT_EQ(event_loop.exec(), 0);
+    EXPECT_EQ(activations, 1);
+
+    // Switching back while disabled must not leave anything behind that could fire.
+    notifier->set_type(Core::Notifier::Type::Read);
+    char byte = 'x';
+    EXPECT_EQ(write(fds[1], &byte, 1), 1);
+    auto timer = MUST(Core::Timer::create_single_shot(100, [&] { event_loop.quit(0); }));
+    timer->start();
+    EXPECT_EQ(event_loop.exec(), 0);
+    EXPECT_EQ(activations, 1);
+
+    close(fds[0]);
+    close(fds[1]);
+}
+
+BENCHMARK_CASE(idle_and_active_connections)
+{
+    // NOTE: This opens as many of the idle connections as we have file descriptors for.
+    run_idle_and_active_connections(10'000, 4, 10'000);
+}
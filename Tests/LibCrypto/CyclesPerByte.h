@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Format.h>
+#include <AK/Platform.h>
+#include <AK/StringView.h>
+#include <time.h>
+
+// Prints how many CPU cycles were spent per byte of input between construction and destruction,
+// which is how cipher speed is usually compared. Without a cycle counter, this reports nanoseconds instead.
+class CyclesPerByte {
+public:
+    CyclesPerByte(StringView name, size_t byte_count)
+        : m_name(name)
+        , m_byte_count(byte_count)
+        , m_start(now())
+    {
+    }
+
+    ~CyclesPerByte()
+    {
+        auto elapsed = now() - m_start;
+        outln("{}: {:.2} {} per byte", m_name, static_cast<double>(elapsed) / m_byte_count, unit);
+    }
+
+private:
+#if ARCH(X86_64)
+    static constexpr StringView unit = "cycles"sv;
+    static u64 now() { return __builtin_ia32_rdtsc(); }
+#else
+    static constexpr StringView unit = "ns"sv;
+    static u64 now()
+    {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<u64>(ts.tv_sec) * 1'000'000'000 + ts.tv_nsec;
+    }
+#endif
+
+    StringView m_name;
+    size_t m_byte_count { 0 };
+    u64 m_start { 0 };
+};
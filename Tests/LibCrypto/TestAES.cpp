@@ -4,6 +4,7 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include "CyclesPerByte.h"
 #include <LibCrypto/BigInt/UnsignedBigInteger.h>
 #include <LibCrypto/Checksum/Adler32.h>
 #include <LibCrypto/Cipher/AES.h>
@@ -454,3 +455,20 @@ TEST_CASE(test_AES_GCM_128bit_decrypt_multiple_blocks_with_aad)
     EXPECT(memcmp(result_pt, out.data(), out.size()) == 0);
     EXPECT_EQ(consistency, Crypto::VerificationConsistency::Consistent);
 }
+
+BENCHMARK_CASE(AES_GCM_128bit_encrypt_1MiB)
+{
+    u8 key[16] {};
+    u8 iv[16] {};
+    u8 aad[13] {};
+    u8 tag[16];
+    auto plaintext = MUST(ByteBuffer::create_zeroed(1 * MiB));
+    auto ciphertext = MUST(ByteBuffer::create_uninitialized(1 * MiB));
+
+    Crypto::Cipher::AESCipher::GCMMode cipher(ReadonlyBytes { key, 16 }, 128, Crypto::Cipher::Intent::Encryption);
+    CyclesPerByte cycles_per_byte("AES-128-GCM encrypt"sv, 64 * plaintext.size());
+    for (size_t i = 0; i < 64; ++i) {
+        iv[11] = static_cast<u8>(i);
+        cipher.encrypt(plaintext, ciphertext.bytes(), { iv, 16 }, { aad, 13 }, { tag, 16 });
+    }
+}
@@ -201,6 +201,45 @@ TEST_CASE(test_unsigned_bigint_multiplication_with_big_numbers2)
     EXPECT_EQ(result.words(), expected_result);
 }
 
+TEST_CASE(test_unsigned_bigint_karatsuba_multiplication)
+{
+    // (2^n - 1)^2 = 2^2n - 2^(n+1) + 1, with n large enough to go through the Karatsuba path.
+    auto one = Crypto::UnsignedBigInteger { 1 };
+    auto all_ones = one.shift_left(4096).minus(one);
+    auto expected = one.shift_left(8192).minus(one.shift_left(4097)).plus(one);
+    EXPECT_EQ(all_ones.multiplied_by(all_ones), expected);
+
+    // Unbalanced operands: (2^n - 1) * (2^m - 1) = 2^(n+m) - 2^n - 2^m + 1
+    auto shorter_ones = one.shift_left(1500).minus(one);
+    expected = one.shift_left(5596).minus(one.shift_left(4096)).minus(one.shift_left(1500)).plus(one);
+    EXPECT_EQ(all_ones.multiplied_by(shorter_ones), expected);
+    EXPECT_EQ(shorter_ones.multiplied_by(all_ones), expected);
+
+    auto num1 = bigint_fibonacci(9000);
+    auto num2 = bigint_fibonacci(7000);
+    EXPECT_EQ(num1.multiplied_by(num2).divided_by(num2).quotient, num1);
+}
+
+TEST_CASE(test_unsigned_bigint_multiplication_reuses_scratch)
+{
+    // The scratch words are left over from a larger multiplication, which must not leak into smaller ones.
+    auto one = Crypto::UnsignedBigInteger { 1 };
+    auto all_ones = one.shift_left(4096).minus(one);
+    auto small = bigint_fibonacci(200);
+    Crypto::UnsignedBigIntegerAlgorithms::MultiplicationScratch temp_words;
+    Crypto::UnsignedBigInteger result;
+
+    Crypto::UnsignedBigIntegerAlgorithms::multiply_without_allocation(all_ones, all_ones, temp_words, result);
+    EXPECT_EQ(result, one.shift_left(8192).minus(one.shift_left(4097)).plus(one));
+    auto scratch_size = temp_words.size();
+
+    Crypto::UnsignedBigIntegerAlgorithms::multiply_without_allocation(small, small, temp_words, result);
+    EXPECT_EQ(result, small.multiplied_by(small));
+    Crypto::UnsignedBigIntegerAlgorithms::multiply_without_allocation(all_ones, small, temp_words, result);
+    EXPECT_EQ(result, small.multiplied_by(all_ones));
+    EXPECT_EQ(temp_words.size(), scratch_size);
+}
+
 TEST_CASE(test_unsigned_bigint_simple_division)
 {
     Crypto::UnsignedBigInteger num1(27194);
@@ -331,6 +370,23 @@ TEST_CASE(test_bigint_modular_power_extra_tests)
     }
 }
 
+TEST_CASE(test_bigint_montgomery_modular_power_matches_simple_modular_power)
+{
+    auto base = bigint_fibonacci(2000);
+    auto exponent = bigint_fibonacci(500);
+    auto modulo = bigint_fibonacci(1000).plus(bigint_fibonacci(1000).is_odd() ? 0 : 1);
+
+    auto ep = exponent;
+    auto reduced_base = base.divided_by(modulo).remainder;
+    Crypto::UnsignedBigInteger temp_1, temp_2, temp_3, temp_4, temp_multiply, temp_quotient, temp_remainder, expected;
+    Crypto::UnsignedBigIntegerAlgorithms::MultiplicationScratch temp_words;
+    Crypto::UnsignedBigIntegerAlgorithms::destructive_modular_power_without_allocation(ep, reduced_base, modulo, temp_1, temp_2, temp_3, temp_4, temp_multiply, temp_words, temp_quotient, temp_remainder, expected);
+
+    EXPECT_EQ(Crypto::NumberTheory::ModularPower(base, exponent, modulo), expected);
+    EXPECT_EQ(Crypto::NumberTheory::ModularPower(base, 0, modulo), 1);
+    EXPECT_EQ(Crypto::NumberTheory::ModularPower(base, 1, modulo), base.divided_by(modulo).remainder);
+}
+
 TEST_CASE(test_bigint_primality_test)
 {
     struct {
@@ -1015,6 +1071,53 @@ TEST_CASE(unsigned_bigint_double_comparisons)
 #undef EXPECT_EQUAL_TO
 }
 
+static void benchmark_modular_power(size_t modulo_fibonacci_index, Crypto::UnsignedBigInteger const& exponent)
+{
+    // Any odd modulo takes the same path as an RSA private or public key operation.
+    auto modulo = bigint_fibonacci(modulo_fibonacci_index);
+    modulo.set_bit_inplace(0);
+    auto base = bigint_fibonacci(modulo_fibonacci_index - 7);
+
+    for (size_t i = 0; i < 4; ++i)
+        base = Crypto::NumberTheory::ModularPower(base, exponent, modulo);
+    EXPECT(base < modulo);
+}
+
+// Fibonacci numbers grow by ~0.694 bits per step, so F(2950) and F(5900) are 2048 and 4096 bits long.
+BENCHMARK_CASE(rsa_2048_private_exponent)
+{
+    benchmark_modular_power(2950, bigint_fibonacci(2945));
+}
+
+BENCHMARK_CASE(rsa_2048_public_exponent)
+{
+    benchmark_modular_power(2950, 65537);
+}
+
+BENCHMARK_CASE(rsa_4096_private_exponent)
+{
+    benchmark_modular_power(5900, bigint_fibonacci(5895));
+}
+
+BENCHMARK_CASE(rsa_4096_public_exponent)
+{
+    benchmark_modular_power(5900, 65537);
+}
+
+BENCHMARK_CASE(bigint_factorial)
+{
+    Crypto::UnsignedBigInteger factorial { 1 };
+    for (u32 i = 2; i <= 3000; ++i)
+        factorial = factorial.multiplied_by(i);
+    EXPECT_EQ(factorial.one_based_index_of_highest_set_bit(), 30332u);
+}
+
+BENCHMARK_CASE(bigint_power)
+{
+    auto result = Crypto::NumberTheory::Power(Crypto::UnsignedBigInteger { 3 }, Crypto::UnsignedBigInteger { 100000 });
+    EXPECT_EQ(result.one_based_index_of_highest_set_bit(), 158497u);
+}
+
 namespace AK {
 
 template<>
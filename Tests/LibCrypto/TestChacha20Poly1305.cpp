@@ -4,6 +4,7 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include "CyclesPerByte.h"
 #include <AK/ByteBuffer.h>
 #include <AK/String.h>
 #include <LibCrypto/AEAD/ChaCha20Poly1305.h>
@@ -207,3 +208,53 @@ TEST_CASE(test_aead_encrypt_and_decrypt)
     EXPECT(Crypto::AEAD::ChaCha20Poly1305::verify_tag(encrypted, decrypted));
     EXPECT_EQ(decrypted.bytes().slice(0, encrypted.bytes().size() - 16), plaintext.bytes());
 }
+
+TEST_CASE(test_aead_encrypt_and_decrypt_into_buffers)
+{
+    u8 aad[12] = { 0x50, 0x51, 0x52, 0x53, 0xc0, 0xc1, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7 };
+    u8 key[32] = {
+        0x80, 0x81, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x8b, 0x8c, 0x8d, 0x8e, 0x8f,
+        0x90, 0x91, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0x9b, 0x9c, 0x9d, 0x9e, 0x9f
+    };
+    u8 nonce[12] = { 0x07, 0x00, 0x00, 0x00, 0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47 };
+
+    // A multiple of the Poly1305 block size, so that no padding is needed after the ciphertext.
+    u8 plaintext[320];
+    for (size_t i = 0; i < sizeof(plaintext); ++i)
+        plaintext[i] = static_cast<u8>(i);
+
+    Crypto::AEAD::ChaCha20Poly1305 aead(ReadonlyBytes { key, 32 }, ReadonlyBytes { nonce, 12 });
+    auto expected = MUST(aead.encrypt(ReadonlyBytes { aad, 12 }, ReadonlyBytes { plaintext, sizeof(plaintext) }));
+
+    u8 ciphertext[sizeof(plaintext)];
+    u8 tag[16];
+    aead.encrypt(ReadonlyBytes { plaintext, sizeof(plaintext) }, Bytes { ciphertext, sizeof(ciphertext) }, ReadonlyBytes { nonce, 12 }, ReadonlyBytes { aad, 12 }, Bytes { tag, 16 });
+    EXPECT_EQ(ReadonlyBytes(ciphertext, sizeof(ciphertext)), expected.bytes().slice(0, sizeof(plaintext)));
+    EXPECT_EQ(ReadonlyBytes(tag, 16), expected.bytes().slice_from_end(16));
+
+    u8 decrypted[sizeof(plaintext)];
+    auto consistency = aead.decrypt(ReadonlyBytes { ciphertext, sizeof(ciphertext) }, Bytes { decrypted, sizeof(decrypted) }, ReadonlyBytes { nonce, 12 }, ReadonlyBytes { aad, 12 }, ReadonlyBytes { tag, 16 });
+    EXPECT_EQ(consistency, Crypto::VerificationConsistency::Consistent);
+    EXPECT_EQ(ReadonlyBytes(decrypted, sizeof(decrypted)), ReadonlyBytes(plaintext, sizeof(plaintext)));
+
+    ciphertext[100] ^= 1;
+    consistency = aead.decrypt(ReadonlyBytes { ciphertext, sizeof(ciphertext) }, Bytes { decrypted, sizeof(decrypted) }, ReadonlyBytes { nonce, 12 }, ReadonlyBytes { aad, 12 }, ReadonlyBytes { tag, 16 });
+    EXPECT_EQ(consistency, Crypto::VerificationConsistency::Inconsistent);
+}
+
+BENCHMARK_CASE(chacha20_poly1305_encrypt_1MiB)
+{
+    u8 key[32] {};
+    u8 nonce[12] {};
+    u8 aad[13] {};
+    u8 tag[16];
+    auto plaintext = MUST(ByteBuffer::create_zeroed(1 * MiB));
+    auto ciphertext = MUST(ByteBuffer::create_uninitialized(1 * MiB));
+
+    Crypto::AEAD::ChaCha20Poly1305 aead(ReadonlyBytes { key, 32 });
+    CyclesPerByte cycles_per_byte("ChaCha20-Poly1305 encrypt"sv, 64 * plaintext.size());
+    for (size_t i = 0; i < 64; ++i) {
+        nonce[11] = static_cast<u8>(i);
+        aead.encrypt(plaintext, ciphertext, ReadonlyBytes { nonce, 12 }, ReadonlyBytes { aad, 13 }, Bytes { tag, 16 });
+    }
+}
@@ -303,3 +303,31 @@ TEST_CASE(test_vector_11)
     auto expected = ReadonlyBytes { expected_result, 16 };
     EXPECT_EQ(result, expected);
 }
+
+TEST_CASE(test_incremental_updates_match_single_update)
+{
+    u8 key[32];
+    for (size_t i = 0; i < 32; ++i)
+        key[i] = static_cast<u8>(i * 7 + 3);
+
+    u8 message[300];
+    for (size_t i = 0; i < 300; ++i)
+        message[i] = static_cast<u8>(i * 13);
+
+    for (size_t length : { 0, 15, 16, 17, 64, 255, 256, 300 }) {
+        Crypto::Authentication::Poly1305 single(ReadonlyBytes { key, 32 });
+        single.update(ReadonlyBytes { message, length });
+        auto expected = MUST(single.digest());
+
+        // Feed the message in uneven pieces so that partial blocks get carried over between updates.
+        Crypto::Authentication::Poly1305 incremental(ReadonlyBytes { key, 32 });
+        size_t offset = 0;
+        for (size_t piece = 1; offset < length; ++piece) {
+            auto piece_length = min(piece * 5, length - offset);
+            incremental.update(ReadonlyBytes { message + offset, piece_length });
+            offset += piece_length;
+        }
+        auto result = MUST(incremental.digest());
+        EXPECT_EQ(result, expected);
+    }
+}
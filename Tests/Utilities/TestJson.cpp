@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/StringView.h>
+#include <LibCore/Command.h>
+#include <LibTest/Macros.h>
+#include <LibTest/TestCase.h>
+
+struct JsonResult {
+    bool succeeded { false };
+    ByteBuffer standard_output;
+};
+
+static JsonResult run_json(StringView standard_input)
+{
+    char const* arguments[] = { "json", nullptr };
+    auto json = MUST(Core::Command::create("json"sv, arguments));
+    MUST(json->write(standard_input));
+    auto [stdout, stderr] = MUST(json->read_all());
+    auto status = MUST(json->status());
+    return { status == Core::Command::ProcessResult::DoneWithZeroExitCode, move(stdout) };
+}
+
+TEST_CASE(pretty_prints)
+{
+    auto result = run_json("{\"a\":[1,true,null],\"b\":{},\"c\":\"d\"}"sv);
+    EXPECT(result.succeeded);
+    EXPECT_EQ(StringView { result.standard_output.bytes() }, "{\n    \"a\": [\n        1,\n        true,\n        null\n    ],\n    \"b\": {\n    },\n    \"c\": \"d\"\n}\n"sv);
+}
+
+TEST_CASE(malformed_input_prints_nothing)
+{
+    auto result = run_json("{\"a\":[1,2,3],\"b\": ]"sv);
+    EXPECT(!result.succeeded);
+    EXPECT(result.standard_output.is_empty());
+}
+
+TEST_CASE(duplicate_keys_keep_the_last_value)
+{
+    auto result = run_json("{\"a\":1,\"b\":2,\"a\":3}"sv);
+    EXPECT(result.succeeded);
+    EXPECT_EQ(StringView { result.standard_output.bytes() }, "{\n    \"a\": 3,\n    \"b\": 2\n}\n"sv);
+}
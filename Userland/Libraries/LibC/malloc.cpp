@@ -115,6 +115,11 @@ struct MallocStats {
     size_t number_of_hot_keeps;
     size_t number_of_cold_keeps;
     size_t number_of_frees;
+
+    size_t number_of_thread_cache_hits;
+    size_t number_of_thread_cache_misses;
+    size_t number_of_thread_cache_free_hits;
+    size_t number_of_thread_cache_flushes;
 };
 static MallocStats g_malloc_stats = {};
 
@@ -293,81 +298,12 @@ enum class CallerWillInitializeMemory {
 __thread bool s_allocation_enabled = true;
 #endif
 
-static ErrorOr<void*> malloc_impl(size_t size, size_t align, CallerWillInitializeMemory caller_will_initialize_memory)
+// Must be called with s_malloc_mutex held.
+static ErrorOr<void*> allocate_chunk(Allocator& allocator, size_t good_size, size_t align)
 {
-#ifndef NO_TLS
-    VERIFY(s_allocation_enabled);
-#endif
-
-    // Align must be a power of 2.
-    if (popcount(align) != 1)
-        return EINVAL;
-
-    // FIXME: Support larger than 32KiB alignments (if you dare).
-    if (sizeof(BigAllocationBlock) + align >= ChunkedBlock::block_size)
-        return EINVAL;
-
-    if (s_log_malloc)
-        dbgln("LibC: malloc({})", size);
-
-    if (!size) {
-        // Legally we could just return a null pointer here, but this is more
-        // compatible with existing software.
-        size = 1;
-    }
-
-    g_malloc_stats.number_of_malloc_calls++;
-
-    size_t good_size;
-    auto* allocator = allocator_for_size(size, good_size, align);
-
-    PthreadMutexLocker locker(s_malloc_mutex);
-
-    if (!allocator) {
-        size_t real_size = round_up_to_power_of_two(sizeof(BigAllocationBlock) + size + ((align > 16) ? align : 0), ChunkedBlock::block_size);
-        if (real_size < size) {
-            dbgln_if(MALLOC_DEBUG, "LibC: Detected overflow trying to do big allocation of size {} for {}", real_size, size);
-            return ENOMEM;
-        }
-#ifdef RECYCLE_BIG_ALLOCATIONS
-        if (auto* allocator = big_allocator_for_size(real_size)) {
-            if (!allocator->blocks.is_empty()) {
-                g_malloc_stats.number_of_big_allocator_hits++;
-                auto* block = allocator->blocks.take_last();
-                int rc = madvise(block, real_size, MADV_SET_NONVOLATILE);
-                bool this_block_was_purged = rc == 1;
-                if (rc < 0) {
-                    perror("madvise");
-                    VERIFY_NOT_REACHED();
-                }
-                if (mprotect(block, real_size, PROT_READ | PROT_WRITE) < 0) {
-                    perror("mprotect");
-                    VERIFY_NOT_REACHED();
-                }
-                if (this_block_was_purged) {
-                    g_malloc_stats.number_of_big_allocator_purge_hits++;
-                    new (block) BigAllocationBlock(real_size);
-                }
-
-                void* ptr = reinterpret_cast<void*>(round_up_to_power_of_two(reinterpret_cast<uintptr_t>(&block->m_slot[0]), align));
-
-                ue_notify_malloc(ptr, size);
-                return ptr;
-            }
-        }
-#endif
-        auto* block = (BigAllocationBlock*)TRY(os_alloc(real_size, "malloc: BigAllocationBlock"));
-        g_malloc_stats.number_of_big_allocs++;
-        new (block) BigAllocationBlock(real_size);
-
-        void* ptr = reinterpret_cast<void*>(round_up_to_power_of_two(reinterpret_cast<uintptr_t>(&block->m_slot[0]), align));
-        ue_notify_malloc(ptr, size);
-        return ptr;
-    }
-
     ChunkedBlock* block = nullptr;
     void* ptr = nullptr;
-    for (auto& current : allocator->usable_blocks) {
+    for (auto& current : allocator.usable_blocks) {
         if (current.free_chunks()) {
             ptr = try_allocate_chunk_aligned(align, current);
             if (ptr) {
@@ -387,7 +323,7 @@ static ErrorOr<void*> malloc_impl(size_t size, size_t align, CallerWillInitializ
             snprintf(buffer, sizeof(buffer), "malloc: ChunkedBlock(%zu)", good_size);
             set_mmap_name(block, ChunkedBlock::block_size, buffer);
         }
-        allocator->usable_blocks.append(*block);
+        allocator.usable_blocks.append(*block);
     }
 
     if (!block && s_cold_empty_block_count) {
@@ -410,7 +346,7 @@ static ErrorOr<void*> malloc_impl(size_t size, size_t align, CallerWillInitializ
             new (block) ChunkedBlock(good_size);
             ue_notify_chunk_size_changed(block, good_size);
         }
-        allocator->usable_blocks.append(*block);
+        allocator.usable_blocks.append(*block);
     }
 
     if (!block) {
@@ -419,8 +355,8 @@ static ErrorOr<void*> malloc_impl(size_t size, size_t align, CallerWillInitializ
         snprintf(buffer, sizeof(buffer), "malloc: ChunkedBlock(%zu)", good_size);
         block = (ChunkedBlock*)TRY(os_alloc(ChunkedBlock::block_size, buffer));
         new (block) ChunkedBlock(good_size);
-        allocator->usable_blocks.append(*block);
-        ++allocator->block_count;
+        allocator.usable_blocks.append(*block);
+        ++allocator.block_count;
     }
 
     if (!ptr) {
@@ -431,69 +367,235 @@ static ErrorOr<void*> malloc_impl(size_t size, size_t align, CallerWillInitializ
     if (block->is_full()) {
         g_malloc_stats.number_of_blocks_full++;
         dbgln_if(MALLOC_DEBUG, "Block {:p} is now full in size class {}", block, good_size);
-        allocator->usable_blocks.remove(*block);
-        allocator->full_blocks.append(*block);
+        allocator.usable_blocks.remove(*block);
+        allocator.full_blocks.append(*block);
     }
     dbgln_if(MALLOC_DEBUG, "LibC: allocated {:p} (chunk in block {:p}, size {})", ptr, block, block->bytes_per_chunk());
 
-    if (s_scrub_malloc && caller_will_initialize_memory == CallerWillInitializeMemory::No)
-        memset(ptr, MALLOC_SCRUB_BYTE, block->m_size);
-
-    ue_notify_malloc(ptr, size);
     return ptr;
 }
 
-static void free_impl(void* ptr)
+#ifndef NO_TLS
+// Every thread keeps a magazine of free chunks for each of the smaller size classes, so that most calls to malloc()
+// and free() don't have to take s_malloc_mutex. Magazines are refilled from and flushed to the blocks in batches of
+// half their capacity. Chunks freed by another thread than the one that allocated them simply end up in that
+// thread's magazine, as blocks aren't owned by any thread.
+constexpr size_t thread_cache_max_chunk_size = 4096;
+constexpr size_t thread_cache_bytes_per_size_class = 8 * KiB;
+constexpr size_t thread_cache_min_magazine_size = 4;
+constexpr size_t thread_cache_max_magazine_size = 32;
+
+consteval size_t number_of_thread_cached_size_classes()
+{
+    size_t count = 0;
+    while (size_classes[count] && size_classes[count] <= thread_cache_max_chunk_size)
+        ++count;
+    return count;
+}
+
+static constexpr size_t magazine_capacity(size_t chunk_size)
+{
+    return clamp(thread_cache_bytes_per_size_class / chunk_size, thread_cache_min_magazine_size, thread_cache_max_magazine_size);
+}
+
+struct Magazine {
+    size_t count;
+    void* chunks[thread_cache_max_magazine_size];
+};
+
+struct ThreadCacheStats {
+    size_t hits;
+    size_t misses;
+    size_t free_hits;
+    size_t flushes;
+};
+
+// This has to stay trivially constructible, as it can't rely on constructors running for new threads.
+struct ThreadCache {
+    Magazine magazines[number_of_thread_cached_size_classes()];
+    ThreadCacheStats stats;
+    bool is_disabled;
+};
+
+static __thread ThreadCache s_thread_cache;
+
+static Magazine* magazine_for_chunk_size(size_t chunk_size)
+{
+    if (s_thread_cache.is_disabled)
+        return nullptr;
+    for (size_t i = 0; i < number_of_thread_cached_size_classes(); ++i) {
+        if (size_classes[i] == chunk_size)
+            return &s_thread_cache.magazines[i];
+    }
+    return nullptr;
+}
+
+// Must be called with s_malloc_mutex held.
+static void fold_thread_cache_stats()
+{
+    auto& stats = s_thread_cache.stats;
+    g_malloc_stats.number_of_thread_cache_hits += stats.hits;
+    g_malloc_stats.number_of_thread_cache_misses += stats.misses;
+    g_malloc_stats.number_of_thread_cache_free_hits += stats.free_hits;
+    g_malloc_stats.number_of_thread_cache_flushes += stats.flushes;
+    stats = {};
+}
+
+static void free_chunk(ChunkedBlock*, void*);
+
+// Only chunks from the regular, 16-byte aligned size classes go through the thread cache.
+static ErrorOr<void*> allocate_from_thread_cache(Allocator& allocator, Magazine& magazine)
+{
+    if (magazine.count > 0) {
+        ++s_thread_cache.stats.hits;
+        return magazine.chunks[--magazine.count];
+    }
+
+    ++s_thread_cache.stats.misses;
+
+    PthreadMutexLocker locker(s_malloc_mutex);
+    fold_thread_cache_stats();
+
+    auto batch_size = magazine_capacity(allocator.size) / 2;
+    while (magazine.count < batch_size) {
+        auto ptr_or_error = allocate_chunk(allocator, allocator.size, 16);
+        if (ptr_or_error.is_error()) {
+            if (magazine.count == 0)
+                return ptr_or_error.release_error();
+            break;
+        }
+        magazine.chunks[magazine.count++] = ptr_or_error.release_value();
+    }
+    return magazine.chunks[--magazine.count];
+}
+
+static bool free_to_thread_cache(ChunkedBlock& block, void* ptr)
+{
+    auto* magazine = magazine_for_chunk_size(block.m_size);
+    if (!magazine)
+        return false;
+
+    auto capacity = magazine_capacity(block.m_size);
+    if (magazine->count == capacity) {
+        ++s_thread_cache.stats.flushes;
+
+        PthreadMutexLocker locker(s_malloc_mutex);
+        fold_thread_cache_stats();
+
+        // Give back the chunks that have been in the magazine the longest.
+        auto batch_size = capacity / 2;
+        for (size_t i = 0; i < batch_size; ++i) {
+            auto* chunk = magazine->chunks[i];
+            free_chunk((ChunkedBlock*)((FlatPtr)chunk & ChunkedBlock::block_mask), chunk);
+        }
+        magazine->count -= batch_size;
+        memmove(magazine->chunks, magazine->chunks + batch_size, magazine->count * sizeof(void*));
+    } else {
+        ++s_thread_cache.stats.free_hits;
+    }
+
+    magazine->chunks[magazine->count++] = ptr;
+    return true;
+}
+#endif
+
+static ErrorOr<void*> malloc_impl(size_t size, size_t align, CallerWillInitializeMemory caller_will_initialize_memory)
 {
 #ifndef NO_TLS
     VERIFY(s_allocation_enabled);
 #endif
 
-    ScopedValueRollback rollback(errno);
+    // Align must be a power of 2.
+    if (popcount(align) != 1)
+        return EINVAL;
 
-    if (!ptr)
-        return;
+    // FIXME: Support larger than 32KiB alignments (if you dare).
+    if (sizeof(BigAllocationBlock) + align >= ChunkedBlock::block_size)
+        return EINVAL;
 
-    g_malloc_stats.number_of_free_calls++;
+    if (s_log_malloc)
+        dbgln("LibC: malloc({})", size);
 
-    void* block_base = (void*)((FlatPtr)ptr & ChunkedBlock::ChunkedBlock::block_mask);
-    size_t magic = *(size_t*)block_base;
+    if (!size) {
+        // Legally we could just return a null pointer here, but this is more
+        // compatible with existing software.
+        size = 1;
+    }
+
+    g_malloc_stats.number_of_malloc_calls++;
+
+    size_t good_size;
+    auto* allocator = allocator_for_size(size, good_size, align);
+
+#ifndef NO_TLS
+    // Every chunk is 16-byte aligned, so any of them will do.
+    if (allocator && align <= 16) {
+        if (auto* magazine = magazine_for_chunk_size(good_size)) {
+            void* ptr = TRY(allocate_from_thread_cache(*allocator, *magazine));
+            if (s_scrub_malloc && caller_will_initialize_memory == CallerWillInitializeMemory::No)
+                memset(ptr, MALLOC_SCRUB_BYTE, good_size);
+            ue_notify_malloc(ptr, size);
+            return ptr;
+        }
+    }
+#endif
 
     PthreadMutexLocker locker(s_malloc_mutex);
 
-    if (magic == MAGIC_BIGALLOC_HEADER) {
-        auto* block = (BigAllocationBlock*)block_base;
+    if (!allocator) {
+        size_t real_size = round_up_to_power_of_two(sizeof(BigAllocationBlock) + size + ((align > 16) ? align : 0), ChunkedBlock::block_size);
+        if (real_size < size) {
+            dbgln_if(MALLOC_DEBUG, "LibC: Detected overflow trying to do big allocation of size {} for {}", real_size, size);
+            return ENOMEM;
+        }
 #ifdef RECYCLE_BIG_ALLOCATIONS
-        if (auto* allocator = big_allocator_for_size(block->m_size)) {
-            if (allocator->blocks.size() < number_of_big_blocks_to_keep_around_per_size_class) {
-                g_malloc_stats.number_of_big_allocator_keeps++;
-                allocator->blocks.append(block);
-                size_t this_block_size = block->m_size;
-                if (mprotect(block, this_block_size, PROT_NONE) < 0) {
-                    perror("mprotect");
+        if (auto* allocator = big_allocator_for_size(real_size)) {
+            if (!allocator->blocks.is_empty()) {
+                g_malloc_stats.number_of_big_allocator_hits++;
+                auto* block = allocator->blocks.take_last();
+                int rc = madvise(block, real_size, MADV_SET_NONVOLATILE);
+                bool this_block_was_purged = rc == 1;
+                if (rc < 0) {
+                    perror("madvise");
                     VERIFY_NOT_REACHED();
                 }
-                if (madvise(block, this_block_size, MADV_SET_VOLATILE) != 0) {
-                    perror("madvise");
+                if (mprotect(block, real_size, PROT_READ | PROT_WRITE) < 0) {
+                    perror("mprotect");
                     VERIFY_NOT_REACHED();
                 }
-                return;
+                if (this_block_was_purged) {
+                    g_malloc_stats.number_of_big_allocator_purge_hits++;
+                    new (block) BigAllocationBlock(real_size);
+                }
+
+                void* ptr = reinterpret_cast<void*>(round_up_to_power_of_two(reinterpret_cast<uintptr_t>(&block->m_slot[0]), align));
+
+                ue_notify_malloc(ptr, size);
+                return ptr;
             }
         }
 #endif
-        g_malloc_stats.number_of_big_allocator_frees++;
-        os_free(block, block->m_size);
-        return;
+        auto* block = (BigAllocationBlock*)TRY(os_alloc(real_size, "malloc: BigAllocationBlock"));
+        g_malloc_stats.number_of_big_allocs++;
+        new (block) BigAllocationBlock(real_size);
+
+        void* ptr = reinterpret_cast<void*>(round_up_to_power_of_two(reinterpret_cast<uintptr_t>(&block->m_slot[0]), align));
+        ue_notify_malloc(ptr, size);
+        return ptr;
     }
 
-    assert(magic == MAGIC_PAGE_HEADER);
-    auto* block = (ChunkedBlock*)block_base;
+    void* ptr = TRY(allocate_chunk(*allocator, good_size, align));
 
-    dbgln_if(MALLOC_DEBUG, "LibC: freeing {:p} in allocator {:p} (size={}, used={})", ptr, block, block->bytes_per_chunk(), block->used_chunks());
+    if (s_scrub_malloc && caller_will_initialize_memory == CallerWillInitializeMemory::No)
+        memset(ptr, MALLOC_SCRUB_BYTE, good_size);
 
-    if (s_scrub_free)
-        memset(ptr, FREE_SCRUB_BYTE, block->bytes_per_chunk());
+    ue_notify_malloc(ptr, size);
+    return ptr;
+}
 
+// Must be called with s_malloc_mutex held.
+static void free_chunk(ChunkedBlock* block, void* ptr)
+{
     auto* entry = (FreelistEntry*)ptr;
     entry->next = block->m_freelist;
     block->m_freelist = entry;
@@ -536,6 +638,65 @@ static void free_impl(void* ptr)
     }
 }
 
+static void free_impl(void* ptr)
+{
+#ifndef NO_TLS
+    VERIFY(s_allocation_enabled);
+#endif
+
+    ScopedValueRollback rollback(errno);
+
+    if (!ptr)
+        return;
+
+    g_malloc_stats.number_of_free_calls++;
+
+    void* block_base = (void*)((FlatPtr)ptr & ChunkedBlock::ChunkedBlock::block_mask);
+    size_t magic = *(size_t*)block_base;
+
+    if (magic == MAGIC_BIGALLOC_HEADER) {
+        PthreadMutexLocker locker(s_malloc_mutex);
+        auto* block = (BigAllocationBlock*)block_base;
+#ifdef RECYCLE_BIG_ALLOCATIONS
+        if (auto* allocator = big_allocator_for_size(block->m_size)) {
+            if (allocator->blocks.size() < number_of_big_blocks_to_keep_around_per_size_class) {
+                g_malloc_stats.number_of_big_allocator_keeps++;
+                allocator->blocks.append(block);
+                size_t this_block_size = block->m_size;
+                if (mprotect(block, this_block_size, PROT_NONE) < 0) {
+                    perror("mprotect");
+                    VERIFY_NOT_REACHED();
+                }
+                if (madvise(block, this_block_size, MADV_SET_VOLATILE) != 0) {
+                    perror("madvise");
+                    VERIFY_NOT_REACHED();
+                }
+                return;
+            }
+        }
+#endif
+        g_malloc_stats.number_of_big_allocator_frees++;
+        os_free(block, block->m_size);
+        return;
+    }
+
+    assert(magic == MAGIC_PAGE_HEADER);
+    auto* block = (ChunkedBlock*)block_base;
+
+    dbgln_if(MALLOC_DEBUG, "LibC: freeing {:p} in allocator {:p} (size={}, used={})", ptr, block, block->bytes_per_chunk(), block->used_chunks());
+
+    if (s_scrub_free)
+        memset(ptr, FREE_SCRUB_BYTE, block->bytes_per_chunk());
+
+#ifndef NO_TLS
+    if (free_to_thread_cache(*block, ptr))
+        return;
+#endif
+
+    PthreadMutexLocker locker(s_malloc_mutex);
+    free_chunk(block, ptr);
+}
+
 // https://pubs.opengroup.org/onlinepubs/9699919799/functions/malloc.html
 void* malloc(size_t size)
 {
@@ -682,8 +843,39 @@ void __malloc_init()
     new (&big_allocators()[0])(BigAllocator);
 }
 
+void __malloc_thread_exit()
+{
+#ifndef NO_TLS
+    PthreadMutexLocker locker(s_malloc_mutex);
+    fold_thread_cache_stats();
+
+    for (auto& magazine : s_thread_cache.magazines) {
+        for (size_t i = 0; i < magazine.count; ++i) {
+            auto* chunk = magazine.chunks[i];
+            free_chunk((ChunkedBlock*)((FlatPtr)chunk & ChunkedBlock::block_mask), chunk);
+        }
+        magazine.count = 0;
+    }
+
+    // Anything freed from here on, e.g. by TLS destructors, goes straight back to the blocks.
+    s_thread_cache.is_disabled = true;
+#endif
+}
+
+static size_t percentage(size_t part, size_t total)
+{
+    return total ? part * 100 / total : 0;
+}
+
 void serenity_dump_malloc_stats()
 {
+#ifndef NO_TLS
+    {
+        PthreadMutexLocker locker(s_malloc_mutex);
+        fold_thread_cache_stats();
+    }
+#endif
+
     dbgln("# malloc() calls: {}", g_malloc_stats.number_of_malloc_calls);
     dbgln();
     dbgln("big alloc hits: {}", g_malloc_stats.number_of_big_allocator_hits);
@@ -705,5 +897,12 @@ void serenity_dump_malloc_stats()
     dbgln("number of hot keeps: {}", g_malloc_stats.number_of_hot_keeps);
     dbgln("number of cold keeps: {}", g_malloc_stats.number_of_cold_keeps);
     dbgln("number of frees: {}", g_malloc_stats.number_of_frees);
+    dbgln();
+    auto cached_allocations = g_malloc_stats.number_of_thread_cache_hits + g_malloc_stats.number_of_thread_cache_misses;
+    auto cached_frees = g_malloc_stats.number_of_thread_cache_free_hits + g_malloc_stats.number_of_thread_cache_flushes;
+    dbgln("thread cache hits: {} ({}%)", g_malloc_stats.number_of_thread_cache_hits, percentage(g_malloc_stats.number_of_thread_cache_hits, cached_allocations));
+    dbgln("thread cache misses: {}", g_malloc_stats.number_of_thread_cache_misses);
+    dbgln("thread cache free hits: {} ({}%)", g_malloc_stats.number_of_thread_cache_free_hits, percentage(g_malloc_stats.number_of_thread_cache_free_hits, cached_frees));
+    dbgln("thread cache flushes: {}", g_malloc_stats.number_of_thread_cache_flushes);
 }
 }
@@ -6,6 +6,7 @@
 
 #include <AK/Atomic.h>
 #include <AK/NeverDestroyed.h>
+#include <AK/Platform.h>
 #include <AK/Types.h>
 #include <AK/Vector.h>
 #include <bits/pthread_integration.h>
@@ -97,6 +98,44 @@ static constexpr u32 MUTEX_UNLOCKED = 0;
 static constexpr u32 MUTEX_LOCKED_NO_NEED_TO_WAKE = 1;
 static constexpr u32 MUTEX_LOCKED_NEED_TO_WAKE = 2;
 
+// Most critical sections are short, so when another processor holds the mutex, it's usually cheaper to
+// watch it for a little while than to go to sleep in the kernel and have to be woken up again.
+static constexpr u32 MUTEX_SPIN_COUNT = 100;
+
+static ALWAYS_INLINE void spin_loop_hint()
+{
+#if ARCH(X86_64)
+    asm volatile("pause");
+#elif ARCH(AARCH64)
+    asm volatile("yield");
+#endif
+}
+
+static bool should_spin_on_mutex()
+{
+    // Spinning only makes sense if the owner can be running at the same time as us.
+    static Atomic<int> s_processor_count { 0 };
+    int processor_count = s_processor_count.load(AK::memory_order_relaxed);
+    if (processor_count == 0) {
+        processor_count = static_cast<int>(max(sysconf(_SC_NPROCESSORS_ONLN), 1l));
+        s_processor_count.store(processor_count, AK::memory_order_relaxed);
+    }
+    return processor_count > 1;
+}
+
+static bool spin_until_mutex_acquired(pthread_mutex_t* mutex)
+{
+    if (!should_spin_on_mutex())
+        return false;
+    for (u32 i = 0; i < MUTEX_SPIN_COUNT; ++i) {
+        spin_loop_hint();
+        u32 value = AK::atomic_load(&mutex->lock, AK::memory_order_relaxed);
+        if (value == MUTEX_UNLOCKED && AK::atomic_compare_exchange_strong(&mutex->lock, value, MUTEX_LOCKED_NO_NEED_TO_WAKE, AK::memory_order_acquire))
+            return true;
+    }
+    return false;
+}
+
 // https://pubs.opengroup.org/onlinepubs/009695399/functions/pthread_mutex_init.html
 int pthread_mutex_init(pthread_mutex_t* mutex, pthread_mutexattr_t const* attributes)
 {
@@ -149,14 +188,16 @@ int pthread_mutex_lock(pthread_mutex_t* mutex)
         }
     }
 
-    // Slow path: wait, record the fact that we're going to wait, and always
-    // remember to wake the next thread up once we release the mutex.
-    if (value != MUTEX_LOCKED_NEED_TO_WAKE)
+    // Adaptive path: the owner may be about to release the mutex, so spin for a bit before sleeping.
+    if (!spin_until_mutex_acquired(mutex)) {
+        // Slow path: wait, record the fact that we're going to wait, and always
+        // remember to wake the next thread up once we release the mutex.
         value = AK::atomic_exchange(&mutex->lock, MUTEX_LOCKED_NEED_TO_WAKE, AK::memory_order_acquire);
 
-    while (value != MUTEX_UNLOCKED) {
-        futex_wait(&mutex->lock, MUTEX_LOCKED_NEED_TO_WAKE, nullptr, 0, false);
-        value = AK::atomic_exchange(&mutex->lock, MUTEX_LOCKED_NEED_TO_WAKE, AK::memory_order_acquire);
+        while (value != MUTEX_UNLOCKED) {
+            futex_wait(&mutex->lock, MUTEX_LOCKED_NEED_TO_WAKE, nullptr, 0, false);
+            value = AK::atomic_exchange(&mutex->lock, MUTEX_LOCKED_NEED_TO_WAKE, AK::memory_order_acquire);
+        }
     }
 
     if (mutex->type == __PTHREAD_MUTEX_RECURSIVE)
@@ -101,6 +101,18 @@ int anon_create(size_t size, int options)
     __RETURN_WITH_ERRNO(rc, rc, -1);
 }
 
+int io_ring_setup(unsigned entries, IORingParameters* parameters)
+{
+    int rc = syscall(SC_io_ring_setup, entries, parameters);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+
+int io_ring_enter(int ring_fd, unsigned to_submit, unsigned minimum_completions)
+{
+    int rc = syscall(SC_io_ring_enter, ring_fd, to_submit, minimum_completions);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+
 int serenity_readlink(char const* path, size_t path_length, char* buffer, size_t buffer_size)
 {
     Syscall::SC_readlink_params small_params {
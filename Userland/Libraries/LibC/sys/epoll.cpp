@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <bits/pthread_cancel.h>
+#include <errno.h>
+#include <sys/epoll.h>
+#include <syscall.h>
+
+extern "C" {
+
+// https://man7.org/linux/man-pages/man2/epoll_create.2.html
+int epoll_create(int size)
+{
+    // NOTE: The size is only a hint that has been ignored by Linux for a long time, but it must be positive.
+    if (size <= 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    return epoll_create1(0);
+}
+
+int epoll_create1(int flags)
+{
+    int rc = syscall(SC_epoll_create1, flags);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+
+// https://man7.org/linux/man-pages/man2/epoll_ctl.2.html
+int epoll_ctl(int epfd, int op, int fd, epoll_event* event)
+{
+    int rc = syscall(SC_epoll_ctl, epfd, op, fd, event);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+
+// https://man7.org/linux/man-pages/man2/epoll_wait.2.html
+int epoll_wait(int epfd, epoll_event* events, int maxevents, int timeout_ms)
+{
+    return epoll_pwait(epfd, events, maxevents, timeout_ms, nullptr);
+}
+
+int epoll_pwait(int epfd, epoll_event* events, int maxevents, int timeout_ms, sigset_t const* sigmask)
+{
+    timespec timeout;
+    timespec* timeout_ts = &timeout;
+    if (timeout_ms < 0)
+        timeout_ts = nullptr;
+    else
+        timeout = { timeout_ms / 1000, (timeout_ms % 1000) * 1'000'000 };
+    return epoll_pwait2(epfd, events, maxevents, timeout_ts, sigmask);
+}
+
+int epoll_pwait2(int epfd, epoll_event* events, int maxevents, timespec const* timeout, sigset_t const* sigmask)
+{
+    __pthread_maybe_cancel();
+
+    Syscall::SC_epoll_pwait_params params { epfd, events, maxevents, timeout, sigmask };
+    int rc = syscall(SC_epoll_pwait, &params);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+}
@@ -4,6 +4,7 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/Debug.h>
 #include <AK/IDAllocator.h>
 #include <AK/Singleton.h>
 #include <AK/TemporaryChange.h>
@@ -16,9 +17,18 @@
 #include <LibCore/Socket.h>
 #include <LibCore/System.h>
 #include <LibCore/ThreadEventQueue.h>
-#include <sys/select.h>
 #include <unistd.h>
 
+// epoll keeps the set of watched file descriptors in the kernel between waits, so a wait only costs as much as
+// the number of ready file descriptors. Everywhere else we fall back to select().
+#if defined(AK_OS_SERENITY) || defined(AK_OS_LINUX)
+#    define USE_EPOLL 1
+#    include <sys/epoll.h>
+#else
+#    define USE_EPOLL 0
+#    include <sys/select.h>
+#endif
+
 namespace Core {
 
 struct ThreadData;
@@ -53,6 +63,9 @@ struct ThreadData {
     {
         pid = getpid();
         initialize_wake_pipe();
+#if USE_EPOLL
+        initialize_epoll();
+#endif
     }
 
     void initialize_wake_pipe()
@@ -73,9 +86,108 @@ struct ThreadData {
         VERIFY(rc == 0);
     }
 
+#if USE_EPOLL
+    void initialize_epoll()
+    {
+        // NOTE: After a fork, the child must not touch the parent's epoll instance, since they share it.
+        if (epoll_fd != -1)
+            close(epoll_fd);
+        registered_notifiers.clear();
+        fd_registrations.clear();
+        always_ready_fds.clear();
+
+        epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        VERIFY(epoll_fd >= 0);
+
+        epoll_event event {};
+        event.events = EPOLLIN;
+        event.data.fd = wake_pipe_fds[0];
+        int rc = epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_pipe_fds[0], &event);
+        VERIFY(rc == 0);
+    }
+
+    struct RegisteredNotifier {
+        Notifier* notifier { nullptr };
+        // The type the notifier had when it was registered, which is what the kernel is watching for.
+        Notifier::Type type { Notifier::Type::None };
+    };
+
+    struct FdRegistration {
+        Vector<RegisteredNotifier, 1> notifiers;
+        // The events the kernel is watching for on behalf of all of the notifiers.
+        u32 events { 0 };
+    };
+
+    void update_epoll_registration(int fd, FdRegistration& registration)
+    {
+        u32 events = 0;
+        for (auto& registered_notifier : registration.notifiers) {
+            if (registered_notifier.type == Notifier::Type::Read)
+                events |= EPOLLIN;
+            if (registered_notifier.type == Notifier::Type::Write)
+                events |= EPOLLOUT;
+            if (registered_notifier.type == Notifier::Type::Exceptional)
+                TODO();
+        }
+        if (events == registration.events)
+            return;
+
+        epoll_event event {};
+        event.events = events;
+        event.data.fd = fd;
+        int rc;
+        if (events == 0)
+            rc = epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+        else if (registration.events == 0)
+            rc = epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event);
+        else
+            rc = epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &event);
+
+        // The fd may have been closed and reused behind our back, which the kernel knows about and we don't.
+        if (rc < 0 && errno == EEXIST)
+            rc = epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &event);
+        else if (rc < 0 && errno == ENOENT && events != 0)
+            rc = epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event);
+
+        registration.events = events;
+        if (rc == 0 || events == 0)
+            return;
+
+        if (errno == EPERM) {
+            // Regular files can't be watched with epoll, but select() says they're always ready, so let's do that.
+            always_ready_fds.set(fd);
+            return;
+        }
+        dbgln_if(EVENT_DEBUG, "EventLoopImplementationUnix: Couldn't watch fd {}: {}", fd, strerror(errno));
+    }
+
+    void remove_notifier_from_fd(Notifier& notifier, int fd)
+    {
+        auto it = fd_registrations.find(fd);
+        if (it == fd_registrations.end())
+            return;
+        it->value.notifiers.remove_first_matching([&](auto& entry) { return entry.notifier == &notifier; });
+        update_epoll_registration(fd, it->value);
+        if (it->value.notifiers.is_empty()) {
+            always_ready_fds.remove(fd);
+            fd_registrations.remove(it);
+        }
+    }
+
+    // Notifiers are tracked by identity, and remember the fd they were registered with, so that unregistering
+    // one still finds it if its fd or type has changed in the meantime. The kernel only lets us watch each fd once,
+    // so the notifiers that share an fd are combined into one registration.
+    HashMap<Notifier*, int> registered_notifiers;
+    HashMap<int, FdRegistration> fd_registrations;
+    HashTable<int> always_ready_fds;
+    int epoll_fd { -1 };
+#endif
+
     // Each thread has its own timers, notifiers and a wake pipe.
     HashMap<int, NonnullOwnPtr<EventLoopTimer>> timers;
+#if !USE_EPOLL
     HashTable<Notifier*> notifiers;
+#endif
 
     // The wake pipe is used to notify another event loop that someone has called wake(), or a signal has been received.
     // wake() writes 0i32 into the pipe, signals write the signal number (guaranteed non-zero).
@@ -143,6 +255,10 @@ void EventLoopManagerUnix::wait_for_events(EventLoopImplementation::PumpMode mod
 {
     auto& thread_data = ThreadData::the();
 
+#if USE_EPOLL
+    epoll_event ready_events[64];
+retry:
+#else
     fd_set read_fds {};
     fd_set write_fds {};
 retry:
@@ -164,6 +280,7 @@ retry:
         if (notifier->type() == Notifier::Type::Exceptional)
             TODO();
     }
+#endif
 
     bool has_pending_events = ThreadEventQueue::current().has_pending_events();
 
@@ -184,6 +301,31 @@ retry:
         }
     }
 
+#if USE_EPOLL
+    int timeout_ms = -1;
+    if (!thread_data.always_ready_fds.is_empty())
+        timeout_ms = 0;
+    else if (!should_wait_forever)
+        timeout_ms = static_cast<int>(min<i64>(timeout.tv_sec * 1000 + (timeout.tv_usec + 999) / 1000, NumericLimits<int>::max()));
+
+try_epoll_wait_again:
+    // epoll_wait() and wait for file system events, calls to wake(), POSIX signals, or timer expirations.
+    int marked_fd_count = epoll_wait(thread_data.epoll_fd, ready_events, array_size(ready_events), timeout_ms);
+    // Because POSIX, we might spuriously return from epoll_wait() with EINTR; just wait again.
+    if (marked_fd_count < 0) {
+        int saved_errno = errno;
+        if (saved_errno == EINTR)
+            goto try_epoll_wait_again;
+        dbgln("EventLoopImplementationUnix::wait_for_events: {} ({}: {})", marked_fd_count, saved_errno, strerror(saved_errno));
+        VERIFY_NOT_REACHED();
+    }
+
+    bool wake_pipe_is_readable = false;
+    for (int i = 0; i < marked_fd_count; ++i) {
+        if (ready_events[i].data.fd == thread_data.wake_pipe_fds[0])
+            wake_pipe_is_readable = true;
+    }
+#else
 try_select_again:
     // select() and wait for file system events, calls to wake(), POSIX signals, or timer expirations.
     int marked_fd_count = select(max_fd + 1, &read_fds, &write_fds, nullptr, should_wait_forever ? nullptr : &timeout);
@@ -196,9 +338,12 @@ try_select_again:
         VERIFY_NOT_REACHED();
     }
 
+    bool wake_pipe_is_readable = FD_ISSET(thread_data.wake_pipe_fds[0], &read_fds);
+#endif
+
     // We woke up due to a call to wake() or a POSIX signal.
     // Handle signals and see whether we need to handle events as well.
-    if (FD_ISSET(thread_data.wake_pipe_fds[0], &read_fds)) {
+    if (wake_pipe_is_readable) {
         int wake_events[8];
         ssize_t nread;
         // We might receive another signal while read()ing here. The signal will go to the handle_signal properly,
@@ -252,6 +397,29 @@ try_select_again:
         }
     }
 
+#if USE_EPOLL
+    auto post_notifier_events = [](int fd, auto& registration, u32 events) {
+        for (auto& registered_notifier : registration.notifiers) {
+            if (registered_notifier.type == Notifier::Type::Read && (events & (EPOLLIN | EPOLLHUP | EPOLLERR)))
+                ThreadEventQueue::current().post_event(*registered_notifier.notifier, make<NotifierActivationEvent>(fd));
+            if (registered_notifier.type == Notifier::Type::Write && (events & (EPOLLOUT | EPOLLHUP | EPOLLERR)))
+                ThreadEventQueue::current().post_event(*registered_notifier.notifier, make<NotifierActivationEvent>(fd));
+        }
+    };
+
+    // Handle file system notifiers by making them normal events.
+    for (int i = 0; i < marked_fd_count; ++i) {
+        auto fd = ready_events[i].data.fd;
+        auto it = thread_data.fd_registrations.find(fd);
+        if (it != thread_data.fd_registrations.end())
+            post_notifier_events(fd, it->value, ready_events[i].events);
+    }
+    for (auto fd : thread_data.always_ready_fds) {
+        auto it = thread_data.fd_registrations.find(fd);
+        if (it != thread_data.fd_registrations.end())
+            post_notifier_events(fd, it->value, EPOLLIN | EPOLLOUT);
+    }
+#else
     if (!marked_fd_count)
         return;
 
@@ -264,6 +432,7 @@ try_select_again:
             ThreadEventQueue::current().post_event(*notifier, make<NotifierActivationEvent>(notifier->fd()));
         }
     }
+#endif
 }
 
 class SignalHandlers : public RefCounted<SignalHandlers> {
@@ -337,8 +506,12 @@ void EventLoopImplementationUnix::notify_forked_and_in_child()
 {
     auto& thread_data = ThreadData::the();
     thread_data.timers.clear();
-    thread_data.notifiers.clear();
     thread_data.initialize_wake_pipe();
+#if USE_EPOLL
+    thread_data.initialize_epoll();
+#else
+    thread_data.notifiers.clear();
+#endif
     if (auto* info = signals_info<false>()) {
         info->signal_handlers.clear();
         info->next_signal_id = 0;
@@ -505,12 +678,30 @@ bool EventLoopManagerUnix::unregister_timer(int timer_id)
 
 void EventLoopManagerUnix::register_notifier(Notifier& notifier)
 {
+#if USE_EPOLL
+    auto& thread_data = ThreadData::the();
+    if (auto fd = thread_data.registered_notifiers.get(&notifier); fd.has_value())
+        thread_data.remove_notifier_from_fd(notifier, *fd);
+    thread_data.registered_notifiers.set(&notifier, notifier.fd());
+    auto& registration = thread_data.fd_registrations.ensure(notifier.fd());
+    registration.notifiers.append({ &notifier, notifier.type() });
+    thread_data.update_epoll_registration(notifier.fd(), registration);
+#else
     ThreadData::the().notifiers.set(&notifier);
+#endif
 }
 
 void EventLoopManagerUnix::unregister_notifier(Notifier& notifier)
 {
+#if USE_EPOLL
+    auto& thread_data = ThreadData::the();
+    auto fd = thread_data.registered_notifiers.take(&notifier);
+    if (!fd.has_value())
+        return;
+    thread_data.remove_notifier_from_fd(notifier, *fd);
+#else
     ThreadData::the().notifiers.remove(&notifier);
+#endif
 }
 
 void EventLoopManagerUnix::did_post_event()
@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Atomic.h>
+#include <LibCore/EventLoop.h>
+#include <LibCore/IORing.h>
+#include <LibCore/System.h>
+#include <sys/mman.h>
+
+namespace Core {
+
+ErrorOr<NonnullOwnPtr<IORing>> IORing::create(u32 entries)
+{
+    IORingParameters parameters {};
+    auto fd = TRY(System::io_ring_setup(entries, parameters));
+    auto memory_or_error = System::mmap(nullptr, parameters.size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (memory_or_error.is_error()) {
+        (void)System::close(fd);
+        return memory_or_error.release_error();
+    }
+    return adopt_nonnull_own_or_enomem(new (nothrow) IORing(fd, parameters, static_cast<u8*>(memory_or_error.value())));
+}
+
+IORing::IORing(int fd, IORingParameters const& parameters, u8* memory)
+    : m_fd(fd)
+    , m_parameters(parameters)
+    , m_memory(memory)
+    , m_submissions(reinterpret_cast<IORingSubmission*>(memory + parameters.submissions_offset))
+    , m_completions(reinterpret_cast<IORingCompletion*>(memory + parameters.completions_offset))
+{
+    m_notifier = Notifier::construct(m_fd, Notifier::Type::Read);
+    m_notifier->on_activation = [this] {
+        process_completions();
+    };
+}
+
+IORing::~IORing()
+{
+    m_notifier->set_enabled(false);
+    (void)System::munmap(m_memory, m_parameters.size);
+    (void)System::close(m_fd);
+}
+
+ErrorOr<void> IORing::queue(IORingSubmission submission, Callback callback)
+{
+    auto is_full = [&] {
+        return m_submission_tail - AK::atomic_load(&header().submission_head, AK::memory_order_acquire) >= m_parameters.submission_entries;
+    };
+    if (is_full()) {
+        TRY(submit());
+        // The kernel doesn't take more requests than there is room for completions of.
+        if (is_full())
+            return Error::from_errno(EBUSY);
+    }
+
+    submission.user_data = m_next_user_data++;
+    TRY(m_callbacks.try_set(submission.user_data, move(callback)));
+
+    m_submissions[m_submission_tail & (m_parameters.submission_entries - 1)] = submission;
+    AK::atomic_store(&header().submission_tail, ++m_submission_tail, AK::memory_order_release);
+    ++m_unsubmitted_count;
+
+    if (!m_submit_is_scheduled) {
+        m_submit_is_scheduled = true;
+        deferred_invoke([weak_this = make_weak_ptr()] {
+            if (!weak_this)
+                return;
+            weak_this->m_submit_is_scheduled = false;
+            (void)weak_this->submit();
+        });
+    }
+    return {};
+}
+
+ErrorOr<void> IORing::submit()
+{
+    if (m_unsubmitted_count == 0)
+        return {};
+    auto submitted_count = TRY(System::io_ring_enter(m_fd, m_unsubmitted_count, 0));
+    m_unsubmitted_count -= submitted_count;
+    return {};
+}
+
+ErrorOr<void> IORing::wait_for_completions(u32 count)
+{
+    auto submitted_count = TRY(System::io_ring_enter(m_fd, m_unsubmitted_count, count));
+    m_unsubmitted_count -= submitted_count;
+    process_completions();
+    return {};
+}
+
+void IORing::process_completions()
+{
+    auto head = header().completion_head;
+    auto tail = AK::atomic_load(&header().completion_tail, AK::memory_order_acquire);
+    while (head != tail) {
+        auto completion = m_completions[head & (m_parameters.completion_entries - 1)];
+        AK::atomic_store(&header().completion_head, ++head, AK::memory_order_release);
+
+        auto callback = m_callbacks.take(completion.user_data);
+        VERIFY(callback.has_value());
+        if (completion.result < 0)
+            (*callback)(Error::from_errno(-completion.result));
+        else
+            (*callback)(static_cast<size_t>(completion.result));
+
+        tail = AK::atomic_load(&header().completion_tail, AK::memory_order_acquire);
+    }
+
+    // The kernel may have held back requests until there was room for their completions.
+    if (m_unsubmitted_count > 0)
+        (void)submit();
+}
+
+ErrorOr<void> IORing::nop(Callback callback)
+{
+    return queue({ .opcode = IORingOpcode::Nop }, move(callback));
+}
+
+ErrorOr<void> IORing::read(int fd, Bytes buffer, Optional<u64> offset, Callback callback)
+{
+    return queue({
+                     .opcode = IORingOpcode::Read,
+                     .fd = fd,
+                     .offset = offset.value_or(IO_RING_CURRENT_OFFSET),
+                     .address = reinterpret_cast<FlatPtr>(buffer.data()),
+                     .length = static_cast<u32>(buffer.size()),
+                 },
+        move(callback));
+}
+
+ErrorOr<void> IORing::write(int fd, ReadonlyBytes buffer, Optional<u64> offset, Callback callback)
+{
+    return queue({
+                     .opcode = IORingOpcode::Write,
+                     .fd = fd,
+                     .offset = offset.value_or(IO_RING_CURRENT_OFFSET),
+                     .address = reinterpret_cast<FlatPtr>(buffer.data()),
+                     .length = static_cast<u32>(buffer.size()),
+                 },
+        move(callback));
+}
+
+ErrorOr<void> IORing::accept(int fd, int flags, Callback callback)
+{
+    return queue({ .opcode = IORingOpcode::Accept, .fd = fd, .operation_flags = static_cast<u32>(flags) }, move(callback));
+}
+
+ErrorOr<void> IORing::connect(int fd, sockaddr const* address, socklen_t address_length, Callback callback)
+{
+    return queue({
+                     .opcode = IORingOpcode::Connect,
+                     .fd = fd,
+                     .address = reinterpret_cast<FlatPtr>(address),
+                     .length = address_length,
+                 },
+        move(callback));
+}
+
+ErrorOr<void> IORing::send(int fd, ReadonlyBytes buffer, int flags, Callback callback)
+{
+    return queue({
+                     .opcode = IORingOpcode::Send,
+                     .fd = fd,
+                     .address = reinterpret_cast<FlatPtr>(buffer.data()),
+                     .length = static_cast<u32>(buffer.size()),
+                     .operation_flags = static_cast<u32>(flags),
+                 },
+        move(callback));
+}
+
+ErrorOr<void> IORing::receive(int fd, Bytes buffer, int flags, Callback callback)
+{
+    return queue({
+                     .opcode = IORingOpcode::Receive,
+                     .fd = fd,
+                     .address = reinterpret_cast<FlatPtr>(buffer.data()),
+                     .length = static_cast<u32>(buffer.size()),
+                     .operation_flags = static_cast<u32>(flags),
+                 },
+        move(callback));
+}
+
+ErrorOr<void> IORing::fsync(int fd, Callback callback)
+{
+    return queue({ .opcode = IORingOpcode::Fsync, .fd = fd }, move(callback));
+}
+
+ErrorOr<void> IORing::poll_add(int fd, short events, Callback callback)
+{
+    return queue({ .opcode = IORingOpcode::PollAdd, .fd = fd, .operation_flags = static_cast<u16>(events) }, move(callback));
+}
+
+}
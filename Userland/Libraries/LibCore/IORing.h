@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Error.h>
+#include <AK/Function.h>
+#include <AK/HashMap.h>
+#include <AK/Noncopyable.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/Optional.h>
+#include <AK/Span.h>
+#include <AK/Weakable.h>
+#include <Kernel/API/IORing.h>
+#include <LibCore/Notifier.h>
+#include <sys/socket.h>
+
+namespace Core {
+
+// Does I/O through a ring that is shared with the kernel (see Kernel/API/IORing.h), so many requests cost a single
+// syscall, and none of them block. The callback of a request runs on the event loop once the kernel is done with it.
+//
+// Requests are handed to the kernel in a batch on the next iteration of the event loop, or when submit() is called.
+// The memory a request refers to has to stay alive until its callback has run.
+class IORing : public Weakable<IORing> {
+    AK_MAKE_NONCOPYABLE(IORing);
+    AK_MAKE_NONMOVABLE(IORing);
+
+public:
+    // Gets the result of the request: what the equivalent syscall would have returned.
+    using Callback = Function<void(ErrorOr<size_t>)>;
+
+    static ErrorOr<NonnullOwnPtr<IORing>> create(u32 entries = 256);
+    ~IORing();
+
+    ErrorOr<void> nop(Callback);
+    // Without an offset, these use and advance the offset of the file description, like read() and write() do.
+    ErrorOr<void> read(int fd, Bytes, Optional<u64> offset, Callback);
+    ErrorOr<void> write(int fd, ReadonlyBytes, Optional<u64> offset, Callback);
+    // Accepted sockets get SOCK_NONBLOCK and SOCK_CLOEXEC from `flags`.
+    ErrorOr<void> accept(int fd, int flags, Callback);
+    ErrorOr<void> connect(int fd, sockaddr const*, socklen_t, Callback);
+    ErrorOr<void> send(int fd, ReadonlyBytes, int flags, Callback);
+    ErrorOr<void> receive(int fd, Bytes, int flags, Callback);
+    ErrorOr<void> fsync(int fd, Callback);
+    // Completes with the POLL* events that happened, once any of `events` does.
+    ErrorOr<void> poll_add(int fd, short events, Callback);
+
+    // Hands all queued requests to the kernel.
+    ErrorOr<void> submit();
+
+    // Submits, then blocks until at least `count` requests are done and runs their callbacks.
+    // This is how to use an IORing without an event loop.
+    ErrorOr<void> wait_for_completions(u32 count = 1);
+
+    size_t pending_request_count() const { return m_callbacks.size(); }
+
+private:
+    IORing(int fd, IORingParameters const&, u8* memory);
+
+    IORingHeader& header() { return *reinterpret_cast<IORingHeader*>(m_memory); }
+    ErrorOr<void> queue(IORingSubmission, Callback);
+    void process_completions();
+
+    int m_fd { -1 };
+    IORingParameters m_parameters;
+    u8* m_memory { nullptr };
+    IORingSubmission* m_submissions { nullptr };
+    IORingCompletion* m_completions { nullptr };
+
+    u32 m_submission_tail { 0 };
+    // Requests that are in the submission queue, but that the kernel hasn't taken yet.
+    u32 m_unsubmitted_count { 0 };
+    bool m_submit_is_scheduled { false };
+
+    u64 m_next_user_data { 1 };
+    HashMap<u64, Callback> m_callbacks;
+
+    RefPtr<Notifier> m_notifier;
+};
+
+}
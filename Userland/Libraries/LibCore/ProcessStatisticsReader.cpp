@@ -5,8 +5,7 @@
  */
 
 #include <AK/ByteBuffer.h>
-#include <AK/JsonArray.h>
-#include <AK/JsonObject.h>
+#include <AK/JsonStreamingParser.h>
 #include <AK/JsonValue.h>
 #include <LibCore/File.h>
 #include <LibCore/ProcessStatisticsReader.h>
@@ -16,76 +15,223 @@ namespace Core {
 
 HashMap<uid_t, DeprecatedString> ProcessStatisticsReader::s_usernames;
 
+// Fills in the statistics straight from the events of the JSON parser, without building a JsonValue tree first.
+class ProcessStatisticsVisitor final : public JsonStreamingParser::Visitor {
+public:
+    explicit ProcessStatisticsVisitor(AllProcessesStatistics& statistics)
+        : m_statistics(statistics)
+    {
+    }
+
+    virtual ErrorOr<void> on_object_start() override
+    {
+        if (m_skipped_depth > 0) {
+            ++m_skipped_depth;
+        } else if (m_object_depth == 0) {
+            ++m_object_depth;
+        } else if (m_object_depth == 1 && m_in_processes) {
+            TRY(m_statistics.processes.try_append({}));
+            ++m_object_depth;
+        } else if (m_object_depth == 2 && m_in_threads) {
+            TRY(m_statistics.processes.last().threads.try_append({}));
+            ++m_object_depth;
+        } else {
+            ++m_skipped_depth;
+        }
+        return {};
+    }
+
+    virtual ErrorOr<void> on_object_end() override
+    {
+        if (m_skipped_depth > 0)
+            --m_skipped_depth;
+        else
+            --m_object_depth;
+        return {};
+    }
+
+    virtual ErrorOr<void> on_array_start() override
+    {
+        if (m_skipped_depth == 0 && is_in_root() && m_key == "processes"sv)
+            m_in_processes = true;
+        else if (m_skipped_depth == 0 && is_in_process() && m_key == "threads"sv)
+            m_in_threads = true;
+        else
+            ++m_skipped_depth;
+        return {};
+    }
+
+    virtual ErrorOr<void> on_array_end() override
+    {
+        if (m_skipped_depth > 0)
+            --m_skipped_depth;
+        else if (m_in_threads)
+            m_in_threads = false;
+        else
+            m_in_processes = false;
+        return {};
+    }
+
+    virtual ErrorOr<void> on_key(StringView key) override
+    {
+        if (m_skipped_depth == 0)
+            m_key = key;
+        return {};
+    }
+
+    virtual ErrorOr<void> on_string(StringView value) override
+    {
+        if (m_skipped_depth > 0)
+            return {};
+
+        if (is_in_process()) {
+            auto& process = m_statistics.processes.last();
+            if (m_key == "name"sv)
+                process.name = value;
+            else if (m_key == "executable"sv)
+                process.executable = value;
+            else if (m_key == "tty"sv)
+                process.tty = value;
+            else if (m_key == "pledge"sv)
+                process.pledge = value;
+            else if (m_key == "veil"sv)
+                process.veil = value;
+        } else if (is_in_thread()) {
+            auto& thread = m_statistics.processes.last().threads.last();
+            if (m_key == "name"sv)
+                thread.name = value;
+            else if (m_key == "state"sv)
+                thread.state = value;
+        }
+        return {};
+    }
+
+    virtual ErrorOr<void> on_number(JsonValue const& value) override
+    {
+        if (m_skipped_depth > 0)
+            return {};
+
+        if (is_in_root()) {
+            if (m_key == "total_time"sv)
+                m_statistics.total_time_scheduled = integer_or_zero<u64>(value);
+            else if (m_key == "total_time_kernel"sv)
+                m_statistics.total_time_scheduled_kernel = integer_or_zero<u64>(value);
+        } else if (is_in_process()) {
+            auto& process = m_statistics.processes.last();
+            if (m_key == "pid"sv)
+                process.pid = integer_or_zero<u32>(value);
+            else if (m_key == "pgid"sv)
+                process.pgid = integer_or_zero<u32>(value);
+            else if (m_key == "pgp"sv)
+                process.pgp = integer_or_zero<u32>(value);
+            else if (m_key == "sid"sv)
+                process.sid = integer_or_zero<u32>(value);
+            else if (m_key == "uid"sv)
+                process.uid = integer_or_zero<u32>(value);
+            else if (m_key == "gid"sv)
+                process.gid = integer_or_zero<u32>(value);
+            else if (m_key == "ppid"sv)
+                process.ppid = integer_or_zero<u32>(value);
+            else if (m_key == "creation_time"sv)
+                process.creation_time = UnixDateTime::from_nanoseconds_since_epoch(integer_or_zero<i64>(value));
+            else if (m_key == "amount_virtual"sv)
+                process.amount_virtual = integer_or_zero<u32>(value);
+            else if (m_key == "amount_resident"sv)
+                process.amount_resident = integer_or_zero<u32>(value);
+            else if (m_key == "amount_shared"sv)
+                process.amount_shared = integer_or_zero<u32>(value);
+            else if (m_key == "amount_dirty_private"sv)
+                process.amount_dirty_private = integer_or_zero<u32>(value);
+            else if (m_key == "amount_clean_inode"sv)
+                process.amount_clean_inode = integer_or_zero<u32>(value);
+            else if (m_key == "amount_purgeable_volatile"sv)
+                process.amount_purgeable_volatile = integer_or_zero<u32>(value);
+            else if (m_key == "amount_purgeable_nonvolatile"sv)
+                process.amount_purgeable_nonvolatile = integer_or_zero<u32>(value);
+        } else if (is_in_thread()) {
+            auto& thread = m_statistics.processes.last().threads.last();
+            if (m_key == "tid"sv)
+                thread.tid = integer_or_zero<u32>(value);
+            else if (m_key == "times_scheduled"sv)
+                thread.times_scheduled = integer_or_zero<u32>(value);
+            else if (m_key == "time_user"sv)
+                thread.time_user = integer_or_zero<u64>(value);
+            else if (m_key == "time_kernel"sv)
+                thread.time_kernel = integer_or_zero<u64>(value);
+            else if (m_key == "cpu"sv)
+                thread.cpu = integer_or_zero<u32>(value);
+            else if (m_key == "priority"sv)
+                thread.priority = integer_or_zero<u32>(value);
+            else if (m_key == "syscall_count"sv)
+                thread.syscall_count = integer_or_zero<u32>(value);
+            else if (m_key == "inode_faults"sv)
+                thread.inode_faults = integer_or_zero<u32>(value);
+            else if (m_key == "zero_faults"sv)
+                thread.zero_faults = integer_or_zero<u32>(value);
+            else if (m_key == "cow_faults"sv)
+                thread.cow_faults = integer_or_zero<u32>(value);
+            else if (m_key == "unix_socket_read_bytes"sv)
+                thread.unix_socket_read_bytes = integer_or_zero<u64>(value);
+            else if (m_key == "unix_socket_write_bytes"sv)
+                thread.unix_socket_write_bytes = integer_or_zero<u64>(value);
+            else if (m_key == "ipv4_socket_read_bytes"sv)
+                thread.ipv4_socket_read_bytes = integer_or_zero<u64>(value);
+            else if (m_key == "ipv4_socket_write_bytes"sv)
+                thread.ipv4_socket_write_bytes = integer_or_zero<u64>(value);
+            else if (m_key == "file_read_bytes"sv)
+                thread.file_read_bytes = integer_or_zero<u64>(value);
+            else if (m_key == "file_write_bytes"sv)
+                thread.file_write_bytes = integer_or_zero<u64>(value);
+        }
+        return {};
+    }
+
+    virtual ErrorOr<void> on_boolean(bool value) override
+    {
+        if (m_skipped_depth > 0)
+            return {};
+
+        if (is_in_process() && m_key == "kernel"sv)
+            m_statistics.processes.last().kernel = value;
+        return {};
+    }
+
+private:
+    // Scalars inside the arrays themselves are ignored, along with anything in a skipped container.
+    bool is_in_root() const { return m_object_depth == 1 && !m_in_processes; }
+    bool is_in_process() const { return m_object_depth == 2 && !m_in_threads; }
+    bool is_in_thread() const { return m_object_depth == 3; }
+
+    template<typename T>
+    static T integer_or_zero(JsonValue const& value)
+    {
+        return value.is_integer<T>() ? value.as_integer<T>() : 0;
+    }
+
+    AllProcessesStatistics& m_statistics;
+    StringView m_key;
+    bool m_in_processes { false };
+    bool m_in_threads { false };
+    size_t m_object_depth { 0 };
+    size_t m_skipped_depth { 0 };
+};
+
 ErrorOr<AllProcessesStatistics> ProcessStatisticsReader::get_all(SeekableStream& proc_all_file, bool include_usernames)
 {
     TRY(proc_all_file.seek(0, SeekMode::SetPosition));
 
-    AllProcessesStatistics all_processes_statistics;
+    AllProcessesStatistics all_processes_statistics {};
 
     auto file_contents = TRY(proc_all_file.read_until_eof());
-    auto json_obj = TRY(JsonValue::from_string(file_contents)).as_object();
-    json_obj.get_array("processes"sv)->for_each([&](auto& value) {
-        const JsonObject& process_object = value.as_object();
-        Core::ProcessStatistics process;
-
-        // kernel data first
-        process.pid = process_object.get_u32("pid"sv).value_or(0);
-        process.pgid = process_object.get_u32("pgid"sv).value_or(0);
-        process.pgp = process_object.get_u32("pgp"sv).value_or(0);
-        process.sid = process_object.get_u32("sid"sv).value_or(0);
-        process.uid = process_object.get_u32("uid"sv).value_or(0);
-        process.gid = process_object.get_u32("gid"sv).value_or(0);
-        process.ppid = process_object.get_u32("ppid"sv).value_or(0);
-        process.kernel = process_object.get_bool("kernel"sv).value_or(false);
-        process.name = process_object.get_deprecated_string("name"sv).value_or("");
-        process.executable = process_object.get_deprecated_string("executable"sv).value_or("");
-        process.tty = process_object.get_deprecated_string("tty"sv).value_or("");
-        process.pledge = process_object.get_deprecated_string("pledge"sv).value_or("");
-        process.veil = process_object.get_deprecated_string("veil"sv).value_or("");
-        process.creation_time = UnixDateTime::from_nanoseconds_since_epoch(process_object.get_i64("creation_time"sv).value_or(0));
-        process.amount_virtual = process_object.get_u32("amount_virtual"sv).value_or(0);
-        process.amount_resident = process_object.get_u32("amount_resident"sv).value_or(0);
-        process.amount_shared = process_object.get_u32("amount_shared"sv).value_or(0);
-        process.amount_dirty_private = process_object.get_u32("amount_dirty_private"sv).value_or(0);
-        process.amount_clean_inode = process_object.get_u32("amount_clean_inode"sv).value_or(0);
-        process.amount_purgeable_volatile = process_object.get_u32("amount_purgeable_volatile"sv).value_or(0);
-        process.amount_purgeable_nonvolatile = process_object.get_u32("amount_purgeable_nonvolatile"sv).value_or(0);
-
-        auto& thread_array = process_object.get_array("threads"sv).value();
-        process.threads.ensure_capacity(thread_array.size());
-        thread_array.for_each([&](auto& value) {
-            auto& thread_object = value.as_object();
-            Core::ThreadStatistics thread;
-            thread.tid = thread_object.get_u32("tid"sv).value_or(0);
-            thread.times_scheduled = thread_object.get_u32("times_scheduled"sv).value_or(0);
-            thread.name = thread_object.get_deprecated_string("name"sv).value_or("");
-            thread.state = thread_object.get_deprecated_string("state"sv).value_or("");
-            thread.time_user = thread_object.get_u64("time_user"sv).value_or(0);
-            thread.time_kernel = thread_object.get_u64("time_kernel"sv).value_or(0);
-            thread.cpu = thread_object.get_u32("cpu"sv).value_or(0);
-            thread.priority = thread_object.get_u32("priority"sv).value_or(0);
-            thread.syscall_count = thread_object.get_u32("syscall_count"sv).value_or(0);
-            thread.inode_faults = thread_object.get_u32("inode_faults"sv).value_or(0);
-            thread.zero_faults = thread_object.get_u32("zero_faults"sv).value_or(0);
-            thread.cow_faults = thread_object.get_u32("cow_faults"sv).value_or(0);
-            thread.unix_socket_read_bytes = thread_object.get_u64("unix_socket_read_bytes"sv).value_or(0);
-            thread.unix_socket_write_bytes = thread_object.get_u64("unix_socket_write_bytes"sv).value_or(0);
-            thread.ipv4_socket_read_bytes = thread_object.get_u64("ipv4_socket_read_bytes"sv).value_or(0);
-            thread.ipv4_socket_write_bytes = thread_object.get_u64("ipv4_socket_write_bytes"sv).value_or(0);
-            thread.file_read_bytes = thread_object.get_u64("file_read_bytes"sv).value_or(0);
-            thread.file_write_bytes = thread_object.get_u64("file_write_bytes"sv).value_or(0);
-            process.threads.append(move(thread));
-        });
-
-        // and synthetic data last
-        if (include_usernames) {
+    ProcessStatisticsVisitor visitor { all_processes_statistics };
+    TRY(JsonStreamingParser { file_contents }.parse(visitor));
+
+    // Synthetic data last.
+    if (include_usernames) {
+        for (auto& process : all_processes_statistics.processes)
             process.username = username_from_uid(process.uid);
-        }
-        all_processes_statistics.processes.append(move(process));
-    });
+    }
 
-    all_processes_statistics.total_time_scheduled = json_obj.get_u64("total_time"sv).value_or(0);
-    all_processes_statistics.total_time_scheduled_kernel = json_obj.get_u64("total_time_kernel"sv).value_or(0);
     return all_processes_statistics;
 }
 
@@ -36,6 +36,10 @@
 #    include <sys/sysmacros.h>
 #endif
 
+#if defined(AK_OS_SERENITY) || defined(AK_OS_LINUX)
+#    include <sys/sendfile.h>
+#endif
+
 #if defined(AK_OS_LINUX) && !defined(MFD_CLOEXEC)
 #    include <linux/memfd.h>
 #    include <sys/syscall.h>
@@ -372,6 +376,18 @@ ErrorOr<void> profiling_free_buffer(pid_t pid)
     int rc = ::profiling_free_buffer(pid);
     HANDLE_SYSCALL_RETURN_VALUE("profiling_free_buffer", rc, {});
 }
+
+ErrorOr<int> io_ring_setup(u32 entries, IORingParameters& parameters)
+{
+    int rc = ::io_ring_setup(entries, &parameters);
+    HANDLE_SYSCALL_RETURN_VALUE("io_ring_setup", rc, rc);
+}
+
+ErrorOr<size_t> io_ring_enter(int ring_fd, u32 to_submit, u32 minimum_completions)
+{
+    int rc = ::io_ring_enter(ring_fd, to_submit, minimum_completions);
+    HANDLE_SYSCALL_RETURN_VALUE("io_ring_enter", rc, static_cast<size_t>(rc));
+}
 #endif
 
 #if !defined(AK_OS_BSD_GENERIC) && !defined(AK_OS_ANDROID)
@@ -650,6 +666,16 @@ ErrorOr<ssize_t> write(int fd, ReadonlyBytes buffer)
     return rc;
 }
 
+#if defined(AK_OS_SERENITY) || defined(AK_OS_LINUX)
+ErrorOr<ssize_t> sendfile(int out_fd, int in_fd, off_t* offset, size_t count)
+{
+    ssize_t rc = ::sendfile(out_fd, in_fd, offset, count);
+    if (rc < 0)
+        return Error::from_syscall("sendfile"sv, -errno);
+    return rc;
+}
+#endif
+
 ErrorOr<void> kill(pid_t pid, int signal)
 {
     if (::kill(pid, signal) < 0)
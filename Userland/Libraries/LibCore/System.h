@@ -32,6 +32,7 @@
 #include <utime.h>
 
 #ifdef AK_OS_SERENITY
+#    include <Kernel/API/IORing.h>
 #    include <Kernel/API/Jail.h>
 #endif
 
@@ -69,6 +70,8 @@ ErrorOr<void> disown(pid_t pid);
 ErrorOr<void> profiling_enable(pid_t, u64 event_mask);
 ErrorOr<void> profiling_disable(pid_t);
 ErrorOr<void> profiling_free_buffer(pid_t);
+ErrorOr<int> io_ring_setup(u32 entries, IORingParameters&);
+ErrorOr<size_t> io_ring_enter(int ring_fd, u32 to_submit, u32 minimum_completions);
 #else
 inline ErrorOr<void> unveil(StringView, StringView)
 {
@@ -131,6 +134,9 @@ ErrorOr<struct stat> stat(StringView path);
 ErrorOr<struct stat> lstat(StringView path);
 ErrorOr<ssize_t> read(int fd, Bytes buffer);
 ErrorOr<ssize_t> write(int fd, ReadonlyBytes buffer);
+#if defined(AK_OS_SERENITY) || defined(AK_OS_LINUX)
+ErrorOr<ssize_t> sendfile(int out_fd, int in_fd, off_t* offset, size_t count);
+#endif
 ErrorOr<void> kill(pid_t, int signal);
 ErrorOr<void> killpg(int pgrp, int signal);
 ErrorOr<int> dup(int source_fd);
@@ -22,69 +22,94 @@ ErrorOr<ByteBuffer> ChaCha20Poly1305::poly1305_key()
 }
 
 // https://datatracker.ietf.org/doc/html/rfc8439#section-2.8
-ErrorOr<ByteBuffer> ChaCha20Poly1305::encrypt(ReadonlyBytes aad, ReadonlyBytes input_plaintext)
+void ChaCha20Poly1305::compute_tag(ReadonlyBytes nonce, ReadonlyBytes aad, ReadonlyBytes ciphertext, Bytes tag)
 {
+    VERIFY(tag.size() == TAG_SIZE);
+
     // First, a Poly1305 one-time key is generated from the 256-bit key
     // and nonce using the procedure described in Section 2.6.
-    auto otk = TRY(poly1305_key());
-
-    // Next, the ChaCha20 encryption function is called to encrypt the
-    // plaintext, using the same key and nonce, and with the initial
-    // counter set to 1.
-    auto ciphertext_buffer = TRY(ByteBuffer::create_zeroed(input_plaintext.size()));
-    auto ciphertext = ciphertext_buffer.bytes();
-    auto chacha = Crypto::Cipher::ChaCha20(m_key, m_nonce, 1);
-    chacha.encrypt(input_plaintext, ciphertext);
-
-    // Finally, the Poly1305 function is called with the Poly1305 key
-    // calculated above, and a message constructed as a concatenation of
-    // the following:
-    auto mac_data = TRY(ByteBuffer::create_zeroed(0));
-    auto buffer_size = aad.size() + pad_to_16(aad) + ciphertext_buffer.size() + pad_to_16(ciphertext_buffer) + sizeof(u64) + sizeof(u64);
-    mac_data.ensure_capacity(buffer_size);
+    Crypto::Cipher::ChaCha20 cipher(m_key, nonce, 0);
+    cipher.generate_block();
+    auto otk = cipher.block().slice(0, 32);
+
+    // The Poly1305 function is called with the Poly1305 key calculated above,
+    // and a message constructed as a concatenation of the following.
+    // NOTE: The message is fed to Poly1305 piece by piece rather than being assembled in a buffer first.
+    static constexpr u8 zeroes[16] {};
+    Crypto::Authentication::Poly1305 mac_function(otk);
 
     // The AAD
-    mac_data.append(aad);
+    mac_function.update(aad);
 
     // padding1 -- the padding is up to 15 zero bytes, and it brings
     // the total length so far to an integral multiple of 16.  If the
     // length of the AAD was already an integral multiple of 16 bytes,
     // this field is zero-length.
-    for (size_t i = 0; i < pad_to_16(aad); ++i)
-        mac_data.append(0);
+    mac_function.update({ zeroes, pad_to_16(aad.size()) });
 
     // The ciphertext
-    mac_data.append(ciphertext);
+    mac_function.update(ciphertext);
 
     // padding2 -- the padding is up to 15 zero bytes, and it brings
     // the total length so far to an integral multiple of 16.  If the
     // length of the ciphertext was already an integral multiple of 16
     // bytes, this field is zero-length.
-    for (size_t i = 0; i < pad_to_16(ciphertext); ++i)
-        mac_data.append(0);
+    mac_function.update({ zeroes, pad_to_16(ciphertext.size()) });
 
-    u8 placeholder[8] = { 0 };
     // The length of the additional data in octets (as a 64-bit little-endian integer).
-    mac_data.append(ReadonlyBytes { placeholder, 8 });
-    ByteReader::store(static_cast<u8*>(mac_data.end_pointer()) - sizeof(u64), AK::convert_between_host_and_little_endian(static_cast<u64>(aad.size())));
-
     // The length of the ciphertext in octets (as a 64-bit little-endian integer).
-    mac_data.append(ReadonlyBytes { placeholder, 8 });
-    ByteReader::store(static_cast<u8*>(mac_data.end_pointer()) - sizeof(u64), AK::convert_between_host_and_little_endian(static_cast<u64>(ciphertext.size())));
+    u64 lengths[2] = {
+        AK::convert_between_host_and_little_endian(static_cast<u64>(aad.size())),
+        AK::convert_between_host_and_little_endian(static_cast<u64>(ciphertext.size())),
+    };
+    mac_function.update({ lengths, sizeof(lengths) });
+
+    auto digest = MUST(mac_function.digest());
+    digest.bytes().copy_to(tag);
+}
 
-    Crypto::Authentication::Poly1305 mac_function(otk);
-    mac_function.update(mac_data.bytes());
-    auto tag = TRY(mac_function.digest());
+void ChaCha20Poly1305::run_cipher(ReadonlyBytes nonce, ReadonlyBytes in, Bytes out)
+{
+    // The ChaCha20 encryption function is called using the same key and nonce, and with the initial counter set to 1.
+    auto chacha = Crypto::Cipher::ChaCha20(m_key, nonce, 1);
+    chacha.encrypt(in, out);
+}
 
-    // The output from the AEAD is the concatenation of:
-    auto result = TRY(ByteBuffer::create_zeroed(0));
-    result.ensure_capacity(ciphertext.size() + tag.size());
+void ChaCha20Poly1305::encrypt(ReadonlyBytes in, Bytes out, ReadonlyBytes nonce, ReadonlyBytes aad, Bytes tag)
+{
+    run_cipher(nonce, in, out);
+    compute_tag(nonce, aad, out.trim(in.size()), tag);
+}
 
-    // A ciphertext of the same length as the plaintext.
-    result.append(ciphertext);
+VerificationConsistency ChaCha20Poly1305::decrypt(ReadonlyBytes in, Bytes out, ReadonlyBytes nonce, ReadonlyBytes aad, ReadonlyBytes tag)
+{
+    // The Poly1305 function is still run on the AAD and the ciphertext, not the plaintext.
+    u8 computed_tag[TAG_SIZE];
+    compute_tag(nonce, aad, in, { computed_tag, TAG_SIZE });
+
+    if (tag.size() != TAG_SIZE)
+        return VerificationConsistency::Inconsistent;
 
+    // With online protocols, implementation MUST use a constant-time comparison function rather
+    // than relying on optimized but insecure library functions such as the C language's memcmp().
+    u8 result = 0;
+    for (size_t i = 0; i < TAG_SIZE; ++i)
+        result |= computed_tag[i] ^ tag[i];
+    if (result != 0)
+        return VerificationConsistency::Inconsistent;
+
+    run_cipher(nonce, in, out);
+    return VerificationConsistency::Consistent;
+}
+
+// https://datatracker.ietf.org/doc/html/rfc8439#section-2.8
+ErrorOr<ByteBuffer> ChaCha20Poly1305::encrypt(ReadonlyBytes aad, ReadonlyBytes plaintext)
+{
+    // The output from the AEAD is the concatenation of:
+    // A ciphertext of the same length as the plaintext.
     // A 128-bit tag, which is the output of the Poly1305 function.
-    result.append(tag);
+    auto result = TRY(ByteBuffer::create_uninitialized(plaintext.size() + TAG_SIZE));
+    encrypt(plaintext, result.bytes(), m_nonce, aad, result.bytes().slice(plaintext.size()));
     return result;
 }
 
@@ -97,68 +122,10 @@ ErrorOr<ByteBuffer> ChaCha20Poly1305::decrypt(ReadonlyBytes aad, ReadonlyBytes c
     //    producing the plaintext.
     // o  The Poly1305 function is still run on the AAD and the ciphertext,
     //    not the plaintext.
-
-    // First, a Poly1305 one-time key is generated from the 256-bit key
-    // and nonce using the procedure described in Section 2.6.
-    auto otk = TRY(poly1305_key());
-
-    // Next, the ChaCha20 encryption function is called to decrypt the
-    // ciphertext, using the same key and nonce, and with the initial
-    // counter set to 1.
-    auto chacha = Crypto::Cipher::ChaCha20(m_key, m_nonce, 1);
-    auto plaintext_buffer = TRY(ByteBuffer::create_zeroed(ciphertext.size()));
-    auto plaintext = plaintext_buffer.bytes();
-    chacha.encrypt(ciphertext, plaintext);
-
-    // Finally, the Poly1305 function is called with the Poly1305 key
-    // calculated above, and a message constructed as a concatenation of
-    // the following:
-    auto mac_data = TRY(ByteBuffer::create_zeroed(0));
-    auto buffer_size = aad.size() + pad_to_16(aad) + ciphertext.size() + pad_to_16(ciphertext) + sizeof(u64) + sizeof(u64);
-    mac_data.ensure_capacity(buffer_size);
-
-    // The AAD
-    mac_data.append(aad);
-
-    // padding1 -- the padding is up to 15 zero bytes, and it brings
-    // the total length so far to an integral multiple of 16.  If the
-    // length of the AAD was already an integral multiple of 16 bytes,
-    // this field is zero-length.
-    for (size_t i = 0; i < pad_to_16(aad); ++i)
-        mac_data.append(0);
-
-    // The ciphertext
-    mac_data.append(ciphertext);
-
-    // padding2 -- the padding is up to 15 zero bytes, and it brings
-    // the total length so far to an integral multiple of 16.  If the
-    // length of the ciphertext was already an integral multiple of 16
-    // bytes, this field is zero-length.
-    for (size_t i = 0; i < pad_to_16(ciphertext); ++i)
-        mac_data.append(0);
-
-    u8 placeholder[8] = { 0 };
-    // The length of the additional data in octets (as a 64-bit little-endian integer).
-    mac_data.append(ReadonlyBytes { placeholder, 8 });
-    ByteReader::store(static_cast<u8*>(mac_data.end_pointer()) - sizeof(u64), AK::convert_between_host_and_little_endian(static_cast<u64>(aad.size())));
-
-    // The length of the ciphertext in octets (as a 64-bit little-endian integer).
-    mac_data.append(ReadonlyBytes { placeholder, 8 });
-    ByteReader::store(static_cast<u8*>(mac_data.end_pointer()) - sizeof(u64), AK::convert_between_host_and_little_endian(static_cast<u64>(ciphertext.size())));
-
-    Crypto::Authentication::Poly1305 mac_function(otk);
-    mac_function.update(mac_data.bytes());
-    auto tag = TRY(mac_function.digest());
-
-    // The output from the AEAD is the concatenation of:
-    auto result = TRY(ByteBuffer::create_zeroed(0));
-    result.ensure_capacity(plaintext.size() + tag.size());
-
-    // A plaintext of the same length as the ciphertext.
-    result.append(plaintext);
-
-    // A 128-bit tag, which is the output of the Poly1305 function.
-    result.append(tag);
+    // The output is the plaintext followed by the computed tag, which callers check with verify_tag().
+    auto result = TRY(ByteBuffer::create_uninitialized(ciphertext.size() + TAG_SIZE));
+    run_cipher(m_nonce, ciphertext, result.bytes());
+    compute_tag(m_nonce, aad, ciphertext, result.bytes().slice(ciphertext.size()));
     return result;
 }
 
@@ -7,12 +7,15 @@
 #pragma once
 
 #include <AK/ByteBuffer.h>
+#include <LibCrypto/Verification.h>
 
 namespace Crypto::AEAD {
 
 class ChaCha20Poly1305 {
 public:
-    explicit ChaCha20Poly1305(ReadonlyBytes key, ReadonlyBytes nonce)
+    static constexpr size_t TAG_SIZE = 16;
+
+    explicit ChaCha20Poly1305(ReadonlyBytes key, ReadonlyBytes nonce = {})
     {
         m_key = MUST(ByteBuffer::copy(key));
         m_nonce = MUST(ByteBuffer::copy(nonce));
@@ -23,10 +26,18 @@ public:
     ErrorOr<ByteBuffer> poly1305_key();
     static bool verify_tag(ReadonlyBytes encrypted, ReadonlyBytes decrypted);
 
+    // These take the nonce for every message and write into caller-provided buffers,
+    // which suits record protocols such as TLS that use a fresh nonce for every record.
+    void encrypt(ReadonlyBytes in, Bytes out, ReadonlyBytes nonce, ReadonlyBytes aad, Bytes tag);
+    VerificationConsistency decrypt(ReadonlyBytes in, Bytes out, ReadonlyBytes nonce, ReadonlyBytes aad, ReadonlyBytes tag);
+
 private:
-    u8 pad_to_16(ReadonlyBytes data)
+    void compute_tag(ReadonlyBytes nonce, ReadonlyBytes aad, ReadonlyBytes ciphertext, Bytes tag);
+    void run_cipher(ReadonlyBytes nonce, ReadonlyBytes in, Bytes out);
+
+    static size_t pad_to_16(size_t length)
     {
-        return 16 - (data.size() % 16);
+        return (16 - length % 16) % 16;
     }
 
     ByteBuffer m_key;
@@ -10,217 +10,174 @@
 
 namespace Crypto::Authentication {
 
+using DoubleLimb = unsigned __int128;
+
+static constexpr u64 mask_44_bits = (1ull << 44) - 1;
+static constexpr u64 mask_42_bits = (1ull << 42) - 1;
+
+ALWAYS_INLINE static u64 load64(u8 const* data)
+{
+    return AK::convert_between_host_and_little_endian(ByteReader::load64(data));
+}
+
 Poly1305::Poly1305(ReadonlyBytes key)
 {
-    for (size_t i = 0; i < 16; i += 4) {
-        m_state.r[i / 4] = AK::convert_between_host_and_little_endian(ByteReader::load32(key.offset(i)));
-    }
+    auto r0 = load64(key.offset(0));
+    auto r1 = load64(key.offset(8));
 
     // r[3], r[7], r[11], and r[15] are required to have their top four bits clear (be smaller than 16)
     // r[4], r[8], and r[12] are required to have their bottom two bits clear (be divisible by 4)
-    m_state.r[0] &= 0x0FFFFFFF;
-    m_state.r[1] &= 0x0FFFFFFC;
-    m_state.r[2] &= 0x0FFFFFFC;
-    m_state.r[3] &= 0x0FFFFFFC;
+    // NOTE: The masks below apply this clamping while splitting r into 44/44/42-bit limbs.
+    m_state.r[0] = r0 & 0xffc0fffffff;
+    m_state.r[1] = ((r0 >> 44) | (r1 << 20)) & 0xfffffc0ffff;
+    m_state.r[2] = (r1 >> 24) & 0x00ffffffc0f;
 
-    for (size_t i = 16; i < 32; i += 4) {
-        m_state.s[(i - 16) / 4] = AK::convert_between_host_and_little_endian(ByteReader::load32(key.offset(i)));
-    }
+    m_state.s[0] = load64(key.offset(16));
+    m_state.s[1] = load64(key.offset(24));
 }
 
 void Poly1305::update(ReadonlyBytes message)
 {
-    size_t offset = 0;
-    while (offset < message.size()) {
-        u32 n = min(message.size() - offset, 16 - m_state.block_count);
-        memcpy(m_state.blocks + m_state.block_count, message.offset_pointer(offset), n);
+    // Top up a partially filled block first.
+    if (m_state.block_count != 0) {
+        size_t n = min(message.size(), 16 - m_state.block_count);
+        memcpy(m_state.blocks + m_state.block_count, message.data(), n);
         m_state.block_count += n;
-        offset += n;
+        message = message.slice(n);
+
+        if (m_state.block_count < 16)
+            return;
 
-        if (m_state.block_count == 16) {
-            process_block();
-            m_state.block_count = 0;
-        }
+        process_blocks({ m_state.blocks, 16 });
+        m_state.block_count = 0;
     }
+
+    // Then process all full blocks straight out of the message, and keep the remainder for later.
+    size_t full_blocks_size = message.size() - message.size() % 16;
+    if (full_blocks_size != 0)
+        process_blocks(message.trim(full_blocks_size));
+
+    auto remainder = message.slice(full_blocks_size);
+    memcpy(m_state.blocks, remainder.data(), remainder.size());
+    m_state.block_count = remainder.size();
 }
 
-void Poly1305::process_block()
+// Computes h = (h + block) * r % (2^130 - 5) for every 16-byte block.
+void Poly1305::process_blocks(ReadonlyBytes blocks, bool is_final_block)
 {
-    u32 a[5];
-    u8 n = m_state.block_count;
-
     // Add one bit beyond the number of octets.  For a 16-byte block,
-    // this is equivalent to adding 2^128 to the number.  For the shorter
-    // block, it can be 2^120, 2^112, or any power of two that is evenly
-    // divisible by 8, all the way down to 2^8.
-    m_state.blocks[n++] = 0x01;
-
-    // If the block is not 17 bytes long (the last block), pad it with zeros.
-    // This is meaningless if you are treating the blocks as numbers.
-    while (n < 17) {
-        m_state.blocks[n++] = 0x00;
+    // this is equivalent to adding 2^128 to the number.  The final, shorter block
+    // already has its 0x01 byte appended by digest().
+    u64 high_bit = is_final_block ? 0 : 1ull << 40;
+
+    auto [r0, r1, r2] = m_state.r;
+    auto [h0, h1, h2] = m_state.h;
+
+    // 2^130 == 5 (mod 2^130 - 5), so the limbs that would end up above 2^130 can be folded back in after multiplying by 5 * 4
+    // (the extra factor 4 accounts for the 2 bits the top limb is short of 44).
+    u64 s1 = r1 * (5 << 2);
+    u64 s2 = r2 * (5 << 2);
+
+    for (size_t offset = 0; offset < blocks.size(); offset += 16) {
+        // Read the block as a little-endian number, and add it to the accumulator.
+        auto t0 = load64(blocks.offset(offset));
+        auto t1 = load64(blocks.offset(offset + 8));
+
+        h0 += t0 & mask_44_bits;
+        h1 += ((t0 >> 44) | (t1 << 20)) & mask_44_bits;
+        h2 += ((t1 >> 24) & mask_42_bits) | high_bit;
+
+        // Multiply by r
+        DoubleLimb d0 = static_cast<DoubleLimb>(h0) * r0 + static_cast<DoubleLimb>(h1) * s2 + static_cast<DoubleLimb>(h2) * s1;
+        DoubleLimb d1 = static_cast<DoubleLimb>(h0) * r1 + static_cast<DoubleLimb>(h1) * r0 + static_cast<DoubleLimb>(h2) * s2;
+        DoubleLimb d2 = static_cast<DoubleLimb>(h0) * r2 + static_cast<DoubleLimb>(h1) * r1 + static_cast<DoubleLimb>(h2) * r0;
+
+        // Partial modular reduction: carry through the limbs, folding the top carry back into the bottom limb.
+        u64 carry = static_cast<u64>(d0 >> 44);
+        h0 = static_cast<u64>(d0) & mask_44_bits;
+        d1 += carry;
+        carry = static_cast<u64>(d1 >> 44);
+        h1 = static_cast<u64>(d1) & mask_44_bits;
+        d2 += carry;
+        carry = static_cast<u64>(d2 >> 42);
+        h2 = static_cast<u64>(d2) & mask_42_bits;
+        h0 += carry * 5;
+        carry = h0 >> 44;
+        h0 &= mask_44_bits;
+        h1 += carry;
     }
 
-    // Read the block as a little-endian number.
-    for (size_t i = 0; i < 16; i += 4) {
-        a[i / 4] = AK::convert_between_host_and_little_endian(ByteReader::load32(m_state.blocks + i));
-    }
-    a[4] = m_state.blocks[16];
-
-    // Add this number to the accumulator.
-    m_state.a[0] += a[0];
-    m_state.a[1] += a[1];
-    m_state.a[2] += a[2];
-    m_state.a[3] += a[3];
-    m_state.a[4] += a[4];
-
-    // Carry
-    m_state.a[1] += m_state.a[0] >> 32;
-    m_state.a[2] += m_state.a[1] >> 32;
-    m_state.a[3] += m_state.a[2] >> 32;
-    m_state.a[4] += m_state.a[3] >> 32;
-
-    // Only consider the least significant bits
-    a[0] = m_state.a[0] & 0xFFFFFFFF;
-    a[1] = m_state.a[1] & 0xFFFFFFFF;
-    a[2] = m_state.a[2] & 0xFFFFFFFF;
-    a[3] = m_state.a[3] & 0xFFFFFFFF;
-    a[4] = m_state.a[4] & 0xFFFFFFFF;
-
-    // Multiply by r
-    m_state.a[0] = (u64)a[0] * m_state.r[0];
-    m_state.a[1] = (u64)a[0] * m_state.r[1] + (u64)a[1] * m_state.r[0];
-    m_state.a[2] = (u64)a[0] * m_state.r[2] + (u64)a[1] * m_state.r[1] + (u64)a[2] * m_state.r[0];
-    m_state.a[3] = (u64)a[0] * m_state.r[3] + (u64)a[1] * m_state.r[2] + (u64)a[2] * m_state.r[1] + (u64)a[3] * m_state.r[0];
-    m_state.a[4] = (u64)a[1] * m_state.r[3] + (u64)a[2] * m_state.r[2] + (u64)a[3] * m_state.r[1] + (u64)a[4] * m_state.r[0];
-    m_state.a[5] = (u64)a[2] * m_state.r[3] + (u64)a[3] * m_state.r[2] + (u64)a[4] * m_state.r[1];
-    m_state.a[6] = (u64)a[3] * m_state.r[3] + (u64)a[4] * m_state.r[2];
-    m_state.a[7] = (u64)a[4] * m_state.r[3];
-
-    // Carry
-    m_state.a[1] += m_state.a[0] >> 32;
-    m_state.a[2] += m_state.a[1] >> 32;
-    m_state.a[3] += m_state.a[2] >> 32;
-    m_state.a[4] += m_state.a[3] >> 32;
-    m_state.a[5] += m_state.a[4] >> 32;
-    m_state.a[6] += m_state.a[5] >> 32;
-    m_state.a[7] += m_state.a[6] >> 32;
-
-    // Save the high part of the accumulator
-    a[0] = m_state.a[4] & 0xFFFFFFFC;
-    a[1] = m_state.a[5] & 0xFFFFFFFF;
-    a[2] = m_state.a[6] & 0xFFFFFFFF;
-    a[3] = m_state.a[7] & 0xFFFFFFFF;
-
-    // Only consider the least significant bits
-    m_state.a[0] &= 0xFFFFFFFF;
-    m_state.a[1] &= 0xFFFFFFFF;
-    m_state.a[2] &= 0xFFFFFFFF;
-    m_state.a[3] &= 0xFFFFFFFF;
-    m_state.a[4] &= 0x00000003;
-
-    // Fast modular reduction (first pass)
-    m_state.a[0] += a[0];
-    m_state.a[0] += (a[0] >> 2) | (a[1] << 30);
-    m_state.a[1] += a[1];
-    m_state.a[1] += (a[1] >> 2) | (a[2] << 30);
-    m_state.a[2] += a[2];
-    m_state.a[2] += (a[2] >> 2) | (a[3] << 30);
-    m_state.a[3] += a[3];
-    m_state.a[3] += (a[3] >> 2);
-
-    // Carry
-    m_state.a[1] += m_state.a[0] >> 32;
-    m_state.a[2] += m_state.a[1] >> 32;
-    m_state.a[3] += m_state.a[2] >> 32;
-    m_state.a[4] += m_state.a[3] >> 32;
-
-    // Save the high part of the accumulator
-    a[0] = m_state.a[4] & 0xFFFFFFFC;
-
-    // Only consider the least significant bits
-    m_state.a[0] &= 0xFFFFFFFF;
-    m_state.a[1] &= 0xFFFFFFFF;
-    m_state.a[2] &= 0xFFFFFFFF;
-    m_state.a[3] &= 0xFFFFFFFF;
-    m_state.a[4] &= 0x00000003;
-
-    // Fast modular reduction (second pass)
-    m_state.a[0] += a[0];
-    m_state.a[0] += a[0] >> 2;
-
-    // Carry
-    m_state.a[1] += m_state.a[0] >> 32;
-    m_state.a[2] += m_state.a[1] >> 32;
-    m_state.a[3] += m_state.a[2] >> 32;
-    m_state.a[4] += m_state.a[3] >> 32;
-
-    // Only consider the least significant bits
-    m_state.a[0] &= 0xFFFFFFFF;
-    m_state.a[1] &= 0xFFFFFFFF;
-    m_state.a[2] &= 0xFFFFFFFF;
-    m_state.a[3] &= 0xFFFFFFFF;
-    m_state.a[4] &= 0x00000003;
+    m_state.h[0] = h0;
+    m_state.h[1] = h1;
+    m_state.h[2] = h2;
 }
 
 ErrorOr<ByteBuffer> Poly1305::digest()
 {
-    if (m_state.block_count != 0)
-        process_block();
-
-    u32 b[4];
-
-    // Save the accumulator
-    b[0] = m_state.a[0] & 0xFFFFFFFF;
-    b[1] = m_state.a[1] & 0xFFFFFFFF;
-    b[2] = m_state.a[2] & 0xFFFFFFFF;
-    b[3] = m_state.a[3] & 0xFFFFFFFF;
-
-    // Compute a + 5
-    m_state.a[0] += 5;
-
-    // Carry
-    m_state.a[1] += m_state.a[0] >> 32;
-    m_state.a[2] += m_state.a[1] >> 32;
-    m_state.a[3] += m_state.a[2] >> 32;
-    m_state.a[4] += m_state.a[3] >> 32;
-
-    // Select mask based on (a + 5) >= 2^130
-    u32 mask = ((m_state.a[4] & 0x04) >> 2) - 1;
+    // If the last block is not 16 bytes long, add a 0x01 byte after the message and pad it with zeros.
+    if (m_state.block_count != 0) {
+        m_state.blocks[m_state.block_count] = 0x01;
+        memset(m_state.blocks + m_state.block_count + 1, 0, 16 - m_state.block_count - 1);
+        process_blocks({ m_state.blocks, 16 }, true);
+    }
 
-    // Select based on mask
-    m_state.a[0] = (m_state.a[0] & ~mask) | (b[0] & mask);
-    m_state.a[1] = (m_state.a[1] & ~mask) | (b[1] & mask);
-    m_state.a[2] = (m_state.a[2] & ~mask) | (b[2] & mask);
-    m_state.a[3] = (m_state.a[3] & ~mask) | (b[3] & mask);
+    auto [h0, h1, h2] = m_state.h;
+
+    // Fully carry the accumulator
+    u64 carry = h1 >> 44;
+    h1 &= mask_44_bits;
+    h2 += carry;
+    carry = h2 >> 42;
+    h2 &= mask_42_bits;
+    h0 += carry * 5;
+    carry = h0 >> 44;
+    h0 &= mask_44_bits;
+    h1 += carry;
+    carry = h1 >> 44;
+    h1 &= mask_44_bits;
+    h2 += carry;
+    carry = h2 >> 42;
+    h2 &= mask_42_bits;
+    h0 += carry * 5;
+    carry = h0 >> 44;
+    h0 &= mask_44_bits;
+    h1 += carry;
+
+    // Compute g = h + 5 - 2^130
+    u64 g0 = h0 + 5;
+    carry = g0 >> 44;
+    g0 &= mask_44_bits;
+    u64 g1 = h1 + carry;
+    carry = g1 >> 44;
+    g1 &= mask_44_bits;
+    u64 g2 = h2 + carry - (1ull << 42);
+
+    // Select g if h >= 2^130 - 5 (g did not underflow), h otherwise, in constant time.
+    u64 mask = (g2 >> 63) - 1;
+    h0 = (h0 & ~mask) | (g0 & mask);
+    h1 = (h1 & ~mask) | (g1 & mask);
+    h2 = (h2 & ~mask) | (g2 & mask);
 
     // Finally, the value of the secret key "s" is added to the accumulator,
     // and the 128 least significant bits are serialized in little-endian
     // order to form the tag.
-    m_state.a[0] += m_state.s[0];
-    m_state.a[1] += m_state.s[1];
-    m_state.a[2] += m_state.s[2];
-    m_state.a[3] += m_state.s[3];
-
-    // Carry
-    m_state.a[1] += m_state.a[0] >> 32;
-    m_state.a[2] += m_state.a[1] >> 32;
-    m_state.a[3] += m_state.a[2] >> 32;
-    m_state.a[4] += m_state.a[3] >> 32;
-
-    // Only consider the least significant bits
-    b[0] = m_state.a[0] & 0xFFFFFFFF;
-    b[1] = m_state.a[1] & 0xFFFFFFFF;
-    b[2] = m_state.a[2] & 0xFFFFFFFF;
-    b[3] = m_state.a[3] & 0xFFFFFFFF;
-
-    ByteBuffer output = TRY(ByteBuffer::create_uninitialized(16));
-
-    for (auto i = 0; i < 4; i++) {
-        ByteReader::store(output.offset_pointer(i * 4), AK::convert_between_host_and_little_endian(b[i]));
-    }
-
-    return output;
+    auto s0 = m_state.s[0];
+    auto s1 = m_state.s[1];
+    h0 += s0 & mask_44_bits;
+    carry = h0 >> 44;
+    h0 &= mask_44_bits;
+    h1 += (((s0 >> 44) | (s1 << 20)) & mask_44_bits) + carry;
+    carry = h1 >> 44;
+    h1 &= mask_44_bits;
+    h2 += ((s1 >> 24) & mask_42_bits) + carry;
+    h2 &= mask_42_bits;
+
+    u64 tag[2] = {
+        AK::convert_between_host_and_little_endian(h0 | (h1 << 44)),
+        AK::convert_between_host_and_little_endian((h1 >> 20) | (h2 << 24)),
+    };
+
+    return ByteBuffer::copy(tag, sizeof(tag));
 }
 
 }
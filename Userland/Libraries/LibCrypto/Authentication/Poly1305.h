@@ -10,11 +10,13 @@
 
 namespace Crypto::Authentication {
 
+// The accumulator and r are kept in radix 2^44 (44 + 44 + 42 bits), so that every
+// limb product fits in a 128-bit integer and carries can be deferred until after the multiplication.
 struct State {
-    u32 r[4] {};
-    u32 s[4] {};
-    u64 a[8] {};
-    u8 blocks[17] {};
+    u64 r[3] {};
+    u64 s[2] {};
+    u64 h[3] {};
+    u8 blocks[16] {};
     u8 block_count {};
 };
 
@@ -26,7 +28,7 @@ public:
     ErrorOr<ByteBuffer> digest();
 
 private:
-    void process_block();
+    void process_blocks(ReadonlyBytes blocks, bool is_final_block = false);
 
     State m_state;
 };
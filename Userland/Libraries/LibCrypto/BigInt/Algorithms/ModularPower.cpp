@@ -9,6 +9,10 @@
 
 namespace Crypto {
 
+using AK::NativeWord;
+using AK::word_size;
+using AK::Detail::DoubleWord;
+
 void UnsignedBigIntegerAlgorithms::destructive_modular_power_without_allocation(
     UnsignedBigInteger& ep,
     UnsignedBigInteger& base,
@@ -18,6 +22,7 @@ void UnsignedBigIntegerAlgorithms::destructive_modular_power_without_allocation(
     UnsignedBigInteger& temp_3,
     UnsignedBigInteger& temp_4,
     UnsignedBigInteger& temp_multiply,
+    MultiplicationScratch& temp_words,
     UnsignedBigInteger& temp_quotient,
     UnsignedBigInteger& temp_remainder,
     UnsignedBigInteger& exp)
@@ -26,7 +31,7 @@ void UnsignedBigIntegerAlgorithms::destructive_modular_power_without_allocation(
     while (!(ep < 1)) {
         if (ep.words()[0] % 2 == 1) {
             // exp = (exp * base) % m;
-            multiply_without_allocation(exp, base, temp_1, temp_2, temp_3, temp_multiply);
+            multiply_without_allocation(exp, base, temp_words, temp_multiply);
             divide_without_allocation(temp_multiply, m, temp_1, temp_2, temp_3, temp_4, temp_quotient, temp_remainder);
             exp.set_to(temp_remainder);
         }
@@ -36,7 +41,7 @@ void UnsignedBigIntegerAlgorithms::destructive_modular_power_without_allocation(
         ep.set_to(temp_quotient);
 
         // base = (base * base) % m;
-        multiply_without_allocation(base, base, temp_1, temp_2, temp_3, temp_multiply);
+        multiply_without_allocation(base, base, temp_words, temp_multiply);
         divide_without_allocation(temp_multiply, m, temp_1, temp_2, temp_3, temp_4, temp_quotient, temp_remainder);
         base.set_to(temp_remainder);
 
@@ -50,137 +55,98 @@ void UnsignedBigIntegerAlgorithms::destructive_modular_power_without_allocation(
 }
 
 /**
- * Compute (1/value) % 2^32.
+ * Compute (1/value) % 2^word_size.
  * This needs an odd input value
- * Algorithm from: Dumas, J.G. "On Newton–Raphson Iteration for Multiplicative Inverses Modulo Prime Powers".
+ * Newton-Raphson iteration: every odd value is its own inverse modulo 2^3,
+ * and each step then doubles the number of correct low bits.
  */
-ALWAYS_INLINE static u32 inverse_wrapped(u32 value)
+ALWAYS_INLINE static NativeWord inverse_wrapped(NativeWord value)
 {
     VERIFY(value & 1);
 
-    u64 b = static_cast<u64>(value);
-    u64 k0 = (2 - b);
-    u64 t = (b - 1);
-    size_t i = 1;
-    while (i < 32) {
-        t = t * t;
-        k0 = k0 * (t + 1);
-        i <<= 1;
-    }
-    return static_cast<u32>(-k0);
+    NativeWord inverse = value;
+    for (size_t correct_bits = 3; correct_bits < word_size; correct_bits *= 2)
+        inverse *= 2 - value * inverse;
+    return inverse;
 }
 
 /**
- * Computes z = x * y + c. z_carry contains the top bits, z contains the bottom bits.
- */
-ALWAYS_INLINE static void linear_multiplication_with_carry(u32 x, u32 y, u32 c, u32& z_carry, u32& z)
-{
-    u64 result = static_cast<u64>(x) * static_cast<u64>(y) + static_cast<u64>(c);
-    z_carry = static_cast<u32>(result >> 32);
-    z = static_cast<u32>(result);
-}
-
-/**
- * Computes z = a + b. z_carry contains the top bit (1 or 0), z contains the bottom bits.
- */
-ALWAYS_INLINE static void addition_with_carry(u32 a, u32 b, u32& z_carry, u32& z)
-{
-    u64 result = static_cast<u64>(a) + static_cast<u64>(b);
-    z_carry = static_cast<u32>(result >> 32);
-    z = static_cast<u32>(result);
-}
-
-/**
- * Computes a montgomery "fragment" for y_i. This computes "z[i] += x[i] * y_i" for all words while rippling the carry, and returns the carry.
- * Algorithm from: Gueron, "Efficient Software Implementations of Modular Exponentiation". (https://eprint.iacr.org/2011/239.pdf)
- */
-UnsignedBigInteger::Word UnsignedBigIntegerAlgorithms::montgomery_fragment(UnsignedBigInteger& z, size_t offset_in_z, UnsignedBigInteger const& x, UnsignedBigInteger::Word y_digit, size_t num_words)
-{
-    UnsignedBigInteger::Word carry { 0 };
-    for (size_t i = 0; i < num_words; ++i) {
-        UnsignedBigInteger::Word a_carry;
-        UnsignedBigInteger::Word a;
-        linear_multiplication_with_carry(x.m_words[i], y_digit, z.m_words[offset_in_z + i], a_carry, a);
-        UnsignedBigInteger::Word b_carry;
-        UnsignedBigInteger::Word b;
-        addition_with_carry(a, carry, b_carry, b);
-        z.m_words[offset_in_z + i] = b;
-        carry = a_carry + b_carry;
-    }
-    return carry;
-}
-
-/**
- * Computes the "almost montgomery" product : x * y * 2 ^ (-num_words * BITS_IN_WORD) % modulo
- * [Note : that means that the result z satisfies z * 2^(num_words * BITS_IN_WORD) % modulo = x * y % modulo]
+ * Computes the montgomery product : x * y * 2 ^ (-num_words * word_size) % modulo
  * assuming :
- *  - x, y and modulo are all already padded to num_words
- *  - k = inverse_wrapped(modulo) (optimization to not recompute K each time)
- * Algorithm from: Gueron, "Efficient Software Implementations of Modular Exponentiation". (https://eprint.iacr.org/2011/239.pdf)
+ *  - x, y and result are all num_words long, with x and y smaller than modulo
+ *  - k = -inverse_wrapped(modulo) (optimization to not recompute K each time)
+ *  - temp is num_words + 2 long
+ * Result may alias x or y.
+ * Algorithm from: Koç, Acar, Kaliski, "Analyzing and Comparing Montgomery Multiplication Algorithms" (CIOS method).
  */
-void UnsignedBigIntegerAlgorithms::almost_montgomery_multiplication_without_allocation(
-    UnsignedBigInteger const& x,
-    UnsignedBigInteger const& y,
-    UnsignedBigInteger const& modulo,
-    UnsignedBigInteger& z,
-    UnsignedBigInteger::Word k,
-    size_t num_words,
-    UnsignedBigInteger& result)
+void UnsignedBigIntegerAlgorithms::montgomery_multiply_native_words(
+    ReadonlySpan<NativeWord> x,
+    ReadonlySpan<NativeWord> y,
+    ReadonlySpan<NativeWord> modulo,
+    NativeWord k,
+    Span<NativeWord> temp,
+    Span<NativeWord> result)
 {
-    VERIFY(x.length() >= num_words);
-    VERIFY(y.length() >= num_words);
-    VERIFY(modulo.length() >= num_words);
-
-    z.set_to(0);
-    z.resize_with_leading_zeros(num_words * 2);
+    size_t num_words = modulo.size();
+    VERIFY(x.size() == num_words);
+    VERIFY(y.size() == num_words);
+    VERIFY(result.size() == num_words);
+    VERIFY(temp.size() == num_words + 2);
 
-    UnsignedBigInteger::Word previous_double_carry { 0 };
+    temp.fill(0);
     for (size_t i = 0; i < num_words; ++i) {
-        // z[i->num_words+i] += x * y_i
-        UnsignedBigInteger::Word carry_1 = montgomery_fragment(z, i, x, y.m_words[i], num_words);
-        // z[i->num_words+i] += modulo * (z_i * k)
-        UnsignedBigInteger::Word t = z.m_words[i] * k;
-        UnsignedBigInteger::Word carry_2 = montgomery_fragment(z, i, modulo, t, num_words);
-
-        // Compute the carry by combining all of the carries of the previous computations
-        // Put it "right after" the range that we computed above
-        UnsignedBigInteger::Word temp_carry = previous_double_carry + carry_1;
-        UnsignedBigInteger::Word overall_carry = temp_carry + carry_2;
-        z.m_words[num_words + i] = overall_carry;
-
-        // Detect if there was a "double carry" for this word by checking if our carry results are smaller than their components
-        previous_double_carry = (temp_carry < carry_1 || overall_carry < carry_2) ? 1 : 0;
+        // temp += x * y_i
+        NativeWord carry = 0;
+        for (size_t j = 0; j < num_words; ++j) {
+            DoubleWord product = static_cast<DoubleWord>(x[j]) * y[i] + temp[j] + carry;
+            temp[j] = static_cast<NativeWord>(product);
+            carry = static_cast<NativeWord>(product >> word_size);
+        }
+        DoubleWord top = static_cast<DoubleWord>(temp[num_words]) + carry;
+        temp[num_words] = static_cast<NativeWord>(top);
+        temp[num_words + 1] = static_cast<NativeWord>(top >> word_size);
+
+        // temp = (temp + modulo * m) / 2^word_size, where m is picked so that the lowest word becomes zero
+        NativeWord m = temp[0] * k;
+        DoubleWord product = static_cast<DoubleWord>(m) * modulo[0] + temp[0];
+        carry = static_cast<NativeWord>(product >> word_size);
+        for (size_t j = 1; j < num_words; ++j) {
+            product = static_cast<DoubleWord>(m) * modulo[j] + temp[j] + carry;
+            temp[j - 1] = static_cast<NativeWord>(product);
+            carry = static_cast<NativeWord>(product >> word_size);
+        }
+        top = static_cast<DoubleWord>(temp[num_words]) + carry;
+        temp[num_words - 1] = static_cast<NativeWord>(top);
+        temp[num_words] = temp[num_words + 1] + static_cast<NativeWord>(top >> word_size);
     }
 
-    if (previous_double_carry == 0) {
-        // Return the top num_words bytes of Z, which contains our result.
-        shift_right_by_n_words(z, num_words, result);
-        result.resize_with_leading_zeros(num_words);
-        return;
+    // At this point temp < 2 * modulo, so a single conditional subtraction brings it back in range.
+    bool needs_subtraction = temp[num_words] != 0;
+    if (!needs_subtraction) {
+        needs_subtraction = true;
+        for (size_t i = num_words; i-- > 0;) {
+            if (temp[i] != modulo[i]) {
+                needs_subtraction = temp[i] > modulo[i];
+                break;
+            }
+        }
     }
 
-    // We have a carry, so we're "one bigger" than we need to be.
-    // Subtract the modulo from the result (the top half of z), and write it to the bottom half of Z since we have space.
-    // (With carry, of course.)
-    UnsignedBigInteger::Word c { 0 };
-    for (size_t i = 0; i < num_words; ++i) {
-        UnsignedBigInteger::Word z_digit = z.m_words[num_words + i];
-        UnsignedBigInteger::Word modulo_digit = modulo.m_words[i];
-        UnsignedBigInteger::Word new_z_digit = z_digit - modulo_digit - c;
-        z.m_words[i] = new_z_digit;
-        // Detect if the subtraction underflowed - from "Hacker's Delight"
-        c = ((modulo_digit & ~z_digit) | ((modulo_digit | ~z_digit) & new_z_digit)) >> (UnsignedBigInteger::BITS_IN_WORD - 1);
+    if (!needs_subtraction) {
+        temp.trim(num_words).copy_to(result);
+        return;
     }
 
-    // Return the bottom num_words bytes of Z (with the carry bit handled)
-    z.m_words.resize(num_words);
-    result.set_to(z);
-    result.resize_with_leading_zeros(num_words);
+    bool borrow = false;
+    for (size_t i = 0; i < num_words; ++i)
+        result[i] = AK::Detail::sub_words(temp[i], modulo[i], borrow);
 }
 
 /**
- * Complexity: still O(N^3) with N the number of words in the largest word, but less complex than the classical mod power.
- * Note: the montgomery multiplications requires an inverse modulo over 2^32, which is only defined for odd numbers.
+ * Complexity: O(N^2 * E) with N the number of words in the modulo and E the number of bits in the exponent.
+ * The exponent is scanned from the most significant bit with a sliding window, so that
+ * only odd powers of the base need to be precomputed and runs of zero bits cost a single squaring each.
+ * Note: the montgomery multiplications requires an inverse modulo over 2^word_size, which is only defined for odd numbers.
  */
 void UnsignedBigIntegerAlgorithms::montgomery_modular_power_with_minimal_allocations(
     UnsignedBigInteger const& base,
@@ -197,88 +163,109 @@ void UnsignedBigIntegerAlgorithms::montgomery_modular_power_with_minimal_allocat
 {
     VERIFY(modulo.is_odd());
 
-    // Note: While this is a constexpr variable for clarity and could be changed in theory,
-    // various optimized parts of the algorithm rely on this value being exactly 4.
-    constexpr size_t window_size = 4;
+    size_t exponent_bits = exponent.one_based_index_of_highest_set_bit();
+    if (exponent_bits == 0) {
+        result.set_to(modulo == 1 ? 0 : 1);
+        return;
+    }
 
-    size_t num_words = modulo.trimmed_length();
-    UnsignedBigInteger::Word k = inverse_wrapped(modulo.m_words[0]);
+    size_t num_words = native_length(modulo.trimmed_length());
 
+    // rr = ( 2 ^ (2 * num_words * word_size) ) % modulo
     one.set_to(1);
-
-    // rr = ( 2 ^ (2 * modulo.length() * BITS_IN_WORD) ) % modulo
-    shift_left_by_n_words(one, 2 * num_words, x);
+    shift_left_by_n_words(one, 2 * num_words * words_per_native_word, x);
     divide_without_allocation(x, modulo, temp_z, one, z, zz, temp_extra, rr);
-    rr.resize_with_leading_zeros(num_words);
 
-    // x = base [% modulo, if x doesn't already fit in modulo's words]
+    // x = base [% modulo, if x doesn't already fit in modulo]
     x.set_to(base);
-    if (x.trimmed_length() > num_words)
+    if (!(x < modulo))
         divide_without_allocation(base, modulo, temp_z, one, z, zz, temp_extra, x);
-    x.resize_with_leading_zeros(num_words);
 
-    one.set_to(1);
-    one.resize_with_leading_zeros(num_words);
-
-    // Compute the montgomery powers from 0 to 2^window_size. powers[i] = x^i
-    UnsignedBigInteger powers[1 << window_size];
-    almost_montgomery_multiplication_without_allocation(one, rr, modulo, temp_z, k, num_words, powers[0]);
-    almost_montgomery_multiplication_without_allocation(x, rr, modulo, temp_z, k, num_words, powers[1]);
-    for (size_t i = 2; i < (1 << window_size); ++i)
-        almost_montgomery_multiplication_without_allocation(powers[i - 1], powers[1], modulo, temp_z, k, num_words, powers[i]);
-
-    z.set_to(powers[0]);
-    z.resize_with_leading_zeros(num_words);
-    zz.set_to(0);
-    zz.resize_with_leading_zeros(num_words);
-
-    ssize_t exponent_length = exponent.trimmed_length();
-    for (ssize_t word_in_exponent = exponent_length - 1; word_in_exponent >= 0; --word_in_exponent) {
-        UnsignedBigInteger::Word exponent_word = exponent.m_words[word_in_exponent];
-        size_t bit_in_word = 0;
-        while (bit_in_word < UnsignedBigInteger::BITS_IN_WORD) {
-            if (word_in_exponent != exponent_length - 1 || bit_in_word != 0) {
-                almost_montgomery_multiplication_without_allocation(z, z, modulo, temp_z, k, num_words, zz);
-                almost_montgomery_multiplication_without_allocation(zz, zz, modulo, temp_z, k, num_words, z);
-                almost_montgomery_multiplication_without_allocation(z, z, modulo, temp_z, k, num_words, zz);
-                almost_montgomery_multiplication_without_allocation(zz, zz, modulo, temp_z, k, num_words, z);
-            }
-            auto power_index = exponent_word >> (UnsignedBigInteger::BITS_IN_WORD - window_size);
-            auto& power = powers[power_index];
-            almost_montgomery_multiplication_without_allocation(z, power, modulo, temp_z, k, num_words, zz);
+    Vector<NativeWord, STARTING_WORD_SIZE> modulo_words;
+    modulo_words.resize(num_words);
+    export_native_words(modulo, modulo_words);
+
+    Vector<NativeWord, STARTING_WORD_SIZE> rr_words;
+    rr_words.resize(num_words);
+    export_native_words(rr, rr_words);
+
+    Vector<NativeWord, STARTING_WORD_SIZE> z_words;
+    z_words.resize(num_words);
+    export_native_words(x, z_words);
+
+    Vector<NativeWord, STARTING_WORD_SIZE> temp;
+    temp.resize(num_words + 2);
+
+    NativeWord k = -inverse_wrapped(modulo_words[0]);
+
+    // Larger windows need fewer multiplications per exponent bit, but cost more precomputed powers up front.
+    size_t window_size = 1;
+    if (exponent_bits > 671)
+        window_size = 6;
+    else if (exponent_bits > 239)
+        window_size = 5;
+    else if (exponent_bits > 79)
+        window_size = 4;
+    else if (exponent_bits > 23)
+        window_size = 3;
+
+    // Compute the odd montgomery powers. powers[i] = x^(2i + 1)
+    size_t power_count = 1 << (window_size - 1);
+    Vector<NativeWord> powers;
+    powers.resize(power_count * num_words);
+    auto power = [&](size_t index) { return powers.span().slice(index * num_words, num_words); };
+
+    montgomery_multiply_native_words(z_words, rr_words, modulo_words, k, temp, power(0));
+    if (power_count > 1) {
+        // z = x^2, used as the step between consecutive odd powers
+        montgomery_multiply_native_words(power(0), power(0), modulo_words, k, temp, z_words);
+        for (size_t i = 1; i < power_count; ++i)
+            montgomery_multiply_native_words(power(i - 1), z_words, modulo_words, k, temp, power(i));
+    }
+
+    auto exponent_bit = [&](size_t bit) {
+        return (exponent.m_words[bit / UnsignedBigInteger::BITS_IN_WORD] >> (bit % UnsignedBigInteger::BITS_IN_WORD)) & 1;
+    };
+
+    // The highest bit is always set, so the first window simply loads its power into z instead of squaring a one.
+    bool is_first_window = true;
+    ssize_t bit = exponent_bits - 1;
+    while (bit >= 0) {
+        if (!exponent_bit(bit)) {
+            montgomery_multiply_native_words(z_words, z_words, modulo_words, k, temp, z_words);
+            --bit;
+            continue;
+        }
 
-            swap(z, zz);
+        // Find the longest window ending in a one bit, starting at the current bit.
+        ssize_t window_end = max(bit - static_cast<ssize_t>(window_size) + 1, static_cast<ssize_t>(0));
+        while (!exponent_bit(window_end))
+            ++window_end;
 
-            // Move to the next window
-            exponent_word <<= window_size;
-            bit_in_word += window_size;
+        size_t window_value = 0;
+        for (ssize_t i = bit; i >= window_end; --i) {
+            window_value = (window_value << 1) | exponent_bit(i);
+            if (!is_first_window)
+                montgomery_multiply_native_words(z_words, z_words, modulo_words, k, temp, z_words);
         }
-    }
 
-    almost_montgomery_multiplication_without_allocation(z, one, modulo, temp_z, k, num_words, zz);
+        if (is_first_window) {
+            power(window_value >> 1).copy_to(z_words);
+            is_first_window = false;
+        } else {
+            montgomery_multiply_native_words(z_words, power(window_value >> 1), modulo_words, k, temp, z_words);
+        }
 
-    if (zz < modulo) {
-        result.set_to(zz);
-        result.clamp_to_trimmed_length();
-        return;
+        bit = window_end - 1;
     }
 
-    // Note : Since we were using "almost montgomery" multiplications, we aren't guaranteed to be under the modulo already.
-    // So, if we're here, we need to respect the modulo.
-    // We can, however, start by trying to subtract the modulo, just in case we're close.
-    subtract_without_allocation(zz, modulo, result);
-
-    if (modulo < zz) {
-        // Note: This branch shouldn't happen in theory (as noted in https://github.com/rust-num/num-bigint/blob/master/src/biguint/monty.rs#L210)
-        // Let's dbgln the values we used. That way, if we hit this branch, we can contribute these values for test cases.
-        dbgln("Encountered the modulo branch during a montgomery modular power. Params : {} - {} - {}", base, exponent, modulo);
-        // We just clobber all the other temporaries that we don't need for the division.
-        // This is wasteful, but we're on the edgiest of cases already.
-        divide_without_allocation(zz, modulo, temp_z, rr, z, x, temp_extra, result);
-    }
+    // Leave montgomery form by multiplying with a plain one.
+    Vector<NativeWord, STARTING_WORD_SIZE> one_words;
+    one_words.resize(num_words);
+    one_words[0] = 1;
+    montgomery_multiply_native_words(z_words, one_words, modulo_words, k, temp, z_words);
 
-    result.clamp_to_trimmed_length();
-    return;
+    import_native_words(z_words, result);
 }
 
 }
@@ -9,38 +9,225 @@
 
 namespace Crypto {
 
+using AK::NativeWord;
+using AK::word_size;
+using AK::Detail::DoubleWord;
+
+// Below this many native words, the schoolbook method is faster than the bookkeeping Karatsuba needs.
+static constexpr size_t karatsuba_threshold = 24;
+
+static ReadonlySpan<NativeWord> trimmed(ReadonlySpan<NativeWord> words)
+{
+    size_t length = words.size();
+    while (length > 0 && words[length - 1] == 0)
+        --length;
+    return words.trim(length);
+}
+
+/**
+ * Adds value into accumulator, rippling the carry through the rest of the accumulator.
+ * The accumulator must be large enough to hold the sum.
+ */
+static void add_into_native_words(Span<NativeWord> accumulator, ReadonlySpan<NativeWord> value)
+{
+    VERIFY(accumulator.size() >= value.size());
+
+    bool carry = false;
+    size_t i = 0;
+    for (; i < value.size(); ++i)
+        accumulator[i] = AK::Detail::add_words(accumulator[i], value[i], carry);
+    for (; carry && i < accumulator.size(); ++i)
+        accumulator[i] = AK::Detail::add_words(accumulator[i], 0, carry);
+
+    VERIFY(!carry);
+}
+
+/**
+ * Subtracts value from accumulator, rippling the borrow through the rest of the accumulator.
+ * The accumulator must not be smaller than the value.
+ */
+static void subtract_from_native_words(Span<NativeWord> accumulator, ReadonlySpan<NativeWord> value)
+{
+    value = trimmed(value);
+    VERIFY(accumulator.size() >= value.size());
+
+    bool borrow = false;
+    size_t i = 0;
+    for (; i < value.size(); ++i)
+        accumulator[i] = AK::Detail::sub_words(accumulator[i], value[i], borrow);
+    for (; borrow && i < accumulator.size(); ++i)
+        accumulator[i] = AK::Detail::sub_words(accumulator[i], 0, borrow);
+
+    VERIFY(!borrow);
+}
+
 /**
- * Complexity: O(N^2) where N is the number of words in the larger number
+ * Complexity: O(N*M) where N and M are the number of words in the operands
+ * Output must be exactly left.size() + right.size() words long.
+ */
+static void schoolbook_multiply_native_words(ReadonlySpan<NativeWord> left, ReadonlySpan<NativeWord> right, Span<NativeWord> output)
+{
+    VERIFY(output.size() == left.size() + right.size());
+    output.fill(0);
+
+    for (size_t i = 0; i < left.size(); ++i) {
+        NativeWord carry = 0;
+        for (size_t j = 0; j < right.size(); ++j) {
+            // Note: (2^w - 1)^2 + 2 * (2^w - 1) == 2^2w - 1, so this can never overflow a DoubleWord.
+            DoubleWord product = static_cast<DoubleWord>(left[i]) * right[j] + output[i + j] + carry;
+            output[i + j] = static_cast<NativeWord>(product);
+            carry = static_cast<NativeWord>(product >> word_size);
+        }
+        output[i + right.size()] = carry;
+    }
+}
+
+/**
+ * Number of scratch words karatsuba_multiply_native_words() needs for operands of at most `length` words:
+ * each level keeps the two operand sums and z1 in the scratch space, and hands what's left to the z1 multiplication.
+ * The other recursive multiplications finish before that space is used, so they can share it.
+ */
+size_t UnsignedBigIntegerAlgorithms::karatsuba_scratch_length(size_t length)
+{
+    size_t scratch_length = 0;
+    while (length >= karatsuba_threshold) {
+        size_t half = (length + 1) / 2;
+        scratch_length += 4 * half + 4;
+        length = half + 1;
+    }
+    return scratch_length;
+}
+
+/**
+ * Complexity: O(N^log2(3)) where N is the number of words in the larger number
  * Multiplication method:
- * An integer is equal to the sum of the powers of two
- * according to the indices of its 'on' bits.
- * So to multiple x*y, we go over each '1' bit in x (say the i'th bit),
- * and add y<<i to the result.
+ * Split both operands in half: x = x1 * B + x0, y = y1 * B + y0. Then
+ * x * y = z2 * B^2 + z1 * B + z0, with z2 = x1 * y1, z0 = x0 * y0 and
+ * z1 = (x0 + x1) * (y0 + y1) - z2 - z0, which takes three half-sized multiplications instead of four.
+ * Output must be exactly left.size() + right.size() words long, and scratch at least
+ * karatsuba_scratch_length() of the larger operand's size.
+ */
+void UnsignedBigIntegerAlgorithms::karatsuba_multiply_native_words(ReadonlySpan<NativeWord> left, ReadonlySpan<NativeWord> right, Span<NativeWord> output, Span<NativeWord> scratch)
+{
+    VERIFY(output.size() == left.size() + right.size());
+
+    if (left.size() < right.size())
+        return karatsuba_multiply_native_words(right, left, output, scratch);
+
+    if (right.size() < karatsuba_threshold) {
+        schoolbook_multiply_native_words(left, right, output);
+        return;
+    }
+
+    size_t half = (left.size() + 1) / 2;
+
+    if (right.size() <= half) {
+        // The operands are too unbalanced to split at the same point,
+        // so multiply right by right-sized slices of left and accumulate the partial products.
+        output.fill(0);
+        auto partial_product_storage = scratch.trim(2 * right.size());
+        auto partial_product_scratch = scratch.slice(2 * right.size());
+        for (size_t offset = 0; offset < left.size(); offset += right.size()) {
+            auto slice = left.slice(offset, min(right.size(), left.size() - offset));
+            auto partial_product = partial_product_storage.trim(slice.size() + right.size());
+            karatsuba_multiply_native_words(slice, right, partial_product, partial_product_scratch);
+            add_into_native_words(output.slice(offset), trimmed(partial_product));
+        }
+        return;
+    }
+
+    auto left_low = left.trim(half);
+    auto left_high = left.slice(half);
+    auto right_low = right.trim(half);
+    auto right_high = right.slice(half);
+
+    // z0 and z2 go straight into their final place in the output, as they can't overlap.
+    auto z0 = output.trim(2 * half);
+    auto z2 = output.slice(2 * half);
+    karatsuba_multiply_native_words(left_low, right_low, z0, scratch);
+    karatsuba_multiply_native_words(left_high, right_high, z2, scratch);
+
+    auto left_sum = scratch.slice(0, half + 1);
+    left_sum.fill(0);
+    left_low.copy_to(left_sum);
+    add_into_native_words(left_sum, left_high);
+
+    auto right_sum = scratch.slice(half + 1, half + 1);
+    right_sum.fill(0);
+    right_low.copy_to(right_sum);
+    add_into_native_words(right_sum, right_high);
+
+    auto z1 = scratch.slice(2 * half + 2, 2 * half + 2);
+    karatsuba_multiply_native_words(left_sum, right_sum, z1, scratch.slice(4 * half + 4));
+    subtract_from_native_words(z1, z0);
+    subtract_from_native_words(z1, z2);
+
+    add_into_native_words(output.slice(half), trimmed(z1));
+}
+
+void UnsignedBigIntegerAlgorithms::export_native_words(UnsignedBigInteger const& number, Span<NativeWord> output)
+{
+    for (size_t i = 0; i < output.size(); ++i) {
+        NativeWord native_word = 0;
+        for (size_t j = 0; j < words_per_native_word; ++j) {
+            auto word_index = i * words_per_native_word + j;
+            if (word_index < number.length())
+                native_word |= static_cast<NativeWord>(number.m_words[word_index]) << (j * UnsignedBigInteger::BITS_IN_WORD);
+        }
+        output[i] = native_word;
+    }
+}
+
+void UnsignedBigIntegerAlgorithms::import_native_words(ReadonlySpan<NativeWord> words, UnsignedBigInteger& output)
+{
+    output.set_to_0();
+    output.m_words.resize_and_keep_capacity(words.size() * words_per_native_word);
+    for (size_t i = 0; i < words.size(); ++i) {
+        for (size_t j = 0; j < words_per_native_word; ++j)
+            output.m_words[i * words_per_native_word + j] = static_cast<UnsignedBigInteger::Word>(words[i] >> (j * UnsignedBigInteger::BITS_IN_WORD));
+    }
+    output.clamp_to_trimmed_length();
+}
+
+/**
+ * Complexity: O(N^2) where N is the number of words in the larger number, O(N^log2(3)) once both exceed the Karatsuba threshold.
+ * Multiplication method:
+ * The operands are repacked into native words (64 bits on 64-bit targets) so that every
+ * step of the inner loop produces a full double-word partial product.
+ * The repacked operands, the product and the Karatsuba scratch space all live in temp_words,
+ * which only needs to grow when it's reused for larger operands than before.
  */
 FLATTEN void UnsignedBigIntegerAlgorithms::multiply_without_allocation(
     UnsignedBigInteger const& left,
     UnsignedBigInteger const& right,
-    UnsignedBigInteger& temp_shift_result,
-    UnsignedBigInteger& temp_shift_plus,
-    UnsignedBigInteger& temp_shift,
+    MultiplicationScratch& temp_words,
     UnsignedBigInteger& output)
 {
-    output.set_to_0();
+    auto left_length = left.trimmed_length();
+    auto right_length = right.trimmed_length();
+    if (left_length == 0 || right_length == 0) {
+        output.set_to_0();
+        return;
+    }
 
-    // iterate all bits
-    for (size_t word_index = 0; word_index < left.length(); ++word_index) {
-        for (size_t bit_index = 0; bit_index < UnsignedBigInteger::BITS_IN_WORD; ++bit_index) {
-            // If the bit is off - skip over it
-            if (!(left.m_words[word_index] & (1 << bit_index)))
-                continue;
+    auto left_native_length = native_length(left_length);
+    auto right_native_length = native_length(right_length);
+    auto product_length = left_native_length + right_native_length;
+    auto scratch_length = karatsuba_scratch_length(max(left_native_length, right_native_length));
+    if (temp_words.size() < 2 * product_length + scratch_length)
+        temp_words.resize(2 * product_length + scratch_length);
 
-            size_t shift_amount = word_index * UnsignedBigInteger::BITS_IN_WORD + bit_index;
+    auto words = temp_words.span();
+    auto left_words = words.slice(0, left_native_length);
+    auto right_words = words.slice(left_native_length, right_native_length);
+    auto product = words.slice(product_length, product_length);
+    auto scratch = words.slice(2 * product_length);
 
-            // output += (right << shift_amount);
-            shift_left_without_allocation(right, shift_amount, temp_shift_result, temp_shift_plus, temp_shift);
-            add_into_accumulator_without_allocation(output, temp_shift);
-        }
-    }
+    export_native_words(left, left_words);
+    export_native_words(right, right_words);
+    karatsuba_multiply_native_words(left_words, right_words, product, scratch);
+
+    import_native_words(product, output);
 }
 
 }
@@ -6,6 +6,8 @@
 
 #include <AK/ByteReader.h>
 #include <AK/Endian.h>
+#include <AK/SIMD.h>
+#include <AK/SIMDExtras.h>
 #include <LibCrypto/Cipher/ChaCha20.h>
 
 namespace Crypto::Cipher {
@@ -53,27 +55,61 @@ ChaCha20::ChaCha20(ReadonlyBytes key, ReadonlyBytes nonce, u32 initial_counter)
     }
 }
 
-// https://datatracker.ietf.org/doc/html/rfc7539#section-2.3
-void ChaCha20::generate_block()
+template<typename T>
+ALWAYS_INLINE static T rotl(T x, u32 n)
 {
-    // Copy the current state into the block
-    memcpy(m_block, m_state, 16 * sizeof(u32));
+    return (x << n) | (x >> (32 - n));
+}
+
+// https://datatracker.ietf.org/doc/html/rfc8439#section-2.1
+// NOTE: This is used both on single words and on SIMD vectors holding the same word of several blocks.
+template<typename T>
+ALWAYS_INLINE static void quarter_round(T& a, T& b, T& c, T& d)
+{
+    a += b;
+    d ^= a;
+    d = rotl(d, 16);
+
+    c += d;
+    b ^= c;
+    b = rotl(b, 12);
 
-    // ChaCha20 runs 20 rounds, alternating between "column rounds" and "diagonal rounds".
-    // Each round consists of four quarter-rounds
+    a += b;
+    d ^= a;
+    d = rotl(d, 8);
+
+    c += d;
+    b ^= c;
+    b = rotl(b, 7);
+}
+
+// ChaCha20 runs 20 rounds, alternating between "column rounds" and "diagonal rounds".
+// Each round consists of four quarter-rounds
+template<typename T>
+ALWAYS_INLINE static void run_rounds(T (&x)[16])
+{
     for (u32 i = 0; i < 20; i += 2) {
         // Column rounds
-        do_quarter_round(m_block[0], m_block[4], m_block[8], m_block[12]);
-        do_quarter_round(m_block[1], m_block[5], m_block[9], m_block[13]);
-        do_quarter_round(m_block[2], m_block[6], m_block[10], m_block[14]);
-        do_quarter_round(m_block[3], m_block[7], m_block[11], m_block[15]);
+        quarter_round(x[0], x[4], x[8], x[12]);
+        quarter_round(x[1], x[5], x[9], x[13]);
+        quarter_round(x[2], x[6], x[10], x[14]);
+        quarter_round(x[3], x[7], x[11], x[15]);
 
         // Diagonal rounds
-        do_quarter_round(m_block[0], m_block[5], m_block[10], m_block[15]);
-        do_quarter_round(m_block[1], m_block[6], m_block[11], m_block[12]);
-        do_quarter_round(m_block[2], m_block[7], m_block[8], m_block[13]);
-        do_quarter_round(m_block[3], m_block[4], m_block[9], m_block[14]);
+        quarter_round(x[0], x[5], x[10], x[15]);
+        quarter_round(x[1], x[6], x[11], x[12]);
+        quarter_round(x[2], x[7], x[8], x[13]);
+        quarter_round(x[3], x[4], x[9], x[14]);
     }
+}
+
+// https://datatracker.ietf.org/doc/html/rfc7539#section-2.3
+void ChaCha20::generate_block()
+{
+    // Copy the current state into the block
+    memcpy(m_block, m_state, 16 * sizeof(u32));
+
+    run_rounds(m_block);
 
     // At the end of 20 rounds, we add the original input words to the output words,
     for (u32 i = 0; i < 16; i++) {
@@ -86,45 +122,73 @@ void ChaCha20::generate_block()
     }
 }
 
-ALWAYS_INLINE static void rotl(u32& x, u32 n)
+// Generates the serialized keystream for the next PARALLEL_BLOCK_COUNT blocks, without touching the block counter.
+// Each vector holds the same state word for all blocks, so every lane runs its own block through the exact same rounds.
+void ChaCha20::generate_parallel_blocks(Bytes output)
 {
-    x = (x << n) | (x >> (32 - n));
-}
+    using AK::SIMD::u32x4;
+    static_assert(PARALLEL_BLOCK_COUNT == 4);
+    VERIFY(output.size() == PARALLEL_BLOCK_COUNT * BLOCK_SIZE);
 
-// https://datatracker.ietf.org/doc/html/rfc8439#section-2.1
-void ChaCha20::do_quarter_round(u32& a, u32& b, u32& c, u32& d)
-{
-    a += b;
-    d ^= a;
-    rotl(d, 16);
+    u32x4 state[16];
+    for (size_t i = 0; i < 16; ++i)
+        state[i] = AK::SIMD::expand4(m_state[i]);
 
-    c += d;
-    b ^= c;
-    rotl(b, 12);
+    // Every lane gets the next block counter, carrying over to word 13 like increment_counter() does.
+    u32x4 counter = state[12] + u32x4 { 0, 1, 2, 3 };
+    state[13] -= bit_cast<u32x4>(counter < state[12]);
+    state[12] = counter;
 
-    a += b;
-    d ^= a;
-    rotl(d, 8);
+    u32x4 x[16];
+    for (size_t i = 0; i < 16; ++i)
+        x[i] = state[i];
 
-    c += d;
-    b ^= c;
-    rotl(b, 7);
+    run_rounds(x);
+
+    for (size_t i = 0; i < 16; ++i) {
+        x[i] += state[i];
+        for (size_t block = 0; block < PARALLEL_BLOCK_COUNT; ++block)
+            ByteReader::store(output.offset_pointer(block * BLOCK_SIZE + i * sizeof(u32)), AK::convert_between_host_and_little_endian(x[i][block]));
+    }
+}
+
+void ChaCha20::increment_counter(u32 blocks)
+{
+    // Increment the block counter, and carry over to block 13
+    m_state[12] += blocks;
+    if (m_state[12] < blocks) {
+        m_state[13]++;
+    }
 }
 
 void ChaCha20::run_cipher(ReadonlyBytes input, Bytes& output)
 {
     size_t offset = 0;
     size_t block_offset = 0;
+
+    // Bulk data: produce the keystream for several blocks at once, and XOR it in vector-sized chunks.
+    u8 keystream[PARALLEL_BLOCK_COUNT * BLOCK_SIZE];
+    while (input.size() - offset >= sizeof(keystream)) {
+        generate_parallel_blocks({ keystream, sizeof(keystream) });
+        increment_counter(PARALLEL_BLOCK_COUNT);
+
+        for (size_t i = 0; i < sizeof(keystream); i += sizeof(AK::SIMD::u32x4)) {
+            AK::SIMD::u32x4 data;
+            AK::SIMD::u32x4 key;
+            __builtin_memcpy(&data, input.offset_pointer(offset + i), sizeof(data));
+            __builtin_memcpy(&key, keystream + i, sizeof(key));
+            data ^= key;
+            __builtin_memcpy(output.offset_pointer(offset + i), &data, sizeof(data));
+        }
+
+        offset += sizeof(keystream);
+    }
+
     while (offset < input.size()) {
         if (block_offset == 0 || block_offset >= 64) {
             // Generate a new XOR block
             generate_block();
-
-            // Increment the block counter, and carry over to block 13
-            m_state[12]++;
-            if (m_state[12] == 0) {
-                m_state[13]++;
-            }
+            increment_counter(1);
 
             block_offset = 0;
         }
@@ -15,6 +15,10 @@ class ChaCha20 {
     static constexpr u32 CONSTANT_32_BYTES[] { 0x61707865, 0x3320646E, 0x79622D32, 0x6B206574 };
 
 public:
+    static constexpr size_t BLOCK_SIZE = 64;
+    // The keystream for this many consecutive blocks is generated at once, one block per SIMD lane.
+    static constexpr size_t PARALLEL_BLOCK_COUNT = 4;
+
     ChaCha20(ReadonlyBytes key, ReadonlyBytes nonce, u32 initial_counter = 0);
 
     void encrypt(ReadonlyBytes input, Bytes& output);
@@ -24,7 +28,8 @@ public:
 
 private:
     void run_cipher(ReadonlyBytes input, Bytes& output);
-    ALWAYS_INLINE void do_quarter_round(u32& a, u32& b, u32& c, u32& d);
+    void generate_parallel_blocks(Bytes output);
+    void increment_counter(u32 blocks);
 
     u32 m_state[16] {};
     u32 m_block[16] {};
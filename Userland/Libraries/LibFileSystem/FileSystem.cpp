@@ -192,6 +192,39 @@ static ErrorOr<String> get_duplicate_file_name(StringView path)
     return current_name;
 }
 
+static ErrorOr<void> copy_file_contents(Core::File& destination, Core::File& source)
+{
+#if defined(AK_OS_SERENITY) || defined(AK_OS_LINUX)
+    // Let the kernel move the data, so it doesn't have to pass through our buffers on its way.
+    // We ask for a bounded amount at a time so that a large copy can still be interrupted.
+    static constexpr size_t sendfile_chunk_size = 1 * MiB;
+    bool has_copied_anything = false;
+    while (true) {
+        auto nsent_or_error = Core::System::sendfile(destination.fd(), source.fd(), nullptr, sendfile_chunk_size);
+        if (nsent_or_error.is_error()) {
+            // Not every kind of file can be sent everywhere, but we can still copy those ourselves.
+            auto code = nsent_or_error.error().code();
+            if (has_copied_anything || (code != EINVAL && code != ENOSYS))
+                return nsent_or_error.release_error();
+            break;
+        }
+        if (nsent_or_error.value() == 0)
+            return {};
+        has_copied_anything = true;
+    }
+#endif
+
+    while (true) {
+        auto bytes_read = TRY(source.read_until_eof());
+
+        if (bytes_read.is_empty())
+            break;
+
+        TRY(destination.write_until_depleted(bytes_read));
+    }
+    return {};
+}
+
 ErrorOr<void> copy_file(StringView destination_path, StringView source_path, struct stat const& source_stat, Core::File& source, PreserveMode preserve_mode)
 {
     auto destination_or_error = Core::File::open(destination_path, Core::File::OpenMode::Write, 0666);
@@ -207,14 +240,7 @@ ErrorOr<void> copy_file(StringView destination_path, StringView source_path, str
     if (source_stat.st_size > 0)
         TRY(destination->truncate(source_stat.st_size));
 
-    while (true) {
-        auto bytes_read = TRY(source.read_until_eof());
-
-        if (bytes_read.is_empty())
-            break;
-
-        TRY(destination->write_until_depleted(bytes_read));
-    }
+    TRY(copy_file_contents(*destination, source));
 
     auto my_umask = umask(0);
     umask(my_umask);
@@ -284,7 +284,10 @@ void PrimitiveString::resolve_rope_if_needed(EncodingPreference preference) cons
     }
 
     // Now that we have all the pieces, we can concatenate them using a StringBuilder.
-    StringBuilder builder;
+    size_t length = 0;
+    for (auto const* current : pieces)
+        length += current->utf8_string_view().length();
+    StringBuilder builder(length);
 
     // We keep track of the previous piece in order to handle surrogate pairs spread across two pieces.
     PrimitiveString const* previous = nullptr;
@@ -344,7 +347,9 @@ void PrimitiveString::resolve_rope_if_needed(EncodingPreference preference) cons
         previous = current;
     }
 
-    m_utf8_string = MUST(builder.to_string());
+    // Every piece is valid UTF-8 on its own, and joining surrogates across pieces keeps it that way,
+    // so there's no need to validate the whole string again.
+    m_utf8_string = MUST(String::from_utf8_without_validation(builder.string_view().bytes()));
     m_is_rope = false;
     m_lhs = nullptr;
     m_rhs = nullptr;
@@ -134,17 +134,15 @@ Optional<Symbol> symbolicate(DeprecatedString const& path, FlatPtr address, Incl
     };
 }
 
-Vector<Symbol> symbolicate_thread(pid_t pid, pid_t tid, IncludeSourcePosition include_source_positions)
-{
-    struct RegionWithSymbols {
-        FlatPtr base { 0 };
-        size_t size { 0 };
-        DeprecatedString path;
-    };
+struct RegionWithSymbols {
+    FlatPtr base { 0 };
+    size_t size { 0 };
+    DeprecatedString path;
+};
 
-    Vector<FlatPtr> stack;
+static Vector<RegionWithSymbols> kernel_regions_with_symbols()
+{
     Vector<RegionWithSymbols> regions;
-
     if (auto maybe_kernel_base = kernel_base(); maybe_kernel_base.has_value()) {
         regions.append(RegionWithSymbols {
             .base = maybe_kernel_base.value(),
@@ -152,77 +150,64 @@ Vector<Symbol> symbolicate_thread(pid_t pid, pid_t tid, IncludeSourcePosition in
             .path = "/boot/Kernel.debug",
         });
     }
+    return regions;
+}
 
-    {
-        auto stack_path = DeprecatedString::formatted("/proc/{}/stacks/{}", pid, tid);
-        auto file_or_error = Core::File::open(stack_path, Core::File::OpenMode::Read);
-        if (file_or_error.is_error()) {
-            warnln("Could not open {}: {}", stack_path, file_or_error.error());
-            return {};
-        }
-
-        auto file_content = file_or_error.value()->read_until_eof();
-        if (file_content.is_error()) {
-            warnln("Could not read {}: {}", stack_path, file_or_error.error());
-            return {};
-        }
+static Optional<Vector<RegionWithSymbols>> regions_with_symbols(pid_t pid)
+{
+    auto regions = kernel_regions_with_symbols();
 
-        auto json = JsonValue::from_string(file_content.value());
-        if (json.is_error() || !json.value().is_array()) {
-            warnln("Invalid contents in {}", stack_path);
-            return {};
-        }
+    auto vm_path = DeprecatedString::formatted("/proc/{}/vm", pid);
+    auto file_or_error = Core::File::open(vm_path, Core::File::OpenMode::Read);
+    if (file_or_error.is_error()) {
+        warnln("Could not open {}: {}", vm_path, file_or_error.error());
+        return {};
+    }
 
-        stack.ensure_capacity(json.value().as_array().size());
-        for (auto& value : json.value().as_array().values()) {
-            stack.append(value.to_addr());
-        }
+    auto file_content = file_or_error.value()->read_until_eof();
+    if (file_content.is_error()) {
+        warnln("Could not read {}: {}", vm_path, file_or_error.error());
+        return {};
     }
 
-    {
-        auto vm_path = DeprecatedString::formatted("/proc/{}/vm", pid);
-        auto file_or_error = Core::File::open(vm_path, Core::File::OpenMode::Read);
-        if (file_or_error.is_error()) {
-            warnln("Could not open {}: {}", vm_path, file_or_error.error());
-            return {};
-        }
+    auto json = JsonValue::from_string(file_content.value());
+    if (json.is_error() || !json.value().is_array()) {
+        warnln("Invalid contents in {}", vm_path);
+        return {};
+    }
 
-        auto file_content = file_or_error.value()->read_until_eof();
-        if (file_content.is_error()) {
-            warnln("Could not read {}: {}", vm_path, file_or_error.error());
-            return {};
-        }
+    for (auto& region_value : json.value().as_array().values()) {
+        auto& region = region_value.as_object();
+        auto name = region.get_deprecated_string("name"sv).value_or({});
+        auto address = region.get_addr("address"sv).value_or(0);
+        auto size = region.get_addr("size"sv).value_or(0);
 
-        auto json = JsonValue::from_string(file_content.value());
-        if (json.is_error() || !json.value().is_array()) {
-            warnln("Invalid contents in {}", vm_path);
-            return {};
+        DeprecatedString path;
+        if (name == "/usr/lib/Loader.so") {
+            path = name;
+        } else if (name.ends_with(": .text"sv) || name.ends_with(": .rodata"sv)) {
+            auto parts = name.split_view(':');
+            path = parts[0];
+        } else {
+            continue;
         }
 
-        for (auto& region_value : json.value().as_array().values()) {
-            auto& region = region_value.as_object();
-            auto name = region.get_deprecated_string("name"sv).value_or({});
-            auto address = region.get_addr("address"sv).value_or(0);
-            auto size = region.get_addr("size"sv).value_or(0);
-
-            DeprecatedString path;
-            if (name == "/usr/lib/Loader.so") {
-                path = name;
-            } else if (name.ends_with(": .text"sv) || name.ends_with(": .rodata"sv)) {
-                auto parts = name.split_view(':');
-                path = parts[0];
-            } else {
-                continue;
-            }
-
-            RegionWithSymbols r;
-            r.base = address;
-            r.size = size;
-            r.path = path;
-            regions.append(move(r));
-        }
+        RegionWithSymbols r;
+        r.base = address;
+        r.size = size;
+        r.path = path;
+        regions.append(move(r));
     }
+    return regions;
+}
+
+enum class SkipUnknownAddresses {
+    Yes,
+    No,
+};
 
+static Vector<Symbol> symbolicate_stack(Vector<RegionWithSymbols> const& regions, ReadonlySpan<FlatPtr> stack, IncludeSourcePosition include_source_positions, SkipUnknownAddresses skip_unknown_addresses)
+{
     Vector<Symbol> symbols;
     bool first_frame = true;
 
@@ -241,7 +226,15 @@ Vector<Symbol> symbolicate_thread(pid_t pid, pid_t tid, IncludeSourcePosition in
         }
 
         if (!found_region) {
-            outln("{:p}  ??", address);
+            if (skip_unknown_addresses == SkipUnknownAddresses::Yes) {
+                outln("{:p}  ??", address);
+            } else {
+                symbols.append(Symbol {
+                    .address = address,
+                    .source_positions = {},
+                });
+                first_frame = false;
+            }
             continue;
         }
 
@@ -279,4 +272,54 @@ Vector<Symbol> symbolicate_thread(pid_t pid, pid_t tid, IncludeSourcePosition in
     return symbols;
 }
 
+Vector<Symbol> symbolicate_thread(pid_t pid, pid_t tid, IncludeSourcePosition include_source_positions)
+{
+    Vector<FlatPtr> stack;
+
+    {
+        auto stack_path = DeprecatedString::formatted("/proc/{}/stacks/{}", pid, tid);
+        auto file_or_error = Core::File::open(stack_path, Core::File::OpenMode::Read);
+        if (file_or_error.is_error()) {
+            warnln("Could not open {}: {}", stack_path, file_or_error.error());
+            return {};
+        }
+
+        auto file_content = file_or_error.value()->read_until_eof();
+        if (file_content.is_error()) {
+            warnln("Could not read {}: {}", stack_path, file_or_error.error());
+            return {};
+        }
+
+        auto json = JsonValue::from_string(file_content.value());
+        if (json.is_error() || !json.value().is_array()) {
+            warnln("Invalid contents in {}", stack_path);
+            return {};
+        }
+
+        stack.ensure_capacity(json.value().as_array().size());
+        for (auto& value : json.value().as_array().values()) {
+            stack.append(value.to_addr());
+        }
+    }
+
+    auto regions = regions_with_symbols(pid);
+    if (!regions.has_value())
+        return {};
+    return symbolicate_stack(*regions, stack, include_source_positions, SkipUnknownAddresses::Yes);
+}
+
+Vector<Vector<Symbol>> symbolicate_stacks(pid_t pid, ReadonlySpan<Vector<FlatPtr>> stacks, IncludeSourcePosition include_source_positions)
+{
+    // Even if the process is gone, the kernel's part of the stacks can still be symbolicated.
+    auto regions = regions_with_symbols(pid);
+    if (!regions.has_value())
+        regions = kernel_regions_with_symbols();
+
+    Vector<Vector<Symbol>> symbolicated_stacks;
+    symbolicated_stacks.ensure_capacity(stacks.size());
+    for (auto const& stack : stacks)
+        symbolicated_stacks.unchecked_append(symbolicate_stack(*regions, stack, include_source_positions, SkipUnknownAddresses::No));
+    return symbolicated_stacks;
+}
+
 }
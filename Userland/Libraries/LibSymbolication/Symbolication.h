@@ -27,6 +27,9 @@ enum class IncludeSourcePosition {
 
 Optional<FlatPtr> kernel_base();
 Vector<Symbol> symbolicate_thread(pid_t pid, pid_t tid, IncludeSourcePosition = IncludeSourcePosition::Yes);
+// Symbolicates stacks that were sampled from a process, which has to still be around for its own code to be found.
+// There is a symbol for every address, which only has its address set if nothing is known about it.
+Vector<Vector<Symbol>> symbolicate_stacks(pid_t pid, ReadonlySpan<Vector<FlatPtr>> stacks, IncludeSourcePosition = IncludeSourcePosition::Yes);
 Optional<Symbol> symbolicate(DeprecatedString const& path, FlatPtr address, IncludeSourcePosition = IncludeSourcePosition::Yes);
 
 }
@@ -14,6 +14,31 @@
 
 namespace TLS {
 
+// RFC 7905: The per-record nonce is the 64-bit sequence number, left-padded to 12 bytes and XORed with the fixed IV.
+static void chacha20_poly1305_nonce(u8 const* fixed_iv, u64 sequence_number, Bytes nonce)
+{
+    VERIFY(nonce.size() == 12);
+    memset(nonce.data(), 0, 4);
+    ByteReader::store(nonce.offset(4), AK::convert_between_host_and_network_endian(sequence_number));
+    for (size_t i = 0; i < 12; ++i)
+        nonce[i] ^= fixed_iv[i];
+}
+
+// AEAD AAD (13)
+// Seq. no (8)
+// content type (1)
+// version (2)
+// length (2)
+static void build_aead_aad(u64 sequence_number, ReadonlyBytes type_and_version, u16 length, Bytes aad)
+{
+    FixedMemoryStream aad_stream { aad };
+
+    MUST(aad_stream.write_value(AK::convert_between_host_and_network_endian(sequence_number)));
+    MUST(aad_stream.write_until_depleted(type_and_version));
+    MUST(aad_stream.write_value(AK::convert_between_host_and_network_endian(length)));
+    VERIFY(MUST(aad_stream.tell()) == MUST(aad_stream.size()));
+}
+
 ByteBuffer TLSv12::build_alert(bool critical, u8 code)
 {
     PacketBuilder builder(ContentType::ALERT, (u16)m_context.options.version);
@@ -90,6 +115,11 @@ void TLSv12::update_packet(ByteBuffer& packet)
                     padding = 0;
                     mac_size = 0; // AEAD provides its own authentication scheme.
                 },
+                [&](Crypto::AEAD::ChaCha20Poly1305&) {
+                    VERIFY(is_aead());
+                    padding = 0;
+                    mac_size = 0; // AEAD provides its own authentication scheme.
+                },
                 [&](Crypto::Cipher::AESCipher::CBCMode& cbc) {
                     VERIFY(!is_aead());
                     block_size = cbc.cipher().block_size();
@@ -134,22 +164,9 @@ void TLSv12::update_packet(ByteBuffer& packet)
                         // copy the header over
                         ct.overwrite(0, packet.data(), header_size - 2);
 
-                        // AEAD AAD (13)
-                        // Seq. no (8)
-                        // content type (1)
-                        // version (2)
-                        // length (2)
                         u8 aad[13];
                         Bytes aad_bytes { aad, 13 };
-                        FixedMemoryStream aad_stream { aad_bytes };
-
-                        u64 seq_no = AK::convert_between_host_and_network_endian(m_context.local_sequence_number);
-                        u16 len = AK::convert_between_host_and_network_endian((u16)(packet.size() - header_size));
-
-                        MUST(aad_stream.write_value(seq_no));                              // sequence number
-                        MUST(aad_stream.write_until_depleted(packet.bytes().slice(0, 3))); // content-type + version
-                        MUST(aad_stream.write_value(len));                                 // length
-                        VERIFY(MUST(aad_stream.tell()) == MUST(aad_stream.size()));
+                        build_aead_aad(m_context.local_sequence_number, packet.bytes().slice(0, 3), static_cast<u16>(packet.size() - header_size), aad_bytes);
 
                         // AEAD IV (12)
                         // IV (4)
@@ -175,6 +192,36 @@ void TLSv12::update_packet(ByteBuffer& packet)
 
                         VERIFY(header_size + 8 + length + 16 == ct.size());
                     },
+                    [&](Crypto::AEAD::ChaCha20Poly1305& chacha) {
+                        VERIFY(is_aead());
+                        // We need enough space for a header, the data and a tag, the nonce is implicit
+                        auto ct_buffer_result = ByteBuffer::create_uninitialized(length + header_size + 16);
+                        if (ct_buffer_result.is_error()) {
+                            dbgln("LibTLS: Failed to allocate enough memory for the ciphertext");
+                            VERIFY_NOT_REACHED();
+                        }
+                        ct = ct_buffer_result.release_value();
+
+                        // copy the header over
+                        ct.overwrite(0, packet.data(), header_size - 2);
+
+                        u8 aad[13];
+                        Bytes aad_bytes { aad, 13 };
+                        build_aead_aad(m_context.local_sequence_number, packet.bytes().slice(0, 3), static_cast<u16>(packet.size() - header_size), aad_bytes);
+
+                        u8 nonce[12];
+                        chacha20_poly1305_nonce(m_context.crypto.local_aead_iv, m_context.local_sequence_number, { nonce, 12 });
+
+                        // Write the encrypted data and the tag
+                        chacha.encrypt(
+                            packet.bytes().slice(header_size, length),
+                            ct.bytes().slice(header_size, length),
+                            { nonce, 12 },
+                            aad_bytes,
+                            ct.bytes().slice(header_size + length, 16));
+
+                        VERIFY(header_size + length + 16 == ct.size());
+                    },
                     [&](Crypto::Cipher::AESCipher::CBCMode& cbc) {
                         VERIFY(!is_aead());
                         // We need enough space for a header, iv_length bytes of IV and whatever the packet contains
@@ -375,22 +422,9 @@ ssize_t TLSv12::handle_message(ReadonlyBytes buffer)
                 }
                 decrypted = decrypted_result.release_value();
 
-                // AEAD AAD (13)
-                // Seq. no (8)
-                // content type (1)
-                // version (2)
-                // length (2)
                 u8 aad[13];
                 Bytes aad_bytes { aad, 13 };
-                FixedMemoryStream aad_stream { aad_bytes };
-
-                u64 seq_no = AK::convert_between_host_and_network_endian(m_context.remote_sequence_number);
-                u16 len = AK::convert_between_host_and_network_endian((u16)packet_length);
-
-                MUST(aad_stream.write_value(seq_no));                                    // sequence number
-                MUST(aad_stream.write_until_depleted(buffer.slice(0, header_size - 2))); // content-type + version
-                MUST(aad_stream.write_value(len));                                       // length
-                VERIFY(MUST(aad_stream.tell()) == MUST(aad_stream.size()));
+                build_aead_aad(m_context.remote_sequence_number, buffer.slice(0, header_size - 2), static_cast<u16>(packet_length), aad_bytes);
 
                 auto nonce = payload.slice(0, iv_length());
                 payload = payload.slice(iv_length());
@@ -427,6 +461,53 @@ ssize_t TLSv12::handle_message(ReadonlyBytes buffer)
 
                 plain = decrypted;
             },
+            [&](Crypto::AEAD::ChaCha20Poly1305& chacha) {
+                VERIFY(is_aead());
+                if (length < 16) {
+                    dbgln("Invalid packet length");
+                    auto packet = build_alert(true, (u8)AlertDescription::DECRYPT_ERROR);
+                    write_packet(packet);
+                    return_value = Error::BrokenPacket;
+                    return;
+                }
+
+                auto packet_length = length - 16;
+                auto decrypted_result = ByteBuffer::create_uninitialized(packet_length);
+                if (decrypted_result.is_error()) {
+                    dbgln("Failed to allocate memory for the packet");
+                    return_value = Error::DecryptionFailed;
+                    return;
+                }
+                decrypted = decrypted_result.release_value();
+
+                u8 aad[13];
+                Bytes aad_bytes { aad, 13 };
+                build_aead_aad(m_context.remote_sequence_number, buffer.slice(0, header_size - 2), static_cast<u16>(packet_length), aad_bytes);
+
+                u8 nonce[12];
+                chacha20_poly1305_nonce(m_context.crypto.remote_aead_iv, m_context.remote_sequence_number, { nonce, 12 });
+
+                auto ciphertext = plain.slice(0, packet_length);
+                auto tag = plain.slice(packet_length, 16);
+
+                auto consistency = chacha.decrypt(
+                    ciphertext,
+                    decrypted,
+                    { nonce, 12 },
+                    aad_bytes,
+                    tag);
+
+                if (consistency != Crypto::VerificationConsistency::Consistent) {
+                    dbgln("integrity check failed (tag length {})", tag.size());
+                    auto packet = build_alert(true, (u8)AlertDescription::BAD_RECORD_MAC);
+                    write_packet(packet);
+
+                    return_value = Error::IntegrityCheckFailed;
+                    return;
+                }
+
+                plain = decrypted;
+            },
             [&](Crypto::Cipher::AESCipher::CBCMode& cbc) {
                 VERIFY(!is_aead());
                 auto iv_size = iv_length();
@@ -23,17 +23,29 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
     args_parser.parse(arguments);
 
     auto file = TRY(Core::File::open_file_or_standard_stream(filepath, Core::File::OpenMode::Read));
-    ByteBuffer buffer = TRY(file->read_until_eof());
+    auto output = TRY(Core::File::standard_output());
 
     TRY(Core::System::pledge("stdio"));
 
+    auto buffer = TRY(ByteBuffer::create_uninitialized(64 * KiB));
+    auto copy_to = [&](Stream& stream) -> ErrorOr<void> {
+        while (!file->is_eof()) {
+            auto bytes = TRY(file->read_some(buffer));
+            TRY(stream.write_until_depleted(bytes));
+        }
+        return {};
+    };
+
     if (decode) {
-        auto decoded = TRY(decode_base64(buffer));
-        out("{}", StringView(decoded.bytes()));
+        Base64Decoder decoder { MaybeOwned<Stream>(*output) };
+        TRY(copy_to(decoder));
+        TRY(decoder.finish());
         return 0;
     }
 
-    auto encoded = TRY(encode_base64(buffer));
-    outln("{}", encoded);
+    Base64Encoder encoder { MaybeOwned<Stream>(*output) };
+    TRY(copy_to(encoder));
+    TRY(encoder.finish());
+    TRY(output->write_until_depleted("\n"sv.bytes()));
     return 0;
 }
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Vector.h>
+#include <LibCore/ArgsParser.h>
+#include <LibCore/DirIterator.h>
+#include <LibCore/System.h>
+#include <LibMain/Main.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+
+struct Extent {
+    u64 logical_block { 0 };
+    u64 physical_block { 0 };
+    u64 length { 0 };
+};
+
+static ErrorOr<Vector<Extent>> extents_of_file(int fd, u64 block_count)
+{
+    Vector<Extent> extents;
+    for (u64 logical_block = 0; logical_block < block_count; ++logical_block) {
+        int block = static_cast<int>(logical_block);
+        TRY(Core::System::ioctl(fd, FIBMAP, &block));
+        // Holes are not part of any extent.
+        if (block == 0)
+            continue;
+        auto physical_block = static_cast<u64>(block);
+        if (!extents.is_empty()) {
+            auto& last = extents.last();
+            if (last.logical_block + last.length == logical_block && last.physical_block + last.length == physical_block) {
+                ++last.length;
+                continue;
+            }
+        }
+        TRY(extents.try_append({ logical_block, physical_block, 1 }));
+    }
+    return extents;
+}
+
+ErrorOr<int> serenity_main(Main::Arguments arguments)
+{
+    TRY(Core::System::pledge("stdio rpath"));
+
+    Vector<StringView> paths;
+    bool verbose = false;
+    bool recursive = false;
+
+    Core::ArgsParser args_parser;
+    args_parser.set_general_help("Report how fragmented files are on disk.");
+    args_parser.add_option(verbose, "List the extents of every file", "verbose", 'v');
+    args_parser.add_option(recursive, "Report on the files in directories, recursively", "recursive", 'r');
+    args_parser.add_positional_argument(paths, "Files to report on", "paths");
+    args_parser.parse(arguments);
+
+    size_t file_count = 0;
+    u64 total_block_count = 0;
+    u64 total_extent_count = 0;
+    size_t fragmented_file_count = 0;
+
+    Function<bool(DeprecatedString const&)> report = [&](DeprecatedString const& path) {
+        auto stat_or_error = Core::System::lstat(path);
+        if (stat_or_error.is_error()) {
+            warnln("filefrag: Could not stat '{}': {}", path, stat_or_error.release_error());
+            return false;
+        }
+        auto st = stat_or_error.release_value();
+
+        if (S_ISDIR(st.st_mode)) {
+            if (!recursive) {
+                warnln("filefrag: '{}' is a directory", path);
+                return false;
+            }
+            bool success = true;
+            Core::DirIterator it(path, Core::DirIterator::Flags::SkipParentAndBaseDir);
+            while (it.has_next())
+                success &= report(it.next_full_path());
+            return success;
+        }
+        if (!S_ISREG(st.st_mode))
+            return true;
+
+        auto fd_or_error = Core::System::open(path, O_RDONLY);
+        if (fd_or_error.is_error()) {
+            warnln("filefrag: Could not open '{}': {}", path, fd_or_error.release_error());
+            return false;
+        }
+        auto fd = fd_or_error.release_value();
+        auto block_count = ceil_div(static_cast<u64>(st.st_size), static_cast<u64>(st.st_blksize));
+        auto extents_or_error = extents_of_file(fd, block_count);
+        (void)Core::System::close(fd);
+        if (extents_or_error.is_error()) {
+            warnln("filefrag: Could not map the blocks of '{}': {}", path, extents_or_error.release_error());
+            return false;
+        }
+        auto extents = extents_or_error.release_value();
+
+        outln("{}: {} extent{} found", path, extents.size(), extents.size() == 1 ? "" : "s");
+        if (verbose) {
+            outln("{:>5} {:>10} {:>10} {:>8}", "ext", "logical", "physical", "length");
+            for (size_t i = 0; i < extents.size(); ++i)
+                outln("{:>5} {:>10} {:>10} {:>8}", i, extents[i].logical_block, extents[i].physical_block, extents[i].length);
+        }
+
+        ++file_count;
+        total_block_count += block_count;
+        total_extent_count += extents.size();
+        if (extents.size() > 1)
+            ++fragmented_file_count;
+        return true;
+    };
+
+    bool success = true;
+    for (auto path : paths)
+        success &= report(path);
+
+    if (file_count > 1) {
+        outln("{} files, {} fragmented ({}%), {} blocks in {} extents, {:.1} blocks per extent",
+            file_count, fragmented_file_count, fragmented_file_count * 100 / file_count,
+            total_block_count, total_extent_count,
+            total_extent_count ? static_cast<double>(total_block_count) / static_cast<double>(total_extent_count) : 0.0);
+    }
+
+    return success ? 0 : 1;
+}
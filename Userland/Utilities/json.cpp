@@ -6,8 +6,10 @@
  */
 
 #include <AK/Assertions.h>
+#include <AK/HashTable.h>
 #include <AK/JsonArray.h>
 #include <AK/JsonObject.h>
+#include <AK/JsonStreamingParser.h>
 #include <AK/JsonValue.h>
 #include <AK/StringBuilder.h>
 #include <AK/StringView.h>
@@ -27,6 +29,142 @@ static void print_indent(int indent, int spaces_per_indent)
         out(" ");
 }
 
+// Formats the document in the same way as print(), but as it's being parsed, so the whole tree never has to be in memory.
+// The output is only kept until parsing has succeeded, so that nothing is printed for malformed input. Objects with
+// duplicate keys fail the parse as well, as the tree keeps only the last value for a key, in the place of the first.
+class StreamingPrinter final : public JsonStreamingParser::Visitor {
+public:
+    StreamingPrinter(int spaces_per_indent, bool use_color)
+        : m_spaces_per_indent(spaces_per_indent)
+        , m_use_color(use_color)
+    {
+    }
+
+    StringView output() const { return m_output.string_view(); }
+
+    virtual ErrorOr<void> on_object_start() override
+    {
+        begin_value();
+        m_output.append("{\n"sv);
+        TRY(m_containers.try_append({ .is_array = false }));
+        return {};
+    }
+
+    virtual ErrorOr<void> on_object_end() override
+    {
+        end_container();
+        m_output.append('}');
+        return {};
+    }
+
+    virtual ErrorOr<void> on_array_start() override
+    {
+        begin_value();
+        m_output.append("[\n"sv);
+        TRY(m_containers.try_append({ .is_array = true }));
+        return {};
+    }
+
+    virtual ErrorOr<void> on_array_end() override
+    {
+        end_container();
+        m_output.append(']');
+        return {};
+    }
+
+    virtual ErrorOr<void> on_key(StringView key) override
+    {
+        if (TRY(m_containers.last().keys.try_set(DeprecatedString { key })) != HashSetResult::InsertedNewEntry)
+            return Error::from_string_literal("Object has duplicate keys");
+        begin_entry();
+        if (m_use_color)
+            m_output.appendff("\"\033[33;1m{}\033[0m\": ", key);
+        else
+            m_output.appendff("\"{}\": ", key);
+        return {};
+    }
+
+    virtual ErrorOr<void> on_string(StringView value) override
+    {
+        print_scalar("\033[31;1m"sv, value, true);
+        return {};
+    }
+
+    virtual ErrorOr<void> on_number(JsonValue const& value) override
+    {
+        print_scalar("\033[35;1m"sv, value.to_deprecated_string(), false);
+        return {};
+    }
+
+    virtual ErrorOr<void> on_boolean(bool value) override
+    {
+        print_scalar("\033[32;1m"sv, value ? "true"sv : "false"sv, false);
+        return {};
+    }
+
+    virtual ErrorOr<void> on_null() override
+    {
+        print_scalar("\033[34;1m"sv, "null"sv, false);
+        return {};
+    }
+
+private:
+    struct Container {
+        bool is_array { false };
+        size_t entries { 0 };
+        HashTable<DeprecatedString> keys {};
+    };
+
+    void append_indent(size_t indent)
+    {
+        for (size_t i = 0; i < indent * m_spaces_per_indent; ++i)
+            m_output.append(' ');
+    }
+
+    // Every entry but the first is preceded by a comma, and every entry goes on its own line.
+    void begin_entry()
+    {
+        auto& container = m_containers.last();
+        if (container.entries++ > 0)
+            m_output.append(",\n"sv);
+        append_indent(m_containers.size());
+    }
+
+    // Object members have already been started by their key.
+    void begin_value()
+    {
+        if (!m_containers.is_empty() && m_containers.last().is_array)
+            begin_entry();
+    }
+
+    void end_container()
+    {
+        auto container = m_containers.take_last();
+        if (container.entries > 0)
+            m_output.append('\n');
+        append_indent(m_containers.size());
+    }
+
+    void print_scalar(StringView color, StringView value, bool is_string)
+    {
+        begin_value();
+        if (m_use_color)
+            m_output.append(color);
+        if (is_string)
+            m_output.append('"');
+        m_output.append(value);
+        if (is_string)
+            m_output.append('"');
+        if (m_use_color)
+            m_output.append("\033[0m"sv);
+    }
+
+    size_t m_spaces_per_indent { 0 };
+    bool m_use_color { false };
+    Vector<Container, 16> m_containers;
+    StringBuilder m_output;
+};
+
 ErrorOr<int> serenity_main(Main::Arguments arguments)
 {
     TRY(Core::System::pledge("stdio rpath"));
@@ -48,6 +186,17 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
     TRY(Core::System::pledge("stdio"));
 
     auto file_contents = TRY(file->read_until_eof());
+
+    // Without a query, there is no need to build the whole tree. If the streaming parser gives up, the tree
+    // will either report the same error or handle the duplicate keys.
+    if (dotted_key.is_empty()) {
+        StreamingPrinter printer { spaces_in_indent, static_cast<bool>(isatty(STDOUT_FILENO)) };
+        if (!JsonStreamingParser { file_contents }.parse(printer).is_error()) {
+            outln("{}", printer.output());
+            return 0;
+        }
+    }
+
     auto json = TRY(JsonValue::from_string(file_contents));
     if (!dotted_key.is_empty()) {
         auto key_parts = dotted_key.split_view('.');
@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Demangle.h>
+#include <AK/JsonArray.h>
+#include <AK/JsonObject.h>
+#include <AK/JsonValue.h>
+#include <AK/QuickSort.h>
+#include <LibCore/ArgsParser.h>
+#include <LibCore/File.h>
+#include <LibCore/MappedFile.h>
+#include <LibCore/System.h>
+#include <LibELF/Image.h>
+#include <LibMain/Main.h>
+#include <LibSymbolication/Symbolication.h>
+
+static constexpr StringView lock_stats_path = "/sys/kernel/lock_stats"sv;
+static constexpr StringView kernel_debug_path = "/boot/Kernel.debug"sv;
+
+struct KernelSymbols {
+    Optional<FlatPtr> base;
+    OwnPtr<Core::MappedFile> file;
+    OwnPtr<ELF::Image> image;
+};
+
+static KernelSymbols load_kernel_symbols()
+{
+    KernelSymbols symbols;
+    symbols.base = Symbolication::kernel_base();
+    if (!symbols.base.has_value())
+        return symbols;
+    auto file_or_error = Core::MappedFile::map(kernel_debug_path);
+    if (file_or_error.is_error())
+        return symbols;
+    symbols.file = file_or_error.release_value();
+    symbols.image = make<ELF::Image>(symbols.file->bytes());
+    if (!symbols.image->is_valid())
+        symbols.image = nullptr;
+    return symbols;
+}
+
+// Locks that are globals get the name of their variable. The others live on the heap, and only mutexes have names.
+static DeprecatedString describe_lock(KernelSymbols const& symbols, JsonObject const& lock)
+{
+    auto name = lock.get_deprecated_string("name"sv).value_or({});
+    if (!name.is_empty())
+        return name;
+    auto address = lock.get_addr("address"sv).value_or(0);
+    if (symbols.image) {
+        u32 offset = 0;
+        auto symbol = symbols.image->find_symbol(address - *symbols.base, &offset);
+        if (symbol.has_value() && offset < symbol->size()) {
+            if (offset == 0)
+                return demangle(symbol->name());
+            return DeprecatedString::formatted("{}+{:#x}", demangle(symbol->name()), offset);
+        }
+    }
+    return DeprecatedString::formatted("{:p}", address);
+}
+
+static DeprecatedString describe_call_site(KernelSymbols const& symbols, FlatPtr address)
+{
+    if (!symbols.image)
+        return DeprecatedString::formatted("{:p}", address);
+    // This is a return address, so look at the call instruction just before it.
+    auto symbol = Symbolication::symbolicate(kernel_debug_path, address - *symbols.base - 1);
+    if (!symbol.has_value() || symbol->name == "??")
+        return DeprecatedString::formatted("{:p}", address);
+    if (symbol->source_positions.is_empty())
+        return DeprecatedString::formatted("{:p}  {}", address, symbol->name);
+    auto const& position = symbol->source_positions.first();
+    return DeprecatedString::formatted("{:p}  {} ({}:{})", address, symbol->name, position.file_path, position.line_number);
+}
+
+ErrorOr<int> serenity_main(Main::Arguments arguments)
+{
+    bool reset = false;
+    bool show_histograms = false;
+    size_t count = 20;
+
+    Core::ArgsParser args_parser;
+    args_parser.set_general_help("Print how contended the kernel's locks are.");
+    args_parser.add_option(reset, "Start counting from zero again", "reset", 'r');
+    args_parser.add_option(count, "How many of the most contended locks to print", "count", 'n', "count");
+    args_parser.add_option(show_histograms, "Print how long the waits for each lock were", "histogram", 'H');
+    args_parser.parse(arguments);
+
+    TRY(Core::System::unveil(lock_stats_path, reset ? "w"sv : "r"sv));
+    TRY(Core::System::unveil("/sys/kernel/load_base"sv, "r"sv));
+    TRY(Core::System::unveil(kernel_debug_path, "r"sv));
+    TRY(Core::System::unveil(nullptr, nullptr));
+    TRY(Core::System::pledge(reset ? "stdio wpath"sv : "stdio rpath"sv));
+
+    auto file_or_error = Core::File::open(lock_stats_path, reset ? Core::File::OpenMode::Write : Core::File::OpenMode::Read);
+    if (file_or_error.is_error() && file_or_error.error().code() == ENOENT) {
+        warnln("{} doesn't exist, the kernel must be built with LOCK_STATISTICS", lock_stats_path);
+        return 1;
+    }
+    auto file = TRY(file_or_error);
+
+    if (reset) {
+        TRY(file->write_until_depleted("1"sv.bytes()));
+        return 0;
+    }
+
+    auto json = TRY(JsonValue::from_string(TRY(file->read_until_eof())));
+    auto const& stats = json.as_object();
+    auto symbols = load_kernel_symbols();
+
+    Vector<JsonObject const*> locks;
+    stats.get_array("locks"sv)->for_each([&](auto& value) {
+        locks.append(&value.as_object());
+    });
+    quick_sort(locks, [](auto* a, auto* b) {
+        auto a_contended = a->get_u64("contended"sv).value_or(0);
+        auto b_contended = b->get_u64("contended"sv).value_or(0);
+        if (a_contended != b_contended)
+            return a_contended > b_contended;
+        return a->get_u64("acquisitions"sv).value_or(0) > b->get_u64("acquisitions"sv).value_or(0);
+    });
+
+    outln("{:<40} {:<17} {:>12} {:>10} {:>14} {:>10}", "Lock", "Type", "Acquired", "Contended", "Total wait", "Max wait");
+    for (size_t i = 0; i < min(count, locks.size()); ++i) {
+        auto const& lock = *locks[i];
+        auto type = lock.get_deprecated_string("type"sv).value_or({});
+        // Mutexes are waited for by sleeping, spinlocks by spinning.
+        auto unit = type == "Mutex"sv ? "us"sv : "spins"sv;
+        outln("{:<40} {:<17} {:>12} {:>10} {:>8} {:<5} {:>10}",
+            describe_lock(symbols, lock),
+            type,
+            lock.get_u64("acquisitions"sv).value_or(0),
+            lock.get_u64("contended"sv).value_or(0),
+            lock.get_u64("total_wait"sv).value_or(0),
+            unit,
+            lock.get_u64("max_wait"sv).value_or(0));
+
+        lock.get_array("call_sites"sv)->for_each([&](auto& value) {
+            auto const& call_site = value.as_object();
+            outln("    {:>8}x {}", call_site.get_u64("contended"sv).value_or(0), describe_call_site(symbols, call_site.get_addr("address"sv).value_or(0)));
+        });
+
+        if (show_histograms) {
+            auto const& histogram = *lock.get_array("histogram"sv);
+            for (size_t bucket = 0; bucket < histogram.size(); ++bucket) {
+                auto waits = histogram.at(bucket).to_number<u64>();
+                if (waits == 0)
+                    continue;
+                // The last bucket counts all the longer waits as well.
+                if (bucket == histogram.size() - 1)
+                    outln("    >= {:>7} {:<5} {}", 1ull << (bucket - 1), unit, waits);
+                else
+                    outln("    <  {:>7} {:<5} {}", 1ull << bucket, unit, waits);
+            }
+        }
+    }
+
+    if (auto untracked = stats.get_u64("untracked"sv).value_or(0); untracked > 0)
+        outln("{} acquisitions of locks that didn't fit in the table weren't counted", untracked);
+
+    return 0;
+}
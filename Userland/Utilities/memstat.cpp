@@ -43,6 +43,8 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
     u64 physical_available = json.get_u64("physical_available"sv).value_or(0);
     u64 physical_committed = json.get_u64("physical_committed"sv).value_or(0);
     u64 physical_uncommitted = json.get_u64("physical_uncommitted"sv).value_or(0);
+    u64 merged_pages = json.get_u64("merged_pages"sv).value_or(0);
+    u64 merged_zero_pages = json.get_u64("merged_zero_pages"sv).value_or(0);
     u32 kmalloc_call_count = json.get_u32("kmalloc_call_count"sv).value_or(0);
     u32 kfree_call_count = json.get_u32("kfree_call_count"sv).value_or(0);
 
@@ -56,12 +58,16 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
         outln("Physical pages (committed) count: {}", TRY(String::formatted("{}", human_readable_size_long(page_count_to_bytes(physical_committed), UseThousandsSeparator::Yes))));
         outln("Physical pages (uncommitted) count: {}", TRY(String::formatted("{}", human_readable_size_long(page_count_to_bytes(physical_uncommitted), UseThousandsSeparator::Yes))));
         outln("Physical pages (total) count: {:'}", physical_pages_total);
+        outln("Physical pages (merged) count: {}", TRY(String::formatted("{}", human_readable_size_long(page_count_to_bytes(merged_pages), UseThousandsSeparator::Yes))));
+        outln("Physical pages (merged into zero page) count: {}", TRY(String::formatted("{}", human_readable_size_long(page_count_to_bytes(merged_zero_pages), UseThousandsSeparator::Yes))));
     } else {
         outln("Kmalloc allocated: {}", TRY(String::formatted("{}/{}", kmalloc_allocated, kmalloc_bytes_total)));
         outln("Physical pages (in use) count: {}", TRY(String::formatted("{}/{}", page_count_to_bytes(physical_pages_in_use), page_count_to_bytes(physical_pages_total))));
         outln("Physical pages (committed) count: {}", TRY(String::formatted("{}", page_count_to_bytes(physical_committed))));
         outln("Physical pages (uncommitted) count: {}", TRY(String::formatted("{}", page_count_to_bytes(physical_uncommitted))));
         outln("Physical pages (total) count: {}", physical_pages_total);
+        outln("Physical pages (merged) count: {}", page_count_to_bytes(merged_pages));
+        outln("Physical pages (merged into zero page) count: {}", page_count_to_bytes(merged_zero_pages));
     }
     outln("Kmalloc call count: {}", kmalloc_call_count);
     outln("Kfree call count: {}", kfree_call_count);
@@ -33,6 +33,7 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
     bool flag_program = false;
     bool flag_wide = false;
     bool flag_extend = false;
+    bool flag_tcp_info = false;
 
     Core::ArgsParser args_parser;
     args_parser.set_general_help("Display network connections");
@@ -44,6 +45,7 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
     args_parser.add_option(flag_program, "Show the PID and name of the program to which each socket belongs", "program", 'p');
     args_parser.add_option(flag_wide, "Do not truncate IP addresses by printing out the whole symbolic host", "wide", 'W');
     args_parser.add_option(flag_extend, "Display more information", "extend", 'e');
+    args_parser.add_option(flag_tcp_info, "Show congestion control and round trip time statistics of TCP connections", "tcp-info", 'i');
     args_parser.parse(arguments);
 
     TRY(Core::System::unveil("/sys/kernel/net", "r"));
@@ -91,6 +93,10 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
     int state_column = -1;
     int user_column = -1;
     int program_column = -1;
+    int congestion_control_column = -1;
+    int congestion_window_column = -1;
+    int round_trip_time_column = -1;
+    int retransmits_column = -1;
 
     auto add_column = [&](auto title, auto alignment, auto width) {
         columns.append({ title, alignment, width, {} });
@@ -105,6 +111,12 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
     state_column = add_column("State", Alignment::Left, 11);
     user_column = flag_extend ? add_column("User", Alignment::Left, 4) : -1;
     program_column = flag_program ? add_column("PID/Program", Alignment::Left, 11) : -1;
+    if (flag_tcp_info) {
+        congestion_control_column = add_column("CC", Alignment::Left, 5);
+        congestion_window_column = add_column("Cwnd", Alignment::Right, 9);
+        round_trip_time_column = add_column("RTT(ms)", Alignment::Right, 7);
+        retransmits_column = add_column("Retrans", Alignment::Right, 7);
+    }
 
     auto print_column = [](auto& column, auto& string) {
         if (!column.width) {
@@ -252,6 +264,18 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
                 columns[user_column].buffer = TRY(get_formatted_user(origin_uid)).to_deprecated_string();
             if (flag_program && program_column != -1)
                 columns[program_column].buffer = get_formatted_program(origin_pid);
+            if (congestion_control_column != -1)
+                columns[congestion_control_column].buffer = if_object.get_deprecated_string("congestion_control"sv).value_or("-");
+            if (congestion_window_column != -1)
+                columns[congestion_window_column].buffer = TRY(String::number(if_object.get_u32("congestion_window"sv).value_or(0))).to_deprecated_string();
+            if (round_trip_time_column != -1) {
+                auto round_trip_time_us = if_object.get_i64("round_trip_time_us"sv);
+                columns[round_trip_time_column].buffer = round_trip_time_us.has_value()
+                    ? DeprecatedString::formatted("{}.{:03}", *round_trip_time_us / 1000, *round_trip_time_us % 1000)
+                    : "-";
+            }
+            if (retransmits_column != -1)
+                columns[retransmits_column].buffer = TRY(String::number(if_object.get_u32("retransmitted_packets"sv).value_or(0))).to_deprecated_string();
 
             for (auto& column : columns)
                 print_column(column, column.buffer);
@@ -336,6 +360,15 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
             if (flag_program && program_column != -1)
                 columns[program_column].buffer = get_formatted_program(origin_pid);
 
+            if (congestion_control_column != -1)
+                columns[congestion_control_column].buffer = "-";
+            if (congestion_window_column != -1)
+                columns[congestion_window_column].buffer = "-";
+            if (round_trip_time_column != -1)
+                columns[round_trip_time_column].buffer = "-";
+            if (retransmits_column != -1)
+                columns[retransmits_column].buffer = "-";
+
             for (auto& column : columns)
                 print_column(column, column.buffer);
             outln();
@@ -4,14 +4,25 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/HashMap.h>
+#include <AK/JsonArray.h>
+#include <AK/JsonObject.h>
+#include <AK/JsonValue.h>
+#include <AK/StringBuilder.h>
 #include <LibCore/ArgsParser.h>
+#include <LibCore/ElapsedTimer.h>
+#include <LibCore/File.h>
+#include <LibCore/ProcessStatisticsReader.h>
 #include <LibCore/System.h>
 #include <LibMain/Main.h>
+#include <LibSymbolication/Symbolication.h>
 #include <serenity.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <unistd.h>
 
 static Optional<pid_t> determine_pid_to_profile(StringView pid_argument, bool all_processes);
+static ErrorOr<int> sample_into_folded_stacks(u32 frequency, u32 duration_in_seconds);
 
 ErrorOr<int> serenity_main(Main::Arguments arguments)
 {
@@ -24,6 +35,9 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
     bool enable = false;
     bool disable = false;
     bool all_processes = false;
+    bool folded = false;
+    u32 sampling_frequency = 125;
+    u32 sampling_duration = 10;
     u64 event_mask = PERF_EVENT_MMAP | PERF_EVENT_MUNMAP | PERF_EVENT_PROCESS_CREATE
         | PERF_EVENT_PROCESS_EXEC | PERF_EVENT_PROCESS_EXIT | PERF_EVENT_THREAD_CREATE | PERF_EVENT_THREAD_EXIT
         | PERF_EVENT_SIGNPOST;
@@ -35,6 +49,9 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
     args_parser.add_option(disable, "Disable", nullptr, 'd');
     args_parser.add_option(free, "Free the profiling buffer for the associated process(es).", nullptr, 'f');
     args_parser.add_option(wait, "Enable profiling and wait for user input to disable.", nullptr, 'w');
+    args_parser.add_option(folded, "Sample all processors and print the stacks in folded format, for flame graphs (super-user only)", "folded", 0);
+    args_parser.add_option(sampling_frequency, "How many times a second to sample with --folded", "frequency", 'F', "hz");
+    args_parser.add_option(sampling_duration, "How many seconds to sample for with --folded", "duration", 0, "seconds");
     args_parser.add_option(Core::ArgsParser::Option {
         Core::ArgsParser::OptionArgumentMode::Required,
         "Enable tracking specific event type", nullptr, 't', "event_type",
@@ -73,6 +90,9 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
         exit(0);
     }
 
+    if (folded)
+        return sample_into_folded_stacks(sampling_frequency, sampling_duration);
+
     if (pid_argument.is_empty() && command.is_empty() && !all_processes) {
         args_parser.print_usage(stdout, arguments.strings[0]);
         print_types();
@@ -132,3 +152,114 @@ static Optional<pid_t> determine_pid_to_profile(StringView pid_argument, bool al
     // pid_argument is guaranteed to have a value
     return pid_argument.to_int();
 }
+
+static ErrorOr<void> set_sampling_frequency(u32 frequency)
+{
+    auto file = TRY(Core::File::open("/sys/kernel/conf/profile_sampling_frequency"sv, Core::File::OpenMode::Write));
+    TRY(file->write_until_depleted(DeprecatedString::number(frequency).bytes()));
+    return {};
+}
+
+// Turns samples into lines of semicolon-separated frames, outermost first, followed by how often each was seen.
+// This is what flamegraph.pl and most other flame graph tools take as input.
+class FoldedStacks {
+public:
+    ErrorOr<void> add_samples(JsonArray const& samples)
+    {
+        HashMap<pid_t, Vector<Vector<FlatPtr>>> stacks_by_pid;
+        HashMap<pid_t, Vector<size_t>> kernel_frame_counts_by_pid;
+        for (auto const& value : samples.values()) {
+            auto const& sample = value.as_object();
+            auto pid = sample.get_i32("pid"sv).value_or(0);
+            Vector<FlatPtr> stack;
+            for (auto const& frame : sample.get_array("stack"sv)->values())
+                TRY(stack.try_append(frame.to_addr()));
+            TRY(stacks_by_pid.ensure(pid).try_append(move(stack)));
+            TRY(kernel_frame_counts_by_pid.ensure(pid).try_append(sample.get_u32("kernel_frames"sv).value_or(0)));
+        }
+
+        for (auto const& [pid, stacks] : stacks_by_pid) {
+            // Symbolicate while the process is still around, as its libraries can't be found after it's gone.
+            auto symbolicated_stacks = Symbolication::symbolicate_stacks(pid, stacks, Symbolication::IncludeSourcePosition::No);
+            auto const& kernel_frame_counts = kernel_frame_counts_by_pid.get(pid).value();
+            auto process_name = TRY(name_of_process(pid));
+            for (size_t i = 0; i < symbolicated_stacks.size(); ++i) {
+                auto const& symbols = symbolicated_stacks[i];
+                StringBuilder builder;
+                builder.append(process_name);
+                for (size_t frame = symbols.size(); frame-- > 0;) {
+                    builder.append(';');
+                    if (symbols[frame].name.is_empty())
+                        builder.appendff("{:p}", symbols[frame].address);
+                    else
+                        builder.append(symbols[frame].name.replace(";"sv, ":"sv, ReplaceMode::All));
+                    // This is how the Linux tools mark kernel frames, which flame graph tools color differently.
+                    if (frame < kernel_frame_counts[i])
+                        builder.append("_[k]"sv);
+                }
+                auto& count = m_counts.ensure(builder.to_deprecated_string());
+                ++count;
+            }
+        }
+        return {};
+    }
+
+    void print() const
+    {
+        for (auto const& [stack, count] : m_counts)
+            outln("{} {}", stack, count);
+    }
+
+private:
+    ErrorOr<DeprecatedString> name_of_process(pid_t pid)
+    {
+        if (auto name = m_process_names.get(pid); name.has_value())
+            return *name;
+        auto all_processes = TRY(Core::ProcessStatisticsReader::get_all(false));
+        for (auto const& process : all_processes.processes)
+            m_process_names.set(process.pid, process.name);
+        // The process has exited since it was sampled.
+        return m_process_names.ensure(pid, [&] { return DeprecatedString::formatted("[{}]", pid); });
+    }
+
+    HashMap<pid_t, DeprecatedString> m_process_names;
+    HashMap<DeprecatedString, size_t> m_counts;
+};
+
+static ErrorOr<int> sample_into_folded_stacks(u32 frequency, u32 duration_in_seconds)
+{
+    auto samples_file = TRY(Core::File::open("/sys/kernel/profile_samples"sv, Core::File::OpenMode::Read));
+    // Seeking back to the start hands out the samples taken since the last read.
+    auto read_samples = [&]() -> ErrorOr<JsonObject> {
+        TRY(samples_file->seek(0, SeekMode::SetPosition));
+        auto json = TRY(JsonValue::from_string(TRY(samples_file->read_until_eof())));
+        return json.as_object();
+    };
+
+    // Throw away whatever was sampled before.
+    auto dropped_at_start = TRY(read_samples()).get_u64("dropped"sv).value_or(0);
+    u64 dropped = dropped_at_start;
+
+    TRY(set_sampling_frequency(frequency));
+
+    FoldedStacks folded_stacks;
+    auto timer = Core::ElapsedTimer::start_new();
+    for (;;) {
+        bool is_done = timer.elapsed_time().to_seconds() >= duration_in_seconds;
+        if (is_done)
+            TRY(set_sampling_frequency(0));
+
+        auto samples = TRY(read_samples());
+        dropped = samples.get_u64("dropped"sv).value_or(0);
+        TRY(folded_stacks.add_samples(*samples.get_array("samples"sv)));
+
+        if (is_done)
+            break;
+        usleep(100'000);
+    }
+
+    folded_stacks.print();
+    if (dropped != dropped_at_start)
+        warnln("profile: {} samples were dropped, try a lower frequency", dropped - dropped_at_start);
+    return 0;
+}